@@ -0,0 +1,388 @@
+#include "utils/OmplSetUp.h"
+#include "utils/BlackmoreHalfPlanes.h"
+#include "utils/InflatedObstacles.h"
+#include "utils/DiskGeometry.h"
+#include "StateValidityCheckers/CentralizedChiSquaredBoundarySVC.h"
+#include "Planners/KCBS.h"
+#include "utils/PlanningService.h"
+#include <ompl/util/Console.h>
+#include <boost/math/distributions/chi_squared.hpp>
+#include <boost/math/special_functions/erf.hpp>
+#include <boost/program_options.hpp>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <tuple>
+
+// Randomized checks that the optimized validity kernels decide as the straightforward implementations they replaced,
+// on fixtures built from the shipped maps and scens, and that the duplicate detection of K-CBS prunes exactly the
+// children whose constraint sets were generated before, and that the planning service answers the requests it cannot
+// load with an error. Prints the cases checked per kernel, and exits with 1 at the first case on which a kernel
+// disagrees with its reference, e.g.
+// kcbs-equivalence --cases 200000 --seed 1
+
+
+namespace
+{
+    /* an instance of a shipped map and scen, and its low-level problems */
+    struct Scenario
+    {
+        InstancePtr instance_;
+        std::vector<MotionPlanningProblemPtr> problems_;
+    };
+
+    void set(po::variables_map &vm, const std::string &key, const boost::any &value)
+    {
+        static_cast<std::map<std::string, po::variable_value> &>(vm)[key] = po::variable_value(value, false);
+    }
+
+    Scenario load(const std::string &map, const std::string &scen, const int k, const std::string &solver,
+        const std::string &svc)
+    {
+        po::variables_map vm;
+        set(vm, "map", std::string(KCBS_SOURCE_DIR "/maps/") + map);
+        set(vm, "scen", std::string(KCBS_SOURCE_DIR "/scens/") + scen);
+        set(vm, "numAgents", k);
+        set(vm, "solver", solver);
+        set(vm, "lowlevel", std::string("BSST"));
+        set(vm, "p_safe", 0.9);
+        set(vm, "pvc", std::string("ChiSquared"));
+        set(vm, "svc", svc);
+        set(vm, "sdfres", 0.05);
+        Scenario s;
+        s.instance_ = std::make_shared<Instance>(vm, "Equivalence");
+        s.problems_ = set_up_all_MP_Problems(s.instance_);
+        return s;
+    }
+
+    /* a random covariance, from nearly a point to about the size of a cell */
+    Eigen::Matrix2d random_covariance(std::mt19937 &gen)
+    {
+        std::uniform_real_distribution<double> unit(0, 1), scale(std::log(0.01), std::log(2.0));
+        const double s = std::exp(scale(gen));
+        Eigen::Matrix2d L;
+        L << unit(gen) * s, 0, (2 * unit(gen) - 1) * s, unit(gen) * s;
+        return L * L.transpose();
+    }
+
+    /* the chance constraint of Blackmore et al. as it was checked before BlackmoreHalfPlanes: the belief is safe from
+       the quadrilateral A x <= B if a^T mu - b >= sqrt(2 a^T Sigma a) * erf_inv for one of its edges. tie is set if an
+       edge is within rounding of its bound, where the square root and the squares may round to either side */
+    bool blackmore_reference(const std::pair<Eigen::MatrixXd, Eigen::MatrixXd> &hp, const double x, const double y,
+        const Eigen::Matrix2d &Sigma, const double erf_inv, bool &tie)
+    {
+        const Eigen::MatrixXd &A = hp.first;
+        const Eigen::MatrixXd &B = hp.second;
+        bool safe = false;
+        for (int i = 0; i < A.rows(); i++) {
+            const double vbar = std::sqrt(2 * (A.row(i) * Sigma * A.row(i).transpose()).value()) * erf_inv;
+            const double margin = A(i, 0) * x + A(i, 1) * y - B(i, 0);
+            tie |= std::abs(margin - vbar) <= 1e-9 * (1 + std::abs(margin) + std::abs(vbar));
+            safe |= margin >= vbar;
+        }
+        return safe;
+    }
+
+    /* BlackmoreHalfPlanes (in double) against the sqrt formulation, on the inflated obstacles of robot 0 of s and on
+       their prefixes (so the padding of the last block is exercised at every size), at random beliefs and risks of
+       both signs of erf_inv */
+    bool check_half_planes(const Scenario &s, const unsigned int cases, std::mt19937 &gen)
+    {
+        const std::shared_ptr<const InflatedObstacles> inflated = s.instance_->getInflatedObstacles(s.instance_->getRobots()[0]);
+        std::vector<std::pair<Eigen::MatrixXd, Eigen::MatrixXd>> quads;
+        for (const Polygon &poly: inflated->getPolygons())
+            quads.push_back(InflatedObstacles::halfPlanes(poly));
+        if (quads.empty()) {
+            OMPL_ERROR("%s: The map has no obstacles.", "check_half_planes");
+            return false;
+        }
+        // the first 1 to 17 quadrilaterals (two blocks and one more), and all of them
+        std::vector<BasicBlackmoreHalfPlanes<double>> prefixes;
+        for (std::size_t n = 1; n <= quads.size(); n++) {
+            if (n > 17 && n < quads.size())
+                continue;
+            BasicBlackmoreHalfPlanes<double> half_planes;
+            for (std::size_t o = 0; o < n; o++)
+                half_planes.add(quads[o].first, quads[o].second);
+            prefixes.push_back(std::move(half_planes));
+        }
+
+        const ob::RealVectorBounds &bounds = s.problems_[0]->getSpaceInformation()->getStateSpace()->as<ob::RealVectorStateSpace>()->getBounds();
+        std::uniform_real_distribution<double> px(bounds.low[0], bounds.high[0]), py(bounds.low[1], bounds.high[1]);
+        std::uniform_real_distribution<double> risk(0.001, 0.999);
+        std::uniform_int_distribution<std::size_t> pick(0, prefixes.size() - 1);
+        std::size_t checked = 0, ties = 0;
+        for (unsigned int c = 0; c < cases; c++) {
+            const BasicBlackmoreHalfPlanes<double> &half_planes = prefixes[pick(gen)];
+            const double x = px(gen), y = py(gen);
+            const Eigen::Matrix2d Sigma = random_covariance(gen);
+            const double erf_inv = boost::math::erf_inv(1 - 2 * risk(gen));
+            bool tie = false, all_safe = true;
+            std::vector<bool> safe(half_planes.size());
+            for (std::size_t o = 0; o < half_planes.size(); o++) {
+                safe[o] = blackmore_reference(quads[o], x, y, Sigma, erf_inv, tie);
+                all_safe = all_safe && safe[o];
+            }
+            if (tie) {
+                ties++;
+                continue;
+            }
+            bool agree = half_planes.allSafe(x, y, Sigma, erf_inv) == all_safe;
+            for (std::size_t o = 0; agree && o < half_planes.size(); o++)
+                agree = half_planes.isSafe(o, x, y, Sigma, erf_inv) == safe[o];
+            if (!agree) {
+                OMPL_ERROR("%s: Disagrees with the sqrt formulation on %zu obstacles at (%g, %g), Sigma (%g, %g, %g), erf_inv %g.",
+                    "BlackmoreHalfPlanes", half_planes.size(), x, y, Sigma(0, 0), Sigma(0, 1), Sigma(1, 1), erf_inv);
+                return false;
+            }
+            checked++;
+        }
+        std::cout << "BlackmoreHalfPlanes: " << checked << " cases agree (" << ties << " ties skipped)" << std::endl;
+        return true;
+    }
+
+    /* CentralizedChiSquaredBoundarySVC as it was before its broad phases: the safety disk of every agent against every
+       obstacle, and against the disk of every other agent if one of the two is active */
+    bool centralized_reference(const Scenario &s, const ob::State *state, const std::vector<bool> &active,
+        bool &agents_valid)
+    {
+        const oc::SpaceInformationPtr si = s.problems_[0]->getSpaceInformation();
+        const ob::RealVectorBounds &bounds = si->getStateSpace()->as<ob::RealVectorStateSpace>()->getBounds();
+        const RealVectorBeliefSpace::StateType *belief = state->as<RealVectorBeliefSpace::StateType>();
+        const std::vector<Robot*> robots = s.instance_->getRobots();
+        const double sc = quantile(bm::chi_squared(2), s.instance_->getPsafe());
+        const int num_agents = active.size();
+        std::vector<double> boundaries(num_agents);
+        agents_valid = true;
+        for (int a = 0; a < num_agents; a++) {
+            const double x = belief->values[2 * a], y = belief->values[2 * a + 1];
+            boundaries[a] = maxEigenvalue2x2(belief->sigmaBlock(a)) * sc + robots[a]->getBoundingRadius();
+            if (x < bounds.low[2 * a] || x > bounds.high[2 * a] || y < bounds.low[2 * a + 1] || y > bounds.high[2 * a + 1])
+                agents_valid = false;
+            for (const Polygon &poly: s.instance_->getInflatedObstacles(robots[a])->getPolygons())
+                agents_valid = agents_valid && !diskIntersectsPolygon(x, y, boundaries[a], poly);
+        }
+        for (int a1 = 0; a1 < num_agents; a1++) {
+            for (int a2 = a1 + 1; a2 < num_agents; a2++) {
+                if ((active[a1] || active[a2]) && disksIntersect(belief->values[2 * a1], belief->values[2 * a1 + 1], boundaries[a1],
+                        belief->values[2 * a2], belief->values[2 * a2 + 1], boundaries[a2]))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    /* the obstacle grid and the sweep over the agent pairs of CentralizedChiSquaredBoundarySVC against the all-pairs
+       loops, on the agents of s at random beliefs. The means gather in a window of random size, so teams range from
+       dense (every pair close) to sparse */
+    bool check_centralized(const Scenario &s, const unsigned int cases, std::mt19937 &gen)
+    {
+        const oc::SpaceInformationPtr si = s.problems_[0]->getSpaceInformation();
+        auto svc = std::dynamic_pointer_cast<const CentralizedChiSquaredBoundarySVC>(si->getStateValidityChecker());
+        if (!svc) {
+            OMPL_ERROR("%s: The scenario is not checked by CentralizedChiSquaredBoundarySVC.", "check_centralized");
+            return false;
+        }
+        const ob::RealVectorBounds &bounds = si->getStateSpace()->as<ob::RealVectorStateSpace>()->getBounds();
+        const int num_agents = bounds.low.size() / 2;
+        std::uniform_real_distribution<double> unit(0, 1), width(std::log(0.5), std::log(16.0));
+        ob::State *state = si->allocState();
+        auto *belief = state->as<RealVectorBeliefSpace::StateType>();
+        std::size_t separated = 0;
+        for (unsigned int c = 0; c < cases; c++) {
+            const double w = std::exp(width(gen));
+            const double cx = bounds.low[0] + unit(gen) * (bounds.high[0] - bounds.low[0]);
+            const double cy = bounds.low[1] + unit(gen) * (bounds.high[1] - bounds.low[1]);
+            std::vector<bool> active(num_agents, true);
+            const bool all_active = unit(gen) < 0.5;
+            for (int a = 0; a < num_agents; a++) {
+                belief->values[2 * a] = cx + (2 * unit(gen) - 1) * w;
+                belief->values[2 * a + 1] = cy + (2 * unit(gen) - 1) * w;
+                belief->sigmaBlock(a) = random_covariance(gen);
+                active[a] = all_active || unit(gen) < 0.5;
+            }
+            bool agents_valid = false;
+            const bool reference = centralized_reference(s, state, active, agents_valid);
+            bool agree = svc->areAgentsSeparated(state, active) == reference;
+            bool agents = true;
+            for (int a = 0; a < num_agents; a++)
+                agents = svc->isAgentValid(state, a) && agents;
+            agree = agree && agents == agents_valid;
+            if (all_active)
+                agree = agree && svc->isValid(state) == (si->satisfiesBounds(state) && agents_valid && reference);
+            if (!agree) {
+                OMPL_ERROR("%s: Disagrees with the all-pairs loops on %d agents in a window of %g around (%g, %g).",
+                    "CentralizedChiSquaredBoundarySVC", num_agents, w, cx, cy);
+                si->freeState(state);
+                return false;
+            }
+            separated += reference;
+        }
+        si->freeState(state);
+        std::cout << "CentralizedChiSquaredBoundarySVC (" << num_agents << " agents): " << cases << " cases agree (" <<
+            separated << " separated)" << std::endl;
+        return true;
+    }
+
+    /* the duplicate detection of K-CBS, on conflict trees grown by disjoint splits of random nodes */
+    class DuplicateProbe: public oc::KCBS
+    {
+    public:
+        DuplicateProbe(const MultiRobotProblemDefinitionPtr &pdef): KCBS(pdef)
+        {
+            setDuplicateDetection(true);
+            setDisjointSplitting(true);
+        }
+
+        /* a constraint by its values, so equal sets compare equal whatever their hashes */
+        typedef std::multiset<std::tuple<int, int, bool, std::vector<double>>> ConstraintSet;
+
+        bool check(const unsigned int cases, std::mt19937 &gen)
+        {
+            const int num_agents = mrmp_pdef_->getAllProblemInformation().size();
+            freeMemory_();
+            closed_.clear();
+            stats_ = Statistics();
+            std::vector<KCBSNode*> nodes{node_arena_.create()};
+            std::vector<ConstraintSet> sets(1);
+            std::set<ConstraintSet> seen;
+            unsigned int duplicates = 0;
+            std::uniform_int_distribution<int> agent(0, num_agents - 1), step(0, 3);
+            for (unsigned int c = 0; c < cases; c++) {
+                const std::size_t parent = std::uniform_int_distribution<std::size_t>(0, nodes.size() - 1)(gen);
+                const int split = agent(gen);
+                int other = agent(gen);
+                while (other == split)
+                    other = agent(gen);
+                const double t = 0.5 * step(gen);
+                const std::vector<double> times{t, t + 0.5};
+                // as a disjoint split: the other agent avoids the region that the split agent keeps to, or the split
+                // agent leaves it
+                std::vector<ConstraintPtr> constraints{std::make_shared<Constraint>(other, split, times),
+                    std::make_shared<Constraint>(split, other, times)};
+                std::vector<ConstraintPtr> companions{std::make_shared<Constraint>(split, other, times, true), nullptr};
+                std::vector<bool> unique;
+                std::vector<ConstraintSet> child_sets;
+                for (std::size_t a = 0; a < constraints.size(); a++) {
+                    ConstraintSet set = sets[parent];
+                    for (const ConstraintPtr &k: {constraints[a], companions[a]}) {
+                        if (k)
+                            set.insert(std::make_tuple(k->getConstrainedAgent(), k->getConstrainingAgent(), k->isPositive(), k->getTimes()));
+                    }
+                    unique.push_back(seen.insert(set).second);
+                    duplicates += !unique.back();
+                    child_sets.push_back(set);
+                }
+                const KCBSNode *n = nodes[parent];
+                const std::vector<ConstraintPtr> candidates = constraints;
+                pruneDuplicates_(n, constraints, companions);
+                std::size_t kept = 0;
+                for (std::size_t a = 0; a < unique.size(); a++) {
+                    if (!unique[a])
+                        continue;
+                    // the children that are not duplicates are kept (in order), and hashed as they were keyed
+                    if (kept >= constraints.size() || constraints[kept] != candidates[a]) {
+                        OMPL_ERROR("%s: A child that is not a duplicate was pruned.", "DuplicateProbe");
+                        return false;
+                    }
+                    KCBSNode *child = node_arena_.create();
+                    child->updateParent(n);
+                    constrainChild_(child, constraints[kept], companions[kept]);
+                    if (closed_.count(child->getConstraintSetHash()) == 0) {
+                        OMPL_ERROR("%s: A child is not hashed as it was keyed.", "DuplicateProbe");
+                        return false;
+                    }
+                    nodes.push_back(child);
+                    sets.push_back(child_sets[a]);
+                    kept++;
+                }
+                if (kept != constraints.size() || stats_.duplicates_pruned_ != duplicates) {
+                    OMPL_ERROR("%s: %u duplicates pruned, but %u children had a constraint set generated before.", "DuplicateProbe",
+                        stats_.duplicates_pruned_, duplicates);
+                    return false;
+                }
+            }
+            std::cout << "KCBS duplicate detection: " << cases << " disjoint splits agree (" << duplicates << " duplicates, " <<
+                nodes.size() << " nodes)" << std::endl;
+            freeMemory_();
+            return true;
+        }
+    };
+
+    /* the service answers the requests it cannot load (a scen shorter than numAgents, a map that is not one) with an
+       error instead of exiting, and plans the next request of the same map */
+    bool check_service()
+    {
+        po::variables_map vm;
+        set(vm, "solver", std::string("K-CBS"));
+        set(vm, "lowlevel", std::string("BSST"));
+        set(vm, "p_safe", 0.9);
+        set(vm, "pvc", std::string("ChiSquared"));
+        set(vm, "svc", std::string("Blackmore"));
+        set(vm, "sdfres", 0.05);
+        set(vm, "time", 1.0);
+        set(vm, "bound", 10);
+        PlanningService service(vm, 1);
+        const std::string map(KCBS_SOURCE_DIR "/maps/narrowPassage.map");
+        const std::string scen(KCBS_SOURCE_DIR "/scens/narrowPassage-2DUncertainLinear.scen");  // of 2 robots
+        auto request = [](const std::string &map, const std::string &scen, const int k) {
+            return "{\"map\": \"" + map + "\", \"scen\": \"" + scen + "\", \"numAgents\": " + std::to_string(k) + "}";
+        };
+        const std::vector<std::pair<std::string, bool>> requests = {
+            {request(map, scen, 3), true}, {request(scen, scen, 2), true}, {request(map, scen, 2), false}};
+        for (const std::pair<std::string, bool> &r: requests) {
+            const std::string response = service.handle(r.first, "q");
+            if ((response.find("\"error\"") != std::string::npos) != r.second) {
+                std::cout << "PlanningService: " << r.first << " answered " << response << std::endl;
+                return false;
+            }
+        }
+        std::cout << "PlanningService: " << requests.size() << " requests answered" << std::endl;
+        return true;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "produce help message")
+        ("cases", po::value<unsigned int>()->default_value(200000), "number of random cases per kernel")
+        ("seed", po::value<std::uint32_t>()->default_value(0), "seed of the cases (0 to pick one)");
+    po::variables_map vm;
+    try {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+    }
+    catch (const po::error &e) {
+        OMPL_ERROR("%s: %s", "kcbs-equivalence", e.what());
+        return 1;
+    }
+    if (vm.count("help")) {
+        std::cout << desc << std::endl;
+        return 1;
+    }
+    std::uint32_t seed = vm["seed"].as<std::uint32_t>();
+    if (seed == 0)
+        seed = std::random_device()();
+    std::cout << "seed " << seed << std::endl;
+    std::mt19937 gen(seed);
+    const unsigned int cases = vm["cases"].as<unsigned int>();
+
+    ompl::msg::setLogLevel(ompl::msg::LOG_WARN);
+    const Scenario beliefs = load("random-32-32-10.map", "random-32-32-10-Rectangles-2DUncertainLinear.scen", 4, "K-CBS", "Blackmore");
+    if (!check_half_planes(beliefs, cases, gen))
+        return 1;
+    DuplicateProbe duplicates(std::make_shared<MultiRobotProblemDefinition>(beliefs.problems_));
+    if (!duplicates.check(std::min(cases, 20000u), gen))
+        return 1;
+    if (!check_service())
+        return 1;
+    for (const int k: {2, 5, 12}) {
+        const Scenario centralized = load("random-32-32-10.map", "random-32-32-10-Rectangles-2DUncertainLinear.scen", k, "CentralizedBSST", "ChiSquared");
+        if (!check_centralized(centralized, cases, gen))
+            return 1;
+    }
+    return 0;
+}
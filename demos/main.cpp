@@ -6,10 +6,18 @@
 #include "PlanValidityCheckers/AdaptiveRiskBlackmorePVC.h"
 #include "PlanValidityCheckers/ChiSquaredBoundaryPVC.h"
 #include "PlanValidityCheckers/BoundingBoxBlackmorePVC.h"
+#include "PlanValidityCheckers/CascadePVC.h"
+#include "PlanValidityCheckers/MonteCarloPVC.h"
 #include "Planners/KCBS.h"
+#include "Planners/PBS.h"
 #include "utils/postProcess.h"
 #include "utils/beliefCollisionCheckingBenchmark.h"
 #include "utils/Benchmark.h"
+#include "utils/Sweep.h"
+#include "utils/PlanningService.h"
+#include "utils/SolutionPublisher.h"
+#include "utils/Trace.h"
+#include "utils/AllocStats.h"
 
 // OMPL_INFORM("OMPL version: %s", OMPL_VERSION);  // blue font
 // OMPL_WARN("OMPL version: %s", OMPL_VERSION);  // yellow font
@@ -28,6 +36,15 @@ void parse_cmd_line(int &argc, char ** &argv, po::variables_map &vm, po::options
         ("scen,s", po::value<std::string>()->required(), "the *.scen file")
         ("numAgents,k", po::value<int>()->required(), "number of agents inside instance")
         ("benchmark", po::value<bool>()->default_value(false), "Boolean flag for benchmarking.")
+        ("serve", po::value<bool>()->default_value(false), "Boolean flag for running as a planning service: K-CBS requests are read from stdin and answered on stdout, one per line (see utils/PlanningService.h)")
+        ("sweep", po::value<std::string>()->default_value(""), "manifest of maps, scens, numbers of agents and solvers to benchmark in one run (see utils/Sweep.h)")
+        ("trials", po::value<unsigned int>()->default_value(50), "number of trials of the benchmark (passes over every belief pair of the throughput batches of the independent benchmark)")
+        ("workers", po::value<unsigned int>()->default_value(1), "number of benchmark trials (or service requests) run at once, each by a worker with its own instance and planners")
+        ("pin", po::value<bool>()->default_value(false), "Boolean flag for pinning every benchmark worker to its own CPU")
+        ("perf", po::value<bool>()->default_value(false), "Boolean flag for writing the hardware counters (cycles, instructions, cache and branch misses) of every phase next to its time in the benchmark results (Linux only)")
+        ("alloc", po::value<bool>()->default_value(false), "Boolean flag for accounting the allocations of the belief states, motions, constraints and conflict tree, reported by K-CBS and in the benchmark results (see utils/AllocStats.h)")
+        ("seed", po::value<std::uint32_t>()->default_value(0), "seed of the random number generators, recorded with the benchmark results (0 to pick one). K-CBS derives the seed of every low-level call from it")
+        ("replay", po::value<std::string>()->default_value(""), "replay log output file of K-CBS: the expanded nodes and the seed of every low-level call, in order (e.g. replay.csv)")
         ("independentBenchmark", po::value<bool>()->default_value(false), "Boolean flag for running independent collision checking benchmark. Must be accompanied by both inputFile flags")
         ("inputFile1", po::value<std::string>()->default_value(""), "first input file for collision checking benchmarks")
         ("inputFile2", po::value<std::string>()->default_value(""), "second input file for collision checking benchmarks")
@@ -35,14 +52,48 @@ void parse_cmd_line(int &argc, char ** &argv, po::variables_map &vm, po::options
         ("lowlevel,l", po::value<std::string>()->default_value("RRT"), "The low-level motion planner for K-CBS (RRT, BSST)")
         ("bound,b", po::value<int>()->default_value(std::numeric_limits<int>::max()), "The merge bound of K-CBS.")
         ("time,t", po::value<double>()->default_value(300), "cutoff time (seconds)")
-        ("output,o", po::value<std::string>()->default_value("results"), "output file name (e.g. results.csv)")
+        ("bypass", po::value<bool>()->default_value(false), "Boolean flag for bypassing conflicts in K-CBS")
+        ("threads", po::value<unsigned int>()->default_value(1), "number of threads used by K-CBS for root planning and to replan child nodes")
+        ("pipeline", po::value<unsigned int>()->default_value(0), "number of K-CBS replans running on the threads while the search expands the nodes already replanned (0 to replan the children of a node before the next one is popped)")
+        ("ordered", po::value<bool>()->default_value(false), "Boolean flag for collecting the pipelined K-CBS replans in the order they were started, so a seeded search is reproducible")
+        ("pvcthreads", po::value<unsigned int>()->default_value(1), "number of threads splitting the steps of a plan when K-CBS validates it (BSST only)")
+        ("pvcsubsteps", po::value<unsigned int>()->default_value(0), "finest fraction (1/n) of a step the motion between the steps of a plan is validated at, or 0 to validate the steps only (BSST only)")
+        ("window", po::value<double>()->default_value(std::numeric_limits<double>::infinity()), "K-CBS only resolves conflicts within this many seconds of the plan")
+        ("anytime", po::value<bool>()->default_value(false), "Boolean flag for improving the K-CBS solution until the time runs out")
+        ("lazy", po::value<bool>()->default_value(false), "Boolean flag for replanning the children of K-CBS only once they are popped")
+        ("duplicates", po::value<bool>()->default_value(false), "Boolean flag for pruning K-CBS children whose constraint sets were already generated")
+        ("disjoint", po::value<bool>()->default_value(false), "Boolean flag for splitting the conflicts of K-CBS disjointly (with positive constraints)")
+        ("independence", po::value<bool>()->default_value(false), "Boolean flag for splitting K-CBS into independent groups of agents")
+        ("allconflicts", po::value<bool>()->default_value(false), "Boolean flag for finding every conflict interval of a K-CBS node in one validation pass")
+        ("classify", po::value<bool>()->default_value(false), "Boolean flag for branching K-CBS on cardinal conflicts first, by probing the low-level trees (BSST only)")
+        ("warmstart", po::value<bool>()->default_value(false), "Boolean flag for reusing the low-level trees of K-CBS when constraints are added (BSST only)")
+        ("llthreads", po::value<unsigned int>()->default_value(1), "number of threads growing each low-level tree of K-CBS (BSST only)")
+        ("llbatch", po::value<unsigned int>()->default_value(1), "number of controls propagated together per low-level extension, the best one is kept (BSST only)")
+        ("heuristic", po::value<double>()->default_value(0), "probability of sampling ahead of each low-level tree along the cost-to-go of the map, 0 to sample uniformly (BSST only)")
+        ("portfolio", po::value<std::string>()->default_value(""), "low-level planners raced against the planner of the agent on every K-CBS replan, the first valid path is kept (e.g. \"BSST:selection_radius=0.5,pruning_radius=0.05;RRT:goal_bias=0.2\")")
+        ("portfoliowidth", po::value<unsigned int>()->default_value(0), "number of planners in a portfolio race (the agent's planner and the members with the best win rates), 0 for every member")
+        ("ranks", po::value<unsigned int>()->default_value(1), "number of ranks (processes, on one or more machines) of a distributed K-CBS search, each started with the same problem and its own --rank")
+        ("rank", po::value<unsigned int>()->default_value(0), "rank of this process in a distributed K-CBS search (rank 0 is the hub, which the others connect to)")
+        ("cluster", po::value<std::string>()->default_value("localhost:7770"), "host:port of the hub of a distributed K-CBS search (rank 0 listens on the port)")
+        ("stealbatch", po::value<unsigned int>()->default_value(16), "largest number of K-CBS nodes a rank gives away when another rank runs out of nodes")
+        ("checkpoint", po::value<std::string>()->default_value(""), "K-CBS checkpoint file (e.g. search.ckpt), written periodically and when time runs out")
+        ("checkpointinterval", po::value<double>()->default_value(60), "seconds between K-CBS checkpoints")
+        ("resume", po::value<bool>()->default_value(false), "Boolean flag for resuming the K-CBS search saved in the checkpoint file (from the start if there is none)")
+        ("memory", po::value<double>()->default_value(0), "memory budget of the K-CBS open list in MB, beyond which its most expensive nodes are compressed to their constraints (0 for unlimited)")
+        ("textplan", po::value<bool>()->default_value(false), "Boolean flag for also writing the solution trajectories as text files (for debugging)")
+        ("publish", po::value<std::string>()->default_value(""), "shared memory ring the K-CBS solutions are also published to for the executors on this host (e.g. /kcbs-solutions, see utils/SolutionPublisher.h)")
+        ("trace", po::value<std::string>()->default_value(""), "Chrome trace output file (e.g. trace.json), requires building with KCBS_TRACING")
+        ("output,o", po::value<std::string>()->default_value("results"), "output file name (e.g. results.csv, or results.jsonl for one JSON object per result)")
         ("p_safe,p", po::value<double>()->default_value(0.9), "Probability of safe in decimal form (only used for non-deterministic planning sequences)")
         ("pvc,c", po::value<std::string>()->default_value("ChiSquaredBoundary"), "The Collision-Checker to be used."
             "This is only used for non-deterministic planning instances."
-            "(ChiSquared, Blackmore, AdaptiveBlackmore, CDFGrid-x, BoundingBox")
+            "(ChiSquared, Blackmore, AdaptiveBlackmore, CDFGrid-x, MonteCarlo-x, BoundingBox, or Cascade:cheap,...,tight e.g. Cascade:BoundingBox,CDFGrid-30")
         ("svc,v", po::value<std::string>()->default_value("Blackmore"), "The Low-Level collision-checker to be used."
             "This is only used for non-deterministic planning instances."
-            "(Blackmore, AdaptiveBlackmore, ChiSquared)")
+            "(Blackmore, AdaptiveBlackmore, ChiSquared, ChiSquaredSDF)")
+        ("experience", po::value<bool>()->default_value(false), "Boolean flag for replaying the low-level trajectories of earlier problems on the same map (by robot shape and dynamics) before growing a fresh BSST tree, and caching the new ones")
+        ("mapcache", po::value<std::string>()->default_value(""), "directory of the binary cache of parsed maps (obstacles and inflated obstacles), keyed by the hash of the map file (empty to disable)")
+        ("sdfres", po::value<double>()->default_value(0.05), "resolution of the signed distance field used by the ChiSquaredSDF collision-checker")
         ("screen", po::value<int>()->default_value(0),
                 "screen option \n0 := none \n1 := K-CBS updates \n2 := Low-Level Planner updates \n3 := MRMP detailed updates");
     po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -58,20 +109,73 @@ int main(int argc, char ** argv)
         std::cout << desc << std::endl;
         return 1;
     }
-    else if (vm["independentBenchmark"].as<bool>()) {
+    // before anything is allocated, so every release is of an allocation that was counted
+    alloc::setEnabled(vm["alloc"].as<bool>());
+    if (vm["independentBenchmark"].as<bool>()) {
         BeliefCollisionCheckerBenchmark tester(vm["inputFile1"].as<std::string>(), vm["inputFile2"].as<std::string>());
+        // scaling over 1, 2, 4, ... up to the requested threads
+        const unsigned int max_threads = std::max(1u, vm["threads"].as<unsigned int>());
+        std::vector<unsigned int> threads;
+        for (unsigned int t = 1; t < max_threads; t *= 2)
+            threads.push_back(t);
+        threads.push_back(max_threads);
+        tester.setThreads(threads);
+        tester.setIterations(vm["trials"].as<unsigned int>());
+        tester.setSummaryFile(vm["output"].as<std::string>() + "_summary.csv");
+        tester.setPerfCounters(vm["perf"].as<bool>());
         tester.runBenchmarks();
         return 1;
     }
-    else if (vm["benchmark"].as<bool>()) {
-        InstancePtr instance = std::make_shared<Instance>(vm);
-        if (instance->getPlannerName() == "K-CBS")
-            run_kcbs_benchmark(instance, vm["bound"].as<int>(), vm["time"].as<double>(), vm["output"].as<std::string>());
-        else if (instance->getPlannerName() == "CentralizedBSST")
-            run_centralized_bsst_benchmark(instance, vm["time"].as<double>(), vm["output"].as<std::string>());
+    else if (vm["serve"].as<bool>()) {
+        // stdout only carries the responses, the logs (and any other output) go to stderr
+        std::ostream responses(std::cout.rdbuf());
+        std::streambuf *stdout_buf = std::cout.rdbuf(std::cerr.rdbuf());
+        PlanningService service(vm, vm["workers"].as<unsigned int>());
+        service.serve(std::cin, responses);
+        std::cout.rdbuf(stdout_buf);
+        return 0;
+    }
+    else if (vm["benchmark"].as<bool>() || !vm["sweep"].as<std::string>().empty()) {
+        BenchmarkOptions options;
+        options.trials_ = vm["trials"].as<unsigned int>();
+        options.workers_ = vm["workers"].as<unsigned int>();
+        options.pin_cpus_ = vm["pin"].as<bool>();
+        options.seed_ = vm["seed"].as<std::uint32_t>();
+        options.perf_counters_ = vm["perf"].as<bool>();
+        options.alloc_stats_ = vm["alloc"].as<bool>();
+        if (!vm["sweep"].as<std::string>().empty()) {
+            run_sweep(vm, vm["sweep"].as<std::string>(), options);
+            return 1;
+        }
+        const std::string planner = vm["solver"].as<std::string>();
+        if (planner == "K-CBS")
+            run_kcbs_benchmark(vm, vm["bound"].as<int>(), vm["time"].as<double>(), vm["output"].as<std::string>(), options);
+        else if (planner == "CentralizedBSST")
+            run_centralized_bsst_benchmark(vm, vm["time"].as<double>(), vm["output"].as<std::string>(), options);
+        return 1;
+    }
+
+    std::vector<oc::KCBS::PortfolioMember> portfolio;
+    if (!oc::KCBS::parsePortfolio(vm["portfolio"].as<std::string>(), portfolio)) {
+        OMPL_ERROR("%s: Invalid portfolio ``%s``.", "main", vm["portfolio"].as<std::string>().c_str());
         return 1;
     }
 
+    // connect the ranks of a distributed K-CBS search
+    std::shared_ptr<SearchCluster> cluster = nullptr;
+    if (vm["ranks"].as<unsigned int>() > 1) {
+        const std::string address = vm["cluster"].as<std::string>();
+        const std::size_t colon = address.rfind(':');
+        if (colon == std::string::npos) {
+            OMPL_ERROR("%s: Invalid cluster address ``%s`` (expected host:port).", "main", address.c_str());
+            return 1;
+        }
+        cluster = std::make_shared<SearchCluster>(vm["rank"].as<unsigned int>(), vm["ranks"].as<unsigned int>(), 
+            address.substr(0, colon), std::atoi(address.substr(colon + 1).c_str()));
+        if (!cluster->connect(60))
+            return 1;
+    }
+
     // set-up planning instance
     InstancePtr instance = std::make_shared<Instance>(vm);
     instance->print(); // print the map (for debugging etc.)
@@ -98,7 +202,30 @@ int main(int argc, char ** argv)
             // create instance of K-CBS, set-up, and solve
             ob::PlannerPtr p(std::make_shared<oc::KCBS>(mrmp_pdef));
             p->as<oc::KCBS>()->setMergeBound(vm["bound"].as<int>());
-            bool solved = p->solve(vm["time"].as<double>());
+            p->as<oc::KCBS>()->setNumThreads(vm["threads"].as<unsigned int>());
+            p->as<oc::KCBS>()->setPipelineDepth(vm["pipeline"].as<unsigned int>());
+            p->as<oc::KCBS>()->setPipelineOrdered(vm["ordered"].as<bool>());
+            p->as<oc::KCBS>()->setBypassing(vm["bypass"].as<bool>());
+            p->as<oc::KCBS>()->setLazyExpansion(vm["lazy"].as<bool>());
+            p->as<oc::KCBS>()->setAnytime(vm["anytime"].as<bool>());
+            p->as<oc::KCBS>()->setConflictWindow(vm["window"].as<double>());
+            p->as<oc::KCBS>()->setDuplicateDetection(vm["duplicates"].as<bool>());
+            p->as<oc::KCBS>()->setDisjointSplitting(vm["disjoint"].as<bool>());
+            p->as<oc::KCBS>()->setIndependenceDetection(vm["independence"].as<bool>());
+            p->as<oc::KCBS>()->setAllConflicts(vm["allconflicts"].as<bool>());
+            p->as<oc::KCBS>()->setConflictClassification(vm["classify"].as<bool>());
+            p->as<oc::KCBS>()->setPortfolio(portfolio);
+            p->as<oc::KCBS>()->setPortfolioWidth(vm["portfoliowidth"].as<unsigned int>());
+            p->as<oc::KCBS>()->setMemoryBudget(vm["memory"].as<double>() * 1024 * 1024);
+            p->as<oc::KCBS>()->setSeed(instance->getSeed());
+            p->as<oc::KCBS>()->setCluster(cluster);
+            p->as<oc::KCBS>()->setStealBatch(vm["stealbatch"].as<unsigned int>());
+            p->as<oc::KCBS>()->setCheckpoint(vm["checkpoint"].as<std::string>(), vm["checkpointinterval"].as<double>());
+            bool solved = (vm["resume"].as<bool>() && !vm["checkpoint"].as<std::string>().empty()) ?
+                p->as<oc::KCBS>()->resumeCheckpoint(vm["checkpoint"].as<std::string>(), 
+                    ob::timedPlannerTerminationCondition(vm["time"].as<double>())) : p->solve(vm["time"].as<double>());
+            if (!vm["replay"].as<std::string>().empty())
+                p->as<oc::KCBS>()->writeReplayLog(vm["replay"].as<std::string>());
         }
         else if (low_level_planner == "BSST") {
             // set-up (and include) a Merger in case merge bound is hit
@@ -122,6 +249,10 @@ int main(int argc, char ** argv)
             else if (instance->getPVC() == "AdaptiveBlackmore") {
                 planValidator = std::make_shared<AdaptiveRiskBlackmorePVC>(mrmp_pdef, instance->getPsafeAgents());
             }
+            else if (instance->getPVC().find("Cascade:") == 0) {
+                // e.g. Cascade:BoundingBox,CDFGrid-30
+                planValidator = CascadePVC::create(mrmp_pdef, instance->getPsafeAgents(), instance->getPVC().substr(8));
+            }
             else if (instance->getPVC().find("CDFGrid") != std::string::npos) {
                 boost::char_separator<char> sep("-");
                 boost::tokenizer< boost::char_separator<char> > tok(instance->getPVC(), sep);
@@ -131,24 +262,76 @@ int main(int argc, char ** argv)
                 OMPL_INFORM("The plan validity checker is CDFGrid with discretization of %d", disks);
                 planValidator = std::make_shared<CDFGridPVC>(mrmp_pdef, instance->getPsafeAgents(), disks);
             }
+            else if (instance->getPVC().find("MonteCarlo-") == 0) {
+                const int samples = atoi(instance->getPVC().substr(11).c_str());
+                OMPL_INFORM("The plan validity checker is MonteCarlo with at most %d samples per pair", samples);
+                planValidator = std::make_shared<MonteCarloPVC>(mrmp_pdef, instance->getPsafeAgents(), samples);
+            }
             else {
                 OMPL_ERROR("Plan Validity Checker ``%s`` is not available.", instance->getPVC().c_str());
             }
             assert(planValidator != nullptr);
+            planValidator->setNumThreads(vm["pvcthreads"].as<unsigned int>());
+            if (vm["pvcsubsteps"].as<unsigned int>() > 0) {
+                if (BeliefPVCPtr belief_pvc = std::dynamic_pointer_cast<BeliefPVC>(planValidator))
+                    belief_pvc->setContinuous(vm["pvcsubsteps"].as<unsigned int>());
+            }
             mrmp_pdef->setPlanValidator(planValidator);
+            // reuse the low-level trees between replans (if requested)
+            for (int i = 0; i < vm["numAgents"].as<int>(); i++) {
+                ob::PlannerPtr ll_planner = mrmp_pdef->getRobotMotionPlanningProblemPtr(i)->getPlanner();
+                ll_planner->as<ConstraintRespectingPlanner>()->setWarmStart(vm["warmstart"].as<bool>());
+                if (ll_planner->params().hasParam("threads"))
+                    ll_planner->params().setParam("threads", std::to_string(vm["llthreads"].as<unsigned int>()));
+                if (ll_planner->params().hasParam("batch_controls"))
+                    ll_planner->params().setParam("batch_controls", std::to_string(vm["llbatch"].as<unsigned int>()));
+                if (vm["heuristic"].as<double>() > 0) {
+                    ll_planner->as<ConstraintRespectingPlanner>()->setCostToGo(instance->getCostToGoMap(instance->getRobots()[i]));
+                    ll_planner->as<ConstraintRespectingPlanner>()->setHeuristicBias(vm["heuristic"].as<double>());
+                }
+            }
             // create instance of K-CBS, set-up, and solve
             ob::PlannerPtr p(std::make_shared<oc::KCBS>(mrmp_pdef));
             p->as<oc::KCBS>()->setMergeBound(vm["bound"].as<int>());
-            bool solved = p->solve(vm["time"].as<double>());
-            if (solved) {
+            p->as<oc::KCBS>()->setNumThreads(vm["threads"].as<unsigned int>());
+            p->as<oc::KCBS>()->setPipelineDepth(vm["pipeline"].as<unsigned int>());
+            p->as<oc::KCBS>()->setPipelineOrdered(vm["ordered"].as<bool>());
+            p->as<oc::KCBS>()->setBypassing(vm["bypass"].as<bool>());
+            p->as<oc::KCBS>()->setLazyExpansion(vm["lazy"].as<bool>());
+            p->as<oc::KCBS>()->setAnytime(vm["anytime"].as<bool>());
+            p->as<oc::KCBS>()->setConflictWindow(vm["window"].as<double>());
+            p->as<oc::KCBS>()->setDuplicateDetection(vm["duplicates"].as<bool>());
+            p->as<oc::KCBS>()->setDisjointSplitting(vm["disjoint"].as<bool>());
+            p->as<oc::KCBS>()->setIndependenceDetection(vm["independence"].as<bool>());
+            p->as<oc::KCBS>()->setAllConflicts(vm["allconflicts"].as<bool>());
+            p->as<oc::KCBS>()->setConflictClassification(vm["classify"].as<bool>());
+            p->as<oc::KCBS>()->setPortfolio(portfolio);
+            p->as<oc::KCBS>()->setPortfolioWidth(vm["portfoliowidth"].as<unsigned int>());
+            p->as<oc::KCBS>()->setMemoryBudget(vm["memory"].as<double>() * 1024 * 1024);
+            p->as<oc::KCBS>()->setSeed(instance->getSeed());
+            p->as<oc::KCBS>()->setCluster(cluster);
+            p->as<oc::KCBS>()->setStealBatch(vm["stealbatch"].as<unsigned int>());
+            p->as<oc::KCBS>()->setCheckpoint(vm["checkpoint"].as<std::string>(), vm["checkpointinterval"].as<double>());
+            bool solved = (vm["resume"].as<bool>() && !vm["checkpoint"].as<std::string>().empty()) ?
+                p->as<oc::KCBS>()->resumeCheckpoint(vm["checkpoint"].as<std::string>(), 
+                    ob::timedPlannerTerminationCondition(vm["time"].as<double>())) : p->solve(vm["time"].as<double>());
+            if (!vm["replay"].as<std::string>().empty())
+                p->as<oc::KCBS>()->writeReplayLog(vm["replay"].as<std::string>());
+            // the hub holds the solution of a distributed search
+            if (solved && (!cluster || cluster->isHub())) {
                 // extract and write results to file
                 std::vector<oc::PathControl*> plan;
                 for (int i=0; i < vm["numAgents"].as<int>(); i++) {
                     oc::PathControl* path = mrmp_pdef->getRobotProblemDefinitionPtr(i)->getSolutionPath()->as<oc::PathControl>();
                     plan.push_back(path);
                 }
-                exportBeliefPlan(plan, vm["output"].as<std::string>());
+                exportBeliefPlan(plan, vm["output"].as<std::string>(), vm["textplan"].as<bool>());
+                SolutionPublisher publisher;
+                if (!vm["publish"].as<std::string>().empty() && publisher.open(vm["publish"].as<std::string>()))
+                    publisher.publish(plan);
             }
+            if (CascadePVCPtr cascade = std::dynamic_pointer_cast<CascadePVC>(planValidator))
+                cascade->printStats();
         } 
         else {
             OMPL_ERROR("%s: Implementation of K-CBS w/ %s is unavailable.", "main", low_level_planner.c_str());
@@ -162,8 +345,12 @@ int main(int argc, char ** argv)
     }
     else if (high_level_planner == "PBS") {
         if (low_level_planner == "RRT") {
-            // solve standard MRMP w. PBS
-            OMPL_WARN("%s: Planning with PBS not implemented after refactor.", "main");
+            // solve standard MRMP w. PBS, planning the two branches of a node in parallel if threads are available
+            ob::PlannerPtr p(std::make_shared<oc::PBS>(mp_problems));
+            p->as<oc::PBS>()->setInstance(instance.get());
+            p->as<oc::PBS>()->setParallelBranches(vm["threads"].as<unsigned int>() > 1);
+            bool solved = p->solve(vm["time"].as<double>());
+            OMPL_INFORM("%s: PBS %s in %0.3f seconds.", "main", solved ? "solved" : "failed", p->as<oc::PBS>()->getSolveTime());
         }
         else {
             OMPL_ERROR("%s: Implementation of PBS w/ %s is unavailable.", "main", low_level_planner.c_str());
@@ -176,5 +363,7 @@ int main(int argc, char ** argv)
     else {
         OMPL_ERROR("%s: Implementation of %s w/ %s is unavailable.", "main", high_level_planner.c_str());
     }
+    if (!vm["trace"].as<std::string>().empty() && !KCBS_TRACE_DUMP(vm["trace"].as<std::string>()))
+        OMPL_WARN("%s: No trace written. Build with -DKCBS_TRACING=ON to record one.", "main");
     return 0;
 }
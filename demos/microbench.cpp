@@ -0,0 +1,417 @@
+#include "utils/OmplSetUp.h"
+#include "utils/DiscretePlan.h"
+#include "PlanValidityCheckers/DeterministicPVC.h"
+#include "PlanValidityCheckers/MinkowskiSumBlackmorePVC.h"
+#include "PlanValidityCheckers/AdaptiveRiskBlackmorePVC.h"
+#include "PlanValidityCheckers/AdaptiveRiskBoundingBoxPVC.h"
+#include "PlanValidityCheckers/ChiSquaredBoundaryPVC.h"
+#include "PlanValidityCheckers/BoundingBoxBlackmorePVC.h"
+#include "PlanValidityCheckers/Blackmore2PVC.h"
+#include "PlanValidityCheckers/CDFGridPVC.h"
+#include "PlanValidityCheckers/CascadePVC.h"
+#include "PlanValidityCheckers/MonteCarloPVC.h"
+#include "utils/PerfCounters.h"
+#include "Spaces/FixedBeliefSpace.h"
+#include <boost/math/special_functions/erf.hpp>
+#include <benchmark/benchmark.h>
+#include <functional>
+#include <map>
+
+// Microbenchmarks of the hot kernels (validity checkers, propagators, distances and goals) on fixtures built from the
+// shipped maps and scens. Run e.g. kcbs-microbench --benchmark_filter=PVC and compare against a previous run with
+// Google Benchmark's compare.py. With --perf, the hardware counters per iteration (cycles, instructions, cache and
+// branch misses) are reported next to the times. The Precision benchmarks time the belief kernels in single and double
+// precision, and report the fraction of their decisions that differ from double.
+
+
+namespace
+{
+    const unsigned int num_samples = 1024;
+    const unsigned int plan_steps = 200;
+
+    /* an instance of a shipped map and scen, and its low-level problems */
+    struct Scenario
+    {
+        InstancePtr instance_;
+        std::vector<MotionPlanningProblemPtr> problems_;
+        MultiRobotProblemDefinitionPtr mrmp_pdef_;
+    };
+
+    Scenario load(const std::string &map, const std::string &scen, const int k, const std::string &solver,
+        const std::string &low_level, const std::string &svc)
+    {
+        po::variables_map vm;
+        auto set = [&vm](const std::string &key, const boost::any &value) {
+            static_cast<std::map<std::string, po::variable_value> &>(vm)[key] = po::variable_value(value, false);
+        };
+        set("map", std::string(KCBS_SOURCE_DIR "/maps/") + map);
+        set("scen", std::string(KCBS_SOURCE_DIR "/scens/") + scen);
+        set("numAgents", k);
+        set("solver", solver);
+        set("lowlevel", low_level);
+        set("p_safe", 0.9);
+        set("pvc", std::string("ChiSquared"));
+        set("svc", svc);
+        set("sdfres", 0.05);
+        Scenario s;
+        s.instance_ = std::make_shared<Instance>(vm, "Microbench");
+        s.problems_ = set_up_all_MP_Problems(s.instance_);
+        s.mrmp_pdef_ = std::make_shared<MultiRobotProblemDefinition>(s.problems_);
+        s.mrmp_pdef_->setMultiRobotInstance(s.instance_);
+        return s;
+    }
+
+    /* states of si drawn uniformly, with the other components (e.g. the covariance) of start */
+    std::vector<ob::State *> sample_states(const oc::SpaceInformationPtr &si, const ob::State *start)
+    {
+        ob::StateSamplerPtr sampler = si->allocStateSampler();
+        std::vector<ob::State *> states;
+        for (unsigned int i = 0; i < num_samples; i++) {
+            states.push_back(si->cloneState(start));
+            sampler->sampleUniform(states.back());
+        }
+        return states;
+    }
+
+    std::vector<oc::Control *> sample_controls(const oc::SpaceInformationPtr &si)
+    {
+        oc::ControlSamplerPtr sampler = si->allocControlSampler();
+        std::vector<oc::Control *> controls;
+        for (unsigned int i = 0; i < num_samples; i++) {
+            controls.push_back(si->allocControl());
+            sampler->sample(controls.back());
+        }
+        return controls;
+    }
+
+    /* an interpolated trajectory of random controls from start, each applied for one step */
+    DiscretePlan::TrajectoryPtr random_trajectory(const oc::SpaceInformationPtr &si, const ob::State *start)
+    {
+        auto path = std::make_shared<oc::PathControl>(si);
+        path->append(start);
+        oc::ControlSamplerPtr sampler = si->allocControlSampler();
+        oc::Control *control = si->allocControl();
+        ob::State *from = si->cloneState(start);
+        ob::State *to = si->allocState();
+        const double dt = si->getPropagationStepSize();
+        for (unsigned int k = 0; k < plan_steps; k++) {
+            // hold a control for 10 steps, so the robots move away from their starts
+            if (k % 10 == 0)
+                sampler->sample(control);
+            si->getStatePropagator()->propagate(from, control, dt, to);
+            path->append(to, control, dt);
+            std::swap(from, to);
+        }
+        si->freeState(from);
+        si->freeState(to);
+        si->freeControl(control);
+        return path;
+    }
+
+    /* the random trajectories of every robot of s from its start */
+    DiscretePlan random_plan(const Scenario &s)
+    {
+        std::vector<DiscretePlan::TrajectoryPtr> trajs;
+        for (const MotionPlanningProblemPtr &problem: s.problems_)
+            trajs.push_back(random_trajectory(problem->getSpaceInformation(), problem->getProblemDefinition()->getStartState(0)));
+        return DiscretePlan(std::move(trajs));
+    }
+
+    /* the plan of s in which every robot follows the trajectory of robot 0, so every pair is in conflict */
+    DiscretePlan colliding_plan(const DiscretePlan &p)
+    {
+        std::vector<DiscretePlan::TrajectoryPtr> trajs(p.size(), p.getTrajectoryPtr(0));
+        return DiscretePlan(std::move(trajs));
+    }
+
+    /* register the benchmark fn, and its hardware counters when they are enabled */
+    void register_kernel(const std::string &name, const std::function<void(benchmark::State &)> &fn)
+    {
+        benchmark::RegisterBenchmark(name.c_str(), [fn](benchmark::State &state) {
+            const perf::Counters c0 = perf::read();
+            fn(state);
+            if (!perf::available())
+                return;
+            const perf::Counters c = perf::read() - c0;
+            state.counters["cycles"] = benchmark::Counter(c.cycles_, benchmark::Counter::kAvgIterations);
+            state.counters["instructions"] = benchmark::Counter(c.instructions_, benchmark::Counter::kAvgIterations);
+            state.counters["IPC"] = c.ipc();
+            state.counters["cache-misses"] = benchmark::Counter(c.cache_misses_, benchmark::Counter::kAvgIterations);
+            state.counters["branch-misses"] = benchmark::Counter(c.branch_misses_, benchmark::Counter::kAvgIterations);
+        });
+    }
+
+    void register_svc(const std::string &name, const Scenario &s)
+    {
+        const oc::SpaceInformationPtr si = s.problems_[0]->getSpaceInformation();
+        const std::vector<ob::State *> states = sample_states(si, s.problems_[0]->getProblemDefinition()->getStartState(0));
+        register_kernel(("SVC/" + name + "/isValid").c_str(), [si, states](benchmark::State &state) {
+            const ob::StateValidityChecker &svc = *si->getStateValidityChecker();
+            std::size_t i = 0;
+            for (auto _: state)
+                benchmark::DoNotOptimize(svc.isValid(states[i++ % states.size()]));
+        });
+    }
+
+    void register_propagator(const std::string &name, const Scenario &s)
+    {
+        const oc::SpaceInformationPtr si = s.problems_[0]->getSpaceInformation();
+        const std::vector<ob::State *> states = sample_states(si, s.problems_[0]->getProblemDefinition()->getStartState(0));
+        const std::vector<oc::Control *> controls = sample_controls(si);
+        register_kernel(("Propagator/" + name + "/propagate").c_str(), [si, states, controls](benchmark::State &state) {
+            const oc::StatePropagator &propagator = *si->getStatePropagator();
+            const double dt = si->getPropagationStepSize();
+            ob::State *result = si->allocState();
+            std::size_t i = 0;
+            for (auto _: state) {
+                propagator.propagate(states[i % states.size()], controls[i % controls.size()], dt, result);
+                benchmark::ClobberMemory();
+                i++;
+            }
+            si->freeState(result);
+        });
+    }
+
+    void register_distance(const std::string &name, const Scenario &s)
+    {
+        const oc::SpaceInformationPtr si = s.problems_[0]->getSpaceInformation();
+        const std::vector<ob::State *> states = sample_states(si, s.problems_[0]->getProblemDefinition()->getStartState(0));
+        register_kernel(("Space/" + name + "/distance").c_str(), [si, states](benchmark::State &state) {
+            const ob::StateSpace &space = *si->getStateSpace();
+            std::size_t i = 0;
+            for (auto _: state) {
+                benchmark::DoNotOptimize(space.distance(states[i % states.size()], states[(i + 1) % states.size()]));
+                i++;
+            }
+        });
+    }
+
+    void register_goal(const std::string &name, const Scenario &s)
+    {
+        const oc::SpaceInformationPtr si = s.problems_[0]->getSpaceInformation();
+        const ob::ProblemDefinitionPtr pdef = s.problems_[0]->getProblemDefinition();
+        const std::vector<ob::State *> states = sample_states(si, pdef->getStartState(0));
+        register_kernel(("Goal/" + name + "/isSatisfied").c_str(), [pdef, states](benchmark::State &state) {
+            const ob::Goal &goal = *pdef->getGoal();
+            std::size_t i = 0;
+            for (auto _: state)
+                benchmark::DoNotOptimize(goal.isSatisfied(states[i++ % states.size()]));
+        });
+    }
+
+    /* validatePlan on a random plan, and satisfiesConstraints on the constraint of a colliding plan */
+    void register_pvc(const std::string &name, const PlanValidityCheckerPtr &pvc, const Scenario &s)
+    {
+        if (!pvc)
+            return;
+        const DiscretePlan plan = random_plan(s);
+        const DiscretePlan collision = colliding_plan(plan);
+        register_kernel(("PVC/" + name + "/validatePlan").c_str(), [pvc, plan](benchmark::State &state) {
+            for (auto _: state)
+                benchmark::DoNotOptimize(pvc->validatePlan(plan));
+        });
+        const std::vector<ConflictPtr> conflicts = pvc->validatePlan(collision);
+        if (conflicts.empty())
+            return;
+        const std::vector<ConstraintPtr> constraints{pvc->createConstraint(collision, conflicts, 1)};
+        register_kernel(("PVC/" + name + "/satisfiesConstraints").c_str(), [pvc, plan, constraints](benchmark::State &state) {
+            for (auto _: state)
+                benchmark::DoNotOptimize(pvc->satisfiesConstraints(plan[1], constraints));
+        });
+    }
+
+    /* the pair test of a belief validator (isSafe_, through independentCheck) on beliefs near each other */
+    template <typename PVC>
+    void register_pair(const std::string &name, const std::shared_ptr<PVC> &pvc, const Scenario &s)
+    {
+        const oc::SpaceInformationPtr si = s.problems_[0]->getSpaceInformation();
+        const ob::State *start = s.problems_[0]->getProblemDefinition()->getStartState(0);
+        const std::vector<ob::State *> states_a = sample_states(si, start);
+        std::vector<ob::State *> states_b;
+        ompl::RNG rng;
+        for (const ob::State *st: states_a) {
+            states_b.push_back(si->cloneState(st));
+            // within a few robot sizes, so the pairs range from colliding to safe
+            states_b.back()->as<RealVectorBeliefSpace::StateType>()->values[0] += rng.uniformReal(-2, 2);
+            states_b.back()->as<RealVectorBeliefSpace::StateType>()->values[1] += rng.uniformReal(-2, 2);
+        }
+        register_kernel(("PVC/" + name + "/isSafe").c_str(), [pvc, states_a, states_b](benchmark::State &state) {
+            std::size_t i = 0;
+            for (auto _: state) {
+                benchmark::DoNotOptimize(pvc->independentCheck(states_a[i % states_a.size()], states_b[i % states_b.size()]));
+                i++;
+            }
+        });
+    }
+
+    /* beliefs of s near the obstacles of robot 0 (within a few robot sizes of their hulls), with covariances of
+       random scales, so the chance constraints range from clearly unsafe to clearly safe */
+    std::vector<ob::State *> sample_beliefs(const Scenario &s)
+    {
+        const oc::SpaceInformationPtr si = s.problems_[0]->getSpaceInformation();
+        std::vector<ob::State *> states = sample_states(si, s.problems_[0]->getProblemDefinition()->getStartState(0));
+        ompl::RNG rng;
+        for (ob::State *st: states) {
+            auto *belief = st->as<RealVectorBeliefSpace::StateType>();
+            belief->sigma_ *= rng.uniformReal(0.1, 10);
+            belief->lambda_ *= rng.uniformReal(0.1, 10);
+        }
+        return states;
+    }
+
+    /* the Blackmore constraints of the inflated obstacles of robot 0 in Scalar, timed, with the fraction of beliefs
+       on which they decide otherwise than in double ("mismatches") */
+    template <typename Scalar>
+    void register_precision_half_planes(const std::string &name, const Scenario &s)
+    {
+        const std::shared_ptr<const InflatedObstacles> inflated = s.instance_->getInflatedObstacles(s.instance_->getRobots()[0]);
+        auto half_planes = std::make_shared<BasicBlackmoreHalfPlanes<Scalar>>();
+        BasicBlackmoreHalfPlanes<double> reference;
+        for (const Polygon &poly: inflated->getPolygons()) {
+            const std::pair<Eigen::MatrixXd, Eigen::MatrixXd> hp = InflatedObstacles::halfPlanes(poly);
+            half_planes->add(hp.first, hp.second);
+            reference.add(hp.first, hp.second);
+        }
+        if (half_planes->size() == 0)
+            return;
+        // as PCCBlackmoreSVC: the risk is split over the obstacles
+        const double erf_inv = boost::math::erf_inv(1 - 2 * (1 - s.instance_->getPsafeObs()) / half_planes->size());
+        const std::vector<ob::State *> states = sample_beliefs(s);
+        std::size_t mismatches = 0;
+        for (const ob::State *st: states) {
+            const auto *belief = st->as<RealVectorBeliefSpace::StateType>();
+            const Eigen::Matrix2d Sigma = belief->sigma_.block<2, 2>(0, 0) + belief->lambda_.block<2, 2>(0, 0);
+            mismatches += half_planes->allSafe(belief->values[0], belief->values[1], Sigma, erf_inv) != 
+                reference.allSafe(belief->values[0], belief->values[1], Sigma, erf_inv);
+        }
+        const double rate = double(mismatches) / states.size();
+        register_kernel(("Precision/" + name + "/allSafe").c_str(), [half_planes, states, erf_inv, rate](benchmark::State &state) {
+            std::size_t i = 0;
+            for (auto _: state) {
+                const auto *belief = states[i++ % states.size()]->as<RealVectorBeliefSpace::StateType>();
+                const Eigen::Matrix2d Sigma = belief->sigma_.block<2, 2>(0, 0) + belief->lambda_.block<2, 2>(0, 0);
+                benchmark::DoNotOptimize(half_planes->allSafe(belief->values[0], belief->values[1], Sigma, erf_inv));
+            }
+            state.counters["mismatches"] = rate;
+        });
+    }
+
+    /* the distance of FixedBeliefSpace<N, Scalar>, timed, with the fraction of triples (a, b, c) on which it orders
+       d(a, b) and d(a, c) otherwise than in double ("mismatches"), i.e. picks another nearest neighbor */
+    template <unsigned int N, typename Scalar>
+    void register_precision_distance(const std::string &name, const Scenario &s)
+    {
+        // the square roots of the covariances are cached in the beliefs, so every space gets beliefs of its own
+        auto space = std::make_shared<FixedBeliefSpace<N, Scalar>>();
+        const FixedBeliefSpace<N, double> reference;
+        std::vector<ob::State *> states, reference_states;
+        for (const ob::State *st: sample_beliefs(s)) {
+            states.push_back(space->allocState());
+            space->copyState(states.back(), st);
+            reference_states.push_back(reference.allocState());
+            reference.copyState(reference_states.back(), st);
+        }
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i + 2 < states.size(); i++) {
+            const bool nearer = space->distance(states[i], states[i + 1]) < space->distance(states[i], states[i + 2]);
+            mismatches += nearer != (reference.distance(reference_states[i], reference_states[i + 1]) < 
+                reference.distance(reference_states[i], reference_states[i + 2]));
+        }
+        for (ob::State *st: reference_states)
+            reference.freeState(st);
+        const double rate = double(mismatches) / (states.size() - 2);
+        register_kernel(("Precision/" + name + "/distance").c_str(), [space, states, rate](benchmark::State &state) {
+            std::size_t i = 0;
+            for (auto _: state) {
+                benchmark::DoNotOptimize(space->distance(states[i % states.size()], states[(i + 1) % states.size()]));
+                i++;
+            }
+            state.counters["mismatches"] = rate;
+        });
+    }
+
+    void register_all()
+    {
+        // belief robots (2D uncertain linear), every obstacle validity checker
+        for (const std::string svc: {"Blackmore", "AdaptiveBlackmore", "ChiSquared", "ChiSquaredSDF"}) {
+            const Scenario s = load("random-32-32-10.map", "random-32-32-10-Rectangles-2DUncertainLinear.scen", 4, "K-CBS", "BSST", svc);
+            register_svc(svc, s);
+            if (svc == "Blackmore") {
+                register_propagator("R2UncertainLinear", s);
+                register_distance("RealVectorBelief", s);
+                register_goal("ChanceConstrained", s);
+            }
+        }
+        const Scenario unicycle = load("empty-8-8.map", "empty-8-8-Rectangles-Uncertain-Unicycle.scen", 4, "K-CBS", "BSST", "Blackmore");
+        register_propagator("UncertainUnicycle", unicycle);
+        register_distance("FixedBelief4", unicycle);
+        // single against double precision belief kernels (see utils/BeliefScalar.h)
+        const Scenario precision = load("random-32-32-10.map", "random-32-32-10-Rectangles-2DUncertainLinear.scen", 4, "K-CBS", "BSST", "Blackmore");
+        register_precision_half_planes<double>("Double/Blackmore", precision);
+        register_precision_half_planes<float>("Float/Blackmore", precision);
+        register_precision_distance<2, double>("Double/FixedBelief2", precision);
+        register_precision_distance<2, float>("Float/FixedBelief2", precision);
+        register_precision_distance<4, double>("Double/FixedBelief4", unicycle);
+        register_precision_distance<4, float>("Float/FixedBelief4", unicycle);
+        const Scenario cars = load("random-32-32-10.map", "random-32-32-10-Rectangles-FirstOrderCars.scen", 4, "K-CBS", "RRT", "Blackmore");
+        register_svc("RealVectorStateSpace", cars);
+        register_propagator("FirstOrderCar", cars);
+        const Scenario centralized = load("random-32-32-10.map", "random-32-32-10-Rectangles-2DUncertainLinear.scen", 2, "CentralizedBSST", "BSST", "ChiSquared");
+        register_svc("CentralizedChiSquared", centralized);
+        register_propagator("CentralizedUncertainLinear", centralized);
+        register_distance("BlockDiagonalBelief", centralized);
+        register_goal("CentralizedChanceConstrained", centralized);
+
+        // plan validators
+        const Scenario beliefs = load("random-32-32-10.map", "random-32-32-10-Rectangles-2DUncertainLinear.scen", 4, "K-CBS", "BSST", "Blackmore");
+        const MultiRobotProblemDefinitionPtr &pdef = beliefs.mrmp_pdef_;
+        const double p_safe = beliefs.instance_->getPsafeAgents();
+        auto chi_squared = std::make_shared<ChiSquaredBoundaryPVC>(pdef, p_safe);
+        auto minkowski = std::make_shared<MinkowskiSumBlackmorePVC>(pdef, p_safe);
+        auto adaptive = std::make_shared<AdaptiveRiskBlackmorePVC>(pdef, p_safe);
+        auto bounding_box = std::make_shared<BoundingBoxBlackmorePVC>(pdef, p_safe);
+        auto adaptive_box = std::make_shared<AdaptiveRiskBoundingBoxPVC>(pdef, p_safe);
+        auto blackmore2 = std::make_shared<Blackmore2PVC>(pdef, p_safe);
+        auto cdf_grid = std::make_shared<CDFGridPVC>(pdef, p_safe, 30);
+        auto monte_carlo = std::make_shared<MonteCarloPVC>(pdef, p_safe, 1024);
+        register_pvc("ChiSquared", chi_squared, beliefs);
+        register_pvc("Blackmore", minkowski, beliefs);
+        register_pvc("AdaptiveBlackmore", adaptive, beliefs);
+        register_pvc("BoundingBox", bounding_box, beliefs);
+        register_pvc("AdaptiveBoundingBox", adaptive_box, beliefs);
+        register_pvc("Blackmore2", blackmore2, beliefs);
+        register_pvc("CDFGrid-30", cdf_grid, beliefs);
+        register_pvc("MonteCarlo-1024", monte_carlo, beliefs);
+        register_pvc("Cascade:BoundingBox,CDFGrid-30", CascadePVC::create(pdef, p_safe, "BoundingBox,CDFGrid-30"), beliefs);
+        register_pair("ChiSquared", chi_squared, beliefs);
+        register_pair("Blackmore", minkowski, beliefs);
+        register_pair("AdaptiveBlackmore", adaptive, beliefs);
+        register_pair("BoundingBox", bounding_box, beliefs);
+        register_pair("AdaptiveBoundingBox", adaptive_box, beliefs);
+        register_pair("Blackmore2", blackmore2, beliefs);
+        register_pair("CDFGrid-30", cdf_grid, beliefs);
+        register_pair("MonteCarlo-1024", monte_carlo, beliefs);
+        register_pvc("Deterministic", std::make_shared<DeterministicPlanValidityChecker>(cars.mrmp_pdef_), cars);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ompl::msg::setLogLevel(ompl::msg::LOG_WARN);
+    // --perf is ours, the other arguments are Google Benchmark's
+    int args = 1;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--perf")
+            perf::setEnabled(true);
+        else
+            argv[args++] = argv[i];
+    }
+    argc = args;
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    register_all();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include "utils/ScenarioGenerator.h"
+#include <ompl/util/Console.h>
+#include <boost/program_options.hpp>
+#include <iostream>
+
+namespace po = boost::program_options;
+
+// writes a synthetic map and scen (see utils/ScenarioGenerator.h), e.g.
+// kcbs-scengen --width 256 --height 256 --density 0.1 --agents 100 --dynamics Uncertain-Unicycle-Model --shape Rectangle
+
+int main(int argc, char ** argv)
+{
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "produce help message")
+        ("width", po::value<int>()->default_value(64), "number of columns of the map")
+        ("height", po::value<int>()->default_value(64), "number of rows of the map")
+        ("density", po::value<double>()->default_value(0.1), "fraction of the cells of the map that are blocked")
+        ("agents,k", po::value<unsigned int>()->default_value(10), "number of agents of the scen")
+        ("dynamics", po::value<std::string>()->default_value("2D-Uncertain-Linear-Model"), "dynamics model of the agents (2D-Uncertain-Linear-Model, Uncertain-Unicycle-Model, FirstOrderCar)")
+        ("shape", po::value<std::string>()->default_value("Point"), "shape of the agents (Point, Rectangle)")
+        ("spacing", po::value<double>()->default_value(2.0), "least distance between two starts, and between two goals (cells)")
+        ("seed", po::value<std::uint32_t>()->default_value(0), "seed of the map and the agents (0 to pick one)")
+        ("output,o", po::value<std::string>()->default_value("."), "directory of the map and scen files");
+    po::variables_map vm;
+    try {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+    }
+    catch (const po::error &e) {
+        OMPL_ERROR("%s: %s", "kcbs-scengen", e.what());
+        return 1;
+    }
+    if (vm.count("help")) {
+        std::cout << desc << std::endl;
+        return 1;
+    }
+
+    ScenarioSpec spec;
+    spec.width_ = vm["width"].as<int>();
+    spec.height_ = vm["height"].as<int>();
+    spec.density_ = vm["density"].as<double>();
+    spec.agents_ = vm["agents"].as<unsigned int>();
+    spec.dynamics_ = vm["dynamics"].as<std::string>();
+    spec.shape_ = vm["shape"].as<std::string>();
+    spec.spacing_ = vm["spacing"].as<double>();
+    spec.seed_ = vm["seed"].as<std::uint32_t>();
+    fs::path map_file, scen_file;
+    if (!generate_scenario(spec, vm["output"].as<std::string>(), map_file, scen_file))
+        return 1;
+    std::cout << map_file.string() << "\n" << scen_file.string() << std::endl;
+    return 0;
+}
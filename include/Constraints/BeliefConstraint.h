@@ -1,16 +1,61 @@
 #pragma once
 #include "Constraints/Constraint.h"
+#include "utils/Conflict.h"
 #include <ompl/base/State.h>
+#include <Eigen/Core>
+#include <vector>
 
 namespace ob = ompl::base;
 
 
+/* Constraint on the belief of the constraining agent: at every constrained step, its x-y mean and covariance.
+   They are stored by value in one contiguous buffer of records, so a constraint owns no states. */
 class BeliefConstraint: public Constraint
 {
 public:
-	BeliefConstraint(int constrained_agent, int constraining_agent, std::vector<double> timeRange, std::vector<ob::State*> beliefStates);
-	~BeliefConstraint();
-	const std::vector<ob::State*> getStates() const;
+	/* x-y mean and covariance (sigma + lambda) of the constraining agent at a constrained step */
+	struct Record
+	{
+		int step_;
+		double x_, y_;
+		double s_xx_, s_xy_, s_yy_;
+
+		Eigen::Vector2d mean() const {return Eigen::Vector2d(x_, y_);};
+
+		Eigen::Matrix2d covariance() const
+		{
+			Eigen::Matrix2d Sigma;
+			Sigma << s_xx_, s_xy_, s_xy_, s_yy_;
+			return Sigma;
+		};
+
+		/* the record of a belief state at step */
+		static Record fromState(const ob::State *st, const int step);
+	};
+
+	/* records holds one record per time of timeRange */
+	BeliefConstraint(int constrained_agent, int constraining_agent, std::vector<double> timeRange, std::vector<Record> records,
+		const bool positive = false);
+
+	const std::vector<Record> &getRecords() const {return records_;};
+	const Record &getRecord(const std::size_t idx) const {return records_[idx];};
+
+	/* also covers the mean and covariance of the records */
+	std::size_t hash(const double resolution) const override;
 private:
-	std::vector<ob::State*> belief_states_;
+	std::vector<Record> records_;
+};
+
+/* A conflict of the belief validators, which carries the records of both of its agents at its step (read from the
+   beliefs that found it), so the constraints of the conflict do not extract them from the plan again */
+struct BeliefConflict: public Conflict
+{
+	BeliefConflict(const Conflict &c, const BeliefConstraint::Record &agent1, const BeliefConstraint::Record &agent2):
+		Conflict(c), agent1_(agent1), agent2_(agent2) {}
+
+	/* the record of agent, which is one of the agents of the conflict */
+	const BeliefConstraint::Record &getRecord(const int agent) const {return (agent == agent1Idx_) ? agent1_ : agent2_;};
+
+	const BeliefConstraint::Record agent1_;
+	const BeliefConstraint::Record agent2_;
 };
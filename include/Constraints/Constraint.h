@@ -1,25 +1,46 @@
 #pragma once
+#include "utils/AllocStats.h"
 #include <vector>
+#include <cmath>
 #include <boost/concept_check.hpp>
+#include <boost/functional/hash.hpp>
 #include <ompl/util/ClassForward.h>
 
 
 
 // abstract class for constraint
+/* A (negative) constraint keeps the constrained agent out of a region at every constrained step: where it would collide
+   with the constraining agent at the states of the constraint. A positive constraint keeps it inside that region */
 OMPL_CLASS_FORWARD(Constraint);
 class Constraint
 {
 public:
-	Constraint(int constrained_agent, int constraining_agent, std::vector<double> timeRange):
-		times_(timeRange), constrained_agent_(constrained_agent), constraining_agent_(constraining_agent) {}
-	~Constraint()
+	Constraint(int constrained_agent, int constraining_agent, std::vector<double> timeRange, const bool positive = false):
+		times_(timeRange), constrained_agent_(constrained_agent), constraining_agent_(constraining_agent), positive_(positive) {}
+	virtual ~Constraint()
 	{
+		if (bytes_ > 0)
+			alloc::onFree(alloc::CONSTRAINTS, bytes_);
 		times_.clear();
 	}
 
-	const std::vector<double> getTimes() const {return times_;};
+	const std::vector<double>& getTimes() const {return times_;};
 	const int getConstrainedAgent() const {return constrained_agent_;};
 	const int getConstrainingAgent() const {return constraining_agent_;};
+	bool isPositive() const {return positive_;};
+
+	/** \brief Hash of the constraint, with every value rounded to a multiple of resolution (> 0).
+	    Constraints that are equal up to this resolution have the same hash. */
+	virtual std::size_t hash(const double resolution) const
+	{
+		std::size_t seed = 0;
+		boost::hash_combine(seed, constrained_agent_);
+		boost::hash_combine(seed, constraining_agent_);
+		boost::hash_combine(seed, positive_);
+		for (const double t: times_)
+			boost::hash_combine(seed, quantize_(t, resolution));
+		return seed;
+	}
 
 	/** \brief Cast this instance to a desired type. */
     template <class T>
@@ -39,7 +60,21 @@ public:
         return static_cast<const T *>(this);
     }
 protected:
+	static long long quantize_(const double v, const double resolution) {return std::llround(v / resolution);};
+
+	/* count the constraint (of bytes with its records) for alloc::CONSTRAINTS, once it is made */
+	void account_(const std::size_t bytes)
+	{
+		if (alloc::isEnabled()) {
+			bytes_ = bytes + times_.capacity() * sizeof(double);
+			alloc::onAlloc(alloc::CONSTRAINTS, bytes_);
+		}
+	}
+
 	std::vector<double> times_;
 	const int constrained_agent_;
 	const int constraining_agent_;
+	const bool positive_;
+private:
+	std::size_t bytes_{0};  // counted by account_, 0 if accounting was off
 };
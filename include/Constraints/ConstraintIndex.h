@@ -0,0 +1,78 @@
+#pragma once
+#include "Constraints/Constraint.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+/* Constraints on one agent, indexed by the propagation step they apply to, and by the window of steps (with the
+   spatial bounds) of every constraint. Built once per set of constraints. The positive constraints are left out of the
+   steps: each has an index of its own (as if it were negative, see PlanValidityChecker::checkConstraints), and a window
+   that is anywhere, so that they are always near */
+struct ConstraintIndex
+{
+	struct Entry
+	{
+		const Constraint *constraint_;
+		std::size_t time_idx_;  // index of the step within the times (and states) of the constraint
+		const void *geometry_;  // of the (constrained, constraining) pair, see PlanValidityChecker::pairGeometry_
+	};
+
+	/* the steps [first, last] a constraint applies to, and the box it lies in. A validator inflates the box by margin_
+	   (and that of the constrained agent), beyond which the constraint is always satisfied. A NaN box or an infinite
+	   margin is anywhere */
+	struct Window
+	{
+		const Constraint *constraint_;
+		unsigned int first_step_, last_step_;
+		double min_x_, max_x_, min_y_, max_y_;
+		double margin_;
+	};
+
+	/* constraints that apply at step, or nullptr */
+	const std::vector<Entry> *at(const unsigned int step) const
+	{
+		return (step < steps_.size() && !steps_[step].empty()) ? &steps_[step] : nullptr;
+	}
+
+	/* true if a constraint applies to any step in [first, last] */
+	bool overlaps(const unsigned int first, const unsigned int last) const
+	{
+		if (constraints_.empty() || first > last_step_ || last < first_step_)
+			return false;
+		const std::size_t end = windowsUpTo_(last);
+		return end > 0 && max_last_[end - 1] >= first;
+	}
+
+	/* calls f(window) for every window that overlaps [first, last], latest first, until f returns false. False if it did */
+	template <typename F>
+	bool forEachWindow(const unsigned int first, const unsigned int last, F &&f) const
+	{
+		// a window below k can only overlap if the latest last step of the windows up to k does
+		for (std::size_t k = windowsUpTo_(last); k-- > 0 && max_last_[k] >= first;) {
+			if (windows_[k].last_step_ >= first && !f(windows_[k]))
+				return false;
+		}
+		return true;
+	}
+
+	bool empty() const {return constraints_.empty();};
+
+	int constrained_agent_{-1};
+	unsigned int first_step_{0};
+	unsigned int last_step_{0};
+	std::vector<std::vector<Entry>> steps_;
+	std::vector<Window> windows_;          // sorted by first step
+	std::vector<unsigned int> max_last_;  // max_last_[k]: latest last step of windows_[0..k]
+	std::vector<ConstraintPtr> constraints_;  // keeps the indexed constraints alive
+	std::vector<std::shared_ptr<const ConstraintIndex>> positives_;  // one per positive constraint
+
+private:
+	/* number of windows that start at or before step */
+	std::size_t windowsUpTo_(const unsigned int step) const
+	{
+		return std::upper_bound(windows_.begin(), windows_.end(), step,
+			[](const unsigned int s, const Window &w) {return s < w.first_step_;}) - windows_.begin();
+	}
+};
+
+typedef std::shared_ptr<const ConstraintIndex> ConstraintIndexPtr;
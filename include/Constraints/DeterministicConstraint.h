@@ -1,14 +1,20 @@
 #pragma once
 #include "utils/common.h"
+#include "utils/RobotFootprint.h"
 #include "Constraints/Constraint.h"
 
 
+/* Constraint on the shape of the constraining agent: at every constrained step, the footprint it occupies */
 class DeterministicConstraint: public Constraint
 {
 public:
-	DeterministicConstraint(int constrained_agent, int constraining_agent, std::vector<double> timeRange, std::vector <Polygon> shapes);
+	DeterministicConstraint(int constrained_agent, int constraining_agent, std::vector<double> timeRange, std::vector<RobotFootprint> shapes,
+		const bool positive = false);
 	~DeterministicConstraint();
-	const std::vector<Polygon> getShapes() const {return shapes_;};
+	const std::vector<RobotFootprint> &getShapes() const {return shapes_;};
+	const RobotFootprint &getShape(const std::size_t idx) const {return shapes_[idx];};
+	/* also covers the corners of the shapes */
+	std::size_t hash(const double resolution) const override;
 private:
-	std::vector<Polygon> shapes_;
+	std::vector<RobotFootprint> shapes_;
 };
@@ -30,6 +30,8 @@ private:
 	Eigen::VectorXd goal_;
 	const double p_safe_;
 	const double threshold_;
+	/* chi-squared quantile of p_safe_ */
+	const double sc_;
 };
 
 class CentralizedCCGoal : public ob::Goal
@@ -44,7 +46,8 @@ public:
     bool isSingleAgentSatisfied(const ob::State *st, const int idx) const;
 
 private:
-    bool isSafe_(const Eigen::Vector2d mu, const Eigen::Matrix2d sigma, const Eigen::Vector2d goal, std::pair<Eigen::MatrixXd, Eigen::MatrixXd> hp, double *distance) const;
+    bool isSafe_(const Eigen::Vector2d &mu, const Eigen::Matrix2d &sigma, const Eigen::Vector2d &goal,
+        const std::pair<Eigen::MatrixXd, Eigen::MatrixXd> &hp, double *distance) const;
     // std::pair<Eigen::Vector2d, Eigen::Matrix2d> getDistFromState_(const ob::State* st) const;
     std::pair<Eigen::MatrixXd, Eigen::MatrixXd> createHalfPlanes_(Polygon combined_poly);
 
@@ -52,10 +55,13 @@ private:
 
     // Eigen::MatrixXd A_;
     // Eigen::MatrixXd B_;
-    std::unordered_map<int, std::pair<Eigen::MatrixXd, Eigen::MatrixXd>> half_plane_map_;
+    /* goal half-planes of every agent */
+    std::vector<std::pair<Eigen::MatrixXd, Eigen::MatrixXd>> half_planes_;
     Eigen::VectorXd goal_;
     const int num_agents_;
     const double p_safe_;
     const double threshold_;
+    /* erf_inv(1 - 2 p_safe_) of the goal half-planes */
+    const double erf_inv_;
 };
 
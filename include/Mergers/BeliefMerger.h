@@ -8,5 +8,8 @@ class BeliefMerger: public Merger
 public: 
 	BeliefMerger(const MultiRobotProblemDefinitionPtr mrmp_pdef);
 
-	void mergeRobots(const int idx1, const int idx2);
-};
\ No newline at end of file
+	/* compose n 2D-Uncertain-Linear robots into a 2n-D belief space, solved with CentralizedBSST */
+	MotionPlanningProblemPtr mergeRobots(const std::vector<int> &idxs) override;
+
+	std::vector<oc::PathControl> splitPath(const oc::PathControl &composed, const std::vector<int> &idxs) override;
+};
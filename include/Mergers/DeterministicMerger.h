@@ -8,5 +8,7 @@ class DeterministicMerger: public Merger
 public: 
 	DeterministicMerger(const MultiRobotProblemDefinitionPtr mrmp_pdef);
 
-	void mergeRobots(const int idx1, const int idx2);
+	MotionPlanningProblemPtr mergeRobots(const std::vector<int> &idxs) override;
+
+	std::vector<oc::PathControl> splitPath(const oc::PathControl &composed, const std::vector<int> &idxs) override;
 };
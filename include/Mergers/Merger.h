@@ -1,16 +1,29 @@
 #pragma once
 #include <ompl/util/Console.h>
 #include <ompl/util/ClassForward.h>
+#include <ompl/control/PathControl.h>
+#include <vector>
 
 
+namespace oc = ompl::control;
+
 OMPL_CLASS_FORWARD(MultiRobotProblemDefinition);
+OMPL_CLASS_FORWARD(MotionPlanningProblem);
 OMPL_CLASS_FORWARD(Merger);
 class Merger
 {
 public:
 	Merger(MultiRobotProblemDefinitionPtr mrmp_pdef, std::string name = "Merger"):
 		mrmp_pdef_(mrmp_pdef), name_(name){}
-	virtual void mergeRobots(const int idx1, const int idx2) = 0;
+
+	virtual ~Merger() = default;
+
+	/* create the composed (meta-agent) problem of robots idxs (e.g. the robots of a meta-agent and one more), or return
+	   nullptr if they cannot be merged */
+	virtual MotionPlanningProblemPtr mergeRobots(const std::vector<int> &idxs) = 0;
+
+	/* split a solution of the composed problem into the trajectories of idxs (in that order) */
+	virtual std::vector<oc::PathControl> splitPath(const oc::PathControl &composed, const std::vector<int> &idxs) = 0;
 protected:
 	const MultiRobotProblemDefinitionPtr mrmp_pdef_;
 	const std::string name_;
@@ -2,6 +2,10 @@
 #include "Spaces/RealVectorBeliefSpace.h"
 #include "Constraints/BeliefConstraint.h"
 #include "PlanValidityCheckers/PlanValidityChecker.h"
+#include "utils/BeliefTrajectories.h"
+#include "utils/PairBatch.h"
+#include "utils/SweepAndPrune.h"
+#include <atomic>
 
 typedef std::pair<Eigen::VectorXd, Eigen::MatrixXd> Belief;
 
@@ -11,11 +15,127 @@ class BeliefPVC: public PlanValidityChecker
 public:
     BeliefPVC(MultiRobotProblemDefinitionPtr pdef, const std::string name, const double p_safe_agnts);
 
-    ConstraintPtr createConstraint(Plan p, std::vector<ConflictPtr> conflicts, const int robotIdx) override;
+    /* first conflict interval of p (conflicts are propagated forward on the pair of the first one) */
+    std::vector<ConflictPtr> validatePlan(const DiscretePlan &p) override;
+
+    ConstraintPtr createConstraint(const DiscretePlan &p, const std::vector<ConflictPtr> &conflicts, const int robotIdx) override;
+
+    ConstraintPtr createRegionConstraint(const DiscretePlan &p, const std::vector<ConflictPtr> &conflicts, const int robotIdx,
+        const bool positive) override;
+
+    using PlanValidityChecker::nearConstraints;
+
+    /* also false if the means of the states and of every constraint that overlaps their steps are further apart
+       (along x or y) than the safe half-widths of the two agents */
+    bool nearConstraints(const std::vector<ob::State*> &states, const unsigned int first_step, const unsigned int last_step,
+        const ConstraintIndex &index) const override;
+
+    /* Also validate the motion between consecutive steps, along which the means of the linear-Gaussian models move in a
+       line. The motion of a pair is safe where the segment of the difference of their means stays out of the box of
+       their safe half-widths, for the larger covariance of the two steps (a swept bound). Elsewhere, near a close
+       approach, the interval is halved down to pieces of 1/substeps of a step, whose midpoints get the exact pair test
+       with covariances lambda_max I. A conflict on the way from step k is reported at k, and its interval goes on to
+       k + 1. Only the validators with a pair test (see pairwise_) support it. 0 (the default) validates the steps only */
+    void setContinuous(const unsigned int substeps);
+
+    unsigned int getContinuous() const {return continuous_substeps_;};
+
+    /* Check the pairs the broadphase keeps at every step of the conflict window in one batch (see checkBatch_), rather
+       than step by step, for the validators whose pair test only reads the relative belief of the pair (see
+       batchable_). The batch does not stop at the first conflict, so it pays off where the test of a pair dwarfs the
+       gathering (many samples or grid cells) or on a device backend. Off by default, and not with continuous validation */
+    void setBatchValidation(const bool batch) {batch_validation_ = batch;};
+
+    bool getBatchValidation() const {return batch_validation_;};
 
 protected:
-    std::map<std::string, Belief> getActiveRobots_(Plan p, const int step, const int a1 = -1, const int a2 = -1);
+    /* a constraint on constrained_robot (from the other robot of conflicts) at the beliefs of region_robot in p */
+    ConstraintPtr createConstraint_(const DiscretePlan &p, const std::vector<ConflictPtr> &conflicts, const int constrained_robot,
+        const int region_robot, const bool positive);
+
+    /* chains the pair tests of other validators */
+    friend class CascadePVC;
+
+    /* steps [first_, last_] in which the agents a_ < b_ may conflict */
+    struct PairSpan
+    {
+        int a_, b_, first_, last_;
+    };
+
+    /* fewest steps given to a thread by the parallel validatePlan */
+    static constexpr int min_chunk_steps_ = 16;
+    /* records of a batch per task of checkBatch_ */
+    static constexpr std::size_t batch_chunk_ = 256;
+
+    /* the box of the means of a belief constraint, inflated by the safe half-width of the constraining agent */
+    void boundConstraint_(const Constraint &c, ConstraintIndex::Window &w) const override;
+        std::vector<ConflictPtr> validatePair_(const DiscretePlan &p, const int a1, const int a2, const int max_states) override;
+    std::vector<std::vector<ConflictPtr>> validatePairAll_(const DiscretePlan &p, const int a1, const int a2, const int max_states) override;
+    /* the first (or every, if all) conflict interval of a1 and a2 */
+    std::vector<std::vector<ConflictPtr>> pairIntervals_(const DiscretePlan &p, const int a1, const int a2, const int max_states,
+        const bool all);
+    /* first conflict in the steps [first_step, last_step) of agents, only testing the pairs of spans (sorted by first step)
+       if given. Gives up once earliest (if given) is below the current step */
+    ConflictPtr firstConflict_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const std::vector<PairSpan> *spans,
+        const int first_step, const int last_step, const std::atomic<int> *earliest);
+    /* first conflict in the steps [0, max_states), from chunks of steps checked by num_threads_ threads */
+    ConflictPtr firstConflictParallel_(const BeliefTrajectories &beliefs, const std::vector<int> &agents,
+        const std::vector<PairSpan> *spans, const int max_states);
+    /* first conflicting pair of agents (indices into beliefs) at step, or nullptr. broadphase is kept from one step to
+       the next of a plan */
+    virtual ConflictPtr checkForConflicts_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int step,
+        SweepAndPrune &broadphase) = 0;
+    /* the pairs (i, j) of positions into agents whose boxes, the means at step +- half_widths, overlap. The pairs of
+       disjoint boxes can be skipped if a pair whose means are further apart (along x or y) than the sum of their
+       half-widths is always safe */
+    const std::vector<std::pair<int, int>> &overlappingPairs_(SweepAndPrune &broadphase, const BeliefTrajectories &beliefs,
+        const std::vector<int> &agents, const int step, const std::vector<double> &half_widths) const;
+    /* half-width of a box around the mean of agent such that a pair whose means are further apart (along x or y) than
+       the sum of their half-widths is safe, for any step whose covariance has no eigenvalue above max_lambda. Infinite
+       (the default) if the margin also depends on the other agents, which disables the hierarchies of validatePlan */
+    virtual double safeHalfWidth_(const int agent, const double max_lambda, const double max_sqrt_lambda) const;
+    /* the spans of steps below max_states in which the hierarchies of the trajectories of a and b do not prune the pair */
+    std::vector<std::pair<int, int>> nearSpans_(const DiscretePlan &p, const int a, const int b, const int max_states) const;
+    /* k such that a pair is safe from the half-plane x <= b (normalized) of its Minkowski sum if x - b >= k * sqrt(Sigma_xx),
+       i.e. sqrt(2) * erf_inv(1 - 2 p_coll). Infinite if p_coll <= 0 (no pair is ever safe) */
+    static double chanceScale_(const double p_coll);
+    /* whether agents a and b, with these x-y beliefs, are safe, for the validators whose test of a pair does not depend
+       on the other agents (see pairwise_). Never (the default) otherwise */
+    virtual bool isPairSafe_(const int a, const Eigen::Vector2d &mu_a, const Eigen::Matrix2d &Sigma_a, const int b,
+        const Eigen::Vector2d &mu_b, const Eigen::Matrix2d &Sigma_b);
+    /* true if isPairSafe_ is the exact test of the validator */
+    virtual bool pairwise_() const {return false;};
+    /* true if the exact test of a pair (a, b) only reads its relative belief N(mu_a - mu_b, Sigma_a + Sigma_b), through
+       isRelativeSafe_, and checkForConflicts_ tests the pairs of overlappingPairs_ with the safe half-widths */
+    virtual bool batchable_() const {return false;};
+    /* the exact test of a pair from its relative belief, if batchable_. It may be called concurrently */
+    virtual bool isRelativeSafe_(const int a, const int b, const Eigen::Vector2d &mu_ab, const Eigen::Matrix2d &Sigma_ab) const
+    {
+        return false;
+    };
+    /* the safe_ of every record of batch, from isRelativeSafe_ in chunks on the task runtime (with num_threads_ > 1).
+       A device backend of a validator would override it to check the batch in one launch */
+    virtual void checkBatch_(PairBatch &batch) const;
+    /* first conflict in the steps [0, max_states), from one batch of the pairs of every step */
+    ConflictPtr firstConflictBatch_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int max_states);
+    /* whether the motion of agents a and b from step to step + 1 is safe (see setContinuous). Always, if not continuous */
+    bool sweptPairSafe_(const BeliefTrajectories &beliefs, const int a, const int b, const int step);
+    /* the first pair of agents whose motion from step to step + 1 is not safe, as a conflict at step. broadphase is kept
+       from one step to the next, as for checkForConflicts_ */
+    ConflictPtr sweptConflict_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int step,
+        SweepAndPrune &broadphase);
+    /* the conflict of pair at step that goes on an interval up to step - 1: at step itself, or on the way to it. Once
+       both agents are parked it goes on without a check */
+    ConflictPtr extendConflict_(const BeliefTrajectories &beliefs, const std::vector<int> &pair, const int step,
+        SweepAndPrune &broadphase);
+    /* c as a BeliefConflict, with the records of its agents at its step read from beliefs */
+    static ConflictPtr withBeliefs_(const ConflictPtr &c, const BeliefTrajectories &beliefs);
     Belief getDistribution_(const ob::State* st);
+    /* bounding radius of every robot (by id) */
+    std::vector<double> bounding_radii_;
     const double p_safe_agnts_;
     double p_coll_agnts_;
+    /* pieces of a step of the continuous validation, 0 if off */
+    unsigned int continuous_substeps_{0};
+    bool batch_validation_{false};
 };
@@ -1,8 +1,10 @@
 #pragma once
 #include "PlanValidityCheckers/BeliefPVC.h"
+#include "utils/BlackmoreHalfPlanes.h"
+#include "utils/PairTable.h"
 #include <boost/math/distributions/chi_squared.hpp>
 #include <Eigen/Eigenvalues> 
-#include <unordered_map>
+#include <cmath>
 
 namespace bm = boost::math;
 
@@ -12,25 +14,47 @@ class CDFGridPVC: public BeliefPVC
 public:
     CDFGridPVC(MultiRobotProblemDefinitionPtr pdef, const double p_safe, int nSteps);
 
-    std::vector<ConflictPtr> validatePlan(Plan p) override;
+    using PlanValidityChecker::satisfiesConstraints;
 
-    bool satisfiesConstraints(oc::PathControl path, std::vector<ConstraintPtr> constraints) override;
+    bool satisfiesConstraints(const std::vector<ob::State*> &states, const unsigned int first_step, 
+        const ConstraintIndex &index) override;
 
     bool independentCheck(ob::State* state1, ob::State* state2);
 
 private:
+    const void *pairGeometry_(const int a, const int b) const override {return &pair_boxes_(a, b);};
+
+    /* bounding box of a pair of robots: its half-planes and its (counter-clockwise) vertices */
+    struct PairBox
+    {
+        QuadHalfPlanes half_planes_;
+        Eigen::Matrix<double, 2, 4> vertices_{Eigen::Matrix<double, 2, 4>::Zero()};
+    };
+
     double chi_squared_quantile_(double v, double p)
     {
         return quantile(bm::chi_squared(v), p);
     }
-    ConflictPtr checkForConflicts_(std::map<std::string, Belief> states_map, const int step);
-    bool isSafe_(const Belief belief_a, const Belief belief_b, std::pair<Eigen::MatrixXd, Eigen::MatrixXd> HP, Polygon V);
+    ConflictPtr checkForConflicts_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int step,
+        SweepAndPrune &broadphase) override;
+    double safeHalfWidth_(const int agent, const double max_lambda, const double max_sqrt_lambda) const override;
+    bool isPairSafe_(const int a, const Eigen::Vector2d &mu_a, const Eigen::Matrix2d &Sigma_a, const int b,
+        const Eigen::Vector2d &mu_b, const Eigen::Matrix2d &Sigma_b) override;
+    bool pairwise_() const override {return true;};
+    bool batchable_() const override {return true;};
+    bool isRelativeSafe_(const int a, const int b, const Eigen::Vector2d &mu_ab, const Eigen::Matrix2d &Sigma_ab) const override
+    {
+        return isSafe_(mu_ab, Sigma_ab, pair_boxes_(a, b));
+    };
+    bool isSafe_(const Eigen::Vector2d &mu_ab, const Eigen::Matrix2d &sigma_ab, const PairBox &box) const;
     Polygon getBoundingBox_(const double r_1, const double r_2);
     std::pair<Eigen::MatrixXd, Eigen::MatrixXd> getHalfPlanes_(Polygon combined_poly);
-    std::vector<double> linspace_(double start_in, double end_in, int num_in);
-    double cdfRect_(std::vector<Point> B);
-    std::unordered_map<std::string, std::pair<Eigen::MatrixXd, Eigen::MatrixXd>> halfPlane_map_;
-    std::unordered_map<std::string, Polygon> polygon_map_;
+    /* standard normal CDF */
+    static double normalCdf_(const double t) {return 0.5 * std::erfc(-t / std::sqrt(2.0));};
+    /* bounding box of every pair of robots (by id) */
+    PairTable<PairBox> pair_boxes_;
     double sc_;
+    /* sqrt(2) erf_inv of the risk of a pair, the scale of the broadphase boxes */
+    double chance_scale_;
     const int disk_steps_;
 };
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#include "PlanValidityCheckers/BeliefPVC.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+OMPL_CLASS_FORWARD(CascadePVC);
+/* Chain of belief validators, from the cheapest to the tightest. A pair is checked by the first tier, and only
+   escalated to the next one while the current one finds it unsafe, so the last tier decides the ambiguous pairs
+   and the safe answers of the earlier (conservative) tiers are trusted. The broadphase of the first tier prunes the
+   pairs before any of them */
+class CascadePVC: public BeliefPVC
+{
+public:
+    /* every tier must have a pair test (see BeliefPVC::pairwise_) */
+    CascadePVC(MultiRobotProblemDefinitionPtr pdef, const double p_safe, std::vector<BeliefPVCPtr> tiers);
+
+    /* the cascade of the validators named by spec, e.g. "BoundingBox,CDFGrid-30", or nullptr if one of them is
+       unknown or has no pair test */
+    static CascadePVCPtr create(MultiRobotProblemDefinitionPtr pdef, const double p_safe, const std::string &spec);
+
+    using PlanValidityChecker::satisfiesConstraints;
+
+    bool satisfiesConstraints(const std::vector<ob::State*> &states, const unsigned int first_step,
+        const ConstraintIndex &index) override;
+
+    /* number of pair checks that every tier resolved (since the last reset) */
+    std::vector<std::size_t> getResolvedChecks() const;
+
+    void resetStats();
+
+    void printStats() const;
+
+private:
+    ConflictPtr checkForConflicts_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int step,
+        SweepAndPrune &broadphase) override;
+    double safeHalfWidth_(const int agent, const double max_lambda, const double max_sqrt_lambda) const override;
+    bool isPairSafe_(const int a, const Eigen::Vector2d &mu_a, const Eigen::Matrix2d &Sigma_a, const int b,
+        const Eigen::Vector2d &mu_b, const Eigen::Matrix2d &Sigma_b) override;
+    bool pairwise_() const override {return true;};
+    std::vector<BeliefPVCPtr> tiers_;
+    /* checks resolved by every tier (counted by the threads of validatePlan) */
+    std::unique_ptr<std::atomic<std::size_t>[]> resolved_;
+};
@@ -1,8 +1,7 @@
 #pragma once
 #include "PlanValidityCheckers/BeliefPVC.h"
+#include "utils/DiskGeometry.h"
 #include <boost/math/distributions/chi_squared.hpp>
-#include <Eigen/Eigenvalues> 
-#include <unordered_map>
 
 namespace bm = boost::math;
 
@@ -12,9 +11,10 @@ class ChiSquaredBoundaryPVC: public BeliefPVC
 public:
     ChiSquaredBoundaryPVC(MultiRobotProblemDefinitionPtr pdef, const double p_safe);
 
-    std::vector<ConflictPtr> validatePlan(Plan p) override;
+    using PlanValidityChecker::satisfiesConstraints;
 
-    bool satisfiesConstraints(oc::PathControl path, std::vector<ConstraintPtr> constraints) override;
+    bool satisfiesConstraints(const std::vector<ob::State*> &states, const unsigned int first_step, 
+        const ConstraintIndex &index) override;
 
     bool independentCheck(ob::State* state1, ob::State* state2);
 
@@ -23,8 +23,13 @@ private:
     {
         return quantile(bm::chi_squared(v), p);
     }
-    ConflictPtr checkForConflicts_(std::map<std::string, Belief> states_map, const int step);
-    bool isSafe_(const Belief belief_a, const double rad_a, const Belief belief_b, const double rad_b);
-    std::unordered_map<std::string, double> boundingRadii_map;
+    ConflictPtr checkForConflicts_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int step,
+        SweepAndPrune &broadphase) override;
+    double safeHalfWidth_(const int agent, const double max_lambda, const double max_sqrt_lambda) const override;
+    bool isPairSafe_(const int a, const Eigen::Vector2d &mu_a, const Eigen::Matrix2d &Sigma_a, const int b,
+        const Eigen::Vector2d &mu_b, const Eigen::Matrix2d &Sigma_b) override;
+    bool pairwise_() const override {return true;};
+    bool isSafe_(const Eigen::Vector2d &mu_a, const Eigen::Matrix2d &Sigma_a, const double rad_a, 
+        const Eigen::Vector2d &mu_b, const Eigen::Matrix2d &Sigma_b, const double rad_b) const;
     double sc_;
 };
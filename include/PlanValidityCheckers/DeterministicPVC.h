@@ -1,10 +1,9 @@
 #pragma once
 #include "PlanValidityCheckers/PlanValidityChecker.h"
 #include "Constraints/DeterministicConstraint.h"
+#include "utils/SweepAndPrune.h"
 #include <ompl/base/spaces/SO2StateSpace.h>
 #include <ompl/base/spaces/RealVectorStateSpace.h>
-#include <boost/geometry/algorithms/correct.hpp>
-#include <boost/geometry/strategies/transform/matrix_transformers.hpp>
 
 
 OMPL_CLASS_FORWARD(DeterministicPlanValidityChecker);
@@ -13,18 +12,50 @@ class DeterministicPlanValidityChecker: public PlanValidityChecker
 public:
 	DeterministicPlanValidityChecker(MultiRobotProblemDefinitionPtr pdef);
 
-	std::vector<ConflictPtr> validatePlan(Plan p) override;
+	std::vector<ConflictPtr> validatePlan(const DiscretePlan &p) override;
 
-	ConstraintPtr createConstraint(Plan p, std::vector<ConflictPtr> conflicts, const int robotIdx) override;
+	ConstraintPtr createConstraint(const DiscretePlan &p, const std::vector<ConflictPtr> &conflicts, const int robotIdx) override;
+
+	ConstraintPtr createRegionConstraint(const DiscretePlan &p, const std::vector<ConflictPtr> &conflicts, const int robotIdx,
+		const bool positive) override;
+
+	using PlanValidityChecker::satisfiesConstraints;
+
+	/* the shape of the constrained robot at every state may not intersect the shape of the constraint at its step */
+	bool satisfiesConstraints(const std::vector<ob::State*> &states, const unsigned int first_step, 
+		const ConstraintIndex &index) override;
+
+	/* also false if the bounding circles of the states are apart from the shapes of every constraint whose window
+	   overlaps their steps */
+	using PlanValidityChecker::nearConstraints;
+
+	bool nearConstraints(const std::vector<ob::State*> &states, const unsigned int first_step, const unsigned int last_step,
+		const ConstraintIndex &index) const override;
+
+
+protected:
+	/* the envelope of the shapes of a deterministic constraint */
+	void boundConstraint_(const Constraint &c, ConstraintIndex::Window &w) const override;
+	std::vector<ConflictPtr> validatePair_(const DiscretePlan &p, const int a1, const int a2, const int max_states) override;
+	std::vector<std::vector<ConflictPtr>> validatePairAll_(const DiscretePlan &p, const int a1, const int a2, const int max_states) override;
 
-	bool satisfiesConstraints(oc::PathControl path, std::vector<ConstraintPtr> constraints) override
-	{
-		OMPL_ERROR("Not yet implemented.");
-		return false;
-	}
-	
 private:
-	std::vector<std::pair<int, Polygon>> getActiveRobots_(Plan p, const int step, const int a1 = -1, const int a2 = -2);
-	Polygon getShapeFromState_(ob::State *st, const int robotIdx);
-	ConflictPtr checkForConflicts_(std::vector<std::pair<int, Polygon>> shapes, const int step);
+	/* a constraint on robotIdx (from the other robot of conflicts) at the states of region_robot in p */
+	ConstraintPtr createConstraint_(const DiscretePlan &p, const std::vector<ConflictPtr> &conflicts, const int robotIdx,
+		const int region_robot, const bool positive);
+	/* the shapes of the robots at step (those of a1 and a2 only, if given), into shapes */
+	void getActiveRobots_(const DiscretePlan &p, const int step, std::vector<std::pair<int, RobotFootprint>> &shapes,
+		const int a1 = -1, const int a2 = -2) const;
+	RobotFootprint getShapeFromState_(const ob::State *st, const int robotIdx) const;
+	/* the last step of the trajectory of robotIdx, at which it stays (parked) from then on */
+	static int lastStep_(const DiscretePlan &p, const int robotIdx) {return static_cast<int>(p[robotIdx].getStateCount()) - 1;};
+	/* the first (or every, if all) conflict interval of a1 and a2 */
+	std::vector<std::vector<ConflictPtr>> pairIntervals_(const DiscretePlan &p, const int a1, const int a2, const int max_states,
+		const bool all);
+	/* first pair of shapes that intersect. Only the pairs whose envelopes overlap are tested, broadphase keeps their
+	   order from one step to the next */
+	ConflictPtr checkForConflicts_(const std::vector<std::pair<int, RobotFootprint>> &shapes, const int step, SweepAndPrune &broadphase);
+
+	/* the shape of every robot (by id) at its start location */
+	std::vector<RobotFootprint> footprints_;
 };
@@ -1,8 +1,10 @@
 #pragma once
 #include "PlanValidityCheckers/BeliefPVC.h"
+#include "utils/BlackmoreHalfPlanes.h"
+#include "utils/PairSafety.h"
+#include "utils/PairTable.h"
 #include <boost/math/special_functions/erf.hpp>
 #include <boost/geometry/strategies/transform/matrix_transformers.hpp>
-#include <unordered_map>
 
 namespace bm = boost::math;
 
@@ -12,20 +14,54 @@ class MinkowskiSumBlackmorePVC: public BeliefPVC
 public:
     MinkowskiSumBlackmorePVC(MultiRobotProblemDefinitionPtr pdef, const double p_safe);
 
-    std::vector<ConflictPtr> validatePlan(Plan p) override;
+    using PlanValidityChecker::satisfiesConstraints;
 
-    bool satisfiesConstraints(oc::PathControl path, std::vector<ConstraintPtr> constraints) override;
+    bool satisfiesConstraints(const std::vector<ob::State*> &states, const unsigned int first_step, 
+        const ConstraintIndex &index) override;
 
     bool independentCheck(ob::State* state1, ob::State* state2);
-    
+
 private:
-    ConflictPtr checkForConflicts_(std::map<std::string, Belief> states_map, const int step);
-    bool isSafe_(const Eigen::Vector2d mu_ab, const Eigen::Matrix2d Sigma_ab, const std::pair<Eigen::MatrixXd, Eigen::MatrixXd> halfPlanes);
+    const void *pairGeometry_(const int a, const int b) const override {return &pair_geometry_(a, b);};
+
+    ConflictPtr checkForConflicts_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int step,
+        SweepAndPrune &broadphase) override;
+    double safeHalfWidth_(const int agent, const double max_lambda, const double max_sqrt_lambda) const override;
+    bool isPairSafe_(const int a, const Eigen::Vector2d &mu_a, const Eigen::Matrix2d &Sigma_a, const int b,
+        const Eigen::Vector2d &mu_b, const Eigen::Matrix2d &Sigma_b) override;
+    bool pairwise_() const override {return true;};
+    bool isSafe_(const Eigen::Vector2d &mu_ab, const Eigen::Matrix2d &Sigma_ab, const QuadHalfPlanes &halfPlanes);
+    /* checkForConflicts_ and satisfiesConstraints on pairs of class Shape (see PairSafety.h) */
+    template <PairShape Shape, bool Positive>
+    ConflictPtr conflictKernel_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int step,
+        SweepAndPrune &broadphase);
+    template <PairShape Shape, bool Positive>
+    bool constraintKernel_(const std::vector<ob::State*> &states, const unsigned int first_step, const ConstraintIndex &index);
+    /* the kernels of the most general class of pair, picked once at setup */
+    void selectKernels_();
+    template <PairShape Shape, bool Positive>
+    void selectKernels_();
+    const QuadHalfPlanes &pairHalfPlanes_(const int a, const int b) const;
     Polygon getMinkowskiSumOfRobots_(Robot* r1, Robot* r2);
     std::pair<Eigen::MatrixXd, Eigen::MatrixXd> getHalfPlanes_(Polygon combined_poly);
     Point addPoints_(const Point &a, const Point &b);
     Point subtractPoints_(const Point &a, const Point &b);
     double crossProduct_(const Point &a, const Point &b);
-    std::unordered_map<std::string, std::pair<Eigen::MatrixXd, Eigen::MatrixXd>> halfPlane_map_;
+    /* half-planes of every pair of robots (by id) */
+    PairTable<QuadHalfPlanes> pair_half_planes_;
+    /* the Minkowski sums of every pair of robots (by id) as read by the kernels, and the most general of their classes */
+    PairTable<PairGeometry> pair_geometry_;
+    PairShape pair_shape_{PairShape::Point};
+    ConflictPtr (MinkowskiSumBlackmorePVC::*conflict_kernel_)(const BeliefTrajectories &, const std::vector<int> &,
+        const int, SweepAndPrune &){nullptr};
+    bool (MinkowskiSumBlackmorePVC::*constraint_kernel_)(const std::vector<ob::State*> &, const unsigned int,
+        const ConstraintIndex &){nullptr};
+    bool (*pair_kernel_)(const PairGeometry &, const double, const double, const double, const double, const double,
+        const double){nullptr};
     double p_coll_dist_;
+    /* sqrt(2) erf_inv of the risk of a pair, the scale of the broadphase boxes */
+    double chance_scale_{0};
+    /* erf_inv of the risk of a pair, and 2 erf_inv^2 */
+    double erf_inv_dist_{0};
+    double kernel_scale_{0};
 };
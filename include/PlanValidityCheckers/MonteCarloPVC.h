@@ -0,0 +1,61 @@
+#pragma once
+#include "PlanValidityCheckers/BeliefPVC.h"
+#include "utils/PairTable.h"
+#include "utils/SimdRandom.h"
+#include <cstdint>
+
+
+/* Estimates the collision probability of a pair by sampling the difference of the robots, N(mu_ab, Sigma_ab), and
+   counting the samples inside the bounding box of the pair (the box of CDFGridPVC). The samples are drawn in blocks
+   of SimdRandom lanes, and a sequential probability ratio test against p_coll (1 - p_safe) stops as soon as the
+   pair is clearly below p_coll (1 - indifference) or above p_coll (1 + indifference), with errors below error. A
+   pair still undecided after max_samples samples (rounded up to a multiple of test_every_) is safe if its estimate
+   is below p_coll, so max_samples trades the time of the checks for their accuracy. Every check draws the same
+   stream (see setSeed), so the checks are deterministic. */
+class MonteCarloPVC: public BeliefPVC
+{
+public:
+    MonteCarloPVC(MultiRobotProblemDefinitionPtr pdef, const double p_safe, const int max_samples,
+        const double indifference = 0.5, const double error = 0.01);
+
+    using PlanValidityChecker::satisfiesConstraints;
+
+    bool satisfiesConstraints(const std::vector<ob::State*> &states, const unsigned int first_step,
+        const ConstraintIndex &index) override;
+
+    bool independentCheck(ob::State* state1, ob::State* state2);
+
+    /* seed of the samples of every check (0 by default) */
+    void setSeed(const std::uint64_t seed) {random_.seed(seed);};
+
+private:
+    const void *pairGeometry_(const int a, const int b) const override {return &pair_reach_(a, b);};
+
+    typedef SimdRandom<8> Random;
+
+    ConflictPtr checkForConflicts_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int step,
+        SweepAndPrune &broadphase) override;
+    double safeHalfWidth_(const int agent, const double max_lambda, const double max_sqrt_lambda) const override;
+    bool isPairSafe_(const int a, const Eigen::Vector2d &mu_a, const Eigen::Matrix2d &Sigma_a, const int b,
+        const Eigen::Vector2d &mu_b, const Eigen::Matrix2d &Sigma_b) override;
+    bool pairwise_() const override {return true;};
+    bool batchable_() const override {return true;};
+    bool isRelativeSafe_(const int a, const int b, const Eigen::Vector2d &mu_ab, const Eigen::Matrix2d &Sigma_ab) const override
+    {
+        return isSafe_(mu_ab, Sigma_ab, pair_reach_(a, b));
+    };
+    /* whether the pair whose difference is N(mu_ab, sigma_ab) collides (is within reach along x and y) with a
+       probability below p_coll */
+    bool isSafe_(const Eigen::Vector2d &mu_ab, const Eigen::Matrix2d &sigma_ab, const double reach) const;
+    /* half-width of the bounding box of every pair of robots (by id), the sum of their bounding radii */
+    PairTable<double> pair_reach_;
+    const int max_samples_;
+    /* samples between two tests of the sequential test */
+    static constexpr int test_every_ = 64;
+    /* log-likelihood ratio of a hit and of a miss, and the thresholds of the test */
+    double llr_hit_, llr_miss_, accept_, reject_;
+    /* sqrt(2) erf_inv of the risk of a pair, the scale of the broadphase boxes */
+    double chance_scale_;
+    /* the generator every check starts from a copy of */
+    Random random_;
+};
@@ -2,7 +2,11 @@
 #include "utils/Conflict.h"
 #include "utils/MultiRobotProblemDefinition.h"
 #include "Constraints/Constraint.h"
+#include "Constraints/ConstraintIndex.h"
+#include "utils/DiscretePlan.h"
 #include <ompl/control/PathControl.h>
+#include <map>
+#include <limits>
 
 namespace oc = ompl::control;
 typedef std::vector<oc::PathControl> Plan;
@@ -12,18 +16,114 @@ OMPL_CLASS_FORWARD(PlanValidityChecker);
 class PlanValidityChecker
 {
 public:
+	/* Conflict intervals of every pair of robots (key (i, j) with i < j) in order, empty if the pair is conflict-free.
+	   Only the first interval of a pair is kept, unless all_intervals_ */
+	struct ValidationCache
+	{
+		int max_states_{-1};
+		bool all_intervals_{false};
+		std::map<std::pair<int, int>, std::vector<std::vector<ConflictPtr>>> pairs_;
+	};
+
 	PlanValidityChecker(MultiRobotProblemDefinitionPtr pdef, const std::string name):
 		mrmp_pdef_(pdef), name_(name) {}
 
-	virtual std::vector<ConflictPtr> validatePlan(Plan p) = 0;
+	/* the validators only read the (already interpolated) trajectories of p, so it is never copied */
+	virtual std::vector<ConflictPtr> validatePlan(const DiscretePlan &p) = 0;
+
+	/* Validate p when only changed_agent differs from the plan that produced cache. Only the pairs that include 
+	   changed_agent are re-checked, and cache is updated in place. If the cache is empty (or changed_agent < 0) every pair is checked.
+	   If agents is not empty, only the pairs between those agents are considered */
+	std::vector<ConflictPtr> validatePlanIncremental(const DiscretePlan &p, const int changed_agent, ValidationCache &cache, 
+		const std::vector<int> &agents = {});
+
+	/* Every conflict interval of p in one pass, ordered by their first step (then by pair), so the first one is the
+	   conflict of validatePlanIncremental. The pairs are re-checked as in validatePlanIncremental, and cache keeps every
+	   interval of every pair (a cache of first intervals only is checked anew) */
+	std::vector<std::vector<ConflictPtr>> validatePlanAll(const DiscretePlan &p, const int changed_agent, ValidationCache &cache,
+		const std::vector<int> &agents = {});
+
+	virtual ConstraintPtr createConstraint(const DiscretePlan &p, const std::vector<ConflictPtr> &conflicts, const int agent) = 0;
+
+	/* the constraints of a disjoint split of conflicts on agent: the region is where agent would collide with the other
+	   robot of the conflicts if that robot were at the states of agent in p. A positive constraint keeps agent inside it
+	   (which its plan already satisfies), a negative one out of it. nullptr if the validator cannot split disjointly */
+	virtual ConstraintPtr createRegionConstraint(const DiscretePlan &p, const std::vector<ConflictPtr> &conflicts, const int agent,
+		const bool positive) {return nullptr;};
+
+	/* index constraints (all on the same agent) by the step they apply to */
+	ConstraintIndexPtr indexConstraints(const std::vector<ConstraintPtr> &constraints) const;
+
+	/* check an interpolated path, whose first state is at time 0 */
+	bool satisfiesConstraints(const oc::PathControl &path, const std::vector<ConstraintPtr> &constraints)
+	{
+		if (constraints.empty())
+			return true;
+		const ConstraintIndexPtr index = indexConstraints(constraints);
+		return checkConstraints(path.getStates(), 0, *index) && (path.getStateCount() == 0 ||
+			satisfiesFinalConstraints(path.getStates().back(), path.getStateCount() - 1, *index));
+	}
+
+	/* check consecutive states (as satisfiesConstraints) against every constraint of index, negative and positive */
+	bool checkConstraints(const std::vector<ompl::base::State*> &states, const unsigned int first_step, const ConstraintIndex &index);
+
+	/* true if a robot that stays at st after step (its path ended there) satisfies the positive constraints of index */
+	bool satisfiesFinalConstraints(ompl::base::State *st, const unsigned int step, const ConstraintIndex &index);
+
+	/* false if the states (as in satisfiesConstraints) satisfy every constraint of index without checking them, because
+	   no constraint applies to their steps or (if the validator bounds its constraints) they are too far away */
+	bool nearConstraints(const std::vector<ompl::base::State*> &states, const unsigned int first_step,
+		const ConstraintIndex &index) const
+	{
+		return !states.empty() && nearConstraints(states, first_step, first_step + states.size() - 1, index);
+	}
 
-	virtual ConstraintPtr createConstraint(Plan p, std::vector<ConflictPtr> conflicts, const int agent) = 0;
+	/* nearConstraints for states that may be anywhere in their box at any step of [first_step, last_step], such as the
+	   ends of an extension that is not propagated yet */
+	virtual bool nearConstraints(const std::vector<ompl::base::State*> &states, const unsigned int first_step,
+		const unsigned int last_step, const ConstraintIndex &index) const;
 
-	virtual bool satisfiesConstraints(oc::PathControl path, std::vector<ConstraintPtr> constraints) = 0;
+	/* check consecutive states of an interpolated path, the first of which is first_step system steps after its start */
+	virtual bool satisfiesConstraints(const std::vector<ompl::base::State*> &states, const unsigned int first_step, 
+		const ConstraintIndex &index) = 0;
 
     std::string getName() const {return name_;};
 
+	/* Only report conflicts within the first t seconds of a plan (receding horizon). The window is infinite by default */
+	void setConflictWindow(const double t) {window_ = t;};
+
+	double getConflictWindow() const {return window_;};
+
+	/* Threads that validatePlan may split the steps of a plan between (if the validator supports it). 1 by default */
+	void setNumThreads(const unsigned int n) {num_threads_ = (n > 0) ? n : 1;};
+
+	unsigned int getNumThreads() const {return num_threads_;};
+
 protected:
+	/* the steps of p (its trajectories interpolated to the same discretization) that a validator checks: the
+	   conflicts after the conflict window are not looked for, so they are not resolved either */
+	int windowSteps_(const DiscretePlan &p) const;
+
+	/* the geometry of the pair (a, b) that the constraint checks of the validator read, resolved once per constraint
+	   into the entries of its indexes (the checks cast it back). It must outlive the validator's indexes. nullptr if
+	   the checks read none (by default) */
+	virtual const void *pairGeometry_(const int a, const int b) const {return nullptr;};
+
+	/* the box and margin of the window of constraint c (see ConstraintIndex::Window). Anywhere by default */
+	virtual void boundConstraint_(const Constraint &c, ConstraintIndex::Window &w) const;
+
+	/* re-check the pairs of cache (see validatePlanIncremental), keeping every interval if all */
+	void updateCache_(const DiscretePlan &p, const int changed_agent, ValidationCache &cache, const std::vector<int> &agents,
+		const bool all);
+
+	/* find the first conflict interval between robots a1 and a2 in an interpolated plan with max_states steps */
+	virtual std::vector<ConflictPtr> validatePair_(const DiscretePlan &p, const int a1, const int a2, const int max_states) = 0;
+
+	/* every conflict interval (in order) between robots a1 and a2 in an interpolated plan with max_states steps */
+	virtual std::vector<std::vector<ConflictPtr>> validatePairAll_(const DiscretePlan &p, const int a1, const int a2, const int max_states) = 0;
+
 	MultiRobotProblemDefinitionPtr mrmp_pdef_;
 	std::string name_;
+	double window_{std::numeric_limits<double>::infinity()};
+	unsigned int num_threads_{1};
 };
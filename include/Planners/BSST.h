@@ -1,5 +1,10 @@
 #pragma once
 #include "Spaces/RealVectorBeliefSpace.h"
+#include "utils/NodeArena.h"
+#include "utils/CostToGoSampler.h"
+#include "utils/CovarianceSampler.h"
+#include "utils/ConstraintRespectingGetDefaultNN.h"
+#include "utils/NearestNeighborsTombstones.h"
 #include <ompl/tools/config/SelfConfig.h>
 #include <ompl/base/goals/GoalSampleableRegion.h>
 #include <ompl/base/objectives/PathLengthOptimizationObjective.h>
@@ -53,6 +58,31 @@ namespace ompl
                 return goalBias_;
             }
 
+            /** \brief Sample from the cost-to-go of the robot (see CostToGoSampler) instead of uniformly, nullptr to
+                stop */
+            void setCostToGo(std::shared_ptr<const CostToGoMap> map)
+            {
+                heuristic_ = map ? std::make_shared<CostToGoSampler>(si_->getStateSpace(), std::move(map)) : nullptr;
+            }
+
+            /** \brief Probability of sampling ahead of the frontier of the tree, with a cost-to-go (0 by default) */
+            void setHeuristicBias(double heuristicBias)
+            {
+                heuristicBias_ = heuristicBias;
+            }
+
+            double getHeuristicBias() const
+            {
+                return heuristicBias_;
+            }
+
+            /** \brief Sampler of the covariance of the random beliefs. By default (nullptr) the covariance is drawn
+                from the sequence reachable from the start (see ReachableCovarianceSampler) */
+            void setCovarianceSampler(std::shared_ptr<const CovarianceSampler> sampler)
+            {
+                covarianceSampler_ = std::move(sampler);
+            }
+
             /**
                 \brief Set the radius for selecting nodes relative to random sample.
                 This radius is used to mimic behavior of RRT* in that it promotes
@@ -115,8 +145,9 @@ namespace ompl
                 if (nn_ && nn_->size() != 0)
                     OMPL_WARN("Calling setNearestNeighbors will clear all states.");
                 clear();
-                nn_ = std::make_shared<NN<Motion *>>();
+                nn_ = withTombstones_(std::make_shared<NN<Motion *>>());
                 witnesses_ = std::make_shared<NN<Motion *>>();
+                witness_grid_ = nullptr;
                 setup();
             }
 
@@ -165,6 +196,9 @@ namespace ompl
 
                 /** \brief If inactive, this node is not considered for selection.*/
                 bool inactive_{false};
+
+                /** \brief If pinned, this node ends the best solution so far and is never pruned */
+                bool pinned_{false};
             };
 
             class Witness : public Motion
@@ -199,9 +233,25 @@ namespace ompl
             /** \brief Find the closest witness node to a newly generated potential node.*/
             Witness *findClosestWitness(Motion *node);
 
+            /** \brief The closest witness within the pruning radius of node, nullptr if there is none */
+            Witness *witnessWithin_(Motion *node) const;
+
             /** \brief Free the memory allocated by this planner */
             void freeMemory();
 
+            /** \brief Make the branch that ends at motion the best solution so far (nullptr for none), unpinning the
+                previous one */
+            void pinSolution_(Motion *motion);
+
+            /** \brief The path of the best solution so far, from its start to its end */
+            std::shared_ptr<PathControl> solutionPath_() const;
+
+            /** \brief Wrap the nearest neighbors of the motions, so removed motions are dropped in batches and recycled */
+            std::shared_ptr<NearestNeighbors<Motion *>> withTombstones_(std::shared_ptr<NearestNeighbors<Motion *>> nn);
+
+            /** \brief A new motion, reusing the state and control of a recycled motion if there is one */
+            Motion *allocMotion_();
+
             /** \brief Compute distance between motions (actually distance between contained states) */
             double distanceFunction(const Motion *a, const Motion *b) const
             {
@@ -217,16 +267,39 @@ namespace ompl
             /** \brief The base::SpaceInformation cast as control::SpaceInformation, for convenience */
             const SpaceInformation *siC_;
 
-            /** \brief A nearest-neighbors datastructure containing the tree of motions */
+            /** \brief A nearest-neighbors datastructure containing the tree of motions. Only active motions are kept (a
+                motion is removed once it is deactivated), so a selection is a single query. Removals are lazy (see
+                NearestNeighborsTombstones): a removed motion stays allocated until nn_ purges it into motion_pool_ */
             std::shared_ptr<NearestNeighbors<Motion *>> nn_;
 
+            /** \brief Motions purged from nn_, whose states and controls are reused by allocMotion_ */
+            std::vector<Motion *> motion_pool_;
+
             /** \brief A nearest-neighbors datastructure containing the tree of witness motions */
             std::shared_ptr<NearestNeighbors<Motion *>> witnesses_;
 
+            /** \brief witnesses_ if it is a hash grid (for belief spaces), which answers witnessWithin_ from the cells
+                around the node */
+            NearestNeighborsHashGrid<Motion *> *witness_grid_{nullptr};
+
+            /** \brief Storage of the motions and witnesses. freeMemory() releases it at once */
+            NodeArena<Motion> motion_arena_;
+            NodeArena<Witness> witness_arena_;
+
             /** \brief The fraction of time the goal is picked as the state to expand towards (if such a state is
              * available) */
             double goalBias_{0.05};
 
+            /** \brief Informed sampling from the cost-to-go, nullptr to sample uniformly */
+            std::shared_ptr<CostToGoSampler> heuristic_;
+
+            /** \brief The fraction of the informed samples drawn ahead of the frontier of the tree */
+            double heuristicBias_{0.0};
+
+            /** \brief The covariance sampler set by the user, and the default one (built on solve) */
+            std::shared_ptr<const CovarianceSampler> covarianceSampler_;
+            std::shared_ptr<const CovarianceSampler> reachableCovariance_;
+
             /** \brief The radius for determining the node selected for extension. */
             double selectionRadius_{0.2};
 
@@ -240,10 +313,9 @@ namespace ompl
             /** \brief The random number generator */
             RNG rng_;
 
-            /** \brief The best solution we found so far. */
-            std::vector<base::State *> prevSolution_;
-            std::vector<Control *> prevSolutionControls_;
-            std::vector<unsigned> prevSolutionSteps_;
+            /** \brief The last motion of the best solution we found so far (pinned, so its branch stays in the tree).
+                The solution path is only built from it when solve() returns */
+            Motion *prevSolution_{nullptr};
 
             /** \brief The best solution cost we found so far. */
             base::Cost prevSolutionCost_;
@@ -1,6 +1,11 @@
 #pragma once
 #include "Goals/BeliefSpaceGoals.h"
 #include "Spaces/RealVectorBeliefSpace.h"
+#include "utils/NodeArena.h"
+#include "utils/AgentDecoupledPropagation.h"
+#include "utils/ConstraintRespectingGetDefaultNN.h"
+#include "utils/NearestNeighborsTombstones.h"
+#include "utils/CovarianceSampler.h"
 #include <ompl/tools/config/SelfConfig.h>
 #include <ompl/base/goals/GoalSampleableRegion.h>
 #include <ompl/control/planners/PlannerIncludes.h>
@@ -59,6 +64,13 @@ namespace ompl
                 return goalBias_;
             }
 
+            /** \brief Sampler of the covariance of the random beliefs. By default (nullptr) the covariance is drawn
+                from the sequence reachable from the start (see ReachableCovarianceSampler) */
+            void setCovarianceSampler(std::shared_ptr<const CovarianceSampler> sampler)
+            {
+                covarianceSampler_ = std::move(sampler);
+            }
+
             /**
                 \brief Set the radius for selecting nodes relative to random sample.
                 This radius is used to mimic behavior of RRT* in that it promotes
@@ -121,8 +133,9 @@ namespace ompl
                 if (nn_ && nn_->size() != 0)
                     OMPL_WARN("Calling setNearestNeighbors will clear all states.");
                 clear();
-                nn_ = std::make_shared<NN<Motion *>>();
+                nn_ = withTombstones_(std::make_shared<NN<Motion *>>());
                 witnesses_ = std::make_shared<NN<Motion *>>();
+                witness_grid_ = nullptr;
                 setup();
             }
 
@@ -171,6 +184,9 @@ namespace ompl
 
                 /** \brief If inactive, this node is not considered for selection.*/
                 bool inactive_{false};
+
+                /** \brief If pinned, this node ends the best solution so far and is never pruned */
+                bool pinned_{false};
             };
 
             class Witness : public Motion
@@ -199,12 +215,8 @@ namespace ompl
                 Motion *rep_{nullptr};
             };
 
-            /* the extend function for multi-agent systems */
-            unsigned int multiAgentControlSampler(Control *rcontrol, Control *previous, 
-                const base::State *source, base::State *dest);
-
-            /* reset states that are already at goal */
-            void overrideStates(const base::State *source, base::State *result, Control *control);
+            /* the agents that are not at their goal at source. The controls of the others are zeroed */
+            std::vector<bool> activeAgents_(const base::State *source, Control *control) const;
 
             /** \brief Finds the best node in the tree withing the selection radius around a random sample.*/
             Motion *selectNode(Motion *sample);
@@ -212,9 +224,25 @@ namespace ompl
             /** \brief Find the closest witness node to a newly generated potential node.*/
             Witness *findClosestWitness(Motion *node);
 
+            /** \brief The closest witness within the pruning radius of node, nullptr if there is none */
+            Witness *witnessWithin_(Motion *node) const;
+
             /** \brief Free the memory allocated by this planner */
             void freeMemory();
 
+            /** \brief Make the branch that ends at motion the best solution so far (nullptr for none), unpinning the
+                previous one */
+            void pinSolution_(Motion *motion);
+
+            /** \brief The path of the best solution so far, from its start to its end */
+            std::shared_ptr<PathControl> solutionPath_() const;
+
+            /** \brief Wrap the nearest neighbors of the motions, so removed motions are dropped in batches and recycled */
+            std::shared_ptr<NearestNeighbors<Motion *>> withTombstones_(std::shared_ptr<NearestNeighbors<Motion *>> nn);
+
+            /** \brief A new motion, reusing the state and control of a recycled motion if there is one */
+            Motion *allocMotion_();
+
             /** \brief Compute distance between motions (actually distance between contained states) */
             double distanceFunction(const Motion *a, const Motion *b) const
             {
@@ -230,16 +258,33 @@ namespace ompl
             /** \brief The base::SpaceInformation cast as control::SpaceInformation, for convenience */
             const SpaceInformation *siC_;
 
-            /** \brief A nearest-neighbors datastructure containing the tree of motions */
+            /** \brief A nearest-neighbors datastructure containing the tree of motions. Only active motions are kept (a
+                motion is removed once it is deactivated), so a selection is a single query. Removals are lazy (see
+                NearestNeighborsTombstones): a removed motion stays allocated until nn_ purges it into motion_pool_ */
             std::shared_ptr<NearestNeighbors<Motion *>> nn_;
 
+            /** \brief Motions purged from nn_, whose states and controls are reused by allocMotion_ */
+            std::vector<Motion *> motion_pool_;
+
             /** \brief A nearest-neighbors datastructure containing the tree of witness motions */
             std::shared_ptr<NearestNeighbors<Motion *>> witnesses_;
 
+            /** \brief witnesses_ if it is a hash grid (for belief spaces), which answers witnessWithin_ from the cells
+                around the node */
+            NearestNeighborsHashGrid<Motion *> *witness_grid_{nullptr};
+
+            /** \brief Storage of the motions and witnesses. freeMemory() releases it at once */
+            NodeArena<Motion> motion_arena_;
+            NodeArena<Witness> witness_arena_;
+
             /** \brief The fraction of time the goal is picked as the state to expand towards (if such a state is
              * available) */
             double goalBias_{0.05};
 
+            /** \brief The covariance sampler set by the user, and the default one (built on solve) */
+            std::shared_ptr<const CovarianceSampler> covarianceSampler_;
+            std::shared_ptr<const CovarianceSampler> reachableCovariance_;
+
             /** \brief The radius for determining the node selected for extension. */
             double selectionRadius_{0.2};
 
@@ -257,10 +302,9 @@ namespace ompl
             /** \brief The random number generator */
             RNG rng_;
 
-            /** \brief The best solution we found so far. */
-            std::vector<base::State *> prevSolution_;
-            std::vector<Control *> prevSolutionControls_;
-            std::vector<unsigned> prevSolutionSteps_;
+            /** \brief The last motion of the best solution we found so far (pinned, so its branch stays in the tree).
+                The solution path is only built from it when solve() returns */
+            Motion *prevSolution_{nullptr};
 
             /** \brief The best solution cost we found so far. */
             base::Cost prevSolutionCost_;
@@ -272,6 +316,9 @@ namespace ompl
 
             const int num_agents_;
             const int dim_;
+
+            /* propagation of the agents that are not at their goal, which are checked on their own first */
+            std::unique_ptr<AgentDecoupledPropagation> propagation_;
         };
     }
 }
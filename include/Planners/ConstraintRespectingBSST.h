@@ -1,5 +1,6 @@
 #pragma once
 #include "Spaces/RealVectorBeliefSpace.h"
+#include "utils/NodeArena.h"
 // #include "Spaces/R2BeliefSpace.h"
 // #include <ompl/base/spaces/SO2StateSpace.h>
 #include <ompl/control/ControlSpace.h>
@@ -8,9 +9,13 @@
 #include "Planners/ConstraintRespectingPlanner.h"
 #include "PlanValidityCheckers/PlanValidityChecker.h"
 #include <utils/ConstraintRespectingGetDefaultNN.h>
+#include "utils/NearestNeighborsTombstones.h"
+#include "utils/CovarianceSampler.h"
+#include "utils/ExperienceCache.h"
 #include <ompl/control/planners/PlannerIncludes.h>
 #include <ompl/base/objectives/PathLengthOptimizationObjective.h>
 #include <ompl/base/objectives/MaximizeMinClearanceObjective.h>
+#include <shared_mutex>
 
 
 namespace ompl
@@ -34,6 +39,10 @@ namespace ompl
 
             void getPlannerDataAndCosts(base::PlannerData &data, std::vector<double > &costs) const;
 
+            bool hasPathWithin(const std::vector<ConstraintPtr> &constraints, const double max_duration) const override;
+
+            bool canProbePaths() const override {return true;};
+
             /** \brief Clear datastructures. Call this function if the
                 input data to the planner has changed and you do not
                 want to continue planning */
@@ -57,6 +66,13 @@ namespace ompl
                 return goalBias_;
             }
 
+            /** \brief Sampler of the covariance of the random beliefs. By default (nullptr) the covariance is drawn
+                from the sequence reachable from the start (see ReachableCovarianceSampler) */
+            void setCovarianceSampler(std::shared_ptr<const CovarianceSampler> sampler)
+            {
+                covarianceSampler_ = std::move(sampler);
+            }
+
             /**
                 \brief Set the radius for selecting nodes relative to random sample.
                 This radius is used to mimic behavior of RRT* in that it promotes
@@ -107,6 +123,61 @@ namespace ompl
                 return samplingBias_;
             }
 
+            /** \brief Set the number of threads that grow the tree. With more than one, the propagator, the state
+                validity checker and the plan validity checker are called concurrently and must be thread-safe */
+            void setNumThreads(unsigned int numThreads)
+            {
+                num_threads_ = std::max(numThreads, 1u);
+                specs_.multithreaded = (num_threads_ > 1);
+            }
+
+            /** \brief Get the number of threads that grow the tree */
+            unsigned int getNumThreads() const
+            {
+                return num_threads_;
+            }
+
+            /** \brief Set the number of controls tried per extension. With more than one, the controls are propagated
+                together (in one batch if the propagator is a BatchStatePropagator) and the valid one that ends
+                closest to the random sample extends the tree */
+            void setBatchControls(unsigned int batchControls)
+            {
+                batch_controls_ = std::max(batchControls, 1u);
+            }
+
+            /** \brief Get the number of controls tried per extension */
+            unsigned int getBatchControls() const
+            {
+                return batch_controls_;
+            }
+
+            /** \brief Set how many times a random state is sampled again when the extension towards it heads into the
+                constraints of the agent at their steps (see headsIntoConstraints_). The last sample is kept, so the
+                tree still reaches the constrained regions. 0 samples without regard to the constraints */
+            void setConstraintResamples(unsigned int resamples)
+            {
+                constraintResamples_ = resamples;
+            }
+
+            /** \brief Get how many times a sample heading into the constraints is drawn again */
+            unsigned int getConstraintResamples() const
+            {
+                return constraintResamples_;
+            }
+
+            /** \brief Before growing a fresh tree, replay the cached trajectories that start nearest to the start and end
+                nearest to the goal. Their valid prefixes (under the constraints) seed the tree, and a replay that reaches
+                the goal is a solution. Every exact solution is added to the cache. nullptr to plan without experience */
+            void setExperienceCache(ExperienceCachePtr cache)
+            {
+                experience_ = std::move(cache);
+            }
+
+            const ExperienceCachePtr &getExperienceCache() const
+            {
+                return experience_;
+            }
+
             void setDistanceFunction(int distfunc)
             {
                 DISTANCE_FUNC_ = distfunc;
@@ -119,8 +190,9 @@ namespace ompl
                 if (nn_ && nn_->size() != 0)
                     OMPL_WARN("Calling setNearestNeighbors will clear all states.");
                 clear();
-                nn_ = std::make_shared<NN<Motion *>>();
+                nn_ = withTombstones_(std::make_shared<NN<Motion *>>());
                 witnesses_ = std::make_shared<NN<Motion *>>();
+                witness_grid_ = nullptr;
                 setup();
             }
 
@@ -169,6 +241,15 @@ namespace ompl
 
                 /** \brief If inactive, this node is not considered for selection.*/
                 bool inactive_{false};
+
+                /** \brief If pinned, this node ends the best solution so far and is never pruned */
+                bool pinned_{false};
+
+                /** \brief Number of propagation steps from the start to state_ */
+                unsigned int timeStep_{0};
+
+                /** \brief The branch from the start up to this motion satisfies the constraints */
+                bool satisfiesConstraints_{true};
             };
 
             class Witness : public Motion
@@ -203,9 +284,89 @@ namespace ompl
             /** \brief Find the closest witness node to a newly generated potential node.*/
             Witness *findClosestWitness(Motion *node);
 
+            /** \brief The closest witness within the pruning radius of node, nullptr if there is none */
+            Witness *witnessWithin_(Motion *node) const;
+
             /** \brief Free the memory allocated by this planner */
             void freeMemory();
 
+            /** \brief Make the branch that ends at motion the best solution so far (nullptr for none), unpinning the
+                previous one */
+            void pinSolution_(Motion *motion);
+
+            /** \brief The path of the best solution so far, from its start to its end */
+            std::shared_ptr<PathControl> solutionPath_() const;
+
+            /** \brief Allocate the nearest neighbors of the motions and witnesses (if not yet allocated) */
+            void allocNearestNeighbors_();
+
+            /** \brief Wrap the nearest neighbors of the motions, so removed motions are dropped in batches and recycled */
+            std::shared_ptr<NearestNeighbors<Motion *>> withTombstones_(std::shared_ptr<NearestNeighbors<Motion *>> nn);
+
+            /** \brief A new motion, reusing the state and control of a recycled motion if there is one */
+            Motion *allocMotion_();
+
+            /** \brief Remove the motions whose path from the start violates the constraints (and their subtrees) */
+            bool pruneTree_() override;
+
+            /** \brief Check only the states of a new edge (applying ctrl for steps from parent) against the constraints that
+                overlap its time window. The branch up to parent must already satisfy the constraints. The states of the
+                edge are propagated again unless edge holds them (steps of them, as kept by a SegmentPropagation) */
+            bool edgeSatisfiesConstraints_(const Motion *parent, const Control *ctrl, const unsigned int steps,
+                base::State *const *edge = nullptr) const;
+
+            /** \brief edgeSatisfiesConstraints_ against index (none if nullptr) instead of the constraints of the planner */
+            bool edgeSatisfiesIndex_(const Motion *parent, const Control *ctrl, const unsigned int steps, const ConstraintIndex *index,
+                base::State *const *edge = nullptr) const;
+
+            /** \brief Whether an extension from nmotion towards target, over the steps a control may last, comes near a
+                constraint whose window covers those steps. Only the box of the two states is tested, so this is a cheap
+                guess that steers the samples rather than a check. False with positive constraints, which are anywhere */
+            bool headsIntoConstraints_(const Motion *nmotion, base::State *target) const;
+
+            /** \brief Scratch controls and states of the best-of-K extension, one set per thread */
+            struct Candidates
+            {
+                std::vector<Control *> controls_;
+                std::vector<base::State *> states_;
+                std::vector<base::State *> next_;
+                /* arguments of one batch call, over the candidates that are still valid */
+                std::vector<std::size_t> alive_;
+                std::vector<const base::State *> from_;
+                std::vector<const Control *> applied_;
+                std::vector<base::State *> to_;
+            };
+
+            void allocCandidates_(Candidates &candidates) const;
+
+            void freeCandidates_(Candidates &candidates) const;
+
+            /** \brief Propagate batch_controls_ sampled controls from source for steps while valid. The valid 
+                candidate closest to target is copied to target and its control to ctrl. Returns steps if there 
+                is such a candidate, and 0 otherwise */
+            unsigned int propagateBestOf_(const base::State *source, base::State *target, const unsigned int steps, 
+                ControlSampler &sampler, Candidates &candidates, Control *ctrl) const;
+
+            /** \brief Grow the tree with num_threads_ workers until a solution is found or ptc is satisfied.
+                Returns the solution (or nullptr) and adds the iterations of all workers to iterations */
+            Motion *growParallel_(const base::PlannerTerminationCondition &ptc, double &approxdif, unsigned int &iterations);
+
+            /** \brief Draw the covariance of the random belief st */
+            void sampleCovariance_(RNG &rng, base::State *st) const
+            {
+                (covarianceSampler_ ? *covarianceSampler_ : *reachableCovariance_).sample(rng, st);
+            }
+
+            /** \brief Replace the best solution found so far with the branch that ends at solution */
+            void storeSolution_(Motion *solution);
+
+            /** \brief Replay the experiences nearest to the problem from root (see setExperienceCache). Returns the motion
+                that reaches the goal (stored as the solution), or nullptr */
+            Motion *replayExperience_(Motion *root, base::Goal *goal);
+
+            /** \brief Add the best solution found so far to the experience cache */
+            void recordExperience_() const;
+
             /** \brief Compute distance between motions (actually distance between contained states) */
             double distanceFunction(const Motion *a, const Motion *b) const
             {
@@ -221,16 +382,33 @@ namespace ompl
             /** \brief The base::SpaceInformation cast as control::SpaceInformation, for convenience */
             const SpaceInformation *siC_;
 
-            /** \brief A nearest-neighbors datastructure containing the tree of motions */
+            /** \brief A nearest-neighbors datastructure containing the tree of motions. Only active motions are kept (a
+                motion is removed once it is deactivated), so a selection is a single query. Removals are lazy (see
+                NearestNeighborsTombstones): a removed motion stays allocated until nn_ purges it into motion_pool_ */
             std::shared_ptr<NearestNeighbors<Motion *>> nn_;
 
+            /** \brief Motions purged from nn_, whose states and controls are reused by allocMotion_ */
+            std::vector<Motion *> motion_pool_;
+
             /** \brief A nearest-neighbors datastructure containing the tree of witness motions */
             std::shared_ptr<NearestNeighbors<Motion *>> witnesses_;
 
+            /** \brief witnesses_ if it is a hash grid (for belief spaces), which answers witnessWithin_ from the cells
+                around the node */
+            NearestNeighborsHashGrid<Motion *> *witness_grid_{nullptr};
+
+            /** \brief Storage of the motions and witnesses. freeMemory() releases it at once */
+            NodeArena<Motion> motion_arena_;
+            NodeArena<Witness> witness_arena_;
+
             /** \brief The fraction of time the goal is picked as the state to expand towards (if such a state is
              * available) */
             double goalBias_{0.05};
 
+            /** \brief The covariance sampler set by the user, and the default one (built on solve) */
+            std::shared_ptr<const CovarianceSampler> covarianceSampler_;
+            std::shared_ptr<const CovarianceSampler> reachableCovariance_;
+
             /** \brief The radius for determining the node selected for extension. */
             double selectionRadius_{0.2};
 
@@ -244,10 +422,9 @@ namespace ompl
             /** \brief The random number generator */
             RNG rng_;
 
-            /** \brief The best solution we found so far. */
-            std::vector<base::State *> prevSolution_;
-            std::vector<Control *> prevSolutionControls_;
-            std::vector<unsigned> prevSolutionSteps_;
+            /** \brief The last motion of the best solution we found so far (pinned, so its branch stays in the tree).
+                The solution path is only built from it when solve() returns */
+            Motion *prevSolution_{nullptr};
 
             /** \brief The best solution cost we found so far. */
             base::Cost prevSolutionCost_;
@@ -256,6 +433,24 @@ namespace ompl
             base::OptimizationObjectivePtr opt_;
 
             double max_eigenvalue_;
+
+            /** \brief The number of threads that grow the tree */
+            unsigned int num_threads_{1};
+
+            /** \brief The number of controls tried per extension */
+            unsigned int batch_controls_{1};
+
+            /** \brief Times a sample heading into the constraints is drawn again */
+            unsigned int constraintResamples_{3};
+
+            /** \brief Trajectories of earlier problems, and how many of them are replayed (the nearest) from a start
+                within experienceRadius_ */
+            ExperienceCachePtr experience_;
+            unsigned int maxReplays_{4};
+            double experienceRadius_{1.0};
+
+            /** \brief Guards the tree and the witnesses while several threads grow them */
+            std::shared_mutex tree_mutex_;
         };
     }
 }
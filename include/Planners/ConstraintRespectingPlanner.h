@@ -1,5 +1,8 @@
 #pragma once
 #include "Constraints/Constraint.h"
+#include "Constraints/ConstraintIndex.h"
+#include "utils/CostToGoSampler.h"
+#include "utils/Seeding.h"
 #include <ompl/base/ProblemDefinition.h>
 #include <ompl/base/goals/GoalSampleableRegion.h>
 #include <ompl/control/planners/PlannerIncludes.h>
@@ -150,19 +153,108 @@ public:
         return planValidator_;
     }
 
-    void updateConstraints(std::vector<ConstraintPtr> c) 
+    void updateConstraints(const std::vector<ConstraintPtr> &c);
+
+    /** \brief With warm-starting, updateConstraints() only removes the branches that violate the new constraints, 
+        instead of clearing the whole tree */
+    void setWarmStart(const bool b) {warm_start_ = b;};
+
+    bool getWarmStart() const {return warm_start_;};
+
+    /** \brief Cost probe of K-CBS (like a reachability check of an MDD): true if the tree of the planner holds a path from
+        the start that reaches the goal within max_duration seconds and satisfies every constraint of constraints. If none
+        does, replanning with them probably takes longer (the tree is only a sample). Only meaningful if canProbePaths() */
+    virtual bool hasPathWithin(const std::vector<ConstraintPtr> &constraints, const double max_duration) const {return false;};
+
+    /** \brief True if the planner keeps a tree for hasPathWithin */
+    virtual bool canProbePaths() const {return false;};
+
+    /** \brief Sample from the cost-to-go of the robot (see CostToGoSampler) instead of uniformly, nullptr to stop */
+    void setCostToGo(std::shared_ptr<const CostToGoMap> map)
+    {
+        heuristic_ = map ? std::make_shared<CostToGoSampler>(si_->getStateSpace(), std::move(map)) : nullptr;
+    }
+
+    /** \brief Probability of sampling ahead of the frontier of the tree, with a cost-to-go (0 by default) */
+    void setHeuristicBias(const double b) {heuristic_bias_ = b;};
+
+    double getHeuristicBias() const {return heuristic_bias_;};
+
+    /** \brief Probability of sampling the position of a state around the region of a positive constraint (a sub-goal of
+        the path), while there are positive constraints (0.05 by default) */
+    void setSubgoalBias(const double b) {subgoal_bias_ = b;};
+
+    double getSubgoalBias() const {return subgoal_bias_;};
+
+    /** \brief Seed the generator and samplers of the planner on the next solve(), instead of OMPL's global sequence.
+        The solves after it draw from the same streams, so a run is repeated by the same seeds. 0 keeps OMPL's */
+    void setSeed(const std::uint32_t seed)
     {
-        /* clear old data */
-        clear();
-        /* clear old solutions */
-        pdef_->clearSolutionPaths();
-        /* update constraints */
-        constraints_ = c;
+        seed_ = seed;
+        seed_stream_ = 0;
+        reseed_ = (seed != 0);
     }
 
+    std::uint32_t getSeed() const {return seed_;};
+
 protected:
+    /* true once after setSeed, when the generators must be seeded */
+    bool takeSeed_()
+    {
+        const bool reseed = reseed_;
+        reseed_ = false;
+        return reseed;
+    }
+
+    /* the seed of the next generator of the planner */
+    std::uint32_t nextSeed_() {return seeding::derive(seed_, seed_stream_++);};
+
+    /* remove every motion (and its subtree) that violates constraints_. 
+       Returns false if the old tree cannot be reused, in which case the planner is cleared */
+    virtual bool pruneTree_() {return false;};
+
+    /* a random state from sampler, informed by the cost-to-go if there is one, or around a sub-goal */
+    void sampleState_(ob::StateSampler &sampler, ompl::RNG &rng, ob::State *st) const
+    {
+        if (heuristic_)
+            heuristic_->sample(sampler, rng, heuristic_bias_, st);
+        else
+            sampler.sampleUniform(st);
+        if (!subgoals_.empty() && rng.uniform01() < subgoal_bias_)
+            sampleSubgoal_(rng, st);
+    }
+
+    /* place the position of st around a random sub-goal */
+    void sampleSubgoal_(ompl::RNG &rng, ob::State *st) const;
+
+    /* true if a path that ends at st, step steps after its start, satisfies the positive constraints after its end (see
+       PlanValidityChecker::satisfiesFinalConstraints) */
+    bool satisfiesFinalConstraints_(ob::State *st, const unsigned int step) const;
+
+    /* record a state added to the tree (for the frontier of the informed sampling) */
+    void trackFrontier_(const ob::State *st)
+    {
+        if (heuristic_)
+            heuristic_->update(st);
+    }
+
     // my additions for replanning w. KCBS
     PlanValidityCheckerPtr planValidator_;
     std::vector<ConstraintPtr> constraints_;
+    /* constraints_ indexed by step, nullptr if there are none */
+    ConstraintIndexPtr constraint_index_;
+    /* the positions (with their spread) that the positive constraints of constraints_ keep the robot around */
+    struct Subgoal
+    {
+        double x_, y_, sd_;
+    };
+    std::vector<Subgoal> subgoals_;
+    double subgoal_bias_{0.05};
+    bool warm_start_{false};
+    std::shared_ptr<CostToGoSampler> heuristic_;
+    double heuristic_bias_{0.0};
+    std::uint32_t seed_{0};
+    std::uint64_t seed_stream_{0};
+    bool reseed_{false};
 };
 
@@ -119,6 +119,9 @@ namespace ompl
                 /** \brief The number of steps the control is applied for */
                 unsigned int steps{0};
 
+                /** \brief The number of propagation steps from the start to the state */
+                unsigned int timeStep{0};
+
                 /** \brief The parent motion in the exploration tree */
                 Motion *parent{nullptr};
             };
@@ -126,6 +129,13 @@ namespace ompl
             /** \brief Free the memory allocated by this planner */
             void freeMemory();
 
+            /** \brief True if the states of the edge that applies ctrl for steps from parent satisfy constraint_index_.
+                Only the new states are checked, at their steps from the start */
+            bool edgeSatisfiesConstraints_(const Motion *parent, const Control *ctrl, const unsigned int steps) const;
+
+            /** \brief True if the states of an edge from parent (already propagated, without parent) satisfy constraint_index_ */
+            bool statesSatisfyConstraints_(const Motion *parent, const std::vector<base::State *> &edge) const;
+
             /** \brief Compute distance between motions (actually distance between contained states) */
             double distanceFunction(const Motion *a, const Motion *b) const
             {
@@ -158,10 +168,8 @@ namespace ompl
             Motion *lastGoalMotion_{nullptr};
 
             // my additions for replanning w. KCBS
-            PlanValidityCheckerPtr planValidator_;
-            std::vector<ConstraintPtr> constraints_;
             // Robot* robot_;
-            bool replanning_;
+            bool replanning_{false};
         };
     }
 }
@@ -3,9 +3,34 @@
 #include "Constraints/BeliefConstraint.h"
 #include "utils/MultiRobotProblemDefinition.h"
 #include "Planners/ConstraintRespectingPlanner.h"
+#include "utils/NodeArena.h"
+#include "utils/AllocStats.h"
+#include "utils/DiscretePlan.h"
+#include "utils/EventQueue.h"
+#include "utils/FocalOpenList.h"
+#include "utils/PerfCounters.h"
+#include "utils/ReplanBudget.h"
+#include "utils/SearchCluster.h"
+#include "utils/SearchCodec.h"
 #include <boost/serialization/export.hpp>
+#include <boost/functional/hash.hpp>
 #include <ompl/control/planners/PlannerIncludes.h>
 #include <ompl/util/ClassForward.h>
+#include <condition_variable>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
 
 
 namespace oc = ompl::control;
@@ -35,15 +60,12 @@ namespace ompl
             //     want to continue planning */
             // // void clear() override;
 
-            // /** In the process of randomly selecting states in the state
-            //     space to attempt to go towards, the algorithm may in fact
-            //     choose the actual goal state, if it knows it, with some
-            //     probability. This probability is a real number between 0.0
-            //     and 1.0; its value should usually be around 0.05 and
-            //     should not be too large. It is probably a good idea to use
-            //     the default value. */
-
-            // // void getPlannerData(base::PlannerData &data) const override;
+            /** \brief The conflict tree of the last (or running) call to solve(): a vertex per queued node, tagged with its id,
+                and an edge from every node to its parent weighted by the cost of the child. The root is the start vertex,
+                the solutions are goal vertices. The tree is logged as the search goes, and is only built into data when
+                asked, so it may be called from another thread during solve(). The states of the vertices only identify
+                the nodes (they are copies of the start of agent 0) */
+            void getPlannerData(base::PlannerData &data) const override;
 
             // // void setup() override;
 
@@ -64,19 +86,393 @@ namespace ompl
 
             // void resetSolveTime() {solveTime_ = 0.0;};
 
+            /** \brief Time spent in one phase of K-CBS (seconds) */
+            struct PhaseTime
+            {
+                double total_{0};
+                double max_{0};
+                unsigned int calls_{0};
+
+                perf::Counters counters_;  // hardware counters of the calls (zero unless perf::setEnabled)
+
+                void add(const double t, const perf::Counters &c = perf::Counters()) {total_ += t; max_ = std::max(max_, t); calls_++; counters_.add(c);};
+                void add(const PhaseTime &p) {total_ += p.total_; max_ = std::max(max_, p.max_); calls_ += p.calls_; counters_.add(p.counters_);};
+                double mean() const {return (calls_ > 0) ? total_ / calls_ : 0.0;};
+            };
+
+            /** \brief Allocations of a subsystem (see utils/AllocStats.h) during solve(), zero unless alloc::setEnabled */
+            struct MemoryUsage
+            {
+                std::size_t live_bytes_{0};      // at the end of solve()
+                std::size_t peak_bytes_{0};
+                std::uint64_t allocations_{0};
+                double allocation_rate_{0};      // allocations per second
+
+                void add(const MemoryUsage &m)
+                {
+                    live_bytes_ = std::max(live_bytes_, m.live_bytes_);
+                    peak_bytes_ = std::max(peak_bytes_, m.peak_bytes_);
+                    allocations_ += m.allocations_;
+                    allocation_rate_ = std::max(allocation_rate_, m.allocation_rate_);
+                };
+            };
+
+            /** \brief Performance counters of the last call to solve() */
+            struct Statistics
+            {
+                PhaseTime root_;           // planning the root
+                PhaseTime low_level_;      // every low-level replan (calcNewPath_)
+                PhaseTime validation_;     // validating the plans of nodes
+                PhaseTime constraints_;    // creating constraints
+                PhaseTime queue_;          // open list operations
+                PhaseTime merge_;          // composing and solving meta-agents
+                PhaseTime classification_; // classifying the conflicts of expanded nodes
+                unsigned int nodes_generated_{0};
+                unsigned int nodes_expanded_{0};
+                unsigned int low_level_failures_{0};
+                unsigned int requeues_{0};  // failed nodes that were replanned and queued again
+                unsigned int duplicates_pruned_{0};  // children whose constraint sets were already in the tree
+                unsigned int solutions_{0};  // improving solutions found in anytime mode
+                unsigned int nodes_pruned_{0};  // nodes left once the incumbent met the lower bound of every plan (anytime mode)
+                unsigned int cardinal_{0};       // expansions that branched on a cardinal conflict (with classification)
+                unsigned int semi_cardinal_{0};
+                unsigned int non_cardinal_{0};
+                std::size_t peak_queue_size_{0};
+                std::vector<unsigned int> constraints_per_agent_;
+                std::vector<unsigned int> portfolio_wins_;  // replans won by the agent's planner, then by every member (see setPortfolio)
+                unsigned int nodes_compressed_{0};  // queued nodes whose plans were dropped for the memory budget
+                std::size_t peak_queue_bytes_{0};   // estimated peak memory of the plans held by queued nodes
+                std::size_t peak_rss_bytes_{0};     // peak resident memory of the process, by the end of solve()
+                unsigned int nodes_sent_{0};      // queued nodes given to other ranks (distributed search)
+                unsigned int nodes_received_{0};  // nodes stolen from other ranks and queued here
+                // per alloc::Subsystem. The counters are those of the process, so they include the planners running alongside
+                std::array<MemoryUsage, alloc::NUM_SUBSYSTEMS> memory_;
+
+                void add(const Statistics &s)
+                {
+                    root_.add(s.root_);
+                    low_level_.add(s.low_level_);
+                    validation_.add(s.validation_);
+                    constraints_.add(s.constraints_);
+                    queue_.add(s.queue_);
+                    merge_.add(s.merge_);
+                    classification_.add(s.classification_);
+                    nodes_generated_ += s.nodes_generated_;
+                    nodes_expanded_ += s.nodes_expanded_;
+                    low_level_failures_ += s.low_level_failures_;
+                    requeues_ += s.requeues_;
+                    duplicates_pruned_ += s.duplicates_pruned_;
+                    solutions_ += s.solutions_;
+                    nodes_pruned_ += s.nodes_pruned_;
+                    cardinal_ += s.cardinal_;
+                    semi_cardinal_ += s.semi_cardinal_;
+                    non_cardinal_ += s.non_cardinal_;
+                    peak_queue_size_ = std::max(peak_queue_size_, s.peak_queue_size_);
+                    nodes_compressed_ += s.nodes_compressed_;
+                    peak_queue_bytes_ = std::max(peak_queue_bytes_, s.peak_queue_bytes_);
+                    peak_rss_bytes_ = std::max(peak_rss_bytes_, s.peak_rss_bytes_);
+                    nodes_sent_ += s.nodes_sent_;
+                    nodes_received_ += s.nodes_received_;
+                    for (std::size_t m = 0; m < memory_.size(); m++)
+                        memory_[m].add(s.memory_[m]);
+                    if (constraints_per_agent_.size() < s.constraints_per_agent_.size())
+                        constraints_per_agent_.resize(s.constraints_per_agent_.size(), 0);
+                    for (std::size_t a = 0; a < s.constraints_per_agent_.size(); a++)
+                        constraints_per_agent_[a] += s.constraints_per_agent_[a];
+                    if (portfolio_wins_.size() < s.portfolio_wins_.size())
+                        portfolio_wins_.resize(s.portfolio_wins_.size(), 0);
+                    for (std::size_t m = 0; m < s.portfolio_wins_.size(); m++)
+                        portfolio_wins_[m] += s.portfolio_wins_[m];
+                };
+            };
+
+            const Statistics& getStatistics() const {return stats_;};
+
             void setMergeBound(int b) {B_ = b;};
 
+            /** \brief Set the time (seconds) of a low-level call. With adaptive budgets, it is the largest budget of a replan */
             void setLowLevelPlanningTime(const double t) {mp_comp_time_ = t;};
 
+            /** \brief Give every low-level replan an adaptive budget instead of the low-level planning time: initial seconds at
+                first, then a high quantile of the times of the past replans of its agent under as many constraints (see
+                utils/ReplanBudget.h), doubled with every failed attempt on its node (which also replaces the pending replan
+                slice). The budget never exceeds the low-level planning time, and every replan still stops with solve().
+                0 to disable */
+            void setAdaptiveLowLevelTime(const double initial) {adaptive_budget_ = (initial > 0); budget_.setInitial(initial);};
+
+            double getAdaptiveLowLevelTime() const {return adaptive_budget_ ? budget_.getInitial() : 0;};
+
+            /** \brief Set the number of threads used to compute the root plan and to replan the children of an expanded node.
+                With more than one thread, every child is replanned on its own clone of the low-level planner. */
+            void setNumThreads(const unsigned int n) {num_threads_ = (n > 0) ? n : 1;};
+
+            unsigned int getNumThreads() const {return num_threads_;};
+
+            /** \brief Bound the (estimated) memory of the plans held by the queued nodes. Beyond it, the queued nodes with the
+                highest costs are compressed to their constraints: they share the plan of their parent, and their constrained
+                agent is replanned once they are popped (as with lazy expansion). 0 for no bound */
+            void setMemoryBudget(const std::size_t bytes) {memory_budget_ = bytes;};
+
+            std::size_t getMemoryBudget() const {return memory_budget_;};
+
+            /** \brief Pipeline the low-level replans: up to depth replans run on getNumThreads() worker threads while the
+                main loop validates and expands the nodes whose replans completed (through the open list, so by cost).
+                Bypassing is not available while pipelining. 0 replans every child before the next node is popped */
+            void setPipelineDepth(const unsigned int depth) {pipeline_depth_ = depth;};
+
+            unsigned int getPipelineDepth() const {return pipeline_depth_;};
+
+            /** \brief Collect the pipelined replans in the order they were submitted rather than as they complete, so the 
+                order of the search does not depend on the timing of the threads */
+            void setPipelineOrdered(const bool b) {pipeline_ordered_ = b;};
+
+            bool getPipelineOrdered() const {return pipeline_ordered_;};
+
+            /** \brief Search as one rank of a distributed K-CBS (see utils/SearchCluster.h). Every rank plans the root with its 
+                own low-level planners, and only rank 0 queues it. A rank whose queue runs empty steals nodes from the rank 
+                with the largest queue, which gives away every other node after its front. Nodes travel as their constraints,
+                and the thief replans their constrained agents from its own root. The cost of the best solution of any rank
+                prunes the search of every rank, and rank 0 publishes it. The nodes below a merge are not given away (the
+                meta-agent only exists on the rank that merged it), and duplicates are only detected within a rank.
+                Independence detection is not used by a distributed search, and resolve() searches alone. nullptr to search
+                alone */
+            void setCluster(const std::shared_ptr<SearchCluster> &cluster) {cluster_ = cluster;};
+
+            std::shared_ptr<SearchCluster> getCluster() const {return cluster_;};
+
+            /** \brief Write the state of the search to filename every interval seconds of solve(), and when it runs out of
+                time: the plans and constraints of the queued nodes (and of the nodes waiting for a replan), the best
+                solution of an anytime search, and the counters and seed sequence of the search. The meta-agents of a node are
+                written with it. An empty filename (or an interval <= 0) disables checkpoints */
+            void setCheckpoint(const std::string &filename, const double interval) {checkpoint_file_ = filename; checkpoint_interval_ = interval;};
+
+            const std::string &getCheckpointFile() const {return checkpoint_file_;};
+
+            double getCheckpointInterval() const {return checkpoint_interval_;};
+
+            /** \brief Continue the search saved in the checkpoint filename (of the same problem and settings) until ptc. The nodes
+                that were waiting for a replan are replanned once they are popped, as lazy nodes. Solves from scratch if there 
+                is no valid checkpoint */
+            base::PlannerStatus resumeCheckpoint(const std::string &filename, const base::PlannerTerminationCondition &ptc);
+
+            /** \brief Largest number of nodes given away per steal */
+            void setStealBatch(const unsigned int n) {steal_batch_ = (n > 0) ? n : 1;};
+
+            unsigned int getStealBatch() const {return steal_batch_;};
+
+            /** \brief Set the suboptimality factor w of the focal search. Nodes whose cost is within w times the
+                minimum cost are expanded in order of fewest conflicting pairs. With w <= 1, K-CBS is best-first. */
+            void setSuboptimalityFactor(const double w) {focal_w_ = w;};
+
+            double getSuboptimalityFactor() const {return focal_w_;};
+
+            /** \brief Set the time slice (seconds) of the first replanning attempt of a node whose low-level planner failed.
+                Every further attempt for that node doubles its slice, up to the low-level planning time. */
+            void setPendingReplanSlice(const double t) {pending_slice_ = t;};
+
+            double getPendingReplanSlice() const {return pending_slice_;};
+
+            /** \brief Replan the nodes whose low-level planner failed on a background thread, while the frontier keeps expanding */
+            void setBackgroundPendingReplans(const bool b) {background_pending_ = b;};
+
+            bool getBackgroundPendingReplans() const {return background_pending_;};
+
+            /** \brief Detect independent groups of agents before searching. Agents whose root plans do not conflict are split 
+                into groups, and every group that contains a conflict is solved by its own K-CBS (up to getNumThreads() at a time), 
+                with the plans of all other agents fixed. Groups whose solutions conflict are merged and solved again. */
+            void setIndependenceDetection(const bool b) {independence_detection_ = b;};
+
+            bool getIndependenceDetection() const {return independence_detection_;};
+
+            /** \brief Number of nodes expanded during the last call to solve() */
+            unsigned int getNumExpansions() const {return num_expansions_;};
+
             // void resetComputationTime() {computation_time_ = 0;};
 
             double getComputationTime() const {return computation_time_;};
 
             double getSolutionSOC() const {return soc_;};
 
-            // void performBypassing() {bypass_ = true;};
+            /** \brief Largest number of conflict-tree nodes alive during the last call to solve() */
+            std::size_t getPeakNodeCount() const {return node_arena_.getPeakSize();};
+
+            /** \brief Largest number of bytes reserved for conflict-tree nodes during the last call to solve() */
+            std::size_t getPeakNodeBytes() const {return node_arena_.getPeakBytes();};
+
+            /** \brief Let an expanded node adopt the plan of a child that has no higher cost and fewer conflicts (instead of branching) */
+            void performBypassing() {bypass_ = true;};
+
+            void setBypassing(const bool b) {bypass_ = b;};
+
+            bool getBypassing() const {return bypass_;};
+
+            /** \brief Online re-planning: replace the start of agent. The low-level tree of agent is cleared, the next call to
+                resolve() re-plans agent, and keeps the trajectories and low-level trees of the agents whose start did not change.
+                Returns false, and changes nothing, if agent is not an agent of the (set-up) planner or start is null. */
+            bool updateStart(const int agent, const base::State *start);
+
+            /** \brief Solve again after updateStart(), reusing the last solution. Constraints of the last solution stay in place,
+                unless their constraining agent changed, and only the agents that changed are planned anew for the root. Falls back
+                to solve() if there is no previous solution. Independence detection is not used when resolving. */
+            base::PlannerStatus resolve(const base::PlannerTerminationCondition &ptc);
+
+            /** \brief Only resolve conflicts within the first t seconds of the plan (receding horizon). The plan validity checker 
+                ignores conflicts after the window, and constraints that begin after it are not given to the low-level planners.
+                A solution is then only conflict-free inside the window. The window is infinite by default. */
+            void setConflictWindow(const double t) {conflict_window_ = t;};
+
+            double getConflictWindow() const {return conflict_window_;};
+
+            /** \brief Keep searching after the first solution, until the termination condition is met or no node is left.
+                Every cheaper conflict-free plan is published to the problem definitions of the robots as it is found. A low-level replan may
+                be cheaper than the trajectory it replaces, so the cost of a node bounds nothing below it: the search only stops early once
+                the incumbent meets the sum of the lower bounds of the agents (see MultiRobotProblemDefinition::getCostLowerBound), which
+                bounds every plan of the tree. The groups of independence detection stop at their first solution. */
+            void setAnytime(const bool b) {anytime_ = b;};
+
+            bool getAnytime() const {return anytime_;};
+
+            /** \brief Defer the replanning of children until they are popped. Children are queued with the plan (and cost) of
+                their parent as an optimistic estimate, so children that never reach the front of the queue are never replanned.
+                Bypassing needs the plans of the children, so it is skipped in lazy mode. */
+            void setLazyExpansion(const bool b) {lazy_ = b;};
+
+            bool getLazyExpansion() const {return lazy_;};
+
+            /** \brief Prune children whose constraint sets (per agent) were already generated in the conflict tree, before they
+                are replanned. Constraints are compared by their hashes, with times and belief states rounded to getDuplicateResolution(). */
+            void setDuplicateDetection(const bool b) {duplicate_detection_ = b;};
+
+            bool getDuplicateDetection() const {return duplicate_detection_;};
+
+            /** \brief Split a conflict disjointly instead of constraining both agents: the first agent of the conflict either
+                stays in the region of its plan over the conflict (a positive constraint, see createRegionConstraint), and the
+                other agent has to avoid it there, or it has to leave that region. The low-level planners sample around the
+                regions of their positive constraints. Only with validators that support it, symmetric splitting otherwise */
+            void setDisjointSplitting(const bool b) {disjoint_splitting_ = b;};
+
+            bool getDisjointSplitting() const {return disjoint_splitting_;};
+
+            void setDuplicateResolution(const double r) {duplicate_resolution_ = (r > 0) ? r : duplicate_resolution_;};
+
+            double getDuplicateResolution() const {return duplicate_resolution_;};
+
+            /** \brief Validate the plans of nodes in search of every conflict interval (of every pair), instead of stopping at the
+                first interval of each pair. The intervals are kept on the node (see KCBSNode::getConflictIntervals), and the
+                children only re-check the pairs of their constrained agent. */
+            void setAllConflicts(const bool b) {all_conflicts_ = b;};
+
+            bool getAllConflicts() const {return all_conflicts_;};
+
+            /** \brief Branch on cardinal conflicts first (both children likely cost more), then on semi-cardinal ones, instead
+                of the earliest conflict. Classification finds every conflict interval of a node (see setAllConflicts), and
+                probes the low-level trees (ConstraintRespectingPlanner::hasPathWithin) for a path of an agent that avoids the
+                new constraint without taking longer. Agents whose planner keeps no tree never raise the cost. */
+            void setConflictClassification(const bool b) {conflict_classification_ = b;};
+
+            bool getConflictClassification() const {return conflict_classification_;};
+
+            /** \brief Number of conflict intervals of a node that are classified (in order) before branching */
+            void setClassificationLimit(const unsigned int n) {classification_limit_ = (n > 0) ? n : 1;};
+
+            unsigned int getClassificationLimit() const {return classification_limit_;};
+
+            /** \brief Number of bypasses (adopted child plans) during the last call to solve() */
+            unsigned int getNumBypasses() const {return num_bypasses_;};
+
+            /** \brief Number of child nodes that were not added to the conflict tree because of bypassing */
+            unsigned int getNumBypassedNodes() const {return num_bypassed_nodes_;};
+
+            /** \brief The meta-agents formed during the last call to solve() (their agents, in increasing order), in the order
+                they were merged. A meta-agent only exists on the branches below the node that merged it */
+            std::vector<std::vector<int>> getMergers() const {return merger_count_;};
+
+            /** \brief Number of conflicts found between agent1 and agent2 */
+            int getConflictCount(const int agent1, const int agent2) const;
+
+            /** \brief Symmetric matrix with the number of conflicts found between every pair of agents */
+            std::vector<std::vector<int>> getConflictCounter() const;
+
+            /** \brief Largest number of conflicts found between a single pair of agents */
+            int getMaxConflictCount() const {return max_conflicts_;};
+
+            /** \brief One event of a search, in the replay log */
+            struct ReplayEvent
+            {
+                std::string event_;   // root, expand, replan, pending or merge
+                int node_;            // id of the conflict-tree node, in order of creation (-1 for the root plans)
+                int agent_;           // planned agent (-1 for expansions)
+                std::uint32_t seed_;  // seed of the low-level call (0 if unseeded)
+            };
+
+            /** \brief Seed every low-level call of solve() from seed, instead of OMPL's global sequence: the root plan of agent
+                a from derive(seed, a), and the n-th replan of the search from derive(seed, agents + n) (see utils/Seeding.h).
+                The seeds do not depend on the threads, but the order of the replans does, so with one thread (and the same
+                low-level terminations) a search is repeated exactly. 0 keeps OMPL's seeds */
+            void setSeed(const std::uint32_t seed) {seed_ = seed;};
+
+            std::uint32_t getSeed() const {return seed_;};
+
+            /** \brief Replay log of the last call to solve(): the expanded nodes and the seed of every low-level call, in order */
+            const std::vector<ReplayEvent> &getReplayLog() const {return replay_;};
 
-            // std::vector<std::pair<int, int>> getMergers() const {return merger_count_;};
+            /** \brief Write the replay log as CSV (event, node, agent, seed), after a comment with the seed of the search */
+            bool writeReplayLog(const std::string &filename) const;
+
+            /** \brief An event of a running search (see setProgressCallback) */
+            struct ProgressEvent
+            {
+                enum Type {NODE_EXPANDED, CONFLICT_FOUND, LOW_LEVEL_SOLVED, LOW_LEVEL_FAILED, INCUMBENT_IMPROVED};
+
+                Type type_;
+                int node_;     // id of the conflict-tree node (-1 for the low-level calls)
+                int agent_;    // planned agent, first agent of a conflict (-1 for the rest and the root plans)
+                int other_;    // second agent of a conflict (-1 otherwise)
+                double value_; // cost of the node (expanded, incumbent), time of the conflict, seconds of the low-level call
+                double time_;  // seconds since the start of solve()
+            };
+
+            /** \brief Called with every event of solve(), on a thread of its own. A false return stops the search, as its
+                termination condition would */
+            typedef std::function<bool(const ProgressEvent &)> ProgressCallback;
+
+            /** \brief Report the events of solve() to callback. The search threads push them to a lock-free queue of
+                capacity events (see utils/EventQueue.h) and never wait for the callback: the events past a full queue are
+                dropped (and counted). The groups of independence detection are not reported. nullptr to report nothing */
+            void setProgressCallback(const ProgressCallback &callback, const std::size_t capacity = 4096)
+            {
+                progress_callback_ = callback;
+                progress_capacity_ = capacity;
+            };
+
+            /** \brief Events of the last call to solve() that found the queue of the callback full */
+            std::size_t getDroppedProgressEvents() const {return progress_dropped_;};
+
+            /** \brief A low-level planner that races the planner of an agent (see setPortfolio) */
+            struct PortfolioMember
+            {
+                std::string planner_;                         // BSST or RRT
+                std::map<std::string, std::string> params_;   // set over the parameters of the agent's planner
+                unsigned int races_{0};
+                unsigned int wins_{0};
+            };
+
+            /** \brief Race the planner of the agent against the members of portfolio on every replan with new constraints, each on
+                its own thread and clone of the problem, and keep the first valid path. The others are stopped through their
+                termination condition. The wins are counted per member (and in getStatistics()), empty to plan alone */
+            void setPortfolio(const std::vector<PortfolioMember> &portfolio) {portfolio_ = portfolio;};
+
+            const std::vector<PortfolioMember> &getPortfolio() const {return portfolio_;};
+
+            /** \brief Number of planners in a race, the agent's planner and the members with the best win rates
+                (an untried member counts as winning half its races), 0 for every member */
+            void setPortfolioWidth(const unsigned int w) {portfolio_width_ = w;};
+
+            unsigned int getPortfolioWidth() const {return portfolio_width_;};
+
+            /** \brief The members of spec "PLANNER[:param=value,...];..." (e.g. "BSST:selection_radius=0.5;RRT:goal_bias=0.2").
+                False if spec is invalid */
+            static bool parsePortfolio(const std::string &spec, std::vector<PortfolioMember> &portfolio);
 
         protected:
             /** \brief Representation of a conflict node
@@ -86,58 +482,299 @@ namespace ompl
             class KCBSNode
             {
             public:
+                /* trajectories are immutable once stored, so nodes can share them */
+                typedef DiscretePlan::TrajectoryPtr TrajectoryPtr;
+
+                /* persistent list of the constraints on one agent. Children extend the list of their parent */
+                struct ConstraintList
+                {
+                    ConstraintPtr constraint_;
+                    std::shared_ptr<const ConstraintList> next_;
+                    std::size_t size_;
+                    std::size_t hash_;  // order independent hash of the constraints in the list
+                };
+                typedef std::shared_ptr<const ConstraintList> ConstraintListPtr;
+
+                /* the constraints of a list (newest first), iterated in place. It holds the head, so the list outlives the
+                   node (e.g. on a worker thread) */
+                struct ConstraintRange
+                {
+                    class iterator
+                    {
+                    public:
+                        typedef std::forward_iterator_tag iterator_category;
+                        typedef ConstraintPtr value_type;
+                        typedef std::ptrdiff_t difference_type;
+                        typedef const ConstraintPtr* pointer;
+                        typedef const ConstraintPtr& reference;
+
+                        explicit iterator(const ConstraintList *l = nullptr): l_(l) {}
+
+                        reference operator*() const {return l_->constraint_;};
+                        pointer operator->() const {return &l_->constraint_;};
+                        iterator &operator++() {l_ = l_->next_.get(); return *this;};
+                        iterator operator++(int) {iterator prev = *this; ++*this; return prev;};
+                        bool operator==(const iterator &other) const {return l_ == other.l_;};
+                        bool operator!=(const iterator &other) const {return l_ != other.l_;};
+
+                    private:
+                        const ConstraintList *l_;
+                    };
+
+                    iterator begin() const {return iterator(head_.get());};
+                    iterator end() const {return iterator();};
+                    std::size_t size() const {return head_ ? head_->size_ : 0;};
+                    bool empty() const {return !head_;};
+                    // the newest constraint (that of the node, if it constrains the agent)
+                    const ConstraintPtr &front() const {return head_->constraint_;};
+
+                    ConstraintListPtr head_;
+                };
+
                 int id=-1;
                 KCBSNode(){};
 
                 KCBSNode(KCBSNode const &n)
                 {
-                    // create a copy of conflict node
+                    // create a (shallow) copy of conflict node
                     this->id = n.id;
-                    this->plan_ = n.getPlan();
+                    this->trajs_ = n.trajs_;
+                    this->discrete_plan_ = n.discrete_plan_;
+                    this->traj_costs_ = n.traj_costs_;
                     this->parent_ = n.getParent();
                     this->cost_ = n.getCost();
                     this->constraint_ = n.getConstraint();
                     this->planner_ = n.getPlanner();
+                    this->agent_constraints_ = n.agent_constraints_;
+                    this->meta_agents_ = n.meta_agents_;
+                    this->validation_ = n.validation_;
+                    this->conflicts_ = n.conflicts_;
+                    this->intervals_ = n.intervals_;
+                    this->num_conflicts_ = n.num_conflicts_;
+                    this->validated_ = n.validated_;
+                    this->replan_attempts_ = n.replan_attempts_;
+                    this->lazy_ = n.lazy_;
                 }
 
                 ~KCBSNode()
                 {
-                    // motions_.clear();
-                    plan_.clear();
-                    // delete constraint_;
-                    // constraint_ = nullptr;
+                    trajs_.clear();
                 }
 
                 // update plan and cost at same time to avoid bad bookkeeping
                 void updatePlanAndCost(Plan &p)
                 {
-                    plan_ = p; 
-                    double total = 0;
-                    for (PathControl traj: plan_)
+                    trajs_.clear();
+                    traj_costs_.clear();
+                    cost_ = 0;
+                    validated_ = false;
+                    lazy_ = false;
+                    std::vector<TrajectoryPtr> discrete;
+                    for (PathControl &traj: p)
                     {
-                        const std::vector<double> times = traj.getControlDurations();
-                        for (double dt: times)
-                            total += dt;
+                        trajs_.push_back(std::make_shared<const PathControl>(traj));
+                        discrete.push_back(DiscretePlan::discretize(trajs_.back()));
+                        traj_costs_.push_back(trajectoryCost_(traj));
+                        cost_ += traj_costs_.back();
                     }
-                    cost_ = total;
+                    discrete_plan_ = DiscretePlan(std::move(discrete));
+                };
+
+                // share every trajectory of n, except for that of agent
+                void updatePlanAndCost(const KCBSNode *n, const int agent, const PathControl &traj)
+                {
+                    // only the cost of agent changed. n may be this node, so the rest is read before it is overwritten
+                    const double rest = n->cost_ - n->traj_costs_[agent];
+                    trajs_ = n->trajs_;
+                    traj_costs_ = n->traj_costs_;
+                    trajs_[agent] = std::make_shared<const PathControl>(traj);
+                    discrete_plan_ = n->discrete_plan_.replace(agent, DiscretePlan::discretize(trajs_[agent]));
+                    traj_costs_[agent] = trajectoryCost_(traj);
+                    validated_ = false;
+                    lazy_ = false;
+                    cost_ = rest + traj_costs_[agent];
+                };
+
+                // share every trajectory of n, except for those of agents (e.g. the split plan of a meta-agent)
+                void updatePlanAndCost(const KCBSNode *n, const std::vector<int> &agents, const std::vector<PathControl> &trajs)
+                {
+                    double rest = n->cost_;
+                    for (const int agent: agents)
+                        rest -= n->traj_costs_[agent];
+                    DiscretePlan discrete = n->discrete_plan_;
+                    trajs_ = n->trajs_;
+                    traj_costs_ = n->traj_costs_;
+                    cost_ = rest;
+                    for (std::size_t i = 0; i < agents.size(); i++) {
+                        const int agent = agents[i];
+                        trajs_[agent] = std::make_shared<const PathControl>(trajs[i]);
+                        discrete = discrete.replace(agent, DiscretePlan::discretize(trajs_[agent]));
+                        traj_costs_[agent] = trajectoryCost_(trajs[i]);
+                        cost_ += traj_costs_[agent];
+                    }
+                    discrete_plan_ = std::move(discrete);
+                    validated_ = false;
+                    lazy_ = false;
                 };
 
                 void printPlan()
                 {
-                    for (int r = 0; r < plan_.size(); r++) {
+                    for (int r = 0; r < trajs_.size(); r++) {
                        std::cout << "Agent " << r << std::endl;
-                       plan_[r].print(std::cout);
+                       trajs_[r]->print(std::cout);
                     }
                 }
 
-                // update parent node
-                void updateParent(const KCBSNode *n) {parent_ = n;};
+                // update parent node, whose meta-agents the node keeps
+                void updateParent(const KCBSNode *n)
+                {
+                    parent_ = n;
+                    meta_agents_ = n->meta_agents_;
+                };
 
-                // add constraint
-                void addConstraint(ConstraintPtr constraint) {constraint_ = constraint;};
+                // whether agent is part of a meta-agent of the branch (planned jointly with others, so it is never constrained)
+                bool isMerged(const int agent) const {return meta_agents_ && (*meta_agents_)[agent] >= 0;};
 
-                // get the plan, but cannot change it
-                Plan getPlan() const {return plan_;};
+                // whether agents were merged on the branch to this node
+                bool hasMetaAgents() const {return meta_agents_ != nullptr;};
+
+                // the agents planned jointly with agent, itself included (in increasing order)
+                std::vector<int> getMetaAgent(const int agent) const
+                {
+                    if (!isMerged(agent))
+                        return {agent};
+                    std::vector<int> agents;
+                    for (int a = 0; a < meta_agents_->size(); a++) {
+                        if ((*meta_agents_)[a] == (*meta_agents_)[agent])
+                            agents.push_back(a);
+                    }
+                    return agents;
+                };
+
+                // take the meta-agents of n, with agents (of num_agents) merged into one (e.g. a meta-agent and another agent)
+                void mergeMetaAgents(const KCBSNode *n, const std::vector<int> &agents, const std::size_t num_agents)
+                {
+                    auto meta = n->meta_agents_ ? std::make_shared<std::vector<int>>(*n->meta_agents_) : 
+                        std::make_shared<std::vector<int>>(num_agents, -1);
+                    const int id = *std::min_element(agents.begin(), agents.end());
+                    for (const int agent: agents)
+                        (*meta)[agent] = id;
+                    meta_agents_ = meta;
+                };
+
+                // the meta-agent of every agent (its lowest agent, -1 if it is planned alone), nullptr if none was merged
+                const std::shared_ptr<const std::vector<int>> &getMetaAgents() const {return meta_agents_;};
+
+                void setMetaAgents(std::shared_ptr<const std::vector<int>> meta) {meta_agents_ = std::move(meta);};
+
+                // add constraint (must be called after updateParent). hash is the hash of the constraint (see getConstraintSetHash)
+                void addConstraint(ConstraintPtr constraint, const std::size_t hash = 0)
+                {
+                    constraint_ = constraint;
+                    if (parent_)
+                        agent_constraints_ = parent_->agent_constraints_;
+                    seedConstraint(constraint, hash);
+                };
+
+                // add a constraint to the branch without making it the constraint of the node (e.g. on a root node)
+                void seedConstraint(ConstraintPtr constraint, const std::size_t hash = 0)
+                {
+                    const int agent = constraint->getConstrainedAgent();
+                    if (agent_constraints_.size() <= agent)
+                        agent_constraints_.resize(agent + 1, nullptr);
+                    const ConstraintListPtr &prev = agent_constraints_[agent];
+                    agent_constraints_[agent] = std::make_shared<const ConstraintList>(
+                        ConstraintList{constraint, prev, prev ? prev->size_ + 1 : 1, (prev ? prev->hash_ : 0) + mix_(hash)});
+                };
+
+                // hash of the constraint multiset of every agent, as if a constraint with hash extra was added on agent (if agent >= 0)
+                std::size_t getConstraintSetHash(const int agent = -1, const std::size_t extra = 0) const
+                {
+                    if (agent < 0)
+                        return getConstraintSetHash(std::vector<std::pair<int, std::size_t>>());
+                    return getConstraintSetHash(std::vector<std::pair<int, std::size_t>>{{agent, extra}});
+                };
+
+                // hash of the constraint multiset of every agent, as if the constraints of extra (agent, hash) were added, so
+                // the hash of a child is known before it is made (e.g. with the companion of a disjoint split)
+                std::size_t getConstraintSetHash(const std::vector<std::pair<int, std::size_t>> &extra) const
+                {
+                    std::size_t seed = 0;
+                    std::size_t n = agent_constraints_.size();
+                    for (const auto &e: extra)
+                        n = std::max<std::size_t>(n, e.first + 1);
+                    for (std::size_t a = 0; a < n; a++) {
+                        const ConstraintList *l = (a < agent_constraints_.size()) ? agent_constraints_[a].get() : nullptr;
+                        std::size_t h = l ? l->hash_ : 0;
+                        std::size_t size = l ? l->size_ : 0;
+                        for (const auto &e: extra) {
+                            if (e.first == static_cast<int>(a)) {
+                                h += mix_(e.second);
+                                size++;
+                            }
+                        }
+                        if (size == 0)
+                            continue;
+                        boost::hash_combine(seed, a);
+                        boost::hash_combine(seed, size);
+                        boost::hash_combine(seed, h);
+                    }
+                    return seed;
+                };
+
+                // take the constraints of n, except for those on the dropped agents (who are now planned jointly)
+                void inheritConstraints(const KCBSNode *n, const std::vector<int> &dropped)
+                {
+                    agent_constraints_ = n->agent_constraints_;
+                    for (const int agent: dropped) {
+                        if (agent < agent_constraints_.size())
+                            agent_constraints_[agent] = nullptr;
+                    }
+                };
+
+                // every constraint on agent along the branch to this node (newest first), without copying the list
+                ConstraintRange getAgentConstraints(const int agent) const
+                {
+                    if (agent >= agent_constraints_.size())
+                        return {};
+                    return {agent_constraints_[agent]};
+                };
+
+                // get a (deep) copy of the plan
+                Plan getPlan() const
+                {
+                    Plan p;
+                    for (const TrajectoryPtr &traj: trajs_)
+                        p.push_back(*traj);
+                    return p;
+                };
+
+                // get the interpolated plan (shared with the nodes that have the same trajectories), which the validator reads
+                const DiscretePlan& getDiscretePlan() const {return discrete_plan_;};
+
+                // get the trajectory of a single agent, but cannot change it
+                const PathControl& getTrajectory(const int agent) const {return *trajs_[agent];};
+
+                // the shared trajectory of agent (to tell apart the trajectories that nodes share)
+                const TrajectoryPtr& getTrajectoryPtr(const int agent) const {return trajs_[agent];};
+
+                // number of trajectories of the node (0 until its plan is set)
+                std::size_t getNumTrajectories() const {return trajs_.size();};
+
+                // share the trajectories trajs, whose interpolations are discrete (e.g. when restoring a checkpoint)
+                void setPlan(const std::vector<TrajectoryPtr> &trajs, const std::vector<TrajectoryPtr> &discrete)
+                {
+                    trajs_ = trajs;
+                    traj_costs_.clear();
+                    cost_ = 0;
+                    for (const TrajectoryPtr &traj: trajs_) {
+                        traj_costs_.push_back(trajectoryCost_(*traj));
+                        cost_ += traj_costs_.back();
+                    }
+                    discrete_plan_ = DiscretePlan(discrete);
+                    validated_ = false;
+                    lazy_ = false;
+                };
 
                 // get the parent, but no not change it
                 const KCBSNode* getParent() const {return parent_;};
@@ -145,6 +782,8 @@ namespace ompl
                 // get the cost, but do not alter it
                 const double getCost() const {return cost_;};
 
+                double getTrajectoryCost(const int agent) const {return traj_costs_[agent];};
+
                 // get the constraint within a node
                 ConstraintPtr getConstraint() const {return constraint_;};
 
@@ -154,19 +793,111 @@ namespace ompl
 
                 PlannerPtr getPlanner() const {return planner_;};
 
-                // void fillMotions(std::vector<ConstraintRRT::Motion*> newMotions)
-                // {
-                //     motions_ = newMotions;
-                // };
+                // number of times the saved planner failed to replan
+                unsigned int getReplanAttempts() const {return replan_attempts_;};
 
-                // const std::vector<ConstraintRRT::Motion*> getMotions() const
-                // {
-                //     return motions_;
-                // };
+                void countReplanAttempt() {replan_attempts_++;};
+
+                // take the plan (and its validation) of n, keeping the constraints of this node
+                void adoptPlan(const KCBSNode *n)
+                {
+                    trajs_ = n->trajs_;
+                    discrete_plan_ = n->discrete_plan_;
+                    traj_costs_ = n->traj_costs_;
+                    cost_ = n->cost_;
+                    validation_ = n->validation_;
+                    conflicts_ = n->conflicts_;
+                    intervals_ = n->intervals_;
+                    num_conflicts_ = n->num_conflicts_;
+                    validated_ = n->validated_;
+                };
+
+                // save the pairwise validation results of the plan
+                void saveValidationCache(std::shared_ptr<const PlanValidityChecker::ValidationCache> cache) {validation_ = cache;};
+
+                std::shared_ptr<const PlanValidityChecker::ValidationCache> getValidationCache() const {return validation_;};
+
+                // save the first conflict interval of the plan and the number of conflicting pairs
+                void saveConflicts(const std::vector<ConflictPtr> &confs, const int num_conflicts)
+                {
+                    conflicts_ = confs;
+                    num_conflicts_ = num_conflicts;
+                    validated_ = true;
+                };
+
+                const std::vector<ConflictPtr>& getConflicts() const {return conflicts_;};
+
+                // save every conflict interval of the plan (ordered by first step), if it was validated for all of them
+                void saveConflictIntervals(std::shared_ptr<const std::vector<std::vector<ConflictPtr>>> intervals) {intervals_ = intervals;};
+
+                // every conflict interval of the plan, or nullptr if only the first one is known
+                std::shared_ptr<const std::vector<std::vector<ConflictPtr>>> getConflictIntervals() const {return intervals_;};
+
+                int getNumConflicts() const {return num_conflicts_;};
+
+                bool isValidated() const {return validated_;};
+
+                // the plan changed, so it must be validated again
+                void invalidate() {validated_ = false;};
+
+                // the node holds the plan of its parent, and its constrained agent must be replanned once it is popped
+                void markLazy() {lazy_ = true;};
+
+                // drop the plan of the node for that of its parent (as a lazy node), but keep its cost and number of conflicts,
+                // which order it in the open list
+                void compress()
+                {
+                    trajs_ = parent_->trajs_;
+                    discrete_plan_ = parent_->discrete_plan_;
+                    traj_costs_ = parent_->traj_costs_;
+                    validation_ = nullptr;
+                    conflicts_.clear();
+                    conflicts_.shrink_to_fit();
+                    intervals_ = nullptr;
+                    validated_ = false;
+                    lazy_ = true;
+                };
+
+                // children were generated from the plan of the node, so it must keep it
+                void markExpanded() {expanded_ = true;};
+
+                bool isExpanded() const {return expanded_;};
+
+                // estimated bytes of the plan that the node holds on its own, while it is queued
+                void setQueuedBytes(const std::size_t bytes) {queued_bytes_ = bytes;};
+
+                std::size_t getQueuedBytes() const {return queued_bytes_;};
+
+                bool isLazy() const {return lazy_;};
 
             private:
-                /** The state contained by the motion */
-                Plan plan_;
+                /* spread the bits of a constraint hash, so that their sum is a good hash of the multiset */
+                static std::size_t mix_(std::size_t h)
+                {
+                    h ^= h >> 33;
+                    h *= 0xff51afd7ed558ccdULL;
+                    h ^= h >> 33;
+                    h *= 0xc4ceb9fe1a85ec53ULL;
+                    h ^= h >> 33;
+                    return h;
+                }
+
+                static double trajectoryCost_(const PathControl &traj)
+                {
+                    double total = 0;
+                    for (double dt: traj.getControlDurations())
+                        total += dt;
+                    return total;
+                }
+
+                /** The trajectory of every agent */
+                std::vector<TrajectoryPtr> trajs_;
+
+                /* trajs_ interpolated to the propagation step size (built once per trajectory) */
+                DiscretePlan discrete_plan_;
+
+                /* The cost of every trajectory in trajs_ */
+                std::vector<double> traj_costs_;
 
                 /* The parent motion in the exploration tree */
                 const KCBSNode* parent_{nullptr};
@@ -179,36 +910,256 @@ namespace ompl
 
                 PlannerPtr planner_{nullptr};
 
-                /* list of motions--only filled if node fails to create plan_ */
-                // std::vector<ob::Planner::Motion*> motions_;
+                /* head of the constraint list of every agent */
+                std::vector<ConstraintListPtr> agent_constraints_;
+
+                /* the meta-agents of the branch (see getMetaAgents), shared with the nodes below until one of them merges */
+                std::shared_ptr<const std::vector<int>> meta_agents_;
+
+                /* pairwise validation results of the plan (only set once the node was validated) */
+                std::shared_ptr<const PlanValidityChecker::ValidationCache> validation_{nullptr};
+
+                /* first conflict interval of the plan */
+                std::vector<ConflictPtr> conflicts_;
+
+                /* every conflict interval of the plan (only in all-conflicts mode) */
+                std::shared_ptr<const std::vector<std::vector<ConflictPtr>>> intervals_{nullptr};
+
+                /* number of conflicting pairs (secondary heuristic of the focal search) */
+                int num_conflicts_{0};
+
+                bool validated_{false};
+
+                unsigned int replan_attempts_{0};
+
+                bool lazy_{false};
+
+                bool expanded_{false};
+
+                std::size_t queued_bytes_{0};
+            };
+
+            /** \brief Schedules the replanning of nodes whose low-level planner failed (pending nodes).
+                Pending nodes are served round-robin, and every attempt on a node gets a time slice that
+                doubles with its number of failed attempts. In background mode, a worker thread serves
+                the pending nodes while the main loop keeps expanding the finite-cost frontier. */
+            class PendingReplanScheduler
+            {
+            public:
+                typedef std::pair<KCBSNode*, std::shared_ptr<PathControl>> Result;
+
+                PendingReplanScheduler(KCBS *kcbs, const base::PlannerTerminationCondition &ptc, const bool background);
+
+                ~PendingReplanScheduler();
+
+                // add a node whose planner failed
+                void add(KCBSNode *n);
+
+                // give the next pending node one time slice (only used in the foreground)
+                void step();
+
+                // get the nodes that were successfully replanned. if wait, block briefly until one is available
+                std::vector<Result> collect(const bool wait);
+
+                // true if no node is pending, in progress, or waiting to be collected
+                bool empty();
+
+                std::size_t size();
+
+                void stop();
+
+            private:
+                std::shared_ptr<PathControl> attempt_(KCBSNode *n);
+
+                void work_();
+
+                KCBS *kcbs_;
+                const base::PlannerTerminationCondition &ptc_;
+                const bool background_;
+                std::deque<KCBSNode*> pending_;
+                std::vector<Result> ready_;
+                std::size_t in_progress_{0};
+                std::atomic<bool> stop_{false};
+                std::mutex mutex_;
+                std::condition_variable cv_;
+                std::thread worker_;
+            };
+
+            /** \brief Replans the constrained agents of new (or lazy) nodes on a pool of worker threads, so the main loop
+                keeps validating and expanding the nodes whose replans completed while others are still running. Every
+                replan runs on its own clone of the low-level planner. Replans are started in the order they are submitted,
+                and at most depth of them are outstanding. If ordered, they are also collected in that order (so the
+                search is reproducible with a seed), otherwise as soon as they complete. */
+            class ReplanPipeline
+            {
+            public:
+                typedef std::tuple<KCBSNode*, PlannerPtr, std::shared_ptr<PathControl>> Result;
+
+                ReplanPipeline(KCBS *kcbs, const base::PlannerTerminationCondition &ptc, const unsigned int threads, 
+                    const std::size_t depth, const bool ordered);
+
+                ~ReplanPipeline();
+
+                // replan the constrained agent of n, with planner (a clone of its planner) under constraints
+                void submit(KCBSNode *n, PlannerPtr planner, KCBSNode::ConstraintRange constraints);
+
+                // get the replans that completed (a null path if the planner failed). if wait, block briefly until one is available
+                std::vector<Result> collect(const bool wait);
+
+                // true if depth replans are outstanding
+                bool full();
+
+                // true if no replan is queued, running, or waiting to be collected
+                bool empty();
+
+                void stop();
+
+            private:
+                struct Job
+                {
+                    std::size_t ticket_;
+                    KCBSNode *node_;
+                    PlannerPtr planner_;
+                    KCBSNode::ConstraintRange constraints_;
+                };
+
+                void work_();
+
+                KCBS *kcbs_;
+                const base::PlannerTerminationCondition &ptc_;
+                const std::size_t depth_;
+                const bool ordered_;
+                std::deque<Job> jobs_;
+                // the completed replans by ticket
+                std::map<std::size_t, Result> done_;
+                std::size_t next_ticket_{0};
+                std::size_t next_collect_{0};
+                std::size_t outstanding_{0};
+                std::atomic<bool> stop_{false};
+                std::mutex mutex_;
+                std::condition_variable cv_;
+                std::vector<std::thread> workers_;
             };
 
             void freeMemory_();
 
             void setUp_();
 
-            oc::PathControl* calcNewPath_(PlannerPtr planner, std::vector<ConstraintPtr> constraints, bool restart = true);
+            /* plan every agent without constraints. Returns EXACT_SOLUTION if every agent has a trajectory */
+            base::PlannerStatus planRoot_(const base::PlannerTerminationCondition &ptc, Plan &root_plan);
+
+            /* the loop of independence detection: solve the dependent groups, and merge the groups that conflict */
+            base::PlannerStatus solveIndependent_(const base::PlannerTerminationCondition &ptc);
+
+            /* keep the plan and constraints of a solution for online re-planning */
+            void saveOnlineState_(const Plan &plan, const KCBSNode *n);
+
+            /* write the plan of n to the problem definitions of the agents in the group (and update the SOC) */
+            void publishSolution_(const KCBSNode *n);
+
+            /* true if agent is planned by this K-CBS */
+            bool inGroup_(const int agent) const;
+
+            /* a lock on the validator and the merger of the problem, if they are shared with other K-CBS (unlocked if not) */
+            std::unique_lock<std::mutex> lockShared_() const;
+
+            /* find the conflicts in the plan of n, reusing the validation results of its parent */
+            void validateNode_(KCBSNode *n);
+
+            /* the conflict interval of n to branch on: the first cardinal one among the first classification_limit_ intervals,
+               else the first semi-cardinal one, else the earliest one */
+            const std::vector<ConflictPtr> &selectConflict_(const KCBSNode *n);
 
-            bool shouldMerge_(
-                std::vector< std::pair< std::pair<int, int>, int> > &conf_cntr, 
-                const int agent1, const int agent2);
+            /* the hash of c for duplicate detection (0 without it) */
+            std::size_t constraintHash_(const ConstraintPtr &c) const {return duplicate_detection_ ? c->hash(duplicate_resolution_) : 0;};
 
-            // function that orders priority queue
-            struct Compare
+            /* drop the constraints (and their companions, nullptr if none) of the children of n whose constraint sets were
+               generated before, and count them as duplicates */
+            void pruneDuplicates_(const KCBSNode *n, std::vector<ConstraintPtr> &constraints, std::vector<ConstraintPtr> &companions);
+
+            /* add constraint (and its companion, if any) to child, which is hashed as pruneDuplicates_ hashed it */
+            void constrainChild_(KCBSNode *child, const ConstraintPtr &constraint, const ConstraintPtr &companion) const;
+
+            /* true if the constraint of interval on agent probably raises the cost of the child (see hasPathWithin) */
+            bool raisesCost_(const KCBSNode *n, const std::vector<ConflictPtr> &interval, const int agent);
+
+            /* replan (restarting) under constraints for the budget of its agent (see lowLevelBudget_), or until ptc */
+            oc::PathControl* calcNewPath_(PlannerPtr planner, const KCBSNode::ConstraintRange &constraints, 
+                const base::PlannerTerminationCondition &ptc);
+
+            oc::PathControl* calcNewPath_(PlannerPtr planner, const KCBSNode::ConstraintRange &constraints, bool restart, 
+                const base::PlannerTerminationCondition &ptc);
+
+            /* estimated bytes of the plan that n holds on its own: the trajectory of its constrained agent (and its interpolation),
+               every trajectory at the root, and its validation results */
+            std::size_t planBytes_(const KCBSNode *n) const;
+
+            /* write the constraints of n (oldest first), to be rebuilt by another rank. False if a constraint cannot be encoded */
+            bool encodeNode_(const KCBSNode *n, ByteWriter &out) const;
+
+            /* a node with constraints, whose constrained agents are replanned (and the others keep their trajectory of
+               root_plan, if complete). nullptr if an agent could not be replanned */
+            KCBSNode *rebuildNode_(const std::vector<ConstraintPtr> &constraints, const Plan &root_plan, const int id, 
+                const base::PlannerTerminationCondition &ptc);
+
+            /* write the queued nodes, the nodes waiting for a replan (saved as lazy nodes), the solution (or nullptr) and the
+               counters to the checkpoint file. elapsed is the time the search has run, over every resumed solve() */
+            bool writeCheckpoint_(const Plan &root_plan, const std::vector<const KCBSNode*> &queued, 
+                const std::vector<const KCBSNode*> &waiting, const KCBSNode *solution, const int count, const double elapsed);
+
+            /* restore the nodes, root plan, solution and counters of a checkpoint written by writeCheckpoint_. False (and
+               nothing is restored but nodes of the arena) if data is not a checkpoint of this problem */
+            bool readCheckpoint_(const std::string &data, Plan &root_plan, std::vector<KCBSNode*> &nodes, KCBSNode *&solution, 
+                int &count, double &elapsed);
+
+            /* seconds for a low-level call of agent under num_constraints constraints, after failures failed attempts: 
+               the low-level planning time, unless the budgets are adaptive */
+            double lowLevelBudget_(const int agent, const std::size_t num_constraints, const unsigned int failures = 0) const;
+
+            /* solve the replan of agent on planner and on clones of the portfolio members, until one of them solves it. The path
+               of a winning clone is copied to the problem definition of planner */
+            base::PlannerStatus racePortfolio_(const PlannerPtr &planner, const int agent, const std::vector<ConstraintPtr> &constraints,
+                const base::PlannerTerminationCondition &ptc);
+
+            std::size_t pairIndex_(const int agent1, const int agent2) const;
+
+            bool shouldMerge_(const int agent1, const int agent2);
+
+            /* restart the conflict count of a pair (and the running maximum) */
+            void resetConflictCount_(const int agent1, const int agent2);
+
+            /* solve the composed problem of the (meta-)agents of agent1 and agent2 in n, and return a copy of n in which they are
+               one meta-agent, with their joint plan (or nullptr) */
+            KCBSNode* mergeAgents_(const KCBSNode *n, const int agent1, const int agent2, const base::PlannerTerminationCondition &ptc);
+
+            KCBSNode* composeAgents_(const KCBSNode *n, const int agent1, const int agent2, const base::PlannerTerminationCondition &ptc);
+
+            static double elapsed_(const std::chrono::steady_clock::time_point &t0);
+
+            /* seed the low-level call of agent at node on planner (if seeded), and record it in the replay log */
+            void seedLowLevel_(const PlannerPtr &planner, const char *event, const int node, const int agent);
+
+            void recordReplay_(const char *event, const int node, const int agent, const std::uint32_t seed);
+
+            /* the search of solve(), and the events of the search to the queue of the progress callback (if any) */
+            base::PlannerStatus search_(const base::PlannerTerminationCondition &ptc);
+
+            void reportProgress_(const ProgressEvent::Type type, const int node, const int agent, const int other, const double value);
+
+            /* log n (queued, expanded or a solution) in the conflict tree of getPlannerData */
+            void recordTreeNode_(const KCBSNode *n, const bool expanded = false, const bool solution = false);
+
+            /* the clock and the hardware counters of the calling thread at the start of a phase */
+            struct PhaseStart
             {
-                bool operator()(const KCBSNode n1, const KCBSNode n2) const
-                {
-                    /* Note that the Compare parameter is defined such 
-                    that it returns true if its first argument comes before 
-                    its second argument in a weak ordering. But because the 
-                    priority queue outputs largest elements first, the 
-                    elements that "come before" are actually output last. 
-                    That is, the front of the queue contains the "last" 
-                    element according to the weak ordering imposed by Compare. */
-                    return n1.getCost() > n2.getCost();
-                }
+                std::chrono::steady_clock::time_point time_{std::chrono::steady_clock::now()};
+                perf::Counters counters_{perf::read()};
             };
 
+            /* add the time (and counters) since t0 to phase (and count a low-level failure). Called on the thread that
+               started the phase */
+            void recordTime_(PhaseTime &phase, const PhaseStart &t0, const bool failed = false);
+
             // this is the Multi-agent motion planning problem definition
             const MultiRobotProblemDefinitionPtr mrmp_pdef_;
             
@@ -229,11 +1180,151 @@ namespace ompl
 
             int B_{100};
 
+            unsigned int num_threads_{1};
+
+            double focal_w_{1.0};
+
+            double pending_slice_{1.0};  // seconds
+
+            bool adaptive_budget_{false};
+            ReplanBudget budget_;
+
+            bool background_pending_{false};
+            unsigned int pipeline_depth_{0};
+            bool pipeline_ordered_{false};
+
+            unsigned int num_expansions_{0};
+
+            unsigned int num_bypasses_{0};
+
+            unsigned int num_bypassed_nodes_{0};
+
             bool bypass_{false};
 
-            std::vector<std::pair<int, int>> merger_count_{};
+            bool lazy_{false};
+
+            bool anytime_{false};
+
+            double conflict_window_{std::numeric_limits<double>::infinity()};  // seconds
+
+            bool duplicate_detection_{false};
+
+            bool disjoint_splitting_{false};
+
+            double duplicate_resolution_{1e-3};
+
+            bool all_conflicts_{false};
+
+            bool conflict_classification_{false};
+
+            unsigned int classification_limit_{8};
+
+            /* constraint set hashes of the nodes generated by the current call to solve() */
+            std::unordered_set<std::size_t> closed_;
+
+            bool independence_detection_{false};
+
+            /* the agents planned by this K-CBS (every agent if empty). The others keep their trajectory of root_plan_ */
+            std::vector<int> group_{};
+
+            /* taken around the validator and the merger, which are not thread-safe, by the K-CBS of the groups that are 
+               solved at the same time (nullptr otherwise) */
+            std::shared_ptr<std::mutex> shared_mutex_{nullptr};
+
+            /* the given root plan (the root is planned from scratch if empty) */
+            Plan root_plan_{};
+
+            /* constraints of every agent that are placed on the root node (with root_plan_) */
+            std::vector<std::vector<ConstraintPtr>> root_constraints_{};
+
+            /* last solution, its constraints, and the agents whose start changed since (online re-planning) */
+            Plan online_plan_{};
+
+            std::vector<KCBSNode::ConstraintRange> online_constraints_{};
+
+            std::vector<int> online_changed_{};
+
+            /* the meta-agents formed so far (see getMergers). The search reads the meta-agents of its nodes, not these */
+            std::vector<std::vector<int>> merger_count_{};
+
+            std::size_t num_agents_{0};
+
+            /* number of conflicts of every pair of agents (upper triangle, see pairIndex_) */
+            std::vector<int> conf_counter_;
+
+            /* largest entry of conf_counter_ */
+            int max_conflicts_{0};
+
+            Statistics stats_;
+
+            std::mutex stats_mutex_;
+
+            /* owns all nodes of the conflict tree for one call to solve() */
+            NodeArena<KCBSNode> node_arena_;
+
+            std::uint32_t seed_{0};
+
+            /* replans seeded by the current search */
+            std::uint64_t low_level_calls_{0};
+
+            std::vector<ReplayEvent> replay_;
+
+            std::mutex replay_mutex_;
+
+            ProgressCallback progress_callback_{nullptr};
+
+            std::size_t progress_capacity_{4096};
+
+            /* the events of the running search, nullptr without a callback */
+            std::unique_ptr<EventQueue<ProgressEvent>> progress_;
+
+            std::atomic<std::size_t> progress_dropped_{0};
+
+            std::atomic<bool> progress_stop_{false};
+
+            std::chrono::steady_clock::time_point progress_start_;
+
+            /* a node of the conflict tree of getPlannerData (by id) */
+            struct TreeRecord
+            {
+                int parent_{-1};
+                double cost_{0};
+                bool queued_{false};
+                bool expanded_{false};
+                bool solution_{false};
+            };
+
+            std::vector<TreeRecord> tree_;
+
+            /* the states of the vertices of getPlannerData, allocated as the tree grows */
+            mutable std::vector<base::State*> tree_states_;
+
+            mutable std::mutex tree_mutex_;
+
+            /* low-level planners raced on every replan (their counts are guarded by stats_mutex_) */
+            std::vector<PortfolioMember> portfolio_;
+
+            unsigned int portfolio_width_{0};
+
+            /* sum of the lower bounds on the cost of every agent (see MultiRobotProblemDefinition::getCostLowerBound), which no plan of
+               the conflict tree is cheaper than. An anytime search whose incumbent meets it is over */
+            double cost_lower_bound_{0};
+            std::size_t memory_budget_{0};  // bytes
+
+            /* estimated bytes of a state of a trajectory (with its control) */
+            std::size_t state_bytes_{0};
+
+            /* the ranks of a distributed search, or nullptr */
+            std::shared_ptr<SearchCluster> cluster_{nullptr};
+
+            unsigned int steal_batch_{16};
+
+            std::string checkpoint_file_{};
+
+            double checkpoint_interval_{0};  // seconds
 
-            std::vector< std::pair< std::pair<int, int>, int>> conf_counter_;
+            /* the checkpoint that the next call to solve() resumes (see resumeCheckpoint) */
+            std::string resume_data_{};
         };
     }
 }
\ No newline at end of file
@@ -43,6 +43,7 @@
 #include <ompl/base/goals/GoalSampleableRegion.h>
 #include <ompl/base/spaces/RealVectorStateSpace.h>
 #include "Goals/MultiRobotStateSpaceGoals.h"
+#include "utils/AgentDecoupledPropagation.h"
  
 namespace ompl
 {
@@ -127,17 +128,18 @@ namespace ompl
                 return si_->distance(a->state, b->state);
             }
 
-            /* the extend function for multi-agent systems */
+            /* the extend function for multi-agent systems: sample a control and a duration (see
+               SimpleDirectedControlSampler) without propagating it. The controls of the vehicles already in goal at
+               source are zeroed, and active tells the others */
             unsigned int MultiAgentControlSampler(Control *rcontrol, Control *previous, 
-                const base::State *source, base::State *dest);
-
-            /* reset states that are already at goal */
-            void overrideStates(const std::vector<int> DoNotProp, const base::State *source, 
-                base::State *result, Control *control);
+                const base::State *source, std::vector<bool> &active);
 
             base::StateSamplerPtr sampler_;
  
-            DirectedControlSamplerPtr controlSampler_;
+            ControlSamplerPtr controlSampler_;
+
+            /* propagation of the vehicles that are not in goal, which are checked on their own first */
+            std::unique_ptr<AgentDecoupledPropagation> propagation_;
  
             const SpaceInformation *siC_;
  
@@ -40,13 +40,20 @@
 #include "Planners/PrioritizedRRT.h"
 #include "utils/MultiRobotProblemDefinition.h"
 #include <ompl/control/planners/PlannerIncludes.h>
+#include <memory>
+#include <utility>
+#include <vector>
 
 
 namespace ompl
 {
     namespace control
     {
-        /** \brief timed Rapidly-exploring Random Tree for Priority based search */
+        /** \brief Priority-Based Search: a depth-first search over a tree of priority orderings. Every node holds a plan
+            and a set of pairwise priorities (higher, lower), and the first collision (a, b) of its plan branches into a
+            child with a above b and one with b above a. Each child replans the lower agent, and then every agent below
+            it that collides with one above, with PrioritizedRRT against the paths of the agents above. The two
+            children of a node are planned in parallel, each with its own set of low-level planners. */
         class PBS : public base::Planner
         {
         public:
@@ -58,6 +65,8 @@ namespace ompl
             /** \brief Continue solving for some amount of time. Return true if solution was found. */
             base::PlannerStatus solve(const base::PlannerTerminationCondition &ptc) override;
 
+            void clear() override;
+
             void setInstance(Instance *mrmp_instance) {mrmp_instance_ = mrmp_instance;};
 
             Instance* getInstance() {return mrmp_instance_;};
@@ -66,12 +75,77 @@ namespace ompl
 
             void resetSolveTime() {solveTime_ = 0.0;};
 
+            /** \brief Seconds given to every low-level replan (1 by default) */
+            void setLowLevelTime(const double t) {low_level_time_ = t;};
+
+            double getLowLevelTime() const {return low_level_time_;};
+
+            /** \brief Plan the two children of a node on separate threads (true by default) */
+            void setParallelBranches(const bool b) {parallel_branches_ = b;};
+
+            bool getParallelBranches() const {return parallel_branches_;};
+
+            /** \brief Nodes of the priority tree expanded by the last solve */
+            std::size_t getExpandedNodes() const {return expanded_;};
+
+            /** \brief The plan found by the last solve (empty if none) */
+            const std::vector<PathControl> &getSolution() const {return solution_;};
+
         protected:
+            typedef std::shared_ptr<const PathControl> TrajectoryPtr;
+
+            /** \brief Node of the priority tree */
+            struct Node
+            {
+                /* priority pairs (higher, lower) */
+                std::vector<std::pair<int, int>> priorities_;
+                /* interpolated trajectory of every agent, shared with the parent where it did not change */
+                std::vector<TrajectoryPtr> plan_;
+                /* sum of the durations of the trajectories */
+                double cost_{0};
+            };
+            typedef std::shared_ptr<Node> NodePtr;
+
+            /** \brief One low-level planner per agent, each with its own problem definition, so that the two branches of
+                a node replan concurrently. Built once and reused by every node */
+            struct PlannerSlot
+            {
+                std::vector<std::shared_ptr<PrioritizedRRT>> planners_;
+            };
+
+            /** \brief Build the planner slots (once) */
+            void setupSlots_();
+
+            /** \brief True if a is above b (transitively) in the priorities of n */
+            static bool isHigher_(const Node &n, const int a, const int b);
+
+            /** \brief First collision of the plan of n, i.e. the pair of agents (a < b) whose shapes first intersect.
+                False if the plan is collision-free */
+            bool firstConflict_(const Node &n, int &a, int &b) const;
+
+            /** \brief True if the shapes of a and b intersect at some step of the plan of n */
+            bool collide_(const Node &n, const int a, const int b) const;
+
+            /** \brief Replan agent in n against the agents above it, with the planners of slot. False if it fails */
+            bool replan_(Node &n, const int agent, PlannerSlot &slot, const base::PlannerTerminationCondition &ptc);
+
+            /** \brief The child of parent in which high is above low, or nullptr if that ordering is inconsistent or a
+                replan fails */
+            NodePtr branch_(const NodePtr &parent, const int high, const int low, PlannerSlot &slot,
+                const base::PlannerTerminationCondition &ptc);
+
             const std::vector<MotionPlanningProblemPtr> mmpp_;
-            Instance* mrmp_instance_;
-            double solveTime_;
+            Instance* mrmp_instance_{nullptr};
+            double solveTime_{0.0};
+            double low_level_time_{1.0};
+            bool parallel_branches_{true};
+            std::size_t expanded_{0};
+            /* shape of every robot at its start location */
+            std::vector<RobotFootprint> footprints_;
+            std::vector<PlannerSlot> slots_;
+            std::vector<PathControl> solution_;
         };
     }
 }
  
-// #endif
\ No newline at end of file
+// #endif
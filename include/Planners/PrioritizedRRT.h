@@ -37,6 +37,7 @@
 #pragma once
 #include "utils/common.h"
 #include "utils/Instance.h"
+#include "utils/ReservationTable.h"
 #include "ompl/control/planners/PlannerIncludes.h"
 #include <ompl/base/goals/GoalSampleableRegion.h>
 #include <ompl/base/spaces/RealVectorStateSpace.h>
@@ -109,9 +110,15 @@ namespace ompl
                 setup();
             }
 
-            void setExistingSolutions(std::vector<PathControl> existing) {existingSolns_ = existing;};
+            /** \brief Paths of the agents of higher priority to avoid. existing[i] is the path of the robot agents[i] of
+                the instance, or of robot i if agents is empty */
+            void setExistingSolutions(std::vector<PathControl> existing, std::vector<int> agents = {})
+            {
+                existingSolns_ = std::move(existing);
+                existingAgents_ = std::move(agents);
+            };
 
-            void clearExistingSolutions() {existingSolns_.clear();};
+            void clearExistingSolutions() {existingSolns_.clear(); existingAgents_.clear();};
 
             void setup() override;
 
@@ -146,11 +153,25 @@ namespace ompl
                 /** \brief The number of steps the control is applied for */
                 unsigned int steps{0};
 
+                /** \brief The number of propagation steps from the start to the state */
+                unsigned int timeStep{0};
+
                 /** \brief The parent motion in the exploration tree */
                 Motion *parent{nullptr};
             };
 
-            bool isCollisionFree(Motion* current);
+            /** \brief True if the states of the edge that applies ctrl for steps from parent are free in reservations_,
+                each at its step from the start */
+            bool isCollisionFree(const Motion *parent, const Control *ctrl, const unsigned int steps) const;
+
+            /** \brief True if the robot at state st is free in reservations_ at step */
+            bool isStateFree_(const base::State *st, const unsigned int step) const;
+
+            /** \brief The footprint of shape at the pose of state st */
+            static RobotFootprint footprintAt_(const base::State *st, const RobotFootprint &shape);
+
+            /** \brief Build reservations_ from existingSolns_ (interpolated) */
+            void reserveExistingSolutions_();
 
             /** \brief Free the memory allocated by this planner */
             void freeMemory();
@@ -189,6 +210,15 @@ namespace ompl
             /* set of paths that need to be avoided */
             std::vector<PathControl> existingSolns_;
 
+            /* robot of every path of existingSolns_ (the first robots in order if empty) */
+            std::vector<int> existingAgents_;
+
+            /* the footprints of existingSolns_ at every step, built once per call to solve */
+            ReservationTable reservations_;
+
+            /* the footprint of robot_ at its start location */
+            RobotFootprint footprint_;
+
             /* world object */
             Instance *mrmp_instance_{nullptr};
 
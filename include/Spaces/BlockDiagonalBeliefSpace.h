@@ -0,0 +1,34 @@
+#pragma once
+#include "Spaces/RealVectorBeliefSpace.h"
+
+
+/* Joint belief of agents moving in the plane, whose covariances are block diagonal: the centralized dynamics
+   never couple the agents, so only the 2 x 2 block of every agent is stored, side by side in a 2 x 2N matrix.
+   A belief of N agents then takes O(N) memory, copies and distances instead of O(N^2) and O(N^3). The blocks
+   are read with StateType::sigmaBlock() and lambdaBlock(). */
+class BlockDiagonalBeliefSpace: public RealVectorBeliefSpace
+{
+public:
+    BlockDiagonalBeliefSpace(const unsigned int num_agents): RealVectorBeliefSpace(2 * num_agents), num_agents_(num_agents)
+    {
+        setName("BlockDiagonal" + getName());
+    }
+
+    ~BlockDiagonalBeliefSpace(void) override {}
+
+    ompl::base::State* allocState(void) const override;
+
+    /* the Wasserstein distance of RealVectorBeliefSpace, which is the sum of the terms of the blocks */
+    double distance(const State* state1, const State *state2) const override;
+
+    unsigned int getNumAgents() const {return num_agents_;};
+
+protected:
+    std::size_t stateBytes_() const override
+    {
+        return sizeof(StateType) + 5 * dimension_ * sizeof(double);
+    }
+
+private:
+    const unsigned int num_agents_;
+};
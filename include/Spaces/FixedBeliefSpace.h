@@ -0,0 +1,129 @@
+#pragma once
+#include "Spaces/RealVectorBeliefSpace.h"
+#include "utils/BeliefScalar.h"
+#include <atomic>
+#include <cmath>
+
+
+/* Belief space of a dimension N known at compile time. The mean and both covariances are stored inline
+   with the belief as fixed-size Eigen types, so a belief is a single allocation, copies are fixed-size
+   and the distance uses fixed-size Eigen kernels, evaluated in Scalar (see BeliefScalar.h). The states are still
+   RealVectorBeliefSpace::StateType, so the propagators, validity checkers and goals work on both spaces. */
+template <unsigned int N, typename Scalar = BeliefScalar>
+class FixedBeliefSpace: public RealVectorBeliefSpace
+{
+public:
+    typedef Eigen::Matrix<double, N, 1> VectorN;
+    typedef Eigen::Matrix<double, N, N> MatrixN;
+    /* the types of the distance */
+    typedef Eigen::Matrix<Scalar, N, 1> VectorS;
+    typedef Eigen::Matrix<Scalar, N, N> MatrixS;
+
+    FixedBeliefSpace(): RealVectorBeliefSpace(N)
+    {
+        setName("Fixed" + getName());
+    }
+
+    ~FixedBeliefSpace(void) override
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        for (StateType *st: free_states_)
+            delete static_cast<Block *>(st);
+        free_states_.clear();
+    }
+
+    ompl::base::State* allocState(void) const override
+    {
+        auto *block = static_cast<Block *>(recycledState_());
+        if (!block) {
+            block = new Block();
+            block->setStorage(block->mean_.data(), block->sigma_data_.data(), block->lambda_data_.data(), N);
+        }
+        block->sigma_data_ = 0.01 * MatrixN::Identity();
+        block->lambda_data_ = 0.01 * MatrixN::Identity();
+        block->setCost(std::numeric_limits<double>::max());
+        alloc::onAlloc(alloc::BELIEF_STATES, stateBytes_());
+        return block;
+    }
+
+    /* the fixed-size views below also accept beliefs of other spaces of dimension N */
+    void copyState(State *destination, const State *source) const override
+    {
+        auto *dst = destination->as<StateType>();
+        const auto *src = source->as<StateType>();
+        Eigen::Map<VectorN>(dst->values) = Eigen::Map<const VectorN>(src->values);
+        Eigen::Map<MatrixN>(dst->sigma_.data()) = Eigen::Map<const MatrixN>(src->sigma_.data());
+        Eigen::Map<MatrixN>(dst->lambda_.data()) = Eigen::Map<const MatrixN>(src->lambda_.data());
+    }
+
+    /* the Wasserstein distance of RealVectorBeliefSpace with fixed-size matrices. It is in closed form for N = 2.
+       Otherwise, the covariance square root of a belief is kept in the belief, which must be of this space */
+    double distance(const State* state1, const State *state2) const override
+    {
+        const auto *b1 = state1->as<StateType>();
+        const auto *b2 = state2->as<StateType>();
+        const VectorS mu_diff = (Eigen::Map<const VectorN>(b1->values) - Eigen::Map<const VectorN>(b2->values)).template cast<Scalar>();
+        if (mu_diff.squaredNorm() == 0)
+            return 0.0;
+
+        const MatrixS cov1 = (Eigen::Map<const MatrixN>(b1->sigma_.data()) + Eigen::Map<const MatrixN>(b1->lambda_.data())).template cast<Scalar>();
+        const MatrixS cov2 = (Eigen::Map<const MatrixN>(b2->sigma_.data()) + Eigen::Map<const MatrixN>(b2->lambda_.data())).template cast<Scalar>();
+        Scalar trace_sqrt;
+        if constexpr (N == 2)
+            trace_sqrt = traceSqrt2x2(cov1, cov2);
+        else {
+            // the metric is symmetric, so use the belief whose square root is already known
+            const Block *c1 = static_cast<const Block *>(b1);
+            const Block *c2 = static_cast<const Block *>(b2);
+            const bool swap = c1->hasSqrt_(cov1) && !c2->hasSqrt_(cov2);
+            const MatrixS sqrt2 = swap ? c1->sqrt_(cov1) : c2->sqrt_(cov2);
+            Eigen::SelfAdjointEigenSolver<MatrixS> es3(sqrt2 * (swap ? cov2 : cov1) * sqrt2, Eigen::EigenvaluesOnly);
+            trace_sqrt = es3.eigenvalues().cwiseMax(Scalar(0)).cwiseSqrt().sum();
+        }
+        const Scalar t = mu_diff.squaredNorm() + cov1.trace() + cov2.trace() - 2 * trace_sqrt;
+        return std::abs(t);
+    }
+
+protected:
+    /* a belief together with its storage */
+    struct Block: public StateType
+    {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        VectorN mean_;
+        MatrixN sigma_data_;
+        MatrixN lambda_data_;
+
+        /* square root of the covariance cov_key_, valid while the covariance is unchanged. Several threads may
+           query a belief that is not being modified, so the first one to compute the root publishes it */
+        bool hasSqrt_(const MatrixS &cov) const
+        {
+            return sqrt_state_.load(std::memory_order_acquire) == ready_ && cov_key_ == cov;
+        };
+
+        MatrixS sqrt_(const MatrixS &cov) const
+        {
+            if (hasSqrt_(cov))
+                return cov_sqrt_;
+            Eigen::SelfAdjointEigenSolver<MatrixS> es(cov);
+            const MatrixS root = es.operatorSqrt();
+            int expected = sqrt_state_.load(std::memory_order_relaxed);
+            if (expected != writing_ && sqrt_state_.compare_exchange_strong(expected, writing_, std::memory_order_acquire)) {
+                cov_key_ = cov;
+                cov_sqrt_ = root;
+                sqrt_state_.store(ready_, std::memory_order_release);
+            }
+            return root;
+        }
+
+        static constexpr int empty_ = 0;
+        static constexpr int writing_ = 1;
+        static constexpr int ready_ = 2;
+
+        mutable MatrixS cov_key_;
+        mutable MatrixS cov_sqrt_;
+        mutable std::atomic<int> sqrt_state_{empty_};
+    };
+
+    std::size_t stateBytes_() const override {return sizeof(Block);};
+};
@@ -1,8 +1,13 @@
 #pragma once
+#include "utils/AllocStats.h"
 #include <ompl/base/spaces/RealVectorStateSpace.h>
 #include <boost/math/constants/constants.hpp>
 #include <unsupported/Eigen/MatrixFunctions>
 #include <Eigen/Eigenvalues> 
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <vector>
 
 using namespace ompl::base;
 
@@ -89,13 +94,37 @@ class RealVectorBeliefSpace : public ompl::base::RealVectorStateSpace
             // int DISTANCE_FUNCTION_TYPE_;
             
         // private:
-            Eigen::MatrixXd sigma_;
-            Eigen::MatrixXd lambda_;
+            /* views on the storage of the belief, which is owned by the space that allocated it */
+            Eigen::Map<Eigen::MatrixXd> sigma_{nullptr, 0, 0};
+            Eigen::Map<Eigen::MatrixXd> lambda_{nullptr, 0, 0};
+
+            /* point the mean and covariances to storage of dim, dim x dim and dim x dim doubles */
+            void setStorage(double *mean, double *sigma, double *lambda, const unsigned int dim)
+            {
+                setStorage(mean, sigma, lambda, dim, dim);
+            }
+
+            /* point the mean and covariances to storage of cols, rows x cols and rows x cols doubles */
+            void setStorage(double *mean, double *sigma, double *lambda, const unsigned int rows, const unsigned int cols)
+            {
+                values = mean;
+                new (&sigma_) Eigen::Map<Eigen::MatrixXd>(sigma, rows, cols);
+                new (&lambda_) Eigen::Map<Eigen::MatrixXd>(lambda, rows, cols);
+            }
+
+            /* the 2 x 2 covariance blocks of agent a of a joint belief. The covariances are either dense, or
+               only their diagonal blocks are stored side by side in a 2 x dim matrix (BlockDiagonalBeliefSpace) */
+            auto sigmaBlock(const unsigned int a) {return sigma_.block<2, 2>(blockRow_(a), 2 * a);};
+            auto sigmaBlock(const unsigned int a) const {return sigma_.block<2, 2>(blockRow_(a), 2 * a);};
+            auto lambdaBlock(const unsigned int a) {return lambda_.block<2, 2>(blockRow_(a), 2 * a);};
+            auto lambdaBlock(const unsigned int a) const {return lambda_.block<2, 2>(blockRow_(a), 2 * a);};
         private:
+            unsigned int blockRow_(const unsigned int a) const {return (sigma_.rows() == sigma_.cols()) ? 2 * a : 0;};
+
             double cost_{std::numeric_limits<double>::max()};
         };
 
-        virtual ~RealVectorBeliefSpace(void) {}
+        ~RealVectorBeliefSpace(void) override;
 
         // virtual State* allocState(void) const override;
         ompl::base::State* allocState(void) const override;
@@ -107,6 +136,26 @@ class RealVectorBeliefSpace : public ompl::base::RealVectorStateSpace
         //virtual void registerProjections(void);
         double distance(const State* state1, const State *state2) const override;
 
+        /* squared distance of the means. A lower bound on distance() that is cheap enough to prune 
+           nearest-neighbor candidates with */
+        double meanDistance(const State* state1, const State *state2) const;
+
+        /* tr(sqrt(C2^1/2 C1 C2^1/2)) of two 2 x 2 covariances, in closed form */
+        static double traceSqrt2x2(const Eigen::Matrix2d &cov1, const Eigen::Matrix2d &cov2)
+        {
+            return traceSqrt2x2<double>(cov1, cov2);
+        }
+
+        /* as traceSqrt2x2, in Scalar */
+        template <typename Scalar>
+        static Scalar traceSqrt2x2(const Eigen::Matrix<Scalar, 2, 2> &cov1, const Eigen::Matrix<Scalar, 2, 2> &cov2)
+        {
+            // the eigenvalues a, b of the product satisfy (sqrt(a) + sqrt(b))^2 = tr + 2 sqrt(det)
+            const Scalar tr = cov1.cwiseProduct(cov2).sum();
+            const Scalar det = std::max<Scalar>(cov1.determinant() * cov2.determinant(), 0);
+            return std::sqrt(std::max<Scalar>(tr + 2 * std::sqrt(det), 0));
+        }
+
         void printState(const State *state, std::ostream &out) const override;
 
         // gets the relative vector between "from" and "to"
@@ -117,6 +166,20 @@ class RealVectorBeliefSpace : public ompl::base::RealVectorStateSpace
 
     protected:
         const unsigned int dimension_;
+
+        /* freed beliefs keep their buffers and are handed out again by allocState(), so that the 
+           planners do not hit the heap for every new motion. They are deleted with the space */
+        mutable std::vector<StateType*> free_states_;
+        mutable std::mutex pool_mutex_;
+
+        /* a freed belief to reuse, or nullptr */
+        StateType *recycledState_() const;
+
+        /* bytes of a belief of this space, counted for alloc::BELIEF_STATES */
+        virtual std::size_t stateBytes_() const
+        {
+            return sizeof(StateType) + (dimension_ + 2 * dimension_ * dimension_) * sizeof(double);
+        }
         // double sigma_init_;
 
 };
@@ -0,0 +1,17 @@
+#pragma once
+#include <ompl/control/SpaceInformation.h>
+#include <vector>
+
+
+/** \brief Interface of the propagators of a joint (multi-robot) state whose agents have independent dynamics, so
+    that the agents that do not move (e.g. the ones already at their goal) are not propagated at all. */
+class AgentDecoupledStatePropagator
+{
+public:
+    virtual ~AgentDecoupledStatePropagator() = default;
+
+    /** \brief Propagate the sub-states of the active agents of state under control for duration into result. The
+        sub-states of the other agents of result are left untouched. result may be state. */
+    virtual void propagateAgents(const ompl::base::State *state, const ompl::control::Control *control,
+        const double duration, const std::vector<bool> &active, ompl::base::State *result) const = 0;
+};
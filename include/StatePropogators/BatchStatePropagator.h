@@ -0,0 +1,29 @@
+#pragma once
+#include <ompl/control/SpaceInformation.h>
+#include <cstddef>
+
+
+/** \brief Interface of the belief propagators that apply several controls in one call. The covariance step does
+    not depend on the control, so candidates that share their input covariance share its update, and the
+    means are updated in a structure of arrays so the loops vectorize. */
+class BatchStatePropagator
+{
+public:
+    virtual ~BatchStatePropagator() = default;
+
+    /** \brief Propagate states[i] under controls[i] for duration into results[i], for i < n. results[i] may be
+        states[i], but not the state of another candidate. */
+    virtual void propagateBatch(const ompl::base::State *const *states, const ompl::control::Control *const *controls,
+        const std::size_t n, const double duration, ompl::base::State *const *results) const = 0;
+
+protected:
+    /** \brief Number of candidates updated together, the doubles of a vector register of the target (see
+        KCBS_NATIVE): 8 with AVX-512, 4 with AVX, 2 with SSE2 or NEON. */
+#if defined(__AVX512F__)
+    static constexpr std::size_t lanes_ = 8;
+#elif defined(__AVX__)
+    static constexpr std::size_t lanes_ = 4;
+#else
+    static constexpr std::size_t lanes_ = 2;
+#endif
+};
@@ -2,6 +2,7 @@
 #include <ompl/control/ODESolver.h>
 #include <ompl/base/spaces/SE2StateSpace.h>
 #include <ompl/control/spaces/RealVectorControlSpace.h>
+#include <ompl/control/StatePropagator.h>
 
 namespace ob = ompl::base;
 namespace oc = ompl::control;
@@ -20,3 +21,31 @@ void SecondOrderCarODE (const oc::ODESolver::StateType& q,
 // callback for putting angle [0, 2pi]
 void SecondOrderCarODEPostIntegration (const ob::State* /*state*/, 
     const oc::Control* /*control*/, const double /*duration*/, ob::State *result);
+
+/** \brief Exact propagation of the first-order car (SE2 state, controls [v, steering angle]). The controls are
+    constant over a step, so the car drives on a circular arc (a line without steering), which is evaluated in
+    closed form instead of integrating FirstOrderCarODE. */
+class FirstOrderCarStatePropagator : public oc::StatePropagator
+{
+public:
+    FirstOrderCarStatePropagator(const oc::SpaceInformationPtr &si, const double car_length = 0.2);
+
+    void propagate(const ob::State *state, const oc::Control *control, const double duration, ob::State *result) const override;
+
+private:
+    const double car_length_;
+};
+
+/** \brief Propagation of the second-order car (state [x, y, v, phi] x SO2 theta, controls [a, phidot]) with fixed
+    RK4 steps (the integrator of the ODE solver), on a fixed-size state and without allocating. */
+class SecondOrderCarStatePropagator : public oc::StatePropagator
+{
+public:
+    SecondOrderCarStatePropagator(const oc::SpaceInformationPtr &si, const double car_length = 0.5, const double int_step = 1e-2);
+
+    void propagate(const ob::State *state, const oc::Control *control, const double duration, ob::State *result) const override;
+
+private:
+    const double car_length_;
+    const double int_step_;
+};
@@ -1,5 +1,8 @@
 #pragma once
 #include "Spaces/RealVectorBeliefSpace.h"
+#include "StatePropogators/AgentDecoupledStatePropagator.h"
+#include "StatePropogators/BatchStatePropagator.h"
+#include "utils/CovarianceCache.h"
 // #include <ompl/base/spaces/SE2StateSpace.h>
 #include <ompl/control/SpaceInformation.h>
 #include <ompl/control/spaces/RealVectorControlSpace.h>
@@ -11,7 +14,7 @@ namespace oc = ompl::control;
 // typedef Eigen::Matrix<double, 2, 2, Eigen::DontAlign> Mat;
 
 /** \brief State propagation for a 2D point motion model. */
-class CentralizedUncertainLinearStatePropagator : public oc::StatePropagator
+class CentralizedUncertainLinearStatePropagator : public oc::StatePropagator, public BatchStatePropagator, public AgentDecoupledStatePropagator
 {
 public:
     // EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -29,6 +32,13 @@ public:
     */
     void propagate(const ompl::base::State *state, const ompl::control::Control* control, const double duration, ompl::base::State *result) const override;
 
+    void propagateBatch(const ompl::base::State *const *states, const ompl::control::Control *const *controls, 
+        const std::size_t n, const double duration, ompl::base::State *const *results) const override;
+
+    /* the agents are independent, so only the mean and covariance blocks of the active ones are updated */
+    void propagateAgents(const ompl::base::State *state, const ompl::control::Control *control, const double duration,
+        const std::vector<bool> &active, ompl::base::State *result) const override;
+
 private:
 
     Eigen::Matrix2d A_ol_, B_ol_, A_cl_, B_cl_, A_cl_d_, B_cl_d_;
@@ -54,5 +64,22 @@ private:
     Eigen::Matrix2d Q_ = Eigen::Matrix2d::Identity();
     Eigen::Matrix2d R_ = Eigen::Matrix2d::Identity();
     double K_ = 0.3;
-    void singleAgentPropogate_(Eigen::Vector2d& mu, Eigen::Matrix2d& sigma, Eigen::Matrix2d& lambda, Eigen::Vector2d& cntrl, Eigen::Vector2d& nxt_mu, Eigen::Matrix2d& nxt_sigma, Eigen::Matrix2d& nxt_lambda) const;
+    /* the Kalman filter step of the covariance block of one agent, which does not depend on the control */
+    void propagateCovariance_(const Eigen::Matrix2d &sigma, const Eigen::Matrix2d &lambda, Eigen::Matrix2d &nxt_sigma, Eigen::Matrix2d &nxt_lambda) const;
+
+    /* the last block update, which the next agents and candidates mostly share (their blocks are at the same depth
+       of the tree), so the cache is only looked up when the input block changes */
+    struct CovarianceMemo
+    {
+        bool valid_{false};
+        double in_[8];   // sigma then lambda, column-major
+        double out_[8];
+    };
+
+    /* the covariance blocks of the agents of st (only the active ones, if active is set) into res, which may be st */
+    void propagateCovariances_(const RealVectorBeliefSpace::StateType *st, const std::vector<bool> *active,
+        CovarianceMemo &memo, RealVectorBeliefSpace::StateType *res) const;
+
+    /* the agents share their dynamics, so one cache of the (control independent) covariance step serves every agent block */
+    CovarianceCache<2> covariance_cache_;
 };
@@ -1,7 +1,11 @@
 #pragma once
+#include "StatePropogators/AgentDecoupledStatePropagator.h"
 #include <ompl/control/ODESolver.h>
 #include <ompl/base/spaces/SE2StateSpace.h>
 #include <ompl/control/spaces/RealVectorControlSpace.h>
+#include <ompl/control/StatePropagator.h>
+#include <cstddef>
+#include <vector>
 
 namespace ob = ompl::base;
 namespace oc = ompl::control;
@@ -20,3 +24,31 @@ void ThreeSecondOrderCarsODE (const oc::ODESolver::StateType& q,
 // callback for putting angle [0, 2pi]
 void ThreeSecondOrderCarsPostIntegration (const ob::State* /*state*/, 
     const oc::Control* /*control*/, const double /*duration*/, ob::State *result);
+
+/** \brief Propagation of any number of second-order cars composed into one state (per car, [x, y, v, phi] x SO2
+    theta; controls [a1, phidot1, a2, phidot2, ...]) with the fixed RK4 steps of SecondOrderCarStatePropagator.
+    The cars do not interact while propagating, so they are laid out as a structure of arrays and every RK4 stage
+    advances a block of cars at once, with the polynomial sin and cos of utils/FastMath.h (which vectorize like the
+    rest of the loop). */
+class MultiSecondOrderCarStatePropagator : public oc::StatePropagator, public AgentDecoupledStatePropagator
+{
+public:
+    MultiSecondOrderCarStatePropagator(const oc::SpaceInformationPtr &si, const double car_length = 0.5, const double int_step = 1e-2);
+
+    void propagate(const ob::State *state, const oc::Control *control, const double duration, ob::State *result) const override;
+
+    void propagateAgents(const ob::State *state, const oc::Control *control, const double duration,
+        const std::vector<bool> &active, ob::State *result) const override;
+
+private:
+    /** \brief Number of cars advanced together; eight doubles fill two AVX2 (or one AVX-512) registers. */
+    static constexpr std::size_t lanes_ = 8;
+
+    /* propagate the cars cars[0..m) (m <= lanes_) of state into result */
+    void propagateBlock_(const ob::State *state, const double *u, const double duration, const std::size_t *cars,
+        const std::size_t m, ob::State *result) const;
+
+    const std::size_t num_cars_;
+    const double car_length_;
+    const double int_step_;
+};
@@ -1,5 +1,7 @@
 #pragma once
 #include "Spaces/RealVectorBeliefSpace.h"
+#include "StatePropogators/BatchStatePropagator.h"
+#include "utils/CovarianceCache.h"
 #include <ompl/base/spaces/SE2StateSpace.h>
 #include <ompl/control/SpaceInformation.h>
 #include <ompl/control/spaces/RealVectorControlSpace.h>
@@ -11,7 +13,7 @@ namespace oc = ompl::control;
 typedef Eigen::Matrix<double, 2, 2, Eigen::DontAlign> Mat;
 
 /** \brief State propagation for a 2D point motion model. */
-class R2_UncertainLinearStatePropagator : public oc::StatePropagator
+class R2_UncertainLinearStatePropagator : public oc::StatePropagator, public BatchStatePropagator
 {
 public:
     /* \brief Construct representation of a unicycle state propagator. */
@@ -25,6 +27,9 @@ public:
     */
     virtual void propagate(const ompl::base::State *state, const ompl::control::Control* control, const double duration, ompl::base::State *result) const;
 
+    void propagateBatch(const ompl::base::State *const *states, const ompl::control::Control *const *controls, 
+        const std::size_t n, const double duration, ompl::base::State *const *results) const override;
+
 private:
 
     Eigen::Matrix2d A_ol_, B_ol_, A_cl_, B_cl_, A_cl_d_, B_cl_d_;
@@ -48,4 +53,9 @@ private:
     Eigen::Matrix2d Q_ = Eigen::Matrix2d::Identity();
     Eigen::Matrix2d R_ = Eigen::Matrix2d::Identity();
     double K_ = 0.3;
+
+    /* the Kalman filter step of the covariances, which does not depend on the control */
+    void propagateCovariance_(const Eigen::Matrix2d &sigma, const Eigen::Matrix2d &lambda, Eigen::Matrix2d &nxt_sigma, Eigen::Matrix2d &nxt_lambda) const;
+
+    CovarianceCache<2> covariance_cache_;
 };
@@ -42,6 +42,8 @@
 #include <ompl/base/spaces/SE2StateSpace.h>
 
 #include "Spaces/RealVectorBeliefSpace.h"
+#include "StatePropogators/BatchStatePropagator.h"
+#include "utils/CovarianceCache.h"
 // #include "../Spaces/R2BeliefSpaceEuclidean.h"
 
 namespace ob = ompl::base;
@@ -53,7 +55,7 @@ namespace oc = ompl::control;
 // typedef Eigen::Matrix<double, 4, 2, Eigen::DontAlign> Mat42;
 
 /** \brief State propagation for a Unicycle motion model. */
-class DynUnicycleControlSpace : public oc::StatePropagator {
+class DynUnicycleControlSpace : public oc::StatePropagator, public BatchStatePropagator {
     public:
         EIGEN_MAKE_ALIGNED_OPERATOR_NEW
         DynUnicycleControlSpace(const oc::SpaceInformationPtr &si);
@@ -65,6 +67,9 @@ class DynUnicycleControlSpace : public oc::StatePropagator {
 
         virtual void propagate(const ob::State *state, const oc::Control* control, const double duration, ob::State *result) const;
 
+        void propagateBatch(const ob::State *const *starts, const oc::Control *const *controls, 
+            const std::size_t n, const double duration, ob::State *const *results) const override;
+
         virtual bool canPropagateBackward(void) const;
 
     private:
@@ -108,11 +113,10 @@ class DynUnicycleControlSpace : public oc::StatePropagator {
         Eigen::Matrix4d Q, R, Ak;
         double myK_ = 0.3;
 
-        mutable const RealVectorBeliefSpace::StateType *result_css;
-        ob::RealVectorStateSpace::StateType *result_css_rvs_pose;
-        Eigen::Matrix2d result_css_rvs_cov;
+        /* the Kalman filter step of the covariances, which does not depend on the control */
+        void propagateCovariance_(const Eigen::Matrix4d &sigma, const Eigen::Matrix4d &lambda, Eigen::Matrix4d &nxt_sigma, Eigen::Matrix4d &nxt_lambda) const;
 
-        mutable double u_bar_0, u_bar_1, surge_final;
+        CovarianceCache<4> covariance_cache_;
 
     protected:
 
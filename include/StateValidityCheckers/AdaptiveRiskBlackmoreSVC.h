@@ -1,6 +1,8 @@
 #pragma once
 #include "utils/Instance.h"
+#include "utils/ErfInv.h"
 #include "Spaces/RealVectorBeliefSpace.h"
+#include "StateValidityCheckers/BatchValidityChecker.h"
 #include <ompl/control/SpaceInformation.h>
 #include <boost/geometry/algorithms/correct.hpp>
 #include <boost/math/special_functions/erf.hpp>
@@ -11,29 +13,41 @@ namespace oc = ompl::control;
 namespace bm = boost::math;
 
 
-class AdaptiveRiskBlackmoreSVC : public ob::StateValidityChecker {
+class AdaptiveRiskBlackmoreSVC : public ob::StateValidityChecker, public BatchValidityChecker {
     public:
         AdaptiveRiskBlackmoreSVC(const oc::SpaceInformationPtr &si, InstancePtr mrmp_instance, const Robot *r, const double accep_prob);
         ~AdaptiveRiskBlackmoreSVC();
 
         virtual bool isValid(const ob::State *state) const;
 
+        std::size_t firstInvalid(const ob::State *const *states, BeliefSegment &segment) const override;
+
     private:
+        /* the half-planes of the obstacles pass the belief (x, y, Sigma) with the quantile erf_inv_eta. reach bounds
+           the margin of the half-planes (see PCCBlackmoreSVC), the grid of the obstacles is only searched that far */
+        bool isClear_(const double x, const double y, const Eigen::Matrix2d &Sigma, const double erf_inv_eta,
+            const double reach) const;
+        static double reach_(const double s_xx, const double s_xy, const double s_yy, const double erf_inv)
+        {
+            const double half_tr = 0.5 * (s_xx + s_yy);
+            const double half_diff = 0.5 * (s_xx - s_yy);
+            const double lambda_max = half_tr + std::sqrt(half_diff * half_diff + s_xy * s_xy);
+            return std::sqrt(2 * std::max(lambda_max, 0.0)) * std::max(erf_inv, 0.0) * (1 + 1e-9) + 1e-12;
+        }
+
         const ob::SpaceInformation *si_;
         InstancePtr mrmp_instance_;
         const Robot *robot_; 
         double p_collision_;
         std::vector<Obstacle*> obs_list_;
 
-        std::vector<Eigen::Matrix<double, 4, 2> > A_list_;
-        std::vector<Eigen::Matrix<double, 4, 1> > B_list_;
+        /* the obstacles (Minkowski sums) with their half-planes. Their grid is only used if every half-plane is axis-aligned */
+        std::shared_ptr<const InflatedObstacles> inflated_;
         Eigen::Matrix2d PX;
 
-        bool isSafe_(const Eigen::Vector2d mu_a, const Eigen::Matrix2d Sigma_a, const Eigen::MatrixXd A, const Eigen::MatrixXd B, const double eta_i) const;
-        std::vector<double> createEtaList_(const Eigen::Vector2d mu_a) const;
-        std::pair<Eigen::MatrixXd, Eigen::MatrixXd> getHalfPlanes_(Polygon combined_poly);
-        Polygon getMinkowskiSum_(const Robot* &r, Obstacle* &obs);
-        Point addPoints_(const Point &a, const Point &b);
-        Point subtractPoints_(const Point &a, const Point &b);
-        double crossProduct_(const Point &a, const Point &b);
+        /* obstacle centers, contiguous for the risk allocation */
+        std::vector<double> obs_x_;
+        std::vector<double> obs_y_;
+
+        double firstEta_(const Eigen::Vector2d &mu_a) const;
 };
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+#include <ompl/base/State.h>
+#include <vector>
+
+
+/** \brief Interface of the validity checkers of a joint (multi-robot) state that check every agent on its own
+    (bounds and obstacles) and then the agents against each other. A state is valid iff every agent is valid and
+    the agents are separated. */
+class AgentDecoupledValidityChecker
+{
+public:
+    virtual ~AgentDecoupledValidityChecker() = default;
+
+    /** \brief True if agent of state is within its bounds and clear of the obstacles */
+    virtual bool isAgentValid(const ompl::base::State *state, const int agent) const = 0;
+
+    /** \brief True if no two agents of state collide, where at least one of them is active (the other pairs are
+        assumed to be separated already) */
+    virtual bool areAgentsSeparated(const ompl::base::State *state, const std::vector<bool> &active) const = 0;
+};
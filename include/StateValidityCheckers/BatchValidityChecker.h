@@ -0,0 +1,44 @@
+#pragma once
+#include "Spaces/RealVectorBeliefSpace.h"
+#include <ompl/base/State.h>
+#include <cstddef>
+#include <vector>
+
+
+/** \brief The x-y means and covariances (sigma + lambda, their top-left 2 x 2 blocks) of a segment of belief states,
+    as a structure of arrays, so the checkers compute the bounds of every state in one loop without calls */
+struct BeliefSegment
+{
+    void assign(const ompl::base::State *const *states, const std::size_t n)
+    {
+        for (std::vector<double> *v: {&x_, &y_, &s_xx_, &s_xy_, &s_yy_, &reach_, &quantile_})
+            v->resize(n);
+        for (std::size_t k = 0; k < n; k++) {
+            const RealVectorBeliefSpace::StateType *belief = states[k]->as<RealVectorBeliefSpace::StateType>();
+            x_[k] = belief->values[0];
+            y_[k] = belief->values[1];
+            s_xx_[k] = belief->sigma_(0, 0) + belief->lambda_(0, 0);
+            s_xy_[k] = belief->sigma_(0, 1) + belief->lambda_(0, 1);
+            s_yy_[k] = belief->sigma_(1, 1) + belief->lambda_(1, 1);
+        }
+    }
+
+    std::size_t size() const {return x_.size();};
+
+    std::vector<double> x_, y_;
+    std::vector<double> s_xx_, s_xy_, s_yy_;
+    /* per state scratch of the checkers */
+    std::vector<double> reach_, quantile_;
+};
+
+/** \brief Interface of the validity checkers of belief states that also check a whole propagated segment at once.
+    A state of the segment is valid iff isValid would accept it */
+class BatchValidityChecker
+{
+public:
+    virtual ~BatchValidityChecker() = default;
+
+    /** \brief The index of the first invalid state of states, whose beliefs are packed in segment (segment.size() if
+        every state is valid) */
+    virtual std::size_t firstInvalid(const ompl::base::State *const *states, BeliefSegment &segment) const = 0;
+};
@@ -1,43 +1,48 @@
 #pragma once
 #include "utils/Instance.h"
+#include "utils/DiskGeometry.h"
 #include "Spaces/RealVectorBeliefSpace.h"
+#include "StateValidityCheckers/AgentDecoupledValidityChecker.h"
 #include <ompl/control/SpaceInformation.h>
 #include <boost/geometry.hpp>
-#include <boost/geometry/strategies/buffer.hpp>
 #include <boost/math/distributions/chi_squared.hpp>
-#include <boost/geometry/multi/geometries/multi_polygon.hpp>
-#include <Eigen/Eigenvalues> 
 
 namespace ob = ompl::base;
 namespace oc = ompl::control;
 namespace bm = boost::math;
 
 
-class CentralizedChiSquaredBoundarySVC : public ob::StateValidityChecker {
+class CentralizedChiSquaredBoundarySVC : public ob::StateValidityChecker, public AgentDecoupledValidityChecker {
     public:
         CentralizedChiSquaredBoundarySVC(const oc::SpaceInformationPtr &si, InstancePtr mrmp_instance, const double accep_prob);
+        /* only check the given robots (in the order of the composed state), e.g. for a merged pair */
+        CentralizedChiSquaredBoundarySVC(const oc::SpaceInformationPtr &si, InstancePtr mrmp_instance, 
+            const std::vector<Robot*> &robots, const double accep_prob);
         ~CentralizedChiSquaredBoundarySVC();
 
         bool isValid(const ob::State *state) const override;
 
+        /* the mean of agent within the bounds, and its safety disk clear of the obstacles */
+        bool isAgentValid(const ob::State *state, const int agent) const override;
+
+        /* the safety disks of the pairs with an active agent are disjoint */
+        bool areAgentsSeparated(const ob::State *state, const std::vector<bool> &active) const override;
+
     private:
         double chi_squared_quantile_(double v, double p)
         {
            return quantile(bm::chi_squared(v), p);
         }
-        Polygon getMinkowskiSum_(const Robot* r, Obstacle* &obs);
-        Point addPoints_(const Point &a, const Point &b);
-        Point subtractPoints_(const Point &a, const Point &b);
-        double crossProduct_(const Point &a, const Point &b);
+        /* radius of the safety disk of agent */
+        double boundary_(const RealVectorBeliefSpace::StateType *belief, const int agent) const
+        {
+            return maxEigenvalue2x2(belief->sigmaBlock(agent)) * sc_ + bounding_radii_[agent];
+        }
         const ob::SpaceInformation *si_;
         InstancePtr mrmp_instance_;
         double sc_;
         const int num_agents_;
-        std::unordered_map<int, std::vector<Polygon>> obs_map_;
-        std::unordered_map<int, double> boundingRadii_map_;
-        const std::size_t points_per_circle_ = 10;
-        bg::strategy::buffer::join_round join_strategy{points_per_circle_};
-        boost::geometry::strategy::buffer::end_flat end_strategy;
-        bg::strategy::buffer::point_circle circle_strategy{points_per_circle_};
-        bg::strategy::buffer::side_straight side_strategy;
+        /* per agent: the obstacles (Minkowski sums) with a grid over them, and the bounding radius */
+        std::vector<std::shared_ptr<const InflatedObstacles>> inflated_;
+        std::vector<double> bounding_radii_;
 };
\ No newline at end of file
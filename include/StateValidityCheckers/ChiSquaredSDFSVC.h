@@ -0,0 +1,39 @@
+#pragma once
+#include "utils/Instance.h"
+#include "utils/SignedDistanceField.h"
+#include "utils/DiskGeometry.h"
+#include "Spaces/RealVectorBeliefSpace.h"
+#include <ompl/control/SpaceInformation.h>
+#include <boost/math/distributions/chi_squared.hpp>
+
+namespace ob = ompl::base;
+namespace oc = ompl::control;
+namespace bm = boost::math;
+
+
+/* The check of ChiSquaredBoundarySVC answered by the signed distance field of the instance: a belief is valid
+   if the disk of radius max_lambda * sc around its mean, grown by the bounding radius of the robot, is clear
+   of the obstacles. The bounding disk contains the bounding shape, so this is at least as conservative, and a
+   check is a constant number of lookups. */
+class ChiSquaredSDFSVC : public ob::StateValidityChecker {
+    public:
+        ChiSquaredSDFSVC(const oc::SpaceInformationPtr &si, InstancePtr mrmp_instance, const Robot *r, const double accep_prob);
+        ~ChiSquaredSDFSVC();
+
+        virtual bool isValid(const ob::State *state) const;
+
+        /* distance from the boundary disk of the belief to the obstacles, negative if they meet */
+        virtual double clearance(const ob::State *state) const;
+
+    private:
+        double chi_squared_quantile_(double v, double p)
+        {
+           return quantile(bm::chi_squared(v), p);
+        }
+        const ob::SpaceInformation *si_;
+        InstancePtr mrmp_instance_;
+        const Robot *robot_;
+        std::shared_ptr<const SignedDistanceField> sdf_;
+        const double max_rad_;
+        double sc_;
+};
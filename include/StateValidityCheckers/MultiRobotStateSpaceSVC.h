@@ -1,5 +1,6 @@
 #pragma once
 #include "utils/Instance.h"
+#include "StateValidityCheckers/AgentDecoupledValidityChecker.h"
 #include <ompl/base/spaces/SO2StateSpace.h>
 #include <ompl/base/spaces/RealVectorStateSpace.h>
 #include <ompl/control/SpaceInformation.h>
@@ -10,15 +11,28 @@ namespace ob = ompl::base;
 namespace oc = ompl::control;
 
 
-class MultiRobotStateSpaceSVC : public ob::StateValidityChecker
+class MultiRobotStateSpaceSVC : public ob::StateValidityChecker, public AgentDecoupledValidityChecker
 {
 public:
     MultiRobotStateSpaceSVC(const oc::SpaceInformationPtr &si, InstancePtr mrmp_instance, const Robot *r, std::string dyn);
  
     virtual bool isValid(const ob::State *state) const;
+
+    /* the sub-states of vehicle agent within their bounds, and its shape disjoint from the obstacles */
+    bool isAgentValid(const ob::State *state, const int agent) const override;
+
+    /* the shapes of the pairs of vehicles with an active one are disjoint */
+    bool areAgentsSeparated(const ob::State *state, const std::vector<bool> &active) const override;
 private:
+    /* number of vehicles of the composed dynamics model (0 if it is not implemented) */
+    int numVehicles_() const;
+
+    /* shape of vehicle i at state */
+    Polygon vehicle_(const ob::State *state, const int i) const;
+
     const ob::SpaceInformation *si_;
     InstancePtr mrmp_instance_;
     const Robot *robot_;
     const std::string dyn_;
+    std::shared_ptr<const OccupancyQuadtree> occupancy_;  // nullptr if the map has none
 };
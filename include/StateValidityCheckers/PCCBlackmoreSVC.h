@@ -1,6 +1,7 @@
 #pragma once
 #include "utils/Instance.h"
 #include "Spaces/RealVectorBeliefSpace.h"
+#include "StateValidityCheckers/BatchValidityChecker.h"
 // #include "Spaces/R2BeliefSpace.h"
 #include <ompl/control/SpaceInformation.h>
 #include <boost/geometry/algorithms/correct.hpp>
@@ -12,32 +13,40 @@ namespace ob = ompl::base;
 namespace oc = ompl::control;
 
 
-class PCCBlackmoreSVC : public ob::StateValidityChecker {
+class PCCBlackmoreSVC : public ob::StateValidityChecker, public BatchValidityChecker {
 	public:
 		PCCBlackmoreSVC(const oc::SpaceInformationPtr &si, InstancePtr mrmp_instance, const Robot *r, const double accep_prob);
 		~PCCBlackmoreSVC();
 
 		virtual bool isValid(const ob::State *state) const;
 
+		std::size_t firstInvalid(const ob::State *const *states, BeliefSegment &segment) const override;
+
 	private:
+		/* the half-planes of the obstacles pass the belief (x, y, Sigma). reach bounds the margin of the
+		   half-planes (see reach_), the grid of the obstacles is only searched that far */
+		bool isClear_(const double x, const double y, const Eigen::Matrix2d &Sigma, const double reach) const;
+		/* sqrt(2 * lambda_max) * erf_inv, an upper bound on the margin along x or y of any half-plane */
+		static double reach_(const double s_xx, const double s_xy, const double s_yy, const double erf_inv)
+		{
+			const double half_tr = 0.5 * (s_xx + s_yy);
+			const double half_diff = 0.5 * (s_xx - s_yy);
+			const double lambda_max = half_tr + std::sqrt(half_diff * half_diff + s_xy * s_xy);
+			return std::sqrt(2 * std::max(lambda_max, 0.0)) * std::max(erf_inv, 0.0) * (1 + 1e-9) + 1e-12;
+		}
+
 		const ob::SpaceInformation *si_;
     	InstancePtr mrmp_instance_;
     	const Robot *robot_; 
 		double p_collision_;
-		double erf_inv_result_;
+		double erf_inv_result_{0};
         int n_obstacles_ = -1;
 
-		std::vector<Eigen::Matrix<double, 4, 2> > A_list_;
-		std::vector<Eigen::Matrix<double, 4, 1> > B_list_;
+		/* the obstacles (Minkowski sums) with their half-planes. Their grid is only used if every half-plane is axis-aligned */
+		std::shared_ptr<const InflatedObstacles> inflated_;
         Eigen::Matrix2d PX;
 
 		inline double computeInverseErrorFunction_(const double &argument) {
 			return boost::math::erf_inv(argument);
 		}
-		bool HyperplaneCCValidityChecker_(const Eigen::MatrixXd &A, const Eigen::MatrixXd &B, const double &x_pose, const double &y_pose, const Eigen::Matrix2d &PX) const;
-		std::pair<Eigen::MatrixXd, Eigen::MatrixXd> getHalfPlanes_(Polygon combined_poly);
-		Polygon getMinkowskiSum_(const Robot* r, Obstacle* &obs);
-		Point addPoints_(const Point &a, const Point &b);
-		Point subtractPoints_(const Point &a, const Point &b);
-		double crossProduct_(const Point &a, const Point &b);
 };
@@ -20,4 +20,5 @@ private:
     const ob::SpaceInformation *si_;
     InstancePtr mrmp_instance_;
     const Robot *robot_; 
+    std::shared_ptr<const OccupancyQuadtree> occupancy_;  // nullptr if the map has none
 };
@@ -0,0 +1,99 @@
+#pragma once
+#include "StatePropogators/AgentDecoupledStatePropagator.h"
+#include "StateValidityCheckers/AgentDecoupledValidityChecker.h"
+#include <ompl/control/SpaceInformation.h>
+#include <functional>
+#include <vector>
+
+namespace ob = ompl::base;
+namespace oc = ompl::control;
+
+
+/* Propagation of a joint (multi-robot) state in which only the active agents move, as SpaceInformation's
+   propagateWhileValid. The inactive agents stay at their sub-states of source: an AgentDecoupledStatePropagator
+   does not propagate them, and after any other propagator freeze(previous, active, state) copies them back. Every new state
+   is checked agent by agent (only the active ones, the others did not move) before the agents are checked against
+   each other, so an edge that takes one agent into an obstacle is rejected before the pairs are looked at. Without
+   an AgentDecoupledValidityChecker the joint isValid is used. */
+class AgentDecoupledPropagation
+{
+public:
+    /* the sub-states of the agents that are not active are copied from the first state to the last one */
+    typedef std::function<void(const ob::State *, const std::vector<bool> &, ob::State *)> Freeze;
+
+    AgentDecoupledPropagation(const oc::SpaceInformation *si, Freeze freeze): si_(si), freeze_(std::move(freeze))
+    {
+        decoupled_ = dynamic_cast<const AgentDecoupledStatePropagator *>(si_->getStatePropagator().get());
+        checker_ = dynamic_cast<const AgentDecoupledValidityChecker *>(si_->getStateValidityChecker().get());
+    }
+
+    /* the number of valid steps (at most steps) of control from source, the last valid state in result (source if
+       none is) */
+    unsigned int propagateWhileValid(const ob::State *source, const oc::Control *control, const unsigned int steps,
+        const std::vector<bool> &active, ob::State *result) const
+    {
+        si_->copyState(result, source);
+        if (steps == 0)
+            return 0;
+        ob::State *next = si_->allocState();
+        unsigned int k = 0;
+        for (; k < steps; k++) {
+            step_(result, control, active, next);
+            if (!isValid_(next, active))
+                break;
+            si_->copyState(result, next);
+        }
+        si_->freeState(next);
+        return k;
+    }
+
+    /* the same, with every valid state (allocated) appended to states */
+    unsigned int propagateWhileValid(const ob::State *source, const oc::Control *control, const unsigned int steps,
+        const std::vector<bool> &active, std::vector<ob::State *> &states) const
+    {
+        const ob::State *from = source;
+        unsigned int k = 0;
+        for (; k < steps; k++) {
+            ob::State *next = si_->allocState();
+            step_(from, control, active, next);
+            if (!isValid_(next, active)) {
+                si_->freeState(next);
+                break;
+            }
+            states.push_back(next);
+            from = next;
+        }
+        return k;
+    }
+
+private:
+    void step_(const ob::State *from, const oc::Control *control, const std::vector<bool> &active, ob::State *to) const
+    {
+        const double dt = si_->getPropagationStepSize();
+        if (decoupled_) {
+            si_->copyState(to, from);
+            decoupled_->propagateAgents(from, control, dt, active, to);
+        }
+        else {
+            si_->getStatePropagator()->propagate(from, control, dt, to);
+            freeze_(from, active, to);
+        }
+    }
+
+    bool isValid_(const ob::State *st, const std::vector<bool> &active) const
+    {
+        if (!checker_)
+            return si_->isValid(st);
+        // fail on the first agent that is not valid on its own
+        for (std::size_t a = 0; a < active.size(); a++) {
+            if (active[a] && !checker_->isAgentValid(st, a))
+                return false;
+        }
+        return checker_->areAgentsSeparated(st, active);
+    }
+
+    const oc::SpaceInformation *si_;
+    Freeze freeze_;
+    const AgentDecoupledStatePropagator *decoupled_{nullptr};
+    const AgentDecoupledValidityChecker *checker_{nullptr};
+};
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/* Allocation accounting of the subsystems that hold most of the memory of planning: the beliefs handed out by the
+   belief spaces, the motions (and witnesses) of the low-level trees, the constraints and the nodes of the conflict
+   tree. Accounting is off by default; once enabled, every allocation and release of a subsystem is counted, so a
+   subsystem whose live bytes do not return to zero after planning leaks:
+
+	alloc::setEnabled(true);
+	const alloc::Window window;  // the peaks of the phase
+	...
+	const alloc::Usage u = alloc::usage(alloc::CONFLICT_TREE);
+
+   The counters are those of the process (relaxed atomics), shared by the planners running at once. An object counts
+   its bytes as they were when it was made, so its release balances its allocation even if it grew meanwhile. */
+
+namespace alloc
+{
+    enum Subsystem
+    {
+        BELIEF_STATES,  // beliefs handed out by the belief spaces (those in their pools are not live)
+        MOTIONS,        // motions and witnesses of the low-level trees
+        CONSTRAINTS,    // constraints and their records
+        CONFLICT_TREE,  // nodes of the conflict tree of K-CBS
+        NUM_SUBSYSTEMS
+    };
+
+    const char *name(const Subsystem s);
+
+    struct Usage
+    {
+        std::size_t live_bytes_{0};
+        std::size_t peak_bytes_{0};  // largest live_bytes_ since the first open window (or since enabled)
+        std::uint64_t allocations_{0};
+        std::uint64_t frees_{0};
+        std::uint64_t allocated_bytes_{0};  // of all allocations so far
+    };
+
+    /* turn accounting on or off for all threads. The arenas and constraints only release what they counted, but a
+       belief allocated while it was off and freed while it is on is not, so it is turned on before planning */
+    void setEnabled(const bool enabled);
+
+    bool isEnabled();
+
+    void onAlloc(const Subsystem s, const std::size_t bytes);
+
+    /* the release of count objects of bytes in all */
+    void onFree(const Subsystem s, const std::size_t bytes, const std::uint64_t count = 1);
+
+    Usage usage(const Subsystem s);
+
+    /* restart the peaks from the live bytes */
+    void resetPeaks();
+
+    /* A phase whose peaks are measured: the first window to open resets the peaks, the windows opened while it is
+       (those of nested or concurrent phases) share them */
+    class Window
+    {
+    public:
+        Window();
+
+        ~Window();
+
+        Window(const Window &) = delete;
+        Window &operator=(const Window &) = delete;
+    };
+}
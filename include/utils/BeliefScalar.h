@@ -0,0 +1,12 @@
+#pragma once
+
+/* The scalar of the belief kernels: the chance constraints of the half-planes (see BlackmoreHalfPlanes.h) and the
+   distance of the fixed-size belief spaces (see FixedBeliefSpace.h). Build with -DKCBS_BELIEF_FLOAT=ON to evaluate
+   them in single precision, which doubles the lanes of their vectors and halves the coefficients they stream. The
+   states keep double storage (they are OMPL real vectors), so only the arithmetic of the kernels is affected.
+   kcbs-microbench --benchmark_filter=Precision compares the decisions of both precisions. */
+#ifdef KCBS_BELIEF_FLOAT
+typedef float BeliefScalar;
+#else
+typedef double BeliefScalar;
+#endif
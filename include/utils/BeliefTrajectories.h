@@ -0,0 +1,92 @@
+#pragma once
+#include "Spaces/RealVectorBeliefSpace.h"
+#include "utils/DiscretePlan.h"
+#include <Eigen/Core>
+#include <vector>
+
+
+/* The beliefs of the agents of a plan as structure of arrays: per agent, the x and y means and the x-y covariance
+   entries of every step are contiguous. The belief validators read them by agent index, instead of building a map
+   of heap-allocated beliefs (keyed by robot name) for every step. */
+class BeliefTrajectories
+{
+public:
+    /* the beliefs of the first max_states steps of the trajectories of agents (every agent if empty) */
+    BeliefTrajectories(const DiscretePlan &p, const int max_states, const std::vector<int> &agents = {});
+
+    /* number of agents of the plan (including those whose beliefs were not extracted) */
+    std::size_t size() const {return trajs_.size();};
+
+    /* max_states, the steps that may be read */
+    int steps() const {return steps_;};
+
+    /* the last step whose belief of agent was extracted: the agent is parked at it from then on (its trajectory
+       ended), unless it is the last of the steps */
+    int lastStep(const int agent) const {return static_cast<int>(trajs_[agent].mu_x_.size()) - 1;};
+
+    /* belief of agent at step, which is its last belief once its trajectory ended. step must be below max_states */
+    double x(const int agent, const int step) const {return trajs_[agent].mu_x_[at_(agent, step)];};
+    double y(const int agent, const int step) const {return trajs_[agent].mu_y_[at_(agent, step)];};
+    double sigmaXX(const int agent, const int step) const {return trajs_[agent].s_xx_[at_(agent, step)];};
+    double sigmaXY(const int agent, const int step) const {return trajs_[agent].s_xy_[at_(agent, step)];};
+    double sigmaYY(const int agent, const int step) const {return trajs_[agent].s_yy_[at_(agent, step)];};
+
+    Eigen::Vector2d mean(const int agent, const int step) const
+    {
+        const std::size_t k = at_(agent, step);
+        return Eigen::Vector2d(trajs_[agent].mu_x_[k], trajs_[agent].mu_y_[k]);
+    };
+
+    Eigen::Matrix2d covariance(const int agent, const int step) const
+    {
+        const std::size_t k = at_(agent, step);
+        Eigen::Matrix2d Sigma;
+        Sigma << trajs_[agent].s_xx_[k], trajs_[agent].s_xy_[k], trajs_[agent].s_xy_[k], trajs_[agent].s_yy_[k];
+        return Sigma;
+    };
+
+    /* the x-y mean and covariance (sigma + lambda) of a belief state. False if its space has no known x-y covariance */
+    static bool extract(const ompl::base::State *st, double &x, double &y, double &s_xx, double &s_xy, double &s_yy);
+
+    /* extract, for a state whose covariance is known to be Rows x Rows (2 or 4): y is entry 1 of a 2-D belief and
+       entry 2 of a 4-D one, so nothing is decided per state */
+    template <int Rows>
+    static void extractAs(const ompl::base::State *st, double &x, double &y, double &s_xx, double &s_xy, double &s_yy)
+    {
+        static_assert(Rows == 2 || Rows == 4, "the x-y covariance is only known for 2-D and 4-D beliefs");
+        constexpr Eigen::Index iy = (Rows == 4) ? 2 : 1;
+        const RealVectorBeliefSpace::StateType *belief = st->as<RealVectorBeliefSpace::StateType>();
+        x = belief->values[0];
+        y = belief->values[1];
+        s_xx = belief->sigma_(0, 0) + belief->lambda_(0, 0);
+        s_xy = belief->sigma_(0, iy) + belief->lambda_(0, iy);
+        s_yy = belief->sigma_(iy, iy) + belief->lambda_(iy, iy);
+    }
+
+private:
+    struct Trajectory
+    {
+        std::vector<double> mu_x_;
+        std::vector<double> mu_y_;
+        std::vector<double> s_xx_;
+        std::vector<double> s_xy_;
+        std::vector<double> s_yy_;
+    };
+
+    /* the first n beliefs of path into traj, all Rows x Rows */
+    template <int Rows>
+    static void fill_(const ompl::control::PathControl &path, const std::size_t n, Trajectory &traj)
+    {
+        for (std::size_t k = 0; k < n; k++)
+            extractAs<Rows>(path.getState(k), traj.mu_x_[k], traj.mu_y_[k], traj.s_xx_[k], traj.s_xy_[k], traj.s_yy_[k]);
+    }
+
+    std::size_t at_(const int agent, const int step) const
+    {
+        const std::size_t n = trajs_[agent].mu_x_.size();
+        return (static_cast<std::size_t>(step) < n) ? step : n - 1;
+    }
+
+    std::vector<Trajectory> trajs_;
+    int steps_;
+};
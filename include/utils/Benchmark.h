@@ -1,5 +1,8 @@
 #pragma once
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 #include <fstream>
 #include <iostream>
@@ -15,12 +18,63 @@
 #include "PlanValidityCheckers/ChiSquaredBoundaryPVC.h"
 #include "PlanValidityCheckers/BoundingBoxBlackmorePVC.h"
 #include "PlanValidityCheckers/CDFGridPVC.h"
+#include "PlanValidityCheckers/CascadePVC.h"
+#include "PlanValidityCheckers/MonteCarloPVC.h"
 #include "Planners/KCBS.h"
 #include "utils/OmplSetUp.h"
+#include "utils/AllocStats.h"
+#include "utils/PerfCounters.h"
+#include "utils/ResultsSink.h"
 
 
-void write_csv(std::string filename, std::tuple<bool, double, double> results);
+/* Settings of the benchmark runners. Every worker builds its own instance, planners and validators from the command
+   line and takes the next trial until all of them ran, so the trials of a configuration run side by side */
+struct BenchmarkOptions
+{
+    unsigned int trials_{50};
+    unsigned int workers_{1};
+    bool pin_cpus_{false};      // pin worker w to CPU w, so concurrent trials are not migrated between cores
+    std::uint32_t seed_{0};     // seed of OMPL's random number generators (0 to let OMPL pick one)
+    // (name, value) columns written first in every row, e.g. the configuration of a sweep
+    std::vector<std::pair<std::string, std::string>> labels_;
+    // write the columns of the K-CBS statistics for every planner (empty for the others), so all rows form one table
+    bool kcbs_columns_{false};
+    // collect the hardware counters (cycles, instructions, cache and branch misses) of every phase, see utils/PerfCounters.h
+    bool perf_counters_{false};
+    // account the allocations of the planning subsystems, and write their columns for K-CBS, see utils/AllocStats.h
+    bool alloc_stats_{false};
+    // rows go to this sink instead of one opened on the file of the runner (e.g. one sink for all runs of a sweep)
+    ResultsSinkPtr sink_{nullptr};
+};
 
-void run_kcbs_benchmark(InstancePtr mrmp_instance, const double merge_bound, const double comp_time,  std::string filename);
+/* The trial a result belongs to, recorded with it */
+struct BenchmarkTrial
+{
+    unsigned int trial_;
+    unsigned int worker_;
+    std::uint32_t seed_;
+    const std::vector<std::pair<std::string, std::string>> *labels_{nullptr};
+    bool perf_counters_{false};  // write the hardware counter columns
+    bool alloc_stats_{false};    // write the allocation columns
+};
 
-void run_centralized_bsst_benchmark(InstancePtr mrmp_instance, const double comp_time, std::string filename);
+/* the problem definition of K-CBS for mrmp_instance, with the merger and plan validator of its low-level planner */
+MultiRobotProblemDefinitionPtr set_up_kcbs(InstancePtr mrmp_instance);
+
+/* clear the solutions and trees of the low-level planners of mrmp_pdef, so it can be planned again */
+void clear_trial(const MultiRobotProblemDefinitionPtr &mrmp_pdef);
+
+/* builds the instance of a worker. Called by the workers concurrently */
+typedef std::function<InstancePtr()> InstanceFactory;
+
+void run_kcbs_benchmark(const po::variables_map &vm, const double merge_bound, const double comp_time, std::string filename,
+    const BenchmarkOptions &options = BenchmarkOptions());
+
+void run_kcbs_benchmark(const InstanceFactory &make_instance, const double merge_bound, const double comp_time,
+    std::string filename, const BenchmarkOptions &options = BenchmarkOptions());
+
+void run_centralized_bsst_benchmark(const po::variables_map &vm, const double comp_time, std::string filename,
+    const BenchmarkOptions &options = BenchmarkOptions());
+
+void run_centralized_bsst_benchmark(const InstanceFactory &make_instance, const double comp_time, std::string filename,
+    const BenchmarkOptions &options = BenchmarkOptions());
@@ -0,0 +1,136 @@
+#pragma once
+#include "utils/BeliefScalar.h"
+#include <Eigen/Core>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+
+/* The half-planes of a list of quadrilaterals (e.g. the Minkowski sums of the obstacles) with the chance
+   constraint of Blackmore et al. A belief (mu, Sigma) is safe from a quadrilateral if, for one of its edges,
+   a^T mu - b >= sqrt(2 a^T Sigma a) * erf_inv. The coefficients are stored as a structure of arrays with
+   the quadrilaterals contiguous for every edge, so allSafe() evaluates a block of them per instruction. The
+   list is padded with half-planes that every belief satisfies. The tests are evaluated in Scalar (see
+   BeliefScalar.h), so a block holds as many quadrilaterals as fit in 8 doubles. */
+template <typename Scalar>
+class BasicBlackmoreHalfPlanes
+{
+public:
+    static constexpr std::size_t edges_ = 4;
+
+    /* add the quadrilateral A x <= B */
+    void add(const Eigen::Ref<const Eigen::MatrixXd> &A, const Eigen::Ref<const Eigen::MatrixXd> &B)
+    {
+        if (size_ % block_ == 0) {
+            for (std::size_t i = 0; i < edges_; i++) {
+                a0_[i].resize(size_ + block_, 0);
+                a1_[i].resize(size_ + block_, 0);
+                b_[i].resize(size_ + block_, -std::numeric_limits<Scalar>::infinity());
+            }
+        }
+        for (std::size_t i = 0; i < edges_; i++) {
+            a0_[i][size_] = A(i, 0);
+            a1_[i][size_] = A(i, 1);
+            b_[i][size_] = B(i, 0);
+        }
+        size_++;
+    }
+
+    std::size_t size() const {return size_;};
+
+    /* true if (mu, Sigma) is safe from quadrilateral o */
+    bool isSafe(const std::size_t o, const double x, const double y, const Eigen::Matrix2d &Sigma, const double erf_inv) const
+    {
+        const Scalar scale = 2 * erf_inv * erf_inv;
+        for (std::size_t i = 0; i < edges_; i++) {
+            const Scalar a0 = a0_[i][o], a1 = a1_[i][o];
+            const Scalar margin = a0 * Scalar(x) + a1 * Scalar(y) - b_[i][o];
+            const Scalar quad = (a0 * Scalar(Sigma(0, 0)) + a1 * Scalar(Sigma(1, 0))) * a0 + 
+                (a0 * Scalar(Sigma(0, 1)) + a1 * Scalar(Sigma(1, 1))) * a1;
+            const Scalar far = margin * margin - scale * quad;
+            if ((erf_inv >= 0) ? (margin >= 0 && far >= 0) : (margin >= 0 || far <= 0))
+                return true;
+        }
+        return false;
+    }
+
+    /* true if (mu, Sigma) is safe from every quadrilateral. Stops at the first block with an unsafe one */
+    bool allSafe(const double x, const double y, const Eigen::Matrix2d &Sigma, const double erf_inv) const
+    {
+        if (erf_inv >= 0)
+            return allSafe_<true>(x, y, Sigma, erf_inv);
+        return allSafe_<false>(x, y, Sigma, erf_inv);
+    }
+
+private:
+    static constexpr std::size_t block_ = 8 * sizeof(double) / sizeof(Scalar);
+    typedef Eigen::Array<Scalar, block_, 1> Lanes;
+
+    /* margin >= sqrt(2 quad) * erf_inv is tested on the squares, so the lanes need no square root */
+    template <bool Positive>
+    bool allSafe_(const double x, const double y, const Eigen::Matrix2d &Sigma, const double erf_inv) const
+    {
+        const Scalar scale = 2 * erf_inv * erf_inv;
+        const Scalar s00 = Sigma(0, 0), s01 = Sigma(0, 1), s10 = Sigma(1, 0), s11 = Sigma(1, 1);
+        const Scalar px = x, py = y;
+        for (std::size_t o0 = 0; o0 < size_; o0 += block_) {
+            // a lane is safe once one of its edges has a non-negative score
+            Lanes score = Lanes::Constant(-1);
+            for (std::size_t i = 0; i < edges_; i++) {
+                const Eigen::Map<const Lanes> a0(a0_[i].data() + o0), a1(a1_[i].data() + o0), b(b_[i].data() + o0);
+                const Lanes margin = a0 * px + a1 * py - b;
+                const Lanes quad = (a0 * s00 + a1 * s10) * a0 + (a0 * s01 + a1 * s11) * a1;
+                const Lanes far = margin.square() - scale * quad;
+                if constexpr (Positive)
+                    score = score.max(margin.min(far));
+                else
+                    score = score.max(margin.max(-far));
+            }
+            if (!(score.minCoeff() >= 0))
+                return false;
+        }
+        return true;
+    }
+
+    std::vector<Scalar> a0_[edges_];
+    std::vector<Scalar> a1_[edges_];
+    std::vector<Scalar> b_[edges_];
+    std::size_t size_{0};
+};
+
+typedef BasicBlackmoreHalfPlanes<BeliefScalar> BlackmoreHalfPlanes;
+
+/* The half-planes A x <= B of a single quadrilateral (e.g. the Minkowski sum of a pair of robots), in fixed-size
+   storage. isSafe() is the chance constraint of BlackmoreHalfPlanes, in Scalar. By default every belief is safe */
+template <typename Scalar>
+struct BasicQuadHalfPlanes
+{
+    typedef Eigen::Matrix<Scalar, 4, 2> MatrixA;
+    typedef Eigen::Matrix<Scalar, 4, 1> VectorB;
+
+    BasicQuadHalfPlanes(): A_(MatrixA::Zero()), B_(VectorB::Constant(-std::numeric_limits<Scalar>::infinity())) {}
+
+    BasicQuadHalfPlanes(const Eigen::Ref<const Eigen::MatrixXd> &A, const Eigen::Ref<const Eigen::MatrixXd> &B): 
+        A_(A.cast<Scalar>()), B_(B.cast<Scalar>()) {}
+
+    /* true if (mu, Sigma) is safe from the quadrilateral */
+    bool isSafe(const double x, const double y, const Eigen::Matrix2d &Sigma, const double erf_inv) const
+    {
+        const Scalar scale = 2 * erf_inv * erf_inv;
+        for (int i = 0; i < 4; i++) {
+            const Scalar a0 = A_(i, 0), a1 = A_(i, 1);
+            const Scalar margin = a0 * Scalar(x) + a1 * Scalar(y) - B_[i];
+            const Scalar quad = (a0 * Scalar(Sigma(0, 0)) + a1 * Scalar(Sigma(1, 0))) * a0 + 
+                (a0 * Scalar(Sigma(0, 1)) + a1 * Scalar(Sigma(1, 1))) * a1;
+            const Scalar far = margin * margin - scale * quad;
+            if ((erf_inv >= 0) ? (margin >= 0 && far >= 0) : (margin >= 0 || far <= 0))
+                return true;
+        }
+        return false;
+    }
+
+    MatrixA A_;
+    VectorB B_;
+};
+
+typedef BasicQuadHalfPlanes<BeliefScalar> QuadHalfPlanes;
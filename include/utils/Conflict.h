@@ -6,6 +6,7 @@ OMPL_CLASS_FORWARD(Conflict);
 struct Conflict
 {
 	Conflict(int agent1Idx, int agent2Idx, int timeStep);
+	virtual ~Conflict() = default;
 	const int agent1Idx_; 
 	const int agent2Idx_;
 	const int timeStep_;
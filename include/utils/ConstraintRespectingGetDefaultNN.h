@@ -1,5 +1,8 @@
 #pragma once
 #include "Planners/ConstraintRespectingPlanner.h"
+#include "Spaces/RealVectorBeliefSpace.h"
+#include "utils/NearestNeighborsHashGrid.h"
+#include "utils/NearestNeighborsMeanGrid.h"
 #include <ompl/datastructures/NearestNeighbors.h>
 #include <ompl/tools/config/SelfConfig.h>
 /** \brief Select a default nearest neighbor datastructure for the given space
@@ -29,5 +32,34 @@ namespace ompl
             }
             return new NearestNeighborsSqrtApprox<_T>();
         }
+
+        /** \brief Select a grid over the mean positions (see NearestNeighborsMeanGrid) for motions of a belief space, 
+            with cells of cell_size, spanning the bounds of the space. Returns nullptr for any other space */
+        template <typename _T>
+        static NearestNeighbors<_T> *getBeliefNearestNeighbors(const base::Planner *planner, const double cell_size)
+        {
+            const auto *space = dynamic_cast<const RealVectorBeliefSpace *>(planner->getSpaceInformation()->getStateSpace().get());
+            if (!space || space->getDimension() < 2)
+                return nullptr;
+            const base::RealVectorBounds &bounds = space->getBounds();
+            return new NearestNeighborsMeanGrid<_T>([](const _T &m) {
+                    const double *mean = m->state_->template as<RealVectorBeliefSpace::StateType>()->values;
+                    return std::make_pair(mean[0], mean[1]);
+                }, bounds.low[0], bounds.high[0], bounds.low[1], bounds.high[1], cell_size);
+        }
+
+        /** \brief Select a hash grid over the mean positions (see NearestNeighborsHashGrid) for the witnesses of a belief
+            space, with cells of cell_size. Returns nullptr for any other space */
+        template <typename _T>
+        static NearestNeighborsHashGrid<_T> *getWitnessNearestNeighbors(const base::Planner *planner, const double cell_size)
+        {
+            const auto *space = dynamic_cast<const RealVectorBeliefSpace *>(planner->getSpaceInformation()->getStateSpace().get());
+            if (!space || space->getDimension() < 2)
+                return nullptr;
+            return new NearestNeighborsHashGrid<_T>([](const _T &m) {
+                    const double *mean = m->state_->template as<RealVectorBeliefSpace::StateType>()->values;
+                    return std::make_pair(mean[0], mean[1]);
+                }, cell_size);
+        }
     }
-}
\ No newline at end of file
+}
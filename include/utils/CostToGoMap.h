@@ -0,0 +1,49 @@
+#pragma once
+#include "utils/InflatedObstacles.h"
+#include <ompl/util/RandomNumbers.h>
+#include <cstddef>
+#include <vector>
+
+
+/* Cost-to-go of a robot over a grid of the map: the length of the shortest 8-connected path of free cells from a
+   cell to the cell of the goal (Dijkstra from the goal). A cell is free if its center is outside the obstacles
+   inflated by the bounding shape of the robot, so the cost-to-go ignores the dynamics and underestimates nothing
+   but the clearance of narrow passages. It is computed once per robot (see Instance::getCostToGoMap) and is not
+   modified once built. */
+class CostToGoMap
+{
+public:
+    CostToGoMap(const InflatedObstacles &obstacles, const double x_low, const double x_high, const double y_low,
+        const double y_high, const double goal_x, const double goal_y, const double resolution);
+
+    /* cost-to-go of the cell of (x, y), +inf if it is blocked, unreachable or outside of the grid */
+    double costToGo(const double x, const double y) const;
+
+    /* true if the goal is reachable from some cell */
+    bool empty() const {return reachable_.empty();};
+
+    /* a point drawn uniformly in the cells from which the goal is reachable */
+    void sampleReachable(ompl::RNG &rng, double &x, double &y) const;
+
+    /* the center of the cell reached by following the steepest descent of the cost-to-go from the cell of (x, y)
+       for distance (or up to the goal). False if the goal is not reachable from (x, y) */
+    bool ahead(const double x, const double y, const double distance, double &ax, double &ay) const;
+
+    double getResolution() const {return res_;};
+
+private:
+    /* index of the cell of (x, y), -1 outside of the grid */
+    long cell_(const double x, const double y) const;
+
+    double centerX_(const long c) const {return x_low_ + (c / ny_ + 0.5) * res_;};
+    double centerY_(const long c) const {return y_low_ + (c % ny_ + 0.5) * res_;};
+
+    std::vector<double> cost_;
+    /* the cells of finite cost */
+    std::vector<long> reachable_;
+    double x_low_;
+    double y_low_;
+    double res_;
+    long nx_;
+    long ny_;
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include "utils/CostToGoMap.h"
+#include <ompl/base/StateSampler.h>
+#include <ompl/base/StateSpace.h>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+namespace ob = ompl::base;
+
+
+/* Informed sampling of a low-level planner from the cost-to-go of its robot. The position of a sample (the first
+   two coordinates of the state, or of its first component) is drawn in the cells from which the goal is reachable
+   instead of over the whole map, and with probability bias it is placed ahead of the frontier of the tree (the
+   position of least cost-to-go reached so far) along decreasing cost-to-go, so the nearest or best node selected
+   for expansion is near the frontier and grows towards the goal. The other coordinates are sampled as before.
+   One per tree: update() is called with every state added to it. Thread-safe. */
+class CostToGoSampler
+{
+public:
+    CostToGoSampler(const ob::StateSpacePtr &space, std::shared_ptr<const CostToGoMap> map, const double lookahead = 2.0):
+        space_(space), map_(std::move(map)), lookahead_(lookahead) {}
+
+    /* sample st with base, then draw its position as above */
+    void sample(ob::StateSampler &base, ompl::RNG &rng, const double bias, ob::State *st) const;
+
+    /* record the position of a state added to the tree */
+    void update(const ob::State *st);
+
+    /* forget the frontier (the tree was cleared) */
+    void reset();
+
+    /* cost-to-go of the position of st */
+    double costToGo(const ob::State *st) const;
+
+    const CostToGoMap &getMap() const {return *map_;};
+
+    /* the position of a state of space */
+    static void getPosition(const ob::StateSpace *space, const ob::State *st, double &x, double &y);
+    static void setPosition(const ob::StateSpace *space, ob::State *st, const double x, const double y);
+
+private:
+    const ob::StateSpacePtr space_;
+    const std::shared_ptr<const CostToGoMap> map_;
+    const double lookahead_;
+    mutable std::mutex frontier_mutex_;
+    double frontier_x_{0};
+    double frontier_y_{0};
+    double frontier_cost_{std::numeric_limits<double>::infinity()};
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include <Eigen/Dense>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+
+/* Cache of a covariance update that does not depend on the control, such as the Kalman filter step of the
+   linear-Gaussian propagators. Every start of a problem has the same covariances, so the covariances of a tree
+   follow a fixed sequence and the update of each (sigma, lambda) is computed once. Entries are keyed by the
+   exact bits of the input, so a hit returns what the update would have returned. Lookups may run concurrently.
+   Once max_entries_ distinct inputs are stored, the update of any other input is computed every time. */
+template <int N>
+class CovarianceCache
+{
+public:
+	typedef Eigen::Matrix<double, N, N> Matrix;
+
+	CovarianceCache(const std::size_t max_entries = 1 << 14): max_entries_(max_entries) {}
+
+	CovarianceCache(const CovarianceCache &) = delete;
+	CovarianceCache &operator=(const CovarianceCache &) = delete;
+
+	/* the update of (sigma, lambda). On a miss, update(sigma, lambda, nxt_sigma, nxt_lambda) computes it */
+	template <typename Update>
+	void propagate(const Matrix &sigma, const Matrix &lambda, Matrix &nxt_sigma, Matrix &nxt_lambda, const Update &update) const
+	{
+		Key key;
+		Eigen::Map<Matrix>(key.values_) = sigma;
+		Eigen::Map<Matrix>(key.values_ + N * N) = lambda;
+		{
+			std::shared_lock<std::shared_mutex> lock(mutex_);
+			auto itr = entries_.find(key);
+			if (itr != entries_.end()) {
+				nxt_sigma = Eigen::Map<const Matrix>(itr->second.values_);
+				nxt_lambda = Eigen::Map<const Matrix>(itr->second.values_ + N * N);
+				return;
+			}
+		}
+		update(sigma, lambda, nxt_sigma, nxt_lambda);
+		Key value;
+		Eigen::Map<Matrix>(value.values_) = nxt_sigma;
+		Eigen::Map<Matrix>(value.values_ + N * N) = nxt_lambda;
+		std::unique_lock<std::shared_mutex> lock(mutex_);
+		if (entries_.size() < max_entries_)
+			entries_.emplace(key, value);
+	}
+
+	std::size_t size() const
+	{
+		std::shared_lock<std::shared_mutex> lock(mutex_);
+		return entries_.size();
+	}
+
+	void clear()
+	{
+		std::unique_lock<std::shared_mutex> lock(mutex_);
+		entries_.clear();
+	}
+
+private:
+	/* both covariances, column-major */
+	struct Key
+	{
+		double values_[2 * N * N];
+
+		bool operator==(const Key &other) const
+		{
+			return std::memcmp(values_, other.values_, sizeof(values_)) == 0;
+		}
+	};
+
+	struct KeyHash
+	{
+		std::size_t operator()(const Key &key) const
+		{
+			std::uint64_t h = 1469598103934665603ull;
+			for (std::size_t i = 0; i < 2 * N * N; i++) {
+				std::uint64_t bits;
+				std::memcpy(&bits, &key.values_[i], sizeof(bits));
+				h = (h ^ bits) * 1099511628211ull;
+			}
+			return h ^ (h >> 32);
+		}
+	};
+
+	const std::size_t max_entries_;
+	mutable std::shared_mutex mutex_;
+	mutable std::unordered_map<Key, Key, KeyHash> entries_;
+};
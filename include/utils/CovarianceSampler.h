@@ -0,0 +1,46 @@
+#pragma once
+#include <ompl/control/SpaceInformation.h>
+#include <ompl/util/RandomNumbers.h>
+#include <Eigen/Core>
+#include <vector>
+
+namespace ob = ompl::base;
+namespace oc = ompl::control;
+
+
+/* Covariance of the beliefs sampled by the belief planners (BSST, ConstraintRespectingBSST, CentralizedBSST). The
+   mean of a sample is drawn by the state sampler, then sample() sets its sigma and lambda. Thread-safe. */
+class CovarianceSampler
+{
+public:
+    virtual ~CovarianceSampler() = default;
+
+    /* set the covariances of the belief st (a RealVectorBeliefSpace state) */
+    virtual void sample(ompl::RNG &rng, ob::State *st) const = 0;
+};
+
+
+/* Covariances drawn from the sequence the propagator reaches from the start belief. The (Kalman) covariance of a
+   linear propagator does not depend on the control, so every node k steps deep in the tree has covariance k of this
+   sequence, and a sample is only close (in the Wasserstein distance) to a node if its covariance is one of them.
+   The sequence is propagated with the null control until it converges or for horizon steps, and step k is drawn
+   uniformly in [0, horizon), the steps after convergence taking the last covariance. For a propagator whose
+   covariance depends on the controls it is the covariance reached by standing still. */
+class ReachableCovarianceSampler: public CovarianceSampler
+{
+public:
+    ReachableCovarianceSampler(const oc::SpaceInformation *si, const ob::State *start, const unsigned int horizon,
+        const double tolerance = 1e-9);
+
+    void sample(ompl::RNG &rng, ob::State *st) const override;
+
+    /* number of distinct covariances of the sequence (the start one included) */
+    std::size_t size() const {return sigmas_.size();};
+
+    unsigned int getHorizon() const {return horizon_;};
+
+private:
+    const unsigned int horizon_;
+    std::vector<Eigen::MatrixXd> sigmas_;
+    std::vector<Eigen::MatrixXd> lambdas_;
+};
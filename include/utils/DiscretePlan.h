@@ -0,0 +1,130 @@
+#pragma once
+#include "utils/TrajectoryBVH.h"
+#include <ompl/control/PathControl.h>
+#include <ompl/control/SpaceInformation.h>
+#include <boost/iterator/indirect_iterator.hpp>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace oc = ompl::control;
+
+
+/* A plan whose trajectories are interpolated to the propagation step size, so that state k of every trajectory
+   is at time k * step. The trajectories are immutable and shared (e.g. between a node and its children), so the
+   plan validators read them without copying or interpolating them again. */
+class DiscretePlan
+{
+public:
+	typedef std::shared_ptr<const oc::PathControl> TrajectoryPtr;
+	typedef boost::indirect_iterator<std::vector<TrajectoryPtr>::const_iterator> const_iterator;
+
+	DiscretePlan() = default;
+
+	/* interpolate a copy of every trajectory of plan */
+	explicit DiscretePlan(const std::vector<oc::PathControl> &plan)
+	{
+		trajs_.reserve(plan.size());
+		for (const oc::PathControl &traj: plan)
+			trajs_.push_back(discretize(traj));
+		resetBVHs_();
+		updateMaxStates_();
+	}
+
+	/* the trajectories must already be interpolated (see discretize) */
+	explicit DiscretePlan(std::vector<TrajectoryPtr> trajs): trajs_(std::move(trajs))
+	{
+		resetBVHs_();
+		updateMaxStates_();
+	}
+
+	/* the same plan in which agent follows traj (already interpolated). The other trajectories are shared */
+	DiscretePlan replace(const int agent, TrajectoryPtr traj) const
+	{
+		DiscretePlan p(*this);
+		p.trajs_[agent] = std::move(traj);
+		p.bvhs_[agent] = std::make_shared<BVHSlot>();
+		p.updateMaxStates_();
+		return p;
+	}
+
+	/* an interpolated copy of traj */
+	static TrajectoryPtr discretize(const oc::PathControl &traj)
+	{
+		auto interpolated = std::make_shared<oc::PathControl>(traj);
+		interpolated->interpolate();
+		return interpolated;
+	}
+
+	/* traj itself if it is already interpolated, otherwise an interpolated copy */
+	static TrajectoryPtr discretize(const TrajectoryPtr &traj)
+	{
+		if (isDiscrete_(*traj))
+			return traj;
+		return discretize(*traj);
+	}
+
+	const oc::PathControl& operator[](const std::size_t agent) const {return *trajs_[agent];};
+
+	const TrajectoryPtr& getTrajectoryPtr(const std::size_t agent) const {return trajs_[agent];};
+
+	std::size_t size() const {return trajs_.size();};
+
+	bool empty() const {return trajs_.empty();};
+
+	const_iterator begin() const {return const_iterator(trajs_.begin());};
+
+	const_iterator end() const {return const_iterator(trajs_.end());};
+
+	/* number of states of the longest trajectory */
+	int getMaxStateCount() const {return max_states_;};
+
+	/* the bounding-volume hierarchy of the (belief) trajectory of agent. It is built on first use and shared with the
+	   plans copied from this one, so after replace() only the replaced agent gets a new one */
+	const TrajectoryBVH &getBVH(const std::size_t agent) const
+	{
+		BVHSlot &slot = *bvhs_[agent];
+		std::call_once(slot.once_, [&]() {slot.bvh_.reset(new TrajectoryBVH(*trajs_[agent]));});
+		return *slot.bvh_;
+	}
+
+private:
+	/* true if every control of traj is applied for (at most) a single propagation step, as after interpolate() */
+	static bool isDiscrete_(const oc::PathControl &traj)
+	{
+		if (traj.getStateCount() != traj.getControlCount() + 1)
+			return false;
+		const double res = static_cast<const oc::SpaceInformation *>(traj.getSpaceInformation().get())->getPropagationStepSize();
+		for (const double dt: traj.getControlDurations()) {
+			if (std::floor(0.5 + dt / res) > 1)
+				return false;
+		}
+		return true;
+	}
+
+	void updateMaxStates_()
+	{
+		max_states_ = 0;
+		for (const TrajectoryPtr &traj: trajs_)
+			max_states_ = std::max<int>(max_states_, traj->getStateCount());
+	}
+
+	struct BVHSlot
+	{
+		std::once_flag once_;
+		std::unique_ptr<const TrajectoryBVH> bvh_;
+	};
+
+	void resetBVHs_()
+	{
+		bvhs_.resize(trajs_.size());
+		for (std::shared_ptr<BVHSlot> &slot: bvhs_)
+			slot = std::make_shared<BVHSlot>();
+	}
+
+	std::vector<TrajectoryPtr> trajs_;
+	std::vector<std::shared_ptr<BVHSlot>> bvhs_;
+	int max_states_{0};
+};
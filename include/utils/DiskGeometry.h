@@ -0,0 +1,52 @@
+#pragma once
+#include "utils/common.h"
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+
+
+/* Closed-form tests between the safety disks of the chi-squared checkers and polygons. They replace
+   building a disk with bg::buffer and calling bg::disjoint, which allocates and only approximates the disk. */
+
+/* largest eigenvalue of a symmetric 2 x 2 matrix */
+inline double maxEigenvalue2x2(const Eigen::Matrix2d &m)
+{
+    const double half_tr = 0.5 * (m(0, 0) + m(1, 1));
+    const double half_diff = 0.5 * (m(0, 0) - m(1, 1));
+    return half_tr + std::sqrt(half_diff * half_diff + m(0, 1) * m(1, 0));
+}
+
+/* true if the closed disk of radius r centered on (x, y) meets the polygon (boundary or interior) */
+inline bool diskIntersectsPolygon(const double x, const double y, const double r, const Polygon &poly)
+{
+    const auto &ring = bg::exterior_ring(poly);
+    const double r2 = r * r;
+    bool inside = false;
+    for (std::size_t k = 0; k + 1 < ring.size(); k++) {
+        const double ax = bg::get<0>(ring[k]), ay = bg::get<1>(ring[k]);
+        const double ex = bg::get<0>(ring[k + 1]) - ax, ey = bg::get<1>(ring[k + 1]) - ay;
+        const double len2 = ex * ex + ey * ey;
+        const double t = (len2 > 0) ? std::clamp(((x - ax) * ex + (y - ay) * ey) / len2, 0.0, 1.0) : 0.0;
+        const double dx = ax + t * ex - x, dy = ay + t * ey - y;
+        if (dx * dx + dy * dy <= r2)
+            return true;
+        // crossing number of a ray towards +x
+        if ((ay > y) != (bg::get<1>(ring[k + 1]) > y) && x < ax + (y - ay) * ex / ey)
+            inside = !inside;
+    }
+    return inside;
+}
+
+/* true if the closed disks of radii r_a and r_b centered on a and b meet */
+inline bool disksIntersect(const double x_a, const double y_a, const double r_a, const double x_b, const double y_b, const double r_b)
+{
+    const double dx = x_a - x_b, dy = y_a - y_b;
+    return dx * dx + dy * dy <= (r_a + r_b) * (r_a + r_b);
+}
+
+/* true if the disk of radius r_a centered on a lies within the disk of radius r_b centered on b */
+inline bool diskWithinDisk(const double x_a, const double y_a, const double r_a, const double x_b, const double y_b, const double r_b)
+{
+    const double dx = x_a - x_b, dy = y_a - y_b;
+    return std::sqrt(dx * dx + dy * dy) + r_a <= r_b;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+
+/* Bounded lock-free queue of many producers and consumers (the ring of sequenced cells of D. Vyukov): a push or pop
+   claims a cell with one compare-and-swap of its end, and the sequence of the cell tells whether it is full or empty
+   yet. Neither end ever waits for the other: a push to a full queue fails, as does a pop of an empty one. The search
+   threads report their events through it (see KCBS::setProgressCallback) without blocking on the thread that reads them */
+template <typename T>
+class EventQueue
+{
+public:
+    /* room for capacity events at least (rounded up to a power of 2) */
+    explicit EventQueue(const std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+            size *= 2;
+        cells_ = std::make_unique<Cell[]>(size);
+        mask_ = size - 1;
+        for (std::size_t i = 0; i < size; i++)
+            cells_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+
+    EventQueue(const EventQueue &) = delete;
+    EventQueue &operator=(const EventQueue &) = delete;
+
+    /* false if the queue is full */
+    bool push(const T &value)
+    {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells_[pos & mask_];
+            const std::size_t sequence = cell.sequence_.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value_ = value;
+                    cell.sequence_.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            // the cell was not popped since the last round
+            else if (diff < 0)
+                return false;
+            else
+                pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+
+    /* false if the queue is empty */
+    bool pop(T &value)
+    {
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells_[pos & mask_];
+            const std::size_t sequence = cell.sequence_.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = cell.value_;
+                    cell.sequence_.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            // the cell was not pushed yet
+            else if (diff < 0)
+                return false;
+            else
+                pos = head_.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::size_t capacity() const {return mask_ + 1;};
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence_;
+        T value_;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    std::size_t mask_;
+    // the ends on lines of their own, as the producers and the consumers write one each
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    alignas(64) std::atomic<std::size_t> head_{0};
+};
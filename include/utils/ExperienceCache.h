@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+
+/* Low-level trajectories that solved earlier problems on a map, for the robots of one shape and dynamics model. A
+   trajectory is kept as the reals of its start and end states (as StateSpace::copyToReals) and its controls, so a planner
+   replays the controls from its own start (validating every step) instead of trusting the cached states. The caches are
+   shared by every instance of the process (see get), and keep the most recent trajectories up to their capacity. */
+class ExperienceCache
+{
+public:
+    struct Experience
+    {
+        std::vector<double> start_;
+        std::vector<double> end_;
+        std::vector<std::vector<double>> controls_;  // one per edge, from the start
+        std::vector<unsigned int> steps_;            // propagation steps of every control
+        double cost_{0};
+    };
+
+    ExperienceCache(const std::size_t capacity = 1024);
+
+    /* the cache of key (e.g. map, robot shape and dynamics model), created on the first call */
+    static std::shared_ptr<ExperienceCache> get(const std::string &key);
+
+    /* add experience, unless a cheaper one has the same start and end */
+    void add(Experience experience);
+
+    /* up to k experiences that start within radius of start, nearest first by the distance of their start plus the 
+       goal_distance of their end */
+    std::vector<Experience> nearest(const std::vector<double> &start, const double radius, const std::size_t k,
+        const std::function<double(const std::vector<double> &)> &goal_distance) const;
+
+    std::size_t size() const;
+
+private:
+    const std::size_t capacity_;
+    std::deque<Experience> experiences_;  // oldest first
+    mutable std::shared_mutex mutex_;
+};
+
+typedef std::shared_ptr<ExperienceCache> ExperienceCachePtr;
@@ -0,0 +1,153 @@
+#pragma once
+#include <set>
+#include <limits>
+
+
+/* Open list of a best-first search with an optional focal list (as in ECBS).
+   Nodes must provide getCost() and getNumConflicts(). With a suboptimality factor w > 1,
+   every node whose cost is at most w times the minimum cost is in the focal list, and the
+   focal node with the fewest conflicts is expanded first. With w <= 1, this is a plain best-first queue. */
+template <typename Node>
+class FocalOpenList
+{
+public:
+	FocalOpenList(const double w = 1.0): w_(w) {}
+
+	void setSuboptimalityFactor(const double w)
+	{
+		w_ = w;
+		rebuildFocal_();
+	}
+
+	double getSuboptimalityFactor() const {return w_;};
+
+	void push(Node *n)
+	{
+		const bool new_min = open_.empty() || n->getCost() < getMinCost();
+		open_.insert(n);
+		if (!useFocal_())
+			return;
+		if (new_min)
+			rebuildFocal_();
+		else if (n->getCost() <= focal_bound_)
+			focal_.insert(n);
+	}
+
+	/* node that should be expanded next */
+	Node *top() const
+	{
+		if (useFocal_() && !focal_.empty())
+			return *focal_.begin();
+		return *open_.begin();
+	}
+
+	void pop()
+	{
+		Node *n = top();
+		erase_(open_, n);
+		if (!useFocal_())
+			return;
+		erase_(focal_, n);
+		updateFocal_();
+	}
+
+	/* remove n, wherever it is in the list */
+	void erase(Node *n)
+	{
+		erase_(open_, n);
+		if (!useFocal_())
+			return;
+		erase_(focal_, n);
+		updateFocal_();
+	}
+
+	bool empty() const {return open_.empty();};
+
+	std::size_t size() const {return open_.size();};
+
+	std::size_t focalSize() const {return useFocal_() ? focal_.size() : open_.size();};
+
+	void clear()
+	{
+		open_.clear();
+		focal_.clear();
+		focal_bound_ = -std::numeric_limits<double>::infinity();
+	}
+
+	/* the nodes from the lowest cost up */
+	auto begin() const {return open_.begin();};
+
+	auto end() const {return open_.end();};
+
+	/* the nodes from the highest cost down (the last ones a best-first search expands) */
+	auto rbegin() const {return open_.rbegin();};
+
+	auto rend() const {return open_.rend();};
+
+	/* lower bound on the cost of any node in the list */
+	double getMinCost() const
+	{
+		if (open_.empty())
+			return std::numeric_limits<double>::infinity();
+		return (*open_.begin())->getCost();
+	}
+
+private:
+	struct CostCompare
+	{
+		using is_transparent = void;
+		bool operator()(const Node *a, const Node *b) const {return a->getCost() < b->getCost();};
+		bool operator()(const Node *a, const double c) const {return a->getCost() < c;};
+		bool operator()(const double c, const Node *b) const {return c < b->getCost();};
+	};
+
+	struct FocalCompare
+	{
+		bool operator()(const Node *a, const Node *b) const
+		{
+			if (a->getNumConflicts() != b->getNumConflicts())
+				return a->getNumConflicts() < b->getNumConflicts();
+			return a->getCost() < b->getCost();
+		}
+	};
+
+	bool useFocal_() const {return w_ > 1.0;};
+
+	template <typename Set>
+	static void erase_(Set &s, Node *n)
+	{
+		auto range = s.equal_range(n);
+		for (auto itr = range.first; itr != range.second; itr++) {
+			if (*itr == n) {
+				s.erase(itr);
+				return;
+			}
+		}
+	}
+
+	/* the minimum cost grew; admit the nodes that are now inside the bound */
+	void updateFocal_()
+	{
+		const double new_bound = w_ * getMinCost();
+		if (new_bound <= focal_bound_)
+			return;
+		auto itr = (focal_bound_ == -std::numeric_limits<double>::infinity()) ? open_.begin() : open_.upper_bound(focal_bound_);
+		for (; itr != open_.end() && (*itr)->getCost() <= new_bound; itr++)
+			focal_.insert(*itr);
+		focal_bound_ = new_bound;
+	}
+
+	/* the minimum cost shrank (or w changed); collect the focal list from scratch */
+	void rebuildFocal_()
+	{
+		focal_.clear();
+		focal_bound_ = -std::numeric_limits<double>::infinity();
+		if (useFocal_())
+			updateFocal_();
+	}
+
+	double w_;
+	double focal_bound_{-std::numeric_limits<double>::infinity()};
+	std::multiset<Node*, CostCompare> open_;
+	std::multiset<Node*, FocalCompare> focal_;
+};
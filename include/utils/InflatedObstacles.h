@@ -0,0 +1,41 @@
+#pragma once
+#include "utils/common.h"
+#include "utils/BlackmoreHalfPlanes.h"
+#include "utils/ObstacleGrid.h"
+#include <Eigen/Core>
+#include <utility>
+#include <vector>
+
+
+/* The obstacles of a map inflated by the bounding shape of a robot (their Minkowski sums), with the half-planes
+   of the sums and a grid over them. They only depend on the bounding shape, so Instance::getInflatedObstacles()
+   builds them once per shape and the validity checkers of every robot with that shape share them. They are not
+   modified once built. */
+class InflatedObstacles
+{
+public:
+    InflatedObstacles(const Polygon &bounding_shape, const std::vector<Obstacle*> &obstacles);
+
+    /* from the Minkowski sums of the obstacles, computed before (e.g. loaded from a MapCache) */
+    InflatedObstacles(std::vector<Polygon> polygons);
+
+    const std::vector<Polygon> &getPolygons() const {return polygons_;};
+    const BlackmoreHalfPlanes &getHalfPlanes() const {return half_planes_;};
+    const ObstacleGrid &getGrid() const {return grid_;};
+    /* true if every half-plane is axis-aligned, so the grid may prune the half-plane checks */
+    bool isAxisAligned() const {return axis_aligned_;};
+
+    /* Minkowski sum of two convex polygons */
+    static Polygon minkowskiSum(const Polygon &shape1, const Polygon &shape2);
+    /* the half-planes A x <= B of the edges of a rectangle */
+    static std::pair<Eigen::MatrixXd, Eigen::MatrixXd> halfPlanes(const Polygon &rectangle);
+
+private:
+    /* the half-planes and grid of polygons_ */
+    void build_();
+
+    std::vector<Polygon> polygons_;
+    BlackmoreHalfPlanes half_planes_;
+    ObstacleGrid grid_;
+    bool axis_aligned_{true};
+};
@@ -1,6 +1,16 @@
 #pragma once
 #include "utils/common.h"
+#include "utils/SignedDistanceField.h"
+#include "utils/OccupancyQuadtree.h"
+#include "utils/InflatedObstacles.h"
+#include "utils/CostToGoMap.h"
+#include "utils/MapCache.h"
+#include "utils/ExperienceCache.h"
+#include "utils/Seeding.h"
 #include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <ompl/tools/config/SelfConfig.h>
 #include <boost/program_options.hpp>
 
@@ -15,6 +25,11 @@ public:
     Instance(Instance &other);
     Instance(const int num_agents, const double p_safe);
     Instance(po::variables_map &vm, std::string name = "Instance");
+    // the robots of vm on the map of map_instance, whose obstacles and geometry caches are shared instead of loaded again
+    Instance(const Instance &map_instance, po::variables_map &vm, std::string name = "Instance");
+    // as the constructors, which exit if the map or the scen cannot be loaded, but nullptr (with an error) instead
+    static InstancePtr load(po::variables_map &vm, std::string name = "Instance");
+    static InstancePtr load(const Instance &map_instance, po::variables_map &vm, std::string name = "Instance");
     // methods for dimensions
     const double getPsafe() const {return p_safe_;};
     const double getPsafeObs() const {return p_safe_obs_;};
@@ -26,24 +41,73 @@ public:
         "x: [0, %0.2f] \n"
         "y: [0, %0.2f]", x_max_, y_max_);};
     std::vector<Obstacle*> getObstacles() const {return obstacles_;};
+    // the blocked cells of the map as a quadtree, nullptr if the instance has no map
+    std::shared_ptr<const OccupancyQuadtree> getOccupancy() const {return geometry_->occupancy_;};
+    // signed distance field of the obstacles, built on the first call
+    std::shared_ptr<const SignedDistanceField> getDistanceField();
+    // obstacles inflated by the bounding shape of r, built once per shape and shared by all robots with it
+    std::shared_ptr<const InflatedObstacles> getInflatedObstacles(const Robot *r);
+    // cost-to-go to the goal of r over a grid of the map, built once per robot
+    std::shared_ptr<const CostToGoMap> getCostToGoMap(const Robot *r, const double resolution = 0.5);
+    // the trajectories of earlier problems of robots like r (same shape and dynamics) on the map, shared by the whole
+    // process. nullptr unless the experience cache is enabled
+    ExperienceCachePtr getExperienceCache(const Robot *r) const;
     std::vector<Robot*> getRobots() const {return robots_;};
     void addRobot(Robot* r)
     {
+        r->setId(robots_.size());
         robots_.push_back(r);
     }
     const std::string getPlannerName() const {return mrmp_planner_;};
     const std::string getLowLevelPlannerName() const {return low_level_planner_;};
+    const fs::path &getMapFile() const {return map_fpath_;};
+    const fs::path &getScenFile() const {return scen_fpath_;};
+    int getNumAgents() const {return num_agents_;};
+    // seed of the planners of the instance (0 to keep OMPL's seeds), see utils/Seeding.h
+    std::uint32_t getSeed() const {return seed_;};
+    // the seed of the low-level planner of robot r
+    std::uint32_t getAgentSeed(const int r) const {return (seed_ != 0) ? seeding::derive(seed_, r) : 0;};
     // printing methods for usability
     void printObstacles();
     void printRobots();
     void print();
 private:
-    bool load_map_();
+    // the constructors, which leave loaded_ false (instead of exiting) if the map or the scen cannot be loaded
+    struct Unchecked {};
+    Instance(po::variables_map &vm, std::string name, Unchecked);
+    Instance(const Instance &map_instance, po::variables_map &vm, std::string name, Unchecked);
+    // the map of contents (the map file), from the map cache when it is enabled and has it
+    bool load_map_(std::string &contents, CachedMap &cached);
+    void add_obstacles_(std::vector<std::vector<bool>> &blocked, std::vector<std::array<double, 4>> &rectangles);
+    // the quadtree of the cells covered by rectangles, the obstacles of the map
+    void build_occupancy_(const std::vector<std::array<double, 4>> &rectangles);
+    // cache the map, with the inflated obstacles of every robot shape it did not have yet
+    void cache_map_(const std::string &contents, CachedMap &cached);
     bool load_agents_();
+    // key of the inflated obstacles of r, its bounding shape
+    static std::vector<double> shape_key_(const Robot *r);
+    void split_p_safe_();
+    // the geometry derived from the obstacles, shared by the instances of a map
+    struct MapGeometry
+    {
+        std::shared_ptr<const OccupancyQuadtree> occupancy_;  // set by load_map_, before the geometry is shared
+        std::map<double, std::shared_ptr<const SignedDistanceField>> sdfs_;  // by resolution
+        std::map<std::vector<double>, std::shared_ptr<const InflatedObstacles>> inflated_;
+        std::map<std::vector<double>, std::vector<Polygon>> cached_inflated_;  // from the map cache, built on first use
+        std::mutex mutex_;
+    };
     double x_max_;
     double y_max_;
     double p_safe_agnts_ = -1;
     double p_safe_obs_ = -1;
+    double sdf_res_ = 0.05;
+    fs::path map_cache_dir_;  // empty if the map cache is disabled
+    std::uint32_t seed_{0};
+    bool experience_{false};
+    bool loaded_{false};
+    std::shared_ptr<MapGeometry> geometry_{std::make_shared<MapGeometry>()};
+    std::map<int, std::shared_ptr<const CostToGoMap>> cost_to_go_;
+    std::mutex cost_to_go_mutex_;
     const int num_agents_;
     const double p_safe_;
     const fs::path map_fpath_;
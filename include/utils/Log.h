@@ -0,0 +1,140 @@
+#pragma once
+#include <ompl/util/Console.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/* Asynchronous logging of the hot paths of planning (every replan, conflict and low-level solve), as structured
+   events: a component, an event name and key=value fields. A message is formatted on its thread and appended to the
+   buffer of that thread; a writer thread hands the buffers to the OMPL output handler every few milliseconds, so the
+   search threads never wait for the console (or for each other on the lock of OMPL_INFORM). Warnings and errors are
+   written at once. Every call site passes at most rate_limit_ messages per second, the next message of a site after
+   a quiet second counts those it dropped (suppressed=n). Usage:
+
+	KCBS_LOG_INFO("KCBS", "replanned", "agent", agent, "seconds", t);
+	...
+	KCBS_LOG_FLUSH();
+
+   The levels below KCBS_LOG_LEVEL (0 debug, 1 info, 2 warn, 3 error, 4 none; set with -DKCBS_LOG_LEVEL=n) expand to
+   nothing; the others are filtered by the OMPL log level at run time. */
+
+#ifndef KCBS_LOG_LEVEL
+#define KCBS_LOG_LEVEL 1
+#endif
+
+namespace logging
+{
+	/* messages per second of a call site */
+	constexpr unsigned int rate_limit_ = 20;
+
+	/* the rate limit of a call site */
+	class Site
+	{
+	public:
+		Site(const char *file, const int line): file_(file), line_(line) {}
+
+		/* whether the next message of the site is written */
+		bool admit();
+
+		/* the messages dropped since the last one written */
+		std::uint64_t takeSuppressed() {return suppressed_.exchange(0, std::memory_order_relaxed);};
+
+		const char *file_;
+		const int line_;
+
+	private:
+		std::atomic<std::int64_t> window_{-1};  // second of the messages counted by passed_
+		std::atomic<unsigned int> passed_{0};
+		std::atomic<std::uint64_t> suppressed_{0};
+	};
+
+	/* whether messages of level are written (the OMPL log level, cached) */
+	bool enabled(const ompl::msg::LogLevel level);
+
+	/* reread the OMPL log level after ompl::msg::setLogLevel */
+	void refreshLevel();
+
+	/* the text of the message of the calling thread, to append fields to */
+	std::string &threadMessage();
+
+	/* hand the message of the calling thread to the writer */
+	void submit(Site &site, const ompl::msg::LogLevel level);
+
+	/* write the buffered messages of every thread now */
+	void flush();
+
+	inline void appendValue(std::string &s, const char *v) {s += v;}
+	inline void appendValue(std::string &s, const std::string &v) {s += v;}
+	inline void appendValue(std::string &s, const bool v) {s += v ? "true" : "false";}
+	void appendValue(std::string &s, const double v);
+
+	template <typename T>
+	typename std::enable_if<std::is_integral<T>::value>::type appendValue(std::string &s, const T v)
+	{
+		s += std::to_string(v);
+	}
+
+	template <typename T>
+	typename std::enable_if<std::is_floating_point<T>::value>::type appendValue(std::string &s, const T v)
+	{
+		appendValue(s, static_cast<double>(v));
+	}
+
+	inline void appendFields(std::string &) {}
+
+	template <typename K, typename V, typename... Rest>
+	void appendFields(std::string &s, const K &key, const V &value, const Rest &...rest)
+	{
+		static_assert(sizeof...(Rest) % 2 == 0, "the fields of a message are key, value pairs");
+		s += ' ';
+		appendValue(s, key);
+		s += '=';
+		appendValue(s, value);
+		appendFields(s, rest...);
+	}
+
+	template <typename... Fields>
+	void log(Site &site, const ompl::msg::LogLevel level, const char *component, const char *event, const Fields &...fields)
+	{
+		std::string &s = threadMessage();
+		s.clear();
+		s += component;
+		s += ": ";
+		s += event;
+		appendFields(s, fields...);
+		submit(site, level);
+	}
+}
+
+#define KCBS_LOG_(level, component, ...) do { \
+	static logging::Site kcbs_log_site_(__FILE__, __LINE__); \
+	if (logging::enabled(level) && kcbs_log_site_.admit()) \
+		logging::log(kcbs_log_site_, level, component, __VA_ARGS__); \
+	} while (0)
+
+#if KCBS_LOG_LEVEL <= 0
+#define KCBS_LOG_DEBUG(component, ...) KCBS_LOG_(ompl::msg::LOG_DEBUG, component, __VA_ARGS__)
+#else
+#define KCBS_LOG_DEBUG(component, ...) ((void)0)
+#endif
+
+#if KCBS_LOG_LEVEL <= 1
+#define KCBS_LOG_INFO(component, ...) KCBS_LOG_(ompl::msg::LOG_INFO, component, __VA_ARGS__)
+#else
+#define KCBS_LOG_INFO(component, ...) ((void)0)
+#endif
+
+#if KCBS_LOG_LEVEL <= 2
+#define KCBS_LOG_WARN(component, ...) KCBS_LOG_(ompl::msg::LOG_WARN, component, __VA_ARGS__)
+#else
+#define KCBS_LOG_WARN(component, ...) ((void)0)
+#endif
+
+#if KCBS_LOG_LEVEL <= 3
+#define KCBS_LOG_ERROR(component, ...) KCBS_LOG_(ompl::msg::LOG_ERROR, component, __VA_ARGS__)
+#else
+#define KCBS_LOG_ERROR(component, ...) ((void)0)
+#endif
+
+#define KCBS_LOG_FLUSH() logging::flush()
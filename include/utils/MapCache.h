@@ -0,0 +1,47 @@
+#pragma once
+#include "utils/common.h"
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+
+/* The parsed geometry of a map, as cached between runs: its dimensions, the rectangles that cover its blocked
+   cells (center x, center y, length, width, as RectangularObstacle) and the obstacles inflated by the bounding
+   shapes of robots (their Minkowski sums, keyed as Instance::getInflatedObstacles) */
+struct CachedMap
+{
+    double x_max_{-1};
+    double y_max_{-1};
+    std::vector<std::array<double, 4>> rectangles_;
+    std::map<std::vector<double>, std::vector<Polygon>> inflated_;
+};
+
+/* Binary cache of parsed maps in a directory, one file per map keyed by the hash of its contents, so an edited map
+   is parsed again. Files are replaced atomically, so concurrent instances may share the directory. */
+class MapCache
+{
+public:
+    MapCache(fs::path directory);
+
+    /* the cached map of contents (of a *.map file). False if it is not cached (or the cache file is invalid) */
+    bool load(const std::string &contents, CachedMap &map) const;
+
+    /* cache map as the parsed map of contents */
+    bool save(const std::string &contents, const CachedMap &map) const;
+
+    /* 64-bit FNV-1a hash of contents */
+    static std::uint64_t hash(const std::string &contents);
+
+private:
+    fs::path file_(const std::uint64_t key) const;
+
+    const fs::path directory_;
+};
+
+/* the contents of filename, in a single read. False if it cannot be read */
+bool readFile(const fs::path &filename, std::string &contents);
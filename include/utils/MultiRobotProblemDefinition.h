@@ -3,6 +3,7 @@
 #include "Mergers/Merger.h"
 #include "PlanValidityCheckers/PlanValidityChecker.h"
 #include "Planners/ConstraintRespectingBSST.h"
+#include "Planners/ConstraintRespectingRRT.h"
 // #include <ompl/control/SpaceInformation.h>
 
 
@@ -24,10 +25,22 @@ public:
     	planner_ = new_p;
     }
 
+    /* the top speed of the robot and the radius of its goal, from which the lower bound of its cost is derived 
+       (see MultiRobotProblemDefinition::getCostLowerBound). A speed of 0 leaves the robot unbounded */
+    void setSpeedBound(const double max_speed, const double goal_radius)
+    {
+    	max_speed_ = max_speed;
+    	goal_radius_ = goal_radius;
+    }
+    double getMaxSpeed() const {return max_speed_;};
+    double getGoalRadius() const {return goal_radius_;};
+
 private:
     oc::SpaceInformationPtr si_;
     ob::ProblemDefinitionPtr pdef_;
     PlannerPtr planner_;
+    double max_speed_{0};
+    double goal_radius_{0};
 };
 
 OMPL_CLASS_FORWARD(MultiRobotProblemDefinition);
@@ -60,6 +73,16 @@ public:
 
 	 void replacePlanner(PlannerPtr old_planner, const int idx);
 
+	/* create an independent low-level planner (with its own problem definition) for robot idx */
+	PlannerPtr clonePlanner(const int idx);
+
+	/* as clonePlanner, but a ll_solver planner (BSST or RRT), with params set over the parameters of the planner of robot idx */
+	PlannerPtr clonePlanner(const int idx, const std::string &ll_solver, const std::map<std::string, std::string> &params);
+
+	/* a lower bound on the duration of any trajectory of robot idx to its goal: its cost-to-go on the grid of the map 
+	   (shortened by the error of the grid and the goal radius) at its top speed. 0 if the robot has no speed bound */
+	double getCostLowerBound(const int idx);
+
 	double getSystemStepSize()
 	{
 		const oc::SpaceInformationPtr siPtr = mrmp_problem_[0]->getSpaceInformation();
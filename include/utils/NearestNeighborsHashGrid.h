@@ -0,0 +1,184 @@
+#pragma once
+#include <ompl/datastructures/NearestNeighbors.h>
+#include <ompl/util/Exception.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+/* Nearest neighbors on an unbounded uniform grid over the planar position (first two mean coordinates) of beliefs,
+   whose occupied cells are kept in a hash map. As for NearestNeighborsMeanGrid, the squared planar distance of two
+   means must be a lower bound on the distance function. It is meant for the witnesses of the BSST planners, which form
+   a net of the pruning radius: with cells of the planar reach of that radius, nearestWithin only visits the cells
+   around the query and re-checks the exact distance of their elements. nearestK visits every element. */
+template <typename _T>
+class NearestNeighborsHashGrid: public ompl::NearestNeighbors<_T>
+{
+public:
+	typedef std::function<std::pair<double, double>(const _T &)> PositionFunction;
+
+	NearestNeighborsHashGrid(const PositionFunction &position, const double cell_size):
+		position_(position), cell_(std::max(cell_size, 1e-6))
+	{
+	}
+
+	bool reportsSortedResults() const override {return true;};
+
+	void clear() override
+	{
+		cells_.clear();
+		size_ = 0;
+	}
+
+	void add(const _T &data) override
+	{
+		cells_[keyOf_(position_(data))].push_back(data);
+		size_++;
+	}
+
+	void add(const std::vector<_T> &data) override
+	{
+		for (const _T &d: data)
+			add(d);
+	}
+
+	bool remove(const _T &data) override
+	{
+		auto cell = cells_.find(keyOf_(position_(data)));
+		if (cell == cells_.end())
+			return false;
+		std::vector<_T> &c = cell->second;
+		auto itr = std::find(c.begin(), c.end(), data);
+		if (itr == c.end())
+			return false;
+		*itr = c.back();
+		c.pop_back();
+		if (c.empty())
+			cells_.erase(cell);
+		size_--;
+		return true;
+	}
+
+	_T nearest(const _T &data) const override
+	{
+		std::vector<_T> nbh;
+		nearestK(data, 1, nbh);
+		if (nbh.empty())
+			throw ompl::Exception("No elements found in nearest neighbors data structure");
+		return nbh.front();
+	}
+
+	void nearestK(const _T &data, std::size_t k, std::vector<_T> &nbh) const override
+	{
+		nbh.clear();
+		if (k == 0)
+			return;
+		std::vector<std::pair<double, _T>> found;
+		found.reserve(size_);
+		for (const auto &c: cells_) {
+			for (const _T &e: c.second)
+				found.emplace_back(this->distFun_(data, e), e);
+		}
+		const std::size_t n = std::min(k, found.size());
+		std::partial_sort(found.begin(), found.begin() + n, found.end(), byDistance_);
+		for (std::size_t i = 0; i < n; i++)
+			nbh.push_back(found[i].second);
+	}
+
+	void nearestR(const _T &data, double radius, std::vector<_T> &nbh) const override
+	{
+		nbh.clear();
+		std::vector<std::pair<double, _T>> found;
+		forWithin_(data, radius, [&](const double d, const _T &e) {found.emplace_back(d, e);});
+		std::sort(found.begin(), found.end(), byDistance_);
+		for (const auto &f: found)
+			nbh.push_back(f.second);
+	}
+
+	/* the nearest element within radius of data, or _T() if there is none */
+	_T nearestWithin(const _T &data, const double radius) const
+	{
+		_T best = _T();
+		double best_dist = std::numeric_limits<double>::infinity();
+		forWithin_(data, radius, [&](const double d, const _T &e) {
+			if (d < best_dist) {
+				best_dist = d;
+				best = e;
+			}
+		});
+		return best;
+	}
+
+	std::size_t size() const override {return size_;};
+
+	void list(std::vector<_T> &data) const override
+	{
+		data.clear();
+		data.reserve(size_);
+		for (const auto &c: cells_)
+			data.insert(data.end(), c.second.begin(), c.second.end());
+	}
+
+private:
+	static bool byDistance_(const std::pair<double, _T> &a, const std::pair<double, _T> &b) {return a.first < b.first;};
+
+	long index_(const double v) const
+	{
+		return static_cast<long>(std::floor(v / cell_));
+	}
+
+	static std::uint64_t key_(const long i, const long j)
+	{
+		return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(i)) << 32) | static_cast<std::uint32_t>(j);
+	}
+
+	std::uint64_t keyOf_(const std::pair<double, double> &p) const
+	{
+		return key_(index_(p.first), index_(p.second));
+	}
+
+	/* call f(distance, element) on every element within radius of data */
+	template <typename F>
+	void forWithin_(const _T &data, const double radius, F f) const
+	{
+		if (size_ == 0 || !(radius >= 0))
+			return;
+		const std::pair<double, double> q = position_(data);
+		const double reach = std::sqrt(radius);
+		const long i0 = index_(q.first - reach), i1 = index_(q.first + reach);
+		const long j0 = index_(q.second - reach), j1 = index_(q.second + reach);
+		auto visit = [&](const std::vector<_T> &cell) {
+			for (const _T &e: cell) {
+				const std::pair<double, double> p = position_(e);
+				if ((p.first - q.first) * (p.first - q.first) + (p.second - q.second) * (p.second - q.second) > radius)
+					continue;
+				const double d = this->distFun_(data, e);
+				if (d <= radius)
+					f(d, e);
+			}
+		};
+		/* a radius far above the cells visits the occupied cells rather than the empty ones */
+		if (static_cast<double>(i1 - i0 + 1) * (j1 - j0 + 1) > cells_.size()) {
+			for (const auto &c: cells_)
+				visit(c.second);
+			return;
+		}
+		for (long i = i0; i <= i1; i++) {
+			for (long j = j0; j <= j1; j++) {
+				auto cell = cells_.find(key_(i, j));
+				if (cell != cells_.end())
+					visit(cell->second);
+			}
+		}
+	}
+
+	PositionFunction position_;
+	const double cell_;
+	std::unordered_map<std::uint64_t, std::vector<_T>> cells_;
+	std::size_t size_{0};
+};
@@ -0,0 +1,213 @@
+#pragma once
+#include <ompl/datastructures/NearestNeighbors.h>
+#include <ompl/util/Console.h>
+#include <ompl/util/Exception.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+
+/* Nearest neighbors on a uniform grid over the planar position (first two mean coordinates) of beliefs.
+   The squared planar distance of two means must be a lower bound on the distance function, which holds
+   for the (squared) Wasserstein distance of RealVectorBeliefSpace. Queries visit the cells around the query
+   in rings, skip every cell and element whose lower bound cannot improve the result, and only evaluate the
+   full distance on the rest. Positions outside the bounds fall into the border cells. */
+template <typename _T>
+class NearestNeighborsMeanGrid: public ompl::NearestNeighbors<_T>
+{
+public:
+	typedef std::function<std::pair<double, double>(const _T &)> PositionFunction;
+
+	NearestNeighborsMeanGrid(const PositionFunction &position, const double x_low, const double x_high,
+		const double y_low, const double y_high, const double cell_size, const std::size_t max_cells = 1 << 18):
+		position_(position), x_low_(x_low), y_low_(y_low)
+	{
+		cell_ = std::max(cell_size, 1e-6);
+		/* coarsen the grid rather than allocating an oversized one */
+		while (true) {
+			nx_ = std::max<long>(1, std::ceil((x_high - x_low) / cell_));
+			ny_ = std::max<long>(1, std::ceil((y_high - y_low) / cell_));
+			if (static_cast<std::size_t>(nx_ * ny_) <= max_cells)
+				break;
+			cell_ *= 2;
+		}
+		cells_.resize(nx_ * ny_);
+	}
+
+	bool reportsSortedResults() const override {return true;};
+
+	void clear() override
+	{
+		for (auto &c: cells_)
+			c.clear();
+		size_ = 0;
+	}
+
+	void add(const _T &data) override
+	{
+		cells_[cellOf_(position_(data))].push_back(data);
+		size_++;
+	}
+
+	void add(const std::vector<_T> &data) override
+	{
+		for (const _T &d: data)
+			add(d);
+	}
+
+	bool remove(const _T &data) override
+	{
+		std::vector<_T> &c = cells_[cellOf_(position_(data))];
+		auto itr = std::find(c.begin(), c.end(), data);
+		if (itr == c.end())
+			return false;
+		*itr = c.back();
+		c.pop_back();
+		size_--;
+		return true;
+	}
+
+	_T nearest(const _T &data) const override
+	{
+		std::vector<_T> nbh;
+		nearestK(data, 1, nbh);
+		if (nbh.empty())
+			throw ompl::Exception("No elements found in nearest neighbors data structure");
+		return nbh.front();
+	}
+
+	void nearestK(const _T &data, std::size_t k, std::vector<_T> &nbh) const override
+	{
+		nbh.clear();
+		if (k == 0 || size_ == 0)
+			return;
+		const std::pair<double, double> q = position_(data);
+		const long qi = index_(q.first, x_low_, nx_), qj = index_(q.second, y_low_, ny_);
+		/* max-heap of the k best (distance, element) */
+		std::priority_queue<std::pair<double, _T>> best;
+		auto bound = [&]() {return best.size() < k ? std::numeric_limits<double>::infinity() : best.top().first;};
+		const long max_ring = std::max(std::max(qi, nx_ - 1 - qi), std::max(qj, ny_ - 1 - qj));
+		for (long r = 0; r <= max_ring; r++) {
+			/* every cell of ring r is at least r - 1 cells away from the query */
+			const double ring_lb = std::pow(std::max<long>(r - 1, 0) * cell_, 2);
+			if (ring_lb > bound())
+				break;
+			forRing_(qi, qj, r, [&](const long i, const long j) {
+				if (cellLowerBound_(q, i, j) > bound())
+					return;
+				for (const _T &e: cells_[i * ny_ + j]) {
+					if (planarDistance_(q, position_(e)) > bound())
+						continue;
+					const double d = this->distFun_(data, e);
+					if (best.size() < k)
+						best.emplace(d, e);
+					else if (d < best.top().first) {
+						best.pop();
+						best.emplace(d, e);
+					}
+				}
+			});
+		}
+		nbh.resize(best.size());
+		for (std::size_t i = nbh.size(); i > 0; i--) {
+			nbh[i - 1] = best.top().second;
+			best.pop();
+		}
+	}
+
+	void nearestR(const _T &data, double radius, std::vector<_T> &nbh) const override
+	{
+		nbh.clear();
+		const std::pair<double, double> q = position_(data);
+		const double reach = std::sqrt(std::max(radius, 0.0));
+		const long i0 = index_(q.first - reach, x_low_, nx_), i1 = index_(q.first + reach, x_low_, nx_);
+		const long j0 = index_(q.second - reach, y_low_, ny_), j1 = index_(q.second + reach, y_low_, ny_);
+		std::vector<std::pair<double, _T>> found;
+		for (long i = i0; i <= i1; i++) {
+			for (long j = j0; j <= j1; j++) {
+				if (cellLowerBound_(q, i, j) > radius)
+					continue;
+				for (const _T &e: cells_[i * ny_ + j]) {
+					if (planarDistance_(q, position_(e)) > radius)
+						continue;
+					const double d = this->distFun_(data, e);
+					if (d <= radius)
+						found.emplace_back(d, e);
+				}
+			}
+		}
+		std::sort(found.begin(), found.end(), [](const std::pair<double, _T> &a, const std::pair<double, _T> &b) {return a.first < b.first;});
+		for (const auto &f: found)
+			nbh.push_back(f.second);
+	}
+
+	std::size_t size() const override {return size_;};
+
+	void list(std::vector<_T> &data) const override
+	{
+		data.clear();
+		data.reserve(size_);
+		for (const auto &c: cells_)
+			data.insert(data.end(), c.begin(), c.end());
+	}
+
+private:
+	long index_(const double v, const double low, const long n) const
+	{
+		const double idx = std::floor((v - low) / cell_);
+		if (!(idx > 0))
+			return 0;
+		return std::min<long>(idx, n - 1);
+	}
+
+	std::size_t cellOf_(const std::pair<double, double> &p) const
+	{
+		return index_(p.first, x_low_, nx_) * ny_ + index_(p.second, y_low_, ny_);
+	}
+
+	static double planarDistance_(const std::pair<double, double> &a, const std::pair<double, double> &b)
+	{
+		return (a.first - b.first) * (a.first - b.first) + (a.second - b.second) * (a.second - b.second);
+	}
+
+	/* squared planar distance from p to cell (i, j). The border cells extend to infinity */
+	double cellLowerBound_(const std::pair<double, double> &p, const long i, const long j) const
+	{
+		auto axis = [this](const double v, const double low, const long idx, const long n) {
+			const double lo = (idx == 0) ? -std::numeric_limits<double>::infinity() : low + idx * cell_;
+			const double hi = (idx == n - 1) ? std::numeric_limits<double>::infinity() : low + (idx + 1) * cell_;
+			return std::max({0.0, lo - v, v - hi});
+		};
+		const double dx = axis(p.first, x_low_, i, nx_);
+		const double dy = axis(p.second, y_low_, j, ny_);
+		return dx * dx + dy * dy;
+	}
+
+	/* call f on the cells of the square ring at Chebyshev distance r from (qi, qj) */
+	template <typename F>
+	void forRing_(const long qi, const long qj, const long r, F f) const
+	{
+		for (long i = qi - r; i <= qi + r; i++) {
+			if (i < 0 || i >= nx_)
+				continue;
+			const bool edge = (i == qi - r || i == qi + r);
+			for (long j = qj - r; j <= qj + r; j += (edge || r == 0) ? 1 : 2 * r) {
+				if (j >= 0 && j < ny_)
+					f(i, j);
+			}
+		}
+	}
+
+	PositionFunction position_;
+	const double x_low_;
+	const double y_low_;
+	double cell_;
+	long nx_;
+	long ny_;
+	std::vector<std::vector<_T>> cells_;
+	std::size_t size_{0};
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <ompl/datastructures/NearestNeighbors.h>
+#include <ompl/util/Exception.h>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+
+/* Lazy removal around another nearest-neighbors structure (e.g. a GNAT, whose remove is expensive and may rebuild it).
+   A removed element is only marked dead: queries skip it, and it stays in the inner structure until the dead elements
+   exceed max_dead_fraction of it. The inner structure is then rebuilt from the live elements in one batch, and every
+   dead element is handed to purge (e.g. to recycle its memory), which is the first time its owner may reuse it. An
+   element must not be added back while it is dead. */
+template <typename _T>
+class NearestNeighborsTombstones: public ompl::NearestNeighbors<_T>
+{
+public:
+	typedef std::function<void(const _T &)> PurgeFunction;
+
+	NearestNeighborsTombstones(std::shared_ptr<ompl::NearestNeighbors<_T>> inner, const PurgeFunction &purge = PurgeFunction(),
+		const double max_dead_fraction = 0.25): inner_(std::move(inner)), purge_(purge), max_dead_fraction_(max_dead_fraction)
+	{
+	}
+
+	void setDistanceFunction(const typename ompl::NearestNeighbors<_T>::DistanceFunction &distFun) override
+	{
+		ompl::NearestNeighbors<_T>::setDistanceFunction(distFun);
+		inner_->setDistanceFunction(distFun);
+	}
+
+	bool reportsSortedResults() const override {return inner_->reportsSortedResults();};
+
+	/* every dead element is purged */
+	void clear() override
+	{
+		inner_->clear();
+		purgeDead_();
+	}
+
+	void add(const _T &data) override
+	{
+		if (dead_.count(data) > 0)
+			compact();
+		inner_->add(data);
+	}
+
+	void add(const std::vector<_T> &data) override
+	{
+		for (const _T &d: data) {
+			if (dead_.count(d) > 0) {
+				compact();
+				break;
+			}
+		}
+		inner_->add(data);
+	}
+
+	bool remove(const _T &data) override
+	{
+		if (!dead_.insert(data).second)
+			return false;
+		if (dead_.size() > max_dead_fraction_ * inner_->size())
+			compact();
+		return true;
+	}
+
+	_T nearest(const _T &data) const override
+	{
+		std::vector<_T> nbh;
+		nearestK(data, 1, nbh);
+		if (nbh.empty())
+			throw ompl::Exception("No elements found in nearest neighbors data structure");
+		return nbh.front();
+	}
+
+	/* the inner query is widened (doubling k) until it returns k live elements */
+	void nearestK(const _T &data, std::size_t k, std::vector<_T> &nbh) const override
+	{
+		nbh.clear();
+		if (k == 0)
+			return;
+		if (dead_.empty()) {
+			inner_->nearestK(data, k, nbh);
+			return;
+		}
+		std::vector<_T> found;
+		for (std::size_t inner_k = k; ; inner_k *= 2) {
+			inner_->nearestK(data, inner_k, found);
+			dropDead_(found);
+			if (found.size() >= k || inner_k >= inner_->size())
+				break;
+		}
+		if (found.size() > k)
+			found.resize(k);
+		nbh.swap(found);
+	}
+
+	void nearestR(const _T &data, double radius, std::vector<_T> &nbh) const override
+	{
+		inner_->nearestR(data, radius, nbh);
+		dropDead_(nbh);
+	}
+
+	std::size_t size() const override {return inner_->size() - dead_.size();};
+
+	void list(std::vector<_T> &data) const override
+	{
+		inner_->list(data);
+		dropDead_(data);
+	}
+
+	/* rebuild the inner structure from the live elements, and purge the dead ones */
+	void compact()
+	{
+		if (dead_.empty())
+			return;
+		std::vector<_T> live;
+		list(live);
+		inner_->clear();
+		inner_->add(live);
+		purgeDead_();
+	}
+
+	std::size_t numDead() const {return dead_.size();};
+
+private:
+	/* remove the dead elements from data, keeping the order of the others */
+	void dropDead_(std::vector<_T> &data) const
+	{
+		if (dead_.empty())
+			return;
+		std::size_t n = 0;
+		for (std::size_t i = 0; i < data.size(); i++) {
+			if (dead_.count(data[i]) == 0)
+				data[n++] = data[i];
+		}
+		data.resize(n);
+	}
+
+	void purgeDead_()
+	{
+		std::unordered_set<_T> dead;
+		dead.swap(dead_);
+		if (purge_) {
+			for (const _T &d: dead)
+				purge_(d);
+		}
+	}
+
+	std::shared_ptr<ompl::NearestNeighbors<_T>> inner_;
+	PurgeFunction purge_;
+	const double max_dead_fraction_;
+	std::unordered_set<_T> dead_;
+};
@@ -0,0 +1,129 @@
+#pragma once
+#include "utils/AllocStats.h"
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+
+
+/* Block allocator that owns every object it creates. Objects are laid out contiguously in blocks and
+   everything is destroyed at once by release(). An object may also be destroyed early by destroy(), 
+   in which case its slot is reused by the next create(). Pointers stay valid until then. */
+template <typename T>
+class NodeArena
+{
+public:
+	NodeArena(const std::size_t block_size = 1024): block_size_(block_size > 0 ? block_size : 1) {}
+
+	~NodeArena()
+	{
+		release();
+	}
+
+	NodeArena(const NodeArena &) = delete;
+	NodeArena &operator=(const NodeArena &) = delete;
+
+	/* construct a new object inside the arena */
+	template <typename... Args>
+	T *create(Args &&... args)
+	{
+		T *slot;
+		if (!free_.empty()) {
+			slot = free_.back();
+			free_.pop_back();
+		}
+		else {
+			if (blocks_.empty() || used_in_block_ == block_size_) {
+				blocks_.emplace_back(static_cast<T *>(::operator new(block_size_ * sizeof(T))));
+				used_in_block_ = 0;
+			}
+			slot = blocks_.back().get() + used_in_block_;
+			used_in_block_++;
+		}
+		T *obj = new (slot) T(std::forward<Args>(args)...);
+		size_++;
+		if (account_ != alloc::NUM_SUBSYSTEMS && alloc::isEnabled()) {
+			alloc::onAlloc(account_, sizeof(T));
+			accounted_++;
+		}
+		if (size_ > peak_size_)
+			peak_size_ = size_;
+		if (getBytes() > peak_bytes_)
+			peak_bytes_ = getBytes();
+		return obj;
+	}
+
+	/* destroy a single object of this arena, its slot is kept for reuse */
+	void destroy(T *obj)
+	{
+		obj->~T();
+		free_.push_back(obj);
+		size_--;
+		if (accounted_ > 0) {
+			alloc::onFree(account_, sizeof(T));
+			accounted_--;
+		}
+	}
+
+	/* destroy every object and return all memory */
+	void release()
+	{
+		/* slots of destroyed objects must not be destroyed twice */
+		std::sort(free_.begin(), free_.end(), std::less<T *>());
+		for (std::size_t b = 0; b < blocks_.size(); b++) {
+			const std::size_t n = (b + 1 == blocks_.size()) ? used_in_block_ : block_size_;
+			for (std::size_t i = 0; i < n; i++) {
+				T *obj = blocks_[b].get() + i;
+				if (!std::binary_search(free_.begin(), free_.end(), obj, std::less<T *>()))
+					obj->~T();
+			}
+		}
+		blocks_.clear();
+		free_.clear();
+		used_in_block_ = 0;
+		size_ = 0;
+		if (accounted_ > 0) {
+			alloc::onFree(account_, accounted_ * sizeof(T), accounted_);
+			accounted_ = 0;
+		}
+	}
+
+	/* count the objects of the arena (while accounting is enabled) for subsystem s */
+	void setAccounting(const alloc::Subsystem s) {account_ = s;};
+
+	/* restart the peak statistics from the current usage */
+	void resetStatistics()
+	{
+		peak_size_ = size_;
+		peak_bytes_ = getBytes();
+	}
+
+	/* number of live objects */
+	std::size_t size() const {return size_;};
+
+	/* number of bytes currently reserved by the arena */
+	std::size_t getBytes() const {return blocks_.size() * block_size_ * sizeof(T);};
+
+	/* largest number of live objects since construction */
+	std::size_t getPeakSize() const {return peak_size_;};
+
+	/* largest number of reserved bytes since construction */
+	std::size_t getPeakBytes() const {return peak_bytes_;};
+
+private:
+	struct BlockDeleter
+	{
+		void operator()(T *p) const {::operator delete(p);};
+	};
+
+	const std::size_t block_size_;
+	std::vector<std::unique_ptr<T, BlockDeleter>> blocks_;
+	std::vector<T *> free_;
+	std::size_t used_in_block_{0};
+	std::size_t size_{0};
+	std::size_t peak_size_{0};
+	std::size_t peak_bytes_{0};
+	alloc::Subsystem account_{alloc::NUM_SUBSYSTEMS};  // none
+	std::size_t accounted_{0};  // live objects counted for account_
+};
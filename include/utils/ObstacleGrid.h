@@ -0,0 +1,111 @@
+#pragma once
+#include "utils/common.h"
+#include <boost/geometry/algorithms/envelope.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+
+/* Broad phase of the obstacle checks: a uniform grid over the axis-aligned bounding boxes of obstacle polygons.
+   Every box is stored in the cells it overlaps and forEachNear() visits the obstacles whose box is within a
+   square of half size radius around a point, so a check only looks at the local obstacles.
+   Queries do not modify the grid and may run concurrently. */
+class ObstacleGrid
+{
+public:
+	ObstacleGrid() = default;
+
+	/* cell_size <= 0 picks the average box extent */
+	ObstacleGrid(const std::vector<Polygon> &obstacles, double cell_size = 0.0)
+	{
+		boxes_.reserve(obstacles.size());
+		for (const Polygon &p: obstacles) {
+			bg::model::box<Point> env;
+			bg::envelope(p, env);
+			boxes_.push_back({env.min_corner().x(), env.min_corner().y(), env.max_corner().x(), env.max_corner().y()});
+		}
+		if (boxes_.empty())
+			return;
+
+		x_low_ = y_low_ = std::numeric_limits<double>::infinity();
+		double x_high = -x_low_, y_high = -y_low_, extent = 0;
+		for (const Box &b: boxes_) {
+			x_low_ = std::min(x_low_, b.x_min_);
+			y_low_ = std::min(y_low_, b.y_min_);
+			x_high = std::max(x_high, b.x_max_);
+			y_high = std::max(y_high, b.y_max_);
+			extent += (b.x_max_ - b.x_min_) + (b.y_max_ - b.y_min_);
+		}
+		cell_ = (cell_size > 0) ? cell_size : extent / (2 * boxes_.size());
+		cell_ = std::max(cell_, 1e-6);
+		/* keep the grid at most a few cells per obstacle */
+		const double max_cells = std::max<double>(64, 16 * boxes_.size());
+		while ((std::floor((x_high - x_low_) / cell_) + 1) * (std::floor((y_high - y_low_) / cell_) + 1) > max_cells)
+			cell_ *= 2;
+		nx_ = static_cast<long>(std::floor((x_high - x_low_) / cell_)) + 1;
+		ny_ = static_cast<long>(std::floor((y_high - y_low_) / cell_)) + 1;
+		cells_.resize(nx_ * ny_);
+		for (std::size_t o = 0; o < boxes_.size(); o++) {
+			const Box &b = boxes_[o];
+			for (long i = index_(b.x_min_, x_low_, nx_); i <= index_(b.x_max_, x_low_, nx_); i++)
+				for (long j = index_(b.y_min_, y_low_, ny_); j <= index_(b.y_max_, y_low_, ny_); j++)
+					cells_[i * ny_ + j].push_back(o);
+		}
+	}
+
+	std::size_t size() const {return boxes_.size();};
+
+	/* call f(o) once for every obstacle o whose box intersects [x - radius, x + radius] x [y - radius, y + radius],
+	   until f returns false. Returns false if f did */
+	template <typename F>
+	bool forEachNear(const double x, const double y, const double radius, F f) const
+	{
+		if (boxes_.empty())
+			return true;
+		const double r = std::max(radius, 0.0);
+		const long i0 = index_(x - r, x_low_, nx_), i1 = index_(x + r, x_low_, nx_);
+		const long j0 = index_(y - r, y_low_, ny_), j1 = index_(y + r, y_low_, ny_);
+		for (long i = i0; i <= i1; i++) {
+			for (long j = j0; j <= j1; j++) {
+				for (const std::size_t o: cells_[i * ny_ + j]) {
+					const Box &b = boxes_[o];
+					if (b.x_min_ > x + r || b.x_max_ < x - r || b.y_min_ > y + r || b.y_max_ < y - r)
+						continue;
+					/* an obstacle is reported by the first cell of the query that it overlaps */
+					if (i != std::max(i0, index_(b.x_min_, x_low_, nx_)) || j != std::max(j0, index_(b.y_min_, y_low_, ny_)))
+						continue;
+					if (!f(o))
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+
+private:
+	struct Box
+	{
+		double x_min_;
+		double y_min_;
+		double x_max_;
+		double y_max_;
+	};
+
+	long index_(const double v, const double low, const long n) const
+	{
+		const double idx = std::floor((v - low) / cell_);
+		if (!(idx > 0))
+			return 0;
+		return std::min<long>(idx, n - 1);
+	}
+
+	std::vector<Box> boxes_;
+	std::vector<std::vector<std::size_t>> cells_;
+	double x_low_{0};
+	double y_low_{0};
+	double cell_{1};
+	long nx_{0};
+	long ny_{0};
+};
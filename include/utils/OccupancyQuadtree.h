@@ -0,0 +1,100 @@
+#pragma once
+#include "utils/common.h"
+#include <cstdint>
+#include <vector>
+
+
+/* Occupancy of the cells of a map at every resolution: a region quadtree over the square of 2^depth cells that holds
+   the map, whose leaves are uniformly free or uniformly blocked (the cells beyond the map are free). A large open
+   area or a wide wall is one leaf, so the queries below visit a number of nodes that grows with the structure of the
+   map near the query, not with its number of cells. Cell (x, y) is the unit square centered at (x, y), as the
+   obstacles of Instance. Queries do not modify the tree and may run concurrently. */
+class OccupancyQuadtree
+{
+public:
+    enum Occupancy {FREE, BLOCKED, MIXED};
+
+    struct Box
+    {
+        double x_min_;
+        double y_min_;
+        double x_max_;
+        double y_max_;
+    };
+
+    OccupancyQuadtree() = default;
+
+    /* the cells of blocked, by row (y) then column (x) */
+    explicit OccupancyQuadtree(const std::vector<std::vector<bool>> &blocked);
+
+    /* whether (x, y) lies in a blocked cell (or on its border) */
+    bool blocked(const double x, const double y) const;
+
+    /* FREE if no blocked cell meets box, BLOCKED if box only meets blocked cells */
+    Occupancy occupancy(const Box &box) const;
+
+    /* call f(leaf) for every blocked leaf that meets box, until f returns false. Returns false if f did */
+    template <typename F>
+    bool forEachBlocked(const Box &box, F f) const
+    {
+        if (nodes_.empty())
+            return true;
+        std::uint32_t stack[MAX_STACK_];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node &n = nodes_[stack[--top]];
+            if (n.occupancy_ == FREE || !meets_(n, box))
+                continue;
+            if (n.occupancy_ == BLOCKED) {
+                if (!f(box_(n)))
+                    return false;
+                continue;
+            }
+            for (std::uint32_t c = 0; c < 4; c++)
+                stack[top++] = n.children_ + c;
+        }
+        return true;
+    }
+
+    /* shape meets no blocked cell, tested against the blocked leaves that meet its bounding box only */
+    bool disjoint(const Polygon &shape) const;
+
+    /* signed (Euclidean) distance from (x, y) to the blocked cells, negative inside them. +inf if there are none */
+    double signedDistance(const double x, const double y) const;
+
+    bool empty() const {return blocked_cells_ == 0;};
+
+    std::size_t numLeaves() const {return leaves_;};
+
+    int getDepth() const {return depth_;};
+
+private:
+    /* a depth first search holds at most 3 siblings per level of the tree (sizes are 32-bit), plus the node it expands */
+    static constexpr int MAX_STACK_ = 3 * 32 + 4;
+
+    struct Node
+    {
+        std::int32_t x_;  // lowest cell
+        std::int32_t y_;
+        std::int32_t size_;  // in cells
+        std::uint32_t children_;  // index of the first of the 4, if MIXED
+        Occupancy occupancy_;
+    };
+
+    Box box_(const Node &n) const {return {n.x_ - 0.5, n.y_ - 0.5, n.x_ + n.size_ - 0.5, n.y_ + n.size_ - 0.5};};
+
+    bool meets_(const Node &n, const Box &b) const
+    {
+        return n.x_ - 0.5 <= b.x_max_ && n.x_ + n.size_ - 0.5 >= b.x_min_ && n.y_ - 0.5 <= b.y_max_ &&
+            n.y_ + n.size_ - 0.5 >= b.y_min_;
+    }
+
+    /* distance from (x, y) to the nearest leaf of occupancy (0 inside it), +inf if there is none */
+    double nearest_(const double x, const double y, const Occupancy occupancy) const;
+
+    std::vector<Node> nodes_;
+    std::size_t leaves_{0};
+    std::size_t blocked_cells_{0};
+    int depth_{0};
+};
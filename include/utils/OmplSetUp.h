@@ -3,6 +3,7 @@
 #include "StateValidityCheckers/PCCBlackmoreSVC.h"
 #include "StateValidityCheckers/AdaptiveRiskBlackmoreSVC.h"
 #include "StateValidityCheckers/ChiSquaredBoundarySVC.h"
+#include "StateValidityCheckers/ChiSquaredSDFSVC.h"
 #include "StateValidityCheckers/CentralizedChiSquaredBoundarySVC.h"
 #include "StatePropogators/CarSP.h"
 #include "StatePropogators/UncertainLinearSP.h"
@@ -15,6 +16,8 @@
 #include "Planners/CentralizedBSST.h"
 #include "Planners/BSST.h"
 #include "Spaces/RealVectorBeliefSpace.h"
+#include "Spaces/FixedBeliefSpace.h"
+#include "Spaces/BlockDiagonalBeliefSpace.h"
 // #include "Spaces/R2BeliefSpace.h"
 #include <boost/program_options.hpp>
 
@@ -0,0 +1,52 @@
+#pragma once
+#include <Eigen/Core>
+#include <cstddef>
+#include <vector>
+
+
+/* Relative beliefs of pairs of agents to check in one call, as structure of arrays (the layout of BeliefTrajectories):
+   per record the agents a < b (by which a validator looks up the geometry of the pair), the step, the mean
+   mu_a - mu_b and the covariance Sigma_a + Sigma_b, and the result of the check. A validator adds the records in the
+   order of its sequential checks (by step, then by pair), so the first unsafe record is the conflict those find. */
+struct PairBatch
+{
+    void clear()
+    {
+        a_.clear();
+        b_.clear();
+        step_.clear();
+        for (std::vector<double> *v: {&x_, &y_, &s_xx_, &s_xy_, &s_yy_})
+            v->clear();
+        safe_.clear();
+    }
+
+    void add(const int a, const int b, const int step, const double x, const double y, const double s_xx, const double s_xy,
+        const double s_yy)
+    {
+        a_.push_back(a);
+        b_.push_back(b);
+        step_.push_back(step);
+        x_.push_back(x);
+        y_.push_back(y);
+        s_xx_.push_back(s_xx);
+        s_xy_.push_back(s_xy);
+        s_yy_.push_back(s_yy);
+    }
+
+    std::size_t size() const {return a_.size();};
+
+    Eigen::Vector2d mean(const std::size_t r) const {return Eigen::Vector2d(x_[r], y_[r]);};
+
+    Eigen::Matrix2d covariance(const std::size_t r) const
+    {
+        Eigen::Matrix2d Sigma;
+        Sigma << s_xx_[r], s_xy_[r], s_xy_[r], s_yy_[r];
+        return Sigma;
+    };
+
+    std::vector<int> a_, b_, step_;
+    std::vector<double> x_, y_;
+    std::vector<double> s_xx_, s_xy_, s_yy_;
+    /* whether every record is safe, set by the check of the batch */
+    std::vector<char> safe_;
+};
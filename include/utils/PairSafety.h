@@ -0,0 +1,101 @@
+#pragma once
+#include <Eigen/Core>
+#include <cmath>
+
+
+/* The chance constraint of Blackmore et al. on the relative belief (mu_ab, Sigma_ab) of a pair of robots, specialized
+   at compile time on the class of the Minkowski sum of their shapes and on the sign of erf_inv. A validator
+   classifies its pairs once at setup and runs the kernel of the most general class among them, so its loops over
+   the pairs of a step have no branch on the shape, no virtual call and no dynamically sized matrix:
+     - Point: the sum of two point robots. Of measure zero, the half-planes (all zero) never find it unsafe
+     - Box: an axis-aligned box, whose edges are tested against the standard deviations along x and y
+     - Convex: a general quadrilateral, tested on its four half-planes */
+enum class PairShape {Point = 0, Box = 1, Convex = 2};
+
+/* the Minkowski sum of a pair, as read by the kernels */
+struct PairGeometry
+{
+    PairShape shape_{PairShape::Point};
+    // the box [x_lo_, x_hi_] x [y_lo_, y_hi_], if Box
+    double x_lo_{0}, x_hi_{0}, y_lo_{0}, y_hi_{0};
+    // the half-planes A_ x <= B_, if Convex
+    Eigen::Matrix<double, 4, 2> A_{Eigen::Matrix<double, 4, 2>::Zero()};
+    Eigen::Vector4d B_{Eigen::Vector4d::Zero()};
+
+    /* the class and geometry of the quadrilateral A x <= B (4 x 2 and 4 x 1) */
+    static PairGeometry fromHalfPlanes(const Eigen::Ref<const Eigen::MatrixXd> &A, const Eigen::Ref<const Eigen::MatrixXd> &B)
+    {
+        PairGeometry g;
+        g.A_ = A.topRows<4>();
+        g.B_ = B.topRows<4>().col(0);
+        if ((g.A_.array() == 0).all())
+            return g;
+        // axis-aligned if every edge has one zero coefficient, and the box has one edge on each side
+        int sides[4] = {0, 0, 0, 0};
+        for (int i = 0; i < 4; i++) {
+            const double a0 = g.A_(i, 0), a1 = g.A_(i, 1);
+            if (a1 == 0 && a0 > 0) {
+                g.x_hi_ = g.B_[i] / a0;
+                sides[0]++;
+            }
+            else if (a1 == 0 && a0 < 0) {
+                g.x_lo_ = g.B_[i] / a0;
+                sides[1]++;
+            }
+            else if (a0 == 0 && a1 > 0) {
+                g.y_hi_ = g.B_[i] / a1;
+                sides[2]++;
+            }
+            else if (a0 == 0 && a1 < 0) {
+                g.y_lo_ = g.B_[i] / a1;
+                sides[3]++;
+            }
+        }
+        const bool box = sides[0] == 1 && sides[1] == 1 && sides[2] == 1 && sides[3] == 1 && g.x_lo_ <= g.x_hi_ &&
+            g.y_lo_ <= g.y_hi_;
+        g.shape_ = box ? PairShape::Box : PairShape::Convex;
+        return g;
+    }
+};
+
+/* the most general of two classes */
+inline PairShape widerPairShape(const PairShape a, const PairShape b)
+{
+    return (static_cast<int>(a) < static_cast<int>(b)) ? b : a;
+}
+
+/* true if an edge whose (unnormalized) margin a^T mu - b and quadratic form a^T Sigma a are given passes
+   margin >= sqrt(2 quad) * erf_inv, tested on the squares (scale = 2 erf_inv^2) as BlackmoreHalfPlanes */
+template <bool Positive>
+inline bool edgeSafe(const double margin, const double quad, const double scale)
+{
+    if constexpr (Positive)
+        return margin >= 0 && margin * margin >= scale * quad;
+    else
+        return margin >= 0 || margin * margin <= scale * quad;
+}
+
+/* true if the relative belief ((x, y), [s_xx s_xy; s_xy s_yy]) of a pair of class Shape is safe from its Minkowski
+   sum g. Positive is erf_inv >= 0 */
+template <PairShape Shape, bool Positive>
+inline bool pairSafe(const PairGeometry &g, const double x, const double y, const double s_xx, const double s_xy,
+    const double s_yy, const double scale)
+{
+    if constexpr (Shape == PairShape::Point) {
+        return true;
+    }
+    else if constexpr (Shape == PairShape::Box) {
+        // the edges normalized to unit normals, whose quadratic forms are the variances along x and y
+        return edgeSafe<Positive>(x - g.x_hi_, s_xx, scale) | edgeSafe<Positive>(g.x_lo_ - x, s_xx, scale) |
+            edgeSafe<Positive>(y - g.y_hi_, s_yy, scale) | edgeSafe<Positive>(g.y_lo_ - y, s_yy, scale);
+    }
+    else {
+        bool safe = false;
+        for (int i = 0; i < 4; i++) {
+            const double a0 = g.A_(i, 0), a1 = g.A_(i, 1);
+            const double quad = a0 * a0 * s_xx + 2 * a0 * a1 * s_xy + a1 * a1 * s_yy;
+            safe |= edgeSafe<Positive>(a0 * x + a1 * y - g.B_[i], quad, scale);
+        }
+        return safe;
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+/* A value for every unordered pair {i, j} (i != j) of n agents, stored densely as a triangular array. (i, j) and
+   (j, i) are the same entry, so the pair geometry of the validators is built (and stored) once per pair */
+template <typename T>
+class PairTable
+{
+public:
+    PairTable() = default;
+
+    explicit PairTable(const std::size_t n): n_(n), values_((n > 1) ? n * (n - 1) / 2 : 0) {}
+
+    T &operator()(const std::size_t i, const std::size_t j) {return values_[index_(i, j)];};
+
+    const T &operator()(const std::size_t i, const std::size_t j) const {return values_[index_(i, j)];};
+
+    /* number of agents */
+    std::size_t size() const {return n_;};
+
+private:
+    static std::size_t index_(std::size_t i, std::size_t j)
+    {
+        if (i > j)
+            std::swap(i, j);
+        return j * (j - 1) / 2 + i;
+    }
+
+    std::size_t n_{0};
+    std::vector<T> values_;
+};
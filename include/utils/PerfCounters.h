@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/* Hardware performance counters of the calling thread (Linux perf_event_open): cycles, instructions, cache misses
+   and branch misses, counted in user space. Collection is off by default. Once enabled, every thread opens its
+   counters on its first read and reads only its own, so a phase is measured by two reads on the thread running it:
+
+	const perf::Counters c0 = perf::read();
+	...
+	const perf::Counters phase = perf::read() - c0;
+
+   Where the counters cannot be opened (not Linux, perf_event_paranoid > 2, a virtual machine without a PMU) the
+   reads are zero and a warning is printed once. */
+
+namespace perf
+{
+    struct Counters
+    {
+        std::uint64_t cycles_{0};
+        std::uint64_t instructions_{0};
+        std::uint64_t cache_misses_{0};
+        std::uint64_t branch_misses_{0};
+
+        void add(const Counters &c)
+        {
+            cycles_ += c.cycles_;
+            instructions_ += c.instructions_;
+            cache_misses_ += c.cache_misses_;
+            branch_misses_ += c.branch_misses_;
+        }
+
+        Counters operator-(const Counters &c) const
+        {
+            return {cycles_ - c.cycles_, instructions_ - c.instructions_, cache_misses_ - c.cache_misses_,
+                branch_misses_ - c.branch_misses_};
+        }
+
+        double ipc() const {return (cycles_ > 0) ? static_cast<double>(instructions_) / cycles_ : 0.0;};
+    };
+
+    /* turn collection on or off for all threads */
+    void setEnabled(const bool enabled);
+
+    bool isEnabled();
+
+    /* true if collection is enabled and the counters of the calling thread are open */
+    bool available();
+
+    /* counts of the calling thread since it opened its counters (zero if disabled or unavailable) */
+    Counters read();
+
+    /* peak resident set size of the process so far, in bytes (zero where it is not reported) */
+    std::size_t peakResidentBytes();
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "utils/Benchmark.h"
+#include "utils/SolutionPublisher.h"
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/* Long-running planning service: plans a stream of problem requests with K-CBS, one line per request, keeping the
+   maps and set-up problems of earlier requests warm. A request is a flat JSON object
+
+       {"id": "q1", "map": "maps/empty-32-32.map", "scen": "scens/empty-32-32-1.scen", "numAgents": 4,
+        "lowlevel": "BSST", "pvc": "ChiSquared", "svc": "Blackmore", "p_safe": 0.9, "time": 30, "bound": 10,
+        "export": true}
+
+   or a scen line "map scen numAgents [id]". Only map, scen and numAgents are required, the other settings are
+   taken from the command line. Every response is a JSON line with the id of its request:
+
+       {"id": "q1", "solved": true, "time": 1.25, "soc": 42.5, "setup": 0.01, "warm": true}
+       {"id": "q2", "error": "..."}
+
+   Requests are planned concurrently on a pool of threads, and answered as they finish. Every map is parsed once:
+   its obstacles, inflated obstacles and distance fields are shared by all the instances planned on it. The problem
+   definitions (planners, validity checkers and their allocators) of a configuration are kept idle after their
+   request, cleared, and planned again by the next request of the same configuration. With --publish every solution
+   is also published to that shared memory ring (see utils/SolutionPublisher.h). */
+class PlanningService
+{
+public:
+    PlanningService(const po::variables_map &vm, const unsigned int threads);
+
+    ~PlanningService();
+
+    /* answer every request of in (until its end or a "quit" line) on out */
+    void serve(std::istream &in, std::ostream &out);
+
+    /* plan the request line, and return its response */
+    std::string handle(const std::string &line, const std::string &default_id);
+
+private:
+    // a problem definition of a configuration, set up by an earlier request if warm
+    struct Checkout
+    {
+        std::string key_;
+        MultiRobotProblemDefinitionPtr pdef_;
+        bool warm_{false};
+    };
+
+    bool checkout_(po::variables_map &config, Checkout &checkout, std::string &error);
+
+    void return_(Checkout &checkout);
+
+    void work_();
+
+    const po::variables_map vm_;
+    const unsigned int threads_;
+
+    // the first instance of every map, whose obstacles and geometry the others share (ready once it is parsed)
+    std::map<std::string, std::shared_future<InstancePtr>> map_instances_;
+    // idle problem definitions by configuration
+    std::map<std::string, std::vector<MultiRobotProblemDefinitionPtr>> idle_;
+    std::size_t num_idle_{0};
+    const std::size_t max_idle_{64};
+    std::mutex cache_mutex_;
+
+    // requests waiting for a thread, as (line, default id)
+    std::deque<std::pair<std::string, std::string>> requests_;
+    std::mutex requests_mutex_;
+    std::condition_variable requests_cv_;
+    bool done_{false};
+    std::ostream *out_{nullptr};
+    std::mutex out_mutex_;
+    SolutionPublisher publisher_;
+    std::vector<std::thread> workers_;
+};
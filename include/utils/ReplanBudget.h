@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+
+/* Time budgets of low-level replans, learned from the replans that succeeded. Their times are kept per agent and per
+   number of constraints (in powers of two: 0, 1, 2-3, 4-7, ...) as running log-time statistics, and a replan gets a high
+   quantile of its cell (the mean plus spread standard deviations of the log-times) times margin. A cell with fewer than
+   min_samples_ times falls back to the cells of the agent with fewer constraints, then to those of every agent, and
+   then to the initial budget. The budget doubles with every earlier failure on the same node, and stays within
+   [min, max]. Thread-safe, as the replans of the children may run on several threads. */
+class ReplanBudget
+{
+public:
+    ReplanBudget(const double initial = 0.5, const double min = 0.05, const double margin = 2, const double spread = 2);
+
+    /* seconds for a replan of agent under num_constraints constraints, after failures failed attempts */
+    double budget(const int agent, const std::size_t num_constraints, const unsigned int failures, const double max) const;
+
+    /* a replan of agent under num_constraints constraints succeeded in seconds */
+    void record(const int agent, const std::size_t num_constraints, const double seconds);
+
+    void clear();
+
+    void setInitial(const double initial) {initial_ = initial;};
+
+    double getInitial() const {return initial_;};
+
+private:
+    /* Welford statistics of the log-times of a cell */
+    struct Cell
+    {
+        unsigned int n_{0};
+        double mean_{0};
+        double m2_{0};
+    };
+
+    static std::size_t bucket_(const std::size_t num_constraints);
+
+    /* the estimate of a cell, or a negative value if it has too few samples */
+    double estimate_(const std::vector<Cell> &cells, const std::size_t bucket) const;
+
+    static constexpr unsigned int min_samples_ = 3;
+    double initial_;
+    const double min_;
+    const double margin_;
+    const double spread_;
+    /* cells_[0] pools every agent, cells_[agent + 1] is the agent's */
+    std::vector<std::vector<Cell>> cells_;
+    mutable std::mutex mutex_;
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include "utils/RobotFootprint.h"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+/* Reservation table of prioritized planning: the footprints of the agents of higher priority at every step of their
+   paths, bucketed per step by the grid cell of their reference point. A query only tests the footprints of the cells
+   its bounding circle can reach. Once its path ended, an agent stays at its last footprint. */
+class ReservationTable
+{
+public:
+    ReservationTable() = default;
+
+    /* paths[a][k]: footprint of reserved agent a at step k. The longest path sets the horizon */
+    explicit ReservationTable(const std::vector<std::vector<RobotFootprint>> &paths);
+
+    bool empty() const {return steps_.empty();};
+
+    /* true if fp intersects the footprint of no reserved agent at step */
+    bool isFree(const unsigned int step, const RobotFootprint &fp) const;
+
+private:
+    struct Entry
+    {
+        long cx_, cy_;  // cell of the reference point
+        RobotFootprint fp_;
+    };
+
+    long cell_(const double v) const;
+
+    double cell_size_{1};
+    double max_r_{0};
+    // per step, the entries sorted by cell
+    std::vector<std::vector<Entry>> steps_;
+};
@@ -0,0 +1,119 @@
+#pragma once
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/* One result, as ordered (column, value) pairs. Numbers are written as they are, text is quoted by the backends
+   that need it */
+struct ResultRow
+{
+    struct Field
+    {
+        std::string name_;
+        std::string value_;
+        bool numeric_;
+    };
+
+    void add(const std::string &name, const std::string &value) {fields_.push_back({name, value, false});};
+    void add(const std::string &name, const char *value) {fields_.push_back({name, value, false});};
+
+    template <typename T>
+    void add(const std::string &name, const T &value)
+    {
+        std::ostringstream ss;
+        ss << value;
+        fields_.push_back({name, ss.str(), true});
+    };
+
+    std::vector<Field> fields_;
+};
+
+
+/* Destination of the benchmark results. write() only queues the row, a writer thread appends the queued rows in
+   batches, so the planning threads never wait for the file. The file is opened once, and rows are on disk after
+   flush() (or the destruction of the sink). Thread-safe. */
+class ResultsSink
+{
+public:
+    ResultsSink(std::string filename, const std::size_t batch_rows = 64);
+
+    virtual ~ResultsSink() = default;
+
+    void write(ResultRow row);
+
+    /* block until every row written so far is on disk */
+    void flush();
+
+    const std::string &getFilename() const {return filename_;};
+
+protected:
+    /* append rows to the file. Only called by the writer thread */
+    virtual void writeRows_(const std::vector<ResultRow> &rows) = 0;
+
+    /* flush the rows and stop the writer, called by the destructor of every backend (before its file is closed) */
+    void close_();
+
+    const std::string filename_;
+
+private:
+    void run_();
+
+    const std::size_t batch_rows_;
+    std::mutex mutex_;
+    std::condition_variable pending_cv_;
+    std::condition_variable written_cv_;
+    std::vector<ResultRow> pending_;
+    std::size_t queued_{0};
+    std::size_t written_{0};
+    bool flushing_{false};
+    bool stop_{false};
+    std::thread writer_;
+};
+
+typedef std::shared_ptr<ResultsSink> ResultsSinkPtr;
+
+
+/* Comma separated values, with the header of the first row. Rows are appended to an existing file (under its
+   header). Text with commas or quotes is quoted */
+class CsvResultsSink: public ResultsSink
+{
+public:
+    CsvResultsSink(std::string filename);
+
+    ~CsvResultsSink() override;
+
+protected:
+    void writeRows_(const std::vector<ResultRow> &rows) override;
+
+private:
+    std::ofstream out_;
+    bool header_;
+    std::vector<std::string> columns_;
+    bool warned_{false};
+};
+
+
+/* One JSON object per line (e.g. pandas.read_json(filename, lines=True)). Non-finite numbers are written as null */
+class JsonLinesResultsSink: public ResultsSink
+{
+public:
+    JsonLinesResultsSink(std::string filename);
+
+    ~JsonLinesResultsSink() override;
+
+protected:
+    void writeRows_(const std::vector<ResultRow> &rows) override;
+
+private:
+    std::ofstream out_;
+};
+
+
+/* the sink of filename, by its extension: JSON lines for *.jsonl and *.json, CSV otherwise */
+ResultsSinkPtr make_results_sink(const std::string &filename);
@@ -0,0 +1,113 @@
+#pragma once
+#include "utils/common.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+
+/* Shape of a rectangular (or point) robot at a state: up to four corners on the stack, and a bounding circle. The
+   deterministic validator tests pairs of these instead of building a transformed Polygon for every robot at every
+   step and calling bg::disjoint. */
+struct RobotFootprint
+{
+    static constexpr int max_corners_ = 4;
+
+    std::array<double, max_corners_> x_{}, y_{};
+    int n_{0};
+    // bounding circle, centered on the reference point of the robot
+    double cx_{0}, cy_{0}, r_{0};
+
+    /* the shape of r as given (at its start location), false if it has more than max_corners_ corners */
+    static bool fromRobot(const Robot &r, RobotFootprint &fp)
+    {
+        const auto &ring = bg::exterior_ring(r.getShape());
+        // the rings are closed, the last point repeats the first
+        std::size_t n = ring.size();
+        if (n > 1 && bg::get<0>(ring.front()) == bg::get<0>(ring.back()) && bg::get<1>(ring.front()) == bg::get<1>(ring.back()))
+            n--;
+        fp.n_ = std::min<int>(n, max_corners_);
+        fp.cx_ = r.getStartLocation().x_;
+        fp.cy_ = r.getStartLocation().y_;
+        fp.r_ = 0;
+        for (int k = 0; k < fp.n_; k++) {
+            fp.x_[k] = bg::get<0>(ring[k]);
+            fp.y_[k] = bg::get<1>(ring[k]);
+            fp.r_ = std::max(fp.r_, std::hypot(fp.x_[k] - fp.cx_, fp.y_[k] - fp.cy_));
+        }
+        return n <= static_cast<std::size_t>(max_corners_);
+    }
+
+    /* this shape (as given at its start location) at the pose (x, y, theta), by the transform the state validity
+       checkers apply to the shape of a robot */
+    RobotFootprint transformed(const double x, const double y, const double theta) const
+    {
+        const double c = std::cos(theta);
+        const double s = std::sin(theta);
+        const double tx = x - cx_;
+        const double ty = y - cy_;
+        RobotFootprint fp;
+        fp.n_ = n_;
+        for (int k = 0; k < n_; k++) {
+            fp.x_[k] = c * x_[k] + s * y_[k] + tx;
+            fp.y_[k] = -s * x_[k] + c * y_[k] + ty;
+        }
+        fp.cx_ = c * cx_ + s * cy_ + tx;
+        fp.cy_ = -s * cx_ + c * cy_ + ty;
+        fp.r_ = r_;
+        return fp;
+    }
+
+    double minX() const {return *std::min_element(x_.begin(), x_.begin() + std::max(n_, 1));};
+    double maxX() const {return *std::max_element(x_.begin(), x_.begin() + std::max(n_, 1));};
+    double minY() const {return *std::min_element(y_.begin(), y_.begin() + std::max(n_, 1));};
+    double maxY() const {return *std::max_element(y_.begin(), y_.begin() + std::max(n_, 1));};
+
+    /* true if the (convex) shapes do not intersect: their bounding circles are apart, or the normal of an edge of
+       either separates their corners (separating axis theorem). Touching shapes intersect, as for bg::disjoint */
+    static bool disjoint(const RobotFootprint &a, const RobotFootprint &b)
+    {
+        if (a.n_ == 0 || b.n_ == 0)
+            return true;
+        // prefilter, padded for the rounding of the corners
+        const double dx = a.cx_ - b.cx_;
+        const double dy = a.cy_ - b.cy_;
+        const double rr = (a.r_ + b.r_) * (1 + 1e-9) + 1e-12;
+        if (dx * dx + dy * dy > rr * rr)
+            return true;
+        bool has_edges = false;
+        for (const RobotFootprint *fp: {&a, &b}) {
+            for (int k = 0; k < fp->n_ && fp->n_ > 1; k++) {
+                const int l = (k + 1 < fp->n_) ? k + 1 : 0;
+                const double nx = fp->y_[l] - fp->y_[k];
+                const double ny = fp->x_[k] - fp->x_[l];
+                if (nx == 0 && ny == 0)
+                    continue;
+                has_edges = true;
+                if (separates_(a, b, nx, ny))
+                    return true;
+            }
+        }
+        // two points intersect if they coincide
+        if (!has_edges)
+            return a.x_[0] != b.x_[0] || a.y_[0] != b.y_[0];
+        return false;
+    }
+
+private:
+    static bool separates_(const RobotFootprint &a, const RobotFootprint &b, const double nx, const double ny)
+    {
+        double min_a = nx * a.x_[0] + ny * a.y_[0], max_a = min_a;
+        for (int k = 1; k < a.n_; k++) {
+            const double d = nx * a.x_[k] + ny * a.y_[k];
+            min_a = std::min(min_a, d);
+            max_a = std::max(max_a, d);
+        }
+        double min_b = nx * b.x_[0] + ny * b.y_[0], max_b = min_b;
+        for (int k = 1; k < b.n_; k++) {
+            const double d = nx * b.x_[k] + ny * b.y_[k];
+            min_b = std::min(min_b, d);
+            max_b = std::max(max_b, d);
+        }
+        return max_a < min_b || max_b < min_a;
+    }
+};
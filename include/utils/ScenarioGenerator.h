@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+
+/* Synthetic problems of any size, in the MovingAI format of the shipped maps and scens: a map of randomly blocked
+   cells, and a scen of agents whose start and goal cells are
+
+       free, with all 8 neighbors free too (so a belief at the center of the cell is clear of the obstacles)
+       in the largest 4-connected free region of the map (so every goal is reachable from its start)
+       at least spacing_ away from the starts (goals) of the other agents
+
+   The last field of an agent is the length of its shortest 8-connected path on the grid (without cutting corners), its
+   bucket is that length over 4, as in the MovingAI benchmarks. The first k agents of a scen are planned for k agents,
+   so one scen of the largest k serves a sweep over k. Usage:
+
+	ScenarioSpec spec;
+	spec.width_ = spec.height_ = 256;
+	spec.agents_ = 100;
+	fs::path map, scen;
+	generate_scenario(spec, "generated", map, scen);  // generated/random-256-256-10.map and its scen
+*/
+
+struct ScenarioSpec
+{
+    int width_{64};
+    int height_{64};
+    double density_{0.1};           // fraction of blocked cells
+    unsigned int agents_{10};
+    std::string dynamics_{"2D-Uncertain-Linear-Model"};  // or Uncertain-Unicycle-Model, FirstOrderCar
+    std::string shape_{"Point"};    // or Rectangle
+    double spacing_{2.0};           // least distance between two starts, and between two goals (cells)
+    std::uint32_t seed_{0};         // 0 to pick one
+};
+
+/* random-<width>-<height>-<percent blocked>, the stem of the map of spec */
+std::string scenario_map_name(const ScenarioSpec &spec);
+
+/* the stem of the map followed by the shape and the dynamics (e.g. random-64-64-10-Points-2DUncertainLinear), as
+   the scens that are run on a map start with its name */
+std::string scenario_scen_name(const ScenarioSpec &spec);
+
+/* write the map and the scen of spec into directory (created if needed). False (with an error) if spec is invalid,
+   or the map has too few clear cells for its agents */
+bool generate_scenario(const ScenarioSpec &spec, const fs::path &directory, fs::path &map_file, fs::path &scen_file);
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+
+/* The ranks of a distributed K-CBS search, connected over TCP in a star around rank 0 (the hub). Rank 0 listens on
+   a port and accepts the other ranks, which connect to it. Every message is a frame
+
+       type (uint8), from (int32), to (int32), length (uint32), payload
+
+   and the hub forwards the frames addressed to other ranks. Besides relaying, the hub balances the load: a rank
+   whose queue ran empty asks the hub to steal (STEAL), and the hub forwards the request to the rank that last
+   reported the largest queue (LOAD), which answers the thief with some of its nodes (NODES). Since every transfer
+   passes through it, the hub knows when every rank is waiting for work with no transfer under way, and then ends
+   the search (DONE). It also keeps the cost of the best solution of any rank (SOLUTION), and broadcasts it to
+   every rank when it improves (INCUMBENT). */
+class SearchCluster
+{
+public:
+    enum MessageType: std::uint8_t
+    {
+        NODES = 1,      // nodes given to a thief (payload set by the sender)
+        STEAL = 2,      // a request for nodes: from the thief to the hub, then from the hub to the victim
+        LOAD = 3,       // number of queued nodes of the sender (uint64), to the hub
+        SOLUTION = 4,   // cost (double) of a solution of the sender, then its plan, to the hub
+        INCUMBENT = 5,  // cost (double) of the best solution, from the hub
+        DONE = 6        // the search is over, from the hub
+    };
+
+    struct Message
+    {
+        MessageType type_;
+        int from_;
+        int to_;
+        std::string payload_;
+    };
+
+    /* rank of size ranks, whose hub listens on host:port */
+    SearchCluster(const int rank, const int size, const std::string &host, const int port);
+
+    ~SearchCluster();
+
+    SearchCluster(const SearchCluster &) = delete;
+    SearchCluster &operator=(const SearchCluster &) = delete;
+
+    /* open the connections: the hub waits for every rank, the others retry until the hub accepts them. False (with an
+       error) if they are not all connected within timeout seconds */
+    bool connect(const double timeout);
+
+    void close();
+
+    int getRank() const {return rank_;};
+
+    int getSize() const {return size_;};
+
+    bool isHub() const {return rank_ == 0;};
+
+    /* send a message to rank to (through the hub). False if the connection was lost */
+    bool send(const MessageType type, const int to, const std::string &payload = std::string());
+
+    /* the messages received for this rank, waiting up to wait_ms milliseconds for one if none is ready */
+    std::vector<Message> poll(const int wait_ms);
+
+    /* true once the hub ended the search (or a connection was lost) */
+    bool done() const {return done_;};
+
+    /* the hub: end the search of every rank */
+    void finish();
+
+    /* cost of the best solution of any rank that this rank knows of (infinite if none) */
+    double getIncumbent() const {return incumbent_;};
+
+private:
+    struct Peer
+    {
+        int fd_{-1};
+        std::string in_;   // bytes received, not yet split into frames
+        std::string out_;  // bytes queued, not yet sent
+    };
+
+    /* read the frames that arrived on peer. False if it was closed */
+    bool receive_(Peer &peer);
+
+    /* queue the frame of m to peer, and send what the socket takes. False if the connection was lost */
+    bool write_(Peer &peer, const Message &m);
+
+    /* send what the socket takes of the queued bytes of peer. False if the connection was lost */
+    bool flush_(Peer &peer);
+
+    /* close the connection to peer: a rank is done without its hub, the hub counts the rank as idle */
+    void lost_(Peer &peer);
+
+    /* deliver m on this rank, forward it, or handle it as the hub */
+    void route_(Message m);
+
+    /* the hub: forward the waiting thieves to the ranks with work to give */
+    void dispatchSteals_();
+
+    /* the hub: end the search if every rank waits for work and no transfer is under way */
+    void checkIdle_();
+
+    const int rank_;
+    const int size_;
+    const std::string host_;
+    const int port_;
+
+    int listen_fd_{-1};
+    // the hub has a peer per rank (none for itself), the others only the hub
+    std::vector<Peer> peers_;
+    std::deque<Message> inbox_;
+    bool done_{false};
+    double incumbent_;
+
+    // the hub's view of the ranks: their reported loads, the thieves waiting for a victim, and the steals under way
+    std::vector<std::uint64_t> load_;
+    std::vector<bool> waiting_;
+    std::deque<int> thieves_;
+    std::size_t outstanding_{0};
+};
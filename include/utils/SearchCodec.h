@@ -0,0 +1,102 @@
+#pragma once
+#include "Constraints/Constraint.h"
+#include <ompl/control/PathControl.h>
+#include <ompl/control/SpaceInformation.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace oc = ompl::control;
+
+
+/* Binary encoding of the state of a K-CBS search, for sending conflict-tree nodes between the ranks of a distributed
+   search and for writing checkpoints. Numbers are written in the byte order of the machine, so the ranks of a
+   cluster (and the reader of a checkpoint) must share it. */
+
+/* appends values to a buffer */
+class ByteWriter
+{
+public:
+    template <typename T>
+    void write(const T &value)
+    {
+        data_.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void writeDoubles(const double *values, const std::size_t n)
+    {
+        data_.append(reinterpret_cast<const char *>(values), n * sizeof(double));
+    }
+
+    void writeBytes(const std::string &bytes)
+    {
+        write(std::uint64_t(bytes.size()));
+        data_.append(bytes);
+    }
+
+    const std::string &data() const {return data_;};
+
+    std::string &data() {return data_;};
+
+private:
+    std::string data_;
+};
+
+/* sequential reads of a buffer, failing once past its end */
+class ByteReader
+{
+public:
+    ByteReader(const std::string &data, const std::size_t pos = 0): data_(data), pos_(pos) {}
+
+    template <typename T>
+    bool read(T &value)
+    {
+        if (pos_ + sizeof(T) > data_.size())
+            return false;
+        std::memcpy(&value, data_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    bool readDoubles(double *values, const std::size_t n)
+    {
+        if (n > (data_.size() - pos_) / sizeof(double))
+            return false;
+        std::memcpy(values, data_.data() + pos_, n * sizeof(double));
+        pos_ += n * sizeof(double);
+        return true;
+    }
+
+    bool readBytes(std::string &bytes)
+    {
+        std::uint64_t n;
+        if (!read(n) || n > data_.size() - pos_)
+            return false;
+        bytes.assign(data_.data() + pos_, n);
+        pos_ += n;
+        return true;
+    }
+
+    /* bytes left to read */
+    std::size_t remaining() const {return data_.size() - pos_;};
+
+    std::size_t position() const {return pos_;};
+
+private:
+    const std::string &data_;
+    std::size_t pos_;
+};
+
+/* write a BeliefConstraint or DeterministicConstraint. False for any other kind of constraint */
+bool encodeConstraint(ByteWriter &out, const Constraint &constraint);
+
+/* read a constraint written by encodeConstraint. nullptr if in does not hold one */
+ConstraintPtr decodeConstraint(ByteReader &in);
+
+/* write the states (with the covariances of beliefs), controls and durations of path */
+void encodeTrajectory(ByteWriter &out, const oc::PathControl &path);
+
+/* read a trajectory written by encodeTrajectory into path, whose states are allocated from si. False if in does not
+   hold a trajectory of the spaces of si */
+bool decodeTrajectory(ByteReader &in, const oc::SpaceInformationPtr &si, oc::PathControl &path);
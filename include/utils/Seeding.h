@@ -0,0 +1,28 @@
+#pragma once
+#include <ompl/base/StateSampler.h>
+#include <ompl/control/ControlSampler.h>
+#include <ompl/control/DirectedControlSampler.h>
+#include <cstdint>
+
+/* Explicit seeding of the random number generators of a planner. OMPL seeds every generator it allocates from one
+   global sequence, so with threads (or any change in the order of allocation) the seeds of a planner differ from run
+   to run. A run seed is instead split into independent streams, one per agent and low-level call:
+
+	const std::uint32_t agent_seed = seeding::derive(run_seed, agent);
+	planner->as<ConstraintRespectingPlanner>()->setSeed(seeding::derive(agent_seed, call));
+
+   and the planner seeds its own generator and samplers from it (seeding::seed). */
+
+namespace seeding
+{
+    /* the seed of stream of seed (SplitMix64 of both), never 0 */
+    std::uint32_t derive(const std::uint32_t seed, const std::uint64_t stream);
+
+    /* reseed the generator of a sampler (OMPL keeps it protected) */
+    void seed(ompl::base::StateSampler &sampler, const std::uint32_t seed);
+
+    void seed(ompl::control::ControlSampler &sampler, const std::uint32_t seed);
+
+    /* the control sampler of a SimpleDirectedControlSampler, false if sampler is another kind */
+    bool seed(ompl::control::DirectedControlSampler &sampler, const std::uint32_t seed);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "StateValidityCheckers/BatchValidityChecker.h"
+#include <ompl/control/SpaceInformation.h>
+#include <vector>
+
+namespace ob = ompl::base;
+namespace oc = ompl::control;
+
+
+/* SpaceInformation's propagateWhileValid for the belief checkers that check a segment at once (BatchValidityChecker):
+   every step of the control is propagated into scratch states first, and the whole segment is then checked by one
+   call, rather than one virtual isValid per step. The steps after the first invalid one are propagated for nothing,
+   which costs less than the checks it batches. Without a BatchValidityChecker SpaceInformation's propagateWhileValid
+   is used. The scratch states are kept from one call to the next, so a propagation is owned by one thread. */
+class SegmentPropagation
+{
+public:
+    explicit SegmentPropagation(const oc::SpaceInformation *si): si_(si)
+    {
+        checker_ = dynamic_cast<const BatchValidityChecker *>(si_->getStateValidityChecker().get());
+    }
+
+    ~SegmentPropagation()
+    {
+        for (ob::State *st: states_)
+            si_->freeState(st);
+    }
+
+    SegmentPropagation(const SegmentPropagation &) = delete;
+    SegmentPropagation &operator=(const SegmentPropagation &) = delete;
+
+    /* the number of valid steps (at most steps) of control from source, the last valid state in result (source if
+       none is) */
+    unsigned int propagateWhileValid(const ob::State *source, const oc::Control *control, const unsigned int steps,
+        ob::State *result)
+    {
+        kept_ = 0;
+        if (!checker_)
+            return si_->propagateWhileValid(source, control, steps, result);
+        if (steps == 0) {
+            si_->copyState(result, source);
+            return 0;
+        }
+        while (states_.size() < steps)
+            states_.push_back(si_->allocState());
+        const oc::StatePropagatorPtr &propagator = si_->getStatePropagator();
+        const double dt = si_->getPropagationStepSize();
+        const ob::State *from = source;
+        for (unsigned int k = 0; k < steps; k++) {
+            propagator->propagate(from, control, dt, states_[k]);
+            from = states_[k];
+        }
+        segment_.assign(states_.data(), steps);
+        const std::size_t valid = checker_->firstInvalid(states_.data(), segment_);
+        si_->copyState(result, (valid == 0) ? source : states_[valid - 1]);
+        kept_ = valid;
+        return valid;
+    }
+
+    /* the states of the last propagation if it was checked in one batch and its steps were all valid, nullptr
+       otherwise. They are overwritten by the next propagation */
+    ob::State *const *lastSegment(const unsigned int steps) const
+    {
+        return (steps > 0 && kept_ == steps) ? states_.data() : nullptr;
+    }
+
+private:
+    const oc::SpaceInformation *si_;
+    const BatchValidityChecker *checker_{nullptr};
+    std::vector<ob::State *> states_;
+    /* valid steps of the last propagation in states_ */
+    unsigned int kept_{0};
+    BeliefSegment segment_;
+};
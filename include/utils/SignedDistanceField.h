@@ -0,0 +1,50 @@
+#pragma once
+#include "utils/common.h"
+#include "utils/OccupancyQuadtree.h"
+#include <vector>
+
+
+/* Signed distance to the obstacles of a map, sampled on a grid of nodes spaced by a fixed resolution. The
+   distance is negative inside an obstacle. It is computed once, and a robot of bounding radius r clears the
+   obstacles at a point if the distance there is above r, since the Minkowski sum of a polygon and a disk is a
+   level set of the distance. The distance is 1-Lipschitz, so the field answers with the largest lower bound
+   given by the corners of the cell of a point: it is exact on the nodes and never overestimates the distance
+   of a point outside the obstacles. */
+class SignedDistanceField
+{
+public:
+    SignedDistanceField(const std::vector<Obstacle*> &obstacles, const double x_low, const double x_high,
+        const double y_low, const double y_high, const double resolution, const std::size_t max_nodes = 1 << 22);
+
+    /* the field of the blocked cells of occupancy, each node a search of the tree instead of a pass over the
+       obstacles. Exact inside the cells too, where the field of the obstacles only measures to the nearest one */
+    SignedDistanceField(const OccupancyQuadtree &occupancy, const double x_low, const double x_high,
+        const double y_low, const double y_high, const double resolution, const std::size_t max_nodes = 1 << 22);
+
+    /* lower bound on the signed distance from (x, y) to the obstacles, +inf if there are none */
+    double distance(const double x, const double y) const;
+
+    double getResolution() const {return res_;};
+
+private:
+    struct Ring
+    {
+        std::vector<Point> points_;
+        double x_min_, y_min_, x_max_, y_max_;
+    };
+
+    /* signed distance from (x, y) to the nearest ring, which is the distance to their union outside of them */
+    static double signedDistance_(const std::vector<Ring> &rings, const double x, const double y);
+
+    /* the nodes over [x_low_, x_high] x [y_low_, y_high], coarser than resolution if there would be too many */
+    void resize_(const double x_high, const double y_high, const double resolution, const std::size_t max_nodes);
+
+    long index_(const double v, const double low, const long n) const;
+
+    std::vector<double> values_;
+    double x_low_;
+    double y_low_;
+    double res_;
+    long nx_;
+    long ny_;
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include "utils/FastMath.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+/* Lanes independent xoshiro256+ generators, stored as a structure of arrays so that one call advances all of them in
+   a few vector instructions. The streams of the lanes are seeded by SplitMix64 from one seed, so a generator seeded
+   the same way repeats its numbers. Normal deviates come in pairs from Box-Muller, with the sin, cos and log of
+   utils/FastMath.h. */
+template <std::size_t Lanes>
+class SimdRandom
+{
+public:
+    static constexpr std::size_t lanes_ = Lanes;
+
+    explicit SimdRandom(const std::uint64_t seed = 0)
+    {
+        this->seed(seed);
+    }
+
+    void seed(std::uint64_t seed)
+    {
+        auto split_mix = [&seed]() {
+            std::uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        };
+        for (std::size_t l = 0; l < Lanes; l++) {
+            s0_[l] = split_mix();
+            s1_[l] = split_mix();
+            s2_[l] = split_mix();
+            s3_[l] = split_mix();
+        }
+    }
+
+    /* a uniform deviate in [1, 2) per lane, from the 52 high bits of the next number of its stream */
+    void uniform12(double (&u)[Lanes])
+    {
+        for (std::size_t l = 0; l < Lanes; l++) {
+            const std::uint64_t bits = ((s0_[l] + s3_[l]) >> 12) | 0x3ff0000000000000ull;
+            std::memcpy(&u[l], &bits, sizeof(double));
+            const std::uint64_t t = s1_[l] << 17;
+            s2_[l] ^= s0_[l];
+            s3_[l] ^= s1_[l];
+            s1_[l] ^= s2_[l];
+            s0_[l] ^= s3_[l];
+            s2_[l] ^= t;
+            s3_[l] = (s3_[l] << 45) | (s3_[l] >> 19);
+        }
+    }
+
+    /* two independent standard normal deviates per lane */
+    void gaussian(double (&z0)[Lanes], double (&z1)[Lanes])
+    {
+        double u1[Lanes], u2[Lanes];
+        uniform12(u1);
+        uniform12(u2);
+        const double two_pi = 6.28318530717958647693;
+        double r[Lanes];
+        for (std::size_t l = 0; l < Lanes; l++) {
+            // 2 - u1 is in (0, 1], so the logarithm is finite
+            r[l] = -2 * fastmath::log(2 - u1[l]);
+        }
+        // (a loop of its own, as the errno of std::sqrt keeps the loop around it from vectorizing)
+        for (std::size_t l = 0; l < Lanes; l++)
+            r[l] = std::sqrt(r[l]);
+        for (std::size_t l = 0; l < Lanes; l++) {
+            double s, c;
+            fastmath::sincos(two_pi * (u2[l] - 1), s, c);
+            z0[l] = r[l] * c;
+            z1[l] = r[l] * s;
+        }
+    }
+
+private:
+    std::uint64_t s0_[Lanes], s1_[Lanes], s2_[Lanes], s3_[Lanes];
+};
@@ -0,0 +1,129 @@
+#pragma once
+#include "utils/TrajectoryFile.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+/* Solutions published to the executors on the same host through a ring of slots in POSIX shared memory, rather than
+   through trajectory files. A slot holds the image of the trajectory file of a plan (see utils/TrajectoryFile.h: the
+   means, covariances, controls and durations of every agent), which a subscriber copies out of the slot:
+
+       SolutionRingHeader              magic, version, slots and their size, plans published so far
+       slots                           per slot, a SolutionSlotHeader and the image (8-byte aligned)
+
+   A plan is written to the slot after the one of the last plan, under the seqlock of the slot (its sequence is odd
+   while it is written), and counted as published after. A reader of the latest plan checks the sequence of its slot
+   before and after: the plan was read whole iff it did not change. A reader has the time of slots - 1 publications
+   before its slot is overwritten. One process at a time publishes to a ring. The ring outlives it (as the solution
+   files do), so the readers keep theirs from one planning run to the next. A publisher that died while writing a slot
+   leaves it odd, so the next one to open the ring makes it even (and free) again first */
+
+struct SolutionRingHeader
+{
+    char magic_[8];
+    std::uint32_t version_;
+    std::uint32_t slots_;
+    std::uint64_t slot_bytes_;  // bytes of the image of a slot
+    std::atomic<std::uint64_t> published_;  // the latest plan is number published_, in slot (published_ - 1) % slots_
+};
+
+struct SolutionSlotHeader
+{
+    std::atomic<std::uint64_t> sequence_;
+    std::uint64_t number_;  // of the plan (its published_), 0 if none
+    double stamp_;  // seconds since the epoch of its publication
+    std::uint64_t bytes_;  // bytes of its image
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "the seqlocks are shared by processes");
+static_assert(sizeof(SolutionRingHeader) == 32, "the ring header is 8-byte aligned");
+static_assert(sizeof(SolutionSlotHeader) == 32, "the slot header is 8-byte aligned");
+
+/* The writer of a ring */
+class SolutionPublisher
+{
+public:
+    SolutionPublisher() = default;
+
+    ~SolutionPublisher();
+
+    SolutionPublisher(const SolutionPublisher &) = delete;
+    SolutionPublisher &operator=(const SolutionPublisher &) = delete;
+
+    /* the ring name (e.g. "/kcbs-solutions") of slots of slot_bytes, the one of an earlier run if it has these, a
+       new one otherwise. False (with an error) if it could not be created */
+    bool open(const std::string &name, const unsigned int slots = 4, const std::uint64_t slot_bytes = 8 << 20);
+
+    void close();
+
+    bool isOpen() const {return ring_ != nullptr;};
+
+    /* write plan (one path per agent) to the next slot, and return its number (0 if it does not fit in a slot) */
+    std::uint64_t publish(const std::vector<oc::PathControl*> &plan);
+
+private:
+    SolutionRingHeader *ring_{nullptr};
+    std::size_t size_{0};
+    std::mutex mutex_;
+};
+
+/* A reader of a ring */
+class SolutionSubscriber
+{
+public:
+    SolutionSubscriber() = default;
+
+    ~SolutionSubscriber();
+
+    SolutionSubscriber(const SolutionSubscriber &) = delete;
+    SolutionSubscriber &operator=(const SolutionSubscriber &) = delete;
+
+    /* map the ring name. False (with an error) if there is none yet, or it is not a ring of this version */
+    bool open(const std::string &name);
+
+    void close();
+
+    /* number of the latest plan, 0 if none was published */
+    std::uint64_t latest() const;
+
+    /* f(number, stamp, file) on the latest plan newer than after (file is a TrajectoryFile). The plan is copied out of
+       its slot first, and f only runs once the copy is known to be whole, so f never sees a torn plan. False, without
+       calling f, if there is no newer plan or it was overwritten while copied (try again) */
+    template <typename F>
+    bool view(const std::uint64_t after, F f) const
+    {
+        // the buffer of the thread is kept across calls, so a reader polling the ring does not allocate each time
+        thread_local std::vector<char> image;
+        std::uint64_t number = 0;
+        double stamp = 0;
+        if (!copy_(after, image, number, stamp))
+            return false;
+        TrajectoryFile file;
+        if (!file.openImage(image.data(), image.size()))
+            return false;
+        f(number, stamp, file);
+        return true;
+    }
+
+    /* a copy of the image of the latest plan newer than after (to open with TrajectoryFile::openImage), and its
+       number. False if there is none, or it was overwritten while copied */
+    bool copy(const std::uint64_t after, std::vector<char> &image, std::uint64_t &number) const;
+
+private:
+    /* copy(), with the stamp of the plan */
+    bool copy_(const std::uint64_t after, std::vector<char> &image, std::uint64_t &number, double &stamp) const;
+
+    /* the slot of the latest plan newer than after, and its sequence before it is read */
+    bool begin_(const std::uint64_t after, const SolutionSlotHeader *&slot, std::uint64_t &number,
+        std::uint64_t &sequence) const;
+    /* whether slot still has sequence, so what was read of it is whole */
+    bool end_(const SolutionSlotHeader *slot, const std::uint64_t sequence) const;
+
+    const char *image_(const SolutionSlotHeader *slot) const {return reinterpret_cast<const char *>(slot + 1);};
+
+    const SolutionRingHeader *ring_{nullptr};
+    std::size_t size_{0};
+};
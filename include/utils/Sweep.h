@@ -0,0 +1,33 @@
+#pragma once
+#include "utils/Benchmark.h"
+#include <string>
+
+
+/* Benchmark every configuration of a manifest in one process, into a single results table (the output of the
+   manifest, or of the command line). The manifest is a config file of (repeatable) entries:
+
+       map = maps/random-32-32-10.map      a *.map file, or a directory of them
+       scen = scens/                       a *.scen file, or a directory of them
+       agents = 2:10:2                     a number of agents k, or a range first:last[:step]
+       solver = K-CBS                      K-CBS or CentralizedBSST
+       lowlevel = BSST
+       pvc = ChiSquared                    (only swept for the BSST low-level planner)
+       svc = Blackmore
+       trials = 10
+       workers = 4
+       output = sweep.csv
+       generate = 128x128                  a generated map of width x height (see utils/ScenarioGenerator.h)
+       density = 0.1                       of the generated maps, with agents of
+       dynamics = 2D-Uncertain-Linear-Model
+       shape = Point
+       generated = generated               the directory of the generated maps and scens
+       summary = scaling.csv               a row per configuration: success rate, times, expansions and peak memory
+
+   A scen is run on the map whose name it starts with (e.g. random-32-32-10-Points-2DUncertainLinear.scen on
+   random-32-32-10.map), for every k, solver, low-level planner, PVC and SVC. Entries that are not given are taken
+   from the command line. Every map is loaded once, and its obstacles and geometry caches (inflated obstacles,
+   signed distance fields) are shared by all the instances planned on it. The results of all configurations go through
+   one results sink, opened once on the output, with the width and height of the map of every row. A generated map
+   gets a scen of the largest k, so the scaling curves over k and over the map size (the summary, by configuration)
+   are taken on the same agents. */
+void run_sweep(const po::variables_map &vm, const std::string &manifest, const BenchmarkOptions &options);
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+/* Broadphase of the plan validators: the pairs of agents whose axis-aligned boxes overlap, by sorting the boxes
+   along x and sweeping. The order is kept from one call to the next, so for the boxes of consecutive steps of a
+   plan (which barely move) the insertion sort costs about O(n) instead of O(n log n). Two agents whose boxes are
+   disjoint are only skipped if the boxes are conservative, i.e. if the exact check would find the pair safe. The
+   boxes of agents whose trajectories ended may be marked parked: they are static obstacles to the others, and a pair
+   of two parked boxes is never reported, as it repeats the test of the step the later of them parked at. */
+class SweepAndPrune
+{
+public:
+    /* number of agents of the next sweep. Their order (and which are parked) is kept if it does not change */
+    void resize(const std::size_t n);
+
+    /* box of agent i of the next sweep. A box with a NaN bound overlaps every other */
+    void setBox(const std::size_t i, const double min_x, const double max_x, const double min_y, const double max_y);
+
+    /* whether agent i stays where it is from now on (none is after a resize to a new number of agents) */
+    void setParked(const std::size_t i, const bool parked) {parked_[i] = parked;};
+
+    /* only test these pairs (sorted, e.g. by a midphase), instead of sorting and sweeping the boxes. nullptr to sweep */
+    void setCandidates(const std::vector<std::pair<int, int>> *candidates) {candidates_ = candidates;};
+
+    /* pairs (i, j), i < j, of overlapping (or touching) boxes in lexicographic order, so the first conflict found
+       by testing them in order is the one found by testing every pair */
+    const std::vector<std::pair<int, int>> &sweep();
+
+private:
+    struct Box
+    {
+        double min_x_, max_x_, min_y_, max_y_;
+    };
+
+    std::vector<Box> boxes_;
+    std::vector<int> order_;
+    std::vector<char> parked_;
+    std::vector<std::pair<int, int>> pairs_;
+    const std::vector<std::pair<int, int>> *candidates_{nullptr};
+};
@@ -0,0 +1,141 @@
+#pragma once
+#include <ompl/base/PlannerTerminationCondition.h>
+#include <ompl/util/RandomNumbers.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskGroup;
+
+
+/* The work-stealing thread pool the parallel parts of the library schedule their work on (the replans and root plans
+   of KCBS, its portfolio, the workers of the BSST planners, the chunks of the plan validators), rather than each
+   starting threads of its own. Every worker has a deque of tasks: it runs the newest of its own first, and steals the
+   oldest of the others once it runs out. Tasks are run through a TaskGroup, and a thread that waits for a group runs
+   the pending tasks of that group meanwhile. So groups nest (a task may wait for a group of its own) without
+   deadlocks, and the work of a group still gets done with every worker busy, or with none at all. A task must not
+   block on anything else than a TaskGroup (the service threads of PlanningService or the replan pipelines of KCBS,
+   which wait for jobs, keep threads of their own). */
+class TaskRuntime
+{
+public:
+    /* the runtime of the process, with a worker per hardware thread but one (the thread waiting for a group runs the
+       share of the last) */
+    static TaskRuntime &instance();
+
+    explicit TaskRuntime(const unsigned int workers);
+    ~TaskRuntime();
+
+    TaskRuntime(const TaskRuntime &) = delete;
+    TaskRuntime &operator=(const TaskRuntime &) = delete;
+
+    unsigned int workers() const {return threads_.size();};
+
+    /* index of the calling thread: 1 to workers() on a worker of a runtime, 0 on any other thread */
+    static unsigned int threadIndex();
+
+    /* the generator of the calling thread, for tasks that need random numbers but no reproducible stream (the
+       planners seed generators of their own, see utils/Seeding.h) */
+    static ompl::RNG &rng();
+
+    /* the T of the calling thread (e.g. a NodeArena of scratch objects), default constructed on first use and
+       destroyed with the thread. The objects of a worker are reused by every task it runs, one at a time */
+    template <typename T>
+    static T &local()
+    {
+        static thread_local T t;
+        return t;
+    }
+
+private:
+    friend class TaskGroup;
+
+    struct Task
+    {
+        TaskGroup *group_;
+        std::function<void()> fn_;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex_;
+        std::deque<Task> tasks_;
+    };
+
+    /* into the deque of the calling worker (that of the other threads is queues_[0]) */
+    void push_(Task task);
+    /* the newest task of the deque of worker index, or else the oldest of another */
+    bool pop_(const unsigned int index, Task &task);
+    /* a pending task of group, from any deque */
+    bool popOf_(const TaskGroup *group, Task &task);
+    void execute_(Task &task);
+    void work_(const unsigned int index);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<std::size_t> queued_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    bool stop_{false};
+};
+
+/* Tasks run on a TaskRuntime, whose end a thread waits for (as the join of threads it would have started). The tasks
+   that have not started when the group is cancelled, or when its termination condition holds, are dropped. The
+   destructor waits for the tasks that did start */
+class TaskGroup
+{
+public:
+    explicit TaskGroup(const ompl::base::PlannerTerminationCondition *ptc = nullptr, TaskRuntime &runtime = TaskRuntime::instance()):
+        runtime_(runtime), ptc_(ptc)
+    {
+    }
+
+    ~TaskGroup()
+    {
+        wait();
+    }
+
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    void run(std::function<void()> task);
+
+    /* n tasks f(0), ..., f(n - 1), the first of which the calling thread runs itself before it waits */
+    template <typename F>
+    void runAndWait(const std::size_t n, F f)
+    {
+        for (std::size_t i = 1; i < n; i++)
+            run([f, i]() {f(i);});
+        if (n > 0 && !cancelled())
+            f(0);
+        wait();
+    }
+
+    /* until every task started has finished, running the pending tasks of the group */
+    void wait();
+
+    void cancel() {cancelled_ = true;};
+
+    bool cancelled() const {return cancelled_ || (ptc_ && (*ptc_)());};
+
+private:
+    friend class TaskRuntime;
+
+    /* one task of the group finished (or was dropped) */
+    void finish_();
+
+    TaskRuntime &runtime_;
+    const ompl::base::PlannerTerminationCondition *ptc_;
+    std::atomic<bool> cancelled_{false};
+    /* tasks not finished yet, and those of them still in a deque */
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<std::size_t> queued_{0};
+    std::mutex mutex_;
+    std::condition_variable done_;
+};
@@ -0,0 +1,100 @@
+#pragma once
+#include <string>
+
+/* Scoped begin/end tracing of the planning pipeline, dumped in the Chrome trace event format
+   (chrome://tracing, ui.perfetto.dev). Build with -DKCBS_TRACING=ON to enable it. Otherwise,
+   the macros expand to nothing and the hot loops pay nothing. Usage:
+
+	void foo() {
+		KCBS_TRACE_SCOPE("foo");
+		...
+	}
+	...
+	KCBS_TRACE_DUMP("trace.json");
+*/
+
+#ifdef KCBS_TRACING
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace trace
+{
+	struct Event
+	{
+		const char *name_;
+		std::int64_t begin_us_;
+		std::int64_t end_us_;
+	};
+
+	/* Fixed size ring buffer of one thread. Only the owning thread writes, so pushing is a plain
+	   store followed by a release of the head. The oldest events are overwritten when it is full. */
+	class ThreadBuffer
+	{
+	public:
+		static constexpr std::size_t capacity_ = 1 << 16;
+
+		ThreadBuffer(const unsigned int tid): tid_(tid) {}
+
+		void push(const Event &e)
+		{
+			const std::size_t h = head_.load(std::memory_order_relaxed);
+			events_[h % capacity_] = e;
+			head_.store(h + 1, std::memory_order_release);
+		}
+
+		std::size_t head() const {return head_.load(std::memory_order_acquire);};
+
+		const Event &at(const std::size_t i) const {return events_[i % capacity_];};
+
+		unsigned int getThreadId() const {return tid_;};
+
+	private:
+		const unsigned int tid_;
+		std::atomic<std::size_t> head_{0};
+		std::array<Event, capacity_> events_;
+	};
+
+	/* buffer of the calling thread, registered on first use */
+	ThreadBuffer &threadBuffer();
+
+	/* microseconds since the tracer was first used */
+	std::int64_t now();
+
+	/* write the events of all threads to a Chrome trace JSON file. Events recorded concurrently
+	   with the dump may be torn, so call it once planning has finished. */
+	bool dump(const std::string &filename);
+
+	class Scope
+	{
+	public:
+		Scope(const char *name): name_(name), begin_us_(now()) {}
+
+		~Scope()
+		{
+			threadBuffer().push({name_, begin_us_, now()});
+		}
+
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+	private:
+		const char *name_;
+		const std::int64_t begin_us_;
+	};
+}
+
+#define KCBS_TRACE_CONCAT_(a, b) a##b
+#define KCBS_TRACE_CONCAT(a, b) KCBS_TRACE_CONCAT_(a, b)
+#define KCBS_TRACE_SCOPE(name) trace::Scope KCBS_TRACE_CONCAT(kcbs_trace_scope_, __LINE__)(name)
+#define KCBS_TRACE_DUMP(filename) trace::dump(filename)
+
+#else
+
+#define KCBS_TRACE_SCOPE(name) ((void)0)
+#define KCBS_TRACE_DUMP(filename) false
+
+#endif
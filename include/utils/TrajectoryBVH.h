@@ -0,0 +1,110 @@
+#pragma once
+#include <ompl/control/PathControl.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace oc = ompl::control;
+
+
+/* Temporal bounding-volume hierarchy of an interpolated belief trajectory. Every node covers a range of steps with
+   the bounding box of the means and the largest (x-y) covariance eigenvalue over that range. Once the trajectory
+   ends, the robot stays at its last belief, which a tail node covers until the end of time. A validator inflates the
+   boxes by its own conservative margin, and a pair of robots is safe over every span where their boxes are disjoint.
+   Built once per trajectory (see DiscretePlan::getBVH). */
+class TrajectoryBVH
+{
+public:
+    struct Node
+    {
+        double min_x_, max_x_, min_y_, max_y_;
+        double max_lambda_;       // largest eigenvalue of the covariances
+        double max_sqrt_lambda_;  // sqrt of max_lambda_ (0 if it is negative)
+        int first_step_, last_step_;
+        int left_{-1};
+        int right_{-1};
+    };
+
+    explicit TrajectoryBVH(const oc::PathControl &traj);
+
+    bool empty() const {return nodes_.empty();};
+
+    /* the spans [first, last] of steps in [first_step, last_step] where the boxes of a and b, inflated by
+       inflate_a(node) and inflate_b(node), overlap. The spans are ordered and disjoint. Every step is reported if
+       a trajectory is empty */
+    template <typename InflateA, typename InflateB>
+    static std::vector<std::pair<int, int>> overlappingSpans(const TrajectoryBVH &a, InflateA &&inflate_a, const TrajectoryBVH &b,
+        InflateB &&inflate_b, const int first_step, const int last_step)
+    {
+        std::vector<std::pair<int, int>> spans;
+        if (first_step > last_step)
+            return spans;
+        if (a.empty() || b.empty()) {
+            spans.emplace_back(first_step, last_step);
+            return spans;
+        }
+        for (const int na: {a.root_, a.tail_}) {
+            for (const int nb: {b.root_, b.tail_})
+                a.descend_(na, inflate_a, b, nb, inflate_b, first_step, last_step, spans);
+        }
+        if (spans.empty())
+            return spans;
+        std::sort(spans.begin(), spans.end());
+        // merge adjacent spans
+        std::size_t m = 0;
+        for (std::size_t k = 1; k < spans.size(); k++) {
+            if (spans[k].first <= spans[m].second + 1)
+                spans[m].second = std::max(spans[m].second, spans[k].second);
+            else
+                spans[++m] = spans[k];
+        }
+        spans.resize(m + 1);
+        return spans;
+    }
+
+    /* number of steps of the leaves */
+    static constexpr int leaf_steps_ = 8;
+
+private:
+    template <typename InflateA, typename InflateB>
+    void descend_(const int na, InflateA &inflate_a, const TrajectoryBVH &b, const int nb, InflateB &inflate_b,
+        const int first_step, const int last_step, std::vector<std::pair<int, int>> &spans) const
+    {
+        const Node &x = nodes_[na];
+        const Node &y = b.nodes_[nb];
+        const int first = std::max({x.first_step_, y.first_step_, first_step});
+        const int last = std::min({x.last_step_, y.last_step_, last_step});
+        if (first > last)
+            return;
+        // padded for the rounding of the exact checks
+        const double w = (inflate_a(x) + inflate_b(y)) * (1 + 1e-9) + 1e-12;
+        // (NaN boxes or margins are never disjoint)
+        if (x.min_x_ - y.max_x_ > w || y.min_x_ - x.max_x_ > w || x.min_y_ - y.max_y_ > w || y.min_y_ - x.max_y_ > w)
+            return;
+        const bool leaf_x = (x.left_ < 0);
+        const bool leaf_y = (y.left_ < 0);
+        if (leaf_x && leaf_y) {
+            spans.emplace_back(first, last);
+            return;
+        }
+        // split the node that covers the longer span
+        const long span_x = static_cast<long>(x.last_step_) - x.first_step_;
+        const long span_y = static_cast<long>(y.last_step_) - y.first_step_;
+        if (!leaf_x && (leaf_y || span_x >= span_y)) {
+            descend_(x.left_, inflate_a, b, nb, inflate_b, first_step, last_step, spans);
+            descend_(x.right_, inflate_a, b, nb, inflate_b, first_step, last_step, spans);
+        }
+        else {
+            descend_(na, inflate_a, b, y.left_, inflate_b, first_step, last_step, spans);
+            descend_(na, inflate_a, b, y.right_, inflate_b, first_step, last_step, spans);
+        }
+    }
+
+    int build_(const std::vector<Node> &leaves, const std::size_t first, const std::size_t last);
+
+    std::vector<Node> nodes_;
+    int root_{-1};
+    int tail_{-1};
+};
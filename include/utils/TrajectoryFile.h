@@ -0,0 +1,107 @@
+#pragma once
+#include <ompl/control/PathControl.h>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace oc = ompl::control;
+namespace fs = std::filesystem;
+
+
+/* Binary trajectory file of a plan, written in one pass and laid out to be memory-mapped as it is:
+
+       TrajectoryFileHeader            magic, version, byte order and number of agents
+       TrajectoryFileAgent[agents]     dimensions of every agent and the offsets of its arrays
+       arrays                          per agent, contiguous doubles (8-byte aligned):
+                                           means        states x state dim
+                                           covariances  states x rows x cols (column major, sigma + lambda)
+                                           controls     (states - 1) x control dim
+                                           durations    states - 1
+
+   Offsets are in bytes from the start of the file. Deterministic plans have no covariances (rows = cols = 0).
+   Numbers have the byte order of the writer, which the reader checks. */
+
+struct TrajectoryFileHeader
+{
+    char magic_[8];
+    std::uint32_t version_;
+    std::uint32_t byte_order_;  // 0x01020304 as written
+    std::uint32_t agents_;
+    std::uint32_t reserved_;
+};
+
+struct TrajectoryFileAgent
+{
+    std::uint32_t states_;
+    std::uint32_t state_dim_;
+    std::uint32_t cov_rows_;
+    std::uint32_t cov_cols_;
+    std::uint32_t control_dim_;
+    std::uint32_t reserved_;
+    std::uint64_t means_;
+    std::uint64_t covariances_;
+    std::uint64_t controls_;
+    std::uint64_t durations_;
+};
+
+static_assert(sizeof(TrajectoryFileHeader) == 24, "the header is 8-byte aligned");
+static_assert(sizeof(TrajectoryFileAgent) == 56, "the agent table is 8-byte aligned");
+
+/* write the trajectories of plan (one path per agent) to filename. False if it could not be written */
+bool writeTrajectoryFile(const fs::path &filename, const std::vector<oc::PathControl*> &plan);
+
+/* the bytes of the file of plan, and the file itself written to the (8-byte aligned) memory at image, e.g. shared
+   memory (see utils/SolutionPublisher.h) */
+std::uint64_t trajectoryImageSize(const std::vector<oc::PathControl*> &plan);
+
+void writeTrajectoryImage(const std::vector<oc::PathControl*> &plan, char *image);
+
+
+/* Read-only view of a trajectory file, memory-mapped where available (read into memory otherwise) */
+class TrajectoryFile
+{
+public:
+    TrajectoryFile() = default;
+
+    ~TrajectoryFile();
+
+    TrajectoryFile(const TrajectoryFile &) = delete;
+    TrajectoryFile &operator=(const TrajectoryFile &) = delete;
+
+    /* map filename and check its header and offsets. False (with an error) if it is not a valid trajectory file */
+    bool open(const fs::path &filename);
+
+    /* view the trajectory file in the size bytes at data (not copied, so they must outlive the view) */
+    bool openImage(const char *data, const std::size_t size);
+
+    void close();
+
+    std::size_t numAgents() const {return agents_.size();};
+
+    const TrajectoryFileAgent &getAgent(const std::size_t a) const {return agents_[a];};
+
+    const double *getMeans(const std::size_t a) const {return array_(agents_[a].means_);};
+
+    const double *getCovariances(const std::size_t a) const {return array_(agents_[a].covariances_);};
+
+    const double *getControls(const std::size_t a) const {return array_(agents_[a].controls_);};
+
+    const double *getDurations(const std::size_t a) const {return array_(agents_[a].durations_);};
+
+private:
+    /* the header and offsets of data_, named filename in the errors */
+    bool check_(const std::string &filename);
+
+    const double *array_(const std::uint64_t offset) const {return reinterpret_cast<const double *>(data_ + offset);};
+
+    const char *data_{nullptr};
+    std::size_t size_{0};
+    bool mapped_{false};
+    std::vector<char> buffer_;
+    std::vector<TrajectoryFileAgent> agents_;
+};
+
+/* write the trajectory file as text for debugging, in directory: agentNN.txt (a row per state of its mean, then
+   the control and duration that leave it) and agentNN_covs.txt (a row per state of its row-major covariance) */
+bool convertTrajectoryFileToText(const fs::path &filename, const fs::path &directory);
@@ -9,7 +9,11 @@
 #include "PlanValidityCheckers/AdaptiveRiskBoundingBoxPVC.h"
 #include "PlanValidityCheckers/CDFGridPVC.h"
 #include "PlanValidityCheckers/Blackmore2PVC.h"
+#include "PlanValidityCheckers/MonteCarloPVC.h"
+#include "utils/PerfCounters.h"
+#include <algorithm>
 #include <chrono>
+#include <functional>
 #include <filesystem>
 #include <unordered_map>
 #include <ompl/control/SpaceInformation.h>
@@ -24,11 +28,52 @@ class BeliefCollisionCheckerBenchmark
 public:
     BeliefCollisionCheckerBenchmark(std::string file1, std::string file2);
 
+    /* Time every checker on the belief pairs: the latency percentiles of individual checks, the throughput of batches
+       of iterations passes over every pair on 1 and more threads, and (with a reference) how often it accepts unsafe
+       pairs or rejects safe ones. One row per checker goes to the summary table, and every check to its own file */
     void runBenchmarks();
 
+    /* passes over every pair of the throughput batches (100 by default) */
+    void setIterations(const unsigned int n) {iterations_ = std::max(n, 1u);};
+
+    /* times every check is repeated for the latency percentiles (10 by default) */
+    void setLatencyRepeats(const unsigned int n) {latency_repeats_ = std::max(n, 1u);};
+
+    /* numbers of threads the throughput is measured on, each with its own checker ({1, 2, 4} by default) */
+    void setThreads(std::vector<unsigned int> threads) {threads_ = std::move(threads);};
+
+    /* Monte Carlo samples of the reference collision probability of a pair, 0 to skip the accuracy (10000 by default) */
+    void setReferenceSamples(const unsigned int n) {reference_samples_ = n;};
+
+    void setSummaryFile(std::string filename) {summary_file_ = std::move(filename);};
+
+    /* also write the hardware counters per check of the single-threaded batches (see utils/PerfCounters.h) */
+    void setPerfCounters(const bool enabled) {perf_counters_ = enabled;};
+
 private:
+    typedef std::function<bool(ob::State *, ob::State *)> CheckFn;
+
+    struct Checker
+    {
+        std::string name_;
+        std::string results_file_;
+        std::function<CheckFn()> make_;
+    };
+
+    std::vector<Checker> checkers_() const;
+
+    /* true for the pairs whose collision probability (estimated by sampling) is within 1 - p_safe */
+    std::vector<bool> referenceSafety_() const;
+
     void exportResults_(std::string filename, std::vector<std::pair<double, bool>> results);
 
+    unsigned int iterations_{100};
+    unsigned int latency_repeats_{10};
+    std::vector<unsigned int> threads_{1, 2, 4};
+    unsigned int reference_samples_{10000};
+    std::string summary_file_{"collision_checker_summary.csv"};
+    bool perf_counters_{false};
+
     std::string beliefList1_;
     std::string beliefList2_;
 
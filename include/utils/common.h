@@ -52,6 +52,9 @@ class Robot
 public:
     Robot(std::string name, std::string model, Location start, Location goal);
     std::string getName() const;
+    /* index of the robot in its instance (and of its trajectory in a plan) */
+    int getId() const;
+    void setId(const int id);
     std::string getDynamicsModel() const;
     const Polygon& getShape() const;
     const Polygon& getBoundingShape() const;
@@ -63,6 +66,7 @@ public:
     void createBoundingShape();
 protected:
     std::string name_;
+    int id_{-1};
     std::string dyn_model_;
     Polygon shape_;
     Polygon bounding_poly_;
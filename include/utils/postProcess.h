@@ -1,5 +1,6 @@
 #pragma once
 #include "Spaces/RealVectorBeliefSpace.h"
+#include "utils/TrajectoryFile.h"
 #include <fstream>
 #include <filesystem>
 #include <ompl/control/PathControl.h>
@@ -22,5 +23,5 @@ namespace fs = std::filesystem;
 // // parent function for including date/time information to files
 // fs::path appendTimeToFileName(const fs::path& fileName);
 
-// // write solultion to the system
-void exportBeliefPlan(const std::vector<oc::PathControl*> plan, const std::string problem_name);
+// write solultion to the system, as one binary trajectory file (and the text files of its agents with text)
+void exportBeliefPlan(const std::vector<oc::PathControl*> plan, const std::string problem_name, const bool text = false);
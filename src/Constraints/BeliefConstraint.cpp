@@ -1,12 +1,29 @@
 #include "Constraints/BeliefConstraint.h"
+#include "utils/BeliefTrajectories.h"
+#include <ompl/util/Console.h>
 
 BeliefConstraint::BeliefConstraint(int constrained_agent, int constraining_agent, 
-	std::vector<double> timeRange, std::vector<ob::State*> beliefStates):
-		Constraint(constrained_agent, constraining_agent, timeRange), belief_states_(beliefStates) {}
+	std::vector<double> timeRange, std::vector<Record> records, const bool positive):
+		Constraint(constrained_agent, constraining_agent, timeRange, positive), records_(std::move(records))
+{
+	account_(sizeof(*this) + records_.capacity() * sizeof(Record));
+}
 
-BeliefConstraint::~BeliefConstraint(){}
+BeliefConstraint::Record BeliefConstraint::Record::fromState(const ob::State *st, const int step)
+{
+	Record r;
+	r.step_ = step;
+	if (!BeliefTrajectories::extract(st, r.x_, r.y_, r.s_xx_, r.s_xy_, r.s_yy_))
+		OMPL_ERROR("Please specify the x and y elements of this type of space!");
+	return r;
+}
 
-const std::vector<ob::State*> BeliefConstraint::getStates() const 
+std::size_t BeliefConstraint::hash(const double resolution) const
 {
-	return belief_states_;
+	std::size_t seed = Constraint::hash(resolution);
+	for (const Record &r: records_) {
+		for (const double v: {r.x_, r.y_, r.s_xx_, r.s_xy_, r.s_yy_})
+			boost::hash_combine(seed, quantize_(v, resolution));
+	}
+	return seed;
 }
@@ -2,10 +2,25 @@
 
 
 DeterministicConstraint::DeterministicConstraint(int constrained_agent, int constraining_agent, 
-	std::vector<double> timeRange, std::vector <Polygon> shapes):
-		Constraint(constrained_agent, constraining_agent, timeRange), shapes_(shapes) {}
+	std::vector<double> timeRange, std::vector<RobotFootprint> shapes, const bool positive):
+		Constraint(constrained_agent, constraining_agent, timeRange, positive), shapes_(std::move(shapes))
+{
+	account_(sizeof(*this) + shapes_.capacity() * sizeof(RobotFootprint));
+}
 
 DeterministicConstraint::~DeterministicConstraint()
 {
 	shapes_.clear();
 }
+
+std::size_t DeterministicConstraint::hash(const double resolution) const
+{
+	std::size_t seed = Constraint::hash(resolution);
+	for (const RobotFootprint &shape: shapes_) {
+		for (int k = 0; k < shape.n_; k++) {
+			boost::hash_combine(seed, quantize_(shape.x_[k], resolution));
+			boost::hash_combine(seed, quantize_(shape.y_[k], resolution));
+		}
+	}
+	return seed;
+}
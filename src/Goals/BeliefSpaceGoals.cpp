@@ -1,13 +1,11 @@
 #include "Goals/BeliefSpaceGoals.h"
+#include "utils/DiskGeometry.h"
 #include <boost/geometry.hpp>
-#include <boost/geometry/strategies/buffer.hpp>
 #include <boost/math/distributions/chi_squared.hpp>
-#include <boost/geometry/multi/geometries/multi_polygon.hpp>
-#include <Eigen/Eigenvalues> 
 
 
 ChanceConstrainedGoal::ChanceConstrainedGoal(const oc::SpaceInformationPtr &si, const Location goal, const double toll, const double p_safe):
-	ob::Goal(si), threshold_(toll), p_safe_(p_safe), A_(4, 2), B_(4, 1), goal_(2, 1)
+	ob::Goal(si), threshold_(toll), p_safe_(p_safe), sc_(quantile(bm::chi_squared(2), p_safe)), A_(4, 2), B_(4, 1), goal_(2, 1)
 {
 	/* Save the goal as a 2d eigen vector */
 	goal_(0, 0) = goal.x_;
@@ -99,53 +97,16 @@ bool ChanceConstrainedGoal::isSafe_(const ob::State* st, double *distance) const
         const double dx = (belief.first(0, 0) - goal_(0, 0));
         const double dy = (belief.first(1, 0) - goal_(1, 0));
         *distance = (dx*dx + dy*dy);
-        if (*distance < 2.0)
-            std::cout << *distance << std::endl;
     }
 
 
     /* Find maximum eigenvalues of the covariances */
-    Eigen::EigenSolver<Eigen::Matrix2d> eigensolver_a;
-    eigensolver_a.compute(Sigma_ab);
-
-    const double max_lambda = eigensolver_a.eigenvalues().real().maxCoeff();
-    double sc_ = quantile(bm::chi_squared(2), p_safe_);
-    double max_rad_ = 0.0;
+    const double max_lambda = maxEigenvalue2x2(Sigma_ab);
+    const double max_rad_ = 0.0;
     const double boundary = (max_lambda * sc_ + max_rad_);
 
-    bg::strategy::buffer::distance_symmetric<double> distance_strategy(boundary);
-
-    Point center = Point(mu_ab[0], mu_ab[1]);
-    bg::model::multi_polygon<Polygon> tmp;  // buffer generates multipolygons
-    Polygon disk;
-
-    const std::size_t points_per_circle_ = 10;
-    bg::strategy::buffer::join_round join_strategy{points_per_circle_};
-    boost::geometry::strategy::buffer::end_flat end_strategy;
-    bg::strategy::buffer::point_circle circle_strategy{points_per_circle_};
-    bg::strategy::buffer::side_straight side_strategy;
-
-    // make disk centered on `center` and of correct `radius`
-    bg::buffer(center, tmp, distance_strategy, side_strategy,
-               join_strategy, end_strategy, circle_strategy);
-
-    Point center2 = Point(goal_(0, 0), goal_(1, 0));
-    bg::model::multi_polygon<Polygon> tmp2;  // buffer generates multipolygons
-    Polygon goal_disk;
-    bg::strategy::buffer::distance_symmetric<double> distance_strategy2(threshold_);
-
-    // make disk centered on `center` and of correct `radius`
-    bg::buffer(center2, tmp2, distance_strategy2, side_strategy,
-               join_strategy, end_strategy, circle_strategy);
-    
-    // convert the MultiPolygon output to a simple polygon
-    disk = Polygon(tmp[0]);
-    goal_disk = Polygon(tmp2[0]);
-    if (bg::within(disk, goal_disk))
-        return true;
-    return false;
-
-
+    // the safety disk must lie within the goal disk
+    return diskWithinDisk(mu_ab[0], mu_ab[1], boundary, goal_(0, 0), goal_(1, 0), threshold_);
 
     // auto const n_rows = A_.rows();
     // for (int i = 0; i < n_rows; i++) {
@@ -160,7 +121,8 @@ bool ChanceConstrainedGoal::isSafe_(const ob::State* st, double *distance) const
 }
 
 CentralizedCCGoal::CentralizedCCGoal(const oc::SpaceInformationPtr &si, const ob::State* goal, const double toll, const double p_safe):
-    ob::Goal(si), threshold_(toll), p_safe_(p_safe), num_agents_(si->getStateSpace()->getDimension() / 2), goal_(Eigen::VectorXd::Zero(si->getStateSpace()->getDimension()))
+    ob::Goal(si), threshold_(toll), p_safe_(p_safe), erf_inv_(bm::erf_inv(1 - (2 * p_safe))), num_agents_(si->getStateSpace()->getDimension() / 2),
+    goal_(Eigen::VectorXd::Zero(si->getStateSpace()->getDimension()))
 {
     // fill goal vector
     const double* all_goal_values = goal->as<RealVectorBeliefSpace::StateType>()->values;
@@ -168,6 +130,7 @@ CentralizedCCGoal::CentralizedCCGoal(const oc::SpaceInformationPtr &si, const ob
         goal_[idx] = all_goal_values[idx];
 
     // create goal half-planes
+    half_planes_.reserve(num_agents_);
     for (auto a = 0; a < num_agents_; a++) {
         /* Save the goal as a 2d eigen vector */
         Eigen::Vector2d goal_a{goal_[2 * a], goal_[2 * a + 1]};
@@ -186,9 +149,7 @@ CentralizedCCGoal::CentralizedCCGoal(const oc::SpaceInformationPtr &si, const ob
 
         bg::correct(goal_poly);
 
-        std::pair<Eigen::MatrixXd, Eigen::MatrixXd> hp = createHalfPlanes_(goal_poly);
-
-        half_plane_map_[a] = hp;
+        half_planes_.push_back(createHalfPlanes_(goal_poly));
     }
 }
 
@@ -230,14 +191,13 @@ bool CentralizedCCGoal::isSatisfied(const ob::State *st) const
 {
     /* Determine if in goal region */
     const double* all_st_values = st->as<RealVectorBeliefSpace::StateType>()->values;
-    const Eigen::MatrixXd all_sigmas = st->as<RealVectorBeliefSpace::StateType>()->sigma_;
-    const Eigen::MatrixXd all_lambdas = st->as<RealVectorBeliefSpace::StateType>()->lambda_;
+    const auto *belief = st->as<RealVectorBeliefSpace::StateType>();
 
     for (int a = 0; a < num_agents_;  a++) {
-        Eigen::Vector2d mu_a{all_st_values[2 * a], all_st_values[2 * a + 1]};
-        Eigen::Matrix2d sigma_a = all_sigmas.block<2, 2>(2 * a, 2 * a);
-        Eigen::Vector2d goal_a{goal_[2 * a], goal_[2 * a + 1]};
-        if (!isSafe_(mu_a, sigma_a, goal_a, half_plane_map_.at(a), nullptr))
+        const Eigen::Vector2d mu_a{all_st_values[2 * a], all_st_values[2 * a + 1]};
+        const Eigen::Matrix2d sigma_a = belief->sigmaBlock(a);
+        const Eigen::Vector2d goal_a{goal_[2 * a], goal_[2 * a + 1]};
+        if (!isSafe_(mu_a, sigma_a, goal_a, half_planes_[a], nullptr))
             return false;
     }
     return true;
@@ -248,19 +208,17 @@ bool CentralizedCCGoal::isSatisfied(const ob::State *st, double *distance) const
     
     /* Determine if in goal region */
     const double* all_st_values = st->as<RealVectorBeliefSpace::StateType>()->values;
-    const Eigen::MatrixXd all_sigmas = st->as<RealVectorBeliefSpace::StateType>()->sigma_;
-    // const Eigen::MatrixXd all_lambdas = st->as<RealVectorBeliefSpace::StateType>()->lambda_;
+    const auto *belief = st->as<RealVectorBeliefSpace::StateType>();
 
     bool result = true;
 
     for (int a = 0; a < num_agents_;  a++) {
-        Eigen::Vector2d mu_a{all_st_values[2 * a], all_st_values[2 * a + 1]};
-        Eigen::Matrix2d sigma_a = all_sigmas.block<2, 2>(2 * a, 2 * a);
-        Eigen::Vector2d goal_a{goal_[2 * a], goal_[2 * a + 1]};
-        if (!isSafe_(mu_a, sigma_a, goal_a, half_plane_map_.at(a), distance))
+        const Eigen::Vector2d mu_a{all_st_values[2 * a], all_st_values[2 * a + 1]};
+        const Eigen::Matrix2d sigma_a = belief->sigmaBlock(a);
+        const Eigen::Vector2d goal_a{goal_[2 * a], goal_[2 * a + 1]};
+        if (!isSafe_(mu_a, sigma_a, goal_a, half_planes_[a], distance))
             result = false;
     }
-    // std::cout << *distance << std::endl;
     return result;
 }
 
@@ -268,21 +226,20 @@ bool CentralizedCCGoal::isSingleAgentSatisfied(const ob::State *st, const int id
 {
     /* Determine if in goal region */
     const double* all_st_values = st->as<RealVectorBeliefSpace::StateType>()->values;
-    const Eigen::MatrixXd all_sigmas = st->as<RealVectorBeliefSpace::StateType>()->sigma_;
+    const auto *belief = st->as<RealVectorBeliefSpace::StateType>();
 
-    Eigen::Vector2d mu_a{all_st_values[2 * idx], all_st_values[2 * idx + 1]};
-    Eigen::Matrix2d sigma_a = all_sigmas.block<2, 2>(2 * idx, 2 * idx);
-    Eigen::Vector2d goal_a{goal_[2 * idx], goal_[2 * idx + 1]};
+    const Eigen::Vector2d mu_a{all_st_values[2 * idx], all_st_values[2 * idx + 1]};
+    const Eigen::Matrix2d sigma_a = belief->sigmaBlock(idx);
+    const Eigen::Vector2d goal_a{goal_[2 * idx], goal_[2 * idx + 1]};
     
-    if (!isSafe_(mu_a, sigma_a, goal_a, half_plane_map_.at(idx), nullptr))
-        return false;
-    return true;
+    return isSafe_(mu_a, sigma_a, goal_a, half_planes_[idx], nullptr);
 }
 
-bool CentralizedCCGoal::isSafe_(const Eigen::Vector2d mu, const Eigen::Matrix2d sigma, const Eigen::Vector2d goal, std::pair<Eigen::MatrixXd, Eigen::MatrixXd> hp, double *distance) const
+bool CentralizedCCGoal::isSafe_(const Eigen::Vector2d &mu, const Eigen::Matrix2d &sigma, const Eigen::Vector2d &goal,
+    const std::pair<Eigen::MatrixXd, Eigen::MatrixXd> &hp, double *distance) const
 {
-    Eigen::MatrixXd A = hp.first;
-    Eigen::MatrixXd B = hp.second;
+    const Eigen::MatrixXd &A = hp.first;
+    const Eigen::MatrixXd &B = hp.second;
 
     /* Update Distance to goal */
     if (distance) {
@@ -291,14 +248,14 @@ bool CentralizedCCGoal::isSafe_(const Eigen::Vector2d mu, const Eigen::Matrix2d
         *distance += (dx*dx + dy*dy);
     }
 
+    /* the belief is out of the goal if it is confidently outside one of its edges */
     auto const n_rows = A.rows();
     for (int i = 0; i < n_rows; i++) {
-        const double tmp = (A.row(i) * sigma * A.row(i).transpose()).value();
-        const double Pv = sqrt(tmp);
-        const double vbar = sqrt(2) * Pv * bm::erf_inv(1 - (2 * p_safe_));
-        if( (A(i, 0) * mu[0] + A(i, 1) * mu[1] - B(i, 0) >= vbar) ) {
+        const double a0 = A(i, 0), a1 = A(i, 1);
+        const double quad = (a0 * sigma(0, 0) + a1 * sigma(1, 0)) * a0 + (a0 * sigma(0, 1) + a1 * sigma(1, 1)) * a1;
+        const double vbar = std::sqrt(2 * quad) * erf_inv_;
+        if (a0 * mu[0] + a1 * mu[1] - B(i, 0) >= vbar)
             return false;
-        };
     }
     return true;
 }
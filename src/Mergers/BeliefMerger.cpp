@@ -1,10 +1,129 @@
 #include "Mergers/BeliefMerger.h"
+#include "utils/MultiRobotProblemDefinition.h"
+#include "Spaces/BlockDiagonalBeliefSpace.h"
+#include "StatePropogators/CentralizedUncertainLinearSP.h"
+#include "StateValidityCheckers/CentralizedChiSquaredBoundarySVC.h"
+#include "Goals/BeliefSpaceGoals.h"
+#include "OptimizationObjectives/StateCostObjectives.h"
+#include "Planners/CentralizedBSST.h"
+#include <ompl/control/spaces/RealVectorControlSpace.h>
 
 BeliefMerger::BeliefMerger(MultiRobotProblemDefinitionPtr mrmp_pdef):
 	Merger(mrmp_pdef, "BeliefMerger"){}
 
-void BeliefMerger::mergeRobots(const int idx1, const int idx2)
+MotionPlanningProblemPtr BeliefMerger::mergeRobots(const std::vector<int> &idxs)
 {
-	OMPL_ERROR("%s: Unable to merge.", name_.c_str());
-	exit(1);
-}
\ No newline at end of file
+	const InstancePtr mrmp_instance = mrmp_pdef_->getInstance();
+	const int n = idxs.size();
+	if (n < 2)
+		return nullptr;
+	std::vector<Robot*> robots;
+	std::string names;
+	for (const int idx: idxs) {
+		Robot* r = mrmp_instance->getRobots()[idx];
+		if (r->getDynamicsModel() != "2D-Uncertain-Linear-Model") {
+			OMPL_ERROR("%s: Unable to merge a %s (robot %d) into a meta-agent.", name_.c_str(), r->getDynamicsModel().c_str(), idx);
+			return nullptr;
+		}
+		robots.push_back(r);
+		names += (names.empty() ? "" : ", ") + std::to_string(idx);
+	}
+	const double goalTollorance = 2.0;
+	const oc::SpaceInformationPtr si1 = mrmp_pdef_->getRobotSpaceInformationPtr(idxs.front());
+
+	// set-up 2n-D Belief Space
+	ob::StateSpacePtr space = ob::StateSpacePtr(new BlockDiagonalBeliefSpace(n));
+	ob::RealVectorBounds bounds(2 * n);
+	for (int d = 0; d < 2 * n; d += 2) {
+		bounds.setLow(d, -1);
+		bounds.setHigh(d, mrmp_instance->getDimensions()[0]);
+		bounds.setLow(d + 1, -1);
+		bounds.setHigh(d + 1, mrmp_instance->getDimensions()[1]);
+	}
+	space->as<RealVectorBeliefSpace>()->setBounds(bounds);
+
+	// set-up the real vector control space
+	auto cspace(std::make_shared<oc::RealVectorControlSpace>(space, 2 * n));
+	ob::RealVectorBounds c_bounds(2 * n);
+	c_bounds.setLow(-1.0);
+	c_bounds.setHigh(1.0);
+	cspace->setBounds(c_bounds);
+
+	// construct an instance of space information from this state/control space
+	auto si(std::make_shared<oc::SpaceInformation>(space, cspace));
+
+	// keep the discretization of the robots, so that the split trajectories can be validated against the others
+	si->setPropagationStepSize(si1->getPropagationStepSize());
+	si->setMinMaxControlDuration(si1->getMinControlDuration(), si1->getMaxControlDuration());
+
+	si->setStatePropagator(oc::StatePropagatorPtr(new CentralizedUncertainLinearStatePropagator(si)));
+	si->setStateValidityChecker(std::make_shared<CentralizedChiSquaredBoundarySVC>(si, mrmp_instance,
+		robots, mrmp_instance->getPsafe()));
+
+	si->setup();
+
+	// create start state from the start beliefs of the robots
+	ob::State *start = si->allocState();
+	ob::State *goal_st = si->allocState();
+	for (int k = 0; k < n; k++) {
+		const ob::State *r_start = mrmp_pdef_->getRobotProblemDefinitionPtr(idxs[k])->getStartState(0);
+		start->as<RealVectorBeliefSpace::StateType>()->values[2 * k] = r_start->as<RealVectorBeliefSpace::StateType>()->values[0];
+		start->as<RealVectorBeliefSpace::StateType>()->values[2 * k + 1] = r_start->as<RealVectorBeliefSpace::StateType>()->values[1];
+		start->as<RealVectorBeliefSpace::StateType>()->sigmaBlock(k) = r_start->as<RealVectorBeliefSpace::StateType>()->sigma_;
+		Robot* r = robots[k];
+		goal_st->as<RealVectorBeliefSpace::StateType>()->values[2 * k] = r->getGoalLocation().x_;
+		goal_st->as<RealVectorBeliefSpace::StateType>()->values[2 * k + 1] = r->getGoalLocation().y_;
+	}
+
+	// create goal object
+	ob::GoalPtr goal(new CentralizedCCGoal(si, goal_st, goalTollorance, 0.95));
+	si->freeState(goal_st);
+
+	// create ProblemDefinition
+	auto pdef(std::make_shared<ob::ProblemDefinition>(si));
+	pdef->addStartState(start);
+	si->freeState(start);
+	pdef->setGoal(goal);
+	pdef->setOptimizationObjective(getEuclideanPathLengthObjective(si));
+
+	// create (and provide) the motion planner object
+	PlannerPtr planner(std::make_shared<oc::CentralizedBSST>(si, n));
+	planner->as<oc::CentralizedBSST>()->setProblemDefinition(pdef);
+	planner->as<oc::CentralizedBSST>()->setup();
+
+	OMPL_INFORM("%s: Composed robots %s into a single meta-agent.", name_.c_str(), names.c_str());
+	return std::make_shared<MotionPlanningProblem>(si, pdef, planner);
+}
+
+std::vector<oc::PathControl> BeliefMerger::splitPath(const oc::PathControl &composed, const std::vector<int> &idxs)
+{
+	std::vector<oc::PathControl> paths;
+	for (int k = 0; k < idxs.size(); k++) {
+		const oc::SpaceInformationPtr si = mrmp_pdef_->getRobotSpaceInformationPtr(idxs[k]);
+		oc::PathControl path(si);
+		ob::State *st = si->allocState();
+		oc::Control *ctrl = si->allocControl();
+		for (std::size_t i = 0; i < composed.getStateCount(); i++) {
+			/* the belief of robot k is the k-th 2D block of the composed belief */
+			const auto *c_st = composed.getState(i)->as<RealVectorBeliefSpace::StateType>();
+			auto *r_st = st->as<RealVectorBeliefSpace::StateType>();
+			r_st->values[0] = c_st->values[2 * k];
+			r_st->values[1] = c_st->values[2 * k + 1];
+			r_st->sigma_ = c_st->sigmaBlock(k);
+			r_st->lambda_ = c_st->lambdaBlock(k);
+			if (i < composed.getControlCount()) {
+				const double *c_u = composed.getControl(i)->as<oc::RealVectorControlSpace::ControlType>()->values;
+				double *r_u = ctrl->as<oc::RealVectorControlSpace::ControlType>()->values;
+				r_u[0] = c_u[2 * k];
+				r_u[1] = c_u[2 * k + 1];
+				path.append(st, ctrl, composed.getControlDuration(i));
+			}
+			else
+				path.append(st);
+		}
+		si->freeState(st);
+		si->freeControl(ctrl);
+		paths.push_back(path);
+	}
+	return paths;
+}
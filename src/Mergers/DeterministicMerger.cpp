@@ -1,10 +1,19 @@
 #include "Mergers/DeterministicMerger.h"
+#include "utils/MultiRobotProblemDefinition.h"
 
 DeterministicMerger::DeterministicMerger(MultiRobotProblemDefinitionPtr mrmp_pdef):
 	Merger(mrmp_pdef, "DeterministicMerger"){}
 
-void DeterministicMerger::mergeRobots(const int idx1, const int idx2)
+MotionPlanningProblemPtr DeterministicMerger::mergeRobots(const std::vector<int> &idxs)
 {
-	OMPL_ERROR("%s: Unable to merge.", name_.c_str());
-	exit(1);
+	/* the deterministic (RRT) low-level set-up has no composed MultiRobotRRT problem yet */
+	OMPL_ERROR("%s: Unable to merge %zu robots. Composed deterministic systems are not yet implemented.", 
+		name_.c_str(), idxs.size());
+	return nullptr;
+}
+
+std::vector<oc::PathControl> DeterministicMerger::splitPath(const oc::PathControl &composed, const std::vector<int> &idxs)
+{
+	OMPL_ERROR("%s: Unable to split a composed trajectory.", name_.c_str());
+	return {};
 }
@@ -1,109 +1,46 @@
 #include "PlanValidityCheckers/AdaptiveRiskBoundingBoxPVC.h"
+#include "utils/DiskGeometry.h"
+#include "utils/Trace.h"
+#include <limits>
 
 
 AdaptiveRiskBoundingBoxPVC::AdaptiveRiskBoundingBoxPVC(MultiRobotProblemDefinitionPtr pdef, const double p_safe):
     BeliefPVC(pdef, "AdaptiveRiskBoundingBoxPVC", p_safe)
 {
     std::vector<Robot*> robots = mrmp_pdef_->getInstance()->getRobots();
-    boost::tokenizer< boost::char_separator<char> >::iterator beg1;
-    boost::tokenizer< boost::char_separator<char> >::iterator beg2;
-    boost::char_separator<char> sep(" ");
-    for (auto itr1 = robots.begin(); itr1 != robots.end(); itr1++) {
-        std::string r1_name = (*itr1)->getName();
-        double max_rad_1 = (*itr1)->getBoundingRadius();
-        boost::tokenizer< boost::char_separator<char> > tok1(r1_name, sep);
-        beg1 = tok1.begin();
-        beg1++;
-        for (auto itr2 = itr1 + 1; itr2 != robots.end(); itr2++) {
-            std::string r2_name = (*itr2)->getName();
-            double max_rad_2 = (*itr2)->getBoundingRadius();
-            boost::tokenizer< boost::char_separator<char> > tok2(r2_name, sep);
-            beg2 = tok2.begin();
-            beg2++;
-            std::string key_name = (*beg1) + "," + (*beg2);
-            Polygon combined_poly = getBoundingBox_(max_rad_1, max_rad_2);
-            std::pair<Eigen::MatrixXd, Eigen::MatrixXd> robot_pair_halfplanes = getHalfPlanes_(combined_poly);
-            halfPlane_map_.insert({key_name, robot_pair_halfplanes});
+    pair_half_planes_ = PairTable<QuadHalfPlanes>(robots.size());
+    for (std::size_t i1 = 0; i1 < robots.size(); i1++) {
+        for (std::size_t i2 = i1 + 1; i2 < robots.size(); i2++) {
+            const std::pair<Eigen::MatrixXd, Eigen::MatrixXd> robot_pair_halfplanes = getHalfPlanes_(getBoundingBox_(robots[i1]->getBoundingRadius(), robots[i2]->getBoundingRadius()));
+            pair_half_planes_(robots[i1]->getId(), robots[i2]->getId()) = QuadHalfPlanes(robot_pair_halfplanes.first, robot_pair_halfplanes.second);
         }
     }
 }
 
-std::vector<ConflictPtr> AdaptiveRiskBoundingBoxPVC::validatePlan(Plan p)
-{
-    std::vector<ConflictPtr> confs{};
-    const double step_duration = mrmp_pdef_->getSystemStepSize();
-
-    // interpolate all trajectories to the same discretization and get max size
-    int maxStates = 0;
-    for (auto itr = p.begin(); itr != p.end(); itr++) {
-        itr->interpolate();
-        if (maxStates < itr->getStateCount())
-            maxStates = itr->getStateCount(); 
-    }
-
-    for (int k = 0; k < maxStates; k++) {
-        std::map<std::string, Belief> activeRobots = getActiveRobots_(p, k);
-        ConflictPtr c = checkForConflicts_(activeRobots, k);
-        if (c) {
-            // found initial conflict at step k
-            // must continue to propogate forward until conflict is finished
-            int step = k;
-            while (c != nullptr && step < maxStates) {
-                confs.push_back(c);
-                step++;
-                activeRobots = getActiveRobots_(p, step, c->agent1Idx_, c->agent2Idx_);
-                c = checkForConflicts_(activeRobots, step);
-            }
-            return confs;
-        }
-    }
-    return {};
-}
-
-bool AdaptiveRiskBoundingBoxPVC::satisfiesConstraints(oc::PathControl path, std::vector<ConstraintPtr> constraints)
+bool AdaptiveRiskBoundingBoxPVC::satisfiesConstraints(const std::vector<ob::State*> &states, const unsigned int first_step, 
+    const ConstraintIndex &index)
 {
+    KCBS_TRACE_SCOPE("AdaptiveRiskBoundingBoxPVC::satisfiesConstraints");
     /* Assume that the constrained robot is the "planning" robot. Check for satisfaction of all constraints */
-    const int constrained_robot = constraints.front()->getConstrainedAgent();
-    const std::string r_a_name = mrmp_pdef_->getInstance()->getRobots()[constrained_robot]->getName();
-    std::vector<ob::State*> states = path.getStates();
-    const double step_size = path.getControlDuration(0);
-    double current_time = 0.0;
-    for (auto itr = states.begin(); itr != states.end(); itr++) {
-        // for every state along path, check if the time coincides with any constraints
-        for (auto c_itr = constraints.begin(); c_itr != constraints.end(); c_itr++) {
-            const std::vector<double> times = (*c_itr)->getTimes();
-            auto it = std::find_if(times.begin(), times.end(), 
-                [&current_time](const double& t) { return abs(t - current_time) < 1E-9;});
-            if (it == times.end()) {
-                continue;
-            }
+    for (std::size_t i = 0; i < states.size(); i++) {
+        // for every state along path, check the constraints at its step
+        const std::vector<ConstraintIndex::Entry> *entries = index.at(first_step + i);
+        if (!entries)
+            continue;
+        const BeliefConstraint::Record constrained_robot_belief = BeliefConstraint::Record::fromState(states[i], first_step + i);
+        for (const ConstraintIndex::Entry &e: *entries) {
             // must check this constraint at this time
-            const int constraining_robot = (*c_itr)->getConstrainingAgent();
-            assert(constrained_robot != constraining_robot);
-            
-            // get the correct half-plane for comparing constrained_robot with constraining_robot
-            std::string key_name = std::to_string(constrained_robot) + "," + std::to_string(constraining_robot);
-            if (halfPlane_map_.find(key_name) == halfPlane_map_.end())
-                key_name = std::to_string(constraining_robot) + "," + std::to_string(constrained_robot);
-
-            // get both beliefs
-            const std::string r_b_name = mrmp_pdef_->getInstance()->getRobots()[constraining_robot]->getName();
-            int idx = it - times.begin();
-            Belief constrained_robot_belief = getDistribution_(*itr);
-            Belief constraining_robot_belief = getDistribution_((*c_itr)->as<BeliefConstraint>()->getStates()[idx]);
-            std::map<std::string, Belief> states_map{{r_a_name, constrained_robot_belief}, {r_b_name, constraining_robot_belief}};
-
-            // calculate the the eta_i's for agent *itr_a
-            std::unordered_map<std::string, double> eta_map = createEtaMap_(r_a_name, states_map);
-
-            // check if constraint is violated
-            Eigen::Vector2d mu_ab = constrained_robot_belief.first - constraining_robot_belief.first;
-            Eigen::Matrix2d Sigma_ab = constrained_robot_belief.second + constraining_robot_belief.second;
-
-            if (!isSafe_(mu_ab, Sigma_ab, halfPlane_map_[key_name], eta_map[r_b_name]))
+            assert(e.geometry_ && e.constraint_->getConstrainingAgent() != index.constrained_agent_);
+
+            const BeliefConstraint::Record &constraining_robot_belief = e.constraint_->as<BeliefConstraint>()->getRecord(e.time_idx_);
+
+            // check if constraint is violated. The constraining robot is the only other one, so all of the risk goes to it
+            const Eigen::Vector2d mu_ab = constrained_robot_belief.mean() - constraining_robot_belief.mean();
+            const Eigen::Matrix2d Sigma_ab = constrained_robot_belief.covariance() + constraining_robot_belief.covariance();
+
+            if (!isSafe_(mu_ab, Sigma_ab, *static_cast<const QuadHalfPlanes *>(e.geometry_), p_coll_agnts_))
                 return false;
         }
-        current_time += step_size;
     }
     return true;
 }
@@ -111,100 +48,68 @@ bool AdaptiveRiskBoundingBoxPVC::satisfiesConstraints(oc::PathControl path, std:
 bool AdaptiveRiskBoundingBoxPVC::independentCheck(ob::State* state1, ob::State* state2)
 {
     /* Only to be used for independent collision testing. Not called during MRMP planning (yet?) */
-
-    std::string key_name = "0,1";
-    if (halfPlane_map_.find(key_name) == halfPlane_map_.end())
-        key_name = "1,0";
-
     Belief r0_belief = getDistribution_(state1);
     Belief r1_belief = getDistribution_(state2);
 
-    // calculate the the eta_i's for agent *itr_a
-    std::map<std::string, Belief> states_map{{"Robot 0", r0_belief}, {"Robot 1", r1_belief}};
-    std::unordered_map<std::string, double> eta_map = createEtaMap_("Robot 0", states_map);
-
+    // with two robots, all of the risk goes to the other one
     Eigen::Vector2d mu_ab = r0_belief.first - r1_belief.first;
     Eigen::Matrix2d Sigma_ab = r0_belief.second + r1_belief.second;
 
-    if (isSafe_(mu_ab, Sigma_ab, halfPlane_map_[key_name], eta_map["Robot 1"]))
+    if (isSafe_(mu_ab, Sigma_ab, pairHalfPlanes_(0, 1), p_coll_agnts_))
         return true;
     return false;
 }
 
-ConflictPtr AdaptiveRiskBoundingBoxPVC::checkForConflicts_(std::map<std::string, Belief> states_map, const int step)
+ConflictPtr AdaptiveRiskBoundingBoxPVC::checkForConflicts_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int step,
+    SweepAndPrune &broadphase)
 {
-    ConflictPtr c = nullptr;
-    
-    boost::tokenizer< boost::char_separator<char> >::iterator beg_a;
-    boost::tokenizer< boost::char_separator<char> >::iterator beg_b;
-    boost::char_separator<char> sep(" ");
-
-    for (auto itr_a = states_map.begin(); itr_a != states_map.end(); itr_a++) {
-        // Belief for ai
-        const std::string r_a_name = itr_a->first;
-        boost::tokenizer< boost::char_separator<char> > tok_a(r_a_name, sep);
-        beg_a = tok_a.begin();
-        beg_a++;
-        const Eigen::Vector2d mu_a = (itr_a->second).first;
-        const Eigen::Matrix2d Sigma_a = (itr_a->second).second;
-        // calculate the the eta_i's for agent *itr_a
-        std::unordered_map<std::string, double> eta_map = createEtaMap_(r_a_name, states_map);
-        // set for itr_b
-        auto itr_b = itr_a;
-        std::advance(itr_b, 1);
-        for (; itr_b != states_map.end(); itr_b++) {
-            // Belief for aj
-            const std::string r_b_name = itr_b->first;
-            boost::tokenizer< boost::char_separator<char> > tok_b(r_b_name, sep);
-            beg_b = tok_b.begin();
-            beg_b++;
-            std::string key_name = (*beg_a) + "," + (*beg_b);
-            const Eigen::Vector2d mu_b = (itr_b->second).first;
-            const Eigen::Matrix2d Sigma_b = (itr_b->second).second;
-            const Eigen::Vector2d mu_ab = mu_a - mu_b;
-            const Eigen::Matrix2d Sigma_ab = Sigma_a + Sigma_b;
-
-            if (halfPlane_map_.find(key_name) == halfPlane_map_.end())
-                key_name = (*beg_b) + "," + (*beg_a);
-
-            if (!isSafe_(mu_ab, Sigma_ab, halfPlane_map_[key_name], eta_map[r_b_name])) {
-                int a_idx = std::atoi((*beg_a).c_str());
-                int b_idx = std::atoi((*beg_b).c_str());
-                c = std::make_shared<Conflict>(a_idx, b_idx, step);
-                return c;
-            }
+    const std::size_t n = agents.size();
+    /* eta_i = (alpha / d_i) * p_coll with alpha = 1 / sum_j (1 / d_j), over the distances from a to the other means */
+    std::vector<double> sums(n, 0);
+    double max_sum = 0;
+    double min_x = std::numeric_limits<double>::infinity(), max_x = -min_x, min_y = min_x, max_y = -min_x;
+    for (std::size_t i = 0; i < n; i++) {
+        const double x_a = beliefs.x(agents[i], step);
+        const double y_a = beliefs.y(agents[i], step);
+        for (std::size_t j = 0; j < n; j++) {
+            if (j == i)
+                continue;
+            const double mu_diff_x = x_a - beliefs.x(agents[j], step);
+            const double mu_diff_y = y_a - beliefs.y(agents[j], step);
+            sums[i] += (1 / std::sqrt(mu_diff_x * mu_diff_x + mu_diff_y * mu_diff_y));
         }
+        max_sum = std::max(max_sum, sums[i]);
+        min_x = std::min(min_x, x_a);
+        max_x = std::max(max_x, x_a);
+        min_y = std::min(min_y, y_a);
+        max_y = std::max(max_y, y_a);
     }
-    return c;
-}
-
-std::unordered_map<std::string, double> AdaptiveRiskBoundingBoxPVC::createEtaMap_(const std::string r_a_name, std::map<std::string, Belief> states_map)
-{
-    /* Find d_i's from r_a_name mean to all other robot means and sum the d_i's */
-    const Belief r_a_belief = states_map[r_a_name];
-    std::unordered_map<std::string, double> di_map;
-    double sum = 0;
-    for (auto itr_b = states_map.begin(); itr_b != states_map.end(); itr_b++) {
-        if (itr_b->first == r_a_name)
-            continue;
-        
-        const Belief r_b_belief = itr_b->second;
-        const double mu_diff_x = r_a_belief.first(0, 0) - r_b_belief.first(0, 0);
-        const double mu_diff_y = r_a_belief.first(1, 0) - r_b_belief.first(1, 0);
-        const double di =  sqrt( mu_diff_x*mu_diff_x + mu_diff_y*mu_diff_y );
-        di_map[itr_b->first] = di;
-        sum += (1 / di);
+    /* d_i is at most the diagonal of the box of the means, so every eta_i is at least eta_min, whose quantile bounds
+       the margins of the boxes of the broadphase */
+    const double diagonal = std::sqrt((max_x - min_x) * (max_x - min_x) + (max_y - min_y) * (max_y - min_y));
+    const double scale = chanceScale_(p_coll_agnts_ / (diagonal * max_sum));
+    std::vector<double> half_widths(n);
+    for (std::size_t i = 0; i < n; i++) {
+        const double max_lambda = maxEigenvalue2x2(beliefs.covariance(agents[i], step));
+        half_widths[i] = bounding_radii_[agents[i]] + scale * std::sqrt(std::max(max_lambda, 0.0));
     }
 
-    const double alpha = 1 / sum;
-
-    /* Calculate all the eta_i and return */
-    std::unordered_map<std::string, double> eta_map;
-    for (auto di_itr = di_map.begin(); di_itr != di_map.end(); di_itr++) {
-        const double eta_i = (alpha / di_itr->second) * p_coll_agnts_;
-        eta_map[di_itr->first] = eta_i; 
+    for (const std::pair<int, int> &ij: overlappingPairs_(broadphase, beliefs, agents, step, half_widths)) {
+        const int a = agents[ij.first];
+        const int b = agents[ij.second];
+        const Eigen::Vector2d mu_ab = beliefs.mean(a, step) - beliefs.mean(b, step);
+        const Eigen::Matrix2d Sigma_ab = beliefs.covariance(a, step) + beliefs.covariance(b, step);
+        const double d_ab = std::sqrt(mu_ab[0] * mu_ab[0] + mu_ab[1] * mu_ab[1]);
+        const double eta_i = p_coll_agnts_ / (d_ab * sums[ij.first]);
+        if (!isSafe_(mu_ab, Sigma_ab, pairHalfPlanes_(a, b), eta_i))
+            return std::make_shared<Conflict>(a, b, step);
     }
-    return eta_map;
+    return nullptr;
+}
+
+const QuadHalfPlanes &AdaptiveRiskBoundingBoxPVC::pairHalfPlanes_(const int a, const int b) const
+{
+    return pair_half_planes_(a, b);
 }
 
 std::pair<Eigen::MatrixXd, Eigen::MatrixXd> AdaptiveRiskBoundingBoxPVC::getHalfPlanes_(Polygon combined_poly)
@@ -235,21 +140,10 @@ std::pair<Eigen::MatrixXd, Eigen::MatrixXd> AdaptiveRiskBoundingBoxPVC::getHalfP
     return std::make_pair(A,B);
 }
 
-bool AdaptiveRiskBoundingBoxPVC::isSafe_(const Eigen::Vector2d mu_ab, const Eigen::Matrix2d Sigma_ab, const std::pair<Eigen::MatrixXd, Eigen::MatrixXd> halfPlanes, const double eta_i)
+bool AdaptiveRiskBoundingBoxPVC::isSafe_(const Eigen::Vector2d &mu_ab, const Eigen::Matrix2d &Sigma_ab, const QuadHalfPlanes &halfPlanes, const double eta_i) const
 {
-    Eigen::MatrixXd A = halfPlanes.first;
-    Eigen::MatrixXd B = halfPlanes.second;
-
-    auto const n_rows = A.rows();
-    for (int i = 0; i < n_rows; i++) {
-        const double tmp = (A.row(i) * Sigma_ab * A.row(i).transpose()).value();
-        const double Pv = sqrt(tmp);
-        const double vbar = sqrt(2) * Pv * bm::erf_inv(1 - (2 * eta_i));
-        if( (A(i, 0) * mu_ab[0] + A(i, 1) * mu_ab[1] - B(i, 0) >= vbar) ) {
-            return true;
-        };
-    }
-    return false;
+    /* the quantile is shared by the half-planes of the pair */
+    return halfPlanes.isSafe(mu_ab[0], mu_ab[1], Sigma_ab, RiskQuantileTable::erfInv(eta_i));
 }
 
 // Polygon AdaptiveRiskBoundingBoxPVC::getMinkowskiSumOfRobots_(Robot* r1, Robot* r2)
@@ -1,113 +1,530 @@
 #include "PlanValidityCheckers/BeliefPVC.h"
+#include "utils/DiskGeometry.h"
+#include "utils/ErfInv.h"
+#include "utils/TaskRuntime.h"
+#include "utils/Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
 
 
 BeliefPVC::BeliefPVC(MultiRobotProblemDefinitionPtr pdef, const std::string name, const double p_safe_agnts):
     PlanValidityChecker(pdef, name), p_safe_agnts_(p_safe_agnts), p_coll_agnts_(-1)
 {
     p_coll_agnts_ = 1 - p_safe_agnts;
+    for (Robot* r: mrmp_pdef_->getInstance()->getRobots())
+        bounding_radii_.push_back(r->getBoundingRadius());
 }
 
-ConstraintPtr BeliefPVC::createConstraint(Plan p, std::vector<ConflictPtr> conflicts, const int constrained_robot)
+ConstraintPtr BeliefPVC::createConstraint(const DiscretePlan &p, const std::vector<ConflictPtr> &conflicts, const int constrained_robot)
 {
-    // interpolate all trajectories to the same discretization and get max size
-    for (auto itr = p.begin(); itr != p.end(); itr++) {
-        itr->interpolate();
-    }
+    int constraining_robot = (constrained_robot == conflicts.front()->agent1Idx_) ? conflicts.front()->agent2Idx_ : conflicts.front()->agent1Idx_;
+    return createConstraint_(p, conflicts, constrained_robot, constraining_robot, false);
+}
 
+ConstraintPtr BeliefPVC::createRegionConstraint(const DiscretePlan &p, const std::vector<ConflictPtr> &conflicts, const int robot,
+    const bool positive)
+{
+    return createConstraint_(p, conflicts, robot, robot, positive);
+}
+
+ConstraintPtr BeliefPVC::createConstraint_(const DiscretePlan &p, const std::vector<ConflictPtr> &conflicts, const int constrained_robot,
+    const int region_robot, const bool positive)
+{
     int constraining_robot = (constrained_robot == conflicts.front()->agent1Idx_) ? conflicts.front()->agent2Idx_ : conflicts.front()->agent1Idx_;
     assert(constrained_robot != constraining_robot);
     const double step_duration = mrmp_pdef_->getSystemStepSize();
+    const oc::PathControl &traj = p[region_robot];
     std::vector<double> times;
-    std::vector<ob::State*> states;
-    for (auto itr = conflicts.begin(); itr != conflicts.end(); itr++) {
-        times.push_back(((*itr)->timeStep_ * step_duration));
-        if ( (*itr)->timeStep_ <  p[constraining_robot].getStates().size()) {
-            ob::State* st = mrmp_pdef_->getRobotSpaceInformationPtr(constraining_robot)->allocState();
-            mrmp_pdef_->getRobotSpaceInformationPtr(constraining_robot)->copyState(st, p[constraining_robot].getState((*itr)->timeStep_));
-            states.push_back(st);
-            // mrmp_pdef_->getRobotSpaceInformationPtr(constraining_robot)->printState(st);
+    std::vector<BeliefConstraint::Record> records;
+    times.reserve(conflicts.size());
+    records.reserve(conflicts.size());
+    for (const ConflictPtr &conf: conflicts) {
+        times.push_back(conf->timeStep_ * step_duration);
+        // the conflicts of validatePlan carry the beliefs they were found with
+        if (const auto *belief = dynamic_cast<const BeliefConflict *>(conf.get())) {
+            records.push_back(belief->getRecord(region_robot));
+            continue;
+        }
+        // once its trajectory ended, the constraining robot stays at its last belief
+        const ob::State *st = (static_cast<std::size_t>(conf->timeStep_) < traj.getStateCount()) ? traj.getState(conf->timeStep_) : traj.getStates().back();
+        records.push_back(BeliefConstraint::Record::fromState(st, conf->timeStep_));
+    }
+    ConstraintPtr c = std::make_shared<BeliefConstraint>(constrained_robot, constraining_robot, std::move(times), std::move(records), positive);
+    return c;
+}
+
+bool BeliefPVC::nearConstraints(const std::vector<ob::State*> &states, const unsigned int first_step, const unsigned int last_step,
+    const ConstraintIndex &index) const
+{
+    if (!PlanValidityChecker::nearConstraints(states, first_step, last_step, index))
+        return false;
+    double min_x = std::numeric_limits<double>::infinity();
+    double max_x = -min_x, min_y = min_x, max_y = -min_x;
+    double max_lambda = 0;
+    for (const ob::State *st: states) {
+        double x, y, s_xx, s_xy, s_yy;
+        if (!BeliefTrajectories::extract(st, x, y, s_xx, s_xy, s_yy) || !std::isfinite(x + y + s_xx + s_xy + s_yy))
+            return true;
+        min_x = std::min(min_x, x);
+        max_x = std::max(max_x, x);
+        min_y = std::min(min_y, y);
+        max_y = std::max(max_y, y);
+        max_lambda = std::max(max_lambda, maxEigenvalue2x2((Eigen::Matrix2d() << s_xx, s_xy, s_xy, s_yy).finished()));
+    }
+    const double half_width = safeHalfWidth_(index.constrained_agent_, max_lambda, std::sqrt(max_lambda));
+    if (!std::isfinite(half_width))
+        return true;
+    // near as soon as a window is not disjoint from the box of the states (NaN boxes or margins never are)
+    return !index.forEachWindow(first_step, last_step, [&](const ConstraintIndex::Window &w) {
+        // padded for the rounding of the exact checks
+        const double m = (half_width + w.margin_) * (1 + 1e-9) + 1e-12;
+        return w.min_x_ - max_x > m || min_x - w.max_x_ > m || w.min_y_ - max_y > m || min_y - w.max_y_ > m;
+    });
+}
 
+void BeliefPVC::boundConstraint_(const Constraint &c, ConstraintIndex::Window &w) const
+{
+    PlanValidityChecker::boundConstraint_(c, w);
+    const std::vector<BeliefConstraint::Record> &records = c.as<BeliefConstraint>()->getRecords();
+    if (records.empty())
+        return;
+    w.min_x_ = w.min_y_ = std::numeric_limits<double>::infinity();
+    w.max_x_ = w.max_y_ = -std::numeric_limits<double>::infinity();
+    double max_lambda = 0;
+    for (const BeliefConstraint::Record &r: records) {
+        if (!std::isfinite(r.x_ + r.y_ + r.s_xx_ + r.s_xy_ + r.s_yy_))
+            return;
+        w.min_x_ = std::min(w.min_x_, r.x_);
+        w.max_x_ = std::max(w.max_x_, r.x_);
+        w.min_y_ = std::min(w.min_y_, r.y_);
+        w.max_y_ = std::max(w.max_y_, r.y_);
+        max_lambda = std::max(max_lambda, maxEigenvalue2x2(r.covariance()));
+    }
+    w.margin_ = safeHalfWidth_(c.getConstrainingAgent(), max_lambda, std::sqrt(max_lambda));
+}
+
+std::vector<ConflictPtr> BeliefPVC::validatePlan(const DiscretePlan &p)
+{
+    KCBS_TRACE_SCOPE("BeliefPVC::validatePlan");
+    const int maxStates = windowSteps_(p);
+    const BeliefTrajectories beliefs(p, maxStates);
+    std::vector<int> agents(p.size());
+    std::iota(agents.begin(), agents.end(), 0);
+
+    /* midphase: the spans of steps in which the hierarchies of the trajectories of a pair do not prune it. Each step
+       only tests the pairs whose spans cover it */
+    std::vector<PairSpan> spans;
+    bool midphase = true;
+    for (std::size_t a = 0; a < p.size() && midphase; a++)
+        midphase = std::isfinite(safeHalfWidth_(a, 0, 0));
+    if (midphase) {
+        for (int a = 0; a < p.size(); a++) {
+            for (int b = a + 1; b < p.size(); b++) {
+                for (const std::pair<int, int> &span: nearSpans_(p, a, b, maxStates))
+                    spans.push_back({a, b, span.first, span.second});
+            }
         }
-        else {
-            ob::State* st = mrmp_pdef_->getRobotSpaceInformationPtr(constraining_robot)->allocState();
-            mrmp_pdef_->getRobotSpaceInformationPtr(constraining_robot)->copyState(st, p[constraining_robot].getStates().back());
-            states.push_back(st);
-            // mrmp_pdef_->getRobotSpaceInformationPtr(constraining_robot)->printState(st);
+        std::stable_sort(spans.begin(), spans.end(), [](const PairSpan &x, const PairSpan &y) {return x.first_ < y.first_;});
+    }
+    const std::vector<PairSpan> *pair_spans = midphase ? &spans : nullptr;
+
+    // the steps are split into chunks between the threads, each finds its earliest conflict
+    ConflictPtr c = nullptr;
+    if (batch_validation_ && batchable_() && continuous_substeps_ == 0)
+        c = firstConflictBatch_(beliefs, agents, maxStates);
+    else if (num_threads_ > 1 && maxStates >= 2 * min_chunk_steps_)
+        c = firstConflictParallel_(beliefs, agents, pair_spans, maxStates);
+    else
+        c = firstConflict_(beliefs, agents, pair_spans, 0, maxStates, nullptr);
+
+    std::vector<ConflictPtr> confs{};
+    if (c) {
+        // found initial conflict at step k
+        // must continue to propogate forward until conflict is finished
+        SweepAndPrune pair_broadphase;
+        const std::vector<int> pair{c->agent1Idx_, c->agent2Idx_};
+        int step = c->timeStep_;
+        while (c != nullptr && step < maxStates) {
+            confs.push_back(withBeliefs_(c, beliefs));
+            step++;
+            if (step < maxStates)
+                c = extendConflict_(beliefs, pair, step, pair_broadphase);
         }
     }
-    ConstraintPtr c = std::make_shared<BeliefConstraint>(constrained_robot, constraining_robot, times, states);
-    return c;
+    return confs;
 }
 
-std::map<std::string, Belief> BeliefPVC::getActiveRobots_(Plan p, const int step, const int a1, const int a2)
+ConflictPtr BeliefPVC::firstConflict_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const std::vector<PairSpan> *spans,
+    const int first_step, const int last_step, const std::atomic<int> *earliest)
 {
-    std::map<std::string, Belief> activeRobots;
+    std::vector<PairSpan> active;
+    std::vector<std::pair<int, int>> candidates;
+    std::size_t next_span = 0;
 
-    // using no pre-defined agent pair, return vector of all robots
-    if (a1 == -1 || a2 == -1) {
-        int idx = 0;
-        auto itr = p.begin();
-        for(; itr < p.end(); itr++, idx++ )
-        {
-            if (step < itr->getStateCount()){
-                Belief b = getDistribution_(itr->getState(step));
-                activeRobots.insert({mrmp_pdef_->getInstance()->getRobots()[idx]->getName(), b});
+    // agents are kept sorted by their boxes from one step to the next
+    SweepAndPrune broadphase;
+    if (spans)
+        broadphase.setCandidates(&candidates);
+    // the motions between steps are swept over every agent, as the spans only bound the steps
+    SweepAndPrune swept_broadphase;
+    broadphase.resize(agents.size());
+    swept_broadphase.resize(agents.size());
+    for (int k = first_step; k < last_step; k++) {
+        // another thread found an earlier conflict
+        if (earliest && earliest->load(std::memory_order_relaxed) < k)
+            return nullptr;
+        /* the agents past their last beliefs are static obstacles: a pair of them was tested at the step the later
+           one parked at (or an earlier chunk found a conflict before) */
+        for (std::size_t i = 0; i < agents.size(); i++) {
+            const bool parked = (k > beliefs.lastStep(agents[i]));
+            broadphase.setParked(i, parked);
+            swept_broadphase.setParked(i, parked);
+        }
+        if (spans) {
+            const std::size_t n_active = active.size();
+            active.erase(std::remove_if(active.begin(), active.end(), [k](const PairSpan &s) {return s.last_ < k;}), active.end());
+            bool changed = (active.size() != n_active);
+            for (; next_span < spans->size() && (*spans)[next_span].first_ <= k; next_span++) {
+                if ((*spans)[next_span].last_ < k)
+                    continue;
+                active.push_back((*spans)[next_span]);
+                changed = true;
             }
-            else{
-                Belief b = getDistribution_(itr->getStates().back());
-                activeRobots.insert({mrmp_pdef_->getInstance()->getRobots()[idx]->getName(), b});
+            if (changed) {
+                std::sort(active.begin(), active.end(), [](const PairSpan &x, const PairSpan &y) {
+                    return std::make_pair(x.a_, x.b_) < std::make_pair(y.a_, y.b_);
+                });
+                candidates.clear();
+                for (const PairSpan &s: active)
+                    candidates.emplace_back(s.a_, s.b_);
             }
         }
+        ConflictPtr c = (spans && candidates.empty()) ? nullptr : checkForConflicts_(beliefs, agents, k, broadphase);
+        if (!c && continuous_substeps_ > 0 && k + 1 < beliefs.steps())
+            c = sweptConflict_(beliefs, agents, k, swept_broadphase);
+        if (c)
+            return c;
     }
-    else {
-        // provided agent pair, return vector with only those two robots
-        if (step < p[a1].getStateCount()) {
-            Belief b = getDistribution_(p[a1].getState(step));
-            activeRobots.insert({mrmp_pdef_->getInstance()->getRobots()[a1]->getName(), b});
+    return nullptr;
+}
+
+ConflictPtr BeliefPVC::firstConflictParallel_(const BeliefTrajectories &beliefs, const std::vector<int> &agents,
+    const std::vector<PairSpan> *spans, const int max_states)
+{
+    KCBS_TRACE_SCOPE("BeliefPVC::firstConflictParallel");
+    /* a few chunks per thread balance the load, since the chunks past the earliest conflict are cancelled */
+    const int n_threads = std::min<int>(num_threads_, max_states / min_chunk_steps_);
+    const int chunk = std::max(min_chunk_steps_, (max_states + 4 * n_threads - 1) / (4 * n_threads));
+    const int n_chunks = (max_states + chunk - 1) / chunk;
+    std::vector<ConflictPtr> found(n_chunks, nullptr);
+    std::atomic<int> next_chunk{0};
+    std::atomic<int> earliest{std::numeric_limits<int>::max()};
+    auto worker = [&]() {
+        for (int i = next_chunk++; i < n_chunks; i = next_chunk++) {
+            // chunks are handed out in order, so every later one is past the earliest conflict too
+            if (earliest.load() < i * chunk)
+                return;
+            ConflictPtr c = firstConflict_(beliefs, agents, spans, i * chunk, std::min((i + 1) * chunk, max_states), &earliest);
+            if (!c)
+                continue;
+            found[i] = c;
+            // min-reduction of the earliest conflicting step
+            int e = earliest.load();
+            while (c->timeStep_ < e && !earliest.compare_exchange_weak(e, c->timeStep_)) {}
         }
-        else {
-            Belief b = getDistribution_(p[a1].getStates().back());
-            activeRobots.insert({mrmp_pdef_->getInstance()->getRobots()[a1]->getName(), b});
+    };
+    TaskGroup workers;
+    workers.runAndWait(n_threads, [&worker](const std::size_t) {worker();});
+
+    // the chunks before the earliest conflict have none
+    for (const ConflictPtr &c: found) {
+        if (c)
+            return c;
+    }
+    return nullptr;
+}
+
+ConflictPtr BeliefPVC::firstConflictBatch_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int max_states)
+{
+    KCBS_TRACE_SCOPE("BeliefPVC::firstConflictBatch");
+    // the pairs checkForConflicts_ would test at every step, in the order it tests them
+    PairBatch batch;
+    SweepAndPrune broadphase;
+    broadphase.resize(agents.size());
+    std::vector<double> half_widths(agents.size());
+    for (int k = 0; k < max_states; k++) {
+        for (std::size_t i = 0; i < agents.size(); i++) {
+            const double max_lambda = maxEigenvalue2x2(beliefs.covariance(agents[i], k));
+            half_widths[i] = safeHalfWidth_(agents[i], max_lambda, std::sqrt(std::max(max_lambda, 0.0)));
+            // (the pairs of parked agents were gathered at the step the later of them parked at)
+            broadphase.setParked(i, k > beliefs.lastStep(agents[i]));
+        }
+        for (const std::pair<int, int> &ij: overlappingPairs_(broadphase, beliefs, agents, k, half_widths)) {
+            const int a = agents[ij.first];
+            const int b = agents[ij.second];
+            batch.add(a, b, k, beliefs.x(a, k) - beliefs.x(b, k), beliefs.y(a, k) - beliefs.y(b, k),
+                beliefs.sigmaXX(a, k) + beliefs.sigmaXX(b, k), beliefs.sigmaXY(a, k) + beliefs.sigmaXY(b, k),
+                beliefs.sigmaYY(a, k) + beliefs.sigmaYY(b, k));
         }
-        if (step < p[a2].getStateCount()) {
-            Belief b = getDistribution_(p[a2].getState(step));
-            activeRobots.insert({mrmp_pdef_->getInstance()->getRobots()[a2]->getName(), b});
+    }
+    checkBatch_(batch);
+    for (std::size_t r = 0; r < batch.size(); r++) {
+        if (!batch.safe_[r])
+            return std::make_shared<Conflict>(batch.a_[r], batch.b_[r], batch.step_[r]);
+    }
+    return nullptr;
+}
+
+void BeliefPVC::checkBatch_(PairBatch &batch) const
+{
+    batch.safe_.assign(batch.size(), false);
+    const std::size_t n_chunks = (batch.size() + batch_chunk_ - 1) / batch_chunk_;
+    auto check = [this, &batch](const std::size_t c) {
+        const std::size_t last = std::min(batch.size(), (c + 1) * batch_chunk_);
+        for (std::size_t r = c * batch_chunk_; r < last; r++)
+            batch.safe_[r] = isRelativeSafe_(batch.a_[r], batch.b_[r], batch.mean(r), batch.covariance(r));
+    };
+    if (num_threads_ > 1 && n_chunks > 1) {
+        TaskGroup chunks;
+        chunks.runAndWait(n_chunks, check);
+    }
+    else {
+        for (std::size_t c = 0; c < n_chunks; c++)
+            check(c);
+    }
+}
+
+std::vector<ConflictPtr> BeliefPVC::validatePair_(const DiscretePlan &p, const int a1, const int a2, const int max_states)
+{
+    std::vector<std::vector<ConflictPtr>> intervals = pairIntervals_(p, a1, a2, max_states, false);
+    if (intervals.empty())
+        return {};
+    return intervals.front();
+}
+
+std::vector<std::vector<ConflictPtr>> BeliefPVC::validatePairAll_(const DiscretePlan &p, const int a1, const int a2, const int max_states)
+{
+    return pairIntervals_(p, a1, a2, max_states, true);
+}
+
+std::vector<std::vector<ConflictPtr>> BeliefPVC::pairIntervals_(const DiscretePlan &p, const int a1, const int a2, const int max_states,
+    const bool all)
+{
+    // the spans of steps in which the pair may conflict
+    std::vector<std::pair<int, int>> spans{{0, max_states - 1}};
+    if (std::isfinite(safeHalfWidth_(a1, 0, 0)) && std::isfinite(safeHalfWidth_(a2, 0, 0))) {
+        spans = nearSpans_(p, a1, a2, max_states);
+        if (spans.empty() && continuous_substeps_ == 0)
+            return {};
+    }
+
+    const std::vector<int> pair{a1, a2};
+    const BeliefTrajectories beliefs(p, max_states, pair);
+    SweepAndPrune broadphase;
+    std::vector<std::vector<ConflictPtr>> intervals;
+    const bool continuous = (continuous_substeps_ > 0);
+    // once both agents are parked, the steps repeat the one the later of them parked at
+    const int parked = std::max(beliefs.lastStep(a1), beliefs.lastStep(a2));
+    // first step that is not part of an interval yet, and the first span that may cover it
+    int next = 0;
+    std::size_t s = 0;
+    for (int k = 0; k < max_states && k <= parked; k++) {
+        while (s < spans.size() && spans[s].second < k)
+            s++;
+        const bool near = (s < spans.size() && spans[s].first <= k);
+        // the steps out of the spans are safe, but the motions between them are still swept
+        if (!near && !continuous) {
+            if (s == spans.size())
+                break;
+            k = spans[s].first - 1;
+            continue;
         }
-        else {
-            Belief b = getDistribution_(p[a2].getStates().back());
-            activeRobots.insert({mrmp_pdef_->getInstance()->getRobots()[a2]->getName(), b});
+        if (k < next)
+            continue;
+        ConflictPtr c = near ? checkForConflicts_(beliefs, pair, k, broadphase) : nullptr;
+        if (!c && continuous && k + 1 < max_states && !sweptPairSafe_(beliefs, a1, a2, k))
+            c = std::make_shared<Conflict>(a1, a2, k);
+        if (c) {
+            // found initial conflict at step k
+            // must continue to propogate forward until conflict is finished
+            std::vector<ConflictPtr> confs{};
+            int step = k;
+            while (c != nullptr && step < max_states) {
+                confs.push_back(withBeliefs_(c, beliefs));
+                step++;
+                if (step < max_states)
+                    c = extendConflict_(beliefs, pair, step, broadphase);
+            }
+            intervals.push_back(std::move(confs));
+            if (!all)
+                return intervals;
+            // the step that ended the interval is safe
+            next = step + 1;
+            k = step;
         }
     }
-    return activeRobots;
+    return intervals;
 }
 
-Belief BeliefPVC::getDistribution_(const ob::State* st)
+std::vector<std::pair<int, int>> BeliefPVC::nearSpans_(const DiscretePlan &p, const int a, const int b, const int max_states) const
 {
-    double* all_vals = st->as<RealVectorBeliefSpace::StateType>()->values;
-    Eigen::VectorXd mu(2);
-    mu[0] = all_vals[0];
-    mu[1] = all_vals[1];
-    Eigen::MatrixXd Sigma = st->as<RealVectorBeliefSpace::StateType>()->getCovariance();
-    if (static_cast<int>(Sigma.rows()) == 4)
-    {
-        Eigen::Matrix2d Sigma_xy;
-        Sigma_xy(0, 0) = Sigma(0, 0);
-        Sigma_xy(0, 1) = Sigma(0, 2);
-        Sigma_xy(1, 0) = Sigma(2, 0);
-        Sigma_xy(1, 1) = Sigma(2, 2);
-        Belief b(mu, Sigma_xy);
-        return b;
-    }
-    else if ((static_cast<int>(Sigma.rows()) == 2))
-    {
-        Belief b(mu, Sigma);
-        return b;
+    return TrajectoryBVH::overlappingSpans(
+        p.getBVH(a), [this, a](const TrajectoryBVH::Node &n) {return safeHalfWidth_(a, n.max_lambda_, n.max_sqrt_lambda_);},
+        p.getBVH(b), [this, b](const TrajectoryBVH::Node &n) {return safeHalfWidth_(b, n.max_lambda_, n.max_sqrt_lambda_);},
+        0, max_states - 1);
+}
+
+double BeliefPVC::safeHalfWidth_(const int agent, const double max_lambda, const double max_sqrt_lambda) const
+{
+    return std::numeric_limits<double>::infinity();
+}
+
+bool BeliefPVC::isPairSafe_(const int a, const Eigen::Vector2d &mu_a, const Eigen::Matrix2d &Sigma_a, const int b,
+    const Eigen::Vector2d &mu_b, const Eigen::Matrix2d &Sigma_b)
+{
+    return false;
+}
+
+const std::vector<std::pair<int, int>> &BeliefPVC::overlappingPairs_(SweepAndPrune &broadphase, const BeliefTrajectories &beliefs,
+    const std::vector<int> &agents, const int step, const std::vector<double> &half_widths) const
+{
+    broadphase.resize(agents.size());
+    for (std::size_t i = 0; i < agents.size(); i++) {
+        // padded for the rounding of the exact checks
+        const double w = half_widths[i] * (1 + 1e-9) + 1e-12;
+        const double x = beliefs.x(agents[i], step);
+        const double y = beliefs.y(agents[i], step);
+        broadphase.setBox(i, x - w, x + w, y - w, y + w);
     }
-    else
+    return broadphase.sweep();
+}
+
+void BeliefPVC::setContinuous(const unsigned int substeps)
+{
+    if (substeps > 0 && !pairwise_()) {
+        OMPL_WARN("%s: has no pair test, so it only validates the steps of a plan.", name_.c_str());
+        return;
+    }
+    // (the pieces are halves of halves, so finer than this would only be rounding)
+    continuous_substeps_ = std::min(substeps, 1u << 20);
+}
+
+namespace
+{
+    /* whether the segment from (x0, y0) to (x1, y1) touches the box [-w, w] x [-w, w], by separating axes: x, y and the
+       normal of the segment. NaNs touch it */
+    bool segment_touches_box(const double x0, const double y0, const double x1, const double y1, const double w)
     {
+        if (std::min(x0, x1) > w || std::max(x0, x1) < -w || std::min(y0, y1) > w || std::max(y0, y1) < -w)
+            return false;
+        const double nx = y1 - y0, ny = x0 - x1;
+        return !(std::abs(nx * x0 + ny * y0) > w * (std::abs(nx) + std::abs(ny)));
+    }
+}
+
+bool BeliefPVC::sweptPairSafe_(const BeliefTrajectories &beliefs, const int a, const int b, const int step)
+{
+    if (continuous_substeps_ == 0)
+        return true;
+    // the larger covariance of each agent over the interval, isotropic so that it bounds both of its ends
+    const double lambda_a = std::max(maxEigenvalue2x2(beliefs.covariance(a, step)), maxEigenvalue2x2(beliefs.covariance(a, step + 1)));
+    const double lambda_b = std::max(maxEigenvalue2x2(beliefs.covariance(b, step)), maxEigenvalue2x2(beliefs.covariance(b, step + 1)));
+    const double w_a = safeHalfWidth_(a, lambda_a, std::sqrt(std::max(lambda_a, 0.0)));
+    const double w_b = safeHalfWidth_(b, lambda_b, std::sqrt(std::max(lambda_b, 0.0)));
+    // padded for the rounding of the exact checks (an infinite width refines every interval)
+    const double w = (w_a + w_b) * (1 + 1e-9) + 1e-12;
+    const Eigen::Vector2d mu_a0 = beliefs.mean(a, step), mu_a1 = beliefs.mean(a, step + 1);
+    const Eigen::Vector2d mu_b0 = beliefs.mean(b, step), mu_b1 = beliefs.mean(b, step + 1);
+    const Eigen::Vector2d d0 = mu_a0 - mu_b0, d1 = mu_a1 - mu_b1;
+    const Eigen::Matrix2d Sigma_a = std::max(lambda_a, 0.0) * Eigen::Matrix2d::Identity();
+    const Eigen::Matrix2d Sigma_b = std::max(lambda_b, 0.0) * Eigen::Matrix2d::Identity();
+
+    // pieces [t0, t1] of the interval still to bound, halved where the bound fails
+    const double min_piece = 1.0 / continuous_substeps_;
+    std::pair<double, double> pieces[64];
+    int n = 0;
+    pieces[n++] = {0.0, 1.0};
+    while (n > 0) {
+        const std::pair<double, double> piece = pieces[--n];
+        const Eigen::Vector2d p0 = d0 + piece.first * (d1 - d0);
+        const Eigen::Vector2d p1 = d0 + piece.second * (d1 - d0);
+        if (!segment_touches_box(p0[0], p0[1], p1[0], p1[1], w))
+            continue;
+        const double t = 0.5 * (piece.first + piece.second);
+        if (piece.second - piece.first <= min_piece * (1 + 1e-9) || n + 2 > 64) {
+            if (!isPairSafe_(a, mu_a0 + t * (mu_a1 - mu_a0), Sigma_a, b, mu_b0 + t * (mu_b1 - mu_b0), Sigma_b))
+                return false;
+            continue;
+        }
+        pieces[n++] = {t, piece.second};
+        pieces[n++] = {piece.first, t};
+    }
+    return true;
+}
+
+ConflictPtr BeliefPVC::sweptConflict_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int step,
+    SweepAndPrune &broadphase)
+{
+    // the boxes of the segments of the means, inflated by the half-widths of the larger covariances
+    broadphase.resize(agents.size());
+    for (std::size_t i = 0; i < agents.size(); i++) {
+        const int a = agents[i];
+        const double lambda = std::max(maxEigenvalue2x2(beliefs.covariance(a, step)), maxEigenvalue2x2(beliefs.covariance(a, step + 1)));
+        const double w = safeHalfWidth_(a, lambda, std::sqrt(std::max(lambda, 0.0))) * (1 + 1e-9) + 1e-12;
+        const double x0 = beliefs.x(a, step), x1 = beliefs.x(a, step + 1);
+        const double y0 = beliefs.y(a, step), y1 = beliefs.y(a, step + 1);
+        broadphase.setBox(i, std::min(x0, x1) - w, std::max(x0, x1) + w, std::min(y0, y1) - w, std::max(y0, y1) + w);
+    }
+    for (const std::pair<int, int> &ij: broadphase.sweep()) {
+        const int a = agents[ij.first];
+        const int b = agents[ij.second];
+        if (!sweptPairSafe_(beliefs, a, b, step))
+            return std::make_shared<Conflict>(a, b, step);
+    }
+    return nullptr;
+}
+
+ConflictPtr BeliefPVC::extendConflict_(const BeliefTrajectories &beliefs, const std::vector<int> &pair, const int step,
+    SweepAndPrune &broadphase)
+{
+    // a pair of parked agents keeps the conflict of the previous step
+    if (step > std::max(beliefs.lastStep(pair[0]), beliefs.lastStep(pair[1])))
+        return std::make_shared<Conflict>(pair[0], pair[1], step);
+    ConflictPtr c = checkForConflicts_(beliefs, pair, step, broadphase);
+    if (!c && !sweptPairSafe_(beliefs, pair[0], pair[1], step - 1))
+        c = std::make_shared<Conflict>(pair[0], pair[1], step);
+    return c;
+}
+
+double BeliefPVC::chanceScale_(const double p_coll)
+{
+    if (!(p_coll > 0))
+        return std::numeric_limits<double>::infinity();
+    if (p_coll >= 0.5)
+        return 0;
+    return std::sqrt(2.0) * RiskQuantileTable::erfInv(p_coll);
+}
+
+ConflictPtr BeliefPVC::withBeliefs_(const ConflictPtr &c, const BeliefTrajectories &beliefs)
+{
+    auto record = [&](const int agent) {
+        const int k = c->timeStep_;
+        return BeliefConstraint::Record{k, beliefs.x(agent, k), beliefs.y(agent, k), beliefs.sigmaXX(agent, k),
+            beliefs.sigmaXY(agent, k), beliefs.sigmaYY(agent, k)};
+    };
+    return std::make_shared<BeliefConflict>(*c, record(c->agent1Idx_), record(c->agent2Idx_));
+}
+
+Belief BeliefPVC::getDistribution_(const ob::State* st)
+{
+    // read in place, without the copy of the whole covariance
+    double x, y, s_xx, s_xy, s_yy;
+    if (!BeliefTrajectories::extract(st, x, y, s_xx, s_xy, s_yy)) {
         OMPL_ERROR("Please specify the x and y elements of this type of space!");
-        Belief b(mu, Sigma); // dummy return -- probably causes errors in code
-        return b;
+        const RealVectorBeliefSpace::StateType *belief = st->as<RealVectorBeliefSpace::StateType>();
+        return Belief(Eigen::Vector2d(x, y), belief->getCovariance()); // dummy return -- probably causes errors in code
     }
-    
+    return Belief(Eigen::Vector2d(x, y), (Eigen::Matrix2d() << s_xx, s_xy, s_xy, s_yy).finished());
 }
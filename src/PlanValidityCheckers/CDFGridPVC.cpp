@@ -1,4 +1,10 @@
 #include "PlanValidityCheckers/CDFGridPVC.h"
+#include "utils/DiskGeometry.h"
+#include "utils/Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
 
 
 CDFGridPVC::CDFGridPVC(MultiRobotProblemDefinitionPtr pdef, const double p_safe, int nSteps):
@@ -11,143 +17,82 @@ CDFGridPVC::CDFGridPVC(MultiRobotProblemDefinitionPtr pdef, const double p_safe,
 
     std::string name = "CDFGridPVC(" + std::to_string(nSteps) + ")";
     this->name_ = name;
+    chance_scale_ = chanceScale_(p_coll_agnts_);
 
     std::vector<Robot*> robots = mrmp_pdef_->getInstance()->getRobots();
-    boost::tokenizer< boost::char_separator<char> >::iterator beg1;
-    boost::tokenizer< boost::char_separator<char> >::iterator beg2;
-    boost::char_separator<char> sep(" ");
-    for (auto itr1 = robots.begin(); itr1 != robots.end(); itr1++) {
-        std::string r1_name = (*itr1)->getName();
-        double max_rad_1 = (*itr1)->getBoundingRadius();
-        boost::tokenizer< boost::char_separator<char> > tok1(r1_name, sep);
-        beg1 = tok1.begin();
-        beg1++;
-        for (auto itr2 = itr1 + 1; itr2 != robots.end(); itr2++) {
-            std::string r2_name = (*itr2)->getName();
-            double max_rad_2 = (*itr2)->getBoundingRadius();
-            boost::tokenizer< boost::char_separator<char> > tok2(r2_name, sep);
-            beg2 = tok2.begin();
-            beg2++;
-            std::string key_name = (*beg1) + "," + (*beg2);
-            Polygon combined_poly = getBoundingBox_(max_rad_1, max_rad_2);
-            polygon_map_.insert({key_name, combined_poly});
-            std::pair<Eigen::MatrixXd, Eigen::MatrixXd> robot_pair_halfplanes = getHalfPlanes_(combined_poly);
-            halfPlane_map_.insert({key_name, robot_pair_halfplanes});
-        }
-    }
-}
-
- std::vector<ConflictPtr> CDFGridPVC::validatePlan(Plan p)
- {
-    std::vector<ConflictPtr> confs{};
-    const double step_duration = mrmp_pdef_->getSystemStepSize();
-
-    // interpolate all trajectories to the same discretization and get max size
-    int maxStates = 0;
-    for (auto itr = p.begin(); itr != p.end(); itr++) {
-        itr->interpolate();
-        if (maxStates < itr->getStateCount())
-            maxStates = itr->getStateCount();
-    }
-
-    for (int k = 0; k < maxStates; k++) {
-        std::map<std::string, Belief> activeRobots = getActiveRobots_(p, k);
-        ConflictPtr c = checkForConflicts_(activeRobots, k);
-        if (c) {
-            // found initial conflict at step k
-            // must continue to propogate forward until conflict is finished
-            int step = k;
-            while (c != nullptr && step < maxStates) {
-                confs.push_back(c);
-                step++;
-                activeRobots = getActiveRobots_(p, step, c->agent1Idx_, c->agent2Idx_);
-                c = checkForConflicts_(activeRobots, step);
+    pair_boxes_ = PairTable<PairBox>(robots.size());
+    for (std::size_t i1 = 0; i1 < robots.size(); i1++) {
+        for (std::size_t i2 = i1 + 1; i2 < robots.size(); i2++) {
+            const Polygon box = getBoundingBox_(robots[i1]->getBoundingRadius(), robots[i2]->getBoundingRadius());
+            const std::pair<Eigen::MatrixXd, Eigen::MatrixXd> hp = getHalfPlanes_(box);
+            PairBox &pb = pair_boxes_(robots[i1]->getId(), robots[i2]->getId());
+            pb.half_planes_ = QuadHalfPlanes(hp.first, hp.second);
+            // the ring of the box is closed, its last point repeats the first
+            auto pts = boost::geometry::exterior_ring(box);
+            for (int i = 0; i != 4; i++) {
+                pb.vertices_(0, i) = bg::get<0>(pts[i]);
+                pb.vertices_(1, i) = bg::get<1>(pts[i]);
             }
-            return confs;
         }
     }
-    return {};
- }
+}
 
-bool CDFGridPVC::satisfiesConstraints(oc::PathControl path, std::vector<ConstraintPtr> constraints)
+bool CDFGridPVC::satisfiesConstraints(const std::vector<ob::State*> &states, const unsigned int first_step, 
+    const ConstraintIndex &index)
 {
+    KCBS_TRACE_SCOPE("CDFGridPVC::satisfiesConstraints");
     /* Assume that the constrained robot is the "planning" robot. Check for satisfaction of all constraints */
-    const int constrained_robot = constraints.front()->getConstrainedAgent();
-    std::vector<ob::State*> states = path.getStates();
-    const double step_size = path.getControlDuration(0);
-    double current_time = 0.0;
-    for (auto itr = states.begin(); itr != states.end(); itr++) {
-        // for every state along path, check if the time coincides with any constraints
-        for (auto c_itr = constraints.begin(); c_itr != constraints.end(); c_itr++) {
-            const std::vector<double> times = (*c_itr)->getTimes();
-            auto it = std::find_if(times.begin(), times.end(), 
-                [&current_time](const double& t) { return abs(t - current_time) < 1E-9;});
-            if (it == times.end()) {
-                continue;
-            }
+    for (std::size_t i = 0; i < states.size(); i++) {
+        // for every state along path, check the constraints at its step
+        const std::vector<ConstraintIndex::Entry> *entries = index.at(first_step + i);
+        if (!entries)
+            continue;
+        const BeliefConstraint::Record constrained_robot_belief = BeliefConstraint::Record::fromState(states[i], first_step + i);
+        for (const ConstraintIndex::Entry &e: *entries) {
             // std::cout << "checking constraint at time: " << (*it) << std::endl;
             // must check this constraint at this time
-            const int constraining_robot = (*c_itr)->getConstrainingAgent();
-            assert(constrained_robot != constraining_robot);
-            
-            // get the correct half-plane for comparing constrained_robot with constraining_robot
-            std::string key_name = std::to_string(constrained_robot) + "," + std::to_string(constraining_robot);
-            if (halfPlane_map_.find(key_name) == halfPlane_map_.end())
-                key_name = std::to_string(constraining_robot) + "," + std::to_string(constrained_robot);
+            assert(e.geometry_ && e.constraint_->getConstrainingAgent() != index.constrained_agent_);
 
-            // get both beliefs
-            int idx = it - times.begin();
-            Belief constrained_robot_belief = getDistribution_(*itr);
-            Belief constraining_robot_belief = getDistribution_((*c_itr)->as<BeliefConstraint>()->getStates()[idx]);
+            // belief of the constraining robot at this step
+            const BeliefConstraint::Record &constraining_robot_belief = e.constraint_->as<BeliefConstraint>()->getRecord(e.time_idx_);
 
-            if (!isSafe_(constrained_robot_belief, constraining_robot_belief, halfPlane_map_[key_name], polygon_map_[key_name]))
+            if (!isSafe_(constrained_robot_belief.mean() - constraining_robot_belief.mean(), constrained_robot_belief.covariance() + constraining_robot_belief.covariance(), 
+                    *static_cast<const PairBox *>(e.geometry_)))
                 return false;
         }
-        current_time += step_size;
     }
     return true;
 }
 
-ConflictPtr CDFGridPVC::checkForConflicts_(std::map<std::string, Belief> states_map, const int step)
+double CDFGridPVC::safeHalfWidth_(const int agent, const double max_lambda, const double max_sqrt_lambda) const
 {
-    ConflictPtr c = nullptr;
-    
-    boost::tokenizer< boost::char_separator<char> >::iterator beg_a;
-    boost::tokenizer< boost::char_separator<char> >::iterator beg_b;
-    boost::char_separator<char> sep(" ");
-
-    for (auto itr_a = states_map.begin(); itr_a != states_map.end(); itr_a++) {
-        // Belief for ai
-        const std::string r_a_name = itr_a->first;
-        boost::tokenizer< boost::char_separator<char> > tok_a(r_a_name, sep);
-        beg_a = tok_a.begin();
-        beg_a++;
-        auto itr_b = itr_a;
-        std::advance(itr_b, 1);
-        for (; itr_b != states_map.end(); itr_b++) {
-            // Belief for aj
-            const std::string r_b_name = itr_b->first;
-            boost::tokenizer< boost::char_separator<char> > tok_b(r_b_name, sep);
-            beg_b = tok_b.begin();
-            beg_b++;
-            std::string key_name = (*beg_a) + "," + (*beg_b);
+    /* the grid only covers the bounding rectangle of the whitened box of the pair. Along one eigenvector u_j of Sigma_ab
+       (|mu_ab . u_j| >= |mu_ab| / sqrt(2)), it lies at least (|mu_ab,x| / sqrt(2) - sqrt(2) r_ab) / (sqrt(lambda_a) + sqrt(lambda_b))
+       deviations from the mean, so a pair further apart along x (or y) than the sum of these has a probability below p_coll */
+    return 2 * bounding_radii_[agent] + std::sqrt(2.0) * chance_scale_ * max_sqrt_lambda;
+}
 
-            if (halfPlane_map_.find(key_name) == halfPlane_map_.end())
-                key_name = (*beg_b) + "," + (*beg_a);
+bool CDFGridPVC::isPairSafe_(const int a, const Eigen::Vector2d &mu_a, const Eigen::Matrix2d &Sigma_a, const int b,
+    const Eigen::Vector2d &mu_b, const Eigen::Matrix2d &Sigma_b)
+{
+    return isSafe_(mu_a - mu_b, Sigma_a + Sigma_b, pair_boxes_(a, b));
+}
 
-            if (!isSafe_(itr_a->second, itr_b->second, halfPlane_map_[key_name], polygon_map_[key_name])) {
-                int a_idx = std::atoi((*beg_a).c_str());
-                int b_idx = std::atoi((*beg_b).c_str());
-                c = std::make_shared<Conflict>(a_idx, b_idx, step);
-                // std::cout << (*itr_a).second.first << std::endl;
-                // std::cout << (*itr_a).second.second << std::endl;
-                // std::cout << (*itr_b).second.first << std::endl;
-                // std::cout << (*itr_b).second.second << std::endl;
-                return c;
-            }
-        }
+ConflictPtr CDFGridPVC::checkForConflicts_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int step,
+    SweepAndPrune &broadphase)
+{
+    std::vector<double> half_widths(agents.size());
+    for (std::size_t i = 0; i < agents.size(); i++) {
+        const double max_lambda = maxEigenvalue2x2(beliefs.covariance(agents[i], step));
+        half_widths[i] = safeHalfWidth_(agents[i], max_lambda, std::sqrt(std::max(max_lambda, 0.0)));
     }
-    return c;
+    for (const std::pair<int, int> &ij: overlappingPairs_(broadphase, beliefs, agents, step, half_widths)) {
+        const int a = agents[ij.first];
+        const int b = agents[ij.second];
+        if (!isSafe_(beliefs.mean(a, step) - beliefs.mean(b, step), beliefs.covariance(a, step) + beliefs.covariance(b, step), pair_boxes_(a, b)))
+            return std::make_shared<Conflict>(a, b, step);
+    }
+    return nullptr;
 }
 
 bool CDFGridPVC::independentCheck(ob::State* state1, ob::State* state2)
@@ -170,161 +115,143 @@ bool CDFGridPVC::independentCheck(ob::State* state1, ob::State* state2)
     // sigma_b << 0.25, 0.1, 0.1, 0.5;
     // Belief r1_belief(mu_b, sigma_b);
 
-    std::string key_name = "0,1";
-    if (halfPlane_map_.find(key_name) == halfPlane_map_.end())
-        key_name = "1,0";
-
-    if (isSafe_(r0_belief, r1_belief, halfPlane_map_[key_name], polygon_map_[key_name]))
+    if (isSafe_(r0_belief.first - r1_belief.first, r0_belief.second + r1_belief.second, pair_boxes_(0, 1)))
         return true;
     return false;
 }
 
-bool CDFGridPVC::isSafe_(const Belief belief_a, const Belief belief_b, std::pair<Eigen::MatrixXd, Eigen::MatrixXd> HP, Polygon V)
+bool CDFGridPVC::isSafe_(const Eigen::Vector2d &mu_ab, const Eigen::Matrix2d &sigma_ab, const PairBox &box) const
 {
-    // compute difference distribution
-    Eigen::Vector2d mu_ab = belief_a.first - belief_b.first;
-    Eigen::Matrix2d sigma_ab = belief_a.second + belief_b.second;
-
-    // perform whitten transform on sigma_ab
-    Eigen::EigenSolver<Eigen::Matrix2d> eigensolver;
-    eigensolver.compute(sigma_ab);
-    Eigen::Matrix2d eigen_vals;
-    eigen_vals.diagonal() << eigensolver.eigenvalues().real();
-    Eigen::Matrix2d eigen_vecs = eigensolver.eigenvectors().real();
-
-    Eigen::LLT<Eigen::Matrix2d> lltOfVal(eigen_vals); // compute the Cholesky decomposition of A
-    Eigen::MatrixXd L = lltOfVal.matrixL(); // retrieve factor L  in the decomposition
-    // The previous two lines can also be written as "L = A.llt().matrixL()"
-
-    Eigen::Matrix2d R = eigen_vecs * L.inverse();
-    Eigen::Vector2d T = mu_ab;
-
-    Eigen::MatrixXd A = HP.first;
-    Eigen::MatrixXd B = HP.second;
-    Eigen::MatrixXd A_new(A.rows(), A.cols());
-    Eigen::MatrixXd B_new(B.rows(), B.cols());
-    for (int i = 0; i != A.rows(); i++) {
-        auto tmp = A.row(i) * (R.transpose()).inverse();
-        A_new(i, 0) = tmp(0, 0);
-        A_new(i, 1) = tmp(0, 1);
-        B_new(i, 0) = (B.row(i)-A.row(i)*T).value();
+    // whiten the box with the closed-form eigendecomposition of sigma_ab (u1 of the largest eigenvalue, u2 orthogonal)
+    const double s_xx = sigma_ab(0, 0);
+    const double s_xy = 0.5 * (sigma_ab(0, 1) + sigma_ab(1, 0));
+    const double s_yy = sigma_ab(1, 1);
+    const double lambda_1 = 0.5 * (s_xx + s_yy) + std::hypot(0.5 * (s_xx - s_yy), s_xy);
+    const double lambda_2 = (s_xx * s_yy - s_xy * s_xy) / lambda_1;
+    // the whitening of a singular (or NaN) covariance is undefined, and such a pair never was safe
+    if (!(lambda_2 > 0) || !std::isfinite(lambda_1))
+        return false;
+    double ux = (s_xx >= s_yy) ? lambda_1 - s_yy : s_xy;
+    double uy = (s_xx >= s_yy) ? s_xy : lambda_1 - s_xx;
+    const double norm = std::hypot(ux, uy);
+    if (norm > 0) {
+        ux /= norm;
+        uy /= norm;
     }
-
-    // convert Polygon V to matrix of vertices
-    auto P_pts = boost::geometry::exterior_ring(V);
-    Eigen::MatrixXd V_mat(2, P_pts.size()-1);
-    for (int i = 0; i != P_pts.size() - 1; i++) {
-        V_mat(0, i) = bg::get<0>(P_pts[i]);
-        V_mat(1, i) = bg::get<1>(P_pts[i]);
+    else {
+        ux = 1;
+        uy = 0;
     }
-    Eigen::MatrixXd V_new = R.transpose() * ((-V_mat).colwise() + T);
-
-    Polygon V_new_poly;
-    // construct the rectangular polygon w/ ref in the center
-    for (int c = 0; c != V_new.cols(); c++) {
-        Point pt(V_new(0, c), V_new(1, c));
-        bg::append(V_new_poly.outer(), pt);
+    const double w_1 = 1 / std::sqrt(lambda_1);
+    const double w_2 = 1 / std::sqrt(lambda_2);
+
+    // vertices of the whitened box (still a parallelogram, in order around it)
+    double vx[4], vy[4];
+    for (int k = 0; k != 4; k++) {
+        const double px = mu_ab[0] - box.vertices_(0, k);
+        const double py = mu_ab[1] - box.vertices_(1, k);
+        vx[k] = w_1 * (ux * px + uy * py);
+        vy[k] = w_2 * (ux * py - uy * px);
     }
-    bg::correct(V_new_poly);
-
-    // std::cout << "poly points" << std::endl;
-    // for (auto &pt: boost::geometry::exterior_ring(V_new_poly)) {
-    //     std::cout << bg::get<0>(pt) << "," << bg::get<1>(pt) << std::endl;
-    // }
-
-    // Grid CDF
-    const double x_low = V_new.row(0).minCoeff();
-    const double x_high = V_new.row(0).maxCoeff();
-    const double y_low = V_new.row(1).minCoeff();
-    const double y_high = V_new.row(1).maxCoeff();
-
-    std::vector<double> Xgrid = linspace_(x_low, x_high, disk_steps_);
-    std::vector<double> Ygrid = linspace_(y_low, y_high, disk_steps_);
-    double prob = 0;
-    for (int ix = 0; ix != disk_steps_ - 1; ix++) {
-        for (int iy = 0; iy != disk_steps_ - 1; iy++) {
-            const double x1 = Xgrid[ix];
-            const double x2 = Xgrid[ix + 1];
-            const double y1 = Ygrid[iy];
-            const double y2 = Ygrid[iy + 1];
-
-            Point pt1(x1, y1);
-            Point pt2(x2, y1);
-            Point pt3(x2, y2);
-            Point pt4(x1, y2);
-
-            // std::cout << "Point1: " << x1 << "," << y1 << std::endl;
-            // std::cout << "Point2: " << x2 << "," << y1 << std::endl;
-            // std::cout << "Point3: " << x2 << "," << y2 << std::endl;
-            // std::cout << "Point4: " << x1 << "," << y2 << std::endl;
 
+    // Grid CDF over the bounding rectangle of the whitened box
+    const double x_low = *std::min_element(vx, vx + 4);
+    const double x_high = *std::max_element(vx, vx + 4);
+    const double y_low = *std::min_element(vy, vy + 4);
+    const double y_high = *std::max_element(vy, vy + 4);
+    if (!std::isfinite(x_low) || !std::isfinite(x_high) || !std::isfinite(y_low) || !std::isfinite(y_high))
+        return false;
+    const int n = disk_steps_;
+    if (n < 2 || !(x_high > x_low) || !(y_high > y_low))
+        return (0 < p_coll_agnts_);
+
+    // the grid lines (as in linspace, the last one is exactly the high end) and the normal CDF at every one of them.
+    // The whitened Gaussian is separable, so the mass of a cell is the product of the CDF differences along x and y
+    thread_local std::vector<double> grid_y, cdf_x, cdf_y;
+    grid_y.resize(n);
+    cdf_x.resize(n);
+    cdf_y.resize(n);
+    const double dx = (x_high - x_low) / (n - 1);
+    const double dy = (y_high - y_low) / (n - 1);
+    auto gridX = [&](const int i) {return (i == n - 1) ? x_high : x_low + dx * i;};
+    for (int i = 0; i != n; i++) {
+        grid_y[i] = (i == n - 1) ? y_high : y_low + dy * i;
+        cdf_x[i] = normalCdf_(gridX(i));
+        cdf_y[i] = normalCdf_(grid_y[i]);
+    }
 
-            if (disk_steps_ == 2) {
-            	Polygon box;
-            	bg::append(box.outer(), pt1);
-            	bg::append(box.outer(), pt2);
-            	bg::append(box.outer(), pt3);
-            	bg::append(box.outer(), pt4);
-            	if (!bg::disjoint(box, V_new_poly)) {
-            		const std::vector<Point> B{pt1, pt2, pt3, pt4};
-            		prob += cdfRect_(B);
-                    break;
-            	}
+    if (n == 2) {
+        // a single cell, the bounding rectangle itself, which always intersects the box
+        const double prob = (cdf_x[1] - cdf_x[0]) * (cdf_y[1] - cdf_y[0]);
+        return (prob < p_coll_agnts_);
+    }
 
+    // scanline: the range [lo, hi] of the grid points of every row inside (or on) the whitened box
+    auto rowRange = [&](const double y, int &lo, int &hi) {
+        double xl = std::numeric_limits<double>::infinity();
+        double xr = -std::numeric_limits<double>::infinity();
+        for (int k = 0; k != 4; k++) {
+            const int l = (k + 1) % 4;
+            if (y < std::min(vy[k], vy[l]) || y > std::max(vy[k], vy[l]))
+                continue;
+            if (vy[k] == vy[l]) {
+                xl = std::min({xl, vx[k], vx[l]});
+                xr = std::max({xr, vx[k], vx[l]});
             }
             else {
-            	const std::vector<Point> B{pt1, pt2, pt3, pt4};
-            	for (auto &pt: B) {
-                	if (!bg::disjoint(pt, V_new_poly)) {
-                    	prob += cdfRect_(B);
-                    	break;
-                	}
-                }
+                const double x = vx[k] + (y - vy[k]) / (vy[l] - vy[k]) * (vx[l] - vx[k]);
+                xl = std::min(xl, x);
+                xr = std::max(xr, x);
             }
         }
+        lo = n;
+        hi = -1;
+        if (!(xl <= xr))
+            return;
+        lo = std::max(0, static_cast<int>(std::ceil((xl - x_low) / dx)));
+        hi = std::min(n - 1, static_cast<int>(std::floor((xr - x_low) / dx)));
+        // match the grid points exactly, whatever the rounding of the divisions
+        while (lo > 0 && gridX(lo - 1) >= xl)
+            lo--;
+        while (lo < n && gridX(lo) < xl)
+            lo++;
+        while (hi < n - 1 && gridX(hi + 1) <= xr)
+            hi++;
+        while (hi >= 0 && gridX(hi) > xr)
+            hi--;
+    };
+    // mass along x of the cells [first, last], clamped to the grid (the sum of the CDF differences telescopes)
+    auto massX = [&](int first, int last) {
+        first = std::max(first, 0);
+        last = std::min(last, n - 2);
+        return (first <= last) ? cdf_x[last + 1] - cdf_x[first] : 0.0;
+    };
+
+    // a cell counts if any of its corners is inside (or on) the whitened box, i.e. if one of its two rows has a point
+    // inside at its left or right end. So the cells of a row of cells that count are the union of two ranges
+    double prob = 0;
+    int lo_1, hi_1;
+    rowRange(grid_y[0], lo_1, hi_1);
+    for (int iy = 0; iy != n - 1; iy++) {
+        int lo_2, hi_2;
+        rowRange(grid_y[iy + 1], lo_2, hi_2);
+        // cells [lo - 1, hi] have a corner among the points [lo, hi]
+        int first_1 = lo_1 - 1, last_1 = hi_1;
+        int first_2 = lo_2 - 1, last_2 = hi_2;
+        double mass;
+        if (lo_1 > hi_1)
+            mass = (lo_2 > hi_2) ? 0.0 : massX(first_2, last_2);
+        else if (lo_2 > hi_2)
+            mass = massX(first_1, last_1);
+        else if (first_2 <= last_1 + 1 && first_1 <= last_2 + 1)
+            mass = massX(std::min(first_1, first_2), std::max(last_1, last_2));
+        else
+            mass = massX(first_1, last_1) + massX(first_2, last_2);
+        prob += mass * (cdf_y[iy + 1] - cdf_y[iy]);
+        lo_1 = lo_2;
+        hi_1 = hi_2;
     }
-    // std::cout << prob << std::endl;
-    // exit(-1);
-    if (prob < p_coll_agnts_)
-        return true;
-    return false;
-}
-
-double CDFGridPVC::cdfRect_(std::vector<Point> B)
-{
-    Point v1 = B[0];
-    Point v2 = B[1];
-    Point v3 = B[2];
-    Point v4 = B[3];
-
-    const double p1 = (1.0/2.0) * (1 + bm::erf(bg::get<0>(v1) / sqrt(2))) * (1.0/2.0) * (1 + bm::erf(bg::get<1>(v1) / sqrt(2)));
-    const double p2 = (1.0/2.0) * (1 + bm::erf(bg::get<0>(v2) / sqrt(2))) * (1.0/2.0) * (1 + bm::erf(bg::get<1>(v2) / sqrt(2)));
-    const double p3 = (1.0/2.0) * (1 + bm::erf(bg::get<0>(v3) / sqrt(2))) * (1.0/2.0) * (1 + bm::erf(bg::get<1>(v3) / sqrt(2)));
-    const double p4 = (1.0/2.0) * (1 + bm::erf(bg::get<0>(v4) / sqrt(2))) * (1.0/2.0) * (1 + bm::erf(bg::get<1>(v4) / sqrt(2)));
-
-    return p3 - p2 - p4 + p1;
-}
-
-std::vector<double> CDFGridPVC::linspace_(double start, double end, int num)
-{
-    std::vector<double> linspaced;
-
-    if (num == 0) { return linspaced; }
-    if (num == 1) 
-    {
-        linspaced.push_back(start);
-        return linspaced;
-    }
-
-    double delta = (end - start) / (num - 1);
-
-    for(int i=0; i < num-1; ++i)
-    {
-        linspaced.push_back(start + delta * i);
-    }
-    linspaced.push_back(end); // I want to ensure that start and end
-                            // are exactly the same as the input
-    return linspaced;
+    return (prob < p_coll_agnts_);
 }
 
 Polygon CDFGridPVC::getBoundingBox_(const double r_1, const double r_2)
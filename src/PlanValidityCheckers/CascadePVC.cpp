@@ -0,0 +1,153 @@
+#include "PlanValidityCheckers/CascadePVC.h"
+#include "PlanValidityCheckers/BoundingBoxBlackmorePVC.h"
+#include "PlanValidityCheckers/CDFGridPVC.h"
+#include "PlanValidityCheckers/ChiSquaredBoundaryPVC.h"
+#include "PlanValidityCheckers/MinkowskiSumBlackmorePVC.h"
+#include "PlanValidityCheckers/Blackmore2PVC.h"
+#include "PlanValidityCheckers/MonteCarloPVC.h"
+#include "utils/DiskGeometry.h"
+#include "utils/Trace.h"
+#include <boost/tokenizer.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+
+CascadePVC::CascadePVC(MultiRobotProblemDefinitionPtr pdef, const double p_safe, std::vector<BeliefPVCPtr> tiers):
+    BeliefPVC(pdef, "CascadePVC", p_safe), tiers_(std::move(tiers)), resolved_(new std::atomic<std::size_t>[tiers_.size()]())
+{
+    std::string name = "CascadePVC(";
+    for (std::size_t k = 0; k < tiers_.size(); k++) {
+        if (!tiers_[k]->pairwise_())
+            OMPL_ERROR("%s: %s has no pair test, so it cannot be a tier.", name_.c_str(), tiers_[k]->getName().c_str());
+        name += (k > 0 ? "," : "") + tiers_[k]->getName();
+    }
+    name_ = name + ")";
+    if (tiers_.empty())
+        OMPL_ERROR("%s: has no tier.", name_.c_str());
+}
+
+CascadePVCPtr CascadePVC::create(MultiRobotProblemDefinitionPtr pdef, const double p_safe, const std::string &spec)
+{
+    std::vector<BeliefPVCPtr> tiers;
+    boost::char_separator<char> sep(",");
+    boost::tokenizer< boost::char_separator<char> > tok(spec, sep);
+    for (const std::string &tier: tok) {
+        if (tier == "ChiSquared")
+            tiers.push_back(std::make_shared<ChiSquaredBoundaryPVC>(pdef, 0.9));
+        else if (tier == "Blackmore")
+            tiers.push_back(std::make_shared<MinkowskiSumBlackmorePVC>(pdef, p_safe));
+        else if (tier == "Blackmore2")
+            tiers.push_back(std::make_shared<Blackmore2PVC>(pdef, p_safe));
+        else if (tier == "BoundingBox")
+            tiers.push_back(std::make_shared<BoundingBoxBlackmorePVC>(pdef, p_safe));
+        else if (tier.find("CDFGrid-") == 0)
+            tiers.push_back(std::make_shared<CDFGridPVC>(pdef, p_safe, atoi(tier.substr(8).c_str())));
+        else if (tier.find("MonteCarlo-") == 0)
+            tiers.push_back(std::make_shared<MonteCarloPVC>(pdef, p_safe, atoi(tier.substr(11).c_str())));
+        else {
+            // (the adaptive validators share the risk between every agent of a step, so they have no pair test)
+            OMPL_ERROR("CascadePVC: ``%s`` is not available as a tier.", tier.c_str());
+            return nullptr;
+        }
+    }
+    if (tiers.empty()) {
+        OMPL_ERROR("CascadePVC: ``%s`` names no tier.", spec.c_str());
+        return nullptr;
+    }
+    return std::make_shared<CascadePVC>(pdef, p_safe, std::move(tiers));
+}
+
+bool CascadePVC::satisfiesConstraints(const std::vector<ob::State*> &states, const unsigned int first_step,
+    const ConstraintIndex &index)
+{
+    KCBS_TRACE_SCOPE("CascadePVC::satisfiesConstraints");
+    /* Assume that the constrained robot is the "planning" robot. Check for satisfaction of all constraints */
+    const int constrained_robot = index.constrained_agent_;
+    for (std::size_t i = 0; i < states.size(); i++) {
+        // for every state along path, check the constraints at its step
+        const std::vector<ConstraintIndex::Entry> *entries = index.at(first_step + i);
+        if (!entries)
+            continue;
+        const BeliefConstraint::Record constrained_robot_belief = BeliefConstraint::Record::fromState(states[i], first_step + i);
+        for (const ConstraintIndex::Entry &e: *entries) {
+            const int constraining_robot = e.constraint_->getConstrainingAgent();
+            assert(constrained_robot != constraining_robot);
+
+            const BeliefConstraint::Record &constraining_robot_belief = e.constraint_->as<BeliefConstraint>()->getRecord(e.time_idx_);
+            if (!isPairSafe_(constrained_robot, constrained_robot_belief.mean(), constrained_robot_belief.covariance(),
+                    constraining_robot, constraining_robot_belief.mean(), constraining_robot_belief.covariance()))
+                return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::size_t> CascadePVC::getResolvedChecks() const
+{
+    std::vector<std::size_t> resolved(tiers_.size());
+    for (std::size_t k = 0; k < tiers_.size(); k++)
+        resolved[k] = resolved_[k].load(std::memory_order_relaxed);
+    return resolved;
+}
+
+void CascadePVC::resetStats()
+{
+    for (std::size_t k = 0; k < tiers_.size(); k++)
+        resolved_[k].store(0, std::memory_order_relaxed);
+}
+
+void CascadePVC::printStats() const
+{
+    const std::vector<std::size_t> resolved = getResolvedChecks();
+    std::size_t total = 0;
+    for (const std::size_t n: resolved)
+        total += n;
+    for (std::size_t k = 0; k < tiers_.size(); k++) {
+        OMPL_INFORM("%s: tier %zu (%s) resolved %zu of %zu pair checks (%.1f%%).", name_.c_str(), k, tiers_[k]->getName().c_str(),
+            resolved[k], total, (total > 0) ? (100.0 * resolved[k] / total) : 0.0);
+    }
+}
+
+double CascadePVC::safeHalfWidth_(const int agent, const double max_lambda, const double max_sqrt_lambda) const
+{
+    /* a pair pruned by the first tier is one it finds safe, which is also the answer of the cascade. (Mixing the
+       margins of several tiers would not be: the sum of two per-agent minima belongs to neither) */
+    if (tiers_.empty())
+        return std::numeric_limits<double>::infinity();
+    return tiers_.front()->safeHalfWidth_(agent, max_lambda, max_sqrt_lambda);
+}
+
+ConflictPtr CascadePVC::checkForConflicts_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int step,
+    SweepAndPrune &broadphase)
+{
+    std::vector<double> half_widths(agents.size());
+    for (std::size_t i = 0; i < agents.size(); i++) {
+        const double max_lambda = maxEigenvalue2x2(beliefs.covariance(agents[i], step));
+        half_widths[i] = safeHalfWidth_(agents[i], max_lambda, std::sqrt(std::max(max_lambda, 0.0)));
+    }
+    for (const std::pair<int, int> &ij: overlappingPairs_(broadphase, beliefs, agents, step, half_widths)) {
+        const int a = agents[ij.first];
+        const int b = agents[ij.second];
+        if (!isPairSafe_(a, beliefs.mean(a, step), beliefs.covariance(a, step), b, beliefs.mean(b, step), beliefs.covariance(b, step)))
+            return std::make_shared<Conflict>(a, b, step);
+    }
+    return nullptr;
+}
+
+bool CascadePVC::isPairSafe_(const int a, const Eigen::Vector2d &mu_a, const Eigen::Matrix2d &Sigma_a, const int b,
+    const Eigen::Vector2d &mu_b, const Eigen::Matrix2d &Sigma_b)
+{
+    if (tiers_.empty())
+        return false;
+    const std::size_t last = tiers_.size() - 1;
+    for (std::size_t k = 0; k < last; k++) {
+        if (tiers_[k]->isPairSafe_(a, mu_a, Sigma_a, b, mu_b, Sigma_b)) {
+            resolved_[k].fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    // ambiguous for every earlier tier, the tightest one decides
+    resolved_[last].fetch_add(1, std::memory_order_relaxed);
+    return tiers_[last]->isPairSafe_(a, mu_a, Sigma_a, b, mu_b, Sigma_b);
+}
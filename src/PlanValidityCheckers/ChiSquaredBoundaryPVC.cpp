@@ -1,87 +1,38 @@
 #include "PlanValidityCheckers/ChiSquaredBoundaryPVC.h"
+#include "utils/Trace.h"
 
 
 ChiSquaredBoundaryPVC::ChiSquaredBoundaryPVC(MultiRobotProblemDefinitionPtr pdef, const double p_safe):
     BeliefPVC(pdef, "ChiSquaredBoundaryPVC", p_safe), sc_(-1)
 {
-    std::vector<Robot*> robots = mrmp_pdef_->getInstance()->getRobots();
-    boost::tokenizer< boost::char_separator<char> >::iterator beg1;
-    boost::tokenizer< boost::char_separator<char> >::iterator beg2;
-    boost::char_separator<char> sep(" ");
-    for (auto itr1 = robots.begin(); itr1 != robots.end(); itr1++) {
-        std::string r1_name = (*itr1)->getName();
-        boost::tokenizer< boost::char_separator<char> > tok1(r1_name, sep);
-        double max_rad = (*itr1)->getBoundingRadius();
-        boundingRadii_map.insert({r1_name, max_rad});
-    }
-
     // set sc_ value
     sc_ = chi_squared_quantile_(2, p_safe_agnts_);
 }
 
-std::vector<ConflictPtr> ChiSquaredBoundaryPVC::validatePlan(Plan p)
-{
-    std::vector<ConflictPtr> confs{};
-    const double step_duration = mrmp_pdef_->getSystemStepSize();
-
-    // interpolate all trajectories to the same discretization and get max size
-    int maxStates = 0;
-    for (auto itr = p.begin(); itr != p.end(); itr++) {
-        itr->interpolate();
-        if (maxStates < itr->getStateCount())
-            maxStates = itr->getStateCount(); 
-    }
-
-    for (int k = 0; k < maxStates; k++) {
-        std::map<std::string, Belief> activeRobots = getActiveRobots_(p, k);
-        ConflictPtr c = checkForConflicts_(activeRobots, k);
-        if (c) {
-            // found initial conflict at step k
-            // must continue to propogate forward until conflict is finished
-            int step = k;
-            while (c != nullptr && step < maxStates) {
-                confs.push_back(c);
-                step++;
-                activeRobots = getActiveRobots_(p, step, c->agent1Idx_, c->agent2Idx_);
-                c = checkForConflicts_(activeRobots, step);
-            }
-            return confs;
-        }
-    }
-    return {};
-}
-
-bool ChiSquaredBoundaryPVC::satisfiesConstraints(oc::PathControl path, std::vector<ConstraintPtr> constraints)
+bool ChiSquaredBoundaryPVC::satisfiesConstraints(const std::vector<ob::State*> &states, const unsigned int first_step, 
+    const ConstraintIndex &index)
 {
+    KCBS_TRACE_SCOPE("ChiSquaredBoundaryPVC::satisfiesConstraints");
     /* Assume that the constrained robot is the "planning" robot. Check for satisfaction of all constraints */
-    const int constrained_robot = constraints.front()->getConstrainedAgent();
-    const std::string constrained_robot_name = mrmp_pdef_->getInstance()->getRobots()[constrained_robot]->getName();
-    std::vector<ob::State*> states = path.getStates();
-    const double step_size = path.getControlDuration(0);
-    double current_time = 0.0;
-    for (auto itr = states.begin(); itr != states.end(); itr++) {
-        // for every state along path, check if the time coincides with any constraints
-        for (auto c_itr = constraints.begin(); c_itr != constraints.end(); c_itr++) {
-            const std::vector<double> times = (*c_itr)->getTimes();
-            auto it = std::find_if(times.begin(), times.end(), 
-                [&current_time](const double& t) { return abs(t - current_time) < 1E-9;});
-            if (it == times.end()) {
-                continue;
-            }
+    const int constrained_robot = index.constrained_agent_;
+    for (std::size_t i = 0; i < states.size(); i++) {
+        // for every state along path, check the constraints at its step
+        const std::vector<ConstraintIndex::Entry> *entries = index.at(first_step + i);
+        if (!entries)
+            continue;
+        const BeliefConstraint::Record constrained_robot_belief = BeliefConstraint::Record::fromState(states[i], first_step + i);
+        for (const ConstraintIndex::Entry &e: *entries) {
             // must check this constraint at this time
-            const int constraining_robot = (*c_itr)->getConstrainingAgent();
-            const std::string constraining_robot_name = mrmp_pdef_->getInstance()->getRobots()[constraining_robot]->getName();
+            const int constraining_robot = e.constraint_->getConstrainingAgent();
             assert(constrained_robot != constraining_robot);
 
-            // get both beliefs
-            int idx = it - times.begin();
-            Belief constrained_robot_belief = getDistribution_(*itr);
-            Belief constraining_robot_belief = getDistribution_((*c_itr)->as<BeliefConstraint>()->getStates()[idx]);
+            // belief of the constraining robot at this step
+            const BeliefConstraint::Record &constraining_robot_belief = e.constraint_->as<BeliefConstraint>()->getRecord(e.time_idx_);
 
-            if (!isSafe_(constrained_robot_belief, boundingRadii_map[constrained_robot_name], constraining_robot_belief, boundingRadii_map[constraining_robot_name]))
+            if (!isSafe_(constrained_robot_belief.mean(), constrained_robot_belief.covariance(), bounding_radii_[constrained_robot], 
+                    constraining_robot_belief.mean(), constraining_robot_belief.covariance(), bounding_radii_[constraining_robot]))
                 return false;
         }
-        current_time += step_size;
     }
     return true;
 }
@@ -89,73 +40,54 @@ bool ChiSquaredBoundaryPVC::satisfiesConstraints(oc::PathControl path, std::vect
 bool ChiSquaredBoundaryPVC::independentCheck(ob::State* state1, ob::State* state2)
 {
     /* Only to be used for independent collision testing. Not called during MRMP planning (yet?) */
-    const double max_rad0 = boundingRadii_map["Robot 0"];
-    const double max_rad1 = boundingRadii_map["Robot 1"];
-
     Belief r0_belief = getDistribution_(state1);
     Belief r1_belief = getDistribution_(state2);
 
-    if (isSafe_(r0_belief, max_rad0, r1_belief, max_rad1))
+    if (isSafe_(r0_belief.first, r0_belief.second, bounding_radii_[0], r1_belief.first, r1_belief.second, bounding_radii_[1]))
         return true;
     return false;
 }
 
-ConflictPtr ChiSquaredBoundaryPVC::checkForConflicts_(std::map<std::string, Belief> states_map, const int step)
+double ChiSquaredBoundaryPVC::safeHalfWidth_(const int agent, const double max_lambda, const double max_sqrt_lambda) const
 {
-    ConflictPtr c = nullptr;
-    
-    boost::tokenizer< boost::char_separator<char> >::iterator beg_a;
-    boost::tokenizer< boost::char_separator<char> >::iterator beg_b;
-    boost::char_separator<char> sep(" ");
+    /* the boundary of a pair is the sum of those of its robots, so a pair whose means are further apart along x or y
+       than the sum of these is safe */
+    return max_lambda * sc_ + bounding_radii_[agent];
+}
 
-    for (auto itr_a = states_map.begin(); itr_a != states_map.end(); itr_a++) {
-        // Belief for ai
-        const std::string r_a_name = itr_a->first;
-        const Belief r_a_belief = itr_a->second;
-        boost::tokenizer< boost::char_separator<char> > tok_a(r_a_name, sep);
-        beg_a = tok_a.begin();
-        beg_a++;
-        auto itr_b = itr_a;
-        std::advance(itr_b, 1);
-        for (; itr_b != states_map.end(); itr_b++) {
-            // Belief for aj
-            const std::string r_b_name = itr_b->first;
-            const Belief r_b_belief = itr_b->second;
-            boost::tokenizer< boost::char_separator<char> > tok_b(r_b_name, sep);
-            beg_b = tok_b.begin();
-            beg_b++;
+bool ChiSquaredBoundaryPVC::isPairSafe_(const int a, const Eigen::Vector2d &mu_a, const Eigen::Matrix2d &Sigma_a, const int b,
+    const Eigen::Vector2d &mu_b, const Eigen::Matrix2d &Sigma_b)
+{
+    return isSafe_(mu_a, Sigma_a, bounding_radii_[a], mu_b, Sigma_b, bounding_radii_[b]);
+}
 
-            if (!isSafe_(r_a_belief, boundingRadii_map[r_a_name], r_b_belief, boundingRadii_map[r_b_name])) {
-                int a_idx = std::atoi((*beg_a).c_str());
-                int b_idx = std::atoi((*beg_b).c_str());
-                c = std::make_shared<Conflict>(a_idx, b_idx, step);
-                return c;
-            }
-        }
+ConflictPtr ChiSquaredBoundaryPVC::checkForConflicts_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int step,
+    SweepAndPrune &broadphase)
+{
+    std::vector<double> half_widths(agents.size());
+    for (std::size_t i = 0; i < agents.size(); i++) {
+        const double max_lambda = maxEigenvalue2x2(beliefs.covariance(agents[i], step));
+        half_widths[i] = safeHalfWidth_(agents[i], max_lambda, std::sqrt(std::max(max_lambda, 0.0)));
+    }
+    for (const std::pair<int, int> &ij: overlappingPairs_(broadphase, beliefs, agents, step, half_widths)) {
+        const int a = agents[ij.first];
+        const int b = agents[ij.second];
+        if (!isSafe_(beliefs.mean(a, step), beliefs.covariance(a, step), bounding_radii_[a], beliefs.mean(b, step), beliefs.covariance(b, step), bounding_radii_[b]))
+            return std::make_shared<Conflict>(a, b, step);
     }
-    return c;
+    return nullptr;
 }
 
-bool ChiSquaredBoundaryPVC::isSafe_(const Belief belief_a, const double rad_a, const Belief belief_b, const double rad_b)
+bool ChiSquaredBoundaryPVC::isSafe_(const Eigen::Vector2d &mu_a, const Eigen::Matrix2d &Sigma_a, const double rad_a, 
+    const Eigen::Vector2d &mu_b, const Eigen::Matrix2d &Sigma_b, const double rad_b) const
 {
     /* Find maximum eigenvalues of the covariances */
-    // Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver_a(belief_a.second.rows());
-    Eigen::EigenSolver<Eigen::Matrix2d> eigensolver_a;
-    eigensolver_a.compute(belief_a.second);
-
-    // Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver_b(belief_b.second.rows());
-    Eigen::EigenSolver<Eigen::Matrix2d> eigensolver_b;
-    eigensolver_b.compute(belief_b.second);
-
-    const double max_lambda_a = eigensolver_a.eigenvalues().real().maxCoeff();
-    const double max_lambda_b = eigensolver_b.eigenvalues().real().maxCoeff();
+    const double max_lambda_a = maxEigenvalue2x2(Sigma_a);
+    const double max_lambda_b = maxEigenvalue2x2(Sigma_b);
 
     /* Calculate the "upper-bounded" distance between the distributions and the safety boundary */
-    auto mu_a = belief_a.first;
-    auto mu_b = belief_b.first;
-
-    const double mu_diff_x = mu_a(0, 0) - mu_b(0, 0);
-    const double mu_diff_y = mu_a(1, 0) - mu_b(1, 0);
+    const double mu_diff_x = mu_a[0] - mu_b[0];
+    const double mu_diff_y = mu_a[1] - mu_b[1];
 
     const double dist =  sqrt( mu_diff_x*mu_diff_x + mu_diff_y*mu_diff_y );
     const double boundary = (max_lambda_a * sc_ + rad_a) + (max_lambda_b * sc_ + rad_b);
@@ -1,36 +1,61 @@
 #include "PlanValidityCheckers/DeterministicPVC.h"
+#include "utils/Trace.h"
+#include <algorithm>
+#include <limits>
 
 DeterministicPlanValidityChecker::DeterministicPlanValidityChecker(MultiRobotProblemDefinitionPtr pdef):
-	PlanValidityChecker(pdef, "DeterministicPlanValidityChecker") {};
+	PlanValidityChecker(pdef, "DeterministicPlanValidityChecker")
+{
+	for (Robot* r: mrmp_pdef_->getInstance()->getRobots()) {
+		if (r->getDynamicsModel() != "FirstOrderCar" && 
+			r->getDynamicsModel() != "SecondOrderCar" && 
+			r->getDynamicsModel() != "SecondOrderUnicycle") {
+				OMPL_WARN("%s: Dynamics Model may not be suitable for this PlanValidityChecker! Be sure to check.", name_.c_str());
+		}
+		RobotFootprint fp;
+		if (!RobotFootprint::fromRobot(*r, fp))
+			OMPL_ERROR("%s: the shape of %s has more than %d corners!", name_.c_str(), r->getName().c_str(), RobotFootprint::max_corners_);
+		footprints_.push_back(fp);
+	}
+}
 
-std::vector<ConflictPtr> DeterministicPlanValidityChecker::validatePlan(Plan p)
+std::vector<ConflictPtr> DeterministicPlanValidityChecker::validatePlan(const DiscretePlan &p)
 {
+	KCBS_TRACE_SCOPE("DeterministicPlanValidityChecker::validatePlan");
 	std::vector<ConflictPtr> confs{};
 	const double step_duration = mrmp_pdef_->getSystemStepSize();
 
-	// interpolate all trajectories to the same discretization and get max size
-	int maxStates = 0;
-	for (auto itr = p.begin(); itr != p.end(); itr++) {
-		itr->interpolate();
-		if (maxStates < itr->getStateCount())
-			maxStates = itr->getStateCount(); 
-	}
+	const int maxStates = windowSteps_(p);
 
+	SweepAndPrune broadphase;
+	broadphase.resize(p.size());
+	// reused from one step to the next
+	std::vector<std::pair<int, RobotFootprint>> activeRobots;
 	for (int k = 0; k < maxStates; k++) {
 		// get shapes and indices of active robots
-		std::vector<std::pair<int, Polygon>> activeRobots = getActiveRobots_(p, k);
-		ConflictPtr c = checkForConflicts_(activeRobots, k);
+		getActiveRobots_(p, k, activeRobots);
+		// the robots whose trajectories ended are static obstacles, a pair of them was checked when the later one parked
+		for (std::size_t ai = 0; ai < p.size(); ai++)
+			broadphase.setParked(ai, k > lastStep_(p, ai));
+		ConflictPtr c = checkForConflicts_(activeRobots, k, broadphase);
 		// std::cout << c << std::endl;
 		if (c) {
 			// found initial conflict at step k
 			// must continue to propogate forward until conflict is finished
+			SweepAndPrune pair_broadphase;
+			const int parked = std::max(lastStep_(p, c->agent1Idx_), lastStep_(p, c->agent2Idx_));
 			int step = k;
 			while (c && step < maxStates) {
 				// std::cout << "found: " << c << std::endl;
 				confs.push_back(c);
 				step++;
-				activeRobots = getActiveRobots_(p, step, c->agent1Idx_, c->agent2Idx_);
-				c = checkForConflicts_(activeRobots, step);
+				// once both robots are parked the conflict goes on
+				if (step > parked) {
+					c = std::make_shared<Conflict>(c->agent1Idx_, c->agent2Idx_, step);
+					continue;
+				}
+				getActiveRobots_(p, step, activeRobots, c->agent1Idx_, c->agent2Idx_);
+				c = checkForConflicts_(activeRobots, step, pair_broadphase);
 			}
 			return confs;
 		}
@@ -38,114 +63,189 @@ std::vector<ConflictPtr> DeterministicPlanValidityChecker::validatePlan(Plan p)
 	return confs;
 }
 
-ConstraintPtr DeterministicPlanValidityChecker::createConstraint(Plan p, std::vector<ConflictPtr> conflicts, const int robotIdx)
+std::vector<ConflictPtr> DeterministicPlanValidityChecker::validatePair_(const DiscretePlan &p, const int a1, const int a2, const int max_states)
 {
-	// const double step_duration = mrmp_pdef_->getSystemStepSize();
-	// std::vector<double> times;
-	// std::vector<Polygon> polys;
-	// for (auto itr = conflicts.begin(); itr != conflicts.end(); itr++) {
-	// 	times.push_back(((*itr)->timeStep_ * step_duration));
-	// 	if ( (*itr)->timeStep_ <  p[robotIdx].getStates().size()) {
-	// 		Polygon r = getShapeFromState_(p[robotIdx].getState((*itr)->timeStep_), robotIdx);
-	// 		polys.push_back(r);
-	// 	}
-	// 	else {
-	// 		Polygon r = getShapeFromState_(p[robotIdx].getStates().back(), robotIdx);
-	// 		polys.push_back(r);
-	// 	}
-		
-	// }
-	// ConstraintPtr c = std::make_shared<DeterministicConstraint>(robotIdx, times, polys);
-	OMPL_ERROR("Not implemented yet!");
-	exit(-1);
-	return nullptr;
+	std::vector<std::vector<ConflictPtr>> intervals = pairIntervals_(p, a1, a2, max_states, false);
+	if (intervals.empty())
+		return {};
+	return intervals.front();
 }
 
-ConflictPtr DeterministicPlanValidityChecker::checkForConflicts_(std::vector<std::pair<int, Polygon>> shapes, const int step)
+std::vector<std::vector<ConflictPtr>> DeterministicPlanValidityChecker::validatePairAll_(const DiscretePlan &p, const int a1, const int a2,
+	const int max_states)
 {
-	ConflictPtr c = nullptr;
-	for (int ai = 0; ai < shapes.size(); ai++) {
-		for (int aj = ai + 1; aj < shapes.size(); aj++) {
-			if (! boost::geometry::disjoint(shapes[ai].second, shapes[aj].second)) {
-				c = std::make_shared<Conflict>(ai, aj, step);
-				return c;
+	return pairIntervals_(p, a1, a2, max_states, true);
+}
+
+std::vector<std::vector<ConflictPtr>> DeterministicPlanValidityChecker::pairIntervals_(const DiscretePlan &p, const int a1, const int a2,
+	const int max_states, const bool all)
+{
+	std::vector<std::vector<ConflictPtr>> intervals;
+	SweepAndPrune broadphase;
+	std::vector<std::pair<int, RobotFootprint>> shapes;
+	// once both robots are parked, the steps repeat the one the later of them parked at
+	const int parked = std::max(lastStep_(p, a1), lastStep_(p, a2));
+	for (int k = 0; k < max_states && k <= parked; k++) {
+		getActiveRobots_(p, k, shapes, a1, a2);
+		ConflictPtr c = checkForConflicts_(shapes, k, broadphase);
+		if (c) {
+			// found initial conflict at step k
+			// must continue to propogate forward until conflict is finished
+			std::vector<ConflictPtr> confs{};
+			int step = k;
+			while (c && step < max_states) {
+				confs.push_back(c);
+				step++;
+				if (step > parked) {
+					c = std::make_shared<Conflict>(a1, a2, step);
+					continue;
+				}
+				getActiveRobots_(p, step, shapes, a1, a2);
+				c = checkForConflicts_(shapes, step, broadphase);
 			}
+			intervals.push_back(std::move(confs));
+			if (!all)
+				return intervals;
+			// the step that ended the interval is conflict-free
+			k = step;
 		}
 	}
-	return c;
+	return intervals;
 }
 
-std::vector<std::pair<int, Polygon>> DeterministicPlanValidityChecker::getActiveRobots_(Plan p, const int step, const int a1, const int a2)
+ConstraintPtr DeterministicPlanValidityChecker::createConstraint(const DiscretePlan &p, const std::vector<ConflictPtr> &conflicts, const int robotIdx)
 {
-	std::vector<std::pair<int, Polygon>> activeRobots{};
+	const int constraining_robot = (robotIdx == conflicts.front()->agent1Idx_) ? conflicts.front()->agent2Idx_ : conflicts.front()->agent1Idx_;
+	return createConstraint_(p, conflicts, robotIdx, constraining_robot, false);
+}
 
-	// using no pre-defined agent pair, return vector of all robots
-	if (a1 == -1 || a2 == -1) {
-		int idx = 0;
-		auto itr = p.begin();
-		for(; itr < p.end(); itr++, idx++ )
-		{
-			if (step < itr->getStateCount())
-			{
-				Polygon robotShape = getShapeFromState_(itr->getState(step), idx);
-				activeRobots.emplace_back(idx, robotShape);
-			}
-			else
-			{
-				Polygon robotShape = getShapeFromState_(itr->getStates().back(), idx);
-				activeRobots.emplace_back(idx, robotShape);
-			}
+ConstraintPtr DeterministicPlanValidityChecker::createRegionConstraint(const DiscretePlan &p, const std::vector<ConflictPtr> &conflicts, 
+	const int robotIdx, const bool positive)
+{
+	return createConstraint_(p, conflicts, robotIdx, robotIdx, positive);
+}
+
+ConstraintPtr DeterministicPlanValidityChecker::createConstraint_(const DiscretePlan &p, const std::vector<ConflictPtr> &conflicts, 
+	const int robotIdx, const int region_robot, const bool positive)
+{
+	const int constraining_robot = (robotIdx == conflicts.front()->agent1Idx_) ? conflicts.front()->agent2Idx_ : conflicts.front()->agent1Idx_;
+	assert(robotIdx != constraining_robot);
+	const double step_duration = mrmp_pdef_->getSystemStepSize();
+	const oc::PathControl &traj = p[region_robot];
+	std::vector<double> times;
+	std::vector<RobotFootprint> shapes;
+	times.reserve(conflicts.size());
+	shapes.reserve(conflicts.size());
+	for (const ConflictPtr &conf: conflicts) {
+		times.push_back(conf->timeStep_ * step_duration);
+		// once its trajectory ended, the constraining robot stays at its last state
+		const ob::State *st = (static_cast<std::size_t>(conf->timeStep_) < traj.getStateCount()) ? traj.getState(conf->timeStep_) : traj.getStates().back();
+		// (the region of a disjoint split is the shape of the constraining robot at the states of robotIdx)
+		shapes.push_back(getShapeFromState_(st, constraining_robot));
+	}
+	return std::make_shared<DeterministicConstraint>(robotIdx, constraining_robot, std::move(times), std::move(shapes), positive);
+}
+
+bool DeterministicPlanValidityChecker::satisfiesConstraints(const std::vector<ob::State*> &states, const unsigned int first_step, 
+	const ConstraintIndex &index)
+{
+	KCBS_TRACE_SCOPE("DeterministicPlanValidityChecker::satisfiesConstraints");
+	const int constrained_robot = index.constrained_agent_;
+	for (std::size_t i = 0; i < states.size(); i++) {
+		// for every state along path, check the constraints at its step
+		const std::vector<ConstraintIndex::Entry> *entries = index.at(first_step + i);
+		if (!entries)
+			continue;
+		const RobotFootprint shape = getShapeFromState_(states[i], constrained_robot);
+		for (const ConstraintIndex::Entry &e: *entries) {
+			if (!RobotFootprint::disjoint(shape, e.constraint_->as<DeterministicConstraint>()->getShape(e.time_idx_)))
+				return false;
 		}
 	}
+	return true;
+}
+
+bool DeterministicPlanValidityChecker::nearConstraints(const std::vector<ob::State*> &states, const unsigned int first_step,
+	const unsigned int last_step, const ConstraintIndex &index) const
+{
+	if (!PlanValidityChecker::nearConstraints(states, first_step, last_step, index))
+		return false;
+	double min_x = std::numeric_limits<double>::infinity();
+	double max_x = -min_x, min_y = min_x, max_y = -min_x;
+	for (const ob::State *st: states) {
+		const RobotFootprint fp = getShapeFromState_(st, index.constrained_agent_);
+		min_x = std::min(min_x, fp.cx_ - fp.r_);
+		max_x = std::max(max_x, fp.cx_ + fp.r_);
+		min_y = std::min(min_y, fp.cy_ - fp.r_);
+		max_y = std::max(max_y, fp.cy_ + fp.r_);
+	}
+	// near as soon as a window is not disjoint from the box of the states (NaN boxes or margins never are)
+	return !index.forEachWindow(first_step, last_step, [&](const ConstraintIndex::Window &w) {
+		// padded for the rounding of the exact checks
+		const double m = w.margin_ * (1 + 1e-9) + 1e-12;
+		return w.min_x_ - max_x > m || min_x - w.max_x_ > m || w.min_y_ - max_y > m || min_y - w.max_y_ > m;
+	});
+}
+
+void DeterministicPlanValidityChecker::boundConstraint_(const Constraint &c, ConstraintIndex::Window &w) const
+{
+	PlanValidityChecker::boundConstraint_(c, w);
+	const std::vector<RobotFootprint> &shapes = c.as<DeterministicConstraint>()->getShapes();
+	if (shapes.empty())
+		return;
+	w.min_x_ = w.min_y_ = std::numeric_limits<double>::infinity();
+	w.max_x_ = w.max_y_ = -std::numeric_limits<double>::infinity();
+	for (const RobotFootprint &fp: shapes) {
+		w.min_x_ = std::min(w.min_x_, fp.minX());
+		w.max_x_ = std::max(w.max_x_, fp.maxX());
+		w.min_y_ = std::min(w.min_y_, fp.minY());
+		w.max_y_ = std::max(w.max_y_, fp.maxY());
+	}
+	w.margin_ = 0;
+}
+
+ConflictPtr DeterministicPlanValidityChecker::checkForConflicts_(const std::vector<std::pair<int, RobotFootprint>> &shapes, const int step, 
+	SweepAndPrune &broadphase)
+{
+	// shapes whose envelopes are disjoint are disjoint
+	broadphase.resize(shapes.size());
+	for (std::size_t ai = 0; ai < shapes.size(); ai++) {
+		const RobotFootprint &fp = shapes[ai].second;
+		broadphase.setBox(ai, fp.minX(), fp.maxX(), fp.minY(), fp.maxY());
+	}
+	for (const std::pair<int, int> &ij: broadphase.sweep()) {
+		if (!RobotFootprint::disjoint(shapes[ij.first].second, shapes[ij.second].second))
+			return std::make_shared<Conflict>(shapes[ij.first].first, shapes[ij.second].first, step);
+	}
+	return nullptr;
+}
+
+void DeterministicPlanValidityChecker::getActiveRobots_(const DiscretePlan &p, const int step,
+	std::vector<std::pair<int, RobotFootprint>> &shapes, const int a1, const int a2) const
+{
+	shapes.clear();
+	// once its trajectory ended, a robot stays at its last state
+	auto stateAt = [step](const oc::PathControl &traj) {
+		return (static_cast<std::size_t>(step) < traj.getStateCount()) ? traj.getState(step) : traj.getStates().back();
+	};
+	// using no pre-defined agent pair, return all robots
+	if (a1 == -1 || a2 == -1) {
+		for (std::size_t idx = 0; idx < p.size(); idx++)
+			shapes.emplace_back(idx, getShapeFromState_(stateAt(p[idx]), idx));
+	}
 	else {
-		// provided agent pair, return vector with only those two robots
-		if (step < p[a1].getStateCount()) {
-			Polygon robotShape1 = getShapeFromState_(p[a1].getState(step), a1);
-			activeRobots.emplace_back(a1, robotShape1);
-		}
-		else {
-			Polygon robotShape1 = getShapeFromState_(p[a1].getStates().back(), a1);
-			activeRobots.emplace_back(a1, robotShape1);
-		}
-		if (step < p[a2].getStateCount()) {
-			Polygon robotShape2 = getShapeFromState_(p[a2].getState(step), a2);
-			activeRobots.emplace_back(a2, robotShape2);
-		}
-		else {
-			Polygon robotShape2 = getShapeFromState_(p[a2].getStates().back(), a2);
-			activeRobots.emplace_back(a2, robotShape2);
-		}
+		// provided agent pair, return only those two robots
+		shapes.emplace_back(a1, getShapeFromState_(stateAt(p[a1]), a1));
+		shapes.emplace_back(a2, getShapeFromState_(stateAt(p[a2]), a2));
 	}
-	return activeRobots;
 }
 
-Polygon DeterministicPlanValidityChecker::getShapeFromState_(ob::State *st, const int robotIdx)
+RobotFootprint DeterministicPlanValidityChecker::getShapeFromState_(const ob::State *st, const int robotIdx) const
 {
 	auto compState = st->as<ob::CompoundStateSpace::StateType>();
 	auto xyState = compState->as<ob::RealVectorStateSpace::StateType>(0);
 	const double cx = xyState->values[0];
 	const double cy = xyState->values[1];
 	const double theta = compState->as<ob::SO2StateSpace::StateType>(1)->value;
-
-	// beta test: use boost transform instread of manual polygon creation
-    Polygon raw;
-    Polygon result;
-    Robot* r = mrmp_pdef_->getInstance()->getRobots()[robotIdx];
-    if (r->getDynamicsModel() != "FirstOrderCar" && 
-    	r->getDynamicsModel() != "SecondOrderCar" && 
-    	r->getDynamicsModel() != "SecondOrderUnicycle") {
-    		OMPL_WARN("%s: Dynamics Model may not be suitable for this PlanValidityChecker! Be sure to check.", name_.c_str());
-    }
-    Polygon initial = r->getShape();
-    const double ix = r->getStartLocation().x_;
-    const double iy = r->getStartLocation().y_;
-    bg::correct(raw);
-    bg::assign(raw, initial);
-    bg::strategy::transform::matrix_transformer<double, 2, 2> xfrm(
-             cos(theta), sin(theta), (cx - ix),
-            -sin(theta), cos(theta), (cy - iy),
-                      0,          0,  1);
-    bg::transform(raw, result, xfrm);
-    
-    return result;
+	return footprints_[robotIdx].transformed(cx, cy, theta);
 }
@@ -1,4 +1,6 @@
 #include "PlanValidityCheckers/MinkowskiSumBlackmorePVC.h"
+#include "utils/DiskGeometry.h"
+#include "utils/Trace.h"
 
 
 MinkowskiSumBlackmorePVC::MinkowskiSumBlackmorePVC(MultiRobotProblemDefinitionPtr pdef, const double p_safe):
@@ -7,98 +9,79 @@ MinkowskiSumBlackmorePVC::MinkowskiSumBlackmorePVC(MultiRobotProblemDefinitionPt
     int norm = (pdef->getInstance()->getRobots().size() - 1);
     p_coll_dist_ = p_coll_agnts_ / norm;
 
+    chance_scale_ = chanceScale_(p_coll_dist_);
+    if (norm > 0)
+        erf_inv_dist_ = bm::erf_inv(1 - (2 * p_coll_dist_));
+    kernel_scale_ = 2 * erf_inv_dist_ * erf_inv_dist_;
+
     std::vector<Robot*> robots = mrmp_pdef_->getInstance()->getRobots();
-    boost::tokenizer< boost::char_separator<char> >::iterator beg1;
-    boost::tokenizer< boost::char_separator<char> >::iterator beg2;
-    boost::char_separator<char> sep(" ");
-    for (auto itr1 = robots.begin(); itr1 != robots.end(); itr1++) {
-        std::string r1_name = (*itr1)->getName();
-        boost::tokenizer< boost::char_separator<char> > tok1(r1_name, sep);
-        beg1 = tok1.begin();
-        beg1++;
-        for (auto itr2 = itr1 + 1; itr2 != robots.end(); itr2++) {
-            std::string r2_name = (*itr2)->getName();
-            boost::tokenizer< boost::char_separator<char> > tok2(r2_name, sep);
-            beg2 = tok2.begin();
-            beg2++;
-            std::string key_name = (*beg1) + "," + (*beg2);
-            Polygon combined_poly = getMinkowskiSumOfRobots_(*itr1, *itr2);
-            std::pair<Eigen::MatrixXd, Eigen::MatrixXd> robot_pair_halfplanes = getHalfPlanes_(combined_poly);
-            halfPlane_map_.insert({key_name, robot_pair_halfplanes});
+    pair_half_planes_ = PairTable<QuadHalfPlanes>(robots.size());
+    pair_geometry_ = PairTable<PairGeometry>(robots.size());
+    for (std::size_t i1 = 0; i1 < robots.size(); i1++) {
+        for (std::size_t i2 = i1 + 1; i2 < robots.size(); i2++) {
+            const std::pair<Eigen::MatrixXd, Eigen::MatrixXd> robot_pair_halfplanes = getHalfPlanes_(getMinkowskiSumOfRobots_(robots[i1], robots[i2]));
+            pair_half_planes_(robots[i1]->getId(), robots[i2]->getId()) = QuadHalfPlanes(robot_pair_halfplanes.first, robot_pair_halfplanes.second);
+            PairGeometry &g = pair_geometry_(robots[i1]->getId(), robots[i2]->getId());
+            g = PairGeometry::fromHalfPlanes(robot_pair_halfplanes.first, robot_pair_halfplanes.second);
+            pair_shape_ = widerPairShape(pair_shape_, g.shape_);
         }
     }
+    selectKernels_();
 }
 
-std::vector<ConflictPtr> MinkowskiSumBlackmorePVC::validatePlan(Plan p)
+void MinkowskiSumBlackmorePVC::selectKernels_()
 {
-    std::vector<ConflictPtr> confs{};
-    const double step_duration = mrmp_pdef_->getSystemStepSize();
-
-    // interpolate all trajectories to the same discretization and get max size
-    int maxStates = 0;
-    for (auto itr = p.begin(); itr != p.end(); itr++) {
-        itr->interpolate();
-        if (maxStates < itr->getStateCount())
-            maxStates = itr->getStateCount();
+    const bool positive = (erf_inv_dist_ >= 0);
+    switch (pair_shape_) {
+        case PairShape::Point:
+            positive ? selectKernels_<PairShape::Point, true>() : selectKernels_<PairShape::Point, false>();
+            break;
+        case PairShape::Box:
+            positive ? selectKernels_<PairShape::Box, true>() : selectKernels_<PairShape::Box, false>();
+            break;
+        default:
+            positive ? selectKernels_<PairShape::Convex, true>() : selectKernels_<PairShape::Convex, false>();
     }
+}
 
-    for (int k = 0; k < maxStates; k++) {
-        std::map<std::string, Belief> activeRobots = getActiveRobots_(p, k);
-        ConflictPtr c = checkForConflicts_(activeRobots, k);
-        if (c) {
-            // found initial conflict at step k
-            // must continue to propogate forward until conflict is finished
-            int step = k;
-            while (c != nullptr && step < maxStates) {
-                confs.push_back(c);
-                step++;
-                activeRobots = getActiveRobots_(p, step, c->agent1Idx_, c->agent2Idx_);
-                c = checkForConflicts_(activeRobots, step);
-            }
-            return confs;
-        }
-    }
-    return {};
+template <PairShape Shape, bool Positive>
+void MinkowskiSumBlackmorePVC::selectKernels_()
+{
+    conflict_kernel_ = &MinkowskiSumBlackmorePVC::conflictKernel_<Shape, Positive>;
+    constraint_kernel_ = &MinkowskiSumBlackmorePVC::constraintKernel_<Shape, Positive>;
+    pair_kernel_ = &pairSafe<Shape, Positive>;
 }
 
-bool MinkowskiSumBlackmorePVC::satisfiesConstraints(oc::PathControl path, std::vector<ConstraintPtr> constraints)
+bool MinkowskiSumBlackmorePVC::satisfiesConstraints(const std::vector<ob::State*> &states, const unsigned int first_step, 
+    const ConstraintIndex &index)
+{
+    KCBS_TRACE_SCOPE("MinkowskiSumBlackmorePVC::satisfiesConstraints");
+    return (this->*constraint_kernel_)(states, first_step, index);
+}
+
+template <PairShape Shape, bool Positive>
+bool MinkowskiSumBlackmorePVC::constraintKernel_(const std::vector<ob::State*> &states, const unsigned int first_step,
+    const ConstraintIndex &index)
 {
     /* Assume that the constrained robot is the "planning" robot. Check for satisfaction of all constraints */
-    const int constrained_robot = constraints.front()->getConstrainedAgent();
-    std::vector<ob::State*> states = path.getStates();
-    const double step_size = path.getControlDuration(0);
-    double current_time = 0.0;
-    for (auto itr = states.begin(); itr != states.end(); itr++) {
-        // for every state along path, check if the time coincides with any constraints
-        for (auto c_itr = constraints.begin(); c_itr != constraints.end(); c_itr++) {
-            const std::vector<double> times = (*c_itr)->getTimes();
-            auto it = std::find_if(times.begin(), times.end(), 
-                [&current_time](const double& t) { return abs(t - current_time) < 1E-9;});
-            if (it == times.end()) {
-                continue;
-            }
+    for (std::size_t i = 0; i < states.size(); i++) {
+        // for every state along path, check the constraints at its step
+        const std::vector<ConstraintIndex::Entry> *entries = index.at(first_step + i);
+        if (!entries)
+            continue;
+        const BeliefConstraint::Record a = BeliefConstraint::Record::fromState(states[i], first_step + i);
+        for (const ConstraintIndex::Entry &e: *entries) {
             // must check this constraint at this time
-            const int constraining_robot = (*c_itr)->getConstrainingAgent();
-            assert(constrained_robot != constraining_robot);
-            
-            // get the correct half-plane for comparing constrained_robot with constraining_robot
-            std::string key_name = std::to_string(constrained_robot) + "," + std::to_string(constraining_robot);
-            if (halfPlane_map_.find(key_name) == halfPlane_map_.end())
-                key_name = std::to_string(constraining_robot) + "," + std::to_string(constrained_robot);
-
-            // get both beliefs
-            int idx = it - times.begin();
-            Belief constrained_robot_belief = getDistribution_(*itr);
-            Belief constraining_robot_belief = getDistribution_((*c_itr)->as<BeliefConstraint>()->getStates()[idx]);
+            assert(e.geometry_ && e.constraint_->getConstrainingAgent() != index.constrained_agent_);
 
-            // check if constraint is violated
-            Eigen::Vector2d mu_ab = constrained_robot_belief.first - constraining_robot_belief.first;
-            Eigen::Matrix2d Sigma_ab = constrained_robot_belief.second + constraining_robot_belief.second;
+            // belief of the constraining robot at this step
+            const BeliefConstraint::Record &b = e.constraint_->as<BeliefConstraint>()->getRecord(e.time_idx_);
 
-            if (!isSafe_(mu_ab, Sigma_ab, halfPlane_map_[key_name]))
+            // check if constraint is violated
+            if (!pairSafe<Shape, Positive>(*static_cast<const PairGeometry *>(e.geometry_), a.x_ - b.x_, a.y_ - b.y_,
+                a.s_xx_ + b.s_xx_, a.s_xy_ + b.s_xy_, a.s_yy_ + b.s_yy_, kernel_scale_))
                 return false;
         }
-        current_time += step_size;
     }
     return true;
 }
@@ -107,75 +90,75 @@ bool MinkowskiSumBlackmorePVC::independentCheck(ob::State* state1, ob::State* st
 {
     /* Only to be used for independent collision testing. Not called during MRMP planning (yet?) */
 
-    std::string key_name = "0,1";
-    if (halfPlane_map_.find(key_name) == halfPlane_map_.end())
-        key_name = "1,0";
-
     Belief r0_belief = getDistribution_(state1);
     Belief r1_belief = getDistribution_(state2);
 
     Eigen::Vector2d mu_ab = r0_belief.first - r1_belief.first;
     Eigen::Matrix2d Sigma_ab = r0_belief.second + r1_belief.second;
 
-    if (isSafe_(mu_ab, Sigma_ab, halfPlane_map_[key_name]))
+    if (isSafe_(mu_ab, Sigma_ab, pairHalfPlanes_(0, 1)))
         return true;
     return false;
 }
 
-ConflictPtr MinkowskiSumBlackmorePVC::checkForConflicts_(std::map<std::string, Belief> states_map, const int step)
+double MinkowskiSumBlackmorePVC::safeHalfWidth_(const int agent, const double max_lambda, const double max_sqrt_lambda) const
 {
-    ConflictPtr c = nullptr;
-    
-    boost::tokenizer< boost::char_separator<char> >::iterator beg_a;
-    boost::tokenizer< boost::char_separator<char> >::iterator beg_b;
-    boost::char_separator<char> sep(" ");
-
-    for (auto itr_a = states_map.begin(); itr_a != states_map.end(); itr_a++) {
-        // Belief for ai
-        const std::string r_a_name = itr_a->first;
-        boost::tokenizer< boost::char_separator<char> > tok_a(r_a_name, sep);
-        beg_a = tok_a.begin();
-        beg_a++;
-        const Eigen::Vector2d mu_a = (itr_a->second).first;
-        const Eigen::Matrix2d Sigma_a = (itr_a->second).second;
-        auto itr_b = itr_a;
-        std::advance(itr_b, 1);
-        for (; itr_b != states_map.end(); itr_b++) {
-            // Belief for aj
-            const std::string r_b_name = itr_b->first;
-            boost::tokenizer< boost::char_separator<char> > tok_b(r_b_name, sep);
-            beg_b = tok_b.begin();
-            beg_b++;
-            std::string key_name = (*beg_a) + "," + (*beg_b);
-            const Eigen::Vector2d mu_b = (itr_b->second).first;
-            const Eigen::Matrix2d Sigma_b = (itr_b->second).second;
-            const Eigen::Vector2d mu_ab = mu_a - mu_b;
-            const Eigen::Matrix2d Sigma_ab = Sigma_a + Sigma_b;
-
-            if (halfPlane_map_.find(key_name) == halfPlane_map_.end())
-                key_name = (*beg_b) + "," + (*beg_a);
-
-            if (!isSafe_(mu_ab, Sigma_ab, halfPlane_map_[key_name])) {
-                int a_idx = std::atoi((*beg_a).c_str());
-                int b_idx = std::atoi((*beg_b).c_str());
-                c = std::make_shared<Conflict>(a_idx, b_idx, step);
-                return c;
-            }
-        }
+    /* the Minkowski sum of a pair is its bounding box (radius r_a + r_b), so a pair whose means are further apart
+       along x or y than the sum of these is safe from the facing edge */
+    return bounding_radii_[agent] + chance_scale_ * max_sqrt_lambda;
+}
+
+bool MinkowskiSumBlackmorePVC::isPairSafe_(const int a, const Eigen::Vector2d &mu_a, const Eigen::Matrix2d &Sigma_a, const int b,
+    const Eigen::Vector2d &mu_b, const Eigen::Matrix2d &Sigma_b)
+{
+    const Eigen::Vector2d mu_ab = mu_a - mu_b;
+    const Eigen::Matrix2d Sigma_ab = Sigma_a + Sigma_b;
+    return pair_kernel_(pair_geometry_(a, b), mu_ab[0], mu_ab[1], Sigma_ab(0, 0), Sigma_ab(0, 1), Sigma_ab(1, 1), kernel_scale_);
+}
+
+ConflictPtr MinkowskiSumBlackmorePVC::checkForConflicts_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int step,
+    SweepAndPrune &broadphase)
+{
+    return (this->*conflict_kernel_)(beliefs, agents, step, broadphase);
+}
+
+template <PairShape Shape, bool Positive>
+ConflictPtr MinkowskiSumBlackmorePVC::conflictKernel_(const BeliefTrajectories &beliefs, const std::vector<int> &agents,
+    const int step, SweepAndPrune &broadphase)
+{
+    std::vector<double> half_widths(agents.size());
+    for (std::size_t i = 0; i < agents.size(); i++) {
+        const double max_lambda = maxEigenvalue2x2(beliefs.covariance(agents[i], step));
+        half_widths[i] = MinkowskiSumBlackmorePVC::safeHalfWidth_(agents[i], max_lambda, std::sqrt(std::max(max_lambda, 0.0)));
+    }
+    for (const std::pair<int, int> &ij: overlappingPairs_(broadphase, beliefs, agents, step, half_widths)) {
+        const int a = agents[ij.first];
+        const int b = agents[ij.second];
+        if (!pairSafe<Shape, Positive>(pair_geometry_(a, b), beliefs.x(a, step) - beliefs.x(b, step),
+            beliefs.y(a, step) - beliefs.y(b, step), beliefs.sigmaXX(a, step) + beliefs.sigmaXX(b, step),
+            beliefs.sigmaXY(a, step) + beliefs.sigmaXY(b, step), beliefs.sigmaYY(a, step) + beliefs.sigmaYY(b, step),
+            kernel_scale_))
+            return std::make_shared<Conflict>(a, b, step);
     }
-    return c;
+    return nullptr;
+}
+
+const QuadHalfPlanes &MinkowskiSumBlackmorePVC::pairHalfPlanes_(const int a, const int b) const
+{
+    return pair_half_planes_(a, b);
 }
 
-bool MinkowskiSumBlackmorePVC::isSafe_(const Eigen::Vector2d mu_ab, const Eigen::Matrix2d Sigma_ab, const std::pair<Eigen::MatrixXd, Eigen::MatrixXd> halfPlanes)
+bool MinkowskiSumBlackmorePVC::isSafe_(const Eigen::Vector2d &mu_ab, const Eigen::Matrix2d &Sigma_ab, const QuadHalfPlanes &halfPlanes)
 {
-    Eigen::MatrixXd A = halfPlanes.first;
-    Eigen::MatrixXd B = halfPlanes.second;
+    // this test is evaluated in double, whatever the scalar of the half-planes
+    const Eigen::Matrix<double, 4, 2> A = halfPlanes.A_.cast<double>();
+    const Eigen::Vector4d B = halfPlanes.B_.cast<double>();
 
     auto const n_rows = A.rows();
     for (int i = 0; i < n_rows; i++) {
         const double tmp = (A.row(i) * Sigma_ab * A.row(i).transpose()).value();
         const double Pv = sqrt(tmp);
-        const double vbar = sqrt(2) * Pv * bm::erf_inv(1 - (2 * p_coll_dist_));
+        const double vbar = sqrt(2) * Pv * erf_inv_dist_;
         if( (A(i, 0) * mu_ab[0] + A(i, 1) * mu_ab[1] - B(i, 0) >= vbar) ) {
             return true;
         };
@@ -0,0 +1,142 @@
+#include "PlanValidityCheckers/MonteCarloPVC.h"
+#include "utils/DiskGeometry.h"
+#include "utils/Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+MonteCarloPVC::MonteCarloPVC(MultiRobotProblemDefinitionPtr pdef, const double p_safe, const int max_samples,
+    const double indifference, const double error):
+    BeliefPVC(pdef, "MonteCarloPVC", p_safe), max_samples_(std::max(max_samples, 1))
+{
+    name_ = "MonteCarloPVC(" + std::to_string(max_samples) + ")";
+    chance_scale_ = chanceScale_(p_coll_agnts_);
+
+    double delta = indifference;
+    if (!(delta > 0 && delta < 1)) {
+        OMPL_WARN("%s: the indifference must be in (0, 1), not %f. Using 0.5.", name_.c_str(), indifference);
+        delta = 0.5;
+    }
+    double alpha = error;
+    if (!(alpha > 0 && alpha < 0.5)) {
+        OMPL_WARN("%s: the error must be in (0, 0.5), not %f. Using 0.01.", name_.c_str(), error);
+        alpha = 0.01;
+    }
+    // Wald's test of p0 (safe) against p1 (unsafe) around p_coll, with both errors alpha
+    const double p = std::min(std::max(p_coll_agnts_, 1e-12), 1 - 1e-12);
+    const double p0 = p * (1 - delta);
+    const double p1 = std::min(p * (1 + delta), 0.5 * (1 + p));
+    llr_hit_ = std::log(p1 / p0);
+    llr_miss_ = std::log((1 - p1) / (1 - p0));
+    accept_ = std::log(alpha / (1 - alpha));
+    reject_ = std::log((1 - alpha) / alpha);
+
+    std::vector<Robot*> robots = mrmp_pdef_->getInstance()->getRobots();
+    pair_reach_ = PairTable<double>(robots.size());
+    for (std::size_t i1 = 0; i1 < robots.size(); i1++) {
+        for (std::size_t i2 = i1 + 1; i2 < robots.size(); i2++)
+            pair_reach_(robots[i1]->getId(), robots[i2]->getId()) = robots[i1]->getBoundingRadius() + robots[i2]->getBoundingRadius();
+    }
+}
+
+bool MonteCarloPVC::satisfiesConstraints(const std::vector<ob::State*> &states, const unsigned int first_step,
+    const ConstraintIndex &index)
+{
+    KCBS_TRACE_SCOPE("MonteCarloPVC::satisfiesConstraints");
+    for (std::size_t i = 0; i < states.size(); i++) {
+        const std::vector<ConstraintIndex::Entry> *entries = index.at(first_step + i);
+        if (!entries)
+            continue;
+        const BeliefConstraint::Record constrained_robot_belief = BeliefConstraint::Record::fromState(states[i], first_step + i);
+        for (const ConstraintIndex::Entry &e: *entries) {
+            // a constraint is on another robot, whose geometry was resolved with the index
+            assert(e.geometry_ && e.constraint_->getConstrainingAgent() != index.constrained_agent_);
+            const BeliefConstraint::Record &constraining_robot_belief = e.constraint_->as<BeliefConstraint>()->getRecord(e.time_idx_);
+            if (!isSafe_(constrained_robot_belief.mean() - constraining_robot_belief.mean(),
+                    constrained_robot_belief.covariance() + constraining_robot_belief.covariance(),
+                    *static_cast<const double *>(e.geometry_)))
+                return false;
+        }
+    }
+    return true;
+}
+
+double MonteCarloPVC::safeHalfWidth_(const int agent, const double max_lambda, const double max_sqrt_lambda) const
+{
+    /* a pair further apart along x than r_ab + chance_scale sqrt(Sigma_ab,xx) is within reach along x with a probability
+       below p_coll, and sqrt(Sigma_ab,xx) <= sqrt(lambda_a) + sqrt(lambda_b) */
+    return bounding_radii_[agent] + chance_scale_ * max_sqrt_lambda;
+}
+
+bool MonteCarloPVC::isPairSafe_(const int a, const Eigen::Vector2d &mu_a, const Eigen::Matrix2d &Sigma_a, const int b,
+    const Eigen::Vector2d &mu_b, const Eigen::Matrix2d &Sigma_b)
+{
+    return isSafe_(mu_a - mu_b, Sigma_a + Sigma_b, pair_reach_(a, b));
+}
+
+ConflictPtr MonteCarloPVC::checkForConflicts_(const BeliefTrajectories &beliefs, const std::vector<int> &agents, const int step,
+    SweepAndPrune &broadphase)
+{
+    std::vector<double> half_widths(agents.size());
+    for (std::size_t i = 0; i < agents.size(); i++) {
+        const double max_lambda = maxEigenvalue2x2(beliefs.covariance(agents[i], step));
+        half_widths[i] = safeHalfWidth_(agents[i], max_lambda, std::sqrt(std::max(max_lambda, 0.0)));
+    }
+    for (const std::pair<int, int> &ij: overlappingPairs_(broadphase, beliefs, agents, step, half_widths)) {
+        const int a = agents[ij.first];
+        const int b = agents[ij.second];
+        if (!isSafe_(beliefs.mean(a, step) - beliefs.mean(b, step), beliefs.covariance(a, step) + beliefs.covariance(b, step), pair_reach_(a, b)))
+            return std::make_shared<Conflict>(a, b, step);
+    }
+    return nullptr;
+}
+
+bool MonteCarloPVC::independentCheck(ob::State* state1, ob::State* state2)
+{
+    /* Only to be used for independent collision testing */
+    Belief r0_belief = getDistribution_(state1);
+    Belief r1_belief = getDistribution_(state2);
+    return isSafe_(r0_belief.first - r1_belief.first, r0_belief.second + r1_belief.second, pair_reach_(0, 1));
+}
+
+bool MonteCarloPVC::isSafe_(const Eigen::Vector2d &mu_ab, const Eigen::Matrix2d &sigma_ab, const double reach) const
+{
+    if (!(p_coll_agnts_ > 0))
+        return false;
+    if (p_coll_agnts_ >= 1)
+        return true;
+    // closed-form Cholesky factor [l_11 0; l_21 l_22] of sigma_ab. A singular (or NaN) covariance never was safe
+    const double l_11 = std::sqrt(std::max(sigma_ab(0, 0), 0.0));
+    if (!(l_11 > 0) || !std::isfinite(l_11) || !std::isfinite(mu_ab[0]) || !std::isfinite(mu_ab[1]))
+        return false;
+    const double l_21 = 0.5 * (sigma_ab(0, 1) + sigma_ab(1, 0)) / l_11;
+    const double l_22_sq = sigma_ab(1, 1) - l_21 * l_21;
+    if (!(l_22_sq > 0) || !std::isfinite(l_22_sq))
+        return false;
+    const double l_22 = std::sqrt(l_22_sq);
+    const double mu_x = mu_ab[0], mu_y = mu_ab[1];
+
+    Random random = random_;
+    double z0[Random::lanes_], z1[Random::lanes_];
+    int hits = 0, n = 0;
+    while (n < max_samples_) {
+        for (int k = 0; k < test_every_; k += Random::lanes_) {
+            random.gaussian(z0, z1);
+            int block = 0;
+            for (std::size_t l = 0; l < Random::lanes_; l++) {
+                const double dx = mu_x + l_11 * z0[l];
+                const double dy = mu_y + l_21 * z0[l] + l_22 * z1[l];
+                block += (std::abs(dx) < reach) & (std::abs(dy) < reach);
+            }
+            hits += block;
+        }
+        n += test_every_;
+        const double llr = hits * llr_hit_ + (n - hits) * llr_miss_;
+        if (llr <= accept_)
+            return true;
+        if (llr >= reject_)
+            return false;
+    }
+    return hits < p_coll_agnts_ * n;
+}
@@ -0,0 +1,187 @@
+#include "PlanValidityCheckers/PlanValidityChecker.h"
+#include "utils/Trace.h"
+#include <algorithm>
+#include <cmath>
+
+
+ConstraintIndexPtr PlanValidityChecker::indexConstraints(const std::vector<ConstraintPtr> &constraints) const
+{
+    auto index = std::make_shared<ConstraintIndex>();
+    index->constraints_ = constraints;
+    if (constraints.empty())
+        return index;
+    index->constrained_agent_ = constraints.front()->getConstrainedAgent();
+    index->first_step_ = std::numeric_limits<unsigned int>::max();
+    const double step_size = mrmp_pdef_->getSystemStepSize();
+    for (const ConstraintPtr &c: constraints) {
+        // the steps of a positive constraint go to an index of its own
+        std::shared_ptr<ConstraintIndex> positive;
+        if (c->isPositive()) {
+            positive = std::make_shared<ConstraintIndex>();
+            positive->constraints_ = {c};
+            positive->constrained_agent_ = index->constrained_agent_;
+        }
+        ConstraintIndex &steps = positive ? *positive : *index;
+        const std::vector<double> &times = c->getTimes();
+        const void *geometry = pairGeometry_(index->constrained_agent_, c->getConstrainingAgent());
+        ConstraintIndex::Window w{c.get(), std::numeric_limits<unsigned int>::max(), 0};
+        for (std::size_t i = 0; i < times.size(); i++) {
+            const long step = std::lround(times[i] / step_size);
+            if (step < 0)
+                continue;
+            if (steps.steps_.size() <= static_cast<std::size_t>(step))
+                steps.steps_.resize(step + 1);
+            steps.steps_[step].push_back({c.get(), i, geometry});
+            w.first_step_ = std::min<unsigned int>(w.first_step_, step);
+            w.last_step_ = std::max<unsigned int>(w.last_step_, step);
+        }
+        if (w.first_step_ > w.last_step_)
+            continue;
+        if (positive) {
+            // away from the region is where a positive constraint is violated, so its window here is anywhere
+            ConstraintIndex::Window anywhere = w;
+            PlanValidityChecker::boundConstraint_(*c, anywhere);
+            index->windows_.push_back(anywhere);
+            boundConstraint_(*c, w);
+            positive->windows_.push_back(w);
+            positive->max_last_.push_back(w.last_step_);
+            positive->first_step_ = w.first_step_;
+            positive->last_step_ = w.last_step_;
+            index->positives_.push_back(positive);
+        }
+        else {
+            boundConstraint_(*c, w);
+            index->windows_.push_back(w);
+        }
+        index->first_step_ = std::min(index->first_step_, w.first_step_);
+        index->last_step_ = std::max(index->last_step_, w.last_step_);
+    }
+    std::stable_sort(index->windows_.begin(), index->windows_.end(),
+        [](const ConstraintIndex::Window &a, const ConstraintIndex::Window &b) {return a.first_step_ < b.first_step_;});
+    index->max_last_.resize(index->windows_.size());
+    for (std::size_t k = 0; k < index->windows_.size(); k++)
+        index->max_last_[k] = std::max(index->windows_[k].last_step_, (k > 0) ? index->max_last_[k - 1] : 0u);
+    return index;
+}
+
+bool PlanValidityChecker::nearConstraints(const std::vector<ompl::base::State*> &states, const unsigned int first_step,
+    const unsigned int last_step, const ConstraintIndex &index) const
+{
+    return !states.empty() && first_step <= last_step && index.overlaps(first_step, last_step);
+}
+
+bool PlanValidityChecker::checkConstraints(const std::vector<ompl::base::State*> &states, const unsigned int first_step,
+    const ConstraintIndex &index)
+{
+    if (states.empty())
+        return true;
+    if (nearConstraints(states, first_step, index) && !satisfiesConstraints(states, first_step, index))
+        return false;
+    // a positive constraint holds at a step where its negative one does not
+    const unsigned int last_step = first_step + states.size() - 1;
+    for (const ConstraintIndexPtr &positive: index.positives_) {
+        const unsigned int first = std::max(first_step, positive->first_step_);
+        const unsigned int last = std::min(last_step, positive->last_step_);
+        for (unsigned int step = first; step <= last && first <= last; step++) {
+            if (positive->at(step) && satisfiesConstraints({states[step - first_step]}, step, *positive))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool PlanValidityChecker::satisfiesFinalConstraints(ompl::base::State *st, const unsigned int step, const ConstraintIndex &index)
+{
+    for (const ConstraintIndexPtr &positive: index.positives_) {
+        for (unsigned int s = std::max(step + 1, positive->first_step_); s <= positive->last_step_; s++) {
+            if (positive->at(s) && satisfiesConstraints({st}, s, *positive))
+                return false;
+        }
+    }
+    return true;
+}
+
+void PlanValidityChecker::boundConstraint_(const Constraint &c, ConstraintIndex::Window &w) const
+{
+    w.min_x_ = w.max_x_ = w.min_y_ = w.max_y_ = std::numeric_limits<double>::quiet_NaN();
+    w.margin_ = std::numeric_limits<double>::infinity();
+}
+
+int PlanValidityChecker::windowSteps_(const DiscretePlan &p) const
+{
+    const int max_states = p.getMaxStateCount();
+    if (!std::isfinite(window_))
+        return max_states;
+    const int window_steps = std::floor(std::max(window_, 0.0) / mrmp_pdef_->getSystemStepSize()) + 1;
+    return std::min(max_states, window_steps);
+}
+
+void PlanValidityChecker::updateCache_(const DiscretePlan &p, const int changed_agent, ValidationCache &cache,
+    const std::vector<int> &agents, const bool all)
+{
+    std::vector<bool> active(p.size(), agents.empty());
+    for (const int a: agents)
+        active[a] = true;
+
+    const int maxStates = windowSteps_(p);
+
+    // conflicts may be extended until the end of the plan, so a new horizon invalidates every pair
+    const bool full_check = (changed_agent < 0 || cache.max_states_ != maxStates || cache.pairs_.empty() || 
+        (all && !cache.all_intervals_));
+    cache.max_states_ = maxStates;
+    // (a cache of every interval stays one, its first intervals are those of validatePair_)
+    cache.all_intervals_ = all || (cache.all_intervals_ && !full_check);
+
+    for (int a1 = 0; a1 < p.size(); a1++) {
+        for (int a2 = a1 + 1; a2 < p.size(); a2++) {
+            if (!active[a1] || !active[a2])
+                continue;
+            if (full_check || a1 == changed_agent || a2 == changed_agent) {
+                if (cache.all_intervals_)
+                    cache.pairs_[{a1, a2}] = validatePairAll_(p, a1, a2, maxStates);
+                else {
+                    std::vector<ConflictPtr> first = validatePair_(p, a1, a2, maxStates);
+                    std::vector<std::vector<ConflictPtr>> &intervals = cache.pairs_[{a1, a2}];
+                    intervals.clear();
+                    if (!first.empty())
+                        intervals.push_back(std::move(first));
+                }
+            }
+        }
+    }
+}
+
+std::vector<ConflictPtr> PlanValidityChecker::validatePlanIncremental(const DiscretePlan &p, const int changed_agent, ValidationCache &cache, 
+    const std::vector<int> &agents)
+{
+    KCBS_TRACE_SCOPE("PlanValidityChecker::validatePlanIncremental");
+    updateCache_(p, changed_agent, cache, agents, false);
+
+    // report the earliest conflict interval of all pairs
+    const std::vector<ConflictPtr> *first = nullptr;
+    for (auto itr = cache.pairs_.begin(); itr != cache.pairs_.end(); itr++) {
+        if (itr->second.empty())
+            continue;
+        const std::vector<ConflictPtr> &interval = itr->second.front();
+        if (!first || interval.front()->timeStep_ < first->front()->timeStep_)
+            first = &interval;
+    }
+    if (first)
+        return *first;
+    return {};
+}
+
+std::vector<std::vector<ConflictPtr>> PlanValidityChecker::validatePlanAll(const DiscretePlan &p, const int changed_agent,
+    ValidationCache &cache, const std::vector<int> &agents)
+{
+    KCBS_TRACE_SCOPE("PlanValidityChecker::validatePlanAll");
+    updateCache_(p, changed_agent, cache, agents, true);
+
+    std::vector<std::vector<ConflictPtr>> intervals;
+    for (auto itr = cache.pairs_.begin(); itr != cache.pairs_.end(); itr++)
+        intervals.insert(intervals.end(), itr->second.begin(), itr->second.end());
+    // by first step, the pairs (in the order of the map) break ties
+    std::stable_sort(intervals.begin(), intervals.end(), [](const std::vector<ConflictPtr> &i1, const std::vector<ConflictPtr> &i2)
+        {return i1.front()->timeStep_ < i2.front()->timeStep_;});
+    return intervals;
+}
@@ -1,15 +1,16 @@
 #include "Planners/BSST.h"
+#include "utils/SegmentPropagation.h"
 
 ompl::control::BSST::BSST(const SpaceInformationPtr &si) : base::Planner(si, "BSST")
 {
 
     specs_.approximateSolutions = true;
     siC_ = si.get();
-    prevSolution_.clear();
-    prevSolutionControls_.clear();
-    prevSolutionSteps_.clear();
+    motion_arena_.setAccounting(alloc::MOTIONS);
+    witness_arena_.setAccounting(alloc::MOTIONS);
 
     Planner::declareParam<double>("goal_bias", this, &BSST::setGoalBias, &BSST::getGoalBias, "0.:.05:1.");
+    Planner::declareParam<double>("heuristic_bias", this, &BSST::setHeuristicBias, &BSST::getHeuristicBias, "0.:.05:1.");
     Planner::declareParam<double>("selection_radius", this, &BSST::setSelectionRadius, &BSST::getSelectionRadius, "0.:.1:"
                                                                                                                 "100");
     Planner::declareParam<double>("pruning_radius", this, &BSST::setPruningRadius, &BSST::getPruningRadius, "0.:.1:100");
@@ -23,18 +24,28 @@ ompl::control::BSST::~BSST()
 void ompl::control::BSST::setup()
 {
     base::Planner::setup();
+    /* the selection radius bounds the squared distance, so a cell spans one radius of the mean */
     if (!nn_)
-        nn_.reset(tools::SelfConfig::getDefaultNearestNeighbors<Motion *>(this));
+    {
+        std::shared_ptr<NearestNeighbors<Motion *>> nn(tools::getBeliefNearestNeighbors<Motion *>(this, std::sqrt(selectionRadius_)));
+        if (!nn)
+            nn.reset(tools::SelfConfig::getDefaultNearestNeighbors<Motion *>(this));
+        nn_ = withTombstones_(std::move(nn));
+    }
     nn_->setDistanceFunction([this](const Motion *a, const Motion *b)
                              {
                                  return distanceFunction(a, b);
                              });
+    /* the witnesses are only looked up within the pruning radius, so a cell spans the reach of that radius */
+    if (!witnesses_)
+        witnesses_.reset(tools::getWitnessNearestNeighbors<Motion *>(this, std::sqrt(pruningRadius_)));
     if (!witnesses_)
         witnesses_.reset(tools::SelfConfig::getDefaultNearestNeighbors<Motion *>(this));
     witnesses_->setDistanceFunction([this](const Motion *a, const Motion *b)
                                     {
                                         return distanceFunction(a, b);
                                     });
+    witness_grid_ = dynamic_cast<NearestNeighborsHashGrid<Motion *> *>(witnesses_.get());
     if (pdef_)
     {
         if (pdef_->hasOptimizationObjective())
@@ -72,6 +83,9 @@ void ompl::control::BSST::clear()
         witnesses_->clear();
     if (opt_)
         prevSolutionCost_ = opt_->infiniteCost();
+    if (heuristic_)
+        heuristic_->reset();
+    reachableCovariance_.reset();
 }
 
 void ompl::control::BSST::freeMemory()
@@ -86,31 +100,77 @@ void ompl::control::BSST::freeMemory()
                 si_->freeState(motion->state_);
             if (motion->control_)
                 siC_->freeControl(motion->control_);
-            delete motion;
         }
+        // the removed motions that were not purged yet go to the pool
+        nn_->clear();
+    }
+    for (auto &motion : motion_pool_)
+    {
+        si_->freeState(motion->state_);
+        siC_->freeControl(motion->control_);
     }
+    motion_pool_.clear();
     if (witnesses_)
     {
         std::vector<Motion *> witnesses;
         witnesses_->list(witnesses);
         for (auto &witness : witnesses)
         {
-            delete witness;
+            if (witness->state_)
+                si_->freeState(witness->state_);
+            if (witness->control_)
+                siC_->freeControl(witness->control_);
         }
     }
-    for (auto &i : prevSolution_)
-    {
-        if (i)
-            si_->freeState(i);
-    }
-    prevSolution_.clear();
-    for (auto &prevSolutionControl : prevSolutionControls_)
-    {
-        if (prevSolutionControl)
-            siC_->freeControl(prevSolutionControl);
-    }
-    prevSolutionControls_.clear();
-    prevSolutionSteps_.clear();
+    /* the states are returned to their space, the motions themselves are released in bulk */
+    motion_arena_.release();
+    witness_arena_.release();
+    prevSolution_ = nullptr;
+}
+
+void ompl::control::BSST::pinSolution_(Motion *motion)
+{
+    if (prevSolution_)
+        prevSolution_->pinned_ = false;
+    prevSolution_ = motion;
+    if (prevSolution_)
+        prevSolution_->pinned_ = true;
+}
+
+std::shared_ptr<ompl::control::PathControl> ompl::control::BSST::solutionPath_() const
+{
+    /* the branch is walked from the end of the solution back to its start */
+    std::vector<const Motion *> branch;
+    for (const Motion *m = prevSolution_; m != nullptr; m = m->parent_)
+        branch.push_back(m);
+    auto path(std::make_shared<PathControl>(si_));
+    for (std::size_t i = branch.size() - 1; i > 0; --i)
+        path->append(branch[i]->state_, branch[i - 1]->control_, branch[i - 1]->steps_ * siC_->getPropagationStepSize());
+    path->append(branch.front()->state_);
+    return path;
+}
+
+std::shared_ptr<ompl::NearestNeighbors<ompl::control::BSST::Motion *>> 
+ompl::control::BSST::withTombstones_(std::shared_ptr<NearestNeighbors<Motion *>> nn)
+{
+    return std::make_shared<NearestNeighborsTombstones<Motion *>>(std::move(nn), [this](Motion *const &m)
+                                                                  {
+                                                                      motion_pool_.push_back(m);
+                                                                  });
+}
+
+ompl::control::BSST::Motion *ompl::control::BSST::allocMotion_()
+{
+    if (motion_pool_.empty())
+        return motion_arena_.create(siC_);
+    Motion *motion = motion_pool_.back();
+    motion_pool_.pop_back();
+    base::State *state = motion->state_;
+    Control *control = motion->control_;
+    *motion = Motion();
+    motion->state_ = state;
+    motion->control_ = control;
+    return motion;
 }
 
 ompl::control::BSST::Motion *ompl::control::BSST::selectNode(ompl::control::BSST::Motion *sample)
@@ -129,44 +189,33 @@ ompl::control::BSST::Motion *ompl::control::BSST::selectNode(ompl::control::BSST
             selected = i;
         }
     }
+    // a motion leaves nn_ as soon as it is deactivated, so the nearest motion is always selectable
     if (selected == nullptr)
-    {
-        
-        int k = 1;
-        while (selected == nullptr)
-        {
-            nn_->nearestK(sample, k, ret);
-            for (unsigned int i = 0; i < ret.size() && selected == nullptr; i++)
-                if (!ret[i]->inactive_)
-                    selected = ret[i];
-            k += 5;
-        }
-    }
+        selected = nn_->nearest(sample);
     return selected;
 }
 
+ompl::control::BSST::Witness *ompl::control::BSST::witnessWithin_(Motion *node) const
+{
+    if (witness_grid_)
+        return static_cast<Witness *>(witness_grid_->nearestWithin(node, pruningRadius_));
+    if (witnesses_->size() == 0)
+        return nullptr;
+    auto *closest = static_cast<Witness *>(witnesses_->nearest(node));
+    return (distanceFunction(closest, node) > pruningRadius_) ? nullptr : closest;
+}
+
 ompl::control::BSST::Witness *ompl::control::BSST::findClosestWitness(ompl::control::BSST::Motion *node)
 {
-    if (witnesses_->size() > 0)
+    Witness *closest = witnessWithin_(node);
+    if (closest == nullptr)
     {
-        auto *closest = static_cast<Witness *>(witnesses_->nearest(node));
-        if (distanceFunction(closest, node) > pruningRadius_)
-        {
-            closest = new Witness(siC_);
-            closest->linkRep(node);
-            si_->copyState(closest->state_, node->state_);
-            witnesses_->add(closest);
-        }
-        return closest;
-    }
-    else
-    {
-        auto *closest = new Witness(siC_);
+        closest = witness_arena_.create(siC_);
         closest->linkRep(node);
         si_->copyState(closest->state_, node->state_);
         witnesses_->add(closest);
-        return closest;
     }
+    return closest;
 }
 
 ompl::base::PlannerStatus ompl::control::BSST::solve(const base::PlannerTerminationCondition &ptc)
@@ -177,10 +226,12 @@ ompl::base::PlannerStatus ompl::control::BSST::solve(const base::PlannerTerminat
 
     while (const base::State *st = pis_.nextStart())
     {
-        auto *motion = new Motion(siC_);
+        auto *motion = motion_arena_.create(siC_);
         si_->copyState(motion->state_, st);
         siC_->nullControl(motion->control_);
         nn_->add(motion);
+        if (heuristic_)
+            heuristic_->update(motion->state_);
         motion->accCost_ = opt_->identityCost();
         findClosestWitness(motion);
     }
@@ -195,6 +246,10 @@ ompl::base::PlannerStatus ompl::control::BSST::solve(const base::PlannerTerminat
         sampler_ = si_->allocStateSampler();
     if (!controlSampler_)
         controlSampler_ = siC_->allocControlSampler();
+    if (!covarianceSampler_ && !reachableCovariance_)
+        reachableCovariance_ = std::make_shared<ReachableCovarianceSampler>(siC_, pdef_->getStartState(0),
+            20 * siC_->getMaxControlDuration());
+    const CovarianceSampler &covarianceSampler = covarianceSampler_ ? *covarianceSampler_ : *reachableCovariance_;
 
     OMPL_INFORM("%s: Starting planning with %u states already in datastructure\n", getName().c_str(), nn_->size());
 
@@ -203,10 +258,11 @@ ompl::base::PlannerStatus ompl::control::BSST::solve(const base::PlannerTerminat
     double approxdif = std::numeric_limits<double>::infinity();
     bool sufficientlyShort = false;
 
-    auto *rmotion = new Motion(siC_);
+    auto *rmotion = motion_arena_.create(siC_);
     base::State *rstate = rmotion->state_;
     Control *rctrl = rmotion->control_;
     base::State *xstate = si_->allocState();
+    SegmentPropagation propagation(siC_);
 
     unsigned iterations = 0;
 
@@ -217,8 +273,11 @@ ompl::base::PlannerStatus ompl::control::BSST::solve(const base::PlannerTerminat
         /* sample random state (with goal biasing) */
         if (goal_s && rng_.uniform01() < goalBias_ && goal_s->canSample())
             goal_s->sampleGoal(rstate);
+        else if (heuristic_)
+            heuristic_->sample(*sampler_, rng_, heuristicBias_, rstate);
         else
             sampler_->sampleUniform(rstate);
+        covarianceSampler.sample(rng_, rstate);
 
         /* find closest state in the tree */
         Motion *nmotion = selectNode(rmotion);
@@ -226,7 +285,7 @@ ompl::base::PlannerStatus ompl::control::BSST::solve(const base::PlannerTerminat
         /* sample a random control that attempts to go towards the random state, and also sample a control duration */
         controlSampler_->sample(rctrl);
         unsigned int cd = rng_.uniformInt(siC_->getMinControlDuration(), siC_->getMaxControlDuration());
-        unsigned int propCd = siC_->propagateWhileValid(nmotion->state_, rctrl, cd, rstate);
+        unsigned int propCd = propagation.propagateWhileValid(nmotion->state_, rctrl, cd, rstate);
 
         if (propCd == cd)
         {
@@ -238,7 +297,7 @@ ompl::base::PlannerStatus ompl::control::BSST::solve(const base::PlannerTerminat
             {
                 Motion *oldRep = closestWitness->rep_;
                 /* create a motion */
-                auto *motion = new Motion(siC_);
+                auto *motion = allocMotion_();
                 motion->accCost_ = cost;
                 motion->state_->as<RealVectorBeliefSpace::StateType>()->setCost(cost.value());
                 si_->copyState(motion->state_, rmotion->state_);
@@ -249,6 +308,8 @@ ompl::base::PlannerStatus ompl::control::BSST::solve(const base::PlannerTerminat
                 closestWitness->linkRep(motion);
 
                 nn_->add(motion);
+                if (heuristic_)
+                    heuristic_->update(motion->state_);
 
                 // if (DISTANCE_FUNC_ == 0){
                 //     if (motion->state_->as<RealVectorBeliefSpaceEuclidean::StateType>()->getCovariance()(0,0) > max_eigenvalue_)
@@ -286,25 +347,7 @@ ompl::base::PlannerStatus ompl::control::BSST::solve(const base::PlannerTerminat
                     approxdif = dist;
                     solution = motion;
 
-                    for (auto &i : prevSolution_)
-                        if (i)
-                            si_->freeState(i);
-                    prevSolution_.clear();
-                    for (auto &prevSolutionControl : prevSolutionControls_)
-                        if (prevSolutionControl)
-                            siC_->freeControl(prevSolutionControl);
-                    prevSolutionControls_.clear();
-                    prevSolutionSteps_.clear();
-
-                    Motion *solTrav = solution;
-                    while (solTrav->parent_ != nullptr)
-                    {
-                        prevSolution_.push_back(si_->cloneState(solTrav->state_));
-                        prevSolutionControls_.push_back(siC_->cloneControl(solTrav->control_));
-                        prevSolutionSteps_.push_back(solTrav->steps_);
-                        solTrav = solTrav->parent_;
-                    }
-                    prevSolution_.push_back(si_->cloneState(solTrav->state_));
+                    pinSolution_(solution);
                     prevSolutionCost_ = solution->accCost_;
 
                     OMPL_INFORM("Found solution with cost %.2f", solution->accCost_.value());
@@ -317,45 +360,18 @@ ompl::base::PlannerStatus ompl::control::BSST::solve(const base::PlannerTerminat
                     approxdif = dist;
                     approxsol = motion;
 
-                    for (auto &i : prevSolution_)
-                        if (i)
-                            si_->freeState(i);
-                    prevSolution_.clear();
-                    for (auto &prevSolutionControl : prevSolutionControls_)
-                        if (prevSolutionControl)
-                            siC_->freeControl(prevSolutionControl);
-                    prevSolutionControls_.clear();
-                    prevSolutionSteps_.clear();
-
-                    Motion *solTrav = approxsol;
-                    while (solTrav->parent_ != nullptr)
-                    {
-                        prevSolution_.push_back(si_->cloneState(solTrav->state_));
-                        prevSolutionControls_.push_back(siC_->cloneControl(solTrav->control_));
-                        prevSolutionSteps_.push_back(solTrav->steps_);
-                        solTrav = solTrav->parent_;
-                    }
-                    prevSolution_.push_back(si_->cloneState(solTrav->state_));
+                    pinSolution_(approxsol);
                 }
 
                 if (oldRep != rmotion)
                 {
-                    while (oldRep->inactive_ && oldRep->numChildren_ == 0)
+                    while (oldRep->inactive_ && oldRep->numChildren_ == 0 && !oldRep->pinned_)
                     {
                         oldRep->inactive_ = true;
+                        // recycled once nn_ purges it
                         nn_->remove(oldRep);
-
-                        if (oldRep->state_)
-                            si_->freeState(oldRep->state_);
-                        if (oldRep->control_)
-                            siC_->freeControl(oldRep->control_);
-
-                        oldRep->state_ = nullptr;
-                        oldRep->control_ = nullptr;
                         oldRep->parent_->numChildren_--;
-                        Motion *oldRepParent = oldRep->parent_;
-                        delete oldRep;
-                        oldRep = oldRepParent;
+                        oldRep = oldRep->parent_;
                     }
                 }
             }
@@ -374,11 +390,7 @@ ompl::base::PlannerStatus ompl::control::BSST::solve(const base::PlannerTerminat
     if (solution != nullptr)
     {
         /* set the solution path */
-        auto path(std::make_shared<oc::PathControl>(si_));
-        for (int i = prevSolution_.size() - 1; i >= 1; --i)
-            path->append(prevSolution_[i], prevSolutionControls_[i - 1],
-                         prevSolutionSteps_[i - 1] * siC_->getPropagationStepSize());
-        path->append(prevSolution_[0]);
+        auto path = solutionPath_();
         solved = true;
         pdef_->addSolutionPath(path, approximate, approxdif, getName());
     }
@@ -388,7 +400,7 @@ ompl::base::PlannerStatus ompl::control::BSST::solve(const base::PlannerTerminat
         si_->freeState(rmotion->state_);
     if (rmotion->control_)
         siC_->freeControl(rmotion->control_);
-    delete rmotion;
+    motion_arena_.destroy(rmotion);
 
     OMPL_INFORM("%s: Created %u states in %u iterations", getName().c_str(), nn_->size(), iterations);
 
@@ -421,8 +433,8 @@ void ompl::control::BSST::getPlannerData(base::PlannerData &data) const
 
     double delta = siC_->getPropagationStepSize();
 
-    if (prevSolution_.size() != 0)
-        data.addGoalVertex(base::PlannerDataVertex(prevSolution_[0]));
+    if (prevSolution_)
+        data.addGoalVertex(base::PlannerDataVertex(prevSolution_->state_));
 
     for (auto m : allMotions)
     {
@@ -466,8 +478,8 @@ void ompl::control::BSST::getPlannerDataAndCosts(base::PlannerData &data, std::v
 
     double delta = siC_->getPropagationStepSize();
 
-    if (prevSolution_.size() != 0)
-        data.addGoalVertex(base::PlannerDataVertex(prevSolution_[0]));
+    if (prevSolution_)
+        data.addGoalVertex(base::PlannerDataVertex(prevSolution_->state_));
 
     for (auto m : allMotions)
     {
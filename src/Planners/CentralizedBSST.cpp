@@ -7,9 +7,8 @@ ompl::control::CentralizedBSST::CentralizedBSST(const SpaceInformationPtr &si, c
 
     specs_.approximateSolutions = true;
     siC_ = si.get();
-    prevSolution_.clear();
-    prevSolutionControls_.clear();
-    prevSolutionSteps_.clear();
+    motion_arena_.setAccounting(alloc::MOTIONS);
+    witness_arena_.setAccounting(alloc::MOTIONS);
 
     Planner::declareParam<double>("goal_bias", this, &CentralizedBSST::setGoalBias, &CentralizedBSST::getGoalBias, "0.:.05:1.");
     Planner::declareParam<double>("selection_radius", this, &CentralizedBSST::setSelectionRadius, &CentralizedBSST::getSelectionRadius, "0.:.1:"
@@ -25,18 +24,41 @@ ompl::control::CentralizedBSST::~CentralizedBSST()
 void ompl::control::CentralizedBSST::setup()
 {
     base::Planner::setup();
+    if (!propagation_)
+        propagation_.reset(new AgentDecoupledPropagation(siC_, [this](const base::State *from, const std::vector<bool> &active, base::State *to) {
+            const auto *start = from->as<RealVectorBeliefSpace::StateType>();
+            auto *destination = to->as<RealVectorBeliefSpace::StateType>();
+            for (int a = 0; a < num_agents_; a++) {
+                if (active[a])
+                    continue;
+                destination->values[dim_ * a] = start->values[dim_ * a];
+                destination->values[dim_ * a + 1] = start->values[dim_ * a + 1];
+                destination->sigmaBlock(a) = start->sigmaBlock(a);
+                destination->lambdaBlock(a) = start->lambdaBlock(a);
+            }
+        }));
+    /* the selection radius bounds the squared distance, so a cell spans one radius of the mean */
     if (!nn_)
-        nn_.reset(tools::SelfConfig::getDefaultNearestNeighbors<Motion *>(this));
+    {
+        std::shared_ptr<NearestNeighbors<Motion *>> nn(tools::getBeliefNearestNeighbors<Motion *>(this, std::sqrt(selectionRadius_)));
+        if (!nn)
+            nn.reset(tools::SelfConfig::getDefaultNearestNeighbors<Motion *>(this));
+        nn_ = withTombstones_(std::move(nn));
+    }
     nn_->setDistanceFunction([this](const Motion *a, const Motion *b)
                              {
                                  return distanceFunction(a, b);
                              });
+    /* the witnesses are only looked up within the pruning radius, so a cell spans the reach of that radius */
+    if (!witnesses_)
+        witnesses_.reset(tools::getWitnessNearestNeighbors<Motion *>(this, std::sqrt(pruningRadius_)));
     if (!witnesses_)
         witnesses_.reset(tools::SelfConfig::getDefaultNearestNeighbors<Motion *>(this));
     witnesses_->setDistanceFunction([this](const Motion *a, const Motion *b)
                                     {
                                         return distanceFunction(a, b);
                                     });
+    witness_grid_ = dynamic_cast<NearestNeighborsHashGrid<Motion *> *>(witnesses_.get());
     if (pdef_)
     {
         if (pdef_->hasOptimizationObjective())
@@ -74,6 +96,7 @@ void ompl::control::CentralizedBSST::clear()
         witnesses_->clear();
     if (opt_)
         prevSolutionCost_ = opt_->infiniteCost();
+    reachableCovariance_.reset();
 }
 
 void ompl::control::CentralizedBSST::freeMemory()
@@ -88,71 +111,93 @@ void ompl::control::CentralizedBSST::freeMemory()
                 si_->freeState(motion->state_);
             if (motion->control_)
                 siC_->freeControl(motion->control_);
-            delete motion;
         }
+        // the removed motions that were not purged yet go to the pool
+        nn_->clear();
     }
+    for (auto &motion : motion_pool_)
+    {
+        si_->freeState(motion->state_);
+        siC_->freeControl(motion->control_);
+    }
+    motion_pool_.clear();
     if (witnesses_)
     {
         std::vector<Motion *> witnesses;
         witnesses_->list(witnesses);
         for (auto &witness : witnesses)
         {
-            delete witness;
+            if (witness->state_)
+                si_->freeState(witness->state_);
+            if (witness->control_)
+                siC_->freeControl(witness->control_);
         }
     }
-    for (auto &i : prevSolution_)
-    {
-        if (i)
-            si_->freeState(i);
-    }
-    prevSolution_.clear();
-    for (auto &prevSolutionControl : prevSolutionControls_)
-    {
-        if (prevSolutionControl)
-            siC_->freeControl(prevSolutionControl);
-    }
-    prevSolutionControls_.clear();
-    prevSolutionSteps_.clear();
+    /* the states are returned to their space, the motions themselves are released in bulk */
+    motion_arena_.release();
+    witness_arena_.release();
+    prevSolution_ = nullptr;
 }
 
-unsigned int ompl::control::CentralizedBSST::multiAgentControlSampler(Control *rcontrol, Control *previous, 
-    const base::State *source, base::State *dest)
-{
-    // // determine which agents are already in goal
-    // auto g = getProblemDefinition()->getGoal()->as<CentralizedCCGoal>();
-    // // std::vector<int> idxInGoal = g->isInGoal(source);
-
-    // // // propogate as normal
-    // // /* sample a random control that attempts to go towards the random state, and also sample a control duration */
-    // unsigned int cd = controlSampler_->sampleTo(rcontrol, previous, source, dest);
-    // // /* override destination for agents already in goal */
-    // // overrideStates(idxInGoal, source, dest, rcontrol); 
-    // return cd;
-    return 0;
-}
-
-void ompl::control::CentralizedBSST::overrideStates(const base::State *source, base::State *result, Control *control)
+std::vector<bool> ompl::control::CentralizedBSST::activeAgents_(const base::State *source, Control *control) const
 {
     auto g = getProblemDefinition()->getGoal()->as<CentralizedCCGoal>();
+    auto cntrl = control->as<RealVectorControlSpace::ControlType>();
+    std::vector<bool> active(num_agents_);
     for (int a = 0; a < num_agents_; a++) {
-        bool a_at_goal = g->isSingleAgentSatisfied(source, a);
-        if (a_at_goal) {
-            // get all relevant information
-            auto start = source->as<RealVectorBeliefSpace::StateType>();
-            auto destination = result->as<RealVectorBeliefSpace::StateType>();
-            auto cntrl = control->as<RealVectorControlSpace::ControlType>();
-
-            // override the destination idx's to start values
-            destination->values[dim_ * a] = start->values[dim_ * a];
-            destination->values[dim_ * a + 1] = start->values[dim_ * a + 1];
-            destination->sigma_.block<2, 2>(dim_ * a, dim_ * a) = start->sigma_.block<2, 2>(dim_ * a, dim_ * a);
-            destination->lambda_.block<2, 2>(dim_ * a, dim_ * a) = start->lambda_.block<2, 2>(dim_ * a, dim_ * a);
-
+        active[a] = !g->isSingleAgentSatisfied(source, a);
+        if (!active[a]) {
             // zero out agent a's controls
             cntrl->values[dim_ * a] = 0;
             cntrl->values[dim_ * a + 1] = 0;
         }
     }
+    return active;
+}
+
+void ompl::control::CentralizedBSST::pinSolution_(Motion *motion)
+{
+    if (prevSolution_)
+        prevSolution_->pinned_ = false;
+    prevSolution_ = motion;
+    if (prevSolution_)
+        prevSolution_->pinned_ = true;
+}
+
+std::shared_ptr<ompl::control::PathControl> ompl::control::CentralizedBSST::solutionPath_() const
+{
+    /* the branch is walked from the end of the solution back to its start */
+    std::vector<const Motion *> branch;
+    for (const Motion *m = prevSolution_; m != nullptr; m = m->parent_)
+        branch.push_back(m);
+    auto path(std::make_shared<PathControl>(si_));
+    for (std::size_t i = branch.size() - 1; i > 0; --i)
+        path->append(branch[i]->state_, branch[i - 1]->control_, branch[i - 1]->steps_ * siC_->getPropagationStepSize());
+    path->append(branch.front()->state_);
+    return path;
+}
+
+std::shared_ptr<ompl::NearestNeighbors<ompl::control::CentralizedBSST::Motion *>> 
+ompl::control::CentralizedBSST::withTombstones_(std::shared_ptr<NearestNeighbors<Motion *>> nn)
+{
+    return std::make_shared<NearestNeighborsTombstones<Motion *>>(std::move(nn), [this](Motion *const &m)
+                                                                  {
+                                                                      motion_pool_.push_back(m);
+                                                                  });
+}
+
+ompl::control::CentralizedBSST::Motion *ompl::control::CentralizedBSST::allocMotion_()
+{
+    if (motion_pool_.empty())
+        return motion_arena_.create(siC_);
+    Motion *motion = motion_pool_.back();
+    motion_pool_.pop_back();
+    base::State *state = motion->state_;
+    Control *control = motion->control_;
+    *motion = Motion();
+    motion->state_ = state;
+    motion->control_ = control;
+    return motion;
 }
 
 ompl::control::CentralizedBSST::Motion *ompl::control::CentralizedBSST::selectNode(ompl::control::CentralizedBSST::Motion *sample)
@@ -171,44 +216,33 @@ ompl::control::CentralizedBSST::Motion *ompl::control::CentralizedBSST::selectNo
             selected = i;
         }
     }
+    // a motion leaves nn_ as soon as it is deactivated, so the nearest motion is always selectable
     if (selected == nullptr)
-    {
-        
-        int k = 1;
-        while (selected == nullptr)
-        {
-            nn_->nearestK(sample, k, ret);
-            for (unsigned int i = 0; i < ret.size() && selected == nullptr; i++)
-                if (!ret[i]->inactive_)
-                    selected = ret[i];
-            k += 5;
-        }
-    }
+        selected = nn_->nearest(sample);
     return selected;
 }
 
+ompl::control::CentralizedBSST::Witness *ompl::control::CentralizedBSST::witnessWithin_(Motion *node) const
+{
+    if (witness_grid_)
+        return static_cast<Witness *>(witness_grid_->nearestWithin(node, pruningRadius_));
+    if (witnesses_->size() == 0)
+        return nullptr;
+    auto *closest = static_cast<Witness *>(witnesses_->nearest(node));
+    return (distanceFunction(closest, node) > pruningRadius_) ? nullptr : closest;
+}
+
 ompl::control::CentralizedBSST::Witness *ompl::control::CentralizedBSST::findClosestWitness(ompl::control::CentralizedBSST::Motion *node)
 {
-    if (witnesses_->size() > 0)
-    {
-        auto *closest = static_cast<Witness *>(witnesses_->nearest(node));
-        if (distanceFunction(closest, node) > pruningRadius_)
-        {
-            closest = new Witness(siC_);
-            closest->linkRep(node);
-            si_->copyState(closest->state_, node->state_);
-            witnesses_->add(closest);
-        }
-        return closest;
-    }
-    else
+    Witness *closest = witnessWithin_(node);
+    if (closest == nullptr)
     {
-        auto *closest = new Witness(siC_);
+        closest = witness_arena_.create(siC_);
         closest->linkRep(node);
         si_->copyState(closest->state_, node->state_);
         witnesses_->add(closest);
-        return closest;
     }
+    return closest;
 }
 
 ompl::base::PlannerStatus ompl::control::CentralizedBSST::solve(const base::PlannerTerminationCondition &ptc)
@@ -220,7 +254,7 @@ ompl::base::PlannerStatus ompl::control::CentralizedBSST::solve(const base::Plan
 
     while (const base::State *st = pis_.nextStart())
     {
-        auto *motion = new Motion(siC_);
+        auto *motion = motion_arena_.create(siC_);
         si_->copyState(motion->state_, st);
         siC_->nullControl(motion->control_);
         nn_->add(motion);
@@ -238,6 +272,10 @@ ompl::base::PlannerStatus ompl::control::CentralizedBSST::solve(const base::Plan
         sampler_ = si_->allocStateSampler();
     if (!controlSampler_)
         controlSampler_ = siC_->allocControlSampler();
+    if (!covarianceSampler_ && !reachableCovariance_)
+        reachableCovariance_ = std::make_shared<ReachableCovarianceSampler>(siC_, pdef_->getStartState(0),
+            20 * siC_->getMaxControlDuration());
+    const CovarianceSampler &covarianceSampler = covarianceSampler_ ? *covarianceSampler_ : *reachableCovariance_;
 
     OMPL_INFORM("%s: Starting planning with %u states already in datastructure\n", getName().c_str(), nn_->size());
     auto start = std::chrono::high_resolution_clock::now();
@@ -247,7 +285,7 @@ ompl::base::PlannerStatus ompl::control::CentralizedBSST::solve(const base::Plan
     double approxdif = std::numeric_limits<double>::infinity();
     bool sufficientlyShort = false;
 
-    auto *rmotion = new Motion(siC_);
+    auto *rmotion = motion_arena_.create(siC_);
     base::State *rstate = rmotion->state_;
     Control *rctrl = rmotion->control_;
     base::State *xstate = si_->allocState();
@@ -263,6 +301,7 @@ ompl::base::PlannerStatus ompl::control::CentralizedBSST::solve(const base::Plan
             goal_s->sampleGoal(rstate);
         else
             sampler_->sampleUniform(rstate);
+        covarianceSampler.sample(rng_, rstate);
 
         /* find closest state in the tree */
         Motion *nmotion = selectNode(rmotion);
@@ -270,13 +309,12 @@ ompl::base::PlannerStatus ompl::control::CentralizedBSST::solve(const base::Plan
         /* sample a random control that attempts to go towards the random state, and also sample a control duration */
         controlSampler_->sample(rctrl);
         unsigned int cd = rng_.uniformInt(siC_->getMinControlDuration(), siC_->getMaxControlDuration());
-        unsigned int propCd = siC_->propagateWhileValid(nmotion->state_, rctrl, cd, rstate);
+        /* agents already at their goal keep still, only the others are propagated */
+        const std::vector<bool> active = activeAgents_(nmotion->state_, rctrl);
+        unsigned int propCd = propagation_->propagateWhileValid(nmotion->state_, rctrl, cd, active, rstate);
 
         if (propCd == cd)
         {
-            /* check if need to override state */
-            overrideStates(nmotion->state_, rstate, rctrl);
-
             base::Cost incCost = opt_->motionCost(nmotion->state_, rstate);
             base::Cost cost = opt_->combineCosts(nmotion->accCost_, incCost);
             Witness *closestWitness = findClosestWitness(rmotion);
@@ -285,7 +323,7 @@ ompl::base::PlannerStatus ompl::control::CentralizedBSST::solve(const base::Plan
             {
                 Motion *oldRep = closestWitness->rep_;
                 /* create a motion */
-                auto *motion = new Motion(siC_);
+                auto *motion = allocMotion_();
                 motion->accCost_ = cost;
                 motion->state_->as<RealVectorBeliefSpace::StateType>()->setCost(cost.value());
                 si_->copyState(motion->state_, rmotion->state_);
@@ -333,25 +371,7 @@ ompl::base::PlannerStatus ompl::control::CentralizedBSST::solve(const base::Plan
                     approxdif = dist;
                     solution = motion;
 
-                    for (auto &i : prevSolution_)
-                        if (i)
-                            si_->freeState(i);
-                    prevSolution_.clear();
-                    for (auto &prevSolutionControl : prevSolutionControls_)
-                        if (prevSolutionControl)
-                            siC_->freeControl(prevSolutionControl);
-                    prevSolutionControls_.clear();
-                    prevSolutionSteps_.clear();
-
-                    Motion *solTrav = solution;
-                    while (solTrav->parent_ != nullptr)
-                    {
-                        prevSolution_.push_back(si_->cloneState(solTrav->state_));
-                        prevSolutionControls_.push_back(siC_->cloneControl(solTrav->control_));
-                        prevSolutionSteps_.push_back(solTrav->steps_);
-                        solTrav = solTrav->parent_;
-                    }
-                    prevSolution_.push_back(si_->cloneState(solTrav->state_));
+                    pinSolution_(solution);
                     prevSolutionCost_ = solution->accCost_;
 
                     OMPL_INFORM("Found solution with cost %.2f", solution->accCost_.value());
@@ -387,22 +407,13 @@ ompl::base::PlannerStatus ompl::control::CentralizedBSST::solve(const base::Plan
 
                 if (oldRep != rmotion)
                 {
-                    while (oldRep->inactive_ && oldRep->numChildren_ == 0)
+                    while (oldRep->inactive_ && oldRep->numChildren_ == 0 && !oldRep->pinned_)
                     {
                         oldRep->inactive_ = true;
+                        // recycled once nn_ purges it
                         nn_->remove(oldRep);
-
-                        if (oldRep->state_)
-                            si_->freeState(oldRep->state_);
-                        if (oldRep->control_)
-                            siC_->freeControl(oldRep->control_);
-
-                        oldRep->state_ = nullptr;
-                        oldRep->control_ = nullptr;
                         oldRep->parent_->numChildren_--;
-                        Motion *oldRepParent = oldRep->parent_;
-                        delete oldRep;
-                        oldRep = oldRepParent;
+                        oldRep = oldRep->parent_;
                     }
                 }
             }
@@ -424,11 +435,7 @@ ompl::base::PlannerStatus ompl::control::CentralizedBSST::solve(const base::Plan
     if (solution != nullptr)
     {
         /* set the solution path */
-        auto path(std::make_shared<oc::PathControl>(si_));
-        for (int i = prevSolution_.size() - 1; i >= 1; --i)
-            path->append(prevSolution_[i], prevSolutionControls_[i - 1],
-                         prevSolutionSteps_[i - 1] * siC_->getPropagationStepSize());
-        path->append(prevSolution_[0]);
+        auto path = solutionPath_();
         solved = true;
         pdef_->addSolutionPath(path, approximate, approxdif, getName());
         soc_ += path->length();
@@ -439,7 +446,7 @@ ompl::base::PlannerStatus ompl::control::CentralizedBSST::solve(const base::Plan
         si_->freeState(rmotion->state_);
     if (rmotion->control_)
         siC_->freeControl(rmotion->control_);
-    delete rmotion;
+    motion_arena_.destroy(rmotion);
 
     OMPL_INFORM("%s: Created %u states in %u iterations", getName().c_str(), nn_->size(), iterations);
 
@@ -472,8 +479,8 @@ void ompl::control::CentralizedBSST::getPlannerData(base::PlannerData &data) con
 
     double delta = siC_->getPropagationStepSize();
 
-    if (prevSolution_.size() != 0)
-        data.addGoalVertex(base::PlannerDataVertex(prevSolution_[0]));
+    if (prevSolution_)
+        data.addGoalVertex(base::PlannerDataVertex(prevSolution_->state_));
 
     for (auto m : allMotions)
     {
@@ -517,8 +524,8 @@ void ompl::control::CentralizedBSST::getPlannerDataAndCosts(base::PlannerData &d
 
     double delta = siC_->getPropagationStepSize();
 
-    if (prevSolution_.size() != 0)
-        data.addGoalVertex(base::PlannerDataVertex(prevSolution_[0]));
+    if (prevSolution_)
+        data.addGoalVertex(base::PlannerDataVertex(prevSolution_->state_));
 
     for (auto m : allMotions)
     {
@@ -1,18 +1,33 @@
 #include "Planners/ConstraintRespectingBSST.h"
+#include "StatePropogators/BatchStatePropagator.h"
+#include "utils/Log.h"
+#include "utils/SegmentPropagation.h"
+#include "utils/TaskRuntime.h"
+#include "utils/Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 ompl::control::ConstraintRespectingBSST::ConstraintRespectingBSST(const SpaceInformationPtr &si): 
 	ConstraintRespectingPlanner(si, "ConstraintRespectingBSST")
 {
     specs_.approximateSolutions = true;
     siC_ = si.get();
-    prevSolution_.clear();
-    prevSolutionControls_.clear();
-    prevSolutionSteps_.clear();
+    motion_arena_.setAccounting(alloc::MOTIONS);
+    witness_arena_.setAccounting(alloc::MOTIONS);
 
     ConstraintRespectingPlanner::declareParam<double>("goal_bias", this, &ConstraintRespectingBSST::setGoalBias, &ConstraintRespectingBSST::getGoalBias, "0.:.05:1.");
     ConstraintRespectingPlanner::declareParam<double>("selection_radius", this, &ConstraintRespectingBSST::setSelectionRadius, &ConstraintRespectingBSST::getSelectionRadius, "0.:.1:"
                                                                                                                 "100");
     ConstraintRespectingPlanner::declareParam<double>("pruning_radius", this, &ConstraintRespectingBSST::setPruningRadius, &ConstraintRespectingBSST::getPruningRadius, "0.:.1:100");
+    ConstraintRespectingPlanner::declareParam<double>("heuristic_bias", this, &ConstraintRespectingBSST::setHeuristicBias, &ConstraintRespectingBSST::getHeuristicBias, "0.:.05:1.");
+    ConstraintRespectingPlanner::declareParam<double>("subgoal_bias", this, &ConstraintRespectingBSST::setSubgoalBias, &ConstraintRespectingBSST::getSubgoalBias, "0.:.05:1.");
+    ConstraintRespectingPlanner::declareParam<bool>("warm_start", this, &ConstraintRespectingBSST::setWarmStart, &ConstraintRespectingBSST::getWarmStart, "0,1");
+    ConstraintRespectingPlanner::declareParam<unsigned int>("batch_controls", this, &ConstraintRespectingBSST::setBatchControls, &ConstraintRespectingBSST::getBatchControls, "1:64");
+    ConstraintRespectingPlanner::declareParam<unsigned int>("threads", this, &ConstraintRespectingBSST::setNumThreads, &ConstraintRespectingBSST::getNumThreads, "1:64");
 }
 
 ompl::control::ConstraintRespectingBSST::~ConstraintRespectingBSST()
@@ -23,18 +38,7 @@ ompl::control::ConstraintRespectingBSST::~ConstraintRespectingBSST()
 void ompl::control::ConstraintRespectingBSST::setup()
 {
     ConstraintRespectingPlanner::setup();
-    if (!nn_)
-        nn_.reset(tools::getDefaultNearestNeighbors<Motion *>(this));
-    nn_->setDistanceFunction([this](const Motion *a, const Motion *b)
-                             {
-                                 return distanceFunction(a, b);
-                             });
-    if (!witnesses_)
-        witnesses_.reset(tools::getDefaultNearestNeighbors<Motion *>(this));
-    witnesses_->setDistanceFunction([this](const Motion *a, const Motion *b)
-                                    {
-                                        return distanceFunction(a, b);
-                                    });
+    /* the nearest neighbors are only allocated by the first solve(), so setting up a planner stays cheap */
 
     if (pdef_)
     {
@@ -73,6 +77,9 @@ void ompl::control::ConstraintRespectingBSST::clear()
         witnesses_->clear();
     if (opt_)
         prevSolutionCost_ = opt_->infiniteCost();
+    if (heuristic_)
+        heuristic_->reset();
+    reachableCovariance_.reset();
 }
 
 void ompl::control::ConstraintRespectingBSST::freeMemory()
@@ -89,31 +96,171 @@ void ompl::control::ConstraintRespectingBSST::freeMemory()
             if (motion->control_) {
                 siC_->freeControl(motion->control_);
             }
-            delete motion;
         }
+        // the removed motions that were not purged yet go to the pool
+        nn_->clear();
+    }
+    for (auto &motion : motion_pool_)
+    {
+        si_->freeState(motion->state_);
+        siC_->freeControl(motion->control_);
     }
+    motion_pool_.clear();
     if (witnesses_)
     {
         std::vector<Motion *> witnesses;
         witnesses_->list(witnesses);
         for (auto &witness : witnesses)
         {
-            delete witness;
+            if (witness->state_)
+                si_->freeState(witness->state_);
+            if (witness->control_)
+                siC_->freeControl(witness->control_);
         }
     }
-    for (auto &i : prevSolution_)
-    {
-        if (i)
-            si_->freeState(i);
+    /* the states are returned to their space, the motions themselves are released in bulk */
+    motion_arena_.release();
+    witness_arena_.release();
+    prevSolution_ = nullptr;
+}
+
+bool ompl::control::ConstraintRespectingBSST::edgeSatisfiesConstraints_(const Motion *parent, const Control *ctrl, 
+    const unsigned int steps, base::State *const *edge) const
+{
+    return edgeSatisfiesIndex_(parent, ctrl, steps, constraint_index_.get(), edge);
+}
+
+bool ompl::control::ConstraintRespectingBSST::edgeSatisfiesIndex_(const Motion *parent, const Control *ctrl, 
+    const unsigned int steps, const ConstraintIndex *index, base::State *const *edge) const
+{
+    /* the edge covers the steps (parent, parent + steps]. The start state is checked with the edges that leave it */
+    const unsigned int first_step = parent->parent_ ? parent->timeStep_ + 1 : 0;
+    const unsigned int last_step = parent->timeStep_ + steps;
+    if (!index || !index->overlaps(first_step, last_step))
+        return true;
+
+    std::vector<base::State *> propagated;
+    if (!edge) {
+        siC_->propagate(parent->state_, ctrl, steps, propagated, true);
+        edge = propagated.data();
     }
-    prevSolution_.clear();
-    for (auto &prevSolutionControl : prevSolutionControls_)
-    {
-        if (prevSolutionControl)
-            siC_->freeControl(prevSolutionControl);
+    std::vector<base::State *> states;
+    if (!parent->parent_)
+        states.push_back(parent->state_);
+    states.insert(states.end(), edge, edge + steps);
+    // only check the constraints if the edge comes near one of those whose window it overlaps
+    const bool satisfied = planValidator_->checkConstraints(states, first_step, *index);
+    for (auto &st: propagated)
+        si_->freeState(st);
+    return satisfied;
+}
+
+bool ompl::control::ConstraintRespectingBSST::headsIntoConstraints_(const Motion *nmotion, base::State *target) const
+{
+    const ConstraintIndex *index = constraint_index_.get();
+    if (!index || index->empty() || !index->positives_.empty())
+        return false;
+    const unsigned int first_step = nmotion->timeStep_ + 1;
+    const unsigned int last_step = nmotion->timeStep_ + siC_->getMaxControlDuration();
+    return planValidator_->nearConstraints({nmotion->state_, target}, first_step, last_step, *index);
+}
+
+bool ompl::control::ConstraintRespectingBSST::hasPathWithin(const std::vector<ConstraintPtr> &constraints, const double max_duration) const
+{
+    if (!nn_ || nn_->size() == 0 || !planValidator_ || !pdef_ || !pdef_->getGoal())
+        return false;
+    const ConstraintIndexPtr index = constraints.empty() ? nullptr : planValidator_->indexConstraints(constraints);
+    // (half a step of slack for the rounding of the durations)
+    const double max_steps = max_duration / siC_->getPropagationStepSize() + 0.5;
+
+    std::vector<Motion *> motions;
+    nn_->list(motions);
+    std::sort(motions.begin(), motions.end(), [](const Motion *a, const Motion *b) {return a->timeStep_ < b->timeStep_;});
+    base::Goal *goal = pdef_->getGoal().get();
+    /* the branches share their first edges, so every edge is only checked once */
+    std::unordered_map<const Motion *, bool> satisfied;
+    for (const Motion *m: motions) {
+        if (m->timeStep_ > max_steps)
+            break;
+        if (!goal->isSatisfied(m->state_) || (index && !planValidator_->satisfiesFinalConstraints(m->state_, m->timeStep_, *index)))
+            continue;
+        std::vector<const Motion *> branch;
+        bool ok = true;
+        for (const Motion *c = m; c->parent_; c = c->parent_) {
+            auto itr = satisfied.find(c);
+            if (itr != satisfied.end()) {
+                ok = itr->second;
+                break;
+            }
+            branch.push_back(c);
+        }
+        // check the unknown edges from the start, up to the first violation
+        for (auto itr = branch.rbegin(); itr != branch.rend(); itr++) {
+            ok = ok && edgeSatisfiesIndex_((*itr)->parent_, (*itr)->control_, (*itr)->steps_, index.get());
+            satisfied[*itr] = ok;
+        }
+        if (ok)
+            return true;
     }
-    prevSolutionControls_.clear();
-    prevSolutionSteps_.clear();
+    return false;
+}
+
+bool ompl::control::ConstraintRespectingBSST::pruneTree_()
+{
+    if (!nn_ || nn_->size() == 0 || !planValidator_)
+        return false;
+
+    std::vector<Motion *> motions;
+    nn_->list(motions);
+
+    /* parents come before their children, so a single pass checks every branch edge by edge. 
+       A motion is pruned if its own edge violates the constraints, or if its parent is pruned */
+    std::sort(motions.begin(), motions.end(), [](const Motion *a, const Motion *b) {return a->timeStep_ < b->timeStep_;});
+    std::vector<Motion *> removed;
+    for (auto &m: motions) {
+        if (m->parent_)
+            m->satisfiesConstraints_ = m->parent_->satisfiesConstraints_ && edgeSatisfiesConstraints_(m->parent_, m->control_, m->steps_);
+        else
+            m->satisfiesConstraints_ = true;
+        if (!m->satisfiesConstraints_)
+            removed.push_back(m);
+    }
+    /* the start itself violates the constraints, so nothing can be reused */
+    if (removed.size() == motions.size())
+        return false;
+
+    /* witnesses that represent a removed motion are dropped as well */
+    std::vector<Motion *> witnesses;
+    witnesses_->list(witnesses);
+    std::unordered_set<const Motion *> kept;
+    for (auto &m: motions) {
+        if (m->satisfiesConstraints_)
+            kept.insert(m);
+    }
+    for (auto &w: witnesses) {
+        auto *witness = static_cast<Witness *>(w);
+        if (kept.count(witness->rep_) == 0) {
+            witnesses_->remove(witness);
+            if (witness->state_)
+                si_->freeState(witness->state_);
+            if (witness->control_)
+                siC_->freeControl(witness->control_);
+            witness_arena_.destroy(witness);
+        }
+    }
+    /* the previous solution may be pruned, so any new solution is accepted */
+    pinSolution_(nullptr);
+    prevSolutionCost_ = opt_->infiniteCost();
+
+    /* the removed motions are recycled once nn_ purges them */
+    for (auto &m: removed) {
+        nn_->remove(m);
+        if (m->parent_ && m->parent_->satisfiesConstraints_)
+            m->parent_->numChildren_--;
+    }
+
+    KCBS_LOG_INFO(getName().c_str(), "warm_start", "kept", motions.size() - removed.size(), "states", motions.size());
+    return true;
 }
 
 ompl::control::ConstraintRespectingBSST::Motion *ompl::control::ConstraintRespectingBSST::selectNode(ompl::control::ConstraintRespectingBSST::Motion *sample)
@@ -131,64 +278,474 @@ ompl::control::ConstraintRespectingBSST::Motion *ompl::control::ConstraintRespec
             selected = i;
         }
     }
+    // a motion leaves nn_ as soon as it is deactivated, so the nearest motion is always selectable
     if (selected == nullptr)
+        selected = nn_->nearest(sample);
+    return selected;
+}
+
+ompl::control::ConstraintRespectingBSST::Witness *ompl::control::ConstraintRespectingBSST::witnessWithin_(Motion *node) const
+{
+    if (witness_grid_)
+        return static_cast<Witness *>(witness_grid_->nearestWithin(node, pruningRadius_));
+    if (witnesses_->size() == 0)
+        return nullptr;
+    auto *closest = static_cast<Witness *>(witnesses_->nearest(node));
+    return (distanceFunction(closest, node) > pruningRadius_) ? nullptr : closest;
+}
+
+ompl::control::ConstraintRespectingBSST::Witness *ompl::control::ConstraintRespectingBSST::findClosestWitness(ompl::control::ConstraintRespectingBSST::Motion *node)
+{
+    Witness *closest = witnessWithin_(node);
+    if (closest == nullptr)
+    {
+        closest = witness_arena_.create(siC_);
+        closest->linkRep(node);
+        si_->copyState(closest->state_, node->state_);
+        witnesses_->add(closest);
+    }
+    return closest;
+}
+
+void ompl::control::ConstraintRespectingBSST::allocCandidates_(Candidates &candidates) const
+{
+    for (unsigned int i = 0; i < batch_controls_; i++) {
+        candidates.controls_.push_back(siC_->allocControl());
+        candidates.states_.push_back(si_->allocState());
+        candidates.next_.push_back(si_->allocState());
+    }
+    candidates.alive_.reserve(batch_controls_);
+    candidates.from_.reserve(batch_controls_);
+    candidates.applied_.reserve(batch_controls_);
+    candidates.to_.reserve(batch_controls_);
+}
+
+void ompl::control::ConstraintRespectingBSST::freeCandidates_(Candidates &candidates) const
+{
+    for (auto &c: candidates.controls_)
+        siC_->freeControl(c);
+    for (auto &st: candidates.states_)
+        si_->freeState(st);
+    for (auto &st: candidates.next_)
+        si_->freeState(st);
+    candidates.controls_.clear();
+    candidates.states_.clear();
+    candidates.next_.clear();
+}
+
+unsigned int ompl::control::ConstraintRespectingBSST::propagateBestOf_(const base::State *source, base::State *target, 
+    const unsigned int steps, ControlSampler &sampler, Candidates &candidates, Control *ctrl) const
+{
+    const StatePropagatorPtr &propagator = siC_->getStatePropagator();
+    const auto *batch = dynamic_cast<const BatchStatePropagator *>(propagator.get());
+    const double dt = siC_->getPropagationStepSize();
+
+    candidates.alive_.clear();
+    for (std::size_t i = 0; i < candidates.controls_.size(); i++) {
+        sampler.sample(candidates.controls_[i]);
+        candidates.alive_.push_back(i);
+    }
+    /* a candidate that leaves the valid states is dropped, as the extension would be rejected anyway */
+    for (unsigned int s = 0; s < steps && !candidates.alive_.empty(); s++) {
+        candidates.from_.clear();
+        candidates.applied_.clear();
+        candidates.to_.clear();
+        for (const std::size_t i: candidates.alive_) {
+            candidates.from_.push_back(s == 0 ? source : candidates.states_[i]);
+            candidates.applied_.push_back(candidates.controls_[i]);
+            candidates.to_.push_back(candidates.next_[i]);
+        }
+        if (batch)
+            batch->propagateBatch(candidates.from_.data(), candidates.applied_.data(), candidates.alive_.size(), dt, candidates.to_.data());
+        else {
+            for (std::size_t j = 0; j < candidates.alive_.size(); j++)
+                propagator->propagate(candidates.from_[j], candidates.applied_[j], dt, candidates.to_[j]);
+        }
+        std::size_t kept = 0;
+        for (const std::size_t i: candidates.alive_) {
+            if (!si_->isValid(candidates.next_[i]))
+                continue;
+            std::swap(candidates.states_[i], candidates.next_[i]);
+            candidates.alive_[kept++] = i;
+        }
+        candidates.alive_.resize(kept);
+    }
+    if (candidates.alive_.empty())
+        return 0;
+
+    std::size_t best = candidates.alive_.front();
+    double best_dist = std::numeric_limits<double>::infinity();
+    for (const std::size_t i: candidates.alive_) {
+        const double d = si_->distance(candidates.states_[i], target);
+        if (d < best_dist) {
+            best_dist = d;
+            best = i;
+        }
+    }
+    si_->copyState(target, candidates.states_[best]);
+    siC_->copyControl(ctrl, candidates.controls_[best]);
+    return steps;
+}
+
+void ompl::control::ConstraintRespectingBSST::storeSolution_(Motion *solution)
+{
+    storeSolution_(solution);
+}
+
+ompl::control::ConstraintRespectingBSST::Motion *ompl::control::ConstraintRespectingBSST::replayExperience_(Motion *root, 
+    base::Goal *goal)
+{
+    KCBS_TRACE_SCOPE("ConstraintRespectingBSST::replayExperience_");
+    const base::StateSpacePtr &space = si_->getStateSpace();
+    std::vector<double> start;
+    space->copyToReals(start, root->state_);
+    base::State *end = si_->allocState();
+    const std::vector<ExperienceCache::Experience> replays = experience_->nearest(start, experienceRadius_, maxReplays_,
+        [&](const std::vector<double> &reals) {
+            double dist = 0.0;
+            space->copyFromReals(end, reals);
+            goal->isSatisfied(end, &dist);
+            return dist;
+        });
+    si_->freeState(end);
+
+    /* every control is propagated again from the start, so the replayed branch is valid for this problem */
+    Motion *solution = nullptr;
+    Control *ctrl = siC_->allocControl();
+    SegmentPropagation propagation(siC_);
+    const unsigned int control_dim = siC_->getControlSpace()->getDimension();
+    for (std::size_t r = 0; r < replays.size() && !solution; r++)
     {
-        int k = 1;
-        while (selected == nullptr)
+        const ExperienceCache::Experience &replay = replays[r];
+        Motion *parent = root;
+        for (std::size_t i = 0; i < replay.controls_.size() && !solution; i++)
         {
-            nn_->nearestK(sample, k, ret);
-            for (unsigned int i = 0; i < ret.size() && selected == nullptr; i++)
-                if (!ret[i]->inactive_)
-                    selected = ret[i];
-            k += 5;
+            for (unsigned int j = 0; j < control_dim && j < replay.controls_[i].size(); j++)
+                *siC_->getControlSpace()->getValueAddressAtIndex(ctrl, j) = replay.controls_[i][j];
+            const unsigned int steps = replay.steps_[i];
+            auto *motion = allocMotion_();
+            if (propagation.propagateWhileValid(parent->state_, ctrl, steps, motion->state_) != steps ||
+                (!constraints_.empty() && !edgeSatisfiesConstraints_(parent, ctrl, steps, propagation.lastSegment(steps))))
+            {
+                si_->freeState(motion->state_);
+                siC_->freeControl(motion->control_);
+                motion_arena_.destroy(motion);
+                break;
+            }
+            siC_->copyControl(motion->control_, ctrl);
+            motion->steps_ = steps;
+            motion->parent_ = parent;
+            parent->numChildren_++;
+            motion->timeStep_ = parent->timeStep_ + steps;
+            motion->accCost_ = opt_->combineCosts(parent->accCost_, opt_->motionCost(parent->state_, motion->state_));
+            motion->state_->as<RealVectorBeliefSpace::StateType>()->setCost(motion->accCost_.value());
+            /* the replayed motions are kept as tree motions, and represent their witness if they are cheaper */
+            Witness *witness = findClosestWitness(motion);
+            if (witness->rep_ != motion && opt_->isCostBetterThan(motion->accCost_, witness->rep_->accCost_))
+                witness->linkRep(motion);
+            nn_->add(motion);
+            trackFrontier_(motion->state_);
+            if (goal->isSatisfied(motion->state_) && satisfiesFinalConstraints_(motion->state_, motion->timeStep_) && 
+                opt_->isCostBetterThan(motion->accCost_, prevSolutionCost_))
+            {
+                storeSolution_(motion);
+                solution = motion;
+            }
+            parent = motion;
         }
     }
-    return selected;
+    siC_->freeControl(ctrl);
+    if (solution)
+        KCBS_LOG_INFO(getName().c_str(), "replayed_experience", "cost", solution->accCost_.value());
+    return solution;
 }
 
-ompl::control::ConstraintRespectingBSST::Witness *ompl::control::ConstraintRespectingBSST::findClosestWitness(ompl::control::ConstraintRespectingBSST::Motion *node)
+void ompl::control::ConstraintRespectingBSST::recordExperience_() const
 {
-    if (witnesses_->size() > 0)
+    /* the branch of prevSolution_ runs from the end of the solution back to its start */
+    std::vector<const Motion *> branch;
+    for (const Motion *m = prevSolution_; m != nullptr; m = m->parent_)
+        branch.push_back(m);
+    ExperienceCache::Experience experience;
+    const base::StateSpacePtr &space = si_->getStateSpace();
+    space->copyToReals(experience.start_, branch.back()->state_);
+    space->copyToReals(experience.end_, branch.front()->state_);
+    const unsigned int control_dim = siC_->getControlSpace()->getDimension();
+    for (int i = static_cast<int>(branch.size()) - 2; i >= 0; --i)
     {
-        // std::cout << "154" << std::endl;
-        auto *closest = static_cast<Witness *>(witnesses_->nearest(node));
-        // si_->printState(closest->state_, std::cout);
-        // si_->printState(node->state_, std::cout);
-        // std::cout << pruningRadius_ << std::endl;
-        // std::cout << distanceFunction(closest, node) << std::endl;
-        if (distanceFunction(closest, node) > pruningRadius_)
+        std::vector<double> control(control_dim);
+        for (unsigned int j = 0; j < control_dim; j++)
+            control[j] = *siC_->getControlSpace()->getValueAddressAtIndex(branch[i]->control_, j);
+        experience.controls_.push_back(std::move(control));
+        experience.steps_.push_back(branch[i]->steps_);
+    }
+    experience.cost_ = prevSolutionCost_.value();
+    experience_->add(std::move(experience));
+}
+
+ompl::control::ConstraintRespectingBSST::Motion *ompl::control::ConstraintRespectingBSST::growParallel_(
+    const base::PlannerTerminationCondition &ptc, double &approxdif, unsigned int &iterations)
+{
+    base::Goal *goal = pdef_->getGoal().get();
+    auto *goal_s = dynamic_cast<base::GoalSampleableRegion *>(goal);
+
+    /* the samplers are not thread-safe, so every worker owns its samplers and its scratch motion */
+    struct Worker
+    {
+        base::StateSamplerPtr sampler_;
+        ControlSamplerPtr controlSampler_;
+        RNG rng_;
+        Motion *rmotion_{nullptr};
+        Candidates candidates_;
+        std::unique_ptr<SegmentPropagation> propagation_;
+    };
+    std::vector<Worker> workers(num_threads_);
+    std::unordered_set<const Motion *> scratch;
+    for (auto &w: workers) {
+        w.sampler_ = si_->allocStateSampler();
+        w.controlSampler_ = siC_->allocControlSampler();
+        if (seed_ != 0) {
+            w.rng_.setLocalSeed(nextSeed_());
+            seeding::seed(*w.sampler_, nextSeed_());
+            seeding::seed(*w.controlSampler_, nextSeed_());
+        }
+        w.rmotion_ = motion_arena_.create(siC_);
+        scratch.insert(w.rmotion_);
+        w.propagation_ = std::make_unique<SegmentPropagation>(siC_);
+        if (batch_controls_ > 1)
+            allocCandidates_(w.candidates_);
+    }
+
+    Motion *solution = nullptr;
+    std::atomic<bool> done{false};
+    std::atomic<unsigned int> count{0};
+    std::mutex goal_mutex;
+    /* motions removed from the tree may still be extended by a worker that selected them earlier, so no
+       motion is recycled (allocMotion_) until all workers have stopped */
+    std::unordered_set<Motion *> retired;
+
+    /* a witness of a scratch motion (left behind by an edge that violated the constraints) represents no motion
+       of the tree */
+    auto improves = [this, &scratch](const Witness *witness, const base::Cost &cost) {
+        return !witness || scratch.count(witness->rep_) > 0 || opt_->isCostBetterThan(cost, witness->rep_->accCost_);
+    };
+
+    /* the expensive part (propagation, cost and constraints) runs outside of the tree lock. Samples are 
+       checked against the witnesses under a shared lock first, and again before inserting under the unique lock */
+    auto grow = [&](Worker &w) {
+        Motion *rmotion = w.rmotion_;
+        base::State *rstate = rmotion->state_;
+        Control *rctrl = rmotion->control_;
+        while (!done && ptc == false)
         {
-            // std::cout << "here" << std::endl;
-            closest = new Witness(siC_);
-            closest->linkRep(node);
-            si_->copyState(closest->state_, node->state_);
-            witnesses_->add(closest);
+            KCBS_TRACE_SCOPE("ConstraintRespectingBSST::parallelIteration");
+            count++;
+            const bool goal_sample = goal_s && w.rng_.uniform01() < goalBias_ && goal_s->canSample();
+            if (goal_sample) {
+                std::lock_guard<std::mutex> lock(goal_mutex);
+                goal_s->sampleGoal(rstate);
+            }
+            else
+                sampleState_(*w.sampler_, w.rng_, rstate);
+            sampleCovariance_(w.rng_, rstate);
+
+            Motion *nmotion = nullptr;
+            {
+                std::shared_lock<std::shared_mutex> lock(tree_mutex_);
+                nmotion = selectNode(rmotion);
+            }
+            for (unsigned int r = 0; r < constraintResamples_ && !goal_sample && headsIntoConstraints_(nmotion, rstate); r++)
+            {
+                sampleState_(*w.sampler_, w.rng_, rstate);
+                sampleCovariance_(w.rng_, rstate);
+                std::shared_lock<std::shared_mutex> lock(tree_mutex_);
+                nmotion = selectNode(rmotion);
+            }
+
+            unsigned int cd = w.rng_.uniformInt(siC_->getMinControlDuration(), siC_->getMaxControlDuration());
+            unsigned int propCd;
+            if (batch_controls_ > 1)
+                propCd = propagateBestOf_(nmotion->state_, rstate, cd, *w.controlSampler_, w.candidates_, rctrl);
+            else {
+                w.controlSampler_->sample(rctrl);
+                propCd = w.propagation_->propagateWhileValid(nmotion->state_, rctrl, cd, rstate);
+            }
+            if (propCd != cd)
+                continue;
+            base::Cost cost = opt_->combineCosts(nmotion->accCost_, opt_->motionCost(nmotion->state_, rstate));
+            {
+                std::shared_lock<std::shared_mutex> lock(tree_mutex_);
+                if (!improves(witnessWithin_(rmotion), cost))
+                    continue;
+            }
+            // the branch up to nmotion satisfies the constraints, so only the states of the new edge are checked
+            base::State *const *edge = (batch_controls_ > 1) ? nullptr : w.propagation_->lastSegment(cd);
+            if (!constraints_.empty() && !edgeSatisfiesConstraints_(nmotion, rctrl, cd, edge))
+                continue;
+
+            std::unique_lock<std::shared_mutex> lock(tree_mutex_);
+            if (done || retired.count(nmotion) > 0)
+                continue;
+            Witness *closestWitness = witnessWithin_(rmotion);
+            if (!improves(closestWitness, cost))
+                continue;
+
+            auto *motion = motion_arena_.create(siC_);
+            motion->accCost_ = cost;
+            motion->state_->as<RealVectorBeliefSpace::StateType>()->setCost(cost.value());
+            si_->copyState(motion->state_, rmotion->state_);
+            siC_->copyControl(motion->control_, rctrl);
+            motion->steps_ = cd;
+            motion->parent_ = nmotion;
+            nmotion->numChildren_++;
+            motion->timeStep_ = nmotion->timeStep_ + cd;
+
+            Motion *oldRep = nullptr;
+            if (closestWitness) {
+                oldRep = scratch.count(closestWitness->rep_) > 0 ? nullptr : closestWitness->rep_;
+                closestWitness->linkRep(motion);
+            }
+            else {
+                closestWitness = witness_arena_.create(siC_);
+                closestWitness->linkRep(motion);
+                si_->copyState(closestWitness->state_, motion->state_);
+                witnesses_->add(closestWitness);
+            }
+            nn_->add(motion);
+            trackFrontier_(motion->state_);
+
+            if (motion->state_->as<RealVectorBeliefSpace::StateType>()->getCovariance()(0,0) > max_eigenvalue_)
+            {
+                max_eigenvalue_ = motion->state_->as<RealVectorBeliefSpace::StateType>()->getCovariance()(0,0);
+            }
+            else if (motion->state_->as<RealVectorBeliefSpace::StateType>()->getCovariance()(1,1) > max_eigenvalue_)
+            {
+                max_eigenvalue_ = motion->state_->as<RealVectorBeliefSpace::StateType>()->getCovariance()(1,1);
+            }
+
+            double dist = 0.0;
+            bool solv = goal->isSatisfied(motion->state_, &dist) && satisfiesFinalConstraints_(motion->state_, motion->timeStep_);
+            if (solv && opt_->isCostBetterThan(motion->accCost_, prevSolutionCost_))
+            {
+                approxdif = dist;
+                solution = motion;
+                storeSolution_(solution);
+                KCBS_LOG_INFO(getName().c_str(), "solution", "cost", solution->accCost_.value());
+                done = true;
+            }
+
+            while (oldRep && oldRep->inactive_ && oldRep->numChildren_ == 0 && !oldRep->pinned_ && retired.count(oldRep) == 0)
+            {
+                nn_->remove(oldRep);
+                retired.insert(oldRep);
+                oldRep->parent_->numChildren_--;
+                oldRep = oldRep->parent_;
+            }
         }
-        return closest;
+    };
+
+    {
+        // the workers are tasks of the runtime, whose pending ones are dropped once ptc is reached
+        TaskGroup group(&ptc);
+        group.runAndWait(num_threads_, [&grow, &workers](const std::size_t t) {grow(workers[t]);});
     }
-    else
+
+    for (auto &w: workers)
     {
-        // std::cout << "167" << std::endl;
-        auto *closest = new Witness(siC_);
-        closest->linkRep(node);
-        si_->copyState(closest->state_, node->state_);
-        witnesses_->add(closest);
-        return closest;
+        si_->freeState(w.rmotion_->state_);
+        siC_->freeControl(w.rmotion_->control_);
+        motion_arena_.destroy(w.rmotion_);
+        freeCandidates_(w.candidates_);
+    }
+    iterations += count;
+    return solution;
+}
+
+void ompl::control::ConstraintRespectingBSST::pinSolution_(Motion *motion)
+{
+    if (prevSolution_)
+        prevSolution_->pinned_ = false;
+    prevSolution_ = motion;
+    if (prevSolution_)
+        prevSolution_->pinned_ = true;
+}
+
+std::shared_ptr<ompl::control::PathControl> ompl::control::ConstraintRespectingBSST::solutionPath_() const
+{
+    /* the branch is walked from the end of the solution back to its start */
+    std::vector<const Motion *> branch;
+    for (const Motion *m = prevSolution_; m != nullptr; m = m->parent_)
+        branch.push_back(m);
+    auto path(std::make_shared<PathControl>(si_));
+    for (std::size_t i = branch.size() - 1; i > 0; --i)
+        path->append(branch[i]->state_, branch[i - 1]->control_, branch[i - 1]->steps_ * siC_->getPropagationStepSize());
+    path->append(branch.front()->state_);
+    return path;
+}
+
+std::shared_ptr<ompl::NearestNeighbors<ompl::control::ConstraintRespectingBSST::Motion *>> 
+ompl::control::ConstraintRespectingBSST::withTombstones_(std::shared_ptr<NearestNeighbors<Motion *>> nn)
+{
+    return std::make_shared<NearestNeighborsTombstones<Motion *>>(std::move(nn), [this](Motion *const &m)
+                                                                  {
+                                                                      motion_pool_.push_back(m);
+                                                                  });
+}
+
+ompl::control::ConstraintRespectingBSST::Motion *ompl::control::ConstraintRespectingBSST::allocMotion_()
+{
+    if (motion_pool_.empty())
+        return motion_arena_.create(siC_);
+    Motion *motion = motion_pool_.back();
+    motion_pool_.pop_back();
+    base::State *state = motion->state_;
+    Control *control = motion->control_;
+    *motion = Motion();
+    motion->state_ = state;
+    motion->control_ = control;
+    return motion;
+}
+
+void ompl::control::ConstraintRespectingBSST::allocNearestNeighbors_()
+{
+    /* the selection radius bounds the squared distance, so a cell spans one radius of the mean */
+    if (!nn_)
+    {
+        std::shared_ptr<NearestNeighbors<Motion *>> nn(tools::getBeliefNearestNeighbors<Motion *>(this, std::sqrt(selectionRadius_)));
+        if (!nn)
+            nn.reset(tools::getDefaultNearestNeighbors<Motion *>(this));
+        nn_ = withTombstones_(std::move(nn));
     }
+    nn_->setDistanceFunction([this](const Motion *a, const Motion *b)
+                             {
+                                 return distanceFunction(a, b);
+                             });
+    /* the witnesses are only looked up within the pruning radius, so a cell spans the reach of that radius */
+    if (!witnesses_)
+        witnesses_.reset(tools::getWitnessNearestNeighbors<Motion *>(this, std::sqrt(pruningRadius_)));
+    if (!witnesses_)
+        witnesses_.reset(tools::getDefaultNearestNeighbors<Motion *>(this));
+    witnesses_->setDistanceFunction([this](const Motion *a, const Motion *b)
+                                    {
+                                        return distanceFunction(a, b);
+                                    });
+    witness_grid_ = dynamic_cast<NearestNeighborsHashGrid<Motion *> *>(witnesses_.get());
 }
 
 ompl::base::PlannerStatus ompl::control::ConstraintRespectingBSST::solve(const base::PlannerTerminationCondition &ptc)
 {
     checkValidity();
+    allocNearestNeighbors_();
     base::Goal *goal = pdef_->getGoal().get();
     auto *goal_s = dynamic_cast<base::GoalSampleableRegion *>(goal);
 
     while (const base::State *st = pis_.nextStart())
     {
-        auto *motion = new Motion(siC_);
+        auto *motion = motion_arena_.create(siC_);
         si_->copyState(motion->state_, st);
         siC_->nullControl(motion->control_);
         nn_->add(motion);
+        trackFrontier_(motion->state_);
         motion->accCost_ = opt_->identityCost();
         findClosestWitness(motion);
     }
@@ -203,49 +760,84 @@ ompl::base::PlannerStatus ompl::control::ConstraintRespectingBSST::solve(const b
         sampler_ = si_->allocStateSampler();
     if (!controlSampler_)
         controlSampler_ = siC_->allocControlSampler();
+    if (!covarianceSampler_ && !reachableCovariance_)
+        reachableCovariance_ = std::make_shared<ReachableCovarianceSampler>(siC_, pdef_->getStartState(0),
+            20 * siC_->getMaxControlDuration());
+    if (takeSeed_())
+    {
+        rng_.setLocalSeed(nextSeed_());
+        seeding::seed(*sampler_, nextSeed_());
+        seeding::seed(*controlSampler_, nextSeed_());
+    }
 
-    OMPL_INFORM("%s: Starting planning with %u states already in datastructure\n", getName().c_str(), nn_->size());
+    KCBS_LOG_INFO(getName().c_str(), "start", "states", nn_->size());
 
     Motion *solution = nullptr;
     Motion *approxsol = nullptr;
     double approxdif = std::numeric_limits<double>::infinity();
     bool sufficientlyShort = false;
 
-    auto *rmotion = new Motion(siC_);
+    auto *rmotion = motion_arena_.create(siC_);
     base::State *rstate = rmotion->state_;
     Control *rctrl = rmotion->control_;
     base::State *xstate = si_->allocState();
+    SegmentPropagation propagation(siC_);
+    Candidates candidates;
+    if (batch_controls_ > 1 && num_threads_ <= 1)
+        allocCandidates_(candidates);
 
     unsigned iterations = 0;
 
     max_eigenvalue_ = 10.0; //TODO: make this general
 
-    while (ptc == false && solution == nullptr)
+    /* a fresh tree (only the start) is seeded by the nearest cached trajectories */
+    if (experience_ && nn_->size() == 1)
     {
+        std::vector<Motion *> roots;
+        nn_->list(roots);
+        solution = replayExperience_(roots.front(), goal);
+        if (solution)
+            approxdif = 0.0;
+    }
+
+    if (solution == nullptr && num_threads_ > 1)
+        solution = growParallel_(ptc, approxdif, iterations);
+    else while (ptc == false && solution == nullptr)
+    {
+        KCBS_TRACE_SCOPE("ConstraintRespectingBSST::iteration");
         /* sample random state (with goal biasing) */
-        if (goal_s && rng_.uniform01() < goalBias_ && goal_s->canSample())
+        const bool goal_sample = goal_s && rng_.uniform01() < goalBias_ && goal_s->canSample();
+        if (goal_sample)
             goal_s->sampleGoal(rstate);
         else
-            sampler_->sampleUniform(rstate);
-        // if (si_->getStateSpace()->isCompound()) {
-        //     rmotion->state_->as<base::CompoundStateSpace::StateType>()->as<R2BeliefSpace::StateType>(0)->setSigmaX(rng_.uniform01() * max_eigenvalue_);
-        //     rmotion->state_->as<base::CompoundStateSpace::StateType>()->as<R2BeliefSpace::StateType>(0)->setSigmaY(rng_.uniform01() * max_eigenvalue_);
-        // }
-        // else {
-        rmotion->state_->as<RealVectorBeliefSpace::StateType>()->sigma_(0, 0) = rng_.uniform01() * max_eigenvalue_;
-        rmotion->state_->as<RealVectorBeliefSpace::StateType>()->sigma_(1, 1) = rng_.uniform01() * max_eigenvalue_;
-        // }
+            sampleState_(*sampler_, rng_, rstate);
+        sampleCovariance_(rng_, rstate);
         
         /* find closest state in the tree */
         Motion *nmotion = selectNode(rmotion);
+        /* a few more samples away from the constraints at the steps of the extension */
+        for (unsigned int r = 0; r < constraintResamples_ && !goal_sample && headsIntoConstraints_(nmotion, rstate); r++)
+        {
+            sampleState_(*sampler_, rng_, rstate);
+            sampleCovariance_(rng_, rstate);
+            nmotion = selectNode(rmotion);
+        }
         // std::cout << "nmotion: " << nmotion << std::endl;
 
         /* sample a random control that attempts to go towards the random state, and also sample a control duration */
         // std::cout << "sample control" << std::endl;
-        controlSampler_->sample(rctrl);
-        // std::cout << "propagate" << std::endl;
-        unsigned int cd = rng_.uniformInt(siC_->getMinControlDuration(), siC_->getMaxControlDuration());
-        unsigned int propCd = siC_->propagateWhileValid(nmotion->state_, rctrl, cd, rstate);
+        unsigned int propCd, cd;
+        if (batch_controls_ > 1) {
+            // best of several controls, propagated together
+            cd = rng_.uniformInt(siC_->getMinControlDuration(), siC_->getMaxControlDuration());
+            propCd = propagateBestOf_(nmotion->state_, rstate, cd, *controlSampler_, candidates, rctrl);
+        }
+        else {
+            controlSampler_->sample(rctrl);
+            // std::cout << "propagate" << std::endl;
+            cd = rng_.uniformInt(siC_->getMinControlDuration(), siC_->getMaxControlDuration());
+            propCd = propagation.propagateWhileValid(nmotion->state_, rctrl, cd, rstate);
+        }
         // std::cout << "done propagating" << std::endl;
         if (propCd == cd)
         {
@@ -262,12 +854,16 @@ ompl::base::PlannerStatus ompl::control::ConstraintRespectingBSST::solve(const b
             // std::cout << closestWitness->rep_->accCost_ << std::endl;
             // exit(-1);
 
-            if (closestWitness->rep_ == rmotion || opt_->isCostBetterThan(cost, closestWitness->rep_->accCost_))
+            // the branch up to nmotion satisfies the constraints, so only the states of the new edge are checked (before
+            // a motion is built for it, as most edges of a heavily constrained agent are rejected)
+            base::State *const *edge = (batch_controls_ > 1) ? nullptr : propagation.lastSegment(cd);
+            if ((closestWitness->rep_ == rmotion || opt_->isCostBetterThan(cost, closestWitness->rep_->accCost_)) &&
+                (constraints_.empty() || edgeSatisfiesConstraints_(nmotion, rctrl, cd, edge)))
             {
                 // std::cout << "in true" << std::endl;
                 Motion *oldRep = closestWitness->rep_;
                 /* create a motion */
-                auto *motion = new Motion(siC_);
+                auto *motion = allocMotion_();
                 motion->accCost_ = cost;
                 motion->state_->as<RealVectorBeliefSpace::StateType>()->setCost(cost.value());
                 si_->copyState(motion->state_, rmotion->state_);
@@ -276,259 +872,104 @@ ompl::base::PlannerStatus ompl::control::ConstraintRespectingBSST::solve(const b
                 motion->parent_ = nmotion;
                 nmotion->numChildren_++;
 
-                if (!constraints_.empty()) {
-                    // get the path-segment from start ---> motion->state
-                    
-                    /* construct the solution path */
-        			std::vector<Motion *> mpath;
-        			Motion* mCpy = motion;
-        			while (mCpy != nullptr)
-        			{
-        			    mpath.push_back(mCpy);
-        			    mCpy = mCpy->parent_;
-        			}
-  
-        			/* set the solution path */
-        			oc::PathControl pathSegment(si_);
-        			for (int i = mpath.size() - 1; i >= 0; --i)
-        			    if (mpath[i]->parent_)
-        			        pathSegment.append(mpath[i]->state_, mpath[i]->control_, mpath[i]->steps_ * siC_->getPropagationStepSize());
-        			    else
-        			        pathSegment.append(mpath[i]->state_);
-                    pathSegment.interpolate();
-                    // check the path-segment for constraint validation prior to adding motion
-                    if (planValidator_->satisfiesConstraints(pathSegment, constraints_)) {
-                        closestWitness->linkRep(motion);
-
-                        nn_->add(motion);
-                        // if (si_->getStateSpace()->isCompound()) {
-                        //     if (motion->state_->as<ob::CompoundState>()->as<R2BeliefSpace::StateType>(0)->getCovariance()(0,0) > max_eigenvalue_)
-                        //     {
-                        //         max_eigenvalue_ = motion->state_->as<ob::CompoundState>()->as<R2BeliefSpace::StateType>(0)->getCovariance()(0,0);
-                        //     }
-                        //     else if (motion->state_->as<ob::CompoundState>()->as<R2BeliefSpace::StateType>(0)->getCovariance()(1,1) > max_eigenvalue_)
-                        //     {
-                        //         max_eigenvalue_ = motion->state_->as<ob::CompoundState>()->as<R2BeliefSpace::StateType>(0)->getCovariance()(1,1);
-                        //     }
-                        // }
-                        // else {
-                        if (motion->state_->as<RealVectorBeliefSpace::StateType>()->getCovariance()(0,0) > max_eigenvalue_)
-                        {
-                            max_eigenvalue_ = motion->state_->as<RealVectorBeliefSpace::StateType>()->getCovariance()(0,0);
-                        }
-                        else if (motion->state_->as<RealVectorBeliefSpace::StateType>()->getCovariance()(1,1) > max_eigenvalue_)
-                        {
-                            max_eigenvalue_ = motion->state_->as<RealVectorBeliefSpace::StateType>()->getCovariance()(1,1);
-                        }
-                        // }
-
-                        double dist = 0.0;
-                        bool solv = goal->isSatisfied(motion->state_, &dist);
-                        if (solv && opt_->isCostBetterThan(motion->accCost_, prevSolutionCost_))
-                        {
-                            approxdif = dist;
-                            solution = motion;
-
-                            for (auto &i : prevSolution_)
-                                if (i)
-                                    si_->freeState(i);
-                            prevSolution_.clear();
-                            for (auto &prevSolutionControl : prevSolutionControls_)
-                                if (prevSolutionControl)
-                                    siC_->freeControl(prevSolutionControl);
-                            prevSolutionControls_.clear();
-                            prevSolutionSteps_.clear();
-
-                            Motion *solTrav = solution;
-                            while (solTrav->parent_ != nullptr)
-                            {
-                                prevSolution_.push_back(si_->cloneState(solTrav->state_));
-                                prevSolutionControls_.push_back(siC_->cloneControl(solTrav->control_));
-                                prevSolutionSteps_.push_back(solTrav->steps_);
-                                solTrav = solTrav->parent_;
-                            }
-                            prevSolution_.push_back(si_->cloneState(solTrav->state_));
-                            prevSolutionCost_ = solution->accCost_;
-
-                            OMPL_INFORM("Found solution with cost %.2f", solution->accCost_.value());
-                            sufficientlyShort = opt_->isSatisfied(solution->accCost_);
-                            if (sufficientlyShort)
-                                break;
-                        }
-                        // removing the ability to return approximate solutions (HACK)
-                        // To-Do: Is there a way to set this behavior inside pdef_?
-                        // if (solution == nullptr && dist < approxdif)
-                        // {
-                        //     approxdif = dist;
-                        //     approxsol = motion;
-
-                        //     for (auto &i : prevSolution_)
-                        //         if (i)
-                        //             si_->freeState(i);
-                        //     prevSolution_.clear();
-                        //     for (auto &prevSolutionControl : prevSolutionControls_)
-                        //         if (prevSolutionControl)
-                        //             siC_->freeControl(prevSolutionControl);
-                        //     prevSolutionControls_.clear();
-                        //     prevSolutionSteps_.clear();
-
-                        //     Motion *solTrav = approxsol;
-                        //     while (solTrav->parent_ != nullptr)
-                        //     {
-                        //         prevSolution_.push_back(si_->cloneState(solTrav->state_));
-                        //         prevSolutionControls_.push_back(siC_->cloneControl(solTrav->control_));
-                        //         prevSolutionSteps_.push_back(solTrav->steps_);
-                        //         solTrav = solTrav->parent_;
-                        //     }
-                        //     prevSolution_.push_back(si_->cloneState(solTrav->state_));
-                        // }
-
-                        if (oldRep != rmotion)
-                        {
-                            while (oldRep->inactive_ && oldRep->numChildren_ == 0)
-                            {
-                                oldRep->inactive_ = true;
-                                nn_->remove(oldRep);
-
-                                if (oldRep->state_)
-                                    si_->freeState(oldRep->state_);
-                                if (oldRep->control_)
-                                    siC_->freeControl(oldRep->control_);
-
-                                oldRep->state_ = nullptr;
-                                oldRep->control_ = nullptr;
-                                oldRep->parent_->numChildren_--;
-                                Motion *oldRepParent = oldRep->parent_;
-                                delete oldRep;
-                                oldRep = oldRepParent;
-                            }
-                        }
-                    }
+                motion->timeStep_ = nmotion->timeStep_ + cd;
+
+                closestWitness->linkRep(motion);
+
+                nn_->add(motion);
+                trackFrontier_(motion->state_);
+
+                // if (DISTANCE_FUNC_ == 0){
+                //     if (motion->state_->as<RealVectorBeliefSpaceEuclidean::StateType>()->getCovariance()(0,0) > max_eigenvalue_)
+                //     {
+                //         max_eigenvalue_ = motion->state_->as<R2BeliefSpaceEuclidean::StateType>()->getCovariance()(0,0);
+                //     }
+                //     else if (motion->state_->as<R2BeliefSpaceEuclidean::StateType>()->getCovariance()(1,1) > max_eigenvalue_)
+                //     {
+                //         max_eigenvalue_ = motion->state_->as<R2BeliefSpaceEuclidean::StateType>()->getCovariance()(1,1);
+                //     }
+                // }
+                // else if (DISTANCE_FUNC_ == 1){
+                //     if (motion->state_->as<R2BeliefSpace::StateType>()->getCovariance()(0,0) > max_eigenvalue_)
+                //     {
+                //         max_eigenvalue_ = motion->state_->as<R2BeliefSpace::StateType>()->getCovariance()(0,0);
+                //     }
+                //     else if (motion->state_->as<R2BeliefSpace::StateType>()->getCovariance()(1,1) > max_eigenvalue_)
+                //     {
+                //         max_eigenvalue_ = motion->state_->as<R2BeliefSpace::StateType>()->getCovariance()(1,1);
+                //     }
+                // }
+                // if (si_->getStateSpace()->isCompound()) {
+                //     if (motion->state_->as<ob::CompoundState>()->as<R2BeliefSpace::StateType>(0)->getCovariance()(0,0) > max_eigenvalue_)
+                //     {
+                //         max_eigenvalue_ = motion->state_->as<ob::CompoundState>()->as<R2BeliefSpace::StateType>(0)->getCovariance()(0,0);
+                //     }
+                //     else if (motion->state_->as<ob::CompoundState>()->as<R2BeliefSpace::StateType>(0)->getCovariance()(1,1) > max_eigenvalue_)
+                //     {
+                //         max_eigenvalue_ = motion->state_->as<ob::CompoundState>()->as<R2BeliefSpace::StateType>(0)->getCovariance()(1,1);
+                //     }
+                // }
+                // else {
+                if (motion->state_->as<RealVectorBeliefSpace::StateType>()->getCovariance()(0,0) > max_eigenvalue_)
+                {
+                    max_eigenvalue_ = motion->state_->as<RealVectorBeliefSpace::StateType>()->getCovariance()(0,0);
                 }
-                else {
-                    // proceed as normal
-                    closestWitness->linkRep(motion);
-
-                    nn_->add(motion);
-
-                    // if (DISTANCE_FUNC_ == 0){
-                    //     if (motion->state_->as<RealVectorBeliefSpaceEuclidean::StateType>()->getCovariance()(0,0) > max_eigenvalue_)
-                    //     {
-                    //         max_eigenvalue_ = motion->state_->as<R2BeliefSpaceEuclidean::StateType>()->getCovariance()(0,0);
-                    //     }
-                    //     else if (motion->state_->as<R2BeliefSpaceEuclidean::StateType>()->getCovariance()(1,1) > max_eigenvalue_)
-                    //     {
-                    //         max_eigenvalue_ = motion->state_->as<R2BeliefSpaceEuclidean::StateType>()->getCovariance()(1,1);
-                    //     }
-                    // }
-                    // else if (DISTANCE_FUNC_ == 1){
-                    //     if (motion->state_->as<R2BeliefSpace::StateType>()->getCovariance()(0,0) > max_eigenvalue_)
-                    //     {
-                    //         max_eigenvalue_ = motion->state_->as<R2BeliefSpace::StateType>()->getCovariance()(0,0);
-                    //     }
-                    //     else if (motion->state_->as<R2BeliefSpace::StateType>()->getCovariance()(1,1) > max_eigenvalue_)
-                    //     {
-                    //         max_eigenvalue_ = motion->state_->as<R2BeliefSpace::StateType>()->getCovariance()(1,1);
-                    //     }
-                    // }
-                    // if (si_->getStateSpace()->isCompound()) {
-                    //     if (motion->state_->as<ob::CompoundState>()->as<R2BeliefSpace::StateType>(0)->getCovariance()(0,0) > max_eigenvalue_)
-                    //     {
-                    //         max_eigenvalue_ = motion->state_->as<ob::CompoundState>()->as<R2BeliefSpace::StateType>(0)->getCovariance()(0,0);
-                    //     }
-                    //     else if (motion->state_->as<ob::CompoundState>()->as<R2BeliefSpace::StateType>(0)->getCovariance()(1,1) > max_eigenvalue_)
-                    //     {
-                    //         max_eigenvalue_ = motion->state_->as<ob::CompoundState>()->as<R2BeliefSpace::StateType>(0)->getCovariance()(1,1);
-                    //     }
-                    // }
-                    // else {
-                    if (motion->state_->as<RealVectorBeliefSpace::StateType>()->getCovariance()(0,0) > max_eigenvalue_)
-                    {
-                        max_eigenvalue_ = motion->state_->as<RealVectorBeliefSpace::StateType>()->getCovariance()(0,0);
-                    }
-                    else if (motion->state_->as<RealVectorBeliefSpace::StateType>()->getCovariance()(1,1) > max_eigenvalue_)
-                    {
-                        max_eigenvalue_ = motion->state_->as<RealVectorBeliefSpace::StateType>()->getCovariance()(1,1);
-                    }
-                    // }
+                else if (motion->state_->as<RealVectorBeliefSpace::StateType>()->getCovariance()(1,1) > max_eigenvalue_)
+                {
+                    max_eigenvalue_ = motion->state_->as<RealVectorBeliefSpace::StateType>()->getCovariance()(1,1);
+                }
+                // }
 
-                    double dist = 0.0;
-                    bool solv = goal->isSatisfied(motion->state_, &dist);
-                    if (solv && opt_->isCostBetterThan(motion->accCost_, prevSolutionCost_))
-                    {
-                        approxdif = dist;
-                        solution = motion;
-
-                        for (auto &i : prevSolution_)
-                            if (i)
-                                si_->freeState(i);
-                        prevSolution_.clear();
-                        for (auto &prevSolutionControl : prevSolutionControls_)
-                            if (prevSolutionControl)
-                                siC_->freeControl(prevSolutionControl);
-                        prevSolutionControls_.clear();
-                        prevSolutionSteps_.clear();
-
-                        Motion *solTrav = solution;
-                        while (solTrav->parent_ != nullptr)
-                        {
-                            prevSolution_.push_back(si_->cloneState(solTrav->state_));
-                            prevSolutionControls_.push_back(siC_->cloneControl(solTrav->control_));
-                            prevSolutionSteps_.push_back(solTrav->steps_);
-                            solTrav = solTrav->parent_;
-                        }
-                        prevSolution_.push_back(si_->cloneState(solTrav->state_));
-                        prevSolutionCost_ = solution->accCost_;
-
-                        OMPL_INFORM("Found solution with cost %.2f", solution->accCost_.value());
-                        sufficientlyShort = opt_->isSatisfied(solution->accCost_);
-                        if (sufficientlyShort)
-                            break;
-                    }
-                    // removing the ability to return approximate solutions (HACK)
-                    // To-Do: Is there a way to set this behavior inside pdef_?
-                    // if (solution == nullptr && dist < approxdif)
-                    // {
-                    //     approxdif = dist;
-                    //     approxsol = motion;
-
-                    //     for (auto &i : prevSolution_)
-                    //         if (i)
-                    //             si_->freeState(i);
-                    //     prevSolution_.clear();
-                    //     for (auto &prevSolutionControl : prevSolutionControls_)
-                    //         if (prevSolutionControl)
-                    //             siC_->freeControl(prevSolutionControl);
-                    //     prevSolutionControls_.clear();
-                    //     prevSolutionSteps_.clear();
-
-                    //     Motion *solTrav = approxsol;
-                    //     while (solTrav->parent_ != nullptr)
-                    //     {
-                    //         prevSolution_.push_back(si_->cloneState(solTrav->state_));
-                    //         prevSolutionControls_.push_back(siC_->cloneControl(solTrav->control_));
-                    //         prevSolutionSteps_.push_back(solTrav->steps_);
-                    //         solTrav = solTrav->parent_;
-                    //     }
-                    //     prevSolution_.push_back(si_->cloneState(solTrav->state_));
-                    // }
-                    if (oldRep != rmotion)
+                double dist = 0.0;
+                bool solv = goal->isSatisfied(motion->state_, &dist) && satisfiesFinalConstraints_(motion->state_, motion->timeStep_);
+                if (solv && opt_->isCostBetterThan(motion->accCost_, prevSolutionCost_))
+                {
+                    approxdif = dist;
+                    solution = motion;
+
+                    storeSolution_(solution);
+
+                    KCBS_LOG_INFO(getName().c_str(), "solution", "cost", solution->accCost_.value());
+                    sufficientlyShort = opt_->isSatisfied(solution->accCost_);
+                    if (sufficientlyShort)
+                        break;
+                }
+                // removing the ability to return approximate solutions (HACK)
+                // To-Do: Is there a way to set this behavior inside pdef_?
+                // if (solution == nullptr && dist < approxdif)
+                // {
+                //     approxdif = dist;
+                //     approxsol = motion;
+
+                //     for (auto &i : prevSolution_)
+                //         if (i)
+                //             si_->freeState(i);
+                //     prevSolution_.clear();
+                //     for (auto &prevSolutionControl : prevSolutionControls_)
+                //         if (prevSolutionControl)
+                //             siC_->freeControl(prevSolutionControl);
+                //     prevSolutionControls_.clear();
+                //     prevSolutionSteps_.clear();
+
+                //     Motion *solTrav = approxsol;
+                //     while (solTrav->parent_ != nullptr)
+                //     {
+                //         prevSolution_.push_back(si_->cloneState(solTrav->state_));
+                //         prevSolutionControls_.push_back(siC_->cloneControl(solTrav->control_));
+                //         prevSolutionSteps_.push_back(solTrav->steps_);
+                //         solTrav = solTrav->parent_;
+                //     }
+                //     prevSolution_.push_back(si_->cloneState(solTrav->state_));
+                // }
+                if (oldRep != rmotion)
+                {
+                    while (oldRep->inactive_ && oldRep->numChildren_ == 0 && !oldRep->pinned_)
                     {
-                        while (oldRep->inactive_ && oldRep->numChildren_ == 0)
-                        {
-                            oldRep->inactive_ = true;
-                            nn_->remove(oldRep);
-                            if (oldRep->state_)
-                                si_->freeState(oldRep->state_);
-                            if (oldRep->control_)
-                                siC_->freeControl(oldRep->control_);
-                            oldRep->state_ = nullptr;
-                            oldRep->control_ = nullptr;
-                            oldRep->parent_->numChildren_--;
-                            Motion *oldRepParent = oldRep->parent_;
-                            delete oldRep;
-                            oldRep = oldRepParent;
-                        }
+                        oldRep->inactive_ = true;
+                        // recycled once nn_ purges it
+                        nn_->remove(oldRep);
+                        oldRep->parent_->numChildren_--;
+                        oldRep = oldRep->parent_;
                     }
                 }
             }
@@ -546,23 +987,22 @@ ompl::base::PlannerStatus ompl::control::ConstraintRespectingBSST::solve(const b
     if (solution != nullptr)
     {
         /* set the solution path */
-        auto path(std::make_shared<oc::PathControl>(si_));
-        for (int i = prevSolution_.size() - 1; i >= 1; --i)
-            path->append(prevSolution_[i], prevSolutionControls_[i - 1],
-                         prevSolutionSteps_[i - 1] * siC_->getPropagationStepSize());
-        path->append(prevSolution_[0]);
+        auto path = solutionPath_();
         solved = true;
         pdef_->addSolutionPath(path, approximate, approxdif, getName());
+        if (experience_ && !approximate)
+            recordExperience_();
     }
 
     si_->freeState(xstate);
+    freeCandidates_(candidates);
     if (rmotion->state_)
         si_->freeState(rmotion->state_);
     if (rmotion->control_)
         siC_->freeControl(rmotion->control_);
-    delete rmotion;
+    motion_arena_.destroy(rmotion);
 
-    OMPL_INFORM("%s: Created %u states in %u iterations", getName().c_str(), nn_->size(), iterations);
+    KCBS_LOG_INFO(getName().c_str(), "done", "states", nn_->size(), "iterations", iterations);
 
     return {solved, approximate};
 }
@@ -593,8 +1033,8 @@ void ompl::control::ConstraintRespectingBSST::getPlannerData(base::PlannerData &
 
     double delta = siC_->getPropagationStepSize();
 
-    if (prevSolution_.size() != 0)
-        data.addGoalVertex(base::PlannerDataVertex(prevSolution_[0]));
+    if (prevSolution_)
+        data.addGoalVertex(base::PlannerDataVertex(prevSolution_->state_));
 
     for (auto m : allMotions)
     {
@@ -638,8 +1078,8 @@ void ompl::control::ConstraintRespectingBSST::getPlannerDataAndCosts(base::Plann
 
     double delta = siC_->getPropagationStepSize();
 
-    if (prevSolution_.size() != 0)
-        data.addGoalVertex(base::PlannerDataVertex(prevSolution_[0]));
+    if (prevSolution_)
+        data.addGoalVertex(base::PlannerDataVertex(prevSolution_->state_));
 
     for (auto m : allMotions)
     {
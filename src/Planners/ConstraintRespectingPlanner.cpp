@@ -1,5 +1,50 @@
 #include "Planners/ConstraintRespectingPlanner.h"
+#include "PlanValidityCheckers/PlanValidityChecker.h"
+#include "Constraints/BeliefConstraint.h"
+#include "Constraints/DeterministicConstraint.h"
+#include <algorithm>
+#include <cmath>
 
 
 ConstraintRespectingPlanner::ConstraintRespectingPlanner(ob::SpaceInformationPtr si, std::string name):
 	ob::Planner(si, name){}
+
+void ConstraintRespectingPlanner::updateConstraints(const std::vector<ConstraintPtr> &c)
+{
+	/* clear old solutions */
+	pdef_->clearSolutionPaths();
+	/* update constraints */
+	constraints_ = c;
+	/* the index is built once here, and shared by every check until the next update */
+	constraint_index_ = (planValidator_ && !c.empty()) ? planValidator_->indexConstraints(c) : nullptr;
+	/* the regions of the positive constraints are sub-goals of the sampling */
+	subgoals_.clear();
+	for (const ConstraintPtr &constraint: c) {
+		if (!constraint->isPositive())
+			continue;
+		if (const auto *belief = dynamic_cast<const BeliefConstraint *>(constraint.get())) {
+			for (const BeliefConstraint::Record &r: belief->getRecords())
+				subgoals_.push_back({r.x_, r.y_, std::sqrt(std::max({r.s_xx_, r.s_yy_, 0.0}))});
+		}
+		else if (const auto *deterministic = dynamic_cast<const DeterministicConstraint *>(constraint.get())) {
+			for (const RobotFootprint &fp: deterministic->getShapes())
+				subgoals_.push_back({fp.cx_, fp.cy_, fp.r_});
+		}
+	}
+	/* keep the part of the old tree that satisfies the new constraints, or clear old data */
+	if (!warm_start_ || !pruneTree_())
+		clear();
+}
+
+void ConstraintRespectingPlanner::sampleSubgoal_(ompl::RNG &rng, ob::State *st) const
+{
+	const Subgoal &g = subgoals_[rng.uniformInt(0, subgoals_.size() - 1)];
+	CostToGoSampler::setPosition(si_->getStateSpace().get(), st, rng.gaussian(g.x_, g.sd_), rng.gaussian(g.y_, g.sd_));
+	si_->enforceBounds(st);
+}
+
+bool ConstraintRespectingPlanner::satisfiesFinalConstraints_(ob::State *st, const unsigned int step) const
+{
+	return !constraint_index_ || constraint_index_->positives_.empty() || 
+		planValidator_->satisfiesFinalConstraints(st, step, *constraint_index_);
+}
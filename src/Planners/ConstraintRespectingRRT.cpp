@@ -1,4 +1,5 @@
 #include "Planners/ConstraintRespectingRRT.h"
+#include "utils/Log.h"
 
 
 oc::ConstraintRespectingRRT::ConstraintRespectingRRT(const SpaceInformationPtr &si): 
@@ -8,6 +9,8 @@ oc::ConstraintRespectingRRT::ConstraintRespectingRRT(const SpaceInformationPtr &
     siC_ = si.get();
  
     ConstraintRespectingPlanner::declareParam<double>("goal_bias", this, &ConstraintRespectingRRT::setGoalBias, &ConstraintRespectingRRT::getGoalBias, "0.:.05:1.");
+    ConstraintRespectingPlanner::declareParam<double>("heuristic_bias", this, &ConstraintRespectingRRT::setHeuristicBias, &ConstraintRespectingRRT::getHeuristicBias, "0.:.05:1.");
+    ConstraintRespectingPlanner::declareParam<double>("subgoal_bias", this, &ConstraintRespectingRRT::setSubgoalBias, &ConstraintRespectingRRT::getSubgoalBias, "0.:.05:1.");
     ConstraintRespectingPlanner::declareParam<bool>("intermediate_states", this, &ConstraintRespectingRRT::setIntermediateStates, &ConstraintRespectingRRT::getIntermediateStates,
                                 "0,1");
 }
@@ -34,6 +37,8 @@ void oc::ConstraintRespectingRRT::clear()
     if (nn_)
         nn_->clear();
     lastGoalMotion_ = nullptr;
+    if (heuristic_)
+        heuristic_->reset();
 }
   
 void oc::ConstraintRespectingRRT::freeMemory()
@@ -53,6 +58,36 @@ void oc::ConstraintRespectingRRT::freeMemory()
     }
 }
 
+bool oc::ConstraintRespectingRRT::edgeSatisfiesConstraints_(const Motion *parent, const Control *ctrl, 
+    const unsigned int steps) const
+{
+    /* the edge covers the steps (parent, parent + steps]. The start state is checked with the edges that leave it */
+    const unsigned int first_step = parent->parent ? parent->timeStep + 1 : 0;
+    const unsigned int last_step = parent->timeStep + steps;
+    if (!constraint_index_ || !constraint_index_->overlaps(first_step, last_step))
+        return true;
+
+    std::vector<base::State *> edge;
+    siC_->propagate(parent->state, ctrl, steps, edge, true);
+    const bool satisfied = statesSatisfyConstraints_(parent, edge);
+    for (auto &st: edge)
+        si_->freeState(st);
+    return satisfied;
+}
+
+bool oc::ConstraintRespectingRRT::statesSatisfyConstraints_(const Motion *parent, const std::vector<base::State *> &edge) const
+{
+    if (!constraint_index_ || edge.empty())
+        return true;
+    const unsigned int first_step = parent->parent ? parent->timeStep + 1 : 0;
+    std::vector<base::State *> states;
+    if (!parent->parent)
+        states.push_back(parent->state);
+    states.insert(states.end(), edge.begin(), edge.end());
+    // only check the constraints if the edge comes near one of those whose window it overlaps
+    return planValidator_->checkConstraints(states, first_step, *constraint_index_);
+}
+
 ob::PlannerStatus oc::ConstraintRespectingRRT::solve(const ob::PlannerTerminationCondition &ptc)
 {
 	checkValidity();
@@ -67,6 +102,7 @@ ob::PlannerStatus oc::ConstraintRespectingRRT::solve(const ob::PlannerTerminatio
             si_->copyState(motion->state, st);
             siC_->nullControl(motion->control);
             nn_->add(motion);
+            trackFrontier_(motion->state);
         }
     }
     else
@@ -82,8 +118,14 @@ ob::PlannerStatus oc::ConstraintRespectingRRT::solve(const ob::PlannerTerminatio
         sampler_ = si_->allocStateSampler();
     if (!controlSampler_)
         controlSampler_ = siC_->allocDirectedControlSampler();
+    if (takeSeed_()) {
+        rng_.setLocalSeed(nextSeed_());
+        seeding::seed(*sampler_, nextSeed_());
+        if (!seeding::seed(*controlSampler_, nextSeed_()))
+            OMPL_WARN("%s: The directed control sampler cannot be seeded.", getName().c_str());
+    }
  
-    OMPL_INFORM("%s: Starting planning with %u states already in datastructure", getName().c_str(), nn_->size());
+    KCBS_LOG_INFO(getName().c_str(), "start", "states", nn_->size());
     // for (const Constraint *c: constraints_)
     // {
     //     std::cout << c->getTimes().front() << ", " << c->getTimes().back() << std::endl;
@@ -112,7 +154,7 @@ ob::PlannerStatus oc::ConstraintRespectingRRT::solve(const ob::PlannerTerminatio
         if (goal_s && rng_.uniform01() < goalBias_ && goal_s->canSample())
             goal_s->sampleGoal(rstate);
         else
-            sampler_->sampleUniform(rstate);
+            sampleState_(*sampler_, rng_, rstate);
  
         /* find closest state in the tree */
         Motion *nmotion = nn_->nearest(rmotion);
@@ -132,13 +174,14 @@ ob::PlannerStatus oc::ConstraintRespectingRRT::solve(const ob::PlannerTerminatio
  
             if (cd >= siC_->getMinControlDuration())
             {
-                OMPL_ERROR("Undefined Constraint Behaviour. Please impliment extensions when adding intermediate states.");
-                exit(1);
                 Motion *lastmotion = nmotion;
                 bool solved = false;
                 size_t p = 0;
                 for (; p < pstates.size(); ++p)
                 {
+                    /* only the new state is checked, at its step from the start */
+                    if (!statesSatisfyConstraints_(lastmotion, {pstates[p]}))
+                        break;
                     /* create a motion */
                     auto *motion = new Motion();
                     motion->state = pstates[p];
@@ -146,11 +189,13 @@ ob::PlannerStatus oc::ConstraintRespectingRRT::solve(const ob::PlannerTerminatio
                     motion->control = siC_->allocControl();
                     siC_->copyControl(motion->control, rctrl);
                     motion->steps = 1;
+                    motion->timeStep = lastmotion->timeStep + 1;
                     motion->parent = lastmotion;
                     lastmotion = motion;
                     nn_->add(motion);
+                    trackFrontier_(motion->state);
                     double dist = 0.0;
-                    solved = goal->isSatisfied(motion->state, &dist);
+                    solved = goal->isSatisfied(motion->state, &dist) && satisfiesFinalConstraints_(motion->state, motion->timeStep);
                     if (solved)
                     {
                         approxdif = dist;
@@ -164,7 +209,9 @@ ob::PlannerStatus oc::ConstraintRespectingRRT::solve(const ob::PlannerTerminatio
                     }
                 }
  
-                // free any states after we hit the goal
+                // free any states after we hit the goal (or after the first that violates a constraint)
+                if (p < pstates.size() && !solved)
+                    si_->freeState(pstates[p]);
                 while (++p < pstates.size())
                     si_->freeState(pstates[p]);
                 if (solved)
@@ -183,18 +230,16 @@ ob::PlannerStatus oc::ConstraintRespectingRRT::solve(const ob::PlannerTerminatio
                 si_->copyState(motion->state, rmotion->state);
                 siC_->copyControl(motion->control, rctrl);
                 motion->steps = cd;
+                motion->timeStep = nmotion->timeStep + cd;
                 motion->parent = nmotion;
-                if (!constraints_.empty())
+                if (constraint_index_)
                 {
-                    oc::PathControl p(si_);
-                    p.append(motion->parent->state);
-                    p.append(motion->state, motion->control, (motion->steps * siC_->getPropagationStepSize()));
-                    p.interpolate();
-                    if (planValidator_->satisfiesConstraints(p, constraints_))
+                    if (edgeSatisfiesConstraints_(nmotion, motion->control, cd))
                     {
                         nn_->add(motion);
+                        trackFrontier_(motion->state);
                         double dist = 0.0;
-                        bool solv = goal->isSatisfied(motion->state, &dist);
+                        bool solv = goal->isSatisfied(motion->state, &dist) && satisfiesFinalConstraints_(motion->state, motion->timeStep);
                         if (solv)
                         {
                             approxdif = dist;
@@ -208,14 +253,19 @@ ob::PlannerStatus oc::ConstraintRespectingRRT::solve(const ob::PlannerTerminatio
                         }
                     }
                     else
+                    {
+                        si_->freeState(motion->state);
+                        siC_->freeControl(motion->control);
                         delete motion;
+                    }
                 }
                 else
                 {
                     // no constraints given, proceed as normal 
                     nn_->add(motion);
+                    trackFrontier_(motion->state);
                     double dist = 0.0;
-                    bool solv = goal->isSatisfied(motion->state, &dist);
+                    bool solv = goal->isSatisfied(motion->state, &dist) && satisfiesFinalConstraints_(motion->state, motion->timeStep);
                     if (solv)
                     {
                         approxdif = dist;
@@ -264,7 +314,7 @@ ob::PlannerStatus oc::ConstraintRespectingRRT::solve(const ob::PlannerTerminatio
     delete rmotion;
     si_->freeState(xstate);
  
-    OMPL_INFORM("%s: Created %u states", getName().c_str(), nn_->size());
+    KCBS_LOG_INFO(getName().c_str(), "done", "states", nn_->size());
  
     return {solved, approximate};
 }
@@ -1,4 +1,19 @@
 #include "Planners/KCBS.h"
+#include "utils/Log.h"
+#include "utils/MapCache.h"
+#include "utils/TaskRuntime.h"
+#include "utils/Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <thread>
 
 
 // constructor
@@ -6,7 +21,26 @@ ompl::control::KCBS::KCBS(const MultiRobotProblemDefinitionPtr mrmp_pdef) :
 	base::Planner(mrmp_pdef->getRobotSpaceInformationPtr(0), "K-CBS"), 
 	mrmp_pdef_(mrmp_pdef), ready_(false), computation_time_(0), soc_(0)
 {
+	node_arena_.setAccounting(alloc::CONFLICT_TREE);
 	setUp_();
+	Planner::declareParam<bool>("bypass", this, &KCBS::setBypassing, &KCBS::getBypassing, "0,1");
+	Planner::declareParam<double>("pending_replan_slice", this, &KCBS::setPendingReplanSlice, &KCBS::getPendingReplanSlice, "0.1:.1:100.");
+	Planner::declareParam<double>("adaptive_low_level_time", this, &KCBS::setAdaptiveLowLevelTime, &KCBS::getAdaptiveLowLevelTime, "0.:.1:100.");
+	Planner::declareParam<bool>("background_pending_replans", this, &KCBS::setBackgroundPendingReplans, &KCBS::getBackgroundPendingReplans, "0,1");
+	Planner::declareParam<unsigned int>("pipeline_depth", this, &KCBS::setPipelineDepth, &KCBS::getPipelineDepth, "0:1:64");
+	Planner::declareParam<bool>("pipeline_ordered", this, &KCBS::setPipelineOrdered, &KCBS::getPipelineOrdered, "0,1");
+	Planner::declareParam<double>("conflict_window", this, &KCBS::setConflictWindow, &KCBS::getConflictWindow, "0.:1.:1000.");
+	Planner::declareParam<bool>("anytime", this, &KCBS::setAnytime, &KCBS::getAnytime, "0,1");
+	Planner::declareParam<bool>("lazy_expansion", this, &KCBS::setLazyExpansion, &KCBS::getLazyExpansion, "0,1");
+	Planner::declareParam<bool>("disjoint_splitting", this, &KCBS::setDisjointSplitting, &KCBS::getDisjointSplitting, "0,1");
+	Planner::declareParam<bool>("duplicate_detection", this, &KCBS::setDuplicateDetection, &KCBS::getDuplicateDetection, "0,1");
+	Planner::declareParam<double>("duplicate_resolution", this, &KCBS::setDuplicateResolution, &KCBS::getDuplicateResolution, "0.0001:.0001:1.");
+	Planner::declareParam<bool>("independence_detection", this, &KCBS::setIndependenceDetection, &KCBS::getIndependenceDetection, "0,1");
+	Planner::declareParam<bool>("all_conflicts", this, &KCBS::setAllConflicts, &KCBS::getAllConflicts, "0,1");
+	Planner::declareParam<bool>("conflict_classification", this, &KCBS::setConflictClassification, &KCBS::getConflictClassification, "0,1");
+	Planner::declareParam<unsigned int>("classification_limit", this, &KCBS::setClassificationLimit, &KCBS::getClassificationLimit, "1:1:1000");
+	Planner::declareParam<unsigned int>("steal_batch", this, &KCBS::setStealBatch, &KCBS::getStealBatch, "1:1:1024");
+	Planner::declareParam<double>("suboptimality_factor", this, &KCBS::setSuboptimalityFactor, &KCBS::getSuboptimalityFactor, "1.:.1:10.");
 	// These params are for benchmarking -- ignore for now
 	// Planner::declareParam<double>("goal_bias", this, &RRT::setGoalBias, &RRT::getGoalBias, "0.:.05:1.");
 	// Planner::declareParam<bool>("intermediate_states", this, &RRT::setIntermediateStates, &RRT::getIntermediateStates,
@@ -36,35 +70,19 @@ void ompl::control::KCBS::setUp_()
    	   	if ( (*itr)->getPlanner() ) {
    	   	   	low_level_planners_.push_back((*itr)->getPlanner());
    	   	}
+   	   	const oc::SpaceInformationPtr siPtr = (*itr)->getSpaceInformation();
+   	   	state_bytes_ = std::max<std::size_t>(state_bytes_, siPtr->getStateSpace()->getSerializationLength() + 
+   	   		siPtr->getControlSpace()->getSerializationLength() + 4 * sizeof(void*));
    	}
 
    	if (low_level_planners_.size() != mrmp_info.size()) {
    	   	return;
    	}
 
-   	/* initialize disjoint sets */
-   	for (int a1 = 0; a1 < mrmp_info.size(); a1++) {
-   	   	for (int a2 = 0; a2 < mrmp_info.size(); a2++) {
-   	   	   if (a1 != a2) {
-   	   	      	// does (a1, a2) exist in conf_counter_?
-   	   	      	bool add = true;
-   	   	      	for (int i = 0; i < conf_counter_.size(); i++) {
-   	   	      	   	std::pair<int, int> curr_pair = conf_counter_[i].first;
-   	   	      	   	if (curr_pair.first == a1 && curr_pair.second == a2)
-   	   	      	   		add = false;
-   	   	      	   	else if (curr_pair.first == a2 && curr_pair.second == a1)
-   	   	      	   		add = false;
-   	   	      	   	if (add == false)
-   	   	      	   		break;
-   	   	      	}
-   	   	      	if (add) {
-   	   	      	   	std::pair<int, int> agnt_pair{a1, a2};
-   	   	      	   	std::pair< std::pair<int, int>, int > conflict_count{agnt_pair, 0};
-   	   	      	   	conf_counter_.push_back(conflict_count);
-   	   	      	}
-   	   	   }
-   	   	}
-   	}
+   	/* initialize the (strictly upper triangular) conflict counter */
+   	num_agents_ = mrmp_info.size();
+   	conf_counter_.assign(num_agents_ * (num_agents_ - 1) / 2, 0);
+   	max_conflicts_ = 0;
    	ready_ = true;
 }
 
@@ -72,58 +90,1040 @@ ompl::control::KCBS::~KCBS()
 {
 	/* Free all allocated memory */
 	freeMemory_();
+	for (base::State *st: tree_states_)
+		si_->freeState(st);
 }
 
 void ompl::control::KCBS::freeMemory_()
 {
-	/* free all alocated memory */
-	OMPL_WARN("%s: freeMemory_ called but not yet implemented. Possible memory leak.", getName().c_str());
+	/* free all alocated memory (every node of the conflict tree, and with them, their constraints and planners) */
+	node_arena_.release();
+}
+
+oc::PathControl* ompl::control::KCBS::calcNewPath_(PlannerPtr planner, const KCBSNode::ConstraintRange &constraints, 
+	const base::PlannerTerminationCondition &ptc)
+{
+	const double budget = constraints.empty() ? mp_comp_time_ : 
+		lowLevelBudget_(constraints.front()->getConstrainedAgent(), constraints.size());
+	return calcNewPath_(planner, constraints, true, base::plannerOrTerminationCondition(ptc, 
+		base::timedPlannerTerminationCondition(budget)));
 }
 
-oc::PathControl* ompl::control::KCBS::calcNewPath_(PlannerPtr planner, std::vector<ConstraintPtr> constraints, bool restart)
+oc::PathControl* ompl::control::KCBS::calcNewPath_(PlannerPtr planner, const KCBSNode::ConstraintRange &constraints, bool restart, 
+	const base::PlannerTerminationCondition &ptc)
 {
+    KCBS_TRACE_SCOPE("KCBS::calcNewPath_");
+    const PhaseStart t0;
     // clear old solution
     planner->getProblemDefinition()->clearSolutionPaths();
     // for (int i = 0; i < mrmp_pdef_->getAllProblemInformation().size(); i++) {
     //     mrmp_pdef_->getRobotProblemDefinitionPtr(i)->clearSolutionPaths();
     // }
-	/* Update the constraints for planner and attempt to resolve them in mp_comp_time_ seconds */
+	/* Update the constraints for planner and attempt to resolve them before ptc is triggered */
 	/* If replanning was successful, return new path. Otherwise, return nullptr */
    	oc::PathControl *traj = nullptr;
-   	if (restart)
-   		planner->as<ConstraintRespectingPlanner>()->updateConstraints(constraints);
-   	ob::PlannerStatus solved = planner->as<ConstraintRespectingPlanner>()->solve(mp_comp_time_);
+   	std::vector<ConstraintPtr> windowed;
+   	if (restart) {
+   		/* constraints that begin after the conflict window are ignored (receding horizon) */
+   		for (const ConstraintPtr &c: constraints) {
+   			if (c->getTimes().empty() || c->getTimes().front() <= conflict_window_)
+   				windowed.push_back(c);
+   		}
+   		planner->as<ConstraintRespectingPlanner>()->updateConstraints(windowed);
+   	}
+   	/* a replan carries (at least) its new constraint, which names the agent */
+   	ob::PlannerStatus solved = (restart && !portfolio_.empty() && !constraints.empty()) ?
+   		racePortfolio_(planner, constraints.front()->getConstrainedAgent(), windowed, ptc) :
+   		planner->as<ConstraintRespectingPlanner>()->solve(ptc);
+   	const int agent = constraints.empty() ? -1 : constraints.front()->getConstrainedAgent();
    	if (solved==ob::PlannerStatus::EXACT_SOLUTION) {
-   	   	OMPL_INFORM("%s: Successfully Replanned.", getName().c_str());
+   	   	KCBS_LOG_INFO(getName().c_str(), "replanned", "agent", agent, "seconds", elapsed_(t0.time_));
+   	   	reportProgress_(ProgressEvent::LOW_LEVEL_SOLVED, -1, agent, -1, elapsed_(t0.time_));
+   	   	/* only fresh replans tell how long a replan takes (a resumed one continues the attempts before it) */
+   	   	if (restart && !constraints.empty())
+   	   		budget_.record(constraints.front()->getConstrainedAgent(), constraints.size(), elapsed_(t0.time_));
    	   	/* create new solution with updated traj. for conflicting agent */
    	   	traj = planner->getProblemDefinition()->getSolutionPath()->as<oc::PathControl>();
+   	   	recordTime_(stats_.low_level_, t0);
    	   	return traj;
    	}
    	else {
-   	   	OMPL_INFORM("Failed to replan.");
+   	   	KCBS_LOG_INFO(getName().c_str(), "replan_failed", "agent", agent, "seconds", elapsed_(t0.time_));
+   	   	reportProgress_(ProgressEvent::LOW_LEVEL_FAILED, -1, agent, -1, elapsed_(t0.time_));
+   	   	recordTime_(stats_.low_level_, t0, true);
    	   	return traj; // empty
    	}
 }
 
-bool ompl::control::KCBS::shouldMerge_(std::vector< std::pair< std::pair<int, int>, int> > &conf_cntr, const int agent1, const int agent2)
+double ompl::control::KCBS::lowLevelBudget_(const int agent, const std::size_t num_constraints, const unsigned int failures) const
 {
-	/* Update the global conflict counter */
-   	for (int i = 0; i < conf_cntr.size(); i++) {
-   	   	if ((conf_cntr[i].first.first == agent1) && (conf_cntr[i].first.second == agent2)) {
-   	   	   	conf_cntr[i].second = conf_cntr[i].second + 1;
-   	   	   	break;
-   	   	}
-   	   	else if ((conf_cntr[i].first.first == agent2) && (conf_cntr[i].first.second == agent1)) {
-   	   	   	conf_cntr[i].second = conf_cntr[i].second + 1;
-   	   	   	break;
-   	   	}
-   	}
-   	/* Check if the merge bound was triggered */
-   	for (int i = 0; i < conf_cntr.size(); i++) {
-		if (conf_cntr[i].second >= B_)
-			return true;
-   	}
-   	return false;
+	if (!adaptive_budget_)
+		return mp_comp_time_;
+	return budget_.budget(agent, num_constraints, failures, mp_comp_time_);
+}
+
+std::size_t ompl::control::KCBS::planBytes_(const KCBSNode *n) const
+{
+	std::size_t states = 0;
+	if (!n->getParent()) {
+		for (std::size_t a = 0; a < n->getDiscretePlan().size(); a++)
+			states += n->getTrajectory(a).getStateCount() + n->getDiscretePlan()[a].getStateCount();
+	}
+	else if (n->getConstraint() && !n->isLazy()) {
+		const int agent = n->getConstraint()->getConstrainedAgent();
+		states += n->getTrajectory(agent).getStateCount() + n->getDiscretePlan()[agent].getStateCount();
+	}
+	std::size_t bytes = states * state_bytes_;
+	if (const auto validation = n->getValidationCache()) {
+		for (const auto &pair: validation->pairs_) {
+			bytes += sizeof(pair) + 4 * sizeof(void*);
+			for (const std::vector<ConflictPtr> &interval: pair.second)
+				bytes += interval.size() * (sizeof(Conflict) + sizeof(ConflictPtr) + 2 * sizeof(void*));
+		}
+	}
+	return bytes;
+}
+
+bool ompl::control::KCBS::encodeNode_(const KCBSNode *n, ByteWriter &out) const
+{
+	/* oldest first, so the thief seeds the lists in the same order */
+	std::vector<ConstraintPtr> constraints;
+	for (std::size_t a = 0; a < num_agents_; a++) {
+		const std::size_t first = constraints.size();
+		for (const ConstraintPtr &c: n->getAgentConstraints(a))
+			constraints.push_back(c);
+		std::reverse(constraints.begin() + first, constraints.end());
+	}
+	ByteWriter node;
+	node.write(n->getCost());
+	node.write(std::uint32_t(constraints.size()));
+	for (const ConstraintPtr &c: constraints) {
+		if (!encodeConstraint(node, *c))
+			return false;
+	}
+	out.data().append(node.data());
+	return true;
+}
+
+ompl::control::KCBS::KCBSNode *ompl::control::KCBS::rebuildNode_(const std::vector<ConstraintPtr> &constraints, 
+	const Plan &root_plan, const int id, const base::PlannerTerminationCondition &ptc)
+{
+	KCBSNode *n = node_arena_.create();
+	n->id = id;
+	for (const ConstraintPtr &c: constraints)
+		n->seedConstraint(c, constraintHash_(c));
+	const bool have_root = (root_plan.size() == num_agents_);
+	Plan plan;
+	for (std::size_t a = 0; a < num_agents_; a++) {
+		const KCBSNode::ConstraintRange agent_constraints = n->getAgentConstraints(a);
+		if (have_root && agent_constraints.empty()) {
+			plan.push_back(root_plan[a]);
+			continue;
+		}
+		/* a few attempts on the same tree, so a hard node does not keep the rank from answering the others */
+		PlannerPtr planner = mrmp_pdef_->getRobotMotionPlanningProblemPtr(a)->getPlanner();
+		seedLowLevel_(planner, "replan", id, a);
+		oc::PathControl *path = nullptr;
+		for (int attempt = 0; !path && attempt < 3 && ptc == false; attempt++)
+			path = calcNewPath_(planner, agent_constraints, attempt == 0, base::plannerOrTerminationCondition(ptc, 
+				base::timedPlannerTerminationCondition(lowLevelBudget_(a, agent_constraints.size(), attempt))));
+		if (!path) {
+			OMPL_INFORM("%s: Unable to replan agent %zu of a stolen node. Discarding node.", getName().c_str(), a);
+			return nullptr;
+		}
+		plan.push_back(*path);
+	}
+	n->updatePlanAndCost(plan);
+	return n;
+}
+
+ompl::base::PlannerStatus ompl::control::KCBS::racePortfolio_(const PlannerPtr &planner, const int agent, 
+	const std::vector<ConstraintPtr> &constraints, const base::PlannerTerminationCondition &ptc)
+{
+	KCBS_TRACE_SCOPE("KCBS::racePortfolio_");
+	/* the members with the best win rates race, an untried member counts as winning half its races */
+	std::vector<std::size_t> members(portfolio_.size());
+	std::iota(members.begin(), members.end(), 0);
+	{
+		std::lock_guard<std::mutex> lock(stats_mutex_);
+		auto rate = [this](const std::size_t m) {return (portfolio_[m].wins_ + 1.0) / (portfolio_[m].races_ + 2.0);};
+		std::stable_sort(members.begin(), members.end(), [&rate](const std::size_t m1, const std::size_t m2) {
+			return rate(m1) > rate(m2);});
+		if (portfolio_width_ > 0 && members.size() >= portfolio_width_)
+			members.resize(portfolio_width_ - 1);
+		for (const std::size_t m: members)
+			portfolio_[m].races_++;
+	}
+
+	/* every member plans on its own clone of the problem, under the same constraints */
+	const std::uint32_t seed = planner->as<ConstraintRespectingPlanner>()->getSeed();
+	std::vector<PlannerPtr> racers{planner};
+	for (const std::size_t m: members) {
+		PlannerPtr clone = mrmp_pdef_->clonePlanner(agent, portfolio_[m].planner_, portfolio_[m].params_);
+		if (clone) {
+			clone->as<ConstraintRespectingPlanner>()->updateConstraints(constraints);
+			if (seed != 0)
+				clone->as<ConstraintRespectingPlanner>()->setSeed(seeding::derive(seed, m + 1));
+		}
+		racers.push_back(clone);
+	}
+
+	/* the first exact solution stops the others */
+	std::atomic<int> winner{-1};
+	const base::PlannerTerminationCondition race_ptc = base::plannerOrTerminationCondition(ptc, 
+		base::PlannerTerminationCondition([&winner] { return winner >= 0; }));
+	auto race = [&racers, &winner, &race_ptc](const int r) {
+		if (!racers[r])
+			return;
+		if (racers[r]->as<ConstraintRespectingPlanner>()->solve(race_ptc) == base::PlannerStatus::EXACT_SOLUTION) {
+			int none = -1;
+			winner.compare_exchange_strong(none, r);
+		}
+	};
+	// (a racer that has not started when the race ends is dropped)
+	TaskGroup group(&race_ptc);
+	group.runAndWait(racers.size(), [&race](const std::size_t r) {race(r);});
+	if (winner < 0)
+		return base::PlannerStatus::TIMEOUT;
+
+	std::lock_guard<std::mutex> lock(stats_mutex_);
+	/* resolve() replans before solve() resets the statistics */
+	stats_.portfolio_wins_.resize(portfolio_.size() + 1, 0);
+	if (winner == 0) {
+		stats_.portfolio_wins_[0]++;
+		return base::PlannerStatus::EXACT_SOLUTION;
+	}
+	const std::size_t m = members[winner - 1];
+	portfolio_[m].wins_++;
+	stats_.portfolio_wins_[m + 1]++;
+	/* the path is owned by the caller's planner, whose tree is kept for the node if it fails later */
+	const base::ProblemDefinitionPtr &pdef = planner->getProblemDefinition();
+	pdef->clearSolutionPaths();
+	pdef->addSolutionPath(std::make_shared<PathControl>(*racers[winner]->getProblemDefinition()->getSolutionPath()->as<PathControl>()),
+		false, 0.0, racers[winner]->getName());
+	return base::PlannerStatus::EXACT_SOLUTION;
+}
+
+bool ompl::control::KCBS::parsePortfolio(const std::string &spec, std::vector<PortfolioMember> &portfolio)
+{
+	portfolio.clear();
+	std::stringstream members(spec);
+	std::string member;
+	while (std::getline(members, member, ';')) {
+		if (member.empty())
+			continue;
+		PortfolioMember m;
+		const std::size_t colon = member.find(':');
+		m.planner_ = member.substr(0, colon);
+		if (m.planner_ != "BSST" && m.planner_ != "RRT")
+			return false;
+		if (colon != std::string::npos) {
+			std::stringstream params(member.substr(colon + 1));
+			std::string param;
+			while (std::getline(params, param, ',')) {
+				const std::size_t eq = param.find('=');
+				if (eq == 0 || eq == std::string::npos)
+					return false;
+				m.params_[param.substr(0, eq)] = param.substr(eq + 1);
+			}
+		}
+		portfolio.push_back(m);
+	}
+	return true;
+}
+
+void ompl::control::KCBS::validateNode_(KCBSNode *n)
+{
+	const PhaseStart t0;
+	/* Only the constrained agent differs from the parent plan, so only its pairs are re-checked */
+	auto validation = std::make_shared<PlanValidityChecker::ValidationCache>();
+	int changed_agent = -1;
+	if (n->getParent() && n->getParent()->getValidationCache()) {
+		*validation = *n->getParent()->getValidationCache();
+		changed_agent = n->getConstraint()->getConstrainedAgent();
+	}
+	std::vector<ConflictPtr> confs;
+	std::unique_lock<std::mutex> lock = lockShared_();
+	if (all_conflicts_ || conflict_classification_) {
+		auto intervals = std::make_shared<std::vector<std::vector<ConflictPtr>>>(
+			mrmp_pdef_->getPlanValidator()->validatePlanAll(n->getDiscretePlan(), changed_agent, *validation, group_));
+		if (!intervals->empty())
+			confs = intervals->front();
+		n->saveConflictIntervals(intervals);
+	}
+	else {
+		confs = mrmp_pdef_->getPlanValidator()->validatePlanIncremental(n->getDiscretePlan(), changed_agent, *validation, group_);
+		n->saveConflictIntervals(nullptr);
+	}
+	lock = std::unique_lock<std::mutex>();
+	int num_conflicts = 0;
+	for (auto itr = validation->pairs_.begin(); itr != validation->pairs_.end(); itr++) {
+		if (!itr->second.empty())
+			num_conflicts++;
+	}
+	n->saveValidationCache(validation);
+	n->saveConflicts(confs, num_conflicts);
+	recordTime_(stats_.validation_, t0);
+}
+
+const std::vector<ConflictPtr> &ompl::control::KCBS::selectConflict_(const KCBSNode *n)
+{
+	KCBS_TRACE_SCOPE("KCBS::selectConflict_");
+	const PhaseStart t0;
+	const std::shared_ptr<const std::vector<std::vector<ConflictPtr>>> intervals = n->getConflictIntervals();
+	if (!intervals || intervals->empty())
+		return n->getConflicts();
+	/* the rises of both children (0 to 2) of every classified interval, the first cardinal one ends the search */
+	std::size_t best = 0;
+	int best_rises = -1;
+	const std::size_t limit = std::min<std::size_t>(intervals->size(), classification_limit_);
+	for (std::size_t i = 0; i < limit && best_rises < 2; i++) {
+		const std::vector<ConflictPtr> &interval = (*intervals)[i];
+		int rises = 0;
+		for (const int agent: {interval.front()->agent1Idx_, interval.front()->agent2Idx_}) {
+			if (raisesCost_(n, interval, agent))
+				rises++;
+		}
+		if (rises > best_rises) {
+			best = i;
+			best_rises = rises;
+		}
+	}
+	if (best_rises == 2)
+		stats_.cardinal_++;
+	else if (best_rises == 1)
+		stats_.semi_cardinal_++;
+	else
+		stats_.non_cardinal_++;
+	recordTime_(stats_.classification_, t0);
+	return (*intervals)[best];
+}
+
+bool ompl::control::KCBS::raisesCost_(const KCBSNode *n, const std::vector<ConflictPtr> &interval, const int agent)
+{
+	/* a meta-agent gets no constraint, so it has no child */
+	if (n->isMerged(agent))
+		return false;
+	PlannerPtr planner = mrmp_pdef_->getRobotMotionPlanningProblemPtr(agent)->getPlanner();
+	const ConstraintRespectingPlanner *crp = dynamic_cast<const ConstraintRespectingPlanner *>(planner.get());
+	if (!crp || !crp->canProbePaths())
+		return false;
+	const KCBSNode::ConstraintRange branch = n->getAgentConstraints(agent);
+	std::vector<ConstraintPtr> constraints(branch.begin(), branch.end());
+	{
+		const std::unique_lock<std::mutex> lock = lockShared_();
+		constraints.push_back(mrmp_pdef_->getPlanValidator()->createConstraint(n->getDiscretePlan(), interval, agent));
+	}
+	return !crp->hasPathWithin(constraints, n->getTrajectoryCost(agent));
+}
+
+double ompl::control::KCBS::elapsed_(const std::chrono::steady_clock::time_point &t0)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void ompl::control::KCBS::recordTime_(PhaseTime &phase, const PhaseStart &t0, const bool failed)
+{
+	/* the low-level planners may run on worker threads */
+	const double t = elapsed_(t0.time_);
+	const perf::Counters c = perf::read() - t0.counters_;
+	std::lock_guard<std::mutex> lock(stats_mutex_);
+	phase.add(t, c);
+	if (failed)
+		stats_.low_level_failures_++;
+}
+
+void ompl::control::KCBS::seedLowLevel_(const PlannerPtr &planner, const char *event, const int node, const int agent)
+{
+	/* the root plans are seeded by agent, the replans by their order in the search */
+	std::uint32_t seed = 0;
+	{
+		std::lock_guard<std::mutex> lock(replay_mutex_);
+		if (seed_ != 0)
+			seed = seeding::derive(seed_, (node < 0) ? agent : num_agents_ + low_level_calls_++);
+	}
+	if (seed != 0) {
+		if (auto *p = dynamic_cast<ConstraintRespectingPlanner *>(planner.get()))
+			p->setSeed(seed);
+	}
+	recordReplay_(event, node, agent, seed);
+}
+
+void ompl::control::KCBS::recordReplay_(const char *event, const int node, const int agent, const std::uint32_t seed)
+{
+	std::lock_guard<std::mutex> lock(replay_mutex_);
+	replay_.push_back({event, node, agent, seed});
+}
+
+void ompl::control::KCBS::reportProgress_(const ProgressEvent::Type type, const int node, const int agent, const int other, 
+	const double value)
+{
+	if (!progress_)
+		return;
+	if (!progress_->push({type, node, agent, other, value, elapsed_(progress_start_)}))
+		progress_dropped_++;
+}
+
+void ompl::control::KCBS::recordTreeNode_(const KCBSNode *n, const bool expanded, const bool solution)
+{
+	if (n->id < 0)
+		return;
+	std::lock_guard<std::mutex> lock(tree_mutex_);
+	if (tree_.size() <= static_cast<std::size_t>(n->id))
+		tree_.resize(n->id + 1);
+	TreeRecord &r = tree_[n->id];
+	r.parent_ = n->getParent() ? n->getParent()->id : -1;
+	r.cost_ = n->getCost();
+	r.queued_ = true;
+	r.expanded_ = r.expanded_ || expanded;
+	r.solution_ = r.solution_ || solution;
+}
+
+void ompl::control::KCBS::getPlannerData(base::PlannerData &data) const
+{
+	Planner::getPlannerData(data);
+	std::lock_guard<std::mutex> lock(tree_mutex_);
+	/* PlannerData tells its vertices apart by their states, so every node gets one */
+	const base::State *start = mrmp_pdef_->getRobotProblemDefinitionPtr(0)->getStartState(0);
+	while (tree_states_.size() < tree_.size()) {
+		tree_states_.push_back(si_->allocState());
+		if (start)
+			si_->copyState(tree_states_.back(), start);
+	}
+	auto vertex = [this](const int id) {return base::PlannerDataVertex(tree_states_[id], id);};
+	for (std::size_t id = 0; id < tree_.size(); id++) {
+		const TreeRecord &r = tree_[id];
+		if (!r.queued_)
+			continue;
+		data.addVertex(vertex(id));
+		if (r.parent_ < 0)
+			data.markStartState(tree_states_[id]);
+		if (r.solution_)
+			data.markGoalState(tree_states_[id]);
+	}
+	for (std::size_t id = 0; id < tree_.size(); id++) {
+		const TreeRecord &r = tree_[id];
+		if (r.queued_ && r.parent_ >= 0 && static_cast<std::size_t>(r.parent_) < tree_.size() && tree_[r.parent_].queued_)
+			data.addEdge(vertex(r.parent_), vertex(id), base::PlannerDataEdge(), base::Cost(r.cost_));
+	}
+}
+
+bool ompl::control::KCBS::writeReplayLog(const std::string &filename) const
+{
+	std::ofstream out(filename);
+	if (!out.is_open()) {
+		OMPL_ERROR("%s: Unable to open ``%s``.", getName().c_str(), filename.c_str());
+		return false;
+	}
+	out << "# seed " << seed_ << "\n";
+	out << "event,node,agent,seed\n";
+	for (const ReplayEvent &e: replay_)
+		out << e.event_ << "," << e.node_ << "," << e.agent_ << "," << e.seed_ << "\n";
+	return static_cast<bool>(out);
+}
+
+namespace
+{
+	const char checkpoint_magic[8] = {'K', 'C', 'B', 'S', 'C', 'K', 'P', 'T'};
+	const std::uint32_t checkpoint_version = 2;
+}
+
+bool ompl::control::KCBS::writeCheckpoint_(const Plan &root_plan, const std::vector<const KCBSNode*> &queued, 
+	const std::vector<const KCBSNode*> &waiting, const KCBSNode *solution, const int count, const double elapsed)
+{
+	const PhaseStart t0;
+	/* every trajectory is written once, however many nodes share it, and the nodes refer to it by index */
+	std::map<const PathControl*, std::uint32_t> index;
+	ByteWriter trajs;
+	auto trajectory = [&](const int agent, const PathControl &traj) {
+		auto itr = index.find(&traj);
+		if (itr == index.end()) {
+			itr = index.emplace(&traj, index.size()).first;
+			trajs.write(std::uint32_t(agent));
+			encodeTrajectory(trajs, traj);
+		}
+		return itr->second;
+	};
+	/* a node is written with the plan it holds (that of its parent if lazy), its meta-agents (the merged agents, and the
+	   meta-agent of each), and the constraints of its branch (oldest first). The constraint of a lazy node comes first, it
+	   is the one replanned once the node is popped */
+	ByteWriter nodes;
+	std::uint32_t num_nodes = 0;
+	auto node = [&](const KCBSNode *n, const KCBSNode *plan, const bool lazy) {
+		nodes.write(std::uint8_t(lazy));
+		nodes.write(std::int32_t(n->id));
+		for (std::size_t a = 0; a < num_agents_; a++)
+			nodes.write(trajectory(a, plan->getTrajectory(a)));
+		std::vector<int> merged;
+		for (std::size_t a = 0; a < num_agents_; a++) {
+			if (n->isMerged(a))
+				merged.push_back(a);
+		}
+		nodes.write(std::uint32_t(merged.size()));
+		for (const int a: merged) {
+			nodes.write(std::int32_t(a));
+			nodes.write(std::int32_t((*n->getMetaAgents())[a]));
+		}
+		std::vector<ConstraintPtr> constraints;
+		if (lazy)
+			constraints.push_back(n->getConstraint());
+		for (std::size_t a = 0; a < num_agents_; a++) {
+			const std::size_t first = constraints.size();
+			for (const ConstraintPtr &c: n->getAgentConstraints(a)) {
+				if (!lazy || c != n->getConstraint())
+					constraints.push_back(c);
+			}
+			std::reverse(constraints.begin() + first, constraints.end());
+		}
+		nodes.write(std::uint32_t(constraints.size()));
+		for (const ConstraintPtr &c: constraints) {
+			if (!encodeConstraint(nodes, *c))
+				return false;
+		}
+		num_nodes++;
+		return true;
+	};
+	bool encoded = true;
+	const bool has_root = (root_plan.size() == num_agents_);
+	std::vector<std::uint32_t> root(num_agents_, 0);
+	for (std::size_t a = 0; has_root && a < num_agents_; a++)
+		root[a] = trajectory(a, root_plan[a]);
+	const bool has_solution = (solution != nullptr);
+	std::vector<std::uint32_t> solved(num_agents_, 0);
+	for (std::size_t a = 0; has_solution && a < num_agents_; a++)
+		solved[a] = trajectory(a, solution->getTrajectory(a));
+	for (const KCBSNode *n: queued)
+		encoded = encoded && node(n, n, n->isLazy() && n->getParent());
+	/* a node waiting for its replan is saved as a lazy node, with the plan it was replanned from */
+	for (const KCBSNode *n: waiting)
+		encoded = encoded && node(n, (n->getNumTrajectories() > 0) ? n : n->getParent(), true);
+	if (!encoded) {
+		OMPL_WARN("%s: A constraint cannot be written to a checkpoint.", getName().c_str());
+		return false;
+	}
+
+	ByteWriter out;
+	out.data().append(checkpoint_magic, sizeof(checkpoint_magic));
+	out.write(checkpoint_version);
+	out.write(std::uint32_t(num_agents_));
+	out.write(seed_);
+	out.write(low_level_calls_);
+	out.write(std::int32_t(count));
+	out.write(std::uint32_t(num_expansions_));
+	out.write(elapsed);
+	out.write(std::uint32_t(conf_counter_.size()));
+	for (const int c: conf_counter_)
+		out.write(std::int32_t(c));
+	out.write(std::int32_t(max_conflicts_));
+	out.write(std::uint64_t(closed_.size()));
+	for (const std::size_t h: closed_)
+		out.write(std::uint64_t(h));
+	out.write(std::uint8_t(has_root));
+	for (const std::uint32_t t: root)
+		out.write(t);
+	out.write(std::uint8_t(has_solution));
+	for (const std::uint32_t t: solved)
+		out.write(t);
+	out.write(std::uint32_t(index.size()));
+	out.data().append(trajs.data());
+	out.write(num_nodes);
+	out.data().append(nodes.data());
+
+	/* written aside and renamed over the checkpoint, so a job killed while writing keeps the previous one */
+	const std::string tmp = checkpoint_file_ + ".tmp";
+	{
+		std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+		file.write(out.data().data(), out.data().size());
+		if (!file) {
+			OMPL_WARN("%s: Unable to write the checkpoint ``%s``.", getName().c_str(), tmp.c_str());
+			return false;
+		}
+	}
+	if (std::rename(tmp.c_str(), checkpoint_file_.c_str()) != 0) {
+		OMPL_WARN("%s: Unable to write the checkpoint ``%s``.", getName().c_str(), checkpoint_file_.c_str());
+		return false;
+	}
+	OMPL_INFORM("%s: Checkpointed %u nodes and %zu trajectories (%zu bytes) in %0.3f seconds.", getName().c_str(), 
+		num_nodes, index.size(), out.data().size(), elapsed_(t0.time_));
+	return true;
+}
+
+bool ompl::control::KCBS::readCheckpoint_(const std::string &data, Plan &root_plan, std::vector<KCBSNode*> &nodes, 
+	KCBSNode *&solution, int &count, double &elapsed)
+{
+	ByteReader in(data);
+	char magic[sizeof(checkpoint_magic)];
+	std::uint32_t version, agents, seed, expansions, num_counts;
+	std::uint64_t calls, num_closed;
+	std::int32_t node_count, max_conflicts;
+	if (!in.read(magic) || std::memcmp(magic, checkpoint_magic, sizeof(magic)) != 0 || !in.read(version) || 
+		version != checkpoint_version || !in.read(agents) || agents != num_agents_ || !in.read(seed) || 
+		!in.read(calls) || !in.read(node_count) || !in.read(expansions) || !in.read(elapsed) || 
+		!in.read(num_counts) || num_counts != conf_counter_.size())
+		return false;
+	std::vector<int> conf_counter(num_counts);
+	for (int &c: conf_counter) {
+		std::int32_t v;
+		if (!in.read(v))
+			return false;
+		c = v;
+	}
+	if (!in.read(max_conflicts) || !in.read(num_closed) || num_closed > in.remaining() / sizeof(std::uint64_t))
+		return false;
+	std::unordered_set<std::size_t> closed;
+	for (std::uint64_t i = 0; i < num_closed; i++) {
+		std::uint64_t h;
+		in.read(h);
+		closed.insert(h);
+	}
+	std::uint8_t has_root, has_solution;
+	std::vector<std::uint32_t> root(num_agents_), solved(num_agents_);
+	bool valid = in.read(has_root);
+	for (std::uint32_t &t: root)
+		valid = valid && in.read(t);
+	valid = valid && in.read(has_solution);
+	for (std::uint32_t &t: solved)
+		valid = valid && in.read(t);
+	std::uint32_t num_trajs;
+	if (!valid || !in.read(num_trajs) || num_trajs > in.remaining())
+		return false;
+
+	/* the restored nodes share the trajectories (and their interpolations), as the nodes that were written did */
+	std::vector<std::uint32_t> owners;
+	std::vector<KCBSNode::TrajectoryPtr> trajs, discrete;
+	for (std::uint32_t t = 0; t < num_trajs; t++) {
+		std::uint32_t agent;
+		if (!in.read(agent) || agent >= num_agents_)
+			return false;
+		const oc::SpaceInformationPtr si = mrmp_pdef_->getRobotSpaceInformationPtr(agent);
+		oc::PathControl path(si);
+		if (!decodeTrajectory(in, si, path))
+			return false;
+		owners.push_back(agent);
+		trajs.push_back(std::make_shared<const PathControl>(path));
+		discrete.push_back(DiscretePlan::discretize(trajs.back()));
+	}
+	/* the trajectories of a plan, one per agent in order */
+	auto plan = [&](const std::vector<std::uint32_t> &idx, std::vector<KCBSNode::TrajectoryPtr> &plan_trajs, 
+		std::vector<KCBSNode::TrajectoryPtr> &plan_discrete) {
+		plan_trajs.clear();
+		plan_discrete.clear();
+		for (std::size_t a = 0; a < num_agents_; a++) {
+			if (idx[a] >= trajs.size() || owners[idx[a]] != a)
+				return false;
+			plan_trajs.push_back(trajs[idx[a]]);
+			plan_discrete.push_back(discrete[idx[a]]);
+		}
+		return true;
+	};
+	std::vector<KCBSNode::TrajectoryPtr> plan_trajs, plan_discrete;
+	root_plan.clear();
+	if (has_root) {
+		if (!plan(root, plan_trajs, plan_discrete))
+			return false;
+		for (const KCBSNode::TrajectoryPtr &traj: plan_trajs)
+			root_plan.push_back(*traj);
+	}
+	solution = nullptr;
+	if (has_solution) {
+		if (!plan(solved, plan_trajs, plan_discrete))
+			return false;
+		solution = node_arena_.create();
+		solution->id = -1;
+		solution->setPlan(plan_trajs, plan_discrete);
+	}
+
+	std::uint32_t num_nodes;
+	if (!in.read(num_nodes) || num_nodes > in.remaining())
+		return false;
+	/* a lazy node is replanned from the plan of its parent, so it gets a parent holding that plan (not queued, and 
+	   shared by the siblings that had the same plan) */
+	std::map<std::vector<std::uint32_t>, KCBSNode*> parents;
+	nodes.clear();
+	for (std::uint32_t i = 0; i < num_nodes; i++) {
+		std::uint8_t lazy;
+		std::int32_t id;
+		std::vector<std::uint32_t> idx(num_agents_);
+		valid = in.read(lazy) && in.read(id);
+		for (std::uint32_t &t: idx)
+			valid = valid && in.read(t);
+		std::uint32_t num_merged;
+		valid = valid && in.read(num_merged) && num_merged <= num_agents_;
+		std::shared_ptr<std::vector<int>> meta;
+		for (std::uint32_t m = 0; valid && m < num_merged; m++) {
+			std::int32_t agent, id;
+			valid = in.read(agent) && in.read(id) && agent >= 0 && agent < num_agents_ && id >= 0 && id < num_agents_;
+			if (!valid)
+				break;
+			if (!meta)
+				meta = std::make_shared<std::vector<int>>(num_agents_, -1);
+			(*meta)[agent] = id;
+		}
+		std::uint32_t num_constraints;
+		if (!valid || !in.read(num_constraints) || num_constraints > in.remaining() || (lazy && num_constraints == 0) || 
+			!plan(idx, plan_trajs, plan_discrete))
+			return false;
+		std::vector<ConstraintPtr> constraints;
+		for (std::uint32_t c = 0; c < num_constraints; c++) {
+			ConstraintPtr constraint = decodeConstraint(in);
+			if (!constraint || constraint->getConstrainedAgent() < 0 || constraint->getConstrainedAgent() >= num_agents_)
+				return false;
+			constraints.push_back(constraint);
+		}
+		KCBSNode *n = node_arena_.create();
+		n->id = id;
+		if (lazy) {
+			KCBSNode *&parent = parents[idx];
+			if (!parent) {
+				parent = node_arena_.create();
+				parent->setPlan(plan_trajs, plan_discrete);
+			}
+			n->updateParent(parent);
+			n->addConstraint(constraints.front(), constraintHash_(constraints.front()));
+			for (std::size_t c = 1; c < constraints.size(); c++)
+				n->seedConstraint(constraints[c], constraintHash_(constraints[c]));
+			n->adoptPlan(parent);
+			n->markLazy();
+		}
+		else {
+			for (const ConstraintPtr &c: constraints)
+				n->seedConstraint(c, constraintHash_(c));
+			n->setPlan(plan_trajs, plan_discrete);
+		}
+		n->setMetaAgents(meta);
+		nodes.push_back(n);
+	}
+
+	count = node_count;
+	seed_ = seed;
+	low_level_calls_ = calls;
+	num_expansions_ = expansions;
+	conf_counter_ = conf_counter;
+	max_conflicts_ = max_conflicts;
+	closed_ = std::move(closed);
+	return true;
+}
+
+ompl::base::PlannerStatus ompl::control::KCBS::resumeCheckpoint(const std::string &filename, 
+	const base::PlannerTerminationCondition &ptc)
+{
+	if (!readFile(filename, resume_data_)) {
+		OMPL_INFORM("%s: No checkpoint ``%s``, solving from the start.", getName().c_str(), filename.c_str());
+		resume_data_.clear();
+		return solve(ptc);
+	}
+	const base::PlannerStatus status = solve(ptc);
+	resume_data_.clear();
+	return status;
+}
+
+ompl::control::KCBS::PendingReplanScheduler::PendingReplanScheduler(KCBS *kcbs, const base::PlannerTerminationCondition &ptc, const bool background):
+	kcbs_(kcbs), ptc_(ptc), background_(background)
+{
+	if (background_)
+		worker_ = std::thread(&PendingReplanScheduler::work_, this);
+}
+
+ompl::control::KCBS::PendingReplanScheduler::~PendingReplanScheduler()
+{
+	stop();
+}
+
+void ompl::control::KCBS::PendingReplanScheduler::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	cv_.notify_all();
+	if (worker_.joinable())
+		worker_.join();
+}
+
+void ompl::control::KCBS::PendingReplanScheduler::add(KCBSNode *n)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		pending_.push_back(n);
+	}
+	cv_.notify_all();
+}
+
+std::shared_ptr<ompl::control::PathControl> ompl::control::KCBS::PendingReplanScheduler::attempt_(KCBSNode *n)
+{
+	/* the time slice doubles with every failed attempt, but never exceeds the low-level planning time. An adaptive budget
+	   continues from the budget of the replan that failed (the first failure) */
+	const int agent = n->getConstraint()->getConstrainedAgent();
+	const double slice = kcbs_->adaptive_budget_ ? 
+		kcbs_->lowLevelBudget_(agent, n->getAgentConstraints(agent).size(), n->getReplanAttempts() + 1) : 
+		std::min(kcbs_->pending_slice_ * std::pow(2.0, n->getReplanAttempts()), kcbs_->mp_comp_time_);
+	base::PlannerTerminationCondition slice_ptc = base::plannerOrTerminationCondition(ptc_, 
+		base::plannerOrTerminationCondition(base::timedPlannerTerminationCondition(slice), 
+			base::PlannerTerminationCondition([this] { return stop_; })));
+	/* continue growing the saved tree of the planner */
+	kcbs_->seedLowLevel_(n->getPlanner(), "pending", n->id, agent);
+	oc::PathControl *path = kcbs_->calcNewPath_(n->getPlanner(), {}, false, slice_ptc);
+	if (path)
+		return std::make_shared<PathControl>(*path);
+	n->countReplanAttempt();
+	return nullptr;
+}
+
+void ompl::control::KCBS::PendingReplanScheduler::step()
+{
+	KCBSNode *n = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (pending_.empty())
+			return;
+		n = pending_.front();
+		pending_.pop_front();
+	}
+	std::shared_ptr<PathControl> path = attempt_(n);
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (path)
+		ready_.emplace_back(n, path);
+	else
+		pending_.push_back(n);  // round-robin
+}
+
+void ompl::control::KCBS::PendingReplanScheduler::work_()
+{
+	while (true) {
+		KCBSNode *n = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+			if (stop_)
+				return;
+			n = pending_.front();
+			pending_.pop_front();
+			in_progress_++;
+		}
+		std::shared_ptr<PathControl> path = attempt_(n);
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			in_progress_--;
+			if (path)
+				ready_.emplace_back(n, path);
+			else
+				pending_.push_back(n);  // round-robin
+		}
+		cv_.notify_all();
+	}
+}
+
+std::vector<ompl::control::KCBS::PendingReplanScheduler::Result> ompl::control::KCBS::PendingReplanScheduler::collect(const bool wait)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	if (wait && background_ && ready_.empty())
+		cv_.wait_for(lock, std::chrono::milliseconds(10), [this] { return stop_ || !ready_.empty(); });
+	std::vector<Result> results;
+	results.swap(ready_);
+	return results;
+}
+
+bool ompl::control::KCBS::PendingReplanScheduler::empty()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return pending_.empty() && ready_.empty() && in_progress_ == 0;
+}
+
+std::size_t ompl::control::KCBS::PendingReplanScheduler::size()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return pending_.size() + ready_.size() + in_progress_;
+}
+
+ompl::control::KCBS::ReplanPipeline::ReplanPipeline(KCBS *kcbs, const base::PlannerTerminationCondition &ptc, const unsigned int threads, 
+	const std::size_t depth, const bool ordered):
+	kcbs_(kcbs), ptc_(ptc), depth_(std::max<std::size_t>(depth, 1)), ordered_(ordered)
+{
+	for (unsigned int t = 0; t < std::max(threads, 1u); t++)
+		workers_.emplace_back(&ReplanPipeline::work_, this);
+}
+
+ompl::control::KCBS::ReplanPipeline::~ReplanPipeline()
+{
+	stop();
+}
+
+void ompl::control::KCBS::ReplanPipeline::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	cv_.notify_all();
+	for (std::thread &w: workers_)
+		w.join();
+	workers_.clear();
+}
+
+void ompl::control::KCBS::ReplanPipeline::submit(KCBSNode *n, PlannerPtr planner, KCBSNode::ConstraintRange constraints)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		jobs_.push_back(Job{next_ticket_++, n, std::move(planner), std::move(constraints)});
+		outstanding_++;
+	}
+	cv_.notify_all();
+}
+
+void ompl::control::KCBS::ReplanPipeline::work_()
+{
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+			if (stop_)
+				return;
+			job = std::move(jobs_.front());
+			jobs_.pop_front();
+		}
+		const base::PlannerTerminationCondition job_ptc = base::plannerOrTerminationCondition(ptc_, 
+			base::PlannerTerminationCondition([this] { return stop_; }));
+		oc::PathControl *path = kcbs_->calcNewPath_(job.planner_, job.constraints_, job_ptc);
+		/* the path belongs to the clone, so it is copied before the clone can be dropped */
+		std::shared_ptr<PathControl> copy = path ? std::make_shared<PathControl>(*path) : nullptr;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			done_.emplace(job.ticket_, Result(job.node_, job.planner_, copy));
+		}
+		cv_.notify_all();
+	}
+}
+
+std::vector<ompl::control::KCBS::ReplanPipeline::Result> ompl::control::KCBS::ReplanPipeline::collect(const bool wait)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	/* in order, only the replans up to the first one still running can be collected */
+	auto ready = [this] { return !done_.empty() && (!ordered_ || done_.begin()->first == next_collect_); };
+	if (wait && !ready())
+		cv_.wait_for(lock, std::chrono::milliseconds(10), [this, &ready] { return stop_ || ready(); });
+	std::vector<Result> results;
+	while (ready()) {
+		results.push_back(std::move(done_.begin()->second));
+		done_.erase(done_.begin());
+		next_collect_++;
+		outstanding_--;
+	}
+	return results;
+}
+
+bool ompl::control::KCBS::ReplanPipeline::full()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return outstanding_ >= depth_;
+}
+
+bool ompl::control::KCBS::ReplanPipeline::empty()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return outstanding_ == 0;
+}
+
+std::size_t ompl::control::KCBS::pairIndex_(const int agent1, const int agent2) const
+{
+	/* index of (i, j), i < j, in the row-major upper triangle of an N x N matrix */
+	const std::size_t i = std::min(agent1, agent2);
+	const std::size_t j = std::max(agent1, agent2);
+	return i * (2 * num_agents_ - i - 1) / 2 + (j - i - 1);
+}
+
+bool ompl::control::KCBS::shouldMerge_(const int agent1, const int agent2)
+{
+	/* Update the global conflict counter and check if the merge bound was triggered */
+	int &count = conf_counter_[pairIndex_(agent1, agent2)];
+	count++;
+	if (count > max_conflicts_)
+		max_conflicts_ = count;
+   	return (max_conflicts_ >= B_);
+}
+
+void ompl::control::KCBS::resetConflictCount_(const int agent1, const int agent2)
+{
+	conf_counter_[pairIndex_(agent1, agent2)] = 0;
+	max_conflicts_ = 0;
+	for (const int c: conf_counter_)
+		max_conflicts_ = std::max(max_conflicts_, c);
+}
+
+ompl::control::KCBS::KCBSNode* ompl::control::KCBS::mergeAgents_(const KCBSNode *n, const int agent1, const int agent2, 
+	const base::PlannerTerminationCondition &ptc)
+{
+	const PhaseStart t0;
+	KCBSNode *merged = composeAgents_(n, agent1, agent2, ptc);
+	recordTime_(stats_.merge_, t0);
+	return merged;
+}
+
+ompl::control::KCBS::KCBSNode* ompl::control::KCBS::composeAgents_(const KCBSNode *n, const int agent1, const int agent2, 
+	const base::PlannerTerminationCondition &ptc)
+{
+	const MergerPtr merger = mrmp_pdef_->getMerger();
+	if (!merger) {
+		OMPL_ERROR("%s: No Merger was provided.", getName().c_str());
+		return nullptr;
+	}
+	/* agents already merged on the branch of n bring their meta-agent along */
+	std::vector<int> agents = n->getMetaAgent(agent1);
+	const std::vector<int> others = n->getMetaAgent(agent2);
+	agents.insert(agents.end(), others.begin(), others.end());
+	std::sort(agents.begin(), agents.end());
+	std::string names;
+	for (const int a: agents)
+		names += (names.empty() ? "" : ", ") + std::to_string(a);
+
+	std::unique_lock<std::mutex> lock = lockShared_();
+	MotionPlanningProblemPtr composed = merger->mergeRobots(agents);
+	lock = std::unique_lock<std::mutex>();
+	if (!composed)
+		return nullptr;
+
+	/* the meta-agent is planned jointly (and without constraints), within the low-level planning time */
+	seedLowLevel_(composed->getPlanner(), "merge", n->id, agents.front());
+	base::PlannerStatus solved = composed->getPlanner()->solve(
+		base::plannerOrTerminationCondition(ptc, base::timedPlannerTerminationCondition(mp_comp_time_)));
+	if (solved != base::PlannerStatus::EXACT_SOLUTION) {
+		OMPL_INFORM("%s: Unable to find a joint plan for agents %s.", getName().c_str(), names.c_str());
+		return nullptr;
+	}
+	const PathControl *joint = composed->getProblemDefinition()->getSolutionPath()->as<PathControl>();
+	lock = lockShared_();
+	const std::vector<PathControl> paths = merger->splitPath(*joint, agents);
+	lock = std::unique_lock<std::mutex>();
+	if (paths.size() != agents.size())
+		return nullptr;
+
+	/* the merged node replaces n, without the constraints on the meta-agent, which its branch keeps */
+	KCBSNode *merged = node_arena_.create();
+	merged->id = n->id;
+	merged->inheritConstraints(n, agents);
+	merged->updatePlanAndCost(n, agents, paths);
+	merged->mergeMetaAgents(n, agents, num_agents_);
+	merger_count_.push_back(agents);
+	return merged;
+}
+
+int ompl::control::KCBS::getConflictCount(const int agent1, const int agent2) const
+{
+	if (agent1 == agent2)
+		return 0;
+	return conf_counter_[pairIndex_(agent1, agent2)];
+}
+
+std::vector<std::vector<int>> ompl::control::KCBS::getConflictCounter() const
+{
+	std::vector<std::vector<int>> counter(num_agents_, std::vector<int>(num_agents_, 0));
+	for (std::size_t i = 0; i < num_agents_; i++) {
+		for (std::size_t j = i + 1; j < num_agents_; j++) {
+			counter[i][j] = conf_counter_[pairIndex_(i, j)];
+			counter[j][i] = counter[i][j];
+		}
+	}
+	return counter;
 }
 
 // Instance* ompl::control::KCBS::composeSystem(const int agentIdx1, const int agentIdx2)
@@ -188,172 +1188,877 @@ bool ompl::control::KCBS::shouldMerge_(std::vector< std::pair< std::pair<int, in
 //    return new_instance;
 // }
 
+void ompl::control::KCBS::saveOnlineState_(const Plan &plan, const KCBSNode *n)
+{
+	online_plan_ = plan;
+	online_constraints_.assign(num_agents_, {});
+	for (std::size_t a = 0; n && a < num_agents_; a++)
+		online_constraints_[a] = n->getAgentConstraints(a);
+	online_changed_.clear();
+}
+
+bool ompl::control::KCBS::updateStart(const int agent, const base::State *start)
+{
+	if (agent < 0 || static_cast<std::size_t>(agent) >= num_agents_ || !start) {
+		OMPL_ERROR("%s: Invalid start for agent %d of %zu.", getName().c_str(), agent, num_agents_);
+		return false;
+	}
+	const base::ProblemDefinitionPtr pdef = mrmp_pdef_->getRobotProblemDefinitionPtr(agent);
+	pdef->clearStartStates();
+	pdef->addStartState(start);
+	/* the tree of the agent is rooted at its old start */
+	mrmp_pdef_->getRobotMotionPlanningProblemPtr(agent)->getPlanner()->clear();
+	if (std::find(online_changed_.begin(), online_changed_.end(), agent) == online_changed_.end())
+		online_changed_.push_back(agent);
+	return true;
+}
+
+ompl::base::PlannerStatus ompl::control::KCBS::resolve(const base::PlannerTerminationCondition &ptc)
+{
+	if (!ready_ || online_plan_.size() != num_agents_) {
+		OMPL_WARN("%s: No previous solution to re-plan from. Solving from scratch.", getName().c_str());
+		return solve(ptc);
+	}
+	const PhaseStart t0;
+	auto changed = [this](const int agent) {
+		return std::find(online_changed_.begin(), online_changed_.end(), agent) != online_changed_.end();
+	};
+
+	/* a constraint avoids the (old) trajectory of its constraining agent, so it stays valid unless that agent changed */
+	std::vector<std::vector<ConstraintPtr>> kept(num_agents_);
+	KCBSNode kept_lists;
+	for (std::size_t a = 0; a < num_agents_ && a < online_constraints_.size(); a++) {
+		for (const ConstraintPtr &c: online_constraints_[a]) {
+			if (!changed(c->getConstrainingAgent()))
+				kept[a].push_back(c);
+		}
+		for (auto itr = kept[a].rbegin(); itr != kept[a].rend(); itr++)
+			kept_lists.seedConstraint(*itr);
+	}
+
+	/* only the agents that changed are planned again for the root, under the constraints they keep */
+	Plan root_plan = online_plan_;
+	replay_.clear();
+	low_level_calls_ = 0;
+	for (const int a: online_changed_) {
+		PlannerPtr planner = mrmp_pdef_->getRobotMotionPlanningProblemPtr(a)->getPlanner();
+		seedLowLevel_(planner, "root", -1, a);
+		oc::PathControl *path = nullptr;
+		for (bool restart = true; !path && ptc == false; restart = false)
+			path = calcNewPath_(planner, kept_lists.getAgentConstraints(a), restart, base::plannerOrTerminationCondition(ptc, 
+				base::timedPlannerTerminationCondition(lowLevelBudget_(a, kept[a].size()))));
+		if (!path) {
+			OMPL_INFORM("%s: Unable to re-plan agent %d from its new start.", getName().c_str(), a);
+			return {false, false};
+		}
+		root_plan[a] = *path;
+	}
+	OMPL_INFORM("%s: Re-planned %zu of %zu agents in %0.3f seconds.", getName().c_str(), online_changed_.size(), 
+		num_agents_, elapsed_(t0.time_));
+
+	root_plan_ = root_plan;
+	root_constraints_ = kept;
+	base::PlannerStatus solved = solve(ptc);
+	root_plan_.clear();
+	root_constraints_.clear();
+	return solved;
+}
+
+void ompl::control::KCBS::publishSolution_(const KCBSNode *n)
+{
+	const Plan sol_plan = n->getPlan();
+	soc_ = 0;
+	for (int i = 0; i < sol_plan.size(); i++)
+	{
+		/* agents outside of the group keep the (fixed) trajectories they were given */
+		if (!inGroup_(i))
+			continue;
+		auto path(std::make_shared<PathControl>(sol_plan[i]));
+		mrmp_pdef_->getRobotProblemDefinitionPtr(i)->clearSolutionPaths();
+		mrmp_pdef_->getRobotProblemDefinitionPtr(i)->addSolutionPath(path, false, -1.0, getName().c_str());
+		soc_ += path->length();
+	}
+}
+
+bool ompl::control::KCBS::inGroup_(const int agent) const
+{
+	return group_.empty() || std::find(group_.begin(), group_.end(), agent) != group_.end();
+}
+
+void ompl::control::KCBS::pruneDuplicates_(const KCBSNode *n, std::vector<ConstraintPtr> &constraints, 
+	std::vector<ConstraintPtr> &companions)
+{
+	std::vector<ConstraintPtr> unique_constraints, unique_companions;
+	for (std::size_t a = 0; a < constraints.size(); a++) {
+		/* the key is the constraint set of the child: the constraint on its agent, and the companion on its own agent */
+		std::vector<std::pair<int, std::size_t>> added{{constraints[a]->getConstrainedAgent(), constraintHash_(constraints[a])}};
+		if (companions[a])
+			added.push_back({companions[a]->getConstrainedAgent(), constraintHash_(companions[a])});
+		if (closed_.insert(n->getConstraintSetHash(added)).second) {
+			unique_constraints.push_back(constraints[a]);
+			unique_companions.push_back(companions[a]);
+		}
+		else
+			stats_.duplicates_pruned_++;
+	}
+	constraints.swap(unique_constraints);
+	companions.swap(unique_companions);
+}
+
+void ompl::control::KCBS::constrainChild_(KCBSNode *child, const ConstraintPtr &constraint, const ConstraintPtr &companion) const
+{
+	child->addConstraint(constraint, constraintHash_(constraint));
+	if (companion)
+		child->seedConstraint(companion, constraintHash_(companion));
+}
+
+std::unique_lock<std::mutex> ompl::control::KCBS::lockShared_() const
+{
+	return shared_mutex_ ? std::unique_lock<std::mutex>(*shared_mutex_) : std::unique_lock<std::mutex>();
+}
+
+ompl::base::PlannerStatus ompl::control::KCBS::solveIndependent_(const base::PlannerTerminationCondition &ptc)
+{
+    for (int i = 0; i < mrmp_pdef_->getAllProblemInformation().size(); i++) {
+        mrmp_pdef_->getRobotProblemDefinitionPtr(i)->clearSolutionPaths();
+    }
+    num_expansions_ = 0;
+    num_bypasses_ = 0;
+    num_bypassed_nodes_ = 0;
+    merger_count_.clear();
+
+   	OMPL_INFORM("%s: Starting planning with independence detection. ", getName().c_str());
+   	auto start = std::chrono::high_resolution_clock::now();
+
+   	Plan plan;
+   	const PhaseStart t0;
+   	const base::PlannerStatus root_status = planRoot_(ptc, plan);
+   	recordTime_(stats_.root_, t0);
+   	if (root_status != base::PlannerStatus::EXACT_SOLUTION)
+   		return (root_status == base::PlannerStatus::INVALID_START) ? root_status : base::PlannerStatus(false, false);
+
+   	/* every agent starts in its own group */
+   	std::vector<int> group_of(num_agents_);
+   	std::iota(group_of.begin(), group_of.end(), 0);
+   	bool solved = false;
+   	bool failed = false;
+   	while (ptc == false && !failed) {
+   		/* find the conflicting pairs of the combined plan, and merge their groups */
+   		PlanValidityChecker::ValidationCache cache;
+   		mrmp_pdef_->getPlanValidator()->validatePlanIncremental(DiscretePlan(plan), -1, cache);
+   		std::vector<std::pair<int, int>> conflicting;
+   		for (auto itr = cache.pairs_.begin(); itr != cache.pairs_.end(); itr++) {
+   			if (itr->second.empty())
+   				continue;
+   			conflicting.push_back(itr->first);
+   			const int g1 = group_of[itr->first.first];
+   			const int g2 = group_of[itr->first.second];
+   			if (g1 != g2) {
+   				for (int &g: group_of) {
+   					if (g == std::max(g1, g2))
+   						g = std::min(g1, g2);
+   				}
+   			}
+   		}
+   		if (conflicting.empty()) {
+   			solved = true;
+   			break;
+   		}
+
+   		/* only the groups that contain a conflict must be (re-)solved */
+   		std::vector<bool> dependent(num_agents_, false);
+   		for (auto &c: conflicting)
+   			dependent[group_of[c.first]] = true;
+   		std::map<int, std::vector<int>> groups;
+   		for (std::size_t a = 0; a < num_agents_; a++) {
+   			if (dependent[group_of[a]])
+   				groups[group_of[a]].push_back(a);
+   		}
+   		OMPL_INFORM("%s: Solving %zu dependent group(s) of agents.", getName().c_str(), groups.size());
+
+   		/* every group gets its own K-CBS, which keeps the plans of all other agents fixed. The groups solved at the same
+   		   time share the threads, and take turns on the validator and the merger. A group is not solved anytime, as
+   		   the next round needs its solution */
+   		const std::size_t n_group_threads = std::min<std::size_t>(num_threads_, groups.size());
+   		const std::shared_ptr<std::mutex> shared_mutex = (n_group_threads > 1) ? std::make_shared<std::mutex>() : nullptr;
+   		std::vector<std::shared_ptr<KCBS>> subs;
+   		for (auto itr = groups.begin(); itr != groups.end(); itr++) {
+   			auto sub = std::make_shared<KCBS>(mrmp_pdef_);
+   			sub->setNumThreads(num_threads_ / n_group_threads);
+   			sub->setMergeBound(B_);
+   			sub->setLowLevelPlanningTime(mp_comp_time_);
+   			sub->setSuboptimalityFactor(focal_w_);
+   			sub->setPendingReplanSlice(pending_slice_);
+   			sub->setAdaptiveLowLevelTime(getAdaptiveLowLevelTime());
+   			sub->setBackgroundPendingReplans(background_pending_);
+   			sub->setBypassing(bypass_);
+   			sub->setLazyExpansion(lazy_);
+   			sub->setConflictWindow(conflict_window_);
+   			sub->setDuplicateDetection(duplicate_detection_);
+   			sub->setDuplicateResolution(duplicate_resolution_);
+   			sub->setDisjointSplitting(disjoint_splitting_);
+   			sub->setAllConflicts(all_conflicts_);
+   			sub->setConflictClassification(conflict_classification_);
+   			sub->setClassificationLimit(classification_limit_);
+   			sub->setPortfolio(portfolio_);
+   			sub->setPortfolioWidth(portfolio_width_);
+   			sub->setMemoryBudget(memory_budget_);
+   			sub->setPipelineDepth(pipeline_depth_);
+   			sub->setPipelineOrdered(pipeline_ordered_);
+   			if (seed_ != 0)
+   				sub->setSeed(seeding::derive(seed_, num_agents_ + low_level_calls_++));
+   			sub->group_ = itr->second;
+   			sub->root_plan_ = plan;
+   			sub->shared_mutex_ = shared_mutex;
+   			subs.push_back(sub);
+   		}
+   		std::vector<char> sub_solved(subs.size(), false);
+   		std::atomic<std::size_t> next_group{0};
+   		auto group_worker = [&subs, &sub_solved, &next_group, &ptc]() {
+   			for (std::size_t g = next_group++; g < subs.size(); g = next_group++)
+   				sub_solved[g] = bool(subs[g]->solve(ptc));
+   		};
+   		if (n_group_threads > 1) {
+   			TaskGroup workers(&ptc);
+   			workers.runAndWait(n_group_threads, [&group_worker](const std::size_t) {group_worker();});
+   		}
+   		else
+   			group_worker();
+
+   		/* collect the new trajectories of every group */
+   		for (std::size_t g = 0; g < subs.size(); g++) {
+   			num_expansions_ += subs[g]->getNumExpansions();
+   			num_bypasses_ += subs[g]->getNumBypasses();
+   			num_bypassed_nodes_ += subs[g]->getNumBypassedNodes();
+   			stats_.add(subs[g]->getStatistics());
+   			replay_.insert(replay_.end(), subs[g]->getReplayLog().begin(), subs[g]->getReplayLog().end());
+   			for (auto &m: subs[g]->getMergers())
+   				merger_count_.push_back(m);
+   			if (!sub_solved[g]) {
+   				failed = true;
+   				continue;
+   			}
+   			for (const int a: subs[g]->group_)
+   				plan[a] = *mrmp_pdef_->getRobotProblemDefinitionPtr(a)->getSolutionPath()->as<PathControl>();
+   		}
+   	}
+
+   	auto stop = std::chrono::high_resolution_clock::now();
+   	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+   	computation_time_ = (duration.count() / 1000000.0);
+   	OMPL_INFORM("%s: Expanded %u nodes in %0.3f seconds.", getName().c_str(), num_expansions_, computation_time_);
+   	if (!solved) {
+   	 	if (ptc == true)
+   	 	   OMPL_INFORM("%s: No solution found due to time.", getName().c_str());
+   	 	return {false, false};
+   	}
+   	OMPL_INFORM("%s: Found Solution in %0.3f seconds!", getName().c_str(), computation_time_);
+   	saveOnlineState_(plan, nullptr);
+   	for (std::size_t a = 0; a < plan.size(); a++) {
+   		auto path(std::make_shared<PathControl>(plan[a]));
+   		mrmp_pdef_->getRobotProblemDefinitionPtr(a)->clearSolutionPaths();
+   		mrmp_pdef_->getRobotProblemDefinitionPtr(a)->addSolutionPath(path, false, -1.0, getName().c_str());
+   		soc_ += path->length();
+   	}
+   	OMPL_INFORM("%s: Planning Complete.", getName().c_str());
+   	return {true, false};
+}
+
+ompl::base::PlannerStatus ompl::control::KCBS::planRoot_(const base::PlannerTerminationCondition &ptc, Plan &root_plan)
+{
+   	/* Every agent is independent at the root, so plan them concurrently */
+    for (std::size_t a = 0; a < low_level_planners_.size(); a++)
+        seedLowLevel_(low_level_planners_[a], "root", -1, a);
+    std::vector<oc::PathControl*> root_paths(low_level_planners_.size(), nullptr);
+    std::atomic<bool> invalid_start{false};
+    std::atomic<std::size_t> next_agent{0};
+    auto root_worker = [this, &ptc, &root_paths, &invalid_start, &next_agent]() {
+        for (std::size_t a = next_agent++; a < low_level_planners_.size() && !invalid_start; a = next_agent++) {
+            PlannerPtr planner = low_level_planners_[a];
+            ob::PlannerStatus solved = planner->as<ConstraintRespectingPlanner>()->solve(mp_comp_time_);
+            while (solved!=ob::PlannerStatus::EXACT_SOLUTION && !ptc && !invalid_start){
+                solved = planner->as<ConstraintRespectingPlanner>()->solve(mp_comp_time_);
+                if (solved == base::PlannerStatus::INVALID_START) {
+                    invalid_start = true;
+                }
+            }
+            /* store initial trajectory */
+            if (solved)
+                root_paths[a] = planner->getProblemDefinition()->getSolutionPath()->as<oc::PathControl>();
+        }
+    };
+    const std::size_t n_root_threads = std::min<std::size_t>(num_threads_, low_level_planners_.size());
+    if (n_root_threads > 1) {
+        TaskGroup workers(&ptc);
+        workers.runAndWait(n_root_threads, [&root_worker](const std::size_t) {root_worker();});
+    }
+    else
+        root_worker();
+    if (invalid_start)
+        return base::PlannerStatus::INVALID_START;
+    root_plan.clear();
+    for (std::size_t a = 0; a < low_level_planners_.size(); a++) {
+        if (root_paths[a])
+            root_plan.push_back(*root_paths[a]);
+        /* a warm-started planner keeps its root tree for the first replan */
+        if (!low_level_planners_[a]->as<ConstraintRespectingPlanner>()->getWarmStart())
+            low_level_planners_[a]->clear();
+    }
+    if (root_plan.size() != low_level_planners_.size())
+        return base::PlannerStatus::TIMEOUT;
+    return base::PlannerStatus::EXACT_SOLUTION;
+}
+
 // the main algorithm
 ob::PlannerStatus ompl::control::KCBS::solve(const base::PlannerTerminationCondition &ptc)
+{
+	progress_dropped_ = 0;
+	{
+		std::lock_guard<std::mutex> lock(tree_mutex_);
+		tree_.clear();
+	}
+	/* the allocations of the subsystems during the search (the peaks since the outermost solve, for meta-agents) */
+	const alloc::Window memory_window;
+	std::array<alloc::Usage, alloc::NUM_SUBSYSTEMS> memory_start;
+	for (int m = 0; m < alloc::NUM_SUBSYSTEMS; m++)
+		memory_start[m] = alloc::usage(alloc::Subsystem(m));
+	const auto memory_t0 = std::chrono::steady_clock::now();
+	auto recordMemory = [this, &memory_start, &memory_t0]() {
+		if (!alloc::isEnabled())
+			return;
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - memory_t0).count();
+		for (int m = 0; m < alloc::NUM_SUBSYSTEMS; m++) {
+			const alloc::Usage u = alloc::usage(alloc::Subsystem(m));
+			MemoryUsage &r = stats_.memory_[m];
+			r.live_bytes_ = u.live_bytes_;
+			r.peak_bytes_ = u.peak_bytes_;
+			r.allocations_ = u.allocations_ - memory_start[m].allocations_;
+			r.allocation_rate_ = (seconds > 0) ? r.allocations_ / seconds : 0.0;
+			OMPL_INFORM("%s: %s peaked at %zu bytes, %zu live, %llu allocations (%0.1f per second).", getName().c_str(),
+				alloc::name(alloc::Subsystem(m)), r.peak_bytes_, r.live_bytes_, (unsigned long long) r.allocations_,
+				r.allocation_rate_);
+		}
+	};
+	if (!progress_callback_) {
+		const base::PlannerStatus status = search_(ptc);
+		recordMemory();
+		/* the buffered messages of the search go before those of the caller */
+		KCBS_LOG_FLUSH();
+		return status;
+	}
+
+	/* the events go from the threads of the search to the callback through the queue, which one thread drains */
+	progress_ = std::make_unique<EventQueue<ProgressEvent>>(progress_capacity_);
+	progress_stop_ = false;
+	progress_start_ = std::chrono::steady_clock::now();
+	std::atomic<bool> searching{true};
+	std::thread dispatcher([this, &searching]() {
+		ProgressEvent e;
+		while (true) {
+			/* read before the queue is drained, so the events of the whole search are delivered */
+			const bool last = !searching;
+			while (progress_->pop(e)) {
+				if (!progress_callback_(e))
+					progress_stop_ = true;
+			}
+			if (last)
+				return;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+	const base::PlannerStatus status = search_(base::plannerOrTerminationCondition(ptc, 
+		base::PlannerTerminationCondition([this]() {return progress_stop_.load();})));
+	searching = false;
+	dispatcher.join();
+	progress_.reset();
+	recordMemory();
+	KCBS_LOG_FLUSH();
+	if (progress_dropped_ > 0)
+		OMPL_WARN("%s: %zu progress events were dropped by a full queue.", getName().c_str(), progress_dropped_.load());
+	return status;
+}
+
+ob::PlannerStatus ompl::control::KCBS::search_(const base::PlannerTerminationCondition &ptc)
 { 
 	/* Be sure that K-CBS was set-up */
    	if (!ready_) {
    	   	OMPL_ERROR("%s: Invalid Set-up. Unable to plan.", getName().c_str());
    	   	return base::PlannerStatus::INVALID_START;
    	}
+   	stats_ = Statistics();
+   	stats_.constraints_per_agent_.assign(num_agents_, 0);
+   	stats_.portfolio_wins_.assign(portfolio_.empty() ? 0 : portfolio_.size() + 1, 0);
+   	{
+   		const std::unique_lock<std::mutex> lock = lockShared_();
+   		mrmp_pdef_->getPlanValidator()->setConflictWindow(conflict_window_);
+   	}
+   	/* resolve() logs its root plans before solving */
+   	if (root_plan_.empty()) {
+   		replay_.clear();
+   		low_level_calls_ = 0;
+   	}
+
+   	/* the bounds hold from the starts of the problem, not from the states of an online replan */
+   	cost_lower_bound_ = 0;
+   	if (anytime_ && root_plan_.empty()) {
+   		for (int a = 0; a < num_agents_; a++)
+   			cost_lower_bound_ += mrmp_pdef_->getCostLowerBound(a);
+   		OMPL_INFORM("%s: The cost of a plan is at least %0.3f.", getName().c_str(), cost_lower_bound_);
+   	}
+
+   	/* resumed: the conflict tree of a checkpoint (see resumeCheckpoint) replaces the root */
+   	const bool resuming = !resume_data_.empty();
+   	/* distributed: every rank plans its own root, rank 0 searches from it and the others steal their first nodes */
+   	const bool distributed = cluster_ && cluster_->getSize() > 1 && group_.empty() && root_plan_.empty() && !resuming;
+   	if (distributed && independence_detection_)
+   		OMPL_WARN("%s: Independence detection is not used by a distributed search.", getName().c_str());
+
+   	/* split the team into independent groups, each solved by its own K-CBS */
+   	if (independence_detection_ && group_.empty() && root_plan_.empty() && !distributed && !resuming)
+   		return solveIndependent_(ptc);
 
     for (int i = 0; i < mrmp_pdef_->getAllProblemInformation().size(); i++) {
-        mrmp_pdef_->getRobotProblemDefinitionPtr(i)->clearSolutionPaths();
+        if (inGroup_(i))
+            mrmp_pdef_->getRobotProblemDefinitionPtr(i)->clearSolutionPaths();
     }
 
    	/* initialize priority queue and constants */ 
-   	std::priority_queue<KCBSNode, std::vector<KCBSNode>, Compare> pq;
+   	FocalOpenList<KCBSNode> pq(focal_w_);
+    /* the focal list orders nodes by their conflicts, so nodes must be validated before they are queued */
+    const bool eager_validation = (focal_w_ > 1.0);
+    /* the plans held by the queued nodes, and the bound beyond which the most expensive ones are compressed (raised 
+       while the nodes that cannot be compressed exceed the budget) */
+    std::size_t queue_bytes = 0;
+    std::size_t compress_bound = memory_budget_;
+    auto compressQueue = [this, &pq, &queue_bytes, &compress_bound]() {
+        /* down to three quarters of the budget, so the queue is not compressed on every push */
+        const std::size_t target = memory_budget_ - memory_budget_ / 4;
+        for (auto itr = pq.rbegin(); itr != pq.rend() && queue_bytes > target; itr++) {
+            KCBSNode *n = *itr;
+            /* a merged node has no parent, and the agent constrained below it is not part of its meta-agents */
+            if (!n->getParent() || !n->getConstraint() || n->isLazy() || n->isExpanded())
+                continue;
+            n->compress();
+            queue_bytes -= n->getQueuedBytes();
+            n->setQueuedBytes(0);
+            stats_.nodes_compressed_++;
+        }
+        if (queue_bytes > target) {
+            if (compress_bound == memory_budget_)
+                OMPL_WARN("%s: The queued nodes that cannot be compressed exceed the memory budget.", getName().c_str());
+            compress_bound = queue_bytes + queue_bytes / 10;
+        }
+        else
+            compress_bound = memory_budget_;
+    };
+    /* every open list operation is timed, and its peak size is recorded */
+    auto queuePush = [this, &pq, &queue_bytes, &compress_bound, &compressQueue](KCBSNode *n) {
+        const PhaseStart t0;
+        recordTreeNode_(n);
+        pq.push(n);
+        n->setQueuedBytes(planBytes_(n));
+        queue_bytes += n->getQueuedBytes();
+        if (memory_budget_ > 0 && queue_bytes > compress_bound)
+            compressQueue();
+        recordTime_(stats_.queue_, t0);
+        stats_.peak_queue_size_ = std::max(stats_.peak_queue_size_, pq.size());
+        stats_.peak_queue_bytes_ = std::max(stats_.peak_queue_bytes_, queue_bytes);
+    };
+    auto queuePop = [this, &pq, &queue_bytes]() {
+        const PhaseStart t0;
+        queue_bytes -= pq.top()->getQueuedBytes();
+        pq.top()->setQueuedBytes(0);
+        pq.pop();
+        recordTime_(stats_.queue_, t0);
+    };
+    num_expansions_ = 0;
+    num_bypasses_ = 0;
+    num_bypassed_nodes_ = 0;
+    merger_count_.clear();
+    closed_.clear();
+    /* the arena owns every node of the conflict tree; the queue only holds handles */
+    freeMemory_();
+    node_arena_.resetStatistics();
    	std::vector<MotionPlanningProblemPtr> all_mp_pdefs = mrmp_pdef_->getAllProblemInformation();
 
    	/* begin planning -- timing should start after this statement */
    	OMPL_INFORM("%s: Starting planning. ", getName().c_str());
    	auto start = std::chrono::high_resolution_clock::now();
 
-   	/* create initial solution */
-   	Plan root_plan;
-   	for (auto itr = low_level_planners_.begin(); itr != low_level_planners_.end(); itr++) {
-   	   	ob::PlannerStatus solved = (*itr)->as<ConstraintRespectingPlanner>()->solve(mp_comp_time_);
-   	   	while (solved!=ob::PlannerStatus::EXACT_SOLUTION && !ptc){
-   	   	   	solved = (*itr)->as<ConstraintRespectingPlanner>()->solve(mp_comp_time_);
-   	   	   	if (solved == base::PlannerStatus::INVALID_START) {
-   	   	   	   	return base::PlannerStatus::INVALID_START;
-   	   	   	}
-   	   	}
-   	   	/* store initial trajectory */
-   	   	if (solved) {
-            oc::PathControl* traj = (*itr)->getProblemDefinition()->getSolutionPath()->as<oc::PathControl>();
-            root_plan.push_back(*traj);  
-   	   	}
-   	   	(*itr)->clear();
+   	/* restore the conflict tree of the checkpoint, if resuming one */
+   	Plan root_plan = root_plan_;
+   	std::vector<KCBSNode*> resumed_nodes;
+   	KCBSNode *resumed_solution = nullptr;
+   	int resumed_count = 0;
+   	double resumed_time = 0;
+   	bool resumed = false;
+   	if (resuming) {
+   		resumed = readCheckpoint_(resume_data_, root_plan, resumed_nodes, resumed_solution, resumed_count, resumed_time);
+   		if (!resumed) {
+   			OMPL_WARN("%s: Invalid checkpoint, solving from the start.", getName().c_str());
+   			freeMemory_();
+   			root_plan = root_plan_;
+   			resumed_time = 0;
+   		}
+   		else
+   			OMPL_INFORM("%s: Resuming %zu nodes after %0.3f seconds.", getName().c_str(), resumed_nodes.size(), resumed_time);
+   	}
+
+   	/* create initial solution (unless this K-CBS was given the root plan of its group) */
+   	if (root_plan.empty() && !resumed) {
+   		const PhaseStart t0;
+   		const base::PlannerStatus root_status = planRoot_(ptc, root_plan);
+   		recordTime_(stats_.root_, t0);
+   		if (root_status == base::PlannerStatus::INVALID_START)
+   			return root_status;
    	}
 
    	/* create root node */
     int count = 0;
-   	KCBSNode rootNode;
-    rootNode.id = count;
-   	if (root_plan.size() == all_mp_pdefs.size()) {
-   	   	rootNode.updatePlanAndCost(root_plan);
-   	   	pq.emplace(rootNode);
+   	KCBSNode *rootNode = node_arena_.create();
+    rootNode->id = count;
+   	/* constraints kept from a previous search (oldest first, as they were added) */
+   	for (std::size_t a = 0; a < root_constraints_.size(); a++) {
+   		for (auto itr = root_constraints_[a].rbegin(); itr != root_constraints_[a].rend(); itr++)
+   			rootNode->seedConstraint(*itr, constraintHash_(*itr));
+   	}
+   	if (root_plan.size() == all_mp_pdefs.size() && (!distributed || cluster_->isHub()) && !resumed) {
+   	   	rootNode->updatePlanAndCost(root_plan);
+   	   	if (eager_validation)
+   	   		validateNode_(rootNode);
+   	   	queuePush(rootNode);
    	}
  
-   	/* initialize solution */
+   	/* initialize solution, and the cost of the best one known (of any rank) */
    	KCBSNode *solution = nullptr;
-   	while (ptc == false && !pq.empty()) {
+   	double incumbent = std::numeric_limits<double>::infinity();
+   	if (resumed) {
+   		count = resumed_count;
+   		for (KCBSNode *n: resumed_nodes) {
+   			if (eager_validation && !n->isLazy())
+   				validateNode_(n);
+   			queuePush(n);
+   		}
+   		/* the incumbent of an anytime search */
+   		if (resumed_solution) {
+   			solution = resumed_solution;
+   			incumbent = solution->getCost();
+   			publishSolution_(solution);
+   		}
+   	}
+   	/* nodes whose low-level planner failed are replanned by the scheduler, in time slices */
+   	PendingReplanScheduler pending(this, ptc, background_pending_);
+   	/* the replans of the children run in the pipeline (if enabled) while other nodes are expanded */
+   	std::unique_ptr<ReplanPipeline> pipeline;
+   	if (pipeline_depth_ > 0)
+   		pipeline = std::make_unique<ReplanPipeline>(this, ptc, num_threads_, pipeline_depth_, pipeline_ordered_);
+   	/* the nodes handed to the scheduler or the pipeline (which a checkpoint saves as lazy nodes) */
+   	std::unordered_set<const KCBSNode*> in_flight;
+   	/* queue a node whose constrained agent was replanned on planner, or hand it to the scheduler if the planner failed */
+   	auto replanned = [&](KCBSNode *n, const PlannerPtr &planner, const PathControl *path, const bool cloned) {
+   		in_flight.erase(n);
+   		const int agent = n->getConstraint()->getConstrainedAgent();
+   		if (path) {
+   			n->updatePlanAndCost(n->getParent(), agent, *path);
+   			if (eager_validation)
+   				validateNode_(n);
+   			queuePush(n);
+   		}
+   		else {
+   			n->savePlanner(planner);
+   			if (!cloned)
+   				mrmp_pdef_->replacePlanner(planner, agent);
+   			pending.add(n);
+   			in_flight.insert(n);
+   		}
+   	};
+   	/* distributed: the nodes given to a thief (every other node after the front, so both keep nodes of every cost) */
+   	auto giveNodes = [&](const int thief) {
+   		std::vector<KCBSNode*> candidates;
+   		std::size_t k = 0;
+   		/* a meta-agent only exists on the rank that merged it */
+   		for (auto itr = pq.begin(); itr != pq.end() && candidates.size() < steal_batch_ && 
+   			2 * candidates.size() + 2 <= pq.size(); itr++) {
+   			if (*itr != pq.top() && !(*itr)->hasMetaAgents() && k++ % 2 == 1)
+   				candidates.push_back(*itr);
+   		}
+   		ByteWriter nodes;
+   		std::uint32_t num_nodes = 0;
+   		for (KCBSNode *n: candidates) {
+   			if (!encodeNode_(n, nodes))
+   				continue;
+   			queue_bytes -= n->getQueuedBytes();
+   			n->setQueuedBytes(0);
+   			pq.erase(n);
+   			num_nodes++;
+   		}
+   		ByteWriter out;
+   		out.write(num_nodes);
+   		out.data().append(nodes.data());
+   		/* answered even without nodes, so the hub knows the steal is over */
+   		cluster_->send(SearchCluster::NODES, thief, out.data());
+   		stats_.nodes_sent_ += num_nodes;
+   	};
+   	/* rebuild the stolen nodes from the root plan of this rank */
+   	auto takeNodes = [&](const std::string &payload) {
+   		ByteReader in(payload);
+   		std::uint32_t num_nodes = 0;
+   		in.read(num_nodes);
+   		for (std::uint32_t i = 0; i < num_nodes && ptc == false; i++) {
+   			double cost;
+   			std::uint32_t num_constraints;
+   			if (!in.read(cost) || !in.read(num_constraints) || num_constraints > in.remaining()) {
+   				OMPL_WARN("%s: Received an invalid node.", getName().c_str());
+   				return;
+   			}
+   			std::vector<ConstraintPtr> constraints;
+   			for (std::uint32_t c = 0; c < num_constraints; c++) {
+   				ConstraintPtr constraint = decodeConstraint(in);
+   				if (!constraint || constraint->getConstrainedAgent() < 0 || constraint->getConstrainedAgent() >= num_agents_) {
+   					OMPL_WARN("%s: Received an invalid constraint.", getName().c_str());
+   					return;
+   				}
+   				constraints.push_back(constraint);
+   			}
+   			KCBSNode *n = rebuildNode_(constraints, root_plan, ++count, ptc);
+   			if (!n)
+   				continue;
+   			if (eager_validation)
+   				validateNode_(n);
+   			queuePush(n);
+   			stats_.nodes_received_++;
+   		}
+   	};
+   	/* the cost of a solution (and its plan, from the other ranks) for the hub */
+   	auto sendSolution = [&](const KCBSNode *n) {
+   		ByteWriter out;
+   		out.write(n->getCost());
+   		if (!cluster_->isHub()) {
+   			out.write(std::uint32_t(num_agents_));
+   			for (std::size_t a = 0; a < num_agents_; a++)
+   				encodeTrajectory(out, n->getTrajectory(a));
+   		}
+   		cluster_->send(SearchCluster::SOLUTION, 0, out.data());
+   	};
+   	/* the hub: a solution of another rank */
+   	auto takeSolution = [&](const std::string &payload) {
+   		ByteReader in(payload);
+   		double cost;
+   		std::uint32_t agents;
+   		if (!in.read(cost) || !in.read(agents) || agents != num_agents_ || (solution && cost >= solution->getCost()))
+   			return;
+   		Plan plan;
+   		for (std::size_t a = 0; a < num_agents_; a++) {
+   			oc::PathControl path(mrmp_pdef_->getRobotSpaceInformationPtr(a));
+   			if (!decodeTrajectory(in, mrmp_pdef_->getRobotSpaceInformationPtr(a), path)) {
+   				OMPL_WARN("%s: Received an invalid solution.", getName().c_str());
+   				return;
+   			}
+   			plan.push_back(path);
+   		}
+   		solution = node_arena_.create();
+   		solution->id = ++count;
+   		solution->updatePlanAndCost(plan);
+   		incumbent = std::min(incumbent, solution->getCost());
+   		stats_.solutions_ += anytime_ ? 1 : 0;
+   		if (anytime_)
+   			publishSolution_(solution);
+   		OMPL_INFORM("%s: Received a solution of cost %0.3f.", getName().c_str(), solution->getCost());
+   	};
+   	/* checkpoint: the queued nodes (with their meta-agents), the nodes in flight (by id, so a resumed search queues them
+   	   in the same order) and the incumbent of an anytime search */
+   	const bool checkpointing = !checkpoint_file_.empty() && checkpoint_interval_ > 0 && !distributed;
+   	const auto checkpoint_start = std::chrono::steady_clock::now();
+   	auto last_checkpoint = checkpoint_start;
+   	auto checkpoint = [&]() {
+   		last_checkpoint = std::chrono::steady_clock::now();
+   		std::vector<const KCBSNode*> queued(pq.begin(), pq.end());
+   		std::vector<const KCBSNode*> waiting(in_flight.begin(), in_flight.end());
+   		std::sort(waiting.begin(), waiting.end(), [](const KCBSNode *n1, const KCBSNode *n2) {return n1->id < n2->id;});
+   		writeCheckpoint_(root_plan, queued, waiting, anytime_ ? solution : nullptr, count, 
+   			resumed_time + elapsed_(checkpoint_start));
+   	};
+   	bool stealing = false;
+   	std::size_t reported_load = 0;
+   	while (ptc == false && (!pq.empty() || !pending.empty() || (pipeline && !pipeline->empty()) || 
+   		(distributed && !cluster_->done()))) {
+   		if (checkpointing && elapsed_(last_checkpoint) >= checkpoint_interval_)
+   			checkpoint();
+   		/* Distributed: answer the other ranks, and steal nodes once this rank has none left */
+   		if (distributed) {
+   			const bool idle = pq.empty() && pending.empty() && (!pipeline || pipeline->empty());
+   			for (const SearchCluster::Message &m: cluster_->poll(idle ? 10 : 0)) {
+   				if (m.type_ == SearchCluster::STEAL)
+   					giveNodes(m.from_);
+   				else if (m.type_ == SearchCluster::NODES) {
+   					stealing = false;
+   					takeNodes(m.payload_);
+   				}
+   				else if (m.type_ == SearchCluster::SOLUTION)
+   					takeSolution(m.payload_);
+   			}
+   			incumbent = std::min(incumbent, cluster_->getIncumbent());
+   			if (cluster_->done() || (!anytime_ && solution))
+   				break;
+   			if (pq.empty() && pending.empty() && (!pipeline || pipeline->empty())) {
+   				if (!stealing)
+   					stealing = cluster_->send(SearchCluster::STEAL, 0);
+   				continue;
+   			}
+   			/* the hub picks its victims by the loads they reported last */
+   			if (pq.size() > 2 * reported_load || 2 * pq.size() < reported_load) {
+   				reported_load = pq.size();
+   				ByteWriter load;
+   				load.write(std::uint64_t(reported_load));
+   				cluster_->send(SearchCluster::LOAD, 0, load.data());
+   			}
+   		}
+      	/* Anytime: no plan of the tree is cheaper than the lower bounds of the agents, so once the incumbent meets them the
+      	   search is over. The hub ends the search of every rank */
+      	if (cost_lower_bound_ >= incumbent && (!distributed || cluster_->isHub())) {
+      		OMPL_INFORM("%s: The solution of cost %0.3f meets the lower bound of every plan.", getName().c_str(), incumbent);
+      		stats_.nodes_pruned_ += pq.size() + in_flight.size();
+      		break;
+      	}
+      	/* Give the pending nodes their share of time, and queue the ones that now have a finite-length plan */
+      	if (!background_pending_)
+      		pending.step();
+      	for (auto &r: pending.collect(pq.empty())) {
+      		KCBSNode *n = r.first;
+      		in_flight.erase(n);
+      		n->updatePlanAndCost(n->getParent(), n->getConstraint()->getConstrainedAgent(), *r.second);
+      		if (eager_validation)
+      			validateNode_(n);
+      		queuePush(n);
+      		stats_.requeues_++;
+      	}
+      	if (pipeline) {
+      		for (auto &r: pipeline->collect(pq.empty() || pipeline->full()))
+      			replanned(std::get<0>(r), std::get<1>(r), std::get<2>(r).get(), true);
+      		/* the search runs ahead of the replans only up to the depth of the pipeline */
+      		if (pipeline->full())
+      			continue;
+      	}
+      	if (pq.empty())
+      		continue;
+
     	/* Get the lowest cost in priority queue */
-      	auto curr = new KCBSNode(pq.top());
-        // std::cout << curr->id << std::endl;
-        // if (curr->getParent())
-            // std::cout << curr->getParent()->id << std::endl;
-
-      	/* If the current K-CBS Node does not contain a finite-length solution, must replan with existing tree */
-      	if (curr->getCost() == std::numeric_limits<double>::infinity()) {
-      		pq.pop();
-         	// std::vector<ConstraintPtr> agent_constraints{curr->getConstraint()};
-        	// const KCBSNode *nCpy = curr->getParent();
-        	// while (nCpy->getParent() != nullptr) {
-           	// 	if (nCpy->getConstraint()->getConstrainedAgent() == curr->getConstraint()->getConstrainedAgent())
-            //   		agent_constraints.emplace_back(nCpy->getConstraint());
-           	// 	nCpy = nCpy->getParent();
-        	// }
-        	/* replan for conflicting agent w/ new constraint */
-        	PlannerPtr p = curr->getPlanner();
-        	oc::PathControl *new_path = calcNewPath_(p, {}, false);
-
-        	if (new_path) {
-        		/* Create new node and add it to the queue */
-        		// KCBSNode nxt;
-                // nxt.id = curr->id;
-            	// nxt.updateParent(curr);
-            	// nxt.addConstraint(curr->getConstraint());
-            	Plan new_plan = curr->getParent()->getPlan();
-            	new_plan[curr->getConstraint()->getConstrainedAgent()] = *new_path;
-            	curr->updatePlanAndCost(new_plan);
-            	pq.emplace(*curr);
-            }
-            else {
-            	/* Failed to find solution. Must copy data to new node and put at back of queue */
-                pq.emplace(*curr);
-            	// KCBSNode nxt;
-                // nxt.id = curr->id;
-            	// nxt.updateParent(curr->getParent());
-            	// nxt.addConstraint(curr->getConstraint());
-				// nxt.savePlanner(curr->getPlanner());
-            	// pq.emplace(nxt);
-            	// mrmp_pdef_->replacePlanner(p, curr->getConstraint()->getConstrainedAgent());
-            	// pq.emplace(nxt);
-            }
+      	KCBSNode *curr = pq.top();
+      	/* A lazy child only carries the plan of its parent. Replan its constrained agent now and queue it with its real cost */
+      	if (curr->isLazy()) {
+      		queuePop();
+      		const int agent = curr->getConstraint()->getConstrainedAgent();
+      		if (pipeline) {
+      			if (PlannerPtr clone = mrmp_pdef_->clonePlanner(agent)) {
+      				seedLowLevel_(clone, "replan", curr->id, agent);
+      				pipeline->submit(curr, clone, curr->getAgentConstraints(agent));
+      				in_flight.insert(curr);
+      				continue;
+      			}
+      		}
+      		PlannerPtr planner = nullptr;
+      		bool cloned = false;
+      		if (background_pending_) {
+      			planner = mrmp_pdef_->clonePlanner(agent);
+      			cloned = (planner != nullptr);
+      		}
+      		if (!planner)
+      			planner = mrmp_pdef_->getRobotMotionPlanningProblemPtr(agent)->getPlanner();
+      		seedLowLevel_(planner, "replan", curr->id, agent);
+      		oc::PathControl *path = calcNewPath_(planner, curr->getAgentConstraints(agent), ptc);
+      		if (path) {
+      			curr->updatePlanAndCost(curr->getParent(), agent, *path);
+      			if (eager_validation)
+      				validateNode_(curr);
+      			queuePush(curr);
+      		}
+      		else {
+      			curr->savePlanner(planner);
+      			if (!cloned)
+      				mrmp_pdef_->replacePlanner(planner, agent);
+      			pending.add(curr);
+      			in_flight.insert(curr);
+      		}
+      		continue;
       	}
-      	else {
+      	{
       		/* Current K-CBS Node has a finite-length plan */
       		/* Simulate the plan in search of conflicts. If no conflicts arrise, return correct solution */
-      		std::vector<ConflictPtr> confs = mrmp_pdef_->getPlanValidator()->validatePlan(curr->getPlan());
+      		if (!curr->isValidated())
+      			validateNode_(curr);
+      		const std::vector<ConflictPtr> confs = curr->getConflicts();
     		if (confs.empty()) {
-        	 	solution = curr;
-        	 	break;
+    			recordTreeNode_(curr, false, true);
+    			if (!anytime_) {
+        	 		solution = curr;
+        	 		reportProgress_(ProgressEvent::INCUMBENT_IMPROVED, curr->id, -1, -1, curr->getCost());
+        	 		if (distributed)
+        	 			sendSolution(curr);
+        	 		break;
+        	 	}
+        	 	/* Anytime: keep the cheapest conflict-free plan, publish it, and keep searching for a cheaper one */
+        	 	queuePop();
+        	 	if (curr->getCost() < incumbent) {
+        	 		solution = curr;
+        	 		incumbent = curr->getCost();
+        	 		if (distributed)
+        	 			sendSolution(curr);
+        	 		publishSolution_(solution);
+        	 		stats_.solutions_++;
+        	 		reportProgress_(ProgressEvent::INCUMBENT_IMPROVED, curr->id, -1, -1, curr->getCost());
+        	 		OMPL_INFORM("%s: Found a solution of cost %0.3f after %u expansions.", getName().c_str(), 
+        	 			solution->getCost(), num_expansions_);
+        	 	}
+        	 	continue;
+      		}
+      		const int agent1 = confs.front()->agent1Idx_;
+      		const int agent2 = confs.front()->agent2Idx_;
+      		/* the joint plan of a meta-agent is in conflict with itself, which no constraint or merge resolves */
+      		if (curr->isMerged(agent1) && curr->getMetaAgent(agent1) == curr->getMetaAgent(agent2)) {
+      			OMPL_INFORM("%s: Conflict within a meta-agent cannot be resolved. Discarding node.", getName().c_str());
+      			queuePop();
+      			continue;
       		}
-      		/* Plan contains conflicts that triggered the merge bound. K-CBS must merge the two conflicting robots */
-      		else if (shouldMerge_(conf_counter_, confs.front()->agent1Idx_, confs.front()->agent2Idx_)) {
-        	 	OMPL_INFORM("%s: Too many conflicts exist between a pair of agents.", getName().c_str());
-        	 	OMPL_INFORM("%s: Composing a %s with a %s.", getName().c_str(),
-        	    	mrmp_pdef_->getInstance()->getRobots()[confs.front()->agent1Idx_]->getDynamicsModel().c_str(), 
-        	    	mrmp_pdef_->getInstance()->getRobots()[confs.front()->agent2Idx_]->getDynamicsModel().c_str());
-        	 	OMPL_ERROR("%s: The Merge block of K-CBS has not been updated since refactor. Aborting with failure.", getName().c_str());
-        	 	return {false, false};
-         
-        		// Instance* new_instance = composeSystem(conf[0].agent1, conf[0].agent2);
-        		// if (new_instance == nullptr)
-        		//    return base::PlannerStatus::INVALID_START;
-         
-        		// const std::vector<mrmp_problem> new_mmpp = multiAgentSetUp(new_instance);
-        		// oc::K_CBS *p = new oc::K_CBS(new_mmpp); // K_CBS
-        		// // subPlanners_.push_back(p);
-        		// p->setInstance(new_instance);
-        		// ob::PlannerPtr planner(p);
-        		// OMPL_INFORM("Set-Up Complete");
-
-        		// bool solved = planner->solve(ptc);
-        		// auto stop = std::chrono::high_resolution_clock::now();
-        		// auto duration = duration_cast<std::chrono::microseconds>(stop - start);
-        		// solveTime_ = (duration.count() / 1000000.0);
-        		// if (!solved)
-        		//    return {solved, false};
-        		// else
-        		// {
-        		//    solved = true;
-        		//    for (int i = 0; i < mmpp_.size(); i++)
-        		//       mmpp_[i].second->clearSolutionPaths();
-
-        		//    // map new_problem solution to mmpp_
-        		//    std::vector<PathControl> plan;
-        		//    for (int a = 0; a < new_mmpp.size(); a++)
-        		//    {
-        		//       const std::string a_dyn = new_instance->getRobots()[a]->getDynamicsModel();
-        		//       // printf("Here: %s \n", a_dyn.c_str());
-        		//       if ((a_dyn == "Dynamic Car") || (a_dyn == "Kinematic Car") || (a_dyn == "Dynamic Unicycle"))
-        		//       {
-        		//          PathControl *mpath = new_mmpp[a].second->getSolutionPath()->as<PathControl>();
-        		//          plan.push_back(*mpath);
-        		//       }
-        		//       else if (a_dyn == "Two Dynamic Cars")
-        		//       {
-        		//          // seperate the paths
-        		//          PathControl *mpath = new_mmpp[a].second->getSolutionPath()->as<PathControl>();
-        		//          plan.push_back(*mpath);
-        		//          plan = decentralizeTrajectory(plan, new_instance);
-        		//       }
-        		//    }
-        		//    for (int i = 0; i < mmpp_.size(); i++)
-        		//    {
-        		//       auto path(std::make_shared<PathControl>(plan[i]));
-        		//       mmpp_[i].second->addSolutionPath(path, false, -1.0, w_->getAgents()[i]->getName());
-        		//    }
-        		//    OMPL_INFORM("%s: Found Solution in %0.3f seconds!", getName().c_str(), solveTime_ );
-        		//    OMPL_INFORM("%s: Planning Complete.", getName().c_str());
-        		//    return {solved, false};
+      		/* Plan contains conflicts that triggered the merge bound, or between two meta-agents (neither of which can be 
+      		   constrained). K-CBS must merge the two conflicting (meta-)agents */
+      		else if (shouldMerge_(agent1, agent2) || (curr->isMerged(agent1) && curr->isMerged(agent2))) {
+        	 	if (max_conflicts_ >= B_)
+        	 		OMPL_INFORM("%s: Too many conflicts exist between a pair of agents.", getName().c_str());
+        	 	OMPL_INFORM("%s: Composing a %s (of %zu agents) with a %s (of %zu agents).", getName().c_str(),
+        	    	mrmp_pdef_->getInstance()->getRobots()[agent1]->getDynamicsModel().c_str(), curr->getMetaAgent(agent1).size(),
+        	    	mrmp_pdef_->getInstance()->getRobots()[agent2]->getDynamicsModel().c_str(), curr->getMetaAgent(agent2).size());
+        	 	KCBSNode *merged = mergeAgents_(curr, agent1, agent2, ptc);
+        	 	if (!merged) {
+        	 		OMPL_ERROR("%s: Unable to merge agents %d and %d. Aborting with failure.", getName().c_str(), agent1, agent2);
+        	 		pending.stop();
+        	 		if (pipeline)
+        	 			pipeline->stop();
+        	 		stats_.nodes_generated_ = node_arena_.size();
+        	 		stats_.nodes_expanded_ = num_expansions_;
+        	 		freeMemory_();
+        	 		return {false, false};
+        	 	}
+        	 	/* continue the search with the meta-agent in place of the current node. Earlier constraint sets were planned 
+        	 	   without the meta-agent, so they are no longer duplicates */
+        	 	resetConflictCount_(agent1, agent2);
+        	 	closed_.clear();
+        	 	queuePop();
+        	 	if (eager_validation)
+        	 		validateNode_(merged);
+        	 	queuePush(merged);
       		}
       		/* Plan contains conflicts. K-CBS must remove the current node from the priority queue and attempt to expand from it */
       		else {
-        	 	pq.pop();
+        	 	queuePop();
+                KCBS_TRACE_SCOPE("KCBS::expand");
+                num_expansions_++;
+                curr->markExpanded();
+                recordReplay_("expand", curr->id, -1, 0);
+                recordTreeNode_(curr, true);
+                reportProgress_(ProgressEvent::NODE_EXPANDED, curr->id, -1, -1, curr->getCost());
+                const DiscretePlan &curr_plan = curr->getDiscretePlan();
+                /* the earliest conflict, unless the conflicts are classified */
+                const std::vector<ConflictPtr> &branch = conflict_classification_ ? selectConflict_(curr) : confs;
                 // auto plan = curr->getPlan();
                 // for (int i = 0; i < plan.size(); i++)
                 // {
@@ -375,8 +2080,11 @@ ob::PlannerStatus ompl::control::KCBS::solve(const base::PlannerTerminationCondi
                 // }
 
 
-                OMPL_INFORM("Conflict between agents: (%d, %d) at time range [%0.1f, %0.1f]", 
-                    confs.front()->agent1Idx_, confs.front()->agent2Idx_, confs.front()->timeStep_ * prop_step_size_, confs.back()->timeStep_ * prop_step_size_);
+                KCBS_LOG_INFO(getName().c_str(), "conflict", "node", curr->id, "agent1", branch.front()->agent1Idx_, "agent2", 
+                    branch.front()->agent2Idx_, "begin", branch.front()->timeStep_ * prop_step_size_, "end", 
+                    branch.back()->timeStep_ * prop_step_size_);
+                reportProgress_(ProgressEvent::CONFLICT_FOUND, curr->id, branch.front()->agent1Idx_, branch.front()->agent2Idx_, 
+                    branch.front()->timeStep_ * prop_step_size_);
 
                 // /* Debug information for the conflics */
                 // for (auto itr = confs.begin(); itr != confs.end(); itr++) {
@@ -385,9 +2093,47 @@ ob::PlannerStatus ompl::control::KCBS::solve(const base::PlannerTerminationCondi
                 // // exit(-1);
                 // std::cout << "entering createConstraint" << std::endl;
 
-        	 	/* extract conflict information */
-        	 	ConstraintPtr agent1IdxConstraint = mrmp_pdef_->getPlanValidator()->createConstraint(curr->getPlan(), confs, confs.front()->agent1Idx_);
-        	 	ConstraintPtr agent2IdxConstraint = mrmp_pdef_->getPlanValidator()->createConstraint(curr->getPlan(), confs, confs.front()->agent2Idx_);
+        	 	/* extract conflict information. Agents of a meta-agent are planned jointly, so they are never constrained (the
+        	 	   other agent of the conflict is, as it is not merged) */
+        	 	std::vector<ConstraintPtr> new_constraints;
+        	 	/* the constraint that a child also carries, on the other agent (with disjoint splitting), or nullptr */
+        	 	std::vector<ConstraintPtr> companions;
+        	 	const PhaseStart t0;
+        	 	const int split_agent = branch.front()->agent1Idx_;
+        	 	const int other_agent = branch.front()->agent2Idx_;
+        	 	std::unique_lock<std::mutex> lock = lockShared_();
+        	 	if (disjoint_splitting_ && !curr->isMerged(split_agent) && !curr->isMerged(other_agent)) {
+        	 		/* either split_agent stays in the region of its plan, which other_agent avoids, or it leaves the region */
+        	 		const PlanValidityCheckerPtr pvc = mrmp_pdef_->getPlanValidator();
+        	 		ConstraintPtr positive = pvc->createRegionConstraint(curr_plan, branch, split_agent, true);
+        	 		ConstraintPtr negative = pvc->createRegionConstraint(curr_plan, branch, split_agent, false);
+        	 		if (positive && negative) {
+        	 			new_constraints = {pvc->createConstraint(curr_plan, branch, other_agent), negative};
+        	 			companions = {positive, nullptr};
+        	 			stats_.constraints_per_agent_[other_agent]++;
+        	 			stats_.constraints_per_agent_[split_agent]++;
+        	 		}
+        	 	}
+        	 	if (new_constraints.empty()) {
+        	 		for (const int agent: {split_agent, other_agent}) {
+        	 			if (!curr->isMerged(agent)) {
+        	 				new_constraints.push_back(mrmp_pdef_->getPlanValidator()->createConstraint(curr_plan, branch, agent));
+        	 				stats_.constraints_per_agent_[agent]++;
+        	 			}
+        	 		}
+        	 	}
+        	 	lock = std::unique_lock<std::mutex>();
+        	 	companions.resize(new_constraints.size(), nullptr);
+        	 	recordTime_(stats_.constraints_, t0);
+
+        	 	/* drop the children whose constraint sets were generated before (they would be replanned for nothing) */
+        	 	if (duplicate_detection_) {
+        	 		pruneDuplicates_(curr, new_constraints, companions);
+        	 		if (new_constraints.empty()) {
+        	 			OMPL_INFORM("%s: Every child of the node is a duplicate. Discarding node.", getName().c_str());
+        	 			continue;
+        	 		}
+        	 	}
         	 	
                 // std::cout << "Creating constraints for agent " << agent1IdxConstraint->getConstrainedAgent() << std::endl;
                 // std::cout << "Time range: [" << agent1IdxConstraint->getTimes().front() << "," << agent1IdxConstraint->getTimes().back() << "]" << std::endl;
@@ -403,7 +2149,6 @@ ob::PlannerStatus ompl::control::KCBS::solve(const base::PlannerTerminationCondi
                 //     std::cout << st->as<RealVectorBeliefSpace::StateType>()->values[0] << "," << st->as<RealVectorBeliefSpace::StateType>()->values[1] << std::endl;
                 // }
 
-                std::vector<ConstraintPtr> new_constraints{agent1IdxConstraint, agent2IdxConstraint};
 
                 // for (int i = 0; i < 2; i++) {
                 //     std::cout << "Printing New Constraints " << std::endl;
@@ -414,82 +2159,184 @@ ob::PlannerStatus ompl::control::KCBS::solve(const base::PlannerTerminationCondi
                 //                  "," << new_constraints[i]->as<BeliefConstraint>()->getStates().back()->as<R2BeliefSpace::StateType>()->getXY().transpose() << std::endl;
                 // }
 
-         		for (int a = 0; a < 2; a++)
+                /* the constraints of the child of new_constraints[a] */
+                auto constrain = [&](KCBSNode *nxt, const int a) {
+                    constrainChild_(nxt, new_constraints[a], companions[a]);
+                };
+
+                /* Lazy expansion: queue the children with the plan of their parent, they are replanned once popped */
+                if (lazy_) {
+                    for (int a = 0; a < new_constraints.size(); a++) {
+                        KCBSNode *nxt = node_arena_.create();
+                        nxt->id = ++count;
+                        nxt->updateParent(curr);
+                        constrain(nxt, a);
+                        nxt->adoptPlan(curr);
+                        nxt->markLazy();
+                        queuePush(nxt);
+                    }
+                    continue;
+                }
+
+                /* Pipeline: submit the replans of the children, and expand other nodes while they run */
+                if (pipeline) {
+                    for (int a = 0; a < new_constraints.size(); a++) {
+                        const int agent = new_constraints[a]->getConstrainedAgent();
+                        KCBSNode *nxt = node_arena_.create();
+                        nxt->id = ++count;
+                        nxt->updateParent(curr);
+                        constrain(nxt, a);
+                        PlannerPtr planner = mrmp_pdef_->clonePlanner(agent);
+                        const bool cloned = (planner != nullptr);
+                        if (!cloned)
+                            planner = mrmp_pdef_->getRobotMotionPlanningProblemPtr(agent)->getPlanner();
+                        seedLowLevel_(planner, "replan", nxt->id, agent);
+                        if (cloned) {
+                            pipeline->submit(nxt, planner, nxt->getAgentConstraints(agent));
+                            in_flight.insert(nxt);
+                        }
+                        else
+                            replanned(nxt, planner, calcNewPath_(planner, nxt->getAgentConstraints(agent), ptc), false);
+                    }
+                    continue;
+                }
+
+                /* Prepare one child K-CBS Node for every new constraint */
+                std::vector<KCBSNode*> children(new_constraints.size(), nullptr);
+                std::vector<KCBSNode::ConstraintRange> children_constraints(new_constraints.size());
+                std::vector<PlannerPtr> children_planners(new_constraints.size(), nullptr);
+                std::vector<bool> cloned(new_constraints.size(), false);
+         		for (int a = 0; a < new_constraints.size(); a++)
          		{
-         			/* Prepare one child K-CBS Node for every new constraint */
          			auto new_constraint = new_constraints[a];
-            		KCBSNode nxt;
-                    nxt.id = curr->id + a + 1;
+                    children[a] = node_arena_.create();
+            		KCBSNode &nxt = *children[a];
+                    nxt.id = ++count;
             		nxt.updateParent(curr);
-            		nxt.addConstraint(new_constraint);
+            		constrain(&nxt, a);
             	
-            		/* Traverse conflict tree to get all agent constraints */
-            		std::vector<ConstraintPtr> agent_constraints{nxt.getConstraint()};
-            		const KCBSNode *nCpy = nxt.getParent();
-            		while (nCpy->getParent() != nullptr)
-            		{
-            		   if (nCpy->getConstraint()->getConstrainedAgent() == new_constraint->getConstrainedAgent())
-            		      agent_constraints.emplace_back(nCpy->getConstraint());
-            		   nCpy = nCpy->getParent();
-            		}
+            		/* Get all agent constraints from the node (no need to traverse the conflict tree) */
+            		children_constraints[a] = nxt.getAgentConstraints(new_constraint->getConstrainedAgent());
 
-                    // for (auto c: agent_constraints) {
-                    //     std::cout << "Constraint" << std::endl;
-                    //     for (auto t: c->getTimes()) {
-                    //         std::cout << t << std::endl;
-                    //     }
-                    // }
-
-                    // std::cout << "here" << std::endl;
-                    // for (auto c: agent_constraints)
-                    // {
-                    //     std::cout << c->getConstrainedAgent() << ", " << c->getConstrainingAgent() << std::endl;
-                    // }
-                    // std::cout << "done" << std::endl;
-            	
-            		/* Replan for conflicting agent w/ new constraint */
-            		PlannerPtr p = mrmp_pdef_->getRobotMotionPlanningProblemPtr(new_constraint->getConstrainedAgent())->getPlanner();
-            		oc::PathControl *new_path = calcNewPath_(p, agent_constraints);
+                    /* Select the planner. When running in parallel, every child gets its own clone */
+                    if (num_threads_ > 1 || background_pending_) {
+                        children_planners[a] = mrmp_pdef_->clonePlanner(new_constraint->getConstrainedAgent());
+                        cloned[a] = (children_planners[a] != nullptr);
+                    }
+                    if (!children_planners[a])
+                        children_planners[a] = mrmp_pdef_->getRobotMotionPlanningProblemPtr(new_constraint->getConstrainedAgent())->getPlanner();
+                    /* seeded in the order of the children, before they are replanned (in parallel or not) */
+                    seedLowLevel_(children_planners[a], "replan", nxt.id, new_constraint->getConstrainedAgent());
+                }
+
+            	/* Replan for conflicting agents w/ new constraints */
+                std::vector<oc::PathControl*> new_paths(new_constraints.size(), nullptr);
+                if (num_threads_ > 1) {
+                    TaskGroup workers(&ptc);
+                    workers.runAndWait(new_constraints.size(), [this, &ptc, &new_paths, &children_planners, &children_constraints](const std::size_t a) {
+                        new_paths[a] = calcNewPath_(children_planners[a], children_constraints[a], ptc);
+                    });
+                }
+                else {
+                    for (int a = 0; a < new_constraints.size(); a++)
+                        new_paths[a] = calcNewPath_(children_planners[a], children_constraints[a], ptc);
+                }
+
+                /* Bypass: if a child is no more expensive and has fewer conflicts, adopt its plan instead of branching */
+                std::vector<bool> planned(new_constraints.size(), false);
+                if (bypass_) {
+                    KCBSNode *adopted = nullptr;
+                    for (int a = 0; a < new_constraints.size() && !adopted; a++) {
+                        if (!new_paths[a])
+                            continue;
+                        KCBSNode &nxt = *children[a];
+                        nxt.updatePlanAndCost(curr, new_constraints[a]->getConstrainedAgent(), *new_paths[a]);
+                        planned[a] = true;
+                        if (nxt.getCost() > curr->getCost())
+                            continue;
+                        validateNode_(&nxt);
+                        if (nxt.getNumConflicts() < curr->getNumConflicts())
+                            adopted = &nxt;
+                    }
+                    if (adopted) {
+                        KCBS_LOG_INFO(getName().c_str(), "bypass", "node", curr->id);
+                        curr->adoptPlan(adopted);
+                        queuePush(curr);
+                        num_bypasses_++;
+                        num_bypassed_nodes_ += new_constraints.size();
+                        continue;
+                    }
+                }
 
-            		if (new_path) {
+                for (int a = 0; a < new_constraints.size(); a++)
+                {
+                    KCBSNode &nxt = *children[a];
+                    const int agent = new_constraints[a]->getConstrainedAgent();
+            		if (new_paths[a]) {
             			/* Create new node and add it to the queue */
-            			Plan new_plan = curr->getPlan();
-            			new_plan[new_constraint->getConstrainedAgent()] = *new_path;
-            			nxt.updatePlanAndCost(new_plan);
-            			pq.emplace(nxt);
+            			if (!planned[a])
+            				nxt.updatePlanAndCost(curr, agent, *new_paths[a]);
+            			if (eager_validation && !nxt.isValidated())
+            				validateNode_(&nxt);
+            			queuePush(&nxt);
             		}
             		else {
-            			/* Failed to find solution. Save the planner inside node, reset the global planner, and add to end of queue */
-            			nxt.savePlanner(p);
-            			mrmp_pdef_->replacePlanner(p, new_constraint->getConstrainedAgent());
-            			pq.emplace(nxt);
+            			/* Failed to find solution. Save the planner inside node, reset the global planner (if it was used), and hand it to the scheduler */
+            			nxt.savePlanner(children_planners[a]);
+                        if (!cloned[a])
+            			    mrmp_pdef_->replacePlanner(children_planners[a], agent);
+            			pending.add(&nxt);
+            			in_flight.insert(&nxt);
             		}
          		}
       		}
       	}
    	}
    	/* End of main loop. If possible, add solutions to every MotionPlanningProblem */
+   	pending.stop();
+   	if (pipeline)
+   		pipeline->stop();
+   	/* stopped by the time limit: save where the search is, so it can be resumed from there */
+   	if (checkpointing && ptc == true && (!pq.empty() || !in_flight.empty()))
+   		checkpoint();
+   	if (distributed) {
+   		/* the hub ends the search of every rank */
+   		if (cluster_->isHub())
+   			cluster_->finish();
+   		OMPL_INFORM("%s: Rank %d gave away %u nodes and received %u.", getName().c_str(), cluster_->getRank(), 
+   			stats_.nodes_sent_, stats_.nodes_received_);
+   	}
+   	stats_.nodes_generated_ = node_arena_.size();
+   	stats_.nodes_expanded_ = num_expansions_;
+   	stats_.peak_rss_bytes_ = perf::peakResidentBytes();
    	auto stop = std::chrono::high_resolution_clock::now();
    	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-   	computation_time_ = (duration.count() / 1000000.0);
+   	computation_time_ = resumed_time + (duration.count() / 1000000.0);
+   	OMPL_INFORM("%s: Expanded %u nodes in %0.3f seconds.", getName().c_str(), num_expansions_, computation_time_);
+   	if (bypass_)
+   	   	OMPL_INFORM("%s: Bypassed %u conflicts, saving %u nodes.", getName().c_str(), num_bypasses_, num_bypassed_nodes_);
+   	OMPL_INFORM("%s: Conflict tree peaked at %zu nodes (%zu bytes).", getName().c_str(), node_arena_.getPeakSize(), node_arena_.getPeakBytes());
+   	if (memory_budget_ > 0)
+   		OMPL_INFORM("%s: Queued plans peaked at %zu bytes, %u nodes were compressed.", getName().c_str(), 
+   			stats_.peak_queue_bytes_, stats_.nodes_compressed_);
+   	for (std::size_t m = 0; m < stats_.portfolio_wins_.size(); m++)
+   		OMPL_INFORM("%s: %s won %u replans.", getName().c_str(), (m == 0) ? "The agents' planner" : 
+   			("Portfolio member " + std::to_string(m) + " (" + portfolio_[m - 1].planner_ + ")").c_str(), stats_.portfolio_wins_[m]);
    	bool solved = false;
    	if (solution == nullptr) {
    	 	if (ptc == true)
    	 	   OMPL_INFORM("%s: No solution found due to time.", getName().c_str());
+   	 	freeMemory_();
    	 	return {solved, false};
    	}
    	else {
    	 	solved = true;
    	 	OMPL_INFORM("%s: Found Solution in %0.3f seconds!", getName().c_str(), computation_time_);
-   	 	auto sol_plan = solution->getPlan();
-        for (int i = 0; i < sol_plan.size(); i++)
-        {
-            auto path(std::make_shared<PathControl>(sol_plan[i]));
-            mrmp_pdef_->getRobotProblemDefinitionPtr(i)->clearSolutionPaths();
-            mrmp_pdef_->getRobotProblemDefinitionPtr(i)->addSolutionPath(path, false, -1.0, getName().c_str());
-            soc_ += path->length();
-        }
+   	 	publishSolution_(solution);
+   	 	if (group_.empty())
+   	 		saveOnlineState_(solution->getPlan(), solution);
    	 	OMPL_INFORM("%s: Planning Complete.", getName().c_str());
+   	 	freeMemory_();
    	 	return {solved, false};
    	}
 }
@@ -55,6 +55,20 @@ ompl::control::MultiRobotRRT::~MultiRobotRRT()
 void ompl::control::MultiRobotRRT::setup()
 {
     base::Planner::setup();
+    if (!propagation_)
+        propagation_.reset(new AgentDecoupledPropagation(siC_, [this](const base::State *from, const std::vector<bool> &active, base::State *to) {
+            const auto *space = si_->getStateSpace()->as<base::CompoundStateSpace>();
+            const auto *src = from->as<base::CompoundStateSpace::StateType>();
+            auto *destination = to->as<base::CompoundStateSpace::StateType>();
+            // the x-y and orientation sub-states of the vehicles in goal
+            for (std::size_t i = 0; i < active.size(); i++)
+            {
+                if (active[i])
+                    continue;
+                space->getSubspace(2*i)->copyState(destination->components[2*i], src->components[2*i]);
+                space->getSubspace(2*i + 1)->copyState(destination->components[2*i + 1], src->components[2*i + 1]);
+            }
+        }));
     if (!nn_)
         nn_.reset(tools::SelfConfig::getDefaultNearestNeighbors<Motion *>(this));
     nn_->setDistanceFunction([this](const Motion *a, const Motion *b) { return distanceFunction(a, b); });
@@ -89,69 +103,30 @@ void ompl::control::MultiRobotRRT::freeMemory()
 }
 
 unsigned int ompl::control::MultiRobotRRT::MultiAgentControlSampler(Control *rcontrol, Control *previous, 
-    const base::State *source, base::State *dest)
+    const base::State *source, std::vector<bool> &active)
 {
     // determine which agents are already in goal
     auto g = getProblemDefinition()->getGoal()->as<R2MultiRobotGoal>();
     std::vector<int> idxInGoal = g->isInGoal(source);
 
-    // propogate as normal
-    /* sample a random control that attempts to go towards the random state, and also sample a control duration */
-    unsigned int cd = controlSampler_->sampleTo(rcontrol, previous, source, dest);
-    /* override destination for agents already in goal */
-    overrideStates(idxInGoal, source, dest, rcontrol); 
-    return cd;
-}
+    /* sample a random control and a control duration, as the default directed control sampler does */
+    if (previous)
+        controlSampler_->sampleNext(rcontrol, previous, source);
+    else
+        controlSampler_->sample(rcontrol, source);
+    const unsigned int cd = controlSampler_->sampleStepCount(siC_->getMinControlDuration(), siC_->getMaxControlDuration());
 
-void ompl::control::MultiRobotRRT::overrideStates(const std::vector<int> DoNotProp, const base::State *source, 
-    base::State *result, Control *control)
-{
-    // this function takes in a state and a list of vehicle indexes that do not need to be propogated
-    // it changes the state s.t. state propogation and controls are null for any vehicles in the goal
-    if (DoNotProp.size() > 0)
+    /* the vehicles in goal keep still */
+    // (two sub-states, x-y and orientation, and two controls per vehicle)
+    active.assign(si_->getStateSpace()->as<base::CompoundStateSpace>()->getSubspaceCount() / 2, true);
+    auto *cntrl = rcontrol->as<RealVectorControlSpace::ControlType>()->values;
+    for (const int i: idxInGoal)
     {
-        // this array has a list of vehicles that do not need to be progpogated
-        // we need to iterate through all of them
-
-        // get the entire compound state for result
-        auto destination = result->as<ompl::base::CompoundStateSpace::StateType>();
-
-        // get the entire compound state space for source
-        const auto *src = source->as<ob::CompoundStateSpace::StateType>();
-
-        auto *cntrl = control->as<RealVectorControlSpace::ControlType>()->values;
-
-        for (int i = 0; i < DoNotProp.size(); i++)
-        {
-            // overriding controls 
-            // indexing method: ControlDimension(vehicle index) + ControlIndex
-            cntrl[2*DoNotProp[i] + 0] = 0.0;
-            cntrl[2*DoNotProp[i] + 1] = 0.0;
-
-            // next, make the source state the destination state for the indiv. vehicles
-            // indexing method: 2(vehicle) or 2(vehicle) + 1
-
-            // get the specific xy state of result 
-            auto *xyDest = destination->as<base::RealVectorStateSpace::StateType>(2*DoNotProp[i]);
-
-            // get the specific xy state of the source
-            const auto *xySrc = src->as<base::RealVectorStateSpace::StateType>(2*DoNotProp[i]);
-
-            // get the specific orientation of result
-            auto *rotDest = destination->as<base::SO2StateSpace::StateType>(2*DoNotProp[i] + 1);
-
-            // get the specific orientation of the source
-            const auto *rotSrc = src->as<base::SO2StateSpace::StateType>(2*DoNotProp[i] + 1);
-
-            // overriding the position state
-            xyDest->values[0] = xySrc->values[0];
-            xyDest->values[1] = xySrc->values[1];
-
-            // overriding the orientation
-            rotDest->value = rotSrc->value;
-
-        }
+        active[i] = false;
+        cntrl[2*i + 0] = 0.0;
+        cntrl[2*i + 1] = 0.0;
     }
+    return cd;
 }
  
 ompl::base::PlannerStatus ompl::control::MultiRobotRRT::solve(const base::PlannerTerminationCondition &ptc)
@@ -177,7 +152,7 @@ ompl::base::PlannerStatus ompl::control::MultiRobotRRT::solve(const base::Planne
     if (!sampler_)
         sampler_ = si_->allocStateSampler();
     if (!controlSampler_)
-        controlSampler_ = siC_->allocDirectedControlSampler();
+        controlSampler_ = siC_->allocControlSampler();
  
     OMPL_INFORM("%s: Starting planning with %u states already in datastructure", getName().c_str(), nn_->size());
     auto start = std::chrono::high_resolution_clock::now();
@@ -201,15 +176,15 @@ ompl::base::PlannerStatus ompl::control::MultiRobotRRT::solve(const base::Planne
         /* find closest state in the tree */
         Motion *nmotion = nn_->nearest(rmotion);
  
-        /* sample a random control that attempts to go towards the random state, and also sample a control duration */
-        // unsigned int cd = controlSampler_->sampleTo(rctrl, nmotion->control, nmotion->state, rmotion->state);
-        unsigned int cd = MultiAgentControlSampler(rctrl, nmotion->control, nmotion->state, rmotion->state);
+        /* sample a random control and a control duration, and propagate the vehicles that are not in goal */
+        std::vector<bool> active;
+        unsigned int cd = MultiAgentControlSampler(rctrl, nmotion->control, nmotion->state, active);
  
         if (addIntermediateStates_)
         {
             // this code is contributed by Jennifer Barry
             std::vector<base::State *> pstates;
-            cd = siC_->propagateWhileValid(nmotion->state, rctrl, cd, pstates, true);
+            cd = propagation_->propagateWhileValid(nmotion->state, rctrl, cd, active, pstates);
  
             if (cd >= siC_->getMinControlDuration())
             {
@@ -255,6 +230,7 @@ ompl::base::PlannerStatus ompl::control::MultiRobotRRT::solve(const base::Planne
         }
         else
         {
+            cd = propagation_->propagateWhileValid(nmotion->state, rctrl, cd, active, rstate);
             if (cd >= siC_->getMinControlDuration())
             {
                 /* create a motion */
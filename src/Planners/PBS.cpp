@@ -35,6 +35,13 @@
 /* Author: Justin Kottinger */
  
 #include "Planners/PBS.h"
+#include "utils/DiscretePlan.h"
+#include "utils/SweepAndPrune.h"
+#include "utils/TaskRuntime.h"
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <ompl/base/spaces/SO2StateSpace.h>
+#include <algorithm>
+#include <chrono>
 
  
 ompl::control::PBS::PBS(const std::vector<MotionPlanningProblemPtr> mmpp): 
@@ -44,7 +51,204 @@ ompl::control::PBS::PBS(const std::vector<MotionPlanningProblemPtr> mmpp):
 
 ompl::control::PBS::~PBS()
 {
-    // OMPL_ERROR("Desturctor called but not implemented");
+    clear();
+}
+
+void ompl::control::PBS::clear()
+{
+    base::Planner::clear();
+    for (PlannerSlot &slot: slots_)
+    {
+        for (auto &planner: slot.planners_)
+            planner->clear();
+    }
+    slots_.clear();
+    footprints_.clear();
+    solution_.clear();
+    expanded_ = 0;
+}
+
+void ompl::control::PBS::setupSlots_()
+{
+    if (!slots_.empty())
+        return;
+    footprints_.resize(mmpp_.size());
+    for (std::size_t a = 0; a < mmpp_.size(); a++)
+    {
+        if (!RobotFootprint::fromRobot(*mrmp_instance_->getRobots()[a], footprints_[a]))
+            OMPL_WARN("%s: Robot %d has more than %d corners, only the first are checked.", getName().c_str(), static_cast<int>(a), RobotFootprint::max_corners_);
+    }
+    /* slot 0 plans on the problem definitions of the agents, slot 1 on copies (same start and goal) */
+    slots_.resize(parallel_branches_ ? 2 : 1);
+    for (std::size_t s = 0; s < slots_.size(); s++)
+    {
+        for (std::size_t a = 0; a < mmpp_.size(); a++)
+        {
+            const base::SpaceInformationPtr &si = mmpp_[a]->getSpaceInformation();
+            base::ProblemDefinitionPtr pdef = mmpp_[a]->getProblemDefinition();
+            if (s > 0)
+            {
+                base::ProblemDefinitionPtr orig = pdef;
+                pdef = std::make_shared<base::ProblemDefinition>(si);
+                pdef->addStartState(orig->getStartState(0));
+                pdef->setGoal(orig->getGoal());
+            }
+            auto planner = std::make_shared<PrioritizedRRT>(std::static_pointer_cast<SpaceInformation>(si));
+            planner->setInstance(mrmp_instance_);
+            planner->setProblemDefinition(pdef);
+            planner->provideRobot(mrmp_instance_->getRobots()[a]);
+            planner->setup();
+            slots_[s].planners_.push_back(planner);
+        }
+    }
+}
+
+bool ompl::control::PBS::isHigher_(const Node &n, const int a, const int b)
+{
+    /* depth-first over the pairs from a */
+    std::vector<int> open{a};
+    std::vector<bool> seen(n.plan_.size(), false);
+    seen[a] = true;
+    while (!open.empty())
+    {
+        const int h = open.back();
+        open.pop_back();
+        for (const auto &pr: n.priorities_)
+        {
+            if (pr.first != h || seen[pr.second])
+                continue;
+            if (pr.second == b)
+                return true;
+            seen[pr.second] = true;
+            open.push_back(pr.second);
+        }
+    }
+    return false;
+}
+
+namespace
+{
+    /* robots stay at their last state once their trajectory ends */
+    RobotFootprint footprintAt(const ompl::control::PathControl &traj, const int step, const RobotFootprint &shape)
+    {
+        const ompl::base::State *st = traj.getState(std::min<int>(step, traj.getStateCount() - 1));
+        auto compState = st->as<ompl::base::CompoundStateSpace::StateType>();
+        auto xyState = compState->as<ompl::base::RealVectorStateSpace::StateType>(0);
+        const double theta = compState->as<ompl::base::SO2StateSpace::StateType>(1)->value;
+        return shape.transformed(xyState->values[0], xyState->values[1], theta);
+    }
+
+    int maxStateCount(const std::vector<std::shared_ptr<const ompl::control::PathControl>> &plan)
+    {
+        int n = 0;
+        for (const auto &traj: plan)
+            n = std::max<int>(n, traj->getStateCount());
+        return n;
+    }
+}
+
+bool ompl::control::PBS::firstConflict_(const Node &n, int &a, int &b) const
+{
+    const int agents = n.plan_.size();
+    std::vector<RobotFootprint> shapes(agents);
+    SweepAndPrune broadphase;
+    broadphase.resize(agents);
+    const int steps = maxStateCount(n.plan_);
+    for (int k = 0; k < steps; k++)
+    {
+        for (int i = 0; i < agents; i++)
+        {
+            shapes[i] = footprintAt(*n.plan_[i], k, footprints_[i]);
+            broadphase.setBox(i, shapes[i].minX(), shapes[i].maxX(), shapes[i].minY(), shapes[i].maxY());
+        }
+        for (const auto &pr: broadphase.sweep())
+        {
+            if (!RobotFootprint::disjoint(shapes[pr.first], shapes[pr.second]))
+            {
+                a = pr.first;
+                b = pr.second;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool ompl::control::PBS::collide_(const Node &n, const int a, const int b) const
+{
+    const int steps = std::max(n.plan_[a]->getStateCount(), n.plan_[b]->getStateCount());
+    for (int k = 0; k < steps; k++)
+    {
+        if (!RobotFootprint::disjoint(footprintAt(*n.plan_[a], k, footprints_[a]), footprintAt(*n.plan_[b], k, footprints_[b])))
+            return true;
+    }
+    return false;
+}
+
+bool ompl::control::PBS::replan_(Node &n, const int agent, PlannerSlot &slot, const base::PlannerTerminationCondition &ptc)
+{
+    /* avoid the (interpolated) paths of every agent above */
+    std::vector<PathControl> existing;
+    std::vector<int> agents;
+    for (int j = 0; j < static_cast<int>(n.plan_.size()); j++)
+    {
+        if (j != agent && n.plan_[j] && isHigher_(n, j, agent))
+        {
+            existing.push_back(*n.plan_[j]);
+            agents.push_back(j);
+        }
+    }
+    PrioritizedRRT &planner = *slot.planners_[agent];
+    const base::ProblemDefinitionPtr &pdef = planner.getProblemDefinition();
+    planner.clear();
+    pdef->clearSolutionPaths();
+    planner.setExistingSolutions(std::move(existing), std::move(agents));
+    const base::PlannerStatus solved = planner.solve(base::plannerOrTerminationCondition(ptc,
+        base::timedPlannerTerminationCondition(low_level_time_)));
+    if (solved != base::PlannerStatus::EXACT_SOLUTION)
+        return false;
+    if (n.plan_[agent])
+        n.cost_ -= n.plan_[agent]->length();
+    n.plan_[agent] = DiscretePlan::discretize(*pdef->getSolutionPath()->as<PathControl>());
+    n.cost_ += n.plan_[agent]->length();
+    return true;
+}
+
+ompl::control::PBS::NodePtr ompl::control::PBS::branch_(const NodePtr &parent, const int high, const int low,
+    PlannerSlot &slot, const base::PlannerTerminationCondition &ptc)
+{
+    if (isHigher_(*parent, low, high))
+        return nullptr;
+    NodePtr child = std::make_shared<Node>(*parent);
+    child->priorities_.emplace_back(high, low);
+    if (!replan_(*child, low, slot, ptc))
+        return nullptr;
+    /* the agents below low, in topological order, only replanned if they collide with an agent above them */
+    std::vector<int> below;
+    for (int j = 0; j < static_cast<int>(child->plan_.size()); j++)
+    {
+        if (isHigher_(*child, low, j))
+            below.push_back(j);
+    }
+    std::vector<bool> done(child->plan_.size(), false);
+    while (!below.empty())
+    {
+        auto next = std::find_if(below.begin(), below.end(), [&](const int j) {
+            return std::none_of(below.begin(), below.end(), [&](const int i) {return i != j && isHigher_(*child, i, j);});
+        });
+        const int j = *next;
+        below.erase(next);
+        for (int i = 0; i < static_cast<int>(child->plan_.size()); i++)
+        {
+            if (i != j && isHigher_(*child, i, j) && collide_(*child, i, j))
+            {
+                if (!replan_(*child, j, slot, ptc))
+                    return nullptr;
+                break;
+            }
+        }
+    }
+    return child;
 }
 
 ompl::base::PlannerStatus ompl::control::PBS::solve(const base::PlannerTerminationCondition &ptc)
@@ -67,61 +271,71 @@ ompl::base::PlannerStatus ompl::control::PBS::solve(const base::PlannerTerminati
         OMPL_ERROR("No world specified.");
         return base::PlannerStatus::INVALID_START;
     }
+    setupSlots_();
+    solution_.clear();
+    expanded_ = 0;
 
-    /* create instances of low-level planner */
-    std::vector<oc::PrioritizedRRT*> treeSearchs;
-    for (int a = 0; a < mmpp_.size(); a++)
-    {
-        PrioritizedRRT* planner = new PrioritizedRRT(mmpp_[a]->getSpaceInformation());
-        planner->setInstance(mrmp_instance_);
-        planner->setProblemDefinition(mmpp_[a]->getProblemDefinition());
-        planner->provideRobot(mrmp_instance_->getRobots()[a]);
-        planner->setup();
-        treeSearchs.push_back(planner);
-    }
-    /* plan */
-    std::vector<PathControl> solution;
     OMPL_INFORM("%s: Starting planning. ", getName().c_str());
     auto start = std::chrono::high_resolution_clock::now();
-    bool solved = false;
-    for (auto p: treeSearchs)
+    /* the root plans every agent on its own */
+    NodePtr root = std::make_shared<Node>();
+    root->plan_.resize(mmpp_.size());
+    for (std::size_t a = 0; a < mmpp_.size() && root; a++)
+    {
+        if (!replan_(*root, a, slots_[0], ptc))
+            root = nullptr;
+    }
+    std::vector<NodePtr> open;
+    if (root)
+        open.push_back(root);
+    NodePtr goal = nullptr;
+    while (!ptc && !open.empty())
     {
-        p->setExistingSolutions(solution);
-        ob::PlannerStatus solved = p->solve(ptc);
-        /* store initial trajectory */
-        if (solved)
+        NodePtr n = open.back();
+        open.pop_back();
+        expanded_++;
+        int a, b;
+        if (!firstConflict_(*n, a, b))
         {
-            PathControl traj = static_cast<PathControl &>
-            (*p->ob::Planner::getProblemDefinition()->getSolutionPath());
-            solution.push_back(traj);
+            goal = n;
+            break;
+        }
+        NodePtr children[2];
+        if (parallel_branches_ && slots_.size() > 1)
+        {
+            TaskGroup branches;
+            branches.run([&]() {children[1] = branch_(n, b, a, slots_[1], ptc);});
+            children[0] = branch_(n, a, b, slots_[0], ptc);
+            branches.wait();
         }
         else
-            break;
+        {
+            children[0] = branch_(n, a, b, slots_[0], ptc);
+            children[1] = branch_(n, b, a, slots_[0], ptc);
+        }
+        /* depth-first, the cheaper child is expanded next */
+        if (children[0] && children[1] && children[0]->cost_ < children[1]->cost_)
+            std::swap(children[0], children[1]);
+        for (const NodePtr &c: children)
+        {
+            if (c)
+                open.push_back(c);
+        }
     }
     auto stop = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
     solveTime_ = (duration.count() / 1000000.0);
-    if (solution.size() == treeSearchs.size())
-        solved = true;
-    /* clean up */
-    for (auto p: treeSearchs)
-    {
-       p->clear();
-       delete p;
-    }
-    if (solved)
-    {
-        OMPL_INFORM("PBS returned correct solution.");
-        return {solved, false};
-    }
-    else
+    if (goal)
     {
-        OMPL_INFORM("%s: No Solution Found.", getName().c_str());
-        return {solved, false};
+        for (std::size_t a = 0; a < mmpp_.size(); a++)
+        {
+            solution_.push_back(*goal->plan_[a]);
+            mmpp_[a]->getProblemDefinition()->clearSolutionPaths();
+            mmpp_[a]->getProblemDefinition()->addSolutionPath(std::make_shared<PathControl>(solution_.back()));
+        }
+        OMPL_INFORM("%s: Found a solution after expanding %lu nodes (cost %0.2f).", getName().c_str(), expanded_, goal->cost_);
+        return {true, false};
     }
+    OMPL_INFORM("%s: No Solution Found after expanding %lu nodes.", getName().c_str(), expanded_);
+    return {false, false};
 }
-
-
-
-
-
@@ -90,192 +90,48 @@ void ompl::control::PrioritizedRRT::freeMemory()
     }
 }
 
-bool ompl::control::PrioritizedRRT::isCollisionFree(Motion* current)
+void ompl::control::PrioritizedRRT::reserveExistingSolutions_()
 {
-    if (existingSolns_.empty())
-        return true;
-
-    /* construct the path segment */
-    Motion *m = current;
-    std::vector<Motion *> mpath;
-    while (m != nullptr)
+    std::vector<std::vector<RobotFootprint>> paths(existingSolns_.size());
+    for (std::size_t agentIdx = 0; agentIdx < existingSolns_.size(); agentIdx++)
     {
-        mpath.push_back(m);
-        m = m->parent;
+        // without agents, the existing solutions are those of the first robots of the instance, in order
+        const int robot = existingAgents_.empty() ? agentIdx : existingAgents_[agentIdx];
+        RobotFootprint shape;
+        RobotFootprint::fromRobot(*mrmp_instance_->getRobots()[robot], shape);
+        paths[agentIdx].reserve(existingSolns_[agentIdx].getStateCount());
+        for (const base::State *st: existingSolns_[agentIdx].getStates())
+            paths[agentIdx].push_back(footprintAt_(st, shape));
     }
- 
-    /* set the path segment */
-    PathControl pathSegment(si_);
-    for (int i = mpath.size() - 1; i >= 0; --i)
-        if (mpath[i]->parent)
-            pathSegment.append(mpath[i]->state, mpath[i]->control, mpath[i]->steps * siC_->getPropagationStepSize());
-        else
-            pathSegment.append(mpath[i]->state);
-
-    // interpolate the path to match existing solutions
-    pathSegment.interpolate();
-
-    int currStateStep = pathSegment.getStateCount()-1;
+    reservations_ = ReservationTable(paths);
+}
 
-    // for every state in pathSegment, check disjointedness against existingSolutions
-    // for (int k = 0; k < pathSegment.getStateCount(); k++)
-    // {
-    // create agent
-    // const double agent_width = a_->getShape()[0];
-    // const double agent_height = a_->getShape()[1];
-    // extract points from state object
-    auto compState = current->state->as<ob::CompoundStateSpace::StateType>();
+RobotFootprint ompl::control::PrioritizedRRT::footprintAt_(const base::State *st, const RobotFootprint &shape)
+{
+    auto compState = st->as<ob::CompoundStateSpace::StateType>();
     auto xyState = compState->as<ob::RealVectorStateSpace::StateType>(0);
-    const double agent_cx = xyState->values[0];
-    const double agent_cy = xyState->values[1];
     const double theta = compState->as<ob::SO2StateSpace::StateType>(1)->value;
-    // // const double theta = 0.0;
-    // // turn (x,y, theta), width, length to a polygon object
-    // // borrowed from conflictChecking
-    // // TOP RIGHT VERTEX:
-    // const double TR_x = agent_cx + ((agent_width / 2) * cos(theta)) - ((agent_height / 2) * sin(theta));
-    // const double TR_y = agent_cy + ((agent_width / 2) * sin(theta)) + ((agent_height / 2) * cos(theta));
-    // std::string top_right = std::to_string(TR_x) + " " + std::to_string(TR_y);
-    // // TOP LEFT VERTEX:
-    // const double TL_x = agent_cx - ((agent_width / 2) * cos(theta)) - ((agent_height / 2) * sin(theta));
-    // const double TL_y = agent_cy - ((agent_width / 2) * sin(theta)) + ((agent_height / 2) * cos(theta));
-    // std::string top_left = std::to_string(TL_x) + " " + std::to_string(TL_y);
-    // // BOTTOM LEFT VERTEX:
-    // const double BL_x = agent_cx - ((agent_width / 2) * cos(theta)) + ((agent_height / 2) * sin(theta));
-    // const double BL_y = agent_cy - ((agent_width / 2) * sin(theta)) - ((agent_height / 2) * cos(theta));
-    // std::string bottom_left = std::to_string(BL_x) + " " + std::to_string(BL_y);
-    // // BOTTOM RIGHT VERTEX:
-    // const double BR_x = agent_cx + ((agent_width / 2) * cos(theta)) + ((agent_height / 2) * sin(theta));
-    // const double BR_y = agent_cy + ((agent_width / 2) * sin(theta)) - ((agent_height / 2) * cos(theta));
-    // std::string bottom_right = std::to_string(BR_x) + " " + std::to_string(BR_y);
-    // // convert to string for easy initializataion
-    // std::string points = "POLYGON((" + bottom_left + "," + bottom_right + "," + top_right + "," + top_left + "," + bottom_left + "))";
-    // polygon planning_agent;
-    // boost::geometry::read_wkt(points, planning_agent);
-
-    // beta test: use boost transform instread of manual polygon creation
-    Polygon raw;
-    Polygon planning_agent;
-    Polygon initial = robot_->getShape();
-    bg::correct(raw);
-    bg::assign(raw, initial);
-    bg::strategy::transform::matrix_transformer<double, 2, 2> xfrm(
-             cos(theta), sin(theta), agent_cx,
-            -sin(theta), cos(theta), agent_cy,
-                      0,          0,  1);
-
-    bg::transform(raw, planning_agent, xfrm);
-        
-    for (int agentIdx = 0; agentIdx < existingSolns_.size(); agentIdx++)
-    {
-        PathControl existingPath = existingSolns_[agentIdx];
-        // // does exisiting path at k exist?
-        // bool check = false;
-        if (currStateStep < existingPath.getStateCount())
-        {
-            // check = true;
-            // create other agent shape
-            const Robot *otherAgent = mrmp_instance_->getRobots()[agentIdx];
-            // const double otherAgent_width = otherAgent->getShape()[0];
-            // const double otherAgent_height = otherAgent->getShape()[1];
-            // extract points from state object
-            auto compState = existingPath.getState(currStateStep)->as<ob::CompoundStateSpace::StateType>();
-            auto xyState = compState->as<ob::RealVectorStateSpace::StateType>(0);
-            const double otherAgent_cx = xyState->values[0];
-            const double otherAgent_cy = xyState->values[1];
-            const double otherAgent_theta = compState->as<ob::SO2StateSpace::StateType>(1)->value;
-            // // const double theta = 0.0;
-            // // turn (x,y, theta), width, length to a polygon object
-            // // borrowed from conflictChecking
-            // // TOP RIGHT VERTEX:
-            // const double TR_x = otherAgent_cx + ((otherAgent_width / 2) * cos(theta)) - ((otherAgent_height / 2) * sin(theta));
-            // const double TR_y = otherAgent_cy + ((otherAgent_width / 2) * sin(theta)) + ((otherAgent_height / 2) * cos(theta));
-            // std::string top_right = std::to_string(TR_x) + " " + std::to_string(TR_y);
-            // // TOP LEFT VERTEX:
-            // const double TL_x = otherAgent_cx - ((otherAgent_width / 2) * cos(theta)) - ((otherAgent_height / 2) * sin(theta));
-            // const double TL_y = otherAgent_cy - ((otherAgent_width / 2) * sin(theta)) + ((otherAgent_height / 2) * cos(theta));
-            // std::string top_left = std::to_string(TL_x) + " " + std::to_string(TL_y);
-            // // BOTTOM LEFT VERTEX:
-            // const double BL_x = otherAgent_cx - ((otherAgent_width / 2) * cos(theta)) + ((otherAgent_height / 2) * sin(theta));
-            // const double BL_y = otherAgent_cy - ((otherAgent_width / 2) * sin(theta)) - ((otherAgent_height / 2) * cos(theta));
-            // std::string bottom_left = std::to_string(BL_x) + " " + std::to_string(BL_y);
-            // // BOTTOM RIGHT VERTEX:
-            // const double BR_x = otherAgent_cx + ((otherAgent_width / 2) * cos(theta)) + ((otherAgent_height / 2) * sin(theta));
-            // const double BR_y = otherAgent_cy + ((otherAgent_width / 2) * sin(theta)) - ((otherAgent_height / 2) * cos(theta));
-            // std::string bottom_right = std::to_string(BR_x) + " " + std::to_string(BR_y);
-            // // convert to string for easy initializataion
-            // std::string points = "POLYGON((" + bottom_left + "," + bottom_right + "," + top_right + "," + top_left + "," + bottom_left + "))";
-            // polygon other_agent;
-            // boost::geometry::read_wkt(points,other_agent);
-
-            Polygon raw;
-            Polygon other_agent;
-            Polygon initial = otherAgent->getShape();
-            bg::correct(raw);
-            bg::assign(raw, initial);
-            bg::strategy::transform::matrix_transformer<double, 2, 2> xfrm(
-                     cos(otherAgent_theta), sin(otherAgent_theta), otherAgent_cx,
-                    -sin(otherAgent_theta), cos(otherAgent_theta), otherAgent_cy,
-                              0,          0,  1);
-            bg::transform(raw, other_agent, xfrm);
-
-            // check if planning_agent is disjoint from other_agent
-            if (! boost::geometry::disjoint(planning_agent, other_agent))
-                return false;
-        }
-        else
-        {
-            // need to check final state
-            // create other agent shape
-            const Robot *otherAgent = mrmp_instance_->getRobots()[agentIdx];
-            // const double otherAgent_width = otherAgent->getShape()[0];
-            // const double otherAgent_height = otherAgent->getShape()[1];
-            auto compState = existingPath.getStates().back()->as<ob::CompoundStateSpace::StateType>();
-            auto xyState = compState->as<ob::RealVectorStateSpace::StateType>(0);
-            const double otherAgent_cx = xyState->values[0];
-            const double otherAgent_cy = xyState->values[1];
-            const double otherAgent_theta = compState->as<ob::SO2StateSpace::StateType>(1)->value;
-            // // const double theta = 0.0;
-            // // turn (x,y, theta), width, length to a polygon object
-            // // borrowed from conflictChecking
-            // // TOP RIGHT VERTEX:
-            // const double TR_x = otherAgent_cx + ((otherAgent_width / 2) * cos(theta)) - ((otherAgent_height / 2) * sin(theta));
-            // const double TR_y = otherAgent_cy + ((otherAgent_width / 2) * sin(theta)) + ((otherAgent_height / 2) * cos(theta));
-            // std::string top_right = std::to_string(TR_x) + " " + std::to_string(TR_y);
-            // // TOP LEFT VERTEX:
-            // const double TL_x = otherAgent_cx - ((otherAgent_width / 2) * cos(theta)) - ((otherAgent_height / 2) * sin(theta));
-            // const double TL_y = otherAgent_cy - ((otherAgent_width / 2) * sin(theta)) + ((otherAgent_height / 2) * cos(theta));
-            // std::string top_left = std::to_string(TL_x) + " " + std::to_string(TL_y);
-            // // BOTTOM LEFT VERTEX:
-            // const double BL_x = otherAgent_cx - ((otherAgent_width / 2) * cos(theta)) + ((otherAgent_height / 2) * sin(theta));
-            // const double BL_y = otherAgent_cy - ((otherAgent_width / 2) * sin(theta)) - ((otherAgent_height / 2) * cos(theta));
-            // std::string bottom_left = std::to_string(BL_x) + " " + std::to_string(BL_y);
-            // // BOTTOM RIGHT VERTEX:
-            // const double BR_x = otherAgent_cx + ((otherAgent_width / 2) * cos(theta)) + ((otherAgent_height / 2) * sin(theta));
-            // const double BR_y = otherAgent_cy + ((otherAgent_width / 2) * sin(theta)) - ((otherAgent_height / 2) * cos(theta));
-            // std::string bottom_right = std::to_string(BR_x) + " " + std::to_string(BR_y);
-            // // convert to string for easy initializataion
-            // std::string points = "POLYGON((" + bottom_left + "," + bottom_right + "," + top_right + "," + top_left + "," + bottom_left + "))";
-            // polygon other_agent;
-            // boost::geometry::read_wkt(points,other_agent);
+    return shape.transformed(xyState->values[0], xyState->values[1], theta);
+}
 
-            Polygon raw;
-            Polygon other_agent;
-            Polygon initial = otherAgent->getShape();
-            bg::correct(raw);
-            bg::assign(raw, initial);
-            bg::strategy::transform::matrix_transformer<double, 2, 2> xfrm(
-                     cos(otherAgent_theta), sin(otherAgent_theta), otherAgent_cx,
-                    -sin(otherAgent_theta), cos(otherAgent_theta), otherAgent_cy,
-                              0,          0,  1);
-            bg::transform(raw, other_agent, xfrm);
+bool ompl::control::PrioritizedRRT::isStateFree_(const base::State *st, const unsigned int step) const
+{
+    return reservations_.empty() || reservations_.isFree(step, footprintAt_(st, footprint_));
+}
 
-            // check if planning_agent is disjoint from other_agent
-            if (! boost::geometry::disjoint(planning_agent, other_agent))
-                return false;
-        }
-    }
-    return true;
+bool ompl::control::PrioritizedRRT::isCollisionFree(const Motion *parent, const Control *ctrl, const unsigned int steps) const
+{
+    if (reservations_.empty())
+        return true;
+    /* only the new states of the edge are checked, the branch up to parent already is */
+    std::vector<base::State *> edge;
+    siC_->propagate(parent->state, ctrl, steps, edge, true);
+    bool free = true;
+    for (std::size_t k = 0; k < edge.size() && free; k++)
+        free = isStateFree_(edge[k], parent->timeStep + k + 1);
+    for (auto &st: edge)
+        si_->freeState(st);
+    return free;
 }
  
 ompl::base::PlannerStatus ompl::control::PrioritizedRRT::solve(const base::PlannerTerminationCondition &ptc)
@@ -297,6 +153,8 @@ ompl::base::PlannerStatus ompl::control::PrioritizedRRT::solve(const base::Plann
         OMPL_ERROR("No Robot Specified!");
         return base::PlannerStatus::INVALID_START;
     }
+    RobotFootprint::fromRobot(*robot_, footprint_);
+    reserveExistingSolutions_();
     // begin normal planning
     checkValidity();
     base::Goal *goal = pdef_->getGoal().get();
@@ -359,6 +217,9 @@ ompl::base::PlannerStatus ompl::control::PrioritizedRRT::solve(const base::Plann
                 size_t p = 0;
                 for (; p < pstates.size(); ++p)
                 {
+                    /* only the new state is checked, at its step from the start */
+                    if (!isStateFree_(pstates[p], lastmotion->timeStep + 1))
+                        break;
                     /* create a motion */
                     auto *motion = new Motion();
                     motion->state = pstates[p];
@@ -366,6 +227,7 @@ ompl::base::PlannerStatus ompl::control::PrioritizedRRT::solve(const base::Plann
                     motion->control = siC_->allocControl();
                     siC_->copyControl(motion->control, rctrl);
                     motion->steps = 1;
+                    motion->timeStep = lastmotion->timeStep + 1;
                     motion->parent = lastmotion;
                     lastmotion = motion;
                     nn_->add(motion);
@@ -384,7 +246,9 @@ ompl::base::PlannerStatus ompl::control::PrioritizedRRT::solve(const base::Plann
                     }
                 }
  
-                // free any states after we hit the goal
+                // free any states after we hit the goal (or after the first that collides)
+                if (p < pstates.size() && !solved)
+                    si_->freeState(pstates[p]);
                 while (++p < pstates.size())
                     si_->freeState(pstates[p]);
                 if (solved)
@@ -403,9 +267,10 @@ ompl::base::PlannerStatus ompl::control::PrioritizedRRT::solve(const base::Plann
                 si_->copyState(motion->state, rmotion->state);
                 siC_->copyControl(motion->control, rctrl);
                 motion->steps = cd;
+                motion->timeStep = nmotion->timeStep + cd;
                 motion->parent = nmotion;
 
-                if (isCollisionFree(motion))
+                if (isCollisionFree(nmotion, motion->control, cd))
                 {
                     nn_->add(motion);
                     double dist = 0.0;
@@ -424,6 +289,8 @@ ompl::base::PlannerStatus ompl::control::PrioritizedRRT::solve(const base::Plann
                 }
                 else
                 {
+                    si_->freeState(motion->state);
+                    siC_->freeControl(motion->control);
                     delete motion;
                 }
             }
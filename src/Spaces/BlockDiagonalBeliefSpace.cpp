@@ -0,0 +1,37 @@
+#include "Spaces/BlockDiagonalBeliefSpace.h"
+
+
+ompl::base::State* BlockDiagonalBeliefSpace::allocState(void) const
+{
+    StateType *rstate = recycledState_();
+    if (!rstate) {
+        // the mean and both sets of blocks share a single buffer, freed by RealVectorBeliefSpace
+        rstate = new StateType();
+        double *storage = new double[dimension_ + 4 * dimension_];
+        rstate->setStorage(storage, storage + dimension_, storage + 3 * dimension_, 2, dimension_);
+    }
+    for (unsigned int a = 0; a < num_agents_; a++) {
+        rstate->sigmaBlock(a) = 0.01 * Eigen::Matrix2d::Identity();
+        rstate->lambdaBlock(a) = 0.01 * Eigen::Matrix2d::Identity();
+    }
+    rstate->setCost(std::numeric_limits<double>::max());
+    alloc::onAlloc(alloc::BELIEF_STATES, stateBytes_());
+    return rstate;
+}
+
+double BlockDiagonalBeliefSpace::distance(const State* state1, const State *state2) const
+{
+    const double mu_diff = meanDistance(state1, state2);
+    if (mu_diff == 0)
+        return 0.0;
+
+    const auto *b1 = state1->as<StateType>();
+    const auto *b2 = state2->as<StateType>();
+    double t = mu_diff;
+    for (unsigned int a = 0; a < num_agents_; a++) {
+        const Eigen::Matrix2d cov1 = b1->sigmaBlock(a) + b1->lambdaBlock(a);
+        const Eigen::Matrix2d cov2 = b2->sigmaBlock(a) + b2->lambdaBlock(a);
+        t += cov1.trace() + cov2.trace() - 2 * traceSqrt2x2(cov1, cov2);
+    }
+    return std::abs(t);
+}
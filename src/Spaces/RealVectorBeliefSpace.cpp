@@ -4,12 +4,38 @@
 // double RealVectorBeliefSpace::StateType::covNormWeight_   = -1;
 // double RealVectorBeliefSpace::StateType::reachDist_   = -1;
 
+RealVectorBeliefSpace::~RealVectorBeliefSpace(void)
+{
+    // values points to the start of the buffer of the belief
+    for (StateType *st: free_states_) {
+        delete[] st->values;
+        delete st;
+    }
+}
+
+RealVectorBeliefSpace::StateType *RealVectorBeliefSpace::recycledState_() const
+{
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    if (free_states_.empty())
+        return nullptr;
+    StateType *st = free_states_.back();
+    free_states_.pop_back();
+    return st;
+}
+
 ompl::base::State* RealVectorBeliefSpace::allocState(void) const
 {
-    StateType *rstate = new StateType();
-    rstate->values = new double[dimension_];
+    StateType *rstate = recycledState_();
+    if (!rstate) {
+        // the mean and both covariances share a single buffer
+        rstate = new StateType();
+        double *storage = new double[dimension_ + 2 * dimension_ * dimension_];
+        rstate->setStorage(storage, storage + dimension_, storage + dimension_ + dimension_ * dimension_, dimension_);
+    }
     rstate->sigma_  = 0.01 * Eigen::MatrixXd::Identity(dimension_, dimension_);
     rstate->lambda_ = 0.01 * Eigen::MatrixXd::Identity(dimension_, dimension_);
+    rstate->setCost(std::numeric_limits<double>::max());
+    alloc::onAlloc(alloc::BELIEF_STATES, stateBytes_());
     return rstate;
 }
 
@@ -31,6 +57,10 @@ double RealVectorBeliefSpace::distance(const State* state1, const State *state2)
     Eigen::MatrixXd cov1 = state1->as<StateType>()->getCovariance();
     Eigen::MatrixXd cov2 = state2->as<StateType>()->getCovariance();
 
+    // planar beliefs need no decomposition at all
+    if (dimension_ == 2)
+        return abs(mu_diff.squaredNorm() + cov1.trace() + cov2.trace() - 2 * traceSqrt2x2(cov1, cov2));
+
     Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es1(cov1);
     auto cov1_sqrt = es1.operatorSqrt();
     Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es2(cov2);
@@ -61,6 +91,16 @@ double RealVectorBeliefSpace::distance(const State* state1, const State *state2)
     return abs(t);
 }
 
+double RealVectorBeliefSpace::meanDistance(const State* state1, const State *state2) const
+{
+    const double *mu1 = state1->as<StateType>()->values;
+    const double *mu2 = state2->as<StateType>()->values;
+    double d = 0;
+    for (unsigned int i = 0; i < dimension_; i++)
+        d += (mu1[i] - mu2[i]) * (mu1[i] - mu2[i]);
+    return d;
+}
+
 void RealVectorBeliefSpace::copyState(State *destination, const State *source) const
 {
     RealVectorStateSpace::copyState(destination, source);
@@ -70,9 +110,9 @@ void RealVectorBeliefSpace::copyState(State *destination, const State *source) c
 
 void RealVectorBeliefSpace::freeState(State *state) const
 {
-    state->as<StateType>()->sigma_.resize(0, 0);
-    state->as<StateType>()->lambda_.resize(0, 0);
-    RealVectorStateSpace::freeState(state);
+    alloc::onFree(alloc::BELIEF_STATES, stateBytes_());
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    free_states_.push_back(state->as<StateType>());
 }
 
 void RealVectorBeliefSpace::printState(const State *state, std::ostream &out) const
@@ -1,4 +1,7 @@
 #include "StatePropogators/CarSP.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
 
 void FirstOrderCarODE (const oc::ODESolver::StateType& q, 
     const oc::Control* control, oc::ODESolver::StateType& qdot)
@@ -57,3 +60,76 @@ void SecondOrderCarODEPostIntegration (const ob::State* /*state*/, const oc::Con
     ob::SO2StateSpace SO2;
     SO2.enforceBounds(angleState1);
 }
+
+FirstOrderCarStatePropagator::FirstOrderCarStatePropagator(const oc::SpaceInformationPtr &si, const double car_length):
+    oc::StatePropagator(si), car_length_(car_length)
+{
+}
+
+void FirstOrderCarStatePropagator::propagate(const ob::State *state, const oc::Control *control, const double duration, 
+    ob::State *result) const
+{
+    const auto *start = state->as<ob::SE2StateSpace::StateType>();
+    const double *u = control->as<oc::RealVectorControlSpace::ControlType>()->values;
+    const double theta = start->getYaw();
+    const double omega = u[0] * std::tan(u[1]) / car_length_;
+    const double dtheta = omega * duration;
+    double x = start->getX(), y = start->getY();
+    // below this turn, the arc is evaluated as a line (the error is of the order of dtheta^2)
+    if (std::abs(dtheta) < 1e-9) {
+        x += u[0] * duration * std::cos(theta);
+        y += u[0] * duration * std::sin(theta);
+    }
+    else {
+        const double r = u[0] / omega;
+        x += r * (std::sin(theta + dtheta) - std::sin(theta));
+        y += r * (std::cos(theta) - std::cos(theta + dtheta));
+    }
+    auto *end = result->as<ob::SE2StateSpace::StateType>();
+    end->setXY(x, y);
+    end->setYaw(theta + dtheta);
+    ob::SO2StateSpace SO2;
+    SO2.enforceBounds(end->as<ob::SO2StateSpace::StateType>(1));
+}
+
+SecondOrderCarStatePropagator::SecondOrderCarStatePropagator(const oc::SpaceInformationPtr &si, const double car_length, 
+    const double int_step): oc::StatePropagator(si), car_length_(car_length), int_step_(int_step)
+{
+}
+
+void SecondOrderCarStatePropagator::propagate(const ob::State *state, const oc::Control *control, const double duration, 
+    ob::State *result) const
+{
+    typedef std::array<double, 5> Q;  // x, y, v, phi, theta
+    const double *u = control->as<oc::RealVectorControlSpace::ControlType>()->values;
+    auto qdot = [this, u](const Q &q) -> Q {
+        return {q[2] * std::cos(q[4]), q[2] * std::sin(q[4]), u[0], u[1], (q[2] / car_length_) * std::tan(q[3])};
+    };
+    auto axpy = [](const Q &q, const double h, const Q &d) -> Q {
+        return {q[0] + h * d[0], q[1] + h * d[1], q[2] + h * d[2], q[3] + h * d[3], q[4] + h * d[4]};
+    };
+
+    const auto *cs = state->as<ob::CompoundState>();
+    const double *rv = cs->as<ob::RealVectorStateSpace::StateType>(0)->values;
+    Q q = {rv[0], rv[1], rv[2], rv[3], cs->as<ob::SO2StateSpace::StateType>(1)->value};
+    // equal steps of at most int_step_ (the step of the ODE solver)
+    const int n = std::max(1, static_cast<int>(std::ceil(duration / int_step_ - 1e-9)));
+    const double h = duration / n;
+    for (int s = 0; s < n; s++) {
+        const Q k1 = qdot(q);
+        const Q k2 = qdot(axpy(q, h / 2, k1));
+        const Q k3 = qdot(axpy(q, h / 2, k2));
+        const Q k4 = qdot(axpy(q, h, k3));
+        for (int i = 0; i < 5; i++)
+            q[i] += h / 6 * (k1[i] + 2 * k2[i] + 2 * k3[i] + k4[i]);
+    }
+
+    auto *end = result->as<ob::CompoundState>();
+    double *out = end->as<ob::RealVectorStateSpace::StateType>(0)->values;
+    for (int i = 0; i < 4; i++)
+        out[i] = q[i];
+    auto *angle = end->as<ob::SO2StateSpace::StateType>(1);
+    angle->value = q[4];
+    ob::SO2StateSpace SO2;
+    SO2.enforceBounds(angle);
+}
@@ -1,4 +1,5 @@
 #include "StatePropogators/CentralizedUncertainLinearSP.h"
+#include <algorithm>
 
 
 CentralizedUncertainLinearStatePropagator::CentralizedUncertainLinearStatePropagator(const oc::SpaceInformationPtr &si) : 
@@ -41,64 +42,115 @@ CentralizedUncertainLinearStatePropagator::CentralizedUncertainLinearStatePropag
 
 void CentralizedUncertainLinearStatePropagator::propagate(const ob::State *state, const oc::Control* control, const double duration, ob::State *result) const
 {
-    const double* all_st_values = state->as<RealVectorBeliefSpace::StateType>()->values;
-    const double* all_cntrl_values = control->as<oc::RealVectorControlSpace::ControlType>()->values;
-    const Eigen::MatrixXd all_sigmas = state->as<RealVectorBeliefSpace::StateType>()->sigma_;
-    const Eigen::MatrixXd all_lambdas = state->as<RealVectorBeliefSpace::StateType>()->lambda_;
+    propagateBatch(&state, &control, 1, duration, &result);
+}
 
-    for (int a = 0; a < num_agents_; a++) {
-        // extract agent-specific state information
-        Eigen::Vector2d mu_a{all_st_values[2 * a], all_st_values[2 * a + 1]};
-        Eigen::Vector2d cntrl_a{all_cntrl_values[2 * a], all_cntrl_values[2 * a + 1]};
-        Eigen::Matrix2d sigma_a = all_sigmas.block<2, 2>(2 * a, 2 * a);
-        Eigen::Matrix2d lambda_a = all_lambdas.block<2, 2>(2 * a, 2 * a);
-
-        // propogate the individual agent
-        Eigen::Vector2d nxt_mu_a = Eigen::Vector2d::Zero();
-        Eigen::Matrix2d nxt_sigma_a = Eigen::Matrix2d::Zero();
-        Eigen::Matrix2d nxt_lambda_a = Eigen::Matrix2d::Zero();
-        singleAgentPropogate_(mu_a, sigma_a, lambda_a, cntrl_a, nxt_mu_a, nxt_sigma_a, nxt_lambda_a);
-
-        // update the resulting states
-        result->as<RealVectorBeliefSpace::StateType>()->values[2 * a] = nxt_mu_a[0];
-        result->as<RealVectorBeliefSpace::StateType>()->values[2 * a + 1] = nxt_mu_a[1];
-        result->as<RealVectorBeliefSpace::StateType>()->sigma_.block<2, 2>(2 * a, 2 * a) = nxt_sigma_a;
-        result->as<RealVectorBeliefSpace::StateType>()->lambda_.block<2, 2>(2 * a, 2 * a) = nxt_lambda_a;
+void CentralizedUncertainLinearStatePropagator::propagateBatch(const ob::State *const *states, const oc::Control *const *controls, 
+    const std::size_t n, const double duration, ob::State *const *results) const
+{
+    // candidates usually share their input covariances, so the memo carries over from one to the next
+    CovarianceMemo memo;
+    const int dim = 2 * num_agents_;
+    for (std::size_t i = 0; i < n; i++) {
+        const auto *st = states[i]->as<RealVectorBeliefSpace::StateType>();
+        auto *res = results[i]->as<RealVectorBeliefSpace::StateType>();
+        // the means of every agent side by side (result may be state)
+        const double *cntrl = controls[i]->as<oc::RealVectorControlSpace::ControlType>()->values;
+        for (int j = 0; j < dim; j++)
+            res->values[j] = st->values[j] + duration_ * cntrl[j];
+        propagateCovariances_(st, nullptr, memo, res);
     }
-    return;
 }
 
-void CentralizedUncertainLinearStatePropagator::singleAgentPropogate_(Eigen::Vector2d& mu, Eigen::Matrix2d& sigma, Eigen::Matrix2d& lambda, Eigen::Vector2d& cntrl, Eigen::Vector2d& nxt_mu, Eigen::Matrix2d& nxt_sigma, Eigen::Matrix2d& nxt_lambda) const
+void CentralizedUncertainLinearStatePropagator::propagateAgents(const ob::State *state, const oc::Control *control, 
+    const double duration, const std::vector<bool> &active, ob::State *result) const
 {
-    //=========================================================================
-    // Get CX vector (RRT near vertex)
-    //=========================================================================
-    const double x_pose = mu[0];
-    const double y_pose = mu[1];
-    //=========================================================================
-    // Get CX vector (RRT random vertex)
-    //=========================================================================
-    const double x_pose_reference = cntrl[0];
-    const double y_pose_reference = cntrl[1];
-    //=========================================================================
-    // Compute control inputs (dot(dot(x)) dot(dot(y)) dot(dot(z))) with PD controller
-    //=========================================================================
-    // const double u_0 = B_ol_(0, 0) * (x_pose_reference - x_pose); //double u_0 = B_cl_d_(0, 0) * (x_pose_reference - x_pose);
-    // const double u_1 = B_ol_(0, 0) * (y_pose_reference - y_pose); //double u_1 = B_cl_d_(1, 1) * (y_pose_reference - y_pose);
+    const auto *st = state->as<RealVectorBeliefSpace::StateType>();
+    auto *res = result->as<RealVectorBeliefSpace::StateType>();
+    const double *cntrl = control->as<oc::RealVectorControlSpace::ControlType>()->values;
+    for (int a = 0; a < num_agents_; a++) {
+        if (!active[a])
+            continue;
+        // (result may be state)
+        res->values[2 * a] = st->values[2 * a] + duration_ * cntrl[2 * a];
+        res->values[2 * a + 1] = st->values[2 * a + 1] + duration_ * cntrl[2 * a + 1];
+    }
+    CovarianceMemo memo;
+    propagateCovariances_(st, &active, memo, res);
+}
 
-    nxt_mu[0] = x_pose + duration_ * x_pose_reference;
-    nxt_mu[1] = y_pose + duration_ * y_pose_reference;
+void CentralizedUncertainLinearStatePropagator::propagateCovariances_(const RealVectorBeliefSpace::StateType *st, 
+    const std::vector<bool> *active, CovarianceMemo &memo, RealVectorBeliefSpace::StateType *res) const
+{
+    auto update = [&](const double *sigma, const double *lambda, double *nxt_sigma, double *nxt_lambda) {
+        if (!memo.valid_ || !std::equal(sigma, sigma + 4, memo.in_) || !std::equal(lambda, lambda + 4, memo.in_ + 4)) {
+            Eigen::Matrix2d nxt_sigma_a, nxt_lambda_a;
+            propagateCovariance_(Eigen::Map<const Eigen::Matrix2d>(sigma), Eigen::Map<const Eigen::Matrix2d>(lambda), 
+                nxt_sigma_a, nxt_lambda_a);
+            std::copy(sigma, sigma + 4, memo.in_);
+            std::copy(lambda, lambda + 4, memo.in_ + 4);
+            Eigen::Map<Eigen::Matrix2d>(memo.out_) = nxt_sigma_a;
+            Eigen::Map<Eigen::Matrix2d>(memo.out_ + 4) = nxt_lambda_a;
+            memo.valid_ = true;
+        }
+        std::copy(memo.out_, memo.out_ + 4, nxt_sigma);
+        std::copy(memo.out_ + 4, memo.out_ + 8, nxt_lambda);
+    };
+
+    const int n = num_agents_;
+    if (st->sigma_.rows() != 2 || res->sigma_.rows() != 2) {
+        // dense covariances: the blocks are copied out and back
+        for (int a = 0; a < n; a++) {
+            if (active && !(*active)[a])
+                continue;
+            Eigen::Matrix2d sigma_a = st->sigmaBlock(a), lambda_a = st->lambdaBlock(a), nxt_sigma_a, nxt_lambda_a;
+            update(sigma_a.data(), lambda_a.data(), nxt_sigma_a.data(), nxt_lambda_a.data());
+            res->sigmaBlock(a) = nxt_sigma_a;
+            res->lambdaBlock(a) = nxt_lambda_a;
+        }
+        return;
+    }
 
-    //=========================================================================
-    // Propagate covariance in the equivalent closed loop system
-    //=========================================================================
-    const Eigen::Matrix2d sigma_pred = F_ * sigma * F_ + Q_;
+    // block diagonal: the (column-major) block of agent a is the four doubles from 4 a. The agents of a group
+    // whose blocks all match the memo (typically every agent, at the same depth of the tree) are updated in one
+    // vectorized pass, the others one at a time
+    const double *sigma = st->sigma_.data(), *lambda = st->lambda_.data();
+    double *nxt_sigma = res->sigma_.data(), *nxt_lambda = res->lambda_.data();
+    for (int first = 0; first < n; first += lanes_) {
+        const int m = std::min<int>(lanes_, n - first);
+        if (!active && memo.valid_) {
+            bool same = true;
+            for (int k = 4 * first; k < 4 * (first + m); k++)
+                same &= (sigma[k] == memo.in_[k & 3]) & (lambda[k] == memo.in_[4 + (k & 3)]);
+            if (same) {
+                for (int k = 4 * first; k < 4 * (first + m); k++) {
+                    nxt_sigma[k] = memo.out_[k & 3];
+                    nxt_lambda[k] = memo.out_[4 + (k & 3)];
+                }
+                continue;
+            }
+        }
+        for (int a = first; a < first + m; a++) {
+            if (active && !(*active)[a])
+                continue;
+            update(sigma + 4 * a, lambda + 4 * a, nxt_sigma + 4 * a, nxt_lambda + 4 * a);
+        }
+    }
+}
 
-    const Eigen::Matrix2d S = (H_ * sigma_pred * H_.transpose()) + R_;
-    const Eigen::Matrix2d K = (sigma_pred * H_.transpose()) * S.inverse();
-    const Eigen::Matrix2d lambda_pred = A_cl_ * lambda * A_cl_;
-    nxt_sigma = (I_ - (K * H_)) * sigma_pred;
-    nxt_lambda = lambda_pred + K * H_ * sigma_pred;
+void CentralizedUncertainLinearStatePropagator::propagateCovariance_(const Eigen::Matrix2d &sigma, const Eigen::Matrix2d &lambda, 
+    Eigen::Matrix2d &nxt_sigma, Eigen::Matrix2d &nxt_lambda) const
+{
+    covariance_cache_.propagate(sigma, lambda, nxt_sigma, nxt_lambda, 
+        [this](const Eigen::Matrix2d &sigma, const Eigen::Matrix2d &lambda, Eigen::Matrix2d &nxt_sigma, Eigen::Matrix2d &nxt_lambda) {
+            const Eigen::Matrix2d sigma_pred = F_ * sigma * F_ + Q_;
+
+            const Eigen::Matrix2d S = (H_ * sigma_pred * H_.transpose()) + R_;
+            const Eigen::Matrix2d K = (sigma_pred * H_.transpose()) * S.inverse();
+            const Eigen::Matrix2d lambda_pred = A_cl_ * lambda * A_cl_;
+            nxt_sigma = (I_ - (K * H_)) * sigma_pred;
+            nxt_lambda = lambda_pred + K * H_ * sigma_pred;
+        });
 }
 
 bool CentralizedUncertainLinearStatePropagator::canPropagateBackward(void) const
@@ -1,4 +1,7 @@
 #include "StatePropogators/MultiCarSP.h"
+#include "utils/FastMath.h"
+#include <algorithm>
+#include <cmath>
 
 void TwoSecondOrderCarsODE (const oc::ODESolver::StateType& q, 
     const oc::Control* control, oc::ODESolver::StateType& qdot)
@@ -116,3 +119,107 @@ void ThreeSecondOrderCarsPostIntegration (const ob::State* /*state*/, const oc::
     SO2.enforceBounds(angleState2);
     SO2.enforceBounds(angleState3);
 }
+
+MultiSecondOrderCarStatePropagator::MultiSecondOrderCarStatePropagator(const oc::SpaceInformationPtr &si, 
+    const double car_length, const double int_step): oc::StatePropagator(si), 
+    num_cars_(si->getStateSpace()->as<ob::CompoundStateSpace>()->getSubspaceCount() / 2), car_length_(car_length), 
+    int_step_(int_step)
+{
+}
+
+void MultiSecondOrderCarStatePropagator::propagate(const ob::State *state, const oc::Control *control, 
+    const double duration, ob::State *result) const
+{
+    propagateAgents(state, control, duration, std::vector<bool>(num_cars_, true), result);
+}
+
+void MultiSecondOrderCarStatePropagator::propagateAgents(const ob::State *state, const oc::Control *control, 
+    const double duration, const std::vector<bool> &active, ob::State *result) const
+{
+    const double *u = control->as<oc::RealVectorControlSpace::ControlType>()->values;
+    std::size_t cars[lanes_];
+    std::size_t m = 0;
+    for (std::size_t c = 0; c < num_cars_; c++) {
+        if (!active[c])
+            continue;
+        cars[m++] = c;
+        if (m == lanes_) {
+            propagateBlock_(state, u, duration, cars, m, result);
+            m = 0;
+        }
+    }
+    if (m > 0)
+        propagateBlock_(state, u, duration, cars, m, result);
+}
+
+void MultiSecondOrderCarStatePropagator::propagateBlock_(const ob::State *state, const double *u, const double duration, 
+    const std::size_t *cars, const std::size_t m, ob::State *result) const
+{
+    // q[i][l] is element i (x, y, v, phi, theta) of the car in lane l. The unused lanes stay at rest, so every
+    // loop runs over all the lanes and vectorizes
+    typedef double Block[5][lanes_];
+    Block q = {}, acc, tmp, k;
+    double accel[lanes_] = {}, steer[lanes_] = {};
+    const auto *cs = state->as<ob::CompoundState>();
+    for (std::size_t l = 0; l < m; l++) {
+        const double *rv = cs->as<ob::RealVectorStateSpace::StateType>(2 * cars[l])->values;
+        for (int i = 0; i < 4; i++)
+            q[i][l] = rv[i];
+        q[4][l] = cs->as<ob::SO2StateSpace::StateType>(2 * cars[l] + 1)->value;
+        accel[l] = u[2 * cars[l]];
+        steer[l] = u[2 * cars[l] + 1];
+    }
+
+    const double inv_length = 1 / car_length_;
+    auto qdot = [&](const Block &in, Block &out) {
+        for (std::size_t l = 0; l < lanes_; l++) {
+            double s_theta, c_theta, s_phi, c_phi;
+            fastmath::sincos(in[4][l], s_theta, c_theta);
+            fastmath::sincos(in[3][l], s_phi, c_phi);
+            out[0][l] = in[2][l] * c_theta;
+            out[1][l] = in[2][l] * s_theta;
+            out[2][l] = accel[l];
+            out[3][l] = steer[l];
+            out[4][l] = in[2][l] * inv_length * s_phi / c_phi;
+        }
+    };
+    // acc += w * k and tmp = q + h * k
+    auto stage = [&](const double w, const double h) {
+        for (int i = 0; i < 5; i++) {
+            for (std::size_t l = 0; l < lanes_; l++) {
+                acc[i][l] += w * k[i][l];
+                tmp[i][l] = q[i][l] + h * k[i][l];
+            }
+        }
+    };
+
+    // equal steps of at most int_step_, as SecondOrderCarStatePropagator
+    const int n = std::max(1, static_cast<int>(std::ceil(duration / int_step_ - 1e-9)));
+    const double h = duration / n;
+    for (int s = 0; s < n; s++) {
+        std::copy(&q[0][0], &q[0][0] + 5 * lanes_, &acc[0][0]);
+        qdot(q, k);
+        stage(h / 6, h / 2);
+        qdot(tmp, k);
+        stage(h / 3, h / 2);
+        qdot(tmp, k);
+        stage(h / 3, h);
+        qdot(tmp, k);
+        for (int i = 0; i < 5; i++) {
+            for (std::size_t l = 0; l < lanes_; l++)
+                q[i][l] = acc[i][l] + h / 6 * k[i][l];
+        }
+    }
+
+    // (result may be state, whose cars of this block were all read above)
+    auto *end = result->as<ob::CompoundState>();
+    ob::SO2StateSpace SO2;
+    for (std::size_t l = 0; l < m; l++) {
+        double *out = end->as<ob::RealVectorStateSpace::StateType>(2 * cars[l])->values;
+        for (int i = 0; i < 4; i++)
+            out[i] = q[i][l];
+        auto *angle = end->as<ob::SO2StateSpace::StateType>(2 * cars[l] + 1);
+        angle->value = q[4][l];
+        SO2.enforceBounds(angle);
+    }
+}
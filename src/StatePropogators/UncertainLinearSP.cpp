@@ -1,4 +1,5 @@
 #include "StatePropogators/UncertainLinearSP.h"
+#include <algorithm>
 
 
 R2_UncertainLinearStatePropagator::R2_UncertainLinearStatePropagator(const oc::SpaceInformationPtr &si) : oc::StatePropagator(si),
@@ -57,57 +58,75 @@ R2_UncertainLinearStatePropagator::R2_UncertainLinearStatePropagator(const oc::S
 
 void R2_UncertainLinearStatePropagator::propagate(const ob::State *state, const oc::Control* control, const double duration, ob::State *result) const
 {
-    const double* all_st_values = state->as<RealVectorBeliefSpace::StateType>()->values;
-    const double* all_cntrl_values = control->as<oc::RealVectorControlSpace::ControlType>()->values;
-    const Eigen::MatrixXd all_sigmas = state->as<RealVectorBeliefSpace::StateType>()->sigma_;
-    const Eigen::MatrixXd all_lambdas = state->as<RealVectorBeliefSpace::StateType>()->lambda_;
-
-    // propogate the individual agent
-    Eigen::Vector2d nxt_mu_a = Eigen::Vector2d::Zero();
-    Eigen::Matrix2d nxt_sigma_a = Eigen::Matrix2d::Zero();
-    Eigen::Matrix2d nxt_lambda_a = Eigen::Matrix2d::Zero();
-
-    // extract agent-specific state information
-    Eigen::Vector2d mu_a{all_st_values[0], all_st_values[1]};
-    Eigen::Vector2d cntrl_a{all_cntrl_values[0], all_cntrl_values[1]};
-    Eigen::Matrix2d sigma_a = all_sigmas.block<2, 2>(0, 0);
-    Eigen::Matrix2d lambda_a = all_lambdas.block<2, 2>(0, 0);
-
-    //=========================================================================
-    // Get CX vector (RRT near vertex)
-    //=========================================================================
-    const double x_pose = mu_a[0];
-    const double y_pose = mu_a[1];
-    //=========================================================================
-    // Get CX vector (RRT random vertex)
-    //=========================================================================
-    const double x_pose_reference = cntrl_a[0];
-    const double y_pose_reference = cntrl_a[1];
-    //=========================================================================
-    // Compute control inputs (dot(dot(x)) dot(dot(y)) dot(dot(z))) with PD controller
-    //=========================================================================
-    // const double u_0 = B_ol_(0, 0) * (x_pose_reference - x_pose); //double u_0 = B_cl_d_(0, 0) * (x_pose_reference - x_pose);
-    // const double u_1 = B_ol_(0, 0) * (y_pose_reference - y_pose); //double u_1 = B_cl_d_(1, 1) * (y_pose_reference - y_pose);
+    propagateBatch(&state, &control, 1, duration, &result);
+}
 
-    nxt_mu_a[0] = x_pose + duration_ * x_pose_reference;
-    nxt_mu_a[1] = y_pose + duration_ * y_pose_reference;
+void R2_UncertainLinearStatePropagator::propagateBatch(const ob::State *const *states, const oc::Control *const *controls, 
+    const std::size_t n, const double duration, ob::State *const *results) const
+{
+    for (std::size_t first = 0; first < n; first += lanes_) {
+        const std::size_t m = std::min(lanes_, n - first);
+        //=========================================================================
+        // Get CX vector (RRT near vertex) and CX vector (RRT random vertex)
+        //=========================================================================
+        double x_pose[lanes_], y_pose[lanes_], x_pose_reference[lanes_], y_pose_reference[lanes_];
+        for (std::size_t i = 0; i < m; i++) {
+            const double *st = states[first + i]->as<RealVectorBeliefSpace::StateType>()->values;
+            const double *cntrl = controls[first + i]->as<oc::RealVectorControlSpace::ControlType>()->values;
+            x_pose[i] = st[0];
+            y_pose[i] = st[1];
+            x_pose_reference[i] = cntrl[0];
+            y_pose_reference[i] = cntrl[1];
+        }
+        //=========================================================================
+        // Compute control inputs (dot(dot(x)) dot(dot(y)) dot(dot(z))) with PD controller
+        //=========================================================================
+        // const double u_0 = B_ol_(0, 0) * (x_pose_reference - x_pose); //double u_0 = B_cl_d_(0, 0) * (x_pose_reference - x_pose);
+        // const double u_1 = B_ol_(0, 0) * (y_pose_reference - y_pose); //double u_1 = B_cl_d_(1, 1) * (y_pose_reference - y_pose);
+        double nxt_x[lanes_], nxt_y[lanes_];
+        for (std::size_t i = 0; i < m; i++) {
+            nxt_x[i] = x_pose[i] + duration_ * x_pose_reference[i];
+            nxt_y[i] = y_pose[i] + duration_ * y_pose_reference[i];
+        }
+        for (std::size_t i = 0; i < m; i++) {
+            double *nxt = results[first + i]->as<RealVectorBeliefSpace::StateType>()->values;
+            nxt[0] = nxt_x[i];
+            nxt[1] = nxt_y[i];
+        }
+    }
 
     //=========================================================================
     // Propagate covariance in the equivalent closed loop system
     //=========================================================================
-    const Eigen::Matrix2d sigma_pred = F_ * sigma_a * F_ + Q_;
+    Eigen::Matrix2d sigma_a, lambda_a, nxt_sigma_a, nxt_lambda_a;
+    for (std::size_t i = 0; i < n; i++) {
+        const auto *st = states[i]->as<RealVectorBeliefSpace::StateType>();
+        auto *res = results[i]->as<RealVectorBeliefSpace::StateType>();
+        // candidates from the same parent share their covariances, so their update is reused
+        const Eigen::Map<const Eigen::Matrix2d> sigma_in(st->sigma_.data()), lambda_in(st->lambda_.data());
+        if (i == 0 || sigma_in != sigma_a || lambda_in != lambda_a) {
+            sigma_a = sigma_in;
+            lambda_a = lambda_in;
+            covariance_cache_.propagate(sigma_a, lambda_a, nxt_sigma_a, nxt_lambda_a, 
+                [this](const Eigen::Matrix2d &sigma, const Eigen::Matrix2d &lambda, Eigen::Matrix2d &nxt_sigma, Eigen::Matrix2d &nxt_lambda) {
+                    propagateCovariance_(sigma, lambda, nxt_sigma, nxt_lambda);
+                });
+        }
+        Eigen::Map<Eigen::Matrix2d>(res->sigma_.data()) = nxt_sigma_a;
+        Eigen::Map<Eigen::Matrix2d>(res->lambda_.data()) = nxt_lambda_a;
+    }
+}
+
+void R2_UncertainLinearStatePropagator::propagateCovariance_(const Eigen::Matrix2d &sigma, const Eigen::Matrix2d &lambda, 
+    Eigen::Matrix2d &nxt_sigma, Eigen::Matrix2d &nxt_lambda) const
+{
+    const Eigen::Matrix2d sigma_pred = F_ * sigma * F_ + Q_;
 
     const Eigen::Matrix2d S = (H_ * sigma_pred * H_.transpose()) + R_;
     const Eigen::Matrix2d K = (sigma_pred * H_.transpose()) * S.inverse();
-    const Eigen::Matrix2d lambda_pred = A_cl_ * lambda_a * A_cl_;
-    nxt_sigma_a = (I_ - (K * H_)) * sigma_pred;
-    nxt_lambda_a = lambda_pred + K * H_ * sigma_pred;
-
-    // update the resulting states
-    result->as<RealVectorBeliefSpace::StateType>()->values[0] = nxt_mu_a[0];
-    result->as<RealVectorBeliefSpace::StateType>()->values[1] = nxt_mu_a[1];
-    result->as<RealVectorBeliefSpace::StateType>()->sigma_.block<2, 2>(0, 0) = nxt_sigma_a;
-    result->as<RealVectorBeliefSpace::StateType>()->lambda_.block<2, 2>(0, 0) = nxt_lambda_a;
+    const Eigen::Matrix2d lambda_pred = A_cl_ * lambda * A_cl_;
+    nxt_sigma = (I_ - (K * H_)) * sigma_pred;
+    nxt_lambda = lambda_pred + K * H_ * sigma_pred;
 }
 
 bool R2_UncertainLinearStatePropagator::canPropagateBackward(void) const
@@ -3,6 +3,7 @@
 #include "StatePropogators/UncertainUnicycleSP.h"
 #include "ompl/control/spaces/RealVectorControlSpace.h"
 #include "ompl/util/Exception.h"
+#include <algorithm>
 using namespace ompl;
 
 
@@ -144,86 +145,103 @@ double wrap(double angle)
 }
 
 void DynUnicycleControlSpace::propagate(const ob::State *start, const oc::Control* control, const double duration, ob::State *result) const {
-    //=========================================================================
-    // Get CX vector (RRT near vertex)
-    //=========================================================================
-    
-    double x_pose, y_pose, yaw, surge, Pxx_init, Pyy_init;
-    x_pose = start->as<RealVectorBeliefSpace::StateType>()->values[0];
-    y_pose = start->as<RealVectorBeliefSpace::StateType>()->values[1];
-    yaw = start->as<RealVectorBeliefSpace::StateType>()->values[2];
-    surge = start->as<RealVectorBeliefSpace::StateType>()->values[3];
-    double cos_y = cos(yaw);
-    double sin_y = sin(yaw);
-    //=========================================================================
-    // Get CX vector (RRT random vertex)
-    //=========================================================================
-    double x_pose_reference, y_pose_reference, yaw_reference, surge_reference;
-
-    // control_css = control->as<oc::CompoundControlSpace::ControlType>();
-    // const oc::RealVectorControlSpace::ControlType *control_css_rvs_pose = control_css->as<oc::RealVectorControlSpace::ControlType>(0);
-
-    x_pose_reference = control->as<oc::RealVectorControlSpace::ControlType>()->values[0];
-    y_pose_reference = control->as<oc::RealVectorControlSpace::ControlType>()->values[1];
-    yaw_reference = control->as<oc::RealVectorControlSpace::ControlType>()->values[2];
-    surge_reference = control->as<oc::RealVectorControlSpace::ControlType>()->values[3];
-    //=========================================================================
-    // Compute control inputs (dot(dot(x)) dot(dot(y))) with PD controller
-    //=========================================================================
-    double u_0 = controller_parameters_[0] * (x_pose_reference - x_pose) + controller_parameters_[1] * (surge_reference * cos(yaw_reference) - surge * cos_y);
-    double u_1 = controller_parameters_[6] * (y_pose_reference - y_pose) + controller_parameters_[7] * (surge_reference * sin(yaw_reference) - surge * sin_y);
-    // std::cout << i++ << std::endl;
-    //=========================================================================
-    // Get dot(v) and dot(yaw) from dot(dot(x)) dot(dot(y))
-    //=========================================================================
-    u_bar_0 = cos_y * u_0 + sin_y * u_1;
-    u_bar_1 = (-sin_y * u_0 + cos_y * u_1) / surge;
+    propagateBatch(&start, &control, 1, duration, &result);
+}
 
-    //=========================================================================
-    // Bound controller outputs (dot(v) and dot(yaw))
-    //=========================================================================
-    saturate(u_bar_0, forward_acceleration_bounds_[0], forward_acceleration_bounds_[1]);
-    saturate(u_bar_1, turning_rate_bounds_[0], turning_rate_bounds_[1]);
-    //=========================================================================
-    // Bound surge
-    //=========================================================================
-    surge_final = surge + duration * u_bar_0;
-    // saturate(surge_final, surge_bounds_[0], surge_bounds_[1]);
-    //=========================================================================
-    // Propagate mean
-    //=========================================================================
-    // ob::CompoundStateSpace::StateType *result_css = result->as<ob::CompoundStateSpace::StateType>();
-    // RealVectorBeliefSpace::StateType *result_css_rvs_pose = result_css->as<RealVectorBeliefSpace::StateType>(0);
-
-    // result_css_rvs_pose->setX();
-    // result_css_rvs_pose->setY();
-    // result_css->as<ob::SO2StateSpace::StateType>(1)->value = ;
-    // result_css->as<ob::RealVectorStateSpace::StateType>(2)->values[0] = surge_final;
-    result->as<RealVectorBeliefSpace::StateType>()->values[0] = x_pose + duration * cos_y * surge_final;
-    result->as<RealVectorBeliefSpace::StateType>()->values[1] = y_pose + duration * sin_y * surge_final;
-    result->as<RealVectorBeliefSpace::StateType>()->values[2] = wrap(yaw + duration * u_bar_1);
-    result->as<RealVectorBeliefSpace::StateType>()->values[3] = surge_final;
+void DynUnicycleControlSpace::propagateBatch(const ob::State *const *starts, const oc::Control *const *controls, 
+    const std::size_t n, const double duration, ob::State *const *results) const
+{
+    for (std::size_t first = 0; first < n; first += lanes_) {
+        const std::size_t m = std::min(lanes_, n - first);
+        //=========================================================================
+        // Get CX vector (RRT near vertex) and CX vector (RRT random vertex)
+        //=========================================================================
+        double x_pose[lanes_], y_pose[lanes_], yaw[lanes_], surge[lanes_];
+        double x_pose_reference[lanes_], y_pose_reference[lanes_], yaw_reference[lanes_], surge_reference[lanes_];
+        for (std::size_t i = 0; i < m; i++) {
+            const double *st = starts[first + i]->as<RealVectorBeliefSpace::StateType>()->values;
+            const double *reference = controls[first + i]->as<oc::RealVectorControlSpace::ControlType>()->values;
+            x_pose[i] = st[0];
+            y_pose[i] = st[1];
+            yaw[i] = st[2];
+            surge[i] = st[3];
+            x_pose_reference[i] = reference[0];
+            y_pose_reference[i] = reference[1];
+            yaw_reference[i] = reference[2];
+            surge_reference[i] = reference[3];
+        }
+        double cos_y[lanes_], sin_y[lanes_], cos_r[lanes_], sin_r[lanes_];
+        for (std::size_t i = 0; i < m; i++) {
+            cos_y[i] = std::cos(yaw[i]);
+            sin_y[i] = std::sin(yaw[i]);
+            cos_r[i] = std::cos(yaw_reference[i]);
+            sin_r[i] = std::sin(yaw_reference[i]);
+        }
+        double nxt_x[lanes_], nxt_y[lanes_], nxt_yaw[lanes_], nxt_surge[lanes_];
+        for (std::size_t i = 0; i < m; i++) {
+            //=========================================================================
+            // Compute control inputs (dot(dot(x)) dot(dot(y))) with PD controller
+            //=========================================================================
+            const double u_0 = controller_parameters_[0] * (x_pose_reference[i] - x_pose[i]) + controller_parameters_[1] * (surge_reference[i] * cos_r[i] - surge[i] * cos_y[i]);
+            const double u_1 = controller_parameters_[6] * (y_pose_reference[i] - y_pose[i]) + controller_parameters_[7] * (surge_reference[i] * sin_r[i] - surge[i] * sin_y[i]);
+            //=========================================================================
+            // Get dot(v) and dot(yaw) from dot(dot(x)) dot(dot(y))
+            //=========================================================================
+            double u_bar_0 = cos_y[i] * u_0 + sin_y[i] * u_1;
+            double u_bar_1 = (-sin_y[i] * u_0 + cos_y[i] * u_1) / surge[i];
+            //=========================================================================
+            // Bound controller outputs (dot(v) and dot(yaw))
+            //=========================================================================
+            saturate(u_bar_0, forward_acceleration_bounds_[0], forward_acceleration_bounds_[1]);
+            saturate(u_bar_1, turning_rate_bounds_[0], turning_rate_bounds_[1]);
+            //=========================================================================
+            // Propagate mean (the heading of the start is used for the whole step)
+            //=========================================================================
+            nxt_surge[i] = surge[i] + duration * u_bar_0;
+            nxt_x[i] = x_pose[i] + duration * cos_y[i] * nxt_surge[i];
+            nxt_y[i] = y_pose[i] + duration * sin_y[i] * nxt_surge[i];
+            nxt_yaw[i] = yaw[i] + duration * u_bar_1;
+        }
+        for (std::size_t i = 0; i < m; i++) {
+            double *nxt = results[first + i]->as<RealVectorBeliefSpace::StateType>()->values;
+            nxt[0] = nxt_x[i];
+            nxt[1] = nxt_y[i];
+            nxt[2] = wrap(nxt_yaw[i]);
+            nxt[3] = nxt_surge[i];
+        }
+    }
     //=========================================================================
     // Propagate covariance in the equivalent closed loop system
     //=========================================================================
-    // std::cout << "-----------" << std::endl;
-    Eigen::Matrix4d sigma_from = start->as<RealVectorBeliefSpace::StateType>()->sigma_;
-    Eigen::Matrix4d lambda_from = start->as<RealVectorBeliefSpace::StateType>()->lambda_;
-    // std::cout << lambda_from << std::endl;
-    Eigen::Matrix4d sigma_pred = (F * sigma_from * F) + Q;
-
-    Eigen::Matrix4d S = (H * sigma_pred * H.transpose())+ R;
-    auto K = (sigma_pred * H.transpose()) * S.inverse();
-    auto lambda_pred = A_cl_d_ * lambda_from * A_cl_d_.transpose();
-    // std::cout << lambda_pred << std::endl;
-    Eigen::Matrix4d sigma_to = (I - (K * H)) * sigma_pred;
-    Eigen::Matrix4d lambda_to = lambda_pred + K * H * sigma_pred;
-
-    result->as<RealVectorBeliefSpace::StateType>()->sigma_ = sigma_to;
-    result->as<RealVectorBeliefSpace::StateType>()->lambda_ = lambda_to;
-
-    // std::cout << lambda_to << std::endl;
-    // std::cout << "-----------" << std::endl;
+    /* the covariance step does not depend on the control, so it is looked up along the sequence every tree shares.
+       Candidates from the same parent share their covariances, so their update is reused */
+    Eigen::Matrix4d sigma_from, lambda_from, sigma_to, lambda_to;
+    for (std::size_t i = 0; i < n; i++) {
+        const auto *start_css = starts[i]->as<RealVectorBeliefSpace::StateType>();
+        auto *result_css = results[i]->as<RealVectorBeliefSpace::StateType>();
+        const Eigen::Map<const Eigen::Matrix4d> sigma_in(start_css->sigma_.data()), lambda_in(start_css->lambda_.data());
+        if (i == 0 || sigma_in != sigma_from || lambda_in != lambda_from) {
+            sigma_from = sigma_in;
+            lambda_from = lambda_in;
+            covariance_cache_.propagate(sigma_from, lambda_from, sigma_to, lambda_to, 
+                [this](const Eigen::Matrix4d &sigma, const Eigen::Matrix4d &lambda, Eigen::Matrix4d &nxt_sigma, Eigen::Matrix4d &nxt_lambda) {
+                    propagateCovariance_(sigma, lambda, nxt_sigma, nxt_lambda);
+                });
+        }
+        Eigen::Map<Eigen::Matrix4d>(result_css->sigma_.data()) = sigma_to;
+        Eigen::Map<Eigen::Matrix4d>(result_css->lambda_.data()) = lambda_to;
+    }
+}
+
+void DynUnicycleControlSpace::propagateCovariance_(const Eigen::Matrix4d &sigma, const Eigen::Matrix4d &lambda, 
+    Eigen::Matrix4d &nxt_sigma, Eigen::Matrix4d &nxt_lambda) const
+{
+    const Eigen::Matrix4d sigma_pred = (F * sigma * F) + Q;
+    const Eigen::Matrix4d S = (H * sigma_pred * H.transpose()) + R;
+    const Eigen::Matrix4d K = (sigma_pred * H.transpose()) * S.inverse();
+    const Eigen::Matrix4d lambda_pred = A_cl_d_ * lambda * A_cl_d_.transpose();
+    nxt_sigma = (I - (K * H)) * sigma_pred;
+    nxt_lambda = lambda_pred + K * H * sigma_pred;
 }
 
 bool DynUnicycleControlSpace::canPropagateBackward(void) const
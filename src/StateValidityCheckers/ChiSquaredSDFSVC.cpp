@@ -0,0 +1,31 @@
+#include "StateValidityCheckers/ChiSquaredSDFSVC.h"
+
+ChiSquaredSDFSVC::ChiSquaredSDFSVC(const oc::SpaceInformationPtr &si, InstancePtr mrmp_instance, const Robot *r, const double accep_prob) :
+    ob::StateValidityChecker(si), si_(si.get()), mrmp_instance_(mrmp_instance), robot_(r), 
+    sdf_(mrmp_instance_->getDistanceField()), max_rad_(robot_->getBoundingRadius())
+{
+    // set sc_ value
+    sc_ = chi_squared_quantile_(2, accep_prob);
+}
+
+ChiSquaredSDFSVC::~ChiSquaredSDFSVC(){};
+
+bool ChiSquaredSDFSVC::isValid(const ob::State *state) const
+{
+    if (!si_->satisfiesBounds(state))
+        return false;
+    return clearance(state) > 0;
+}
+
+double ChiSquaredSDFSVC::clearance(const ob::State *state) const
+{
+    /* get Belief from state */
+    const RealVectorBeliefSpace::StateType *belief = state->as<RealVectorBeliefSpace::StateType>();
+    const double x = belief->values[0];
+    const double y = belief->values[1];
+
+    const Eigen::Matrix2d cov = belief->sigma_.block<2, 2>(0, 0) + belief->lambda_.block<2, 2>(0, 0);
+    const double max_lambda = maxEigenvalue2x2(cov);
+
+    return sdf_->distance(x, y) - max_rad_ - max_lambda * sc_;
+}
@@ -2,7 +2,8 @@
 
 MultiRobotStateSpaceSVC::MultiRobotStateSpaceSVC
     (const oc::SpaceInformationPtr &si, InstancePtr mrmp_instance, const Robot *r, std::string dyn) :
-    ob::StateValidityChecker(si), si_(si.get()), mrmp_instance_(mrmp_instance), robot_(r), dyn_(dyn) {}
+    ob::StateValidityChecker(si), si_(si.get()), mrmp_instance_(mrmp_instance), robot_(r), dyn_(dyn),
+    occupancy_(mrmp_instance->getOccupancy()) {}
  
 bool MultiRobotStateSpaceSVC::isValid(const ob::State *state) const
 {
@@ -18,96 +19,112 @@ bool MultiRobotStateSpaceSVC::isValid(const ob::State *state) const
     // Polygon map;
     // boost::geometry::assign_points(map, map_pts);
 
-    // use comp state to fill vehicles vector
-    auto compState = state->as<ob::CompoundStateSpace::StateType>();
-    std::vector<Polygon> vehicles;
-        
-    int numVs = 0;
+    const int numVs = numVehicles_();
+    if (numVs == 0)
+        OMPL_ERROR("Current composed dynamics model is not implemented.");
+    for (int i = 0; i < numVs; i++) {
+        if (!isAgentValid(state, i))
+            return false;
+    }
+    return areAgentsSeparated(state, std::vector<bool>(numVs, true));
+}
+
+int MultiRobotStateSpaceSVC::numVehicles_() const
+{
     if (dyn_ == "Two Dynamic Cars" )
-        numVs = 2;
+        return 2;
     else if (dyn_ == "Three Dynamic Cars" )
-        numVs = 3;
-        
-    if (dyn_ == "Two Dynamic Cars" || dyn_ == "Three Dynamic Cars")
-    {
-        for (int i = 0; i < numVs; i++)
-        {
-            auto xyState = compState->as<
-                ob::RealVectorStateSpace::StateType>(2*i + 0);
-            const double cx = xyState->values[0];
-            const double cy = xyState->values[1];
-            const double theta = compState->as<ob::SO2StateSpace::StateType>(2*i + 1)->value;
+        return 3;
+    return 0;
+}
 
-            // // Get important params from car object
-            // const double carWidth = a_->getShape()[0];
-            // const double carHeight = a_->getShape()[1];
+Polygon MultiRobotStateSpaceSVC::vehicle_(const ob::State *state, const int i) const
+{
+    auto compState = state->as<ob::CompoundStateSpace::StateType>();
+    auto xyState = compState->as<
+        ob::RealVectorStateSpace::StateType>(2*i + 0);
+    const double cx = xyState->values[0];
+    const double cy = xyState->values[1];
+    const double theta = compState->as<ob::SO2StateSpace::StateType>(2*i + 1)->value;
 
-            // // turn (x,y, theta), width, length to a polygon object
-            // // see https://stackoverflow.com/questions/41898990/find-corners-of-a-rotated-rectangle-given-its-center-point-and-rotation
-            // // TOP RIGHT VERTEX:
-            // const double TR_x = cx + ((carWidth / 2) * cos(theta)) - ((carHeight / 2) * sin(theta));
-            // const double TR_y = cy + ((carWidth / 2) * sin(theta)) + ((carHeight / 2) * cos(theta));
-            // std::string top_right = std::to_string(TR_x) + " " + std::to_string(TR_y);
-            // // TOP LEFT VERTEX:
-            // const double TL_x = cx - ((carWidth / 2) * cos(theta)) - ((carHeight / 2) * sin(theta));
-            // const double TL_y = cy - ((carWidth / 2) * sin(theta)) + ((carHeight / 2) * cos(theta));
-            // std::string top_left = std::to_string(TL_x) + " " + std::to_string(TL_y);
-            // // BOTTOM LEFT VERTEX:
-            // const double BL_x = cx - ((carWidth / 2) * cos(theta)) + ((carHeight / 2) * sin(theta));
-            // const double BL_y = cy - ((carWidth / 2) * sin(theta)) - ((carHeight / 2) * cos(theta));
-            // std::string bottom_left = std::to_string(BL_x) + " " + std::to_string(BL_y);
-            // // BOTTOM RIGHT VERTEX:
-            // const double BR_x = cx + ((carWidth / 2) * cos(theta)) + ((carHeight / 2) * sin(theta));
-            // const double BR_y = cy + ((carWidth / 2) * sin(theta)) - ((carHeight / 2) * cos(theta));
-            // std::string bottom_right = std::to_string(BR_x) + " " + std::to_string(BR_y);
+    // // Get important params from car object
+    // const double carWidth = a_->getShape()[0];
+    // const double carHeight = a_->getShape()[1];
 
-            // // convert to string for easy initializataion
-            // std::string points = "POLYGON((" + bottom_left + "," + bottom_right + "," + top_right + "," + top_left + "," + bottom_left + "))";
-            // Polygon agent;
-            // boost::geometry::read_wkt(points,agent);
-            
-            // beta test: use boost transform instread of creating a polygon manually
-            Polygon raw;
-            Polygon result;
-            Polygon initial = robot_->getShape();
-            bg::correct(raw);
-            bg::assign(raw, initial);
-            bg::strategy::transform::matrix_transformer<double, 2, 2> xfrm(
-                     cos(theta), sin(theta), cx,
-                    -sin(theta), cos(theta), cy,
-                      0,          0,  1);
+    // // turn (x,y, theta), width, length to a polygon object
+    // // see https://stackoverflow.com/questions/41898990/find-corners-of-a-rotated-rectangle-given-its-center-point-and-rotation
+    // // TOP RIGHT VERTEX:
+    // const double TR_x = cx + ((carWidth / 2) * cos(theta)) - ((carHeight / 2) * sin(theta));
+    // const double TR_y = cy + ((carWidth / 2) * sin(theta)) + ((carHeight / 2) * cos(theta));
+    // std::string top_right = std::to_string(TR_x) + " " + std::to_string(TR_y);
+    // // TOP LEFT VERTEX:
+    // const double TL_x = cx - ((carWidth / 2) * cos(theta)) - ((carHeight / 2) * sin(theta));
+    // const double TL_y = cy - ((carWidth / 2) * sin(theta)) + ((carHeight / 2) * cos(theta));
+    // std::string top_left = std::to_string(TL_x) + " " + std::to_string(TL_y);
+    // // BOTTOM LEFT VERTEX:
+    // const double BL_x = cx - ((carWidth / 2) * cos(theta)) + ((carHeight / 2) * sin(theta));
+    // const double BL_y = cy - ((carWidth / 2) * sin(theta)) - ((carHeight / 2) * cos(theta));
+    // std::string bottom_left = std::to_string(BL_x) + " " + std::to_string(BL_y);
+    // // BOTTOM RIGHT VERTEX:
+    // const double BR_x = cx + ((carWidth / 2) * cos(theta)) + ((carHeight / 2) * sin(theta));
+    // const double BR_y = cy + ((carWidth / 2) * sin(theta)) - ((carHeight / 2) * cos(theta));
+    // std::string bottom_right = std::to_string(BR_x) + " " + std::to_string(BR_y);
 
-            bg::transform(raw, result, xfrm);
-            vehicles.push_back(result);
-        }
-    }
-    else
-        OMPL_ERROR("Current composed dynamics model is not implemented.");
+    // // convert to string for easy initializataion
+    // std::string points = "POLYGON((" + bottom_left + "," + bottom_right + "," + top_right + "," + top_left + "," + bottom_left + "))";
+    // Polygon agent;
+    // boost::geometry::read_wkt(points,agent);
+    
+    // beta test: use boost transform instread of creating a polygon manually
+    Polygon raw;
+    Polygon result;
+    Polygon initial = robot_->getShape();
+    bg::correct(raw);
+    bg::assign(raw, initial);
+    bg::strategy::transform::matrix_transformer<double, 2, 2> xfrm(
+             cos(theta), sin(theta), cx,
+            -sin(theta), cos(theta), cy,
+              0,          0,  1);
+
+    bg::transform(raw, result, xfrm);
+    return result;
+}
 
-    if (vehicles.size() != numVs) {
-        printf("num polys: %lu, num vs: %i \n", vehicles.size(), numVs);
-        OMPL_ERROR("Collision Checking not working as expected.");
+bool MultiRobotStateSpaceSVC::isAgentValid(const ob::State *state, const int agent) const
+{
+    // the bounds of the sub-states of the vehicle
+    const auto *space = si_->getStateSpace()->as<ob::CompoundStateSpace>();
+    const auto *compState = state->as<ob::CompoundStateSpace::StateType>();
+    for (int k = 2*agent; k < 2*agent + 2; k++) {
+        if (!space->getSubspace(k)->satisfiesBounds(compState->components[k]))
+            return false;
     }
-        
-    // check agent is disjoint from all obstacles and map
+    // check vehicle is disjoint from all obstacles
+    const Polygon v = vehicle_(state, agent);
+    // only the blocked cells near the vehicle, when the map has a quadtree
+    if (occupancy_)
+        return occupancy_->disjoint(v);
     std::vector<Obstacle*> obs_list = mrmp_instance_->getObstacles();
-    for (const auto v: vehicles) {
-        // check against obs
-        for (auto itr = obs_list.begin(); itr != obs_list.end(); itr++) {
-            if (! boost::geometry::disjoint(v, (*itr)->getPolyPoints()))
+    for (auto itr = obs_list.begin(); itr != obs_list.end(); itr++) {
+        if (! boost::geometry::disjoint(v, (*itr)->getPolyPoints()))
             return false;
-        }   
-        // // check against map
-        // if (! boost::geometry::within(v, map))
-        //         return false;
     }
-    // check vehicles against each other
+    // // check against map
+    // if (! boost::geometry::within(v, map))
+    //         return false;
+    return true;
+}
+
+bool MultiRobotStateSpaceSVC::areAgentsSeparated(const ob::State *state, const std::vector<bool> &active) const
+{
+    std::vector<Polygon> vehicles;
+    for (int i = 0; i < numVehicles_(); i++)
+        vehicles.push_back(vehicle_(state, i));
+    // check vehicles against each other (each pair once)
     for (int a1 = 0; a1 < vehicles.size(); a1++) {
-        for (int a2 = 0; a2 < vehicles.size(); a2++) {
-            if (a1 != a2) {
-                if (! boost::geometry::disjoint(vehicles[a1], vehicles[a2]))
-                    return false;
-            }
+        for (int a2 = a1 + 1; a2 < vehicles.size(); a2++) {
+            if ((active[a1] || active[a2]) && ! boost::geometry::disjoint(vehicles[a1], vehicles[a2]))
+                return false;
         }
     }
     return true;
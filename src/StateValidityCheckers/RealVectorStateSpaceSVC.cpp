@@ -2,7 +2,8 @@
 
 RealVectorStateSpaceSVC::RealVectorStateSpaceSVC
     (const oc::SpaceInformationPtr &si, const InstancePtr mrmp_instance, const Robot *r) :
-    ob::StateValidityChecker(si), si_(si.get()), mrmp_instance_(mrmp_instance), robot_(r) {}
+    ob::StateValidityChecker(si), si_(si.get()), mrmp_instance_(mrmp_instance), robot_(r),
+    occupancy_(mrmp_instance->getOccupancy()) {}
  
 bool RealVectorStateSpaceSVC::isValid(const ob::State *state) const
 {
@@ -37,6 +38,9 @@ bool RealVectorStateSpaceSVC::isValid(const ob::State *state) const
     bg::transform(raw, result, xfrm);
 
 
+    // only the blocked cells near the robot, when the map has a quadtree
+    if (occupancy_)
+        return occupancy_->disjoint(result);
     // beta test: use boost transform instread of creating a polygon manually
     std::vector<Obstacle*> obs_list = mrmp_instance_->getObstacles();
     for (auto itr = obs_list.begin(); itr != obs_list.end(); itr++) {
@@ -0,0 +1,92 @@
+#include "utils/AllocStats.h"
+#include <algorithm>
+#include <atomic>
+
+
+namespace alloc
+{
+    namespace
+    {
+        /* the counters of a subsystem on a line of their own, as the subsystems are hit by different threads */
+        struct alignas(64) Counters
+        {
+            std::atomic<std::int64_t> live_bytes_{0};
+            std::atomic<std::int64_t> peak_bytes_{0};
+            std::atomic<std::uint64_t> allocations_{0};
+            std::atomic<std::uint64_t> frees_{0};
+            std::atomic<std::uint64_t> allocated_bytes_{0};
+        };
+
+        std::atomic<bool> enabled{false};
+        std::atomic<unsigned int> windows{0};
+        Counters counters[NUM_SUBSYSTEMS];
+
+        const char *names[NUM_SUBSYSTEMS] = {"Belief States", "Motions", "Constraints", "Conflict Tree"};
+    }
+
+    const char *name(const Subsystem s)
+    {
+        return names[s];
+    }
+
+    void setEnabled(const bool on)
+    {
+        enabled.store(on, std::memory_order_relaxed);
+    }
+
+    bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    void onAlloc(const Subsystem s, const std::size_t bytes)
+    {
+        if (!isEnabled())
+            return;
+        Counters &c = counters[s];
+        const std::int64_t live = c.live_bytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        std::int64_t peak = c.peak_bytes_.load(std::memory_order_relaxed);
+        while (live > peak && !c.peak_bytes_.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+        c.allocations_.fetch_add(1, std::memory_order_relaxed);
+        c.allocated_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void onFree(const Subsystem s, const std::size_t bytes, const std::uint64_t count)
+    {
+        if (!isEnabled())
+            return;
+        Counters &c = counters[s];
+        c.live_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+        c.frees_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    Usage usage(const Subsystem s)
+    {
+        const Counters &c = counters[s];
+        Usage u;
+        // negative while the objects allocated before accounting was enabled are freed
+        u.live_bytes_ = std::max<std::int64_t>(0, c.live_bytes_.load(std::memory_order_relaxed));
+        u.peak_bytes_ = std::max<std::int64_t>(0, c.peak_bytes_.load(std::memory_order_relaxed));
+        u.allocations_ = c.allocations_.load(std::memory_order_relaxed);
+        u.frees_ = c.frees_.load(std::memory_order_relaxed);
+        u.allocated_bytes_ = c.allocated_bytes_.load(std::memory_order_relaxed);
+        return u;
+    }
+
+    void resetPeaks()
+    {
+        for (Counters &c: counters)
+            c.peak_bytes_.store(c.live_bytes_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    Window::Window()
+    {
+        if (windows.fetch_add(1, std::memory_order_acq_rel) == 0)
+            resetPeaks();
+    }
+
+    Window::~Window()
+    {
+        windows.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
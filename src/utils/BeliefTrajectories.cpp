@@ -0,0 +1,59 @@
+#include "utils/BeliefTrajectories.h"
+#include <ompl/util/Console.h>
+#include <algorithm>
+
+
+BeliefTrajectories::BeliefTrajectories(const DiscretePlan &p, const int max_states, const std::vector<int> &agents):
+    trajs_(p.size()), steps_(max_states)
+{
+    std::vector<bool> active(p.size(), agents.empty());
+    for (const int a: agents)
+        active[a] = true;
+
+    bool warned = false;
+    for (std::size_t a = 0; a < p.size(); a++) {
+        if (!active[a] || p[a].getStateCount() == 0)
+            continue;
+        const std::size_t n = std::min<std::size_t>(p[a].getStateCount(), std::max(max_states, 1));
+        Trajectory &traj = trajs_[a];
+        traj.mu_x_.resize(n);
+        traj.mu_y_.resize(n);
+        traj.s_xx_.resize(n);
+        traj.s_xy_.resize(n);
+        traj.s_yy_.resize(n);
+        // every belief of a trajectory has the dimension of its space, so the layout is picked once per agent
+        const Eigen::Index rows = p[a].getState(0)->as<RealVectorBeliefSpace::StateType>()->sigma_.rows();
+        if (rows == 2) {
+            fill_<2>(p[a], n, traj);
+            continue;
+        }
+        if (rows == 4) {
+            fill_<4>(p[a], n, traj);
+            continue;
+        }
+        for (std::size_t k = 0; k < n; k++) {
+            if (!extract(p[a].getState(k), traj.mu_x_[k], traj.mu_y_[k], traj.s_xx_[k], traj.s_xy_[k], traj.s_yy_[k]) && !warned) {
+                OMPL_ERROR("Please specify the x and y elements of this type of space!");
+                warned = true;
+            }
+        }
+    }
+}
+
+bool BeliefTrajectories::extract(const ompl::base::State *st, double &x, double &y, double &s_xx, double &s_xy, double &s_yy)
+{
+    const RealVectorBeliefSpace::StateType *belief = st->as<RealVectorBeliefSpace::StateType>();
+    x = belief->values[0];
+    y = belief->values[1];
+    // the x-y entries of the covariance, as read by BeliefPVC::getDistribution_
+    const Eigen::Index rows = belief->sigma_.rows();
+    if (rows < 2) {
+        s_xx = s_xy = s_yy = 0;
+        return false;
+    }
+    const Eigen::Index iy = (rows == 4) ? 2 : 1;
+    s_xx = belief->sigma_(0, 0) + belief->lambda_(0, 0);
+    s_xy = belief->sigma_(0, iy) + belief->lambda_(0, iy);
+    s_yy = belief->sigma_(iy, iy) + belief->lambda_(iy, iy);
+    return (rows == 2 || rows == 4);
+}
@@ -1,7 +1,168 @@
 #include "utils/Benchmark.h"
+#include <ompl/util/RandomNumbers.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 
-void run_kcbs_benchmark(InstancePtr mrmp_instance, const double merge_bound, const double comp_time, std::string filename)
+namespace
+{
+    void pin_to_cpu(const unsigned int worker)
+    {
+#ifdef __linux__
+        const unsigned int cpus = std::max(std::thread::hardware_concurrency(), 1u);
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(worker % cpus, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+            OMPL_WARN("%s: Could not pin worker %u to CPU %u.", "Benchmark", worker, worker % cpus);
+#else
+        OMPL_WARN("%s: Pinning workers to CPUs is only supported on Linux.", "Benchmark");
+#endif
+    }
+
+    double elapsed(const std::chrono::steady_clock::time_point &t0)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+
+    /* seed OMPL (before any planner is allocated) and return the seed of the run */
+    std::uint32_t seed_run(const BenchmarkOptions &options)
+    {
+        // OMPL takes the seed only once, so the runs of a sweep share it
+        if (options.seed_ != 0 && options.seed_ != ompl::RNG::getSeed())
+            ompl::RNG::setSeed(options.seed_);
+        return ompl::RNG::getSeed();
+    }
+
+    /* run the trials of options on options.workers_ threads. Worker w calls set_up(w) once, then run(state, trial)
+       for every trial it takes. The workers are threads of their own (not tasks of utils/TaskRuntime.h), as they may
+       be pinned to CPUs and their trials are timed; the planners of a trial still schedule on the runtime */
+    template <typename SetUp, typename Run>
+    void run_trials(const BenchmarkOptions &options, SetUp &&set_up, Run &&run)
+    {
+        const std::uint32_t seed = seed_run(options);
+        perf::setEnabled(options.perf_counters_);
+        alloc::setEnabled(options.alloc_stats_);
+        const unsigned int workers = std::max(1u, std::min(options.workers_, options.trials_));
+        std::atomic<unsigned int> next_trial{0};
+        auto work = [&](const unsigned int w) {
+            if (options.pin_cpus_)
+                pin_to_cpu(w);
+            auto state = set_up(w);
+            for (unsigned int t = next_trial++; t < options.trials_; t = next_trial++)
+                run(state, BenchmarkTrial{t, w, seed, &options.labels_, options.perf_counters_, options.alloc_stats_});
+        };
+        OMPL_INFORM("%s: Running %u trials on %u workers (seed %u).", "Benchmark", options.trials_, workers, seed);
+        std::vector<std::thread> threads;
+        for (unsigned int w = 1; w < workers; w++)
+            threads.emplace_back(work, w);
+        work(0);
+        for (std::thread &t: threads)
+            t.join();
+    }
+
+    /* the label columns of trial, the metadata of instance and the results every planner has */
+    ResultRow result_row(const BenchmarkTrial &trial, const Instance &instance, const bool solved, const double time,
+        const double soc)
+    {
+        ResultRow row;
+        if (trial.labels_) {
+            for (const std::pair<std::string, std::string> &label: *trial.labels_)
+                row.add(label.first, label.second);
+        }
+        row.add("Map", instance.getMapFile().filename().string());
+        row.add("Scen", instance.getScenFile().filename().string());
+        row.add("Agents", instance.getNumAgents());
+        row.add("Solver", instance.getPlannerName());
+        row.add("Low-Level", instance.getLowLevelPlannerName());
+        row.add("PVC", instance.getPVC());
+        row.add("SVC", instance.getSVC());
+        row.add("P Safe", instance.getPsafe());
+        row.add("Success (Boolean)", solved);
+        row.add("Computation Time (s)", time);
+        row.add("Sum of Controls (double)", soc);
+        return row;
+    }
+
+    /* the columns of the counters, prefixed by name */
+    void add_counters(ResultRow &row, const std::string &name, const perf::Counters &c)
+    {
+        row.add(name + " Cycles", c.cycles_);
+        row.add(name + " Instructions", c.instructions_);
+        row.add(name + " Cache Misses", c.cache_misses_);
+        row.add(name + " Branch Misses", c.branch_misses_);
+    }
+
+    void add_kcbs_statistics(ResultRow &row, const oc::KCBS::Statistics &kcbs_stats, const BenchmarkTrial &trial)
+    {
+        const std::vector<std::pair<std::string, const oc::KCBS::PhaseTime*>> phases{
+            {"Root", &kcbs_stats.root_}, {"Low-Level", &kcbs_stats.low_level_}, {"Validation", &kcbs_stats.validation_},
+            {"Constraints", &kcbs_stats.constraints_}, {"Queue", &kcbs_stats.queue_}, {"Merge", &kcbs_stats.merge_},
+            {"Classification", &kcbs_stats.classification_}};
+        row.add("Nodes Generated", kcbs_stats.nodes_generated_);
+        row.add("Nodes Expanded", kcbs_stats.nodes_expanded_);
+        row.add("Low-Level Failures", kcbs_stats.low_level_failures_);
+        row.add("Re-queues", kcbs_stats.requeues_);
+        row.add("Peak Queue Size", kcbs_stats.peak_queue_size_);
+        row.add("Peak Queue Bytes", kcbs_stats.peak_queue_bytes_);
+        row.add("Nodes Compressed", kcbs_stats.nodes_compressed_);
+        row.add("Peak RSS (bytes)", kcbs_stats.peak_rss_bytes_);
+        row.add("Duplicates Pruned", kcbs_stats.duplicates_pruned_);
+        row.add("Solutions Found", kcbs_stats.solutions_);
+        row.add("Nodes Pruned", kcbs_stats.nodes_pruned_);
+        row.add("Cardinal Conflicts", kcbs_stats.cardinal_);
+        row.add("Semi-Cardinal Conflicts", kcbs_stats.semi_cardinal_);
+        row.add("Non-Cardinal Conflicts", kcbs_stats.non_cardinal_);
+        for (auto &ph: phases) {
+            row.add(ph.first + " Total (s)", ph.second->total_);
+            row.add(ph.first + " Calls", ph.second->calls_);
+            row.add(ph.first + " Max (s)", ph.second->max_);
+            if (trial.perf_counters_)
+                add_counters(row, ph.first, ph.second->counters_);
+        }
+        // constraints per agent are separated by ';' to keep a single column
+        std::string constraints;
+        for (std::size_t a = 0; a < kcbs_stats.constraints_per_agent_.size(); a++)
+            constraints += (a > 0 ? ";" : "") + std::to_string(kcbs_stats.constraints_per_agent_[a]);
+        row.add("Constraints per Agent", constraints);
+        if (trial.alloc_stats_) {
+            for (int m = 0; m < alloc::NUM_SUBSYSTEMS; m++) {
+                const std::string name = alloc::name(alloc::Subsystem(m));
+                row.add(name + " Live Bytes", kcbs_stats.memory_[m].live_bytes_);
+                row.add(name + " Peak Bytes", kcbs_stats.memory_[m].peak_bytes_);
+                row.add(name + " Allocations", kcbs_stats.memory_[m].allocations_);
+                row.add(name + " Allocations/s", kcbs_stats.memory_[m].allocation_rate_);
+            }
+        }
+    }
+
+    /* the seed of the low-level calls of trial, so a trial is repeated by the seed of its run */
+    std::uint32_t trial_seed(const BenchmarkTrial &trial)
+    {
+        return seeding::derive(trial.seed_, trial.trial_);
+    }
+
+    void add_trial(ResultRow &row, const BenchmarkTrial &trial)
+    {
+        row.add("Trial", trial.trial_);
+        row.add("Worker", trial.worker_);
+        row.add("Seed", trial.seed_);
+        row.add("Trial Seed", trial_seed(trial));
+    }
+
+    /* the sink of options, or a new one on filename */
+    ResultsSinkPtr results_sink(const std::string &filename, const BenchmarkOptions &options)
+    {
+        return options.sink_ ? options.sink_ : make_results_sink(filename);
+    }
+}
+
+MultiRobotProblemDefinitionPtr set_up_kcbs(InstancePtr mrmp_instance)
 {
     // set-up low-level planners
     std::vector<MotionPlanningProblemPtr> mp_problems = set_up_all_MP_Problems(mrmp_instance);
@@ -41,6 +202,9 @@ void run_kcbs_benchmark(InstancePtr mrmp_instance, const double merge_bound, con
         else if (mrmp_instance->getPVC() == "AdaptiveBoundingBox") {
             planValidator = std::make_shared<AdaptiveRiskBoundingBoxPVC>(mrmp_pdef, mrmp_instance->getPsafeAgents());
         }
+        else if (mrmp_instance->getPVC().find("Cascade:") == 0) {
+            planValidator = CascadePVC::create(mrmp_pdef, mrmp_instance->getPsafeAgents(), mrmp_instance->getPVC().substr(8));
+        }
         else if (mrmp_instance->getPVC().find("CDFGrid") != std::string::npos) {
             boost::char_separator<char> sep("-");
             boost::tokenizer< boost::char_separator<char> > tok(mrmp_instance->getPVC(), sep);
@@ -50,78 +214,122 @@ void run_kcbs_benchmark(InstancePtr mrmp_instance, const double merge_bound, con
             OMPL_INFORM("The plan validity checker is CDFGrid with discretization of %d", disks);
             planValidator = std::make_shared<CDFGridPVC>(mrmp_pdef, mrmp_instance->getPsafeAgents(), disks);
         }
+        else if (mrmp_instance->getPVC().find("MonteCarlo-") == 0) {
+            const int samples = atoi(mrmp_instance->getPVC().substr(11).c_str());
+            OMPL_INFORM("The plan validity checker is MonteCarlo with at most %d samples per pair", samples);
+            planValidator = std::make_shared<MonteCarloPVC>(mrmp_pdef, mrmp_instance->getPsafeAgents(), samples);
+        }
         else {
             OMPL_ERROR("Plan Validity Checker ``%s`` is not available.", mrmp_instance->getPVC().c_str());
         }
         mrmp_pdef->setPlanValidator(planValidator);
     }
+    return mrmp_pdef;
+}
 
-    std::vector<std::tuple<bool, double, double>> results; // solved, computation time, path length
-
-    for (int i = 0; i < 50; i++) {
-        // create K-CBS instance
-        ob::PlannerPtr p(std::make_shared<oc::KCBS>(mrmp_pdef));
-        p->as<oc::KCBS>()->setMergeBound(merge_bound);
-        // plan with K-CBS
-        bool solved = p->solve(comp_time);
-        // fill results
-        std::tuple<bool, double, double> r{solved, p->as<oc::KCBS>()->getComputationTime(), p->as<oc::KCBS>()->getSolutionSOC()};
-        results.push_back(r);
-        // update results file with n
-        write_csv(filename, r);
-        // clear memory
-        p.reset();
-        auto all_pdefs = mrmp_pdef->getAllProblemInformation();
-        for (auto pdef_itr = all_pdefs.begin(); pdef_itr != all_pdefs.end(); pdef_itr++) {
-            (*pdef_itr)->getProblemDefinition()->clearSolutionPaths();// << std::endl; //->clearSolutionPaths()
-            (*pdef_itr)->getPlanner()->clear();
-        }
+void clear_trial(const MultiRobotProblemDefinitionPtr &mrmp_pdef)
+{
+    auto all_pdefs = mrmp_pdef->getAllProblemInformation();
+    for (auto pdef_itr = all_pdefs.begin(); pdef_itr != all_pdefs.end(); pdef_itr++) {
+        (*pdef_itr)->getProblemDefinition()->clearSolutionPaths();
+        (*pdef_itr)->getPlanner()->clear();
     }
 }
 
-void run_centralized_bsst_benchmark(InstancePtr mrmp_instance, const double comp_time, std::string filename)
+void run_kcbs_benchmark(const po::variables_map &vm, const double merge_bound, const double comp_time, std::string filename,
+    const BenchmarkOptions &options)
 {
-    // set-up low-level planners
-    std::vector<MotionPlanningProblemPtr> mp_problems = set_up_all_MP_Problems(mrmp_instance);
-    // set-up MRMP Problem Definition
-    MultiRobotProblemDefinitionPtr mrmp_pdef = std::make_shared<MultiRobotProblemDefinition>(mp_problems);
-    mrmp_pdef->setMultiRobotInstance(mrmp_instance);
-    const std::string low_level_planner = mrmp_instance->getLowLevelPlannerName();
+    // every worker parses its own copy of the instance
+    run_kcbs_benchmark([&vm]() {
+        po::variables_map worker_vm(vm);
+        return std::make_shared<Instance>(worker_vm);
+    }, merge_bound, comp_time, filename, options);
+}
 
-    std::vector<std::tuple<bool, double, double>> results; // solved, computation time, path length
-
-    for (int i = 0; i < 50; i++) {
-        // solve with CentralizedBSST instance
-        PlannerPtr p = mrmp_pdef->getRobotMotionPlanningProblemPtr(0)->getPlanner();
-        bool solved = p->solve(comp_time);
-        // fill results
-        std::tuple<bool, double, double> r{solved, p->as<oc::CentralizedBSST>()->getComputationTime(), p->as<oc::CentralizedBSST>()->getSolutionSOC()};
-        results.push_back(r);
-        // update results file with n
-        write_csv(filename, r);
-        // clear memory
-        mrmp_pdef->getRobotMotionPlanningProblemPtr(0)->getPlanner()->clear();
-        auto all_pdefs = mrmp_pdef->getAllProblemInformation();
-        for (auto pdef_itr = all_pdefs.begin(); pdef_itr != all_pdefs.end(); pdef_itr++) {
-            (*pdef_itr)->getProblemDefinition()->clearSolutionPaths();// << std::endl; //->clearSolutionPaths()
-            (*pdef_itr)->getPlanner()->clear();
-        }
+void run_kcbs_benchmark(const InstanceFactory &make_instance, const double merge_bound, const double comp_time,
+    std::string filename, const BenchmarkOptions &options)
+{
+    std::vector<MultiRobotProblemDefinitionPtr> pdefs(std::max(options.workers_, 1u));
+    std::vector<double> set_up_times(pdefs.size());
+    const ResultsSinkPtr sink = results_sink(filename, options);
+    run_trials(options,
+        [&](const unsigned int w) {
+            const auto t0 = std::chrono::steady_clock::now();
+            pdefs[w] = set_up_kcbs(make_instance());
+            set_up_times[w] = elapsed(t0);
+            return pdefs[w];
+        },
+        [&](const MultiRobotProblemDefinitionPtr &mrmp_pdef, const BenchmarkTrial &trial) {
+            // create K-CBS instance
+            ob::PlannerPtr p(std::make_shared<oc::KCBS>(mrmp_pdef));
+            p->as<oc::KCBS>()->setMergeBound(merge_bound);
+            p->as<oc::KCBS>()->setSeed(trial_seed(trial));
+            // plan with K-CBS
+            bool solved = p->solve(comp_time);
+            // queue the result of the trial (with the performance counters of K-CBS)
+            ResultRow row = result_row(trial, *mrmp_pdef->getInstance(), solved, p->as<oc::KCBS>()->getComputationTime(),
+                p->as<oc::KCBS>()->getSolutionSOC());
+            row.add("Set-Up Time (s)", set_up_times[trial.worker_]);
+            add_kcbs_statistics(row, p->as<oc::KCBS>()->getStatistics(), trial);
+            add_trial(row, trial);
+            sink->write(std::move(row));
+            // clear memory
+            p.reset();
+            clear_trial(mrmp_pdef);
+        });
+    sink->flush();
+    for (const MultiRobotProblemDefinitionPtr &mrmp_pdef: pdefs) {
+        if (!mrmp_pdef)
+            continue;
+        if (CascadePVCPtr cascade = std::dynamic_pointer_cast<CascadePVC>(mrmp_pdef->getPlanValidator()))
+            cascade->printStats();
     }
 }
 
-void write_csv(std::string filename, std::tuple<bool, double, double> results)
+void run_centralized_bsst_benchmark(const po::variables_map &vm, const double comp_time, std::string filename,
+    const BenchmarkOptions &options)
 {
-    // Make a CSV file with one or more columns of integer values
-    std::ifstream infile(filename);
-    bool exist = infile.good();
-    infile.close();
-    if (!exist)
-    {
-        std::ofstream addHeads(filename);
-        addHeads << "Success (Boolean),Computation Time (s), Sum of Controls (double)" << std::endl;
-        addHeads.close();
-    }
-    std::ofstream stats(filename, std::ios::app);
-    stats << std::get<0>(results) << "," << std::get<1>(results) << "," << std::get<2>(results);
-    stats << std::endl;
+    run_centralized_bsst_benchmark([&vm]() {
+        po::variables_map worker_vm(vm);
+        return std::make_shared<Instance>(worker_vm);
+    }, comp_time, filename, options);
+}
+
+void run_centralized_bsst_benchmark(const InstanceFactory &make_instance, const double comp_time, std::string filename,
+    const BenchmarkOptions &options)
+{
+    std::vector<double> set_up_times(std::max(options.workers_, 1u));
+    const ResultsSinkPtr sink = results_sink(filename, options);
+    run_trials(options,
+        [&](const unsigned int w) {
+            const auto t0 = std::chrono::steady_clock::now();
+            InstancePtr mrmp_instance = make_instance();
+            // set-up low-level planners
+            std::vector<MotionPlanningProblemPtr> mp_problems = set_up_all_MP_Problems(mrmp_instance);
+            // set-up MRMP Problem Definition
+            MultiRobotProblemDefinitionPtr mrmp_pdef = std::make_shared<MultiRobotProblemDefinition>(mp_problems);
+            mrmp_pdef->setMultiRobotInstance(mrmp_instance);
+            set_up_times[w] = elapsed(t0);
+            return mrmp_pdef;
+        },
+        [&](const MultiRobotProblemDefinitionPtr &mrmp_pdef, const BenchmarkTrial &trial) {
+            // solve with CentralizedBSST instance
+            PlannerPtr p = mrmp_pdef->getRobotMotionPlanningProblemPtr(0)->getPlanner();
+            const perf::Counters c0 = perf::read();
+            bool solved = p->solve(comp_time);
+            const perf::Counters counters = perf::read() - c0;
+            // queue the result of the trial
+            ResultRow row = result_row(trial, *mrmp_pdef->getInstance(), solved,
+                p->as<oc::CentralizedBSST>()->getComputationTime(), p->as<oc::CentralizedBSST>()->getSolutionSOC());
+            row.add("Set-Up Time (s)", set_up_times[trial.worker_]);
+            if (options.kcbs_columns_)
+                add_kcbs_statistics(row, oc::KCBS::Statistics(), trial);
+            else if (trial.perf_counters_)
+                add_counters(row, "Solve", counters);
+            add_trial(row, trial);
+            sink->write(std::move(row));
+            // clear memory
+            clear_trial(mrmp_pdef);
+        });
+    sink->flush();
 }
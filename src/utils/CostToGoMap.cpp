@@ -0,0 +1,114 @@
+#include "utils/CostToGoMap.h"
+#include <ompl/util/Console.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+
+CostToGoMap::CostToGoMap(const InflatedObstacles &obstacles, const double x_low, const double x_high, const double y_low,
+    const double y_high, const double goal_x, const double goal_y, const double resolution):
+    x_low_(x_low), y_low_(y_low), res_(std::max(resolution, 1e-6))
+{
+    nx_ = std::max<long>(1, std::ceil((x_high - x_low) / res_));
+    ny_ = std::max<long>(1, std::ceil((y_high - y_low) / res_));
+    const double inf = std::numeric_limits<double>::infinity();
+    cost_.assign(nx_ * ny_, inf);
+
+    std::vector<bool> blocked(nx_ * ny_, false);
+    const std::vector<Polygon> &polys = obstacles.getPolygons();
+    for (long c = 0; c < nx_ * ny_; c++) {
+        const Point center(centerX_(c), centerY_(c));
+        blocked[c] = !obstacles.getGrid().forEachNear(center.x(), center.y(), 0.0, [&](const std::size_t o) {
+            return !bg::covered_by(center, polys[o]);
+        });
+    }
+
+    /* Dijkstra from the goal cell (even if it is blocked, the goal region may not be) */
+    const long goal = cell_(goal_x, goal_y);
+    if (goal < 0) {
+        OMPL_WARN("%s: The goal (%0.2f, %0.2f) is outside of the map.", "CostToGoMap", goal_x, goal_y);
+        return;
+    }
+    typedef std::pair<double, long> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    cost_[goal] = 0;
+    open.emplace(0, goal);
+    while (!open.empty()) {
+        const Entry e = open.top();
+        open.pop();
+        if (e.first > cost_[e.second])
+            continue;
+        reachable_.push_back(e.second);
+        const long i = e.second / ny_, j = e.second % ny_;
+        for (long di = -1; di <= 1; di++) {
+            for (long dj = -1; dj <= 1; dj++) {
+                if ((di == 0 && dj == 0) || i + di < 0 || i + di >= nx_ || j + dj < 0 || j + dj >= ny_)
+                    continue;
+                const long n = (i + di) * ny_ + (j + dj);
+                if (blocked[n])
+                    continue;
+                // no corner cutting: a diagonal move needs both of its side cells free
+                if (di != 0 && dj != 0 && (blocked[(i + di) * ny_ + j] || blocked[i * ny_ + (j + dj)]))
+                    continue;
+                const double c = e.first + ((di != 0 && dj != 0) ? M_SQRT2 : 1.0) * res_;
+                if (c < cost_[n]) {
+                    cost_[n] = c;
+                    open.emplace(c, n);
+                }
+            }
+        }
+    }
+}
+
+long CostToGoMap::cell_(const double x, const double y) const
+{
+    const double i = std::floor((x - x_low_) / res_);
+    const double j = std::floor((y - y_low_) / res_);
+    if (!(i >= 0 && i < nx_ && j >= 0 && j < ny_))
+        return -1;
+    return static_cast<long>(i) * ny_ + static_cast<long>(j);
+}
+
+double CostToGoMap::costToGo(const double x, const double y) const
+{
+    const long c = cell_(x, y);
+    return (c < 0) ? std::numeric_limits<double>::infinity() : cost_[c];
+}
+
+void CostToGoMap::sampleReachable(ompl::RNG &rng, double &x, double &y) const
+{
+    const long c = reachable_[rng.uniformInt(0, reachable_.size() - 1)];
+    x = centerX_(c) + res_ * (rng.uniform01() - 0.5);
+    y = centerY_(c) + res_ * (rng.uniform01() - 0.5);
+}
+
+bool CostToGoMap::ahead(const double x, const double y, const double distance, double &ax, double &ay) const
+{
+    long c = cell_(x, y);
+    if (c < 0 || !std::isfinite(cost_[c]))
+        return false;
+    const double target = std::max(0.0, cost_[c] - distance);
+    while (cost_[c] > target) {
+        // the neighbor of least cost (a finite neighbor of lower cost always exists, but for the goal)
+        const long i = c / ny_, j = c % ny_;
+        long best = c;
+        for (long di = -1; di <= 1; di++) {
+            for (long dj = -1; dj <= 1; dj++) {
+                if (i + di < 0 || i + di >= nx_ || j + dj < 0 || j + dj >= ny_)
+                    continue;
+                const long n = (i + di) * ny_ + (j + dj);
+                if (cost_[n] < cost_[best])
+                    best = n;
+            }
+        }
+        if (best == c)
+            break;
+        c = best;
+    }
+    ax = centerX_(c);
+    ay = centerY_(c);
+    return true;
+}
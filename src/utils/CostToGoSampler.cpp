@@ -0,0 +1,70 @@
+#include "utils/CostToGoSampler.h"
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <cmath>
+
+
+void CostToGoSampler::getPosition(const ob::StateSpace *space, const ob::State *st, double &x, double &y)
+{
+    // e.g. SE2: the x-y component comes first
+    const double *values = space->isCompound() ?
+        st->as<ob::CompoundStateSpace::StateType>()->as<ob::RealVectorStateSpace::StateType>(0)->values :
+        st->as<ob::RealVectorStateSpace::StateType>()->values;
+    x = values[0];
+    y = values[1];
+}
+
+void CostToGoSampler::setPosition(const ob::StateSpace *space, ob::State *st, const double x, const double y)
+{
+    double *values = space->isCompound() ?
+        st->as<ob::CompoundStateSpace::StateType>()->as<ob::RealVectorStateSpace::StateType>(0)->values :
+        st->as<ob::RealVectorStateSpace::StateType>()->values;
+    values[0] = x;
+    values[1] = y;
+}
+
+void CostToGoSampler::sample(ob::StateSampler &base, ompl::RNG &rng, const double bias, ob::State *st) const
+{
+    base.sampleUniform(st);
+    if (map_->empty())
+        return;
+    double x, y;
+    bool ahead = false;
+    if (bias > 0 && rng.uniform01() < bias) {
+        std::lock_guard<std::mutex> lock(frontier_mutex_);
+        ahead = std::isfinite(frontier_cost_) && map_->ahead(frontier_x_, frontier_y_, lookahead_, x, y);
+    }
+    if (ahead) {
+        // anywhere in the cell ahead
+        x += map_->getResolution() * (rng.uniform01() - 0.5);
+        y += map_->getResolution() * (rng.uniform01() - 0.5);
+    }
+    else
+        map_->sampleReachable(rng, x, y);
+    setPosition(space_.get(), st, x, y);
+}
+
+void CostToGoSampler::update(const ob::State *st)
+{
+    double x, y;
+    getPosition(space_.get(), st, x, y);
+    const double cost = map_->costToGo(x, y);
+    std::lock_guard<std::mutex> lock(frontier_mutex_);
+    if (cost < frontier_cost_) {
+        frontier_x_ = x;
+        frontier_y_ = y;
+        frontier_cost_ = cost;
+    }
+}
+
+void CostToGoSampler::reset()
+{
+    std::lock_guard<std::mutex> lock(frontier_mutex_);
+    frontier_cost_ = std::numeric_limits<double>::infinity();
+}
+
+double CostToGoSampler::costToGo(const ob::State *st) const
+{
+    double x, y;
+    getPosition(space_.get(), st, x, y);
+    return map_->costToGo(x, y);
+}
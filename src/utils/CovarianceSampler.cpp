@@ -0,0 +1,41 @@
+#include "utils/CovarianceSampler.h"
+#include "Spaces/RealVectorBeliefSpace.h"
+#include <algorithm>
+
+
+ReachableCovarianceSampler::ReachableCovarianceSampler(const oc::SpaceInformation *si, const ob::State *start,
+    const unsigned int horizon, const double tolerance): horizon_(std::max(horizon, 1u))
+{
+    const auto *belief = start->as<RealVectorBeliefSpace::StateType>();
+    sigmas_.emplace_back(belief->sigma_);
+    lambdas_.emplace_back(belief->lambda_);
+
+    oc::Control *control = si->allocControl();
+    si->nullControl(control);
+    ob::State *from = si->cloneState(start);
+    ob::State *to = si->allocState();
+    const double dt = si->getPropagationStepSize();
+    for (unsigned int k = 1; k < horizon_; k++) {
+        si->getStatePropagator()->propagate(from, control, dt, to);
+        const auto *next = to->as<RealVectorBeliefSpace::StateType>();
+        // converged: every later step has the last covariance
+        const double change = (next->sigma_ - sigmas_.back()).norm() + (next->lambda_ - lambdas_.back()).norm();
+        const double scale = sigmas_.back().norm() + lambdas_.back().norm();
+        if (change <= tolerance * std::max(scale, 1.0))
+            break;
+        sigmas_.emplace_back(next->sigma_);
+        lambdas_.emplace_back(next->lambda_);
+        std::swap(from, to);
+    }
+    si->freeState(from);
+    si->freeState(to);
+    si->freeControl(control);
+}
+
+void ReachableCovarianceSampler::sample(ompl::RNG &rng, ob::State *st) const
+{
+    const std::size_t k = std::min<std::size_t>(rng.uniformInt(0, horizon_ - 1), sigmas_.size() - 1);
+    auto *belief = st->as<RealVectorBeliefSpace::StateType>();
+    belief->sigma_ = sigmas_[k];
+    belief->lambda_ = lambdas_[k];
+}
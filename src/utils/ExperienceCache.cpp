@@ -0,0 +1,76 @@
+#include "utils/ExperienceCache.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+
+namespace
+{
+    double distance(const std::vector<double> &a, const std::vector<double> &b)
+    {
+        double d = 0;
+        for (std::size_t i = 0; i < std::min(a.size(), b.size()); i++)
+            d += (a[i] - b[i]) * (a[i] - b[i]);
+        return std::sqrt(d);
+    }
+}
+
+ExperienceCache::ExperienceCache(const std::size_t capacity): capacity_(std::max<std::size_t>(capacity, 1))
+{
+}
+
+std::shared_ptr<ExperienceCache> ExperienceCache::get(const std::string &key)
+{
+    static std::map<std::string, std::shared_ptr<ExperienceCache>> caches;
+    static std::mutex caches_mutex;
+    std::lock_guard<std::mutex> lock(caches_mutex);
+    std::shared_ptr<ExperienceCache> &cache = caches[key];
+    if (!cache)
+        cache = std::make_shared<ExperienceCache>();
+    return cache;
+}
+
+void ExperienceCache::add(Experience experience)
+{
+    const double same = 1e-6;
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (Experience &e: experiences_) {
+        if (distance(e.start_, experience.start_) < same && distance(e.end_, experience.end_) < same) {
+            if (experience.cost_ < e.cost_)
+                e = std::move(experience);
+            return;
+        }
+    }
+    experiences_.push_back(std::move(experience));
+    if (experiences_.size() > capacity_)
+        experiences_.pop_front();
+}
+
+std::vector<ExperienceCache::Experience> ExperienceCache::nearest(const std::vector<double> &start, const double radius, 
+    const std::size_t k, const std::function<double(const std::vector<double> &)> &goal_distance) const
+{
+    // copied out of the lock, goal_distance may be slow
+    std::vector<std::pair<double, Experience>> candidates;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        for (const Experience &e: experiences_) {
+            const double d = distance(e.start_, start);
+            if (d <= radius)
+                candidates.emplace_back(d, e);
+        }
+    }
+    for (auto &c: candidates)
+        c.first += goal_distance(c.second.end_);
+    std::stable_sort(candidates.begin(), candidates.end(), [](const auto &c1, const auto &c2) {return c1.first < c2.first;});
+    std::vector<Experience> nearest;
+    for (std::size_t i = 0; i < std::min(k, candidates.size()); i++)
+        nearest.push_back(std::move(candidates[i].second));
+    return nearest;
+}
+
+std::size_t ExperienceCache::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return experiences_.size();
+}
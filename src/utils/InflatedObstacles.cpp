@@ -0,0 +1,88 @@
+#include "utils/InflatedObstacles.h"
+#include <boost/geometry/algorithms/correct.hpp>
+
+
+InflatedObstacles::InflatedObstacles(const Polygon &bounding_shape, const std::vector<Obstacle*> &obstacles)
+{
+    polygons_.reserve(obstacles.size());
+    for (Obstacle* o: obstacles) {
+        Polygon obs_poly = o->getPolygon();
+        bg::correct(obs_poly);
+        polygons_.push_back(minkowskiSum(bounding_shape, obs_poly));
+    }
+    build_();
+}
+
+InflatedObstacles::InflatedObstacles(std::vector<Polygon> polygons): polygons_(std::move(polygons))
+{
+    build_();
+}
+
+void InflatedObstacles::build_()
+{
+    for (const Polygon &poly: polygons_) {
+        std::pair<Eigen::MatrixXd, Eigen::MatrixXd> half_plane_matrices = halfPlanes(poly);
+        half_planes_.add(half_plane_matrices.first, half_plane_matrices.second);
+        for (int i = 0; i < 4; i++) {
+            if (half_plane_matrices.first(i, 0) != 0 && half_plane_matrices.first(i, 1) != 0)
+                axis_aligned_ = false;
+        }
+    }
+    grid_ = ObstacleGrid(polygons_);
+}
+
+Polygon InflatedObstacles::minkowskiSum(const Polygon &shape1, const Polygon &shape2)
+{
+    std::vector<Point> shape1_points = bg::exterior_ring(shape1);
+    std::vector<Point> shape2_points = bg::exterior_ring(shape2);
+
+    shape1_points.push_back(shape1_points[1]);
+    shape2_points.push_back(shape2_points[1]);
+
+    // merge the edges of both polygons by their angle
+    std::vector<Point> result;
+    std::size_t i = 0, j = 0;
+    while (i < shape1_points.size() - 2 || j < shape2_points.size() - 2) {
+        result.push_back(Point(shape1_points[i].x() + shape2_points[j].x(), shape1_points[i].y() + shape2_points[j].y()));
+        const double e1x = shape1_points[i + 1].x() - shape1_points[i].x();
+        const double e1y = shape1_points[i + 1].y() - shape1_points[i].y();
+        const double e2x = shape2_points[j + 1].x() - shape2_points[j].x();
+        const double e2y = shape2_points[j + 1].y() - shape2_points[j].y();
+        const double cross = e1x * e2y - e1y * e2x;
+        if (cross >= 0)
+            ++i;
+        if (cross <= 0)
+            ++j;
+    }
+
+    result.push_back(result.front()); // make polygon closed
+
+    Polygon result_poly;
+    for (const Point &p: result)
+        bg::append(result_poly.outer(), p);
+    bg::correct(result_poly);
+    return result_poly;
+}
+
+std::pair<Eigen::MatrixXd, Eigen::MatrixXd> InflatedObstacles::halfPlanes(const Polygon &rectangle)
+{
+    auto exterior_points = bg::exterior_ring(rectangle);
+    if (exterior_points.size() != 5) {
+        OMPL_WARN("%s: Generating Halfplanes currently supports closed rectangles. Please check the implementation.", "InflatedObstacles");
+    }
+    Eigen::MatrixXd A = Eigen::MatrixXd::Zero(4, 2);
+    Eigen::MatrixXd B = Eigen::MatrixXd::Zero(4, 1);
+    for (std::size_t i = 0; i + 1 < exterior_points.size() && i < 4; i++) {
+        const double x1 = bg::get<0>(exterior_points[i]);
+        const double y1 = bg::get<1>(exterior_points[i]);
+        const double x2 = bg::get<0>(exterior_points[i + 1]);
+        const double y2 = bg::get<1>(exterior_points[i + 1]);
+
+        const double a = y2 - y1;
+        const double b = x1 - x2;
+        A(i, 0) = a;
+        A(i, 1) = b;
+        B(i, 0) = a * x1 + b * y1;
+    }
+    return std::make_pair(A, B);
+}
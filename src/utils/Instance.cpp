@@ -1,7 +1,89 @@
 #include "utils/Instance.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <sstream>
+#include <string_view>
 
 
-Instance::Instance(po::variables_map &vm, std::string name): 
+namespace
+{
+    /* the lines of a file read at once, viewed without copying them */
+    class Lines
+    {
+    public:
+        Lines(const std::string &text): text_(text) {}
+
+        bool next(std::string_view &line)
+        {
+            if (pos_ >= text_.size())
+                return false;
+            std::size_t end = text_.find('\n', pos_);
+            if (end == std::string::npos)
+                end = text_.size();
+            line = std::string_view(text_).substr(pos_, end - pos_);
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            pos_ = end + 1;
+            return true;
+        }
+
+    private:
+        const std::string &text_;
+        std::size_t pos_{0};
+    };
+
+    /* the non-empty fields of line between separators */
+    void split(const std::string_view line, const char sep, std::vector<std::string_view> &fields)
+    {
+        fields.clear();
+        std::size_t begin = 0;
+        while (begin <= line.size()) {
+            std::size_t end = line.find(sep, begin);
+            if (end == std::string_view::npos)
+                end = line.size();
+            if (end > begin)
+                fields.push_back(line.substr(begin, end - begin));
+            begin = end + 1;
+        }
+    }
+
+    int to_int(const std::string_view s)
+    {
+        int value = 0;
+        std::from_chars(s.data(), s.data() + s.size(), value);
+        return value;
+    }
+}
+
+
+Instance::Instance(po::variables_map &vm, std::string name):
+    Instance(vm, name, Unchecked())
+{
+    if (!loaded_)
+        exit(-1);
+}
+
+Instance::Instance(const Instance &map_instance, po::variables_map &vm, std::string name):
+    Instance(map_instance, vm, name, Unchecked())
+{
+    if (!loaded_)
+        exit(-1);
+}
+
+InstancePtr Instance::load(po::variables_map &vm, std::string name)
+{
+    InstancePtr instance(new Instance(vm, name, Unchecked()));
+    return instance->loaded_ ? instance : nullptr;
+}
+
+InstancePtr Instance::load(const Instance &map_instance, po::variables_map &vm, std::string name)
+{
+    InstancePtr instance(new Instance(map_instance, vm, name, Unchecked()));
+    return instance->loaded_ ? instance : nullptr;
+}
+
+Instance::Instance(po::variables_map &vm, std::string name, Unchecked): 
     name_(name), 
     mrmp_planner_(vm["solver"].as<std::string>()),
     low_level_planner_(vm["lowlevel"].as<std::string>()),
@@ -11,18 +93,55 @@ Instance::Instance(po::variables_map &vm, std::string name):
     scen_fpath_(vm["scen"].as<std::string>()),
     p_safe_(vm["p_safe"].as<double>()),
     pvc_(vm["pvc"].as<std::string>()),
-    svc_(vm["svc"].as<std::string>())
+    svc_(vm["svc"].as<std::string>()),
+    sdf_res_(vm["sdfres"].as<double>()),
+    map_cache_dir_(vm.count("mapcache") ? vm["mapcache"].as<std::string>() : ""),
+    seed_(vm.count("seed") ? vm["seed"].as<std::uint32_t>() : 0),
+    experience_(vm.count("experience") ? vm["experience"].as<bool>() : false)
 {
-    bool succ = load_map_();
-    if (!succ) {
+    std::string map_contents;
+    CachedMap cached;
+    if (!load_map_(map_contents, cached)) {
         OMPL_ERROR("%s: Unable to load map.", name_.c_str());
-        exit(-1);
+        return;
     }
-    succ = load_agents_();
-    if (!succ) {
+    if (!load_agents_()) {
         OMPL_ERROR("%s: Unable to load scen file.", name_.c_str());
-        exit(-1);
+        return;
     }
+    if (!map_cache_dir_.empty())
+        cache_map_(map_contents, cached);
+    split_p_safe_();
+    loaded_ = true;
+}
+
+Instance::Instance(const Instance &map_instance, po::variables_map &vm, std::string name, Unchecked):
+    name_(name),
+    mrmp_planner_(vm["solver"].as<std::string>()),
+    low_level_planner_(vm["lowlevel"].as<std::string>()),
+    x_max_(map_instance.x_max_), y_max_(map_instance.y_max_),
+    num_agents_(vm["numAgents"].as<int>()),
+    map_fpath_(map_instance.map_fpath_),
+    scen_fpath_(vm["scen"].as<std::string>()),
+    p_safe_(vm["p_safe"].as<double>()),
+    pvc_(vm["pvc"].as<std::string>()),
+    svc_(vm["svc"].as<std::string>()),
+    sdf_res_(vm["sdfres"].as<double>()),
+    geometry_(map_instance.geometry_),
+    seed_(vm.count("seed") ? vm["seed"].as<std::uint32_t>() : 0),
+    experience_(vm.count("experience") ? vm["experience"].as<bool>() : false),
+    obstacles_(map_instance.obstacles_)
+{
+    if (!load_agents_()) {
+        OMPL_ERROR("%s: Unable to load scen file.", name_.c_str());
+        return;
+    }
+    split_p_safe_();
+    loaded_ = true;
+}
+
+void Instance::split_p_safe_()
+{
     if (mrmp_planner_ == "K-CBS") {
         // // divide p_coll amongst PVC & SVC
         // double obs_area = 0;
@@ -70,92 +189,227 @@ Instance::Instance(Instance &other):
     num_agents_(other.num_agents_),
     map_fpath_(other.map_fpath_),
     scen_fpath_(other.scen_fpath_),
-    p_safe_(other.p_safe_) 
+    p_safe_(other.p_safe_),
+    sdf_res_(other.sdf_res_),
+    geometry_(other.geometry_),
+    seed_(other.seed_),
+    experience_(other.experience_)
 {
     this->obstacles_ = other.obstacles_;
 }
 
-bool Instance::load_map_()
-{    
-    std::ifstream myfile(map_fpath_);
-    if (!myfile.is_open())
+std::shared_ptr<const SignedDistanceField> Instance::getDistanceField()
+{
+    std::lock_guard<std::mutex> lock(geometry_->mutex_);
+    std::shared_ptr<const SignedDistanceField> &sdf = geometry_->sdfs_[sdf_res_];
+    if (!sdf) {
+        // same bounds as the state spaces. The quadtree measures the cells without going through every obstacle
+        if (geometry_->occupancy_)
+            sdf = std::make_shared<SignedDistanceField>(*geometry_->occupancy_, -1, x_max_, -1, y_max_, sdf_res_);
+        else
+            sdf = std::make_shared<SignedDistanceField>(obstacles_, -1, x_max_, -1, y_max_, sdf_res_);
+        OMPL_INFORM("%s: Built the signed distance field of %d obstacles at resolution %0.3f.", name_.c_str(), obstacles_.size(), sdf->getResolution());
+    }
+    return sdf;
+}
+
+std::vector<double> Instance::shape_key_(const Robot *r)
+{
+    std::vector<double> key;
+    for (const Point &p: bg::exterior_ring(r->getBoundingShape())) {
+        key.push_back(p.x());
+        key.push_back(p.y());
+    }
+    return key;
+}
+
+std::shared_ptr<const InflatedObstacles> Instance::getInflatedObstacles(const Robot *r)
+{
+    // robots with the same bounding shape (e.g. all rectangles of a size) share their inflated obstacles
+    const std::vector<double> key = shape_key_(r);
+    std::lock_guard<std::mutex> lock(geometry_->mutex_);
+    std::shared_ptr<const InflatedObstacles> &inflated = geometry_->inflated_[key];
+    if (!inflated) {
+        auto cached = geometry_->cached_inflated_.find(key);
+        if (cached != geometry_->cached_inflated_.end())
+            inflated = std::make_shared<InflatedObstacles>(cached->second);
+        else
+            inflated = std::make_shared<InflatedObstacles>(r->getBoundingShape(), obstacles_);
+    }
+    return inflated;
+}
+
+std::shared_ptr<const CostToGoMap> Instance::getCostToGoMap(const Robot *r, const double resolution)
+{
+    std::shared_ptr<const InflatedObstacles> inflated = getInflatedObstacles(r);
+    std::lock_guard<std::mutex> lock(cost_to_go_mutex_);
+    std::shared_ptr<const CostToGoMap> &map = cost_to_go_[r->getId()];
+    if (!map) {
+        // over the bounds of the state spaces
+        map = std::make_shared<CostToGoMap>(*inflated, -1, x_max_, -1, y_max_, r->getGoalLocation().x_, r->getGoalLocation().y_, resolution);
+        if (map->empty())
+            OMPL_WARN("%s: The goal of robot %d is not reachable on the grid of the map.", name_.c_str(), r->getId());
+    }
+    return map;
+}
+
+ExperienceCachePtr Instance::getExperienceCache(const Robot *r) const
+{
+    if (!experience_)
+        return nullptr;
+    std::ostringstream key;
+    key << fs::absolute(map_fpath_).lexically_normal().string() << "|" << r->getDynamicsModel();
+    for (const double v: shape_key_(r))
+        key << "|" << v;
+    return ExperienceCache::get(key.str());
+}
+
+bool Instance::load_map_(std::string &contents, CachedMap &cached)
+{
+    if (!readFile(map_fpath_, contents))
         return false;
-    std::string line;
-    boost::tokenizer< boost::char_separator<char> >::iterator beg;
-    getline(myfile, line);
-    if (line[0] == 't') // standard benchmark
+    if (!map_cache_dir_.empty() && MapCache(map_cache_dir_).load(contents, cached)) {
+        x_max_ = cached.x_max_;
+        y_max_ = cached.y_max_;
+        obstacles_.reserve(cached.rectangles_.size());
+        for (const std::array<double, 4> &rect: cached.rectangles_)
+            obstacles_.emplace_back(new RectangularObstacle(rect[0], rect[1], rect[2], rect[3]));
+        build_occupancy_(cached.rectangles_);
+        std::lock_guard<std::mutex> lock(geometry_->mutex_);
+        geometry_->cached_inflated_ = cached.inflated_;
+        OMPL_INFORM("%s: Loaded %d obstacles (and %d inflated shapes) from the map cache.", name_.c_str(),
+            obstacles_.size(), cached.inflated_.size());
+        return true;
+    }
+
+    Lines lines(contents);
+    std::string_view line;
+    lines.next(line);
+    if (!line.empty() && line[0] == 't') // standard benchmark
     {
-        boost::char_separator<char> sep(" ");
-        getline(myfile, line);
-        boost::tokenizer< boost::char_separator<char> > tok(line, sep);
-        beg = tok.begin();
-        beg++;
-        y_max_ = atoi((*beg).c_str()); // read number of rows (i.e. y max value)
-        getline(myfile, line);
-        boost::tokenizer< boost::char_separator<char> > tok2(line, sep);
-        beg = tok2.begin();
-        beg++;
-        x_max_ = atoi((*beg).c_str()); // read number of cols (i.e. x max value)
-        getline(myfile, line); // skip "map"
-    }
-    assert((x_max_ > 0 && y_max_ > 0));
-    // getline(myfile, line);
-    int c = 0;
-    while (getline(myfile, line)) {
-        for (int r = 0; r < x_max_; r++) {
-            if (line[r] != '.') {
-                std::cout << r << "\t" << c << std::endl;
-                obstacles_.emplace_back(new RectangularObstacle(r, c, 1, 1));
+        // "height <rows>", "width <cols>", then "map"
+        lines.next(line);
+        y_max_ = to_int(line.substr(line.find(' ') + 1)); // read number of rows (i.e. y max value)
+        lines.next(line);
+        x_max_ = to_int(line.substr(line.find(' ') + 1)); // read number of cols (i.e. x max value)
+        lines.next(line); // skip "map"
+    }
+    if (x_max_ <= 0 || y_max_ <= 0) {
+        OMPL_ERROR("%s: ``%s`` has no height and width.", name_.c_str(), map_fpath_.c_str());
+        return false;
+    }
+    std::vector<std::vector<bool>> blocked;
+    blocked.reserve(y_max_);
+    while (lines.next(line)) {
+        blocked.emplace_back(x_max_, false);
+        for (int r = 0; r < x_max_ && r < line.size(); r++)
+            blocked.back()[r] = (line[r] != '.');
+    }
+    add_obstacles_(blocked, cached.rectangles_);
+    build_occupancy_(cached.rectangles_);
+    cached.x_max_ = x_max_;
+    cached.y_max_ = y_max_;
+    return true;
+}
+
+void Instance::cache_map_(const std::string &contents, CachedMap &cached)
+{
+    bool changed = cached.inflated_.empty();
+    for (const Robot *r: robots_) {
+        // point robots have no bounding shape
+        const std::vector<double> key = shape_key_(r);
+        if (key.empty())
+            continue;
+        std::vector<Polygon> &polygons = cached.inflated_[key];
+        if (polygons.empty() && !obstacles_.empty()) {
+            polygons = getInflatedObstacles(r)->getPolygons();
+            changed = true;
+        }
+    }
+    if (changed)
+        MapCache(map_cache_dir_).save(contents, cached);
+}
+
+void Instance::add_obstacles_(std::vector<std::vector<bool>> &blocked, std::vector<std::array<double, 4>> &rectangles)
+{
+    /* cover the blocked cells with few rectangles: grow each one along its row, then down the next rows */
+    const std::size_t num_before = obstacles_.size();
+    int num_blocked = 0;
+    for (int c = 0; c < blocked.size(); c++) {
+        for (int r = 0; r < blocked[c].size(); r++) {
+            if (!blocked[c][r])
+                continue;
+            int r_end = r;
+            while (r_end + 1 < blocked[c].size() && blocked[c][r_end + 1])
+                r_end++;
+            int c_end = c;
+            while (c_end + 1 < blocked.size() &&
+                std::all_of(blocked[c_end + 1].begin() + r, blocked[c_end + 1].begin() + r_end + 1, [](bool b) {return b;}))
+                c_end++;
+            for (int i = c; i <= c_end; i++) {
+                std::fill(blocked[i].begin() + r, blocked[i].begin() + r_end + 1, false);
+                num_blocked += (r_end - r + 1);
             }
+            // cell (r, c) is the unit square centered at (r, c)
+            const double len = r_end - r + 1;
+            const double width = c_end - c + 1;
+            rectangles.push_back({r + (len - 1) / 2, c + (width - 1) / 2, len, width});
+            obstacles_.emplace_back(new RectangularObstacle(rectangles.back()[0], rectangles.back()[1], len, width));
         }
-        c++; // pun intended...
     }
-    myfile.close();
-    return true;
+    OMPL_INFORM("%s: Merged %d blocked cells into %d obstacles.", name_.c_str(), num_blocked, obstacles_.size() - num_before);
+}
+
+void Instance::build_occupancy_(const std::vector<std::array<double, 4>> &rectangles)
+{
+    // the cells again from the rectangles, which are all that the map cache keeps of them
+    std::vector<std::vector<bool>> blocked(y_max_, std::vector<bool>(x_max_, false));
+    for (const std::array<double, 4> &rect: rectangles) {
+        const int x0 = std::lround(rect[0] - (rect[2] - 1) / 2);
+        const int y0 = std::lround(rect[1] - (rect[3] - 1) / 2);
+        for (int y = std::max(y0, 0); y < std::min<int>(y0 + rect[3], y_max_); y++) {
+            for (int x = std::max(x0, 0); x < std::min<int>(x0 + rect[2], x_max_); x++)
+                blocked[y][x] = true;
+        }
+    }
+    geometry_->occupancy_ = std::make_shared<OccupancyQuadtree>(blocked);
+    OMPL_INFORM("%s: Built the occupancy quadtree of the map (%zu leaves, depth %d).", name_.c_str(),
+        geometry_->occupancy_->numLeaves(), geometry_->occupancy_->getDepth());
 }
 
 bool Instance::load_agents_()
 {
-    std::ifstream myfile(scen_fpath_);
-    if (!myfile.is_open())
+    std::string contents;
+    if (!readFile(scen_fpath_, contents))
         return false;
-    std::string line;
-    getline(myfile, line);
+    Lines lines(contents);
+    std::string_view line;
+    lines.next(line); // skip the version
     if (num_agents_ == 0)
     {
         OMPL_ERROR("%s: The number of agents should be larger than 0", name_.c_str());
-        exit(-1);
+        return false;
     }
-    boost::char_separator<char> sep("\t");
+    // bucket, map, columns, rows, start, goal, shape and dynamics model, separated by tabs
+    std::vector<std::string_view> fields;
     for (int i = 0; i < num_agents_; i++)
     {
         // extract the start Location and goal Location for robot i
-        getline(myfile, line);
-        // std::cout << line << std::endl;
-        if (line.empty())
+        if (!lines.next(line) || line.empty())
+        {
+            OMPL_ERROR("%s: The instance has only %d robots.", name_.c_str(), i);
+            return false;
+        }
+        split(line, '\t', fields);
+        if (fields.size() < 10)
         {
-            OMPL_ERROR("%s: The instance has only %d robots.", (name_.c_str(), i));
-            exit(-1);
+            OMPL_ERROR("%s: Robot %d of the scen file has %zu of its 10 fields.", name_.c_str(), i, fields.size());
+            return false;
         }
-        boost::tokenizer< boost::char_separator<char> > tok(line, sep);
-        boost::tokenizer< boost::char_separator<char> >::iterator beg = tok.begin();
-        beg++; // skip the first number
-        beg++; // skip the map name
-        beg++; // skip the columns
-        beg++; // skip the rows
-        int row = atoi((*beg).c_str());
-        beg++;
-        int col = atoi((*beg).c_str());
-        Location start(row, col);
-        beg++;
-        row = atoi((*beg).c_str());
-        beg++;
-        col = atoi((*beg).c_str());
-        Location goal(row, col);
-        beg++;
-        std::string shape = std::string(*beg);
-        beg++;
-        std::string dyn_model = std::string(*beg);
+        Location start(to_int(fields[4]), to_int(fields[5]));
+        Location goal(to_int(fields[6]), to_int(fields[7]));
+        const std::string shape(fields[8]);
+        const std::string dyn_model(fields[9]);
 
         std::string name = "Robot " + std::to_string(i);
 
@@ -165,11 +419,11 @@ bool Instance::load_agents_()
         else if (shape == "Rectangle")
             robots_.emplace_back(new RectangularRobot(name, dyn_model, start, goal, 0.25, 0.25)); // manual size To-Do!
         else {
-            OMPL_WARN("%s: %sRobot class ``%s`` not yet implemented!", name_.c_str(), shape.c_str());
-            exit(-1);
+            OMPL_ERROR("%s: Robot class ``%s`` not yet implemented!", name_.c_str(), shape.c_str());
+            return false;
         }
+        robots_.back()->setId(i);
     }
-    myfile.close();
     return true;
 }
 
@@ -0,0 +1,198 @@
+#include "utils/Log.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace logging
+{
+	namespace
+	{
+		struct Record
+		{
+			ompl::msg::LogLevel level_;
+			const char *file_;
+			int line_;
+			std::string text_;
+		};
+
+		/* the messages of one thread not written yet. The writer swaps them out under the lock, which the thread only
+		   contends for with it */
+		struct ThreadBuffer
+		{
+			std::mutex mutex_;
+			std::vector<Record> records_;
+			std::atomic<bool> retired_{false};  // its thread exited, so nothing is added to it any more
+		};
+
+		/* the buffers of every live thread, and of the exited ones until their last messages are written */
+		class Writer
+		{
+		public:
+			Writer(): thread_(&Writer::work_, this) {}
+
+			~Writer()
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					stop_ = true;
+				}
+				cv_.notify_all();
+				thread_.join();
+				flush();
+			}
+
+			std::shared_ptr<ThreadBuffer> add()
+			{
+				auto b = std::make_shared<ThreadBuffer>();
+				std::lock_guard<std::mutex> lock(mutex_);
+				buffers_.push_back(b);
+				return b;
+			}
+
+			void flush()
+			{
+				std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+				std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					buffers = buffers_;
+				}
+				std::vector<ThreadBuffer *> retired;
+				for (const std::shared_ptr<ThreadBuffer> &b: buffers) {
+					// read before the records, so a retired buffer is dropped only once it was drained
+					if (b->retired_.load(std::memory_order_acquire))
+						retired.push_back(b.get());
+					{
+						std::lock_guard<std::mutex> lock(b->mutex_);
+						records_.swap(b->records_);
+					}
+					for (const Record &r: records_)
+						ompl::msg::log(r.file_, r.line_, r.level_, "%s", r.text_.c_str());
+					records_.clear();
+				}
+				// the workers of successive solves come and go, their buffers with them
+				if (!retired.empty()) {
+					std::lock_guard<std::mutex> lock(mutex_);
+					buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(), [&retired](const std::shared_ptr<ThreadBuffer> &b) {
+						return std::find(retired.begin(), retired.end(), b.get()) != retired.end();
+					}), buffers_.end());
+				}
+			}
+
+		private:
+			void work_()
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				while (!stop_) {
+					cv_.wait_for(lock, std::chrono::milliseconds(20));
+					lock.unlock();
+					flush();
+					lock.lock();
+				}
+			}
+
+			std::mutex mutex_;
+			std::condition_variable cv_;
+			bool stop_{false};
+			std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+			/* one flush at a time, through the records of the writer */
+			std::mutex flush_mutex_;
+			std::vector<Record> records_;
+			std::thread thread_;
+		};
+
+		Writer &writer()
+		{
+			static Writer w;
+			return w;
+		}
+
+		/* the buffer of a thread, retired when the thread exits. The writer still holds it until it is written, so
+		   the exit does not wait for the writer (which may already be gone at the exit of the process) */
+		struct ThreadHandle
+		{
+			ThreadHandle(): buffer_(writer().add()) {}
+
+			~ThreadHandle() {buffer_->retired_.store(true, std::memory_order_release);}
+
+			std::shared_ptr<ThreadBuffer> buffer_;
+		};
+
+		ThreadBuffer &threadBuffer()
+		{
+			thread_local ThreadHandle handle;
+			return *handle.buffer_;
+		}
+
+		std::atomic<int> cached_level{-1};
+
+		std::int64_t second()
+		{
+			return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+	}
+
+	bool Site::admit()
+	{
+		const std::int64_t now = second();
+		std::int64_t window = window_.load(std::memory_order_relaxed);
+		if (window != now && window_.compare_exchange_strong(window, now, std::memory_order_relaxed))
+			passed_.store(0, std::memory_order_relaxed);
+		if (passed_.fetch_add(1, std::memory_order_relaxed) < rate_limit_)
+			return true;
+		suppressed_.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	bool enabled(const ompl::msg::LogLevel level)
+	{
+		int cached = cached_level.load(std::memory_order_relaxed);
+		if (cached < 0) {
+			refreshLevel();
+			cached = cached_level.load(std::memory_order_relaxed);
+		}
+		return level >= cached;
+	}
+
+	void refreshLevel()
+	{
+		cached_level.store(ompl::msg::getLogLevel(), std::memory_order_relaxed);
+	}
+
+	std::string &threadMessage()
+	{
+		thread_local std::string message;
+		return message;
+	}
+
+	void submit(Site &site, const ompl::msg::LogLevel level)
+	{
+		std::string &s = threadMessage();
+		if (const std::uint64_t suppressed = site.takeSuppressed())
+			s += " suppressed=" + std::to_string(suppressed);
+		if (level >= ompl::msg::LOG_WARN) {
+			ompl::msg::log(site.file_, site.line_, level, "%s", s.c_str());
+			return;
+		}
+		ThreadBuffer &b = threadBuffer();
+		std::lock_guard<std::mutex> lock(b.mutex_);
+		b.records_.push_back({level, site.file_, site.line_, s});
+	}
+
+	void flush()
+	{
+		writer().flush();
+	}
+
+	void appendValue(std::string &s, const double v)
+	{
+		char buffer[32];
+		std::snprintf(buffer, sizeof(buffer), "%.6g", v);
+		s += buffer;
+	}
+}
@@ -0,0 +1,181 @@
+#include "utils/MapCache.h"
+#include <cstring>
+#include <sstream>
+#include <random>
+
+
+namespace
+{
+    const char magic[8] = {'K', 'C', 'B', 'S', 'M', 'A', 'P', '\0'};
+    const std::uint32_t version = 1;
+
+    /* sequential binary reads of a cache file, failing once past its end */
+    class Reader
+    {
+    public:
+        Reader(const std::string &data): data_(data) {}
+
+        template <typename T>
+        bool read(T &value)
+        {
+            if (pos_ + sizeof(T) > data_.size())
+                return false;
+            std::memcpy(&value, data_.data() + pos_, sizeof(T));
+            pos_ += sizeof(T);
+            return true;
+        }
+
+        bool readDoubles(double *values, const std::size_t n)
+        {
+            if (n > (data_.size() - pos_) / sizeof(double))
+                return false;
+            std::memcpy(values, data_.data() + pos_, n * sizeof(double));
+            pos_ += n * sizeof(double);
+            return true;
+        }
+
+    private:
+        const std::string &data_;
+        std::size_t pos_{0};
+    };
+
+    template <typename T>
+    void append(std::string &out, const T &value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+}
+
+MapCache::MapCache(fs::path directory): directory_(std::move(directory))
+{
+}
+
+std::uint64_t MapCache::hash(const std::string &contents)
+{
+    std::uint64_t h = 14695981039346656037ull;
+    for (const char c: contents) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+fs::path MapCache::file_(const std::uint64_t key) const
+{
+    std::ostringstream name;
+    name << std::hex << key << ".kcbsmap";
+    return directory_ / name.str();
+}
+
+bool MapCache::load(const std::string &contents, CachedMap &map) const
+{
+    const std::uint64_t key = hash(contents);
+    std::string data;
+    if (!readFile(file_(key), data))
+        return false;
+    Reader in(data);
+    char file_magic[8];
+    std::uint32_t file_version, reserved;
+    std::uint64_t file_key, file_size, num_rectangles;
+    if (!in.read(file_magic) || std::memcmp(file_magic, magic, sizeof(magic)) != 0 || !in.read(file_version) ||
+        file_version != version || !in.read(reserved) || !in.read(file_key) || file_key != key || !in.read(file_size) ||
+        file_size != contents.size())
+        return false;
+    CachedMap cached;
+    // counts are checked against the size of the file before anything is allocated for them
+    if (!in.read(cached.x_max_) || !in.read(cached.y_max_) || !in.read(num_rectangles) || num_rectangles > data.size())
+        return false;
+    cached.rectangles_.resize(num_rectangles);
+    if (!in.readDoubles(reinterpret_cast<double *>(cached.rectangles_.data()), 4 * num_rectangles))
+        return false;
+    std::uint32_t num_shapes;
+    if (!in.read(num_shapes))
+        return false;
+    for (std::uint32_t s = 0; s < num_shapes; s++) {
+        std::uint32_t key_size, num_polygons;
+        if (!in.read(key_size) || key_size > data.size())
+            return false;
+        std::vector<double> shape(key_size);
+        if (!in.readDoubles(shape.data(), key_size) || !in.read(num_polygons) || num_polygons > data.size())
+            return false;
+        std::vector<Polygon> &polygons = cached.inflated_[shape];
+        polygons.resize(num_polygons);
+        for (Polygon &poly: polygons) {
+            std::uint32_t num_points;
+            if (!in.read(num_points) || num_points > data.size())
+                return false;
+            std::vector<double> xy(2 * num_points);
+            if (!in.readDoubles(xy.data(), xy.size()))
+                return false;
+            for (std::uint32_t p = 0; p < num_points; p++)
+                bg::append(poly.outer(), Point(xy[2 * p], xy[2 * p + 1]));
+        }
+    }
+    map = std::move(cached);
+    return true;
+}
+
+bool MapCache::save(const std::string &contents, const CachedMap &map) const
+{
+    const std::uint64_t key = hash(contents);
+    std::string data;
+    data.append(magic, sizeof(magic));
+    append(data, version);
+    append(data, std::uint32_t(0));
+    append(data, key);
+    append(data, std::uint64_t(contents.size()));
+    append(data, map.x_max_);
+    append(data, map.y_max_);
+    append(data, std::uint64_t(map.rectangles_.size()));
+    for (const std::array<double, 4> &rect: map.rectangles_)
+        data.append(reinterpret_cast<const char *>(rect.data()), sizeof(rect));
+    append(data, std::uint32_t(map.inflated_.size()));
+    for (const auto &shape: map.inflated_) {
+        append(data, std::uint32_t(shape.first.size()));
+        data.append(reinterpret_cast<const char *>(shape.first.data()), shape.first.size() * sizeof(double));
+        append(data, std::uint32_t(shape.second.size()));
+        for (const Polygon &poly: shape.second) {
+            append(data, std::uint32_t(poly.outer().size()));
+            for (const Point &p: poly.outer()) {
+                append(data, p.x());
+                append(data, p.y());
+            }
+        }
+    }
+
+    // written aside and renamed over the cache file, so a concurrent load reads the old file or the new one
+    std::error_code ec;
+    fs::create_directories(directory_, ec);
+    const fs::path file = file_(key);
+    std::ostringstream tmp_name;
+    tmp_name << file.filename().string() << "." << std::random_device()() << ".tmp";
+    const fs::path tmp = directory_ / tmp_name.str();
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+        if (!out) {
+            OMPL_WARN("%s: Unable to write ``%s``.", "MapCache", tmp.c_str());
+            return false;
+        }
+    }
+    fs::rename(tmp, file, ec);
+    if (ec) {
+        OMPL_WARN("%s: Unable to write ``%s``: %s", "MapCache", file.c_str(), ec.message().c_str());
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+bool readFile(const fs::path &filename, std::string &contents)
+{
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    if (!in.is_open())
+        return false;
+    const std::streamsize size = in.tellg();
+    if (size < 0)
+        return false;
+    contents.resize(size);
+    in.seekg(0);
+    return static_cast<bool>(in.read(&contents[0], size));
+}
@@ -1,4 +1,5 @@
 #include "utils/MultiRobotProblemDefinition.h"
+#include <cmath>
 
 
 MotionPlanningProblem::MotionPlanningProblem(const oc::SpaceInformationPtr si, const ob::ProblemDefinitionPtr pdef, const PlannerPtr planner):
@@ -38,6 +39,8 @@ void MultiRobotProblemDefinition::replacePlanner(PlannerPtr old_planner, const i
         planner->as<oc::ConstraintRespectingBSST>()->setProblemDefinition(pdef);
         planner->as<oc::ConstraintRespectingBSST>()->setPlanValidator(validator_);
         planner->as<oc::ConstraintRespectingBSST>()->setup();
+        if (auto *old_bsst = dynamic_cast<oc::ConstraintRespectingBSST *>(old_planner.get()))
+            planner->as<oc::ConstraintRespectingBSST>()->setExperienceCache(old_bsst->getExperienceCache());
         mrmp_problem_[idx]->replacePlanner(planner);
 	}
 	else {
@@ -45,6 +48,45 @@ void MultiRobotProblemDefinition::replacePlanner(PlannerPtr old_planner, const i
 	}
 }
 
+PlannerPtr MultiRobotProblemDefinition::clonePlanner(const int idx)
+{
+	return clonePlanner(idx, mrmp_instance_->getLowLevelPlannerName(), {});
+}
+
+PlannerPtr MultiRobotProblemDefinition::clonePlanner(const int idx, const std::string &ll_solver, 
+	const std::map<std::string, std::string> &params)
+{
+	// create a planner that shares no mutable state with the planner of robot idx
+	// the space information is shared, but the problem definition (and its solutions) is copied
+	auto si = getRobotSpaceInformationPtr(idx);
+	ob::ProblemDefinitionPtr pdef = getRobotProblemDefinitionPtr(idx)->clone();
+	pdef->clearSolutionPaths();
+	PlannerPtr planner = nullptr;
+	if (ll_solver == "BSST")
+		planner = std::make_shared<oc::ConstraintRespectingBSST>(si);
+	else if (ll_solver == "RRT")
+		planner = std::make_shared<oc::ConstraintRespectingRRT>(si);
+	else {
+		OMPL_ERROR("%s: You must add the ability to clone a %s planner!", "MultiRobotProblemDefinition", ll_solver.c_str());
+		return planner;
+	}
+	// keep the tuning of the original planner (the parameters it shares with this one)
+	std::map<std::string, std::string> tuning;
+	mrmp_problem_[idx]->getPlanner()->params().getParams(tuning);
+	planner->params().setParams(tuning, true);
+	if (!params.empty() && !planner->params().setParams(params))
+		OMPL_WARN("%s: Not every parameter applies to a %s planner.", "MultiRobotProblemDefinition", ll_solver.c_str());
+	planner->setProblemDefinition(pdef);
+	planner->as<ConstraintRespectingPlanner>()->setPlanValidator(validator_);
+	planner->setup();
+	// and its experience
+	auto *bsst = dynamic_cast<oc::ConstraintRespectingBSST *>(planner.get());
+	auto *original = dynamic_cast<oc::ConstraintRespectingBSST *>(mrmp_problem_[idx]->getPlanner().get());
+	if (bsst && original)
+		bsst->setExperienceCache(original->getExperienceCache());
+	return planner;
+}
+
 void MultiRobotProblemDefinition::setMultiRobotInstance(InstancePtr &mrmp_instance)
 {
 	mrmp_instance_ = mrmp_instance;
@@ -82,3 +124,19 @@ const MotionPlanningProblemPtr MultiRobotProblemDefinition::getRobotMotionPlanni
 {
 	return mrmp_problem_[idx];
 }
+
+double MultiRobotProblemDefinition::getCostLowerBound(const int idx)
+{
+	const MotionPlanningProblemPtr &mp = mrmp_problem_[idx];
+	if (mp->getMaxSpeed() <= 0 || !mrmp_instance_ || idx >= mrmp_instance_->getRobots().size())
+		return 0;
+	const Robot *robot = mrmp_instance_->getRobots()[idx];
+	const std::shared_ptr<const CostToGoMap> map = mrmp_instance_->getCostToGoMap(robot);
+	const double cost_to_go = map->costToGo(robot->getStartLocation().x_, robot->getStartLocation().y_);
+	if (!std::isfinite(cost_to_go))
+		return 0;
+	/* an 8-connected path is at most sqrt(4 - 2 sqrt(2)) times longer than the straight line between its cells, and the 
+	   start and goal are up to half a cell diagonal from the centers of theirs */
+	const double length = cost_to_go / std::sqrt(4 - 2 * std::sqrt(2.0)) - std::sqrt(2.0) * map->getResolution() - mp->getGoalRadius();
+	return std::max(0.0, length / mp->getMaxSpeed());
+}
@@ -0,0 +1,151 @@
+#include "utils/OccupancyQuadtree.h"
+#include <boost/geometry/algorithms/disjoint.hpp>
+#include <boost/geometry/algorithms/envelope.hpp>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+
+namespace
+{
+    double box_distance(const OccupancyQuadtree::Box &b, const double x, const double y)
+    {
+        const double dx = std::max({0.0, b.x_min_ - x, x - b.x_max_});
+        const double dy = std::max({0.0, b.y_min_ - y, y - b.y_max_});
+        return std::sqrt(dx * dx + dy * dy);
+    }
+}
+
+OccupancyQuadtree::OccupancyQuadtree(const std::vector<std::vector<bool>> &blocked)
+{
+    const long height = blocked.size();
+    long width = 0;
+    for (const std::vector<bool> &row: blocked)
+        width = std::max<long>(width, row.size());
+    if (width == 0 || height == 0)
+        return;
+
+    // blocked cells of every region in constant time, from the summed-area table
+    std::vector<std::uint32_t> sums((width + 1) * (height + 1), 0);
+    for (long y = 0; y < height; y++) {
+        for (long x = 0; x < width; x++) {
+            const bool b = x < static_cast<long>(blocked[y].size()) && blocked[y][x];
+            sums[(y + 1) * (width + 1) + x + 1] = b + sums[y * (width + 1) + x + 1] + sums[(y + 1) * (width + 1) + x] -
+                sums[y * (width + 1) + x];
+        }
+    }
+    auto count = [&](const long x0, const long y0, const long x1, const long y1) -> long {
+        // cells [x0, x1) x [y0, y1), clipped to the map
+        const long a = std::min(x0, width), b = std::min(y0, height), c = std::min(x1, width), d = std::min(y1, height);
+        if (a >= c || b >= d)
+            return 0;
+        return static_cast<long>(sums[d * (width + 1) + c]) - sums[b * (width + 1) + c] - sums[d * (width + 1) + a] +
+            sums[b * (width + 1) + a];
+    };
+    blocked_cells_ = count(0, 0, width, height);
+
+    long size = 1;
+    while (size < std::max(width, height)) {
+        size *= 2;
+        depth_++;
+    }
+    // breadth first, so the 4 children of a node are consecutive
+    nodes_.push_back({0, 0, static_cast<std::int32_t>(size), 0, MIXED});
+    for (std::size_t i = 0; i < nodes_.size(); i++) {
+        const Node n = nodes_[i];
+        const long b = count(n.x_, n.y_, n.x_ + n.size_, n.y_ + n.size_);
+        const long cells = static_cast<long>(n.size_) * n.size_;
+        if (b == 0 || b == cells) {
+            nodes_[i].occupancy_ = (b == 0) ? FREE : BLOCKED;
+            leaves_++;
+            continue;
+        }
+        nodes_[i].children_ = nodes_.size();
+        const std::int32_t half = n.size_ / 2;
+        for (std::int32_t c = 0; c < 4; c++)
+            nodes_.push_back({n.x_ + (c % 2) * half, n.y_ + (c / 2) * half, half, 0, MIXED});
+    }
+}
+
+bool OccupancyQuadtree::blocked(const double x, const double y) const
+{
+    return !nodes_.empty() && occupancy({x, y, x, y}) != FREE;
+}
+
+OccupancyQuadtree::Occupancy OccupancyQuadtree::occupancy(const Box &box) const
+{
+    if (nodes_.empty())
+        return FREE;
+    const Box root = box_(nodes_[0]);
+    bool free = (box.x_min_ < root.x_min_ || box.y_min_ < root.y_min_ || box.x_max_ > root.x_max_ || box.y_max_ > root.y_max_);
+    bool blocked = false;
+    std::uint32_t stack[MAX_STACK_];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0 && !(free && blocked)) {
+        const Node &n = nodes_[stack[--top]];
+        if (!meets_(n, box))
+            continue;
+        if (n.occupancy_ == MIXED) {
+            for (std::uint32_t c = 0; c < 4; c++)
+                stack[top++] = n.children_ + c;
+            continue;
+        }
+        // a leaf the box only touches does not make it free
+        const Box b = box_(n);
+        const bool inner = b.x_min_ < box.x_max_ && b.x_max_ > box.x_min_ && b.y_min_ < box.y_max_ && b.y_max_ > box.y_min_;
+        if (n.occupancy_ == BLOCKED)
+            blocked = true;
+        else if (inner)
+            free = true;
+    }
+    if (!blocked)
+        return FREE;
+    return free ? MIXED : BLOCKED;
+}
+
+bool OccupancyQuadtree::disjoint(const Polygon &shape) const
+{
+    bg::model::box<Point> envelope;
+    bg::envelope(shape, envelope);
+    const Box box{envelope.min_corner().x(), envelope.min_corner().y(), envelope.max_corner().x(),
+        envelope.max_corner().y()};
+    return forEachBlocked(box, [&shape](const Box &leaf) {
+        return bg::disjoint(shape, bg::model::box<Point>(Point(leaf.x_min_, leaf.y_min_), Point(leaf.x_max_, leaf.y_max_)));
+    });
+}
+
+double OccupancyQuadtree::signedDistance(const double x, const double y) const
+{
+    if (empty())
+        return std::numeric_limits<double>::infinity();
+    if (!blocked(x, y))
+        return nearest_(x, y, BLOCKED);
+    // the cells beyond the tree are free too
+    const Box root = box_(nodes_[0]);
+    const double outside = std::min({x - root.x_min_, root.x_max_ - x, y - root.y_min_, root.y_max_ - y});
+    return -std::min(outside, nearest_(x, y, FREE));
+}
+
+double OccupancyQuadtree::nearest_(const double x, const double y, const Occupancy occupancy) const
+{
+    // best first: the distance to the box of a node bounds those of its leaves, and is exact for a leaf
+    typedef std::pair<double, std::uint32_t> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    open.push({box_distance(box_(nodes_[0]), x, y), 0});
+    while (!open.empty()) {
+        const Entry e = open.top();
+        open.pop();
+        const Node &n = nodes_[e.second];
+        if (n.occupancy_ == occupancy)
+            return e.first;
+        if (n.occupancy_ != MIXED)
+            continue;
+        for (std::uint32_t c = 0; c < 4; c++)
+            open.push({box_distance(box_(nodes_[n.children_ + c]), x, y), n.children_ + c});
+    }
+    return std::numeric_limits<double>::infinity();
+}
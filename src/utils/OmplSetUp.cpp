@@ -1,30 +1,39 @@
 #include "utils/OmplSetUp.h"
+#include "utils/TaskRuntime.h"
+#include <atomic>
+#include <cmath>
+#include <chrono>
+#include <thread>
 
 // this function sets-up an ompl planning problem for an arbtrary number of agents
 // returns planners to be used
 std::vector<MotionPlanningProblemPtr> set_up_all_MP_Problems(InstancePtr mrmp_instance)
 {
     OMPL_INFORM("%s: Setting up planning problem for all agents.", "OMPL Set-Up");
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<MotionPlanningProblemPtr> prob_defs;
     std::string mrmp_solver = mrmp_instance->getPlannerName();
     std::string ll_solver = mrmp_instance->getLowLevelPlannerName();
     if (mrmp_solver == "K-CBS" || mrmp_solver == "PBS") {
         if (ll_solver == "RRT") {
-            return set_up_ConstraintRRT_MP_Problems(mrmp_instance);
+            prob_defs = set_up_ConstraintRRT_MP_Problems(mrmp_instance);
         }
         else if (ll_solver == "BSST") {
-            return set_up_ConstraintBSST_MP_Problems(mrmp_instance);
+            prob_defs = set_up_ConstraintBSST_MP_Problems(mrmp_instance);
         }
     }
     else if (mrmp_solver == "MR-RRT") {
-        return set_up_MultiRobotRRT_MP_Problem(mrmp_instance);
+        prob_defs = set_up_MultiRobotRRT_MP_Problem(mrmp_instance);
     }
     else if (mrmp_solver == "CentralizedBSST") {
-        return set_up_CentralizedBSST_Problem(mrmp_instance);
+        prob_defs = set_up_CentralizedBSST_Problem(mrmp_instance);
     }
     else {
         OMPL_ERROR("%s: %s is not yet implemented for MRMP.", "OMPL Set-Up", mrmp_solver.c_str());
     }
-    return {};
+    OMPL_INFORM("%s: Set-up took %.3f seconds.", "OMPL Set-Up",
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    return prob_defs;
 }
 
 std::vector<MotionPlanningProblemPtr> set_up_ConstraintRRT_MP_Problems(InstancePtr mrmp_instance)
@@ -63,10 +72,14 @@ std::vector<MotionPlanningProblemPtr> set_up_ConstraintRRT_MP_Problems(InstanceP
             // construct (and include) an instance of PCCBlackmore State Validity Checker
             si->setStateValidityChecker(std::make_shared<RealVectorStateSpaceSVC>(si, mrmp_instance, (*itr)));
     
-            // construct (and include) an instance of 2D-Uncertain-Linear State Propogator
+            // construct (and include) the propagator of the car (the ODE solver if built with KCBS_ODE_CARS)
+#ifdef KCBS_ODE_CARS
             auto odeSolver(std::make_shared<oc::ODEBasicSolver<>>(si, &FirstOrderCarODE));
             si->setStatePropagator(oc::ODESolver::getStatePropagator(odeSolver, 
                 &FirstOrderCarODEPostIntegration));
+#else
+            si->setStatePropagator(std::make_shared<FirstOrderCarStatePropagator>(si));
+#endif
             // assume that planner integrates dynamics at steps of 0.1 seconds
             si->setPropagationStepSize(stepSize);
             si->setMinMaxControlDuration(1, 10);
@@ -130,10 +143,14 @@ std::vector<MotionPlanningProblemPtr> set_up_ConstraintRRT_MP_Problems(InstanceP
             // construct (and include) an instance of PCCBlackmore State Validity Checker
             si->setStateValidityChecker(std::make_shared<RealVectorStateSpaceSVC>(si, mrmp_instance, (*itr)));
     
-            // construct (and include) an instance of 2D-Uncertain-Linear State Propogator
+            // construct (and include) the propagator of the car (the ODE solver if built with KCBS_ODE_CARS)
+#ifdef KCBS_ODE_CARS
             auto odeSolver(std::make_shared<oc::ODEBasicSolver<>>(si, &SecondOrderCarODE));
             si->setStatePropagator(oc::ODESolver::getStatePropagator(odeSolver, 
                 &SecondOrderCarODEPostIntegration));
+#else
+            si->setStatePropagator(std::make_shared<SecondOrderCarStatePropagator>(si));
+#endif
             // assume that planner integrates dynamics at steps of 0.1 seconds
             si->setPropagationStepSize(stepSize);
             si->setMinMaxControlDuration(1, 10);
@@ -180,174 +197,202 @@ std::vector<MotionPlanningProblemPtr> set_up_ConstraintRRT_MP_Problems(InstanceP
     return prob_defs;
 }
 
-std::vector<MotionPlanningProblemPtr> set_up_ConstraintBSST_MP_Problems(InstancePtr mrmp_instance)
+// the planning problem (and BSST planner) of a single robot, or nullptr if its dynamics are not implemented
+static MotionPlanningProblemPtr set_up_ConstraintBSST_MP_Problem(InstancePtr mrmp_instance, Robot *robot)
 {
     const double goalTollorance = 2.0;
     const double stepSize = 0.2; // 0.15
-    
-    std::vector<MotionPlanningProblemPtr> prob_defs{};
-
-    std::vector<Robot*> robots= mrmp_instance->getRobots();
-    for (auto itr = robots.begin(); itr != robots.end(); itr++) {
-        if ((*itr)->getDynamicsModel() == "2D-Uncertain-Linear-Model") {
-            // set-up 2D Belief Space
-            ob::StateSpacePtr space = ob::StateSpacePtr(new RealVectorBeliefSpace(2));
-            ob::RealVectorBounds bounds_se2(2);
-            bounds_se2.setLow(0, -1);
-            bounds_se2.setHigh(0, mrmp_instance->getDimensions()[0]);
-            bounds_se2.setLow(1, -1);
-            bounds_se2.setHigh(1, mrmp_instance->getDimensions()[1]);
-            space->as<RealVectorBeliefSpace>()->setBounds(bounds_se2);
-
-            // set-up the real vector control space
-            auto cspace(std::make_shared<oc::RealVectorControlSpace>(space, 2));
-            ob::RealVectorBounds c_bounds(2);
-            c_bounds.setLow(-1.0);  // this was [-100.0, 100.0]!
-            c_bounds.setHigh(1.0);
-            cspace->setBounds(c_bounds);
-
-            // construct an instance of space information from this state/control space
-            auto si(std::make_shared<oc::SpaceInformation>(space, cspace));
-
-            // construct (and include) an instance of PCCBlackmore State Validity Checker
-            if (mrmp_instance->getSVC() == "Blackmore") {
-                si->setStateValidityChecker(std::make_shared<PCCBlackmoreSVC>(si, mrmp_instance, (*itr), mrmp_instance->getPsafeObs()));
-            }
-            else if (mrmp_instance->getSVC() == "AdaptiveBlackmore") {
-                si->setStateValidityChecker(std::make_shared<AdaptiveRiskBlackmoreSVC>(si, mrmp_instance, (*itr), mrmp_instance->getPsafeObs()));
-            }
-            else if (mrmp_instance->getSVC() == "ChiSquared") {
-                // si->setStateValidityChecker(std::make_shared<ChiSquaredBoundarySVC>(si, mrmp_instance, (*itr), mrmp_instance->getPsafeObs()));
-                si->setStateValidityChecker(std::make_shared<ChiSquaredBoundarySVC>(si, mrmp_instance, (*itr), 0.9));
-            }
-
-            si->setPropagationStepSize(stepSize);
-            si->setMinMaxControlDuration(1, 10);
-            
-            // construct (and include) an instance of 2D-Uncertain-Linear State Propogator
-            si->setStatePropagator(oc::StatePropagatorPtr(new R2_UncertainLinearStatePropagator(si)));
 
-            si->setup();
-
-            ob::State *start = si->allocState();
-            start->as<RealVectorBeliefSpace::StateType>()->values[0] = (*itr)->getStartLocation().x_;
-            start->as<RealVectorBeliefSpace::StateType>()->values[1] = (*itr)->getStartLocation().y_;
-            Eigen::MatrixXd Sigma0 = 0.01 * Eigen::MatrixXd::Identity(2, 2);
-            start->as<RealVectorBeliefSpace::StateType>()->sigma_ = Sigma0;
-
-            // // create goal
-            ob::GoalPtr goal(new ChanceConstrainedGoal(si, (*itr)->getGoalLocation(), goalTollorance, 0.95));
-
-            // create a problem instance
-            auto pdef(std::make_shared<ob::ProblemDefinition>(si));
-
-            // set the start and goal states
-            pdef->addStartState(start);
-            pdef->setGoal(goal);
-
-            // set optimization objective
-            pdef->setOptimizationObjective(getEuclideanPathLengthObjective(si));
-
-            // // create (and provide) the low-level motion planner object
-            PlannerPtr planner(std::make_shared<oc::ConstraintRespectingBSST>(si));
-            // ConstraintRespectingPlannerPtr planner(std::make_shared<oc::ConstraintRespectingBSST>(si));
-            planner->as<oc::ConstraintRespectingBSST>()->setProblemDefinition(pdef);
-            planner->as<oc::ConstraintRespectingBSST>()->setup();
-
-            // append to MRMP problem list
-            auto mp = std::make_shared<MotionPlanningProblem>(si, pdef, planner);
-            prob_defs.push_back(mp);
+    if (robot->getDynamicsModel() == "2D-Uncertain-Linear-Model") {
+        // set-up 2D Belief Space
+        ob::StateSpacePtr space = ob::StateSpacePtr(new FixedBeliefSpace<2>());
+        ob::RealVectorBounds bounds_se2(2);
+        bounds_se2.setLow(0, -1);
+        bounds_se2.setHigh(0, mrmp_instance->getDimensions()[0]);
+        bounds_se2.setLow(1, -1);
+        bounds_se2.setHigh(1, mrmp_instance->getDimensions()[1]);
+        space->as<RealVectorBeliefSpace>()->setBounds(bounds_se2);
+
+        // set-up the real vector control space
+        auto cspace(std::make_shared<oc::RealVectorControlSpace>(space, 2));
+        ob::RealVectorBounds c_bounds(2);
+        c_bounds.setLow(-1.0);  // this was [-100.0, 100.0]!
+        c_bounds.setHigh(1.0);
+        cspace->setBounds(c_bounds);
+
+        // construct an instance of space information from this state/control space
+        auto si(std::make_shared<oc::SpaceInformation>(space, cspace));
+
+        // construct (and include) an instance of PCCBlackmore State Validity Checker
+        if (mrmp_instance->getSVC() == "Blackmore") {
+            si->setStateValidityChecker(std::make_shared<PCCBlackmoreSVC>(si, mrmp_instance, robot, mrmp_instance->getPsafeObs()));
+        }
+        else if (mrmp_instance->getSVC() == "AdaptiveBlackmore") {
+            si->setStateValidityChecker(std::make_shared<AdaptiveRiskBlackmoreSVC>(si, mrmp_instance, robot, mrmp_instance->getPsafeObs()));
+        }
+        else if (mrmp_instance->getSVC() == "ChiSquared") {
+            // si->setStateValidityChecker(std::make_shared<ChiSquaredBoundarySVC>(si, mrmp_instance, robot, mrmp_instance->getPsafeObs()));
+            si->setStateValidityChecker(std::make_shared<ChiSquaredBoundarySVC>(si, mrmp_instance, robot, 0.9));
+        }
+        else if (mrmp_instance->getSVC() == "ChiSquaredSDF") {
+            si->setStateValidityChecker(std::make_shared<ChiSquaredSDFSVC>(si, mrmp_instance, robot, 0.9));
         }
-        else if ((*itr)->getDynamicsModel() == "Uncertain-Unicycle-Model") {
-            // set-up Belief Space
-            ob::StateSpacePtr space = ob::StateSpacePtr(new RealVectorBeliefSpace(4));
-            // ob::RealVectorBounds bounds(4);
-            // bounds.setLow(0, -1); // x low
-            // bounds.setHigh(0, mrmp_instance->getDimensions()[0]); // x high
-            // bounds.setLow(1, -1); // y low
-            // bounds.setHigh(1, mrmp_instance->getDimensions()[1]); // y high
-            // bounds.setLow(2, -1); // xdot
-            // bounds.setHigh(2, 1); // xdot
-            // bounds.setLow(3, -1); // ydot
-            // bounds.setHigh(3, 1); // ydot
-            // space->as<RealVectorBeliefSpace>()->setBounds(bounds);
-
-            ob::RealVectorBounds cbounds(4);
-            cbounds.setLow(0, -1); // x low
-            cbounds.setHigh(0, mrmp_instance->getDimensions()[0]); // x high
-            cbounds.setLow(1, -1); // y low
-            cbounds.setHigh(1, mrmp_instance->getDimensions()[1]); // y high
-            cbounds.setLow(2, -M_PI); // yaw low
-            cbounds.setHigh(2, M_PI); // yaw high
-            cbounds.setLow(3, 0.01); // surge low
-            cbounds.setHigh(3, 10.0); // surge high
-
-            // set-up the real vector control space
-            auto cspace(std::make_shared<oc::RealVectorControlSpace>(space, 4));
-            cspace->setBounds(cbounds); // cspace bounds are identical to state space bounds
-
-            space->as<RealVectorBeliefSpace>()->setBounds(cbounds);
-
-            // construct an instance of space information from this state/control space
-            auto si(std::make_shared<oc::SpaceInformation>(space, cspace));
-
-            // construct (and include) an instance of PCCBlackmore State Validity Checker
-            if (mrmp_instance->getSVC() == "Blackmore") {
-                si->setStateValidityChecker(std::make_shared<PCCBlackmoreSVC>(si, mrmp_instance, (*itr), mrmp_instance->getPsafeObs()));
-            }
-            else if (mrmp_instance->getSVC() == "AdaptiveBlackmore") {
-                si->setStateValidityChecker(std::make_shared<AdaptiveRiskBlackmoreSVC>(si, mrmp_instance, (*itr), mrmp_instance->getPsafeObs()));
-            }
-            else if (mrmp_instance->getSVC() == "ChiSquared") {
-                // si->setStateValidityChecker(std::make_shared<ChiSquaredBoundarySVC>(si, mrmp_instance, (*itr), mrmp_instance->getPsafeObs()));
-                si->setStateValidityChecker(std::make_shared<ChiSquaredBoundarySVC>(si, mrmp_instance, (*itr), 0.9));
-            }
-
-            si->setPropagationStepSize(stepSize);
-            si->setMinMaxControlDuration(1, 10);
-            
-            // construct (and include) an instance of 2D-Uncertain-Linear State Propogator
-            si->setStatePropagator(oc::StatePropagatorPtr(new DynUnicycleControlSpace(si)));
-
-            si->setup();
-
-            ob::State *start = si->allocState();
-            start->as<RealVectorBeliefSpace::StateType>()->values[0] = (*itr)->getStartLocation().x_;
-            start->as<RealVectorBeliefSpace::StateType>()->values[1] = (*itr)->getStartLocation().y_;
-            start->as<RealVectorBeliefSpace::StateType>()->values[2] = 0; // initial yaw
-            start->as<RealVectorBeliefSpace::StateType>()->values[3] = 0.1; // initial surge
-            Eigen::MatrixXd Sigma0 = 0.01 * Eigen::MatrixXd::Identity(4, 4);
-            start->as<RealVectorBeliefSpace::StateType>()->sigma_ = Sigma0;
-
-            // // create goal
-            ob::GoalPtr goal(new ChanceConstrainedGoal(si, (*itr)->getGoalLocation(), goalTollorance, 0.95));
-
-            // create a problem instance
-            auto pdef(std::make_shared<ob::ProblemDefinition>(si));
-
-            // set the start and goal states
-            pdef->addStartState(start);
-            pdef->setGoal(goal);
 
-            // set optimization objective
-            pdef->setOptimizationObjective(getEuclideanPathLengthObjective(si));
+        si->setPropagationStepSize(stepSize);
+        si->setMinMaxControlDuration(1, 10);
+        
+        // construct (and include) an instance of 2D-Uncertain-Linear State Propogator
+        si->setStatePropagator(oc::StatePropagatorPtr(new R2_UncertainLinearStatePropagator(si)));
+
+        si->setup();
+
+        ob::State *start = si->allocState();
+        start->as<RealVectorBeliefSpace::StateType>()->values[0] = robot->getStartLocation().x_;
+        start->as<RealVectorBeliefSpace::StateType>()->values[1] = robot->getStartLocation().y_;
+        Eigen::MatrixXd Sigma0 = 0.01 * Eigen::MatrixXd::Identity(2, 2);
+        start->as<RealVectorBeliefSpace::StateType>()->sigma_ = Sigma0;
+
+        // // create goal
+        ob::GoalPtr goal(new ChanceConstrainedGoal(si, robot->getGoalLocation(), goalTollorance, 0.95));
+
+        // create a problem instance
+        auto pdef(std::make_shared<ob::ProblemDefinition>(si));
+
+        // set the start and goal states
+        pdef->addStartState(start);
+        pdef->setGoal(goal);
+
+        // set optimization objective
+        pdef->setOptimizationObjective(getEuclideanPathLengthObjective(si));
+
+        // // create (and provide) the low-level motion planner object
+        PlannerPtr planner(std::make_shared<oc::ConstraintRespectingBSST>(si));
+        // ConstraintRespectingPlannerPtr planner(std::make_shared<oc::ConstraintRespectingBSST>(si));
+        planner->as<oc::ConstraintRespectingBSST>()->setProblemDefinition(pdef);
+        planner->as<oc::ConstraintRespectingBSST>()->setup();
+        planner->as<oc::ConstraintRespectingBSST>()->setSeed(mrmp_instance->getAgentSeed(robot->getId()));
+        planner->as<oc::ConstraintRespectingBSST>()->setExperienceCache(mrmp_instance->getExperienceCache(robot));
+
+        // append to MRMP problem list (the controls are the velocities)
+        auto mp = std::make_shared<MotionPlanningProblem>(si, pdef, planner);
+        mp->setSpeedBound(std::sqrt(2.0) * c_bounds.high[0], goalTollorance);
+        return mp;
+    }
+    else if (robot->getDynamicsModel() == "Uncertain-Unicycle-Model") {
+        // set-up Belief Space
+        ob::StateSpacePtr space = ob::StateSpacePtr(new FixedBeliefSpace<4>());
+        // ob::RealVectorBounds bounds(4);
+        // bounds.setLow(0, -1); // x low
+        // bounds.setHigh(0, mrmp_instance->getDimensions()[0]); // x high
+        // bounds.setLow(1, -1); // y low
+        // bounds.setHigh(1, mrmp_instance->getDimensions()[1]); // y high
+        // bounds.setLow(2, -1); // xdot
+        // bounds.setHigh(2, 1); // xdot
+        // bounds.setLow(3, -1); // ydot
+        // bounds.setHigh(3, 1); // ydot
+        // space->as<RealVectorBeliefSpace>()->setBounds(bounds);
+
+        ob::RealVectorBounds cbounds(4);
+        cbounds.setLow(0, -1); // x low
+        cbounds.setHigh(0, mrmp_instance->getDimensions()[0]); // x high
+        cbounds.setLow(1, -1); // y low
+        cbounds.setHigh(1, mrmp_instance->getDimensions()[1]); // y high
+        cbounds.setLow(2, -M_PI); // yaw low
+        cbounds.setHigh(2, M_PI); // yaw high
+        cbounds.setLow(3, 0.01); // surge low
+        cbounds.setHigh(3, 10.0); // surge high
+
+        // set-up the real vector control space
+        auto cspace(std::make_shared<oc::RealVectorControlSpace>(space, 4));
+        cspace->setBounds(cbounds); // cspace bounds are identical to state space bounds
+
+        space->as<RealVectorBeliefSpace>()->setBounds(cbounds);
+
+        // construct an instance of space information from this state/control space
+        auto si(std::make_shared<oc::SpaceInformation>(space, cspace));
+
+        // construct (and include) an instance of PCCBlackmore State Validity Checker
+        if (mrmp_instance->getSVC() == "Blackmore") {
+            si->setStateValidityChecker(std::make_shared<PCCBlackmoreSVC>(si, mrmp_instance, robot, mrmp_instance->getPsafeObs()));
+        }
+        else if (mrmp_instance->getSVC() == "AdaptiveBlackmore") {
+            si->setStateValidityChecker(std::make_shared<AdaptiveRiskBlackmoreSVC>(si, mrmp_instance, robot, mrmp_instance->getPsafeObs()));
+        }
+        else if (mrmp_instance->getSVC() == "ChiSquared") {
+            // si->setStateValidityChecker(std::make_shared<ChiSquaredBoundarySVC>(si, mrmp_instance, robot, mrmp_instance->getPsafeObs()));
+            si->setStateValidityChecker(std::make_shared<ChiSquaredBoundarySVC>(si, mrmp_instance, robot, 0.9));
+        }
+        else if (mrmp_instance->getSVC() == "ChiSquaredSDF") {
+            si->setStateValidityChecker(std::make_shared<ChiSquaredSDFSVC>(si, mrmp_instance, robot, 0.9));
+        }
 
-            // create (and provide) the low-level motion planner object
-            PlannerPtr planner(std::make_shared<oc::ConstraintRespectingBSST>(si));
-            planner->as<oc::ConstraintRespectingBSST>()->setProblemDefinition(pdef);
-            planner->as<oc::ConstraintRespectingBSST>()->setup();
+        si->setPropagationStepSize(stepSize);
+        si->setMinMaxControlDuration(1, 10);
+        
+        // construct (and include) an instance of 2D-Uncertain-Linear State Propogator
+        si->setStatePropagator(oc::StatePropagatorPtr(new DynUnicycleControlSpace(si)));
+
+        si->setup();
+
+        ob::State *start = si->allocState();
+        start->as<RealVectorBeliefSpace::StateType>()->values[0] = robot->getStartLocation().x_;
+        start->as<RealVectorBeliefSpace::StateType>()->values[1] = robot->getStartLocation().y_;
+        start->as<RealVectorBeliefSpace::StateType>()->values[2] = 0; // initial yaw
+        start->as<RealVectorBeliefSpace::StateType>()->values[3] = 0.1; // initial surge
+        Eigen::MatrixXd Sigma0 = 0.01 * Eigen::MatrixXd::Identity(4, 4);
+        start->as<RealVectorBeliefSpace::StateType>()->sigma_ = Sigma0;
+
+        // // create goal
+        ob::GoalPtr goal(new ChanceConstrainedGoal(si, robot->getGoalLocation(), goalTollorance, 0.95));
+
+        // create a problem instance
+        auto pdef(std::make_shared<ob::ProblemDefinition>(si));
+
+        // set the start and goal states
+        pdef->addStartState(start);
+        pdef->setGoal(goal);
+
+        // set optimization objective
+        pdef->setOptimizationObjective(getEuclideanPathLengthObjective(si));
+
+        // create (and provide) the low-level motion planner object
+        PlannerPtr planner(std::make_shared<oc::ConstraintRespectingBSST>(si));
+        planner->as<oc::ConstraintRespectingBSST>()->setProblemDefinition(pdef);
+        planner->as<oc::ConstraintRespectingBSST>()->setup();
+        planner->as<oc::ConstraintRespectingBSST>()->setSeed(mrmp_instance->getAgentSeed(robot->getId()));
+        planner->as<oc::ConstraintRespectingBSST>()->setExperienceCache(mrmp_instance->getExperienceCache(robot));
+
+        // append to MRMP problem list (the surge is bounded as the state)
+        auto mp = std::make_shared<MotionPlanningProblem>(si, pdef, planner);
+        mp->setSpeedBound(cbounds.high[3], goalTollorance);
+        return mp;
+    }
+    OMPL_ERROR("%s: Dynamics model named %s is not yet implemented!", 
+        "OMPL Set-Up", robot->getDynamicsModel().c_str());
+    return nullptr;
+}
 
-            // append to MRMP problem list
-            auto mp = std::make_shared<MotionPlanningProblem>(si, pdef, planner);
-            prob_defs.push_back(mp);
-        }
-        else {
-            OMPL_ERROR("%s: Dynamics model named %s is not yet implemented!", 
-                "OMPL Set-Up", (*itr)->getDynamicsModel().c_str());
+std::vector<MotionPlanningProblemPtr> set_up_ConstraintBSST_MP_Problems(InstancePtr mrmp_instance)
+{
+    std::vector<Robot*> robots = mrmp_instance->getRobots();
+    std::vector<MotionPlanningProblemPtr> prob_defs(robots.size());
+
+    // the robots are independent (the caches of the instance are shared under a lock), so they are set up in
+    // parallel, each into its own slot to keep the order of the robots
+    const unsigned int num_threads = std::max(1u, std::min<unsigned int>(std::thread::hardware_concurrency(), robots.size()));
+    std::atomic<std::size_t> next_robot{0};
+    auto work = [&]() {
+        for (std::size_t r = next_robot++; r < robots.size(); r = next_robot++)
+            prob_defs[r] = set_up_ConstraintBSST_MP_Problem(mrmp_instance, robots[r]);
+    };
+    TaskGroup workers;
+    workers.runAndWait(num_threads, [&work](const std::size_t) {work();});
+
+    for (const MotionPlanningProblemPtr &mp: prob_defs) {
+        if (!mp)
             return {};
-        }
     }
-    OMPL_INFORM("%s: Initialized %lu robots.", "OMPL Set-Up", prob_defs.size());
+    OMPL_INFORM("%s: Initialized %lu robots on %u threads.", "OMPL Set-Up", prob_defs.size(), num_threads);
     return prob_defs;
 }
 
@@ -363,7 +408,7 @@ std::vector<MotionPlanningProblemPtr> set_up_CentralizedBSST_Problem(InstancePtr
         Robot* r2 = mrmp_instance->getRobots()[1];
         if (r1->getDynamicsModel() == "2D-Uncertain-Linear-Model" && r2->getDynamicsModel() == "2D-Uncertain-Linear-Model") {
             // set-up 4D Belief Space
-            ob::StateSpacePtr space = ob::StateSpacePtr(new RealVectorBeliefSpace(4));
+            ob::StateSpacePtr space = ob::StateSpacePtr(new BlockDiagonalBeliefSpace(2));
             ob::RealVectorBounds bounds(4);
             bounds.setLow(0, -1);
             bounds.setHigh(0, mrmp_instance->getDimensions()[0]);
@@ -402,8 +447,8 @@ std::vector<MotionPlanningProblemPtr> set_up_CentralizedBSST_Problem(InstancePtr
             start->as<RealVectorStateSpace::StateType>()->values[1] = r1->getStartLocation().y_;
             start->as<RealVectorStateSpace::StateType>()->values[2] = r2->getStartLocation().x_;
             start->as<RealVectorStateSpace::StateType>()->values[3] = r2->getStartLocation().y_;
-            Eigen::MatrixXd Sigma0 = 0.00001 * Eigen::MatrixXd::Identity(4, 4);
-            start->as<RealVectorBeliefSpace::StateType>()->sigma_ = Sigma0;
+            for (int a = 0; a < 2; a++)
+                start->as<RealVectorBeliefSpace::StateType>()->sigmaBlock(a) = 0.00001 * Eigen::Matrix2d::Identity();
 
             // create goal state
             ob::State *goal_st = si->allocState();
@@ -446,7 +491,7 @@ std::vector<MotionPlanningProblemPtr> set_up_CentralizedBSST_Problem(InstancePtr
                 r2->getDynamicsModel() == "2D-Uncertain-Linear-Model" && 
                 r3->getDynamicsModel() == "2D-Uncertain-Linear-Model") {
             // set-up 6D Belief Space
-            ob::StateSpacePtr space = ob::StateSpacePtr(new RealVectorBeliefSpace(6));
+            ob::StateSpacePtr space = ob::StateSpacePtr(new BlockDiagonalBeliefSpace(3));
             ob::RealVectorBounds bounds(6);
             bounds.setLow(0, -1);
             bounds.setHigh(0, mrmp_instance->getDimensions()[0]);
@@ -492,8 +537,8 @@ std::vector<MotionPlanningProblemPtr> set_up_CentralizedBSST_Problem(InstancePtr
             start->as<RealVectorStateSpace::StateType>()->values[3] = r2->getStartLocation().y_;
             start->as<RealVectorStateSpace::StateType>()->values[4] = r3->getStartLocation().x_;
             start->as<RealVectorStateSpace::StateType>()->values[5] = r3->getStartLocation().y_;
-            Eigen::MatrixXd Sigma0 = 0.00001 * Eigen::MatrixXd::Identity(6, 6);
-            start->as<RealVectorBeliefSpace::StateType>()->sigma_ = Sigma0;
+            for (int a = 0; a < 3; a++)
+                start->as<RealVectorBeliefSpace::StateType>()->sigmaBlock(a) = 0.00001 * Eigen::Matrix2d::Identity();
 
             // create goal state
             ob::State *goal_st = si->allocState();
@@ -540,7 +585,7 @@ std::vector<MotionPlanningProblemPtr> set_up_CentralizedBSST_Problem(InstancePtr
                 r3->getDynamicsModel() == "2D-Uncertain-Linear-Model" &&
                 r4->getDynamicsModel() == "2D-Uncertain-Linear-Model") {
             // set-up 6D Belief Space
-            ob::StateSpacePtr space = ob::StateSpacePtr(new RealVectorBeliefSpace(8));
+            ob::StateSpacePtr space = ob::StateSpacePtr(new BlockDiagonalBeliefSpace(4));
             ob::RealVectorBounds bounds(8);
             bounds.setLow(0, -1);
             bounds.setHigh(0, mrmp_instance->getDimensions()[0]);
@@ -592,8 +637,8 @@ std::vector<MotionPlanningProblemPtr> set_up_CentralizedBSST_Problem(InstancePtr
             start->as<RealVectorStateSpace::StateType>()->values[5] = r3->getStartLocation().y_;
             start->as<RealVectorStateSpace::StateType>()->values[6] = r4->getStartLocation().x_;
             start->as<RealVectorStateSpace::StateType>()->values[7] = r4->getStartLocation().y_;
-            Eigen::MatrixXd Sigma0 = 0.00001 * Eigen::MatrixXd::Identity(8, 8);
-            start->as<RealVectorBeliefSpace::StateType>()->sigma_ = Sigma0;
+            for (int a = 0; a < 4; a++)
+                start->as<RealVectorBeliefSpace::StateType>()->sigmaBlock(a) = 0.00001 * Eigen::Matrix2d::Identity();
 
             // create goal state
             ob::State *goal_st = si->allocState();
@@ -0,0 +1,151 @@
+#include "utils/PerfCounters.h"
+#include <ompl/util/Console.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace perf
+{
+    namespace
+    {
+        std::atomic<bool> enabled{false};
+        std::atomic<bool> warned{false};
+
+        void warnOnce(const char *reason)
+        {
+            if (!warned.exchange(true))
+                OMPL_WARN("%s: Hardware counters are unavailable (%s), they are reported as zero.", "PerfCounters", reason);
+        }
+
+#ifdef __linux__
+        /* the counters of one thread, read at once as a group led by the cycles */
+        class ThreadCounters
+        {
+        public:
+            ThreadCounters()
+            {
+                const std::uint64_t configs[4] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+                for (int i = 0; i < 4; i++) {
+                    fds_[i] = open_(configs[i], (i == 0) ? -1 : fds_[0]);
+                    if (fds_[i] < 0) {
+                        warnOnce(strerror(errno));
+                        close_();
+                        return;
+                    }
+                }
+                ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+
+            ~ThreadCounters()
+            {
+                close_();
+            }
+
+            bool isOpen() const {return fds_[0] >= 0;};
+
+            Counters read() const
+            {
+                // PERF_FORMAT_GROUP: the number of counters, then their values in the order they were opened
+                std::uint64_t values[5] = {0, 0, 0, 0, 0};
+                if (!isOpen() || ::read(fds_[0], values, sizeof(values)) != sizeof(values))
+                    return Counters();
+                return {values[1], values[2], values[3], values[4]};
+            }
+
+        private:
+            static int open_(const std::uint64_t config, const int group)
+            {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = config;
+                attr.read_format = PERF_FORMAT_GROUP;
+                // the leader starts the group once all its members are open
+                attr.disabled = (group == -1);
+                // user space only, which an unprivileged process may count
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+            }
+
+            void close_()
+            {
+                for (int &fd: fds_) {
+                    if (fd >= 0)
+                        close(fd);
+                    fd = -1;
+                }
+            }
+
+            int fds_[4] = {-1, -1, -1, -1};
+        };
+
+        const ThreadCounters &threadCounters()
+        {
+            thread_local const ThreadCounters counters;
+            return counters;
+        }
+#endif
+    }
+
+    void setEnabled(const bool enable)
+    {
+#ifndef __linux__
+        if (enable)
+            warnOnce("perf_event_open is Linux only");
+#endif
+        enabled = enable;
+    }
+
+    bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    bool available()
+    {
+#ifdef __linux__
+        return isEnabled() && threadCounters().isOpen();
+#else
+        return false;
+#endif
+    }
+
+    Counters read()
+    {
+#ifdef __linux__
+        if (isEnabled())
+            return threadCounters().read();
+#endif
+        return Counters();
+    }
+
+    std::size_t peakResidentBytes()
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+#ifdef __APPLE__
+        return usage.ru_maxrss;  // bytes
+#else
+        return static_cast<std::size_t>(usage.ru_maxrss) * 1024;  // kilobytes
+#endif
+#else
+        return 0;
+#endif
+    }
+}
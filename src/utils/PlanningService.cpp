@@ -0,0 +1,318 @@
+#include "utils/PlanningService.h"
+#include "utils/postProcess.h"
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+
+
+namespace
+{
+    void set_option(po::variables_map &vm, const std::string &key, const boost::any &value)
+    {
+        // variables_map only exposes its values to read, they are written through the map it is
+        static_cast<std::map<std::string, po::variable_value> &>(vm)[key] = po::variable_value(value, false);
+    }
+
+    std::string json_string(const std::string &s)
+    {
+        std::string quoted = "\"";
+        for (const char c: s) {
+            if (c == '"' || c == '\\')
+                quoted += '\\';
+            if (c == '\n')
+                quoted += "\\n";
+            else
+                quoted += c;
+        }
+        return quoted + "\"";
+    }
+
+    /* the fields of a flat JSON object (strings, numbers and booleans, as their text). False if line is not one */
+    bool parse_json(const std::string &line, std::map<std::string, std::string> &fields)
+    {
+        std::size_t i = 0;
+        auto skip = [&]() {
+            while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i])))
+                i++;
+        };
+        auto parse_string = [&](std::string &s) {
+            if (i >= line.size() || line[i] != '"')
+                return false;
+            for (i++; i < line.size() && line[i] != '"'; i++) {
+                if (line[i] == '\\' && ++i < line.size())
+                    s += (line[i] == 'n') ? '\n' : line[i];
+                else
+                    s += line[i];
+            }
+            return i++ < line.size();
+        };
+        skip();
+        if (i >= line.size() || line[i++] != '{')
+            return false;
+        skip();
+        if (i < line.size() && line[i] == '}')
+            return true;
+        while (i < line.size()) {
+            std::string key, value;
+            skip();
+            if (!parse_string(key))
+                return false;
+            skip();
+            if (i >= line.size() || line[i++] != ':')
+                return false;
+            skip();
+            if (i < line.size() && line[i] == '"') {
+                if (!parse_string(value))
+                    return false;
+            }
+            else {
+                while (i < line.size() && line[i] != ',' && line[i] != '}' && !std::isspace(static_cast<unsigned char>(line[i])))
+                    value += line[i++];
+                if (value.empty())
+                    return false;
+            }
+            fields[key] = value;
+            skip();
+            if (i < line.size() && line[i] == ',') {
+                i++;
+                continue;
+            }
+            return i < line.size() && line[i] == '}';
+        }
+        return false;
+    }
+
+    /* the fields of a scen line "map scen numAgents [id]" */
+    bool parse_scen_line(const std::string &line, std::map<std::string, std::string> &fields)
+    {
+        std::stringstream ss(line);
+        std::string map, scen, k, id;
+        if (!(ss >> map >> scen >> k))
+            return false;
+        fields["map"] = map;
+        fields["scen"] = scen;
+        fields["numAgents"] = k;
+        if (ss >> id)
+            fields["id"] = id;
+        return true;
+    }
+
+    std::string error_response(const std::string &id, const std::string &error)
+    {
+        return "{\"id\": " + json_string(id) + ", \"error\": " + json_string(error) + "}";
+    }
+}
+
+PlanningService::PlanningService(const po::variables_map &vm, const unsigned int threads):
+    vm_(vm), threads_(std::max(threads, 1u))
+{
+    if (vm_.count("publish") && !vm_["publish"].as<std::string>().empty())
+        publisher_.open(vm_["publish"].as<std::string>());
+}
+
+PlanningService::~PlanningService()
+{
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        done_ = true;
+    }
+    requests_cv_.notify_all();
+    for (std::thread &t: workers_)
+        t.join();
+}
+
+void PlanningService::serve(std::istream &in, std::ostream &out)
+{
+    out_ = &out;
+    for (unsigned int t = 0; t < threads_; t++)
+        workers_.emplace_back(&PlanningService::work_, this);
+    OMPL_INFORM("%s: Serving requests on %u threads.", "PlanningService", threads_);
+
+    std::string line;
+    unsigned int num_requests = 0;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        if (line == "quit")
+            break;
+        {
+            std::lock_guard<std::mutex> lock(requests_mutex_);
+            requests_.emplace_back(line, std::to_string(num_requests++));
+        }
+        requests_cv_.notify_one();
+    }
+
+    // the requests already read are answered before returning
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        done_ = true;
+    }
+    requests_cv_.notify_all();
+    for (std::thread &t: workers_)
+        t.join();
+    workers_.clear();
+    OMPL_INFORM("%s: Answered %u requests.", "PlanningService", num_requests);
+}
+
+void PlanningService::work_()
+{
+    while (true) {
+        std::pair<std::string, std::string> request;
+        {
+            std::unique_lock<std::mutex> lock(requests_mutex_);
+            requests_cv_.wait(lock, [this] {return done_ || !requests_.empty();});
+            if (requests_.empty())
+                return;
+            request = std::move(requests_.front());
+            requests_.pop_front();
+        }
+        const std::string response = handle(request.first, request.second);
+        std::lock_guard<std::mutex> lock(out_mutex_);
+        *out_ << response << std::endl;
+    }
+}
+
+std::string PlanningService::handle(const std::string &line, const std::string &default_id)
+{
+    std::map<std::string, std::string> fields;
+    const bool json = (line.find('{') != std::string::npos);
+    if (!(json ? parse_json(line, fields) : parse_scen_line(line, fields)))
+        return error_response(default_id, "invalid request");
+    const std::string id = fields.count("id") ? fields["id"] : default_id;
+
+    // the settings of the command line, with those of the request
+    po::variables_map config(vm_);
+    bool export_plan = false;
+    for (const std::pair<const std::string, std::string> &f: fields) {
+        if (f.first == "id")
+            continue;
+        else if (f.first == "map" || f.first == "scen" || f.first == "solver" || f.first == "lowlevel" ||
+            f.first == "pvc" || f.first == "svc")
+            set_option(config, f.first, f.second);
+        else if (f.first == "numAgents" || f.first == "bound")
+            set_option(config, f.first, std::atoi(f.second.c_str()));
+        else if (f.first == "p_safe" || f.first == "time")
+            set_option(config, f.first, std::atof(f.second.c_str()));
+        else if (f.first == "export")
+            export_plan = (f.second == "true");
+        else
+            return error_response(id, "unknown field " + f.first);
+    }
+    if (!config.count("map") || !config.count("scen") || !config.count("numAgents"))
+        return error_response(id, "map, scen and numAgents are required");
+    if (!fs::is_regular_file(config["map"].as<std::string>()) || !fs::is_regular_file(config["scen"].as<std::string>()))
+        return error_response(id, "no such map or scen file");
+    if (config["numAgents"].as<int>() <= 0)
+        return error_response(id, "numAgents should be larger than 0");
+    if (config["solver"].as<std::string>() != "K-CBS")
+        return error_response(id, "the service only plans with K-CBS");
+
+    const auto t0 = std::chrono::steady_clock::now();
+    Checkout checkout;
+    std::string error;
+    if (!checkout_(config, checkout, error))
+        return error_response(id, error);
+    const double setup = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    ob::PlannerPtr p(std::make_shared<oc::KCBS>(checkout.pdef_));
+    p->as<oc::KCBS>()->setMergeBound(config["bound"].as<int>());
+    const bool solved = p->solve(config["time"].as<double>());
+    if (solved && (export_plan || publisher_.isOpen())) {
+        std::vector<oc::PathControl*> plan;
+        for (int i = 0; i < config["numAgents"].as<int>(); i++)
+            plan.push_back(checkout.pdef_->getRobotProblemDefinitionPtr(i)->getSolutionPath()->as<oc::PathControl>());
+        if (export_plan)
+            exportBeliefPlan(plan, id);
+        publisher_.publish(plan);
+    }
+    std::ostringstream response;
+    response << "{\"id\": " << json_string(id) << ", \"solved\": " << (solved ? "true" : "false")
+             << ", \"time\": " << p->as<oc::KCBS>()->getComputationTime() << ", \"soc\": "
+             << p->as<oc::KCBS>()->getSolutionSOC() << ", \"setup\": " << setup << ", \"warm\": "
+             << (checkout.warm_ ? "true" : "false") << "}";
+    p.reset();
+    return_(checkout);
+    return response.str();
+}
+
+bool PlanningService::checkout_(po::variables_map &config, Checkout &checkout, std::string &error)
+{
+    std::ostringstream key;
+    key << config["map"].as<std::string>() << "|" << config["scen"].as<std::string>() << "|"
+        << config["numAgents"].as<int>() << "|" << config["lowlevel"].as<std::string>() << "|"
+        << config["pvc"].as<std::string>() << "|" << config["svc"].as<std::string>() << "|"
+        << config["p_safe"].as<double>();
+    checkout.key_ = key.str();
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        std::vector<MultiRobotProblemDefinitionPtr> &idle = idle_[checkout.key_];
+        if (!idle.empty()) {
+            checkout.pdef_ = idle.back();
+            checkout.warm_ = true;
+            idle.pop_back();
+            num_idle_--;
+            return true;
+        }
+    }
+    // the map is parsed (and its geometry built) by its first request, outside of the cache lock: the other requests
+    // of that map wait for it, and parse it themselves if it fails (on the scen of the first request, say)
+    const std::string map = config["map"].as<std::string>();
+    InstancePtr map_instance;
+    while (!map_instance) {
+        std::promise<InstancePtr> parsed;
+        std::shared_future<InstancePtr> slot;
+        bool parse = false;
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex_);
+            auto it = map_instances_.find(map);
+            if (it == map_instances_.end()) {
+                slot = parsed.get_future().share();
+                map_instances_.emplace(map, slot);
+                parse = true;
+            }
+            else
+                slot = it->second;
+        }
+        if (!parse) {
+            map_instance = slot.get();
+            continue;
+        }
+        map_instance = Instance::load(config);
+        if (!map_instance) {
+            std::lock_guard<std::mutex> lock(cache_mutex_);
+            map_instances_.erase(map);
+        }
+        parsed.set_value(map_instance);
+        if (!map_instance) {
+            error = "unable to load the map or scen";
+            return false;
+        }
+    }
+    InstancePtr instance = Instance::load(*map_instance, config);
+    if (!instance) {
+        error = "unable to load the scen";
+        return false;
+    }
+    checkout.pdef_ = set_up_kcbs(instance);
+    if (checkout.pdef_->getAllProblemInformation().empty()) {
+        error = "the robots could not be set up";
+        return false;
+    }
+    if (!checkout.pdef_->getPlanValidator()) {
+        error = "plan validity checker " + config["pvc"].as<std::string>() + " is not available";
+        return false;
+    }
+    return true;
+}
+
+void PlanningService::return_(Checkout &checkout)
+{
+    clear_trial(checkout.pdef_);
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (num_idle_ >= max_idle_)
+        return;
+    idle_[checkout.key_].push_back(std::move(checkout.pdef_));
+    num_idle_++;
+}
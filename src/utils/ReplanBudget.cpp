@@ -0,0 +1,74 @@
+#include "utils/ReplanBudget.h"
+#include <algorithm>
+#include <cmath>
+
+
+ReplanBudget::ReplanBudget(const double initial, const double min, const double margin, const double spread):
+    initial_(initial), min_(min), margin_(margin), spread_(spread)
+{
+}
+
+std::size_t ReplanBudget::bucket_(const std::size_t num_constraints)
+{
+    std::size_t b = 0;
+    for (std::size_t n = num_constraints; n > 0; n >>= 1)
+        b++;
+    return b;
+}
+
+double ReplanBudget::estimate_(const std::vector<Cell> &cells, const std::size_t bucket) const
+{
+    // fewer constraints are (usually) faster to satisfy, so their cells are the next best guess
+    for (std::size_t b = std::min(bucket + 1, cells.size()); b-- > 0; ) {
+        const Cell &c = cells[b];
+        if (c.n_ < min_samples_)
+            continue;
+        const double sd = std::sqrt(c.m2_ / (c.n_ - 1));
+        return margin_ * std::exp(c.mean_ + spread_ * sd);
+    }
+    return -1;
+}
+
+double ReplanBudget::budget(const int agent, const std::size_t num_constraints, const unsigned int failures, 
+    const double max) const
+{
+    const std::size_t bucket = bucket_(num_constraints);
+    double t = -1;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (agent >= 0 && std::size_t(agent) + 1 < cells_.size())
+            t = estimate_(cells_[agent + 1], bucket);
+        if (t < 0 && !cells_.empty())
+            t = estimate_(cells_[0], bucket);
+    }
+    if (t < 0)
+        t = initial_;
+    t *= std::pow(2.0, std::min(failures, 64u));
+    return std::min(std::max(t, min_), max);
+}
+
+void ReplanBudget::record(const int agent, const std::size_t num_constraints, const double seconds)
+{
+    if (agent < 0 || !(seconds > 0))
+        return;
+    const std::size_t bucket = bucket_(num_constraints);
+    const double x = std::log(seconds);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cells_.size() < std::size_t(agent) + 2)
+        cells_.resize(agent + 2);
+    for (std::vector<Cell> *cells: {&cells_[0], &cells_[agent + 1]}) {
+        if (cells->size() <= bucket)
+            cells->resize(bucket + 1);
+        Cell &c = (*cells)[bucket];
+        c.n_++;
+        const double delta = x - c.mean_;
+        c.mean_ += delta / c.n_;
+        c.m2_ += delta * (x - c.mean_);
+    }
+}
+
+void ReplanBudget::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    cells_.clear();
+}
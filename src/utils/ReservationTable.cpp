@@ -0,0 +1,61 @@
+#include "utils/ReservationTable.h"
+#include <algorithm>
+#include <cmath>
+
+
+ReservationTable::ReservationTable(const std::vector<std::vector<RobotFootprint>> &paths)
+{
+    std::size_t horizon = 0;
+    for (const std::vector<RobotFootprint> &path: paths) {
+        horizon = std::max(horizon, path.size());
+        for (const RobotFootprint &fp: path)
+            max_r_ = std::max(max_r_, fp.r_);
+    }
+    if (horizon == 0)
+        return;
+    // a cell as large as the largest footprint, so a query reaches few cells
+    if (max_r_ > 0)
+        cell_size_ = 2 * max_r_;
+
+    steps_.resize(horizon);
+    for (std::size_t k = 0; k < horizon; k++) {
+        std::vector<Entry> &entries = steps_[k];
+        for (const std::vector<RobotFootprint> &path: paths) {
+            if (path.empty())
+                continue;
+            const RobotFootprint &fp = path[std::min(k, path.size() - 1)];
+            entries.push_back({cell_(fp.cx_), cell_(fp.cy_), fp});
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+            return (a.cx_ < b.cx_) || (a.cx_ == b.cx_ && a.cy_ < b.cy_);
+        });
+    }
+}
+
+long ReservationTable::cell_(const double v) const
+{
+    return static_cast<long>(std::floor(v / cell_size_));
+}
+
+bool ReservationTable::isFree(const unsigned int step, const RobotFootprint &fp) const
+{
+    if (steps_.empty())
+        return true;
+    // every agent is parked at its last footprint beyond the horizon
+    const std::vector<Entry> &entries = steps_[std::min<std::size_t>(step, steps_.size() - 1)];
+    // the cells of the reference points of the footprints that fp may touch, padded for the rounding
+    const double reach = (fp.r_ + max_r_) * (1 + 1e-9) + 1e-12;
+    const long x_low = cell_(fp.cx_ - reach), x_high = cell_(fp.cx_ + reach);
+    const long y_low = cell_(fp.cy_ - reach), y_high = cell_(fp.cy_ + reach);
+    for (long cx = x_low; cx <= x_high; cx++) {
+        // the cells (cx, y_low..y_high) are contiguous in the order of the entries
+        auto first = std::lower_bound(entries.begin(), entries.end(), std::make_pair(cx, y_low), [](const Entry &e, const std::pair<long, long> &c) {
+            return (e.cx_ < c.first) || (e.cx_ == c.first && e.cy_ < c.second);
+        });
+        for (auto itr = first; itr != entries.end() && itr->cx_ == cx && itr->cy_ <= y_high; itr++) {
+            if (!RobotFootprint::disjoint(fp, itr->fp_))
+                return false;
+        }
+    }
+    return true;
+}
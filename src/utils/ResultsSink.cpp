@@ -0,0 +1,191 @@
+#include "utils/ResultsSink.h"
+#include <ompl/util/Console.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+
+
+ResultsSink::ResultsSink(std::string filename, const std::size_t batch_rows):
+    filename_(std::move(filename)), batch_rows_(std::max<std::size_t>(batch_rows, 1))
+{
+}
+
+void ResultsSink::write(ResultRow row)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // the writer starts with the first row, once the backend is constructed
+    if (!writer_.joinable())
+        writer_ = std::thread(&ResultsSink::run_, this);
+    pending_.push_back(std::move(row));
+    queued_++;
+    if (pending_.size() >= batch_rows_)
+        pending_cv_.notify_one();
+}
+
+void ResultsSink::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (written_ == queued_)
+        return;
+    flushing_ = true;
+    pending_cv_.notify_one();
+    written_cv_.wait(lock, [this] {return written_ == queued_;});
+}
+
+void ResultsSink::close_()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        pending_cv_.notify_one();
+    }
+    if (writer_.joinable())
+        writer_.join();
+}
+
+void ResultsSink::run_()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        pending_cv_.wait(lock, [this] {return pending_.size() >= batch_rows_ || flushing_ || stop_;});
+        std::vector<ResultRow> rows;
+        rows.swap(pending_);
+        const bool stop = stop_;
+        lock.unlock();
+        if (!rows.empty())
+            writeRows_(rows);
+        lock.lock();
+        written_ += rows.size();
+        if (written_ == queued_) {
+            flushing_ = false;
+            written_cv_.notify_all();
+        }
+        if (stop && pending_.empty())
+            return;
+    }
+}
+
+
+namespace
+{
+    std::string csv_value(const ResultRow::Field &f)
+    {
+        if (f.numeric_ || f.value_.find_first_of(",\"\n") == std::string::npos)
+            return f.value_;
+        std::string quoted = "\"";
+        for (const char c: f.value_) {
+            if (c == '"')
+                quoted += '"';
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+
+    void json_string(std::ostream &out, const std::string &s)
+    {
+        out << '"';
+        for (const char c: s) {
+            if (c == '"' || c == '\\')
+                out << '\\' << c;
+            else if (c == '\n')
+                out << "\\n";
+            else
+                out << c;
+        }
+        out << '"';
+    }
+
+    /* numbers as written by an ostream, with JSON's null for nan and inf */
+    bool is_finite(const std::string &number)
+    {
+        return std::isfinite(std::strtod(number.c_str(), nullptr));
+    }
+}
+
+CsvResultsSink::CsvResultsSink(std::string filename): ResultsSink(std::move(filename))
+{
+    // the header of an existing file, which the appended rows are checked against
+    std::ifstream in(filename_);
+    std::string header;
+    if (in.good() && std::getline(in, header) && !header.empty()) {
+        std::stringstream ss(header);
+        std::string column;
+        while (std::getline(ss, column, ','))
+            columns_.push_back(column);
+    }
+    header_ = columns_.empty();
+    out_.open(filename_, std::ios::app);
+    if (!out_.is_open())
+        OMPL_ERROR("%s: Unable to open ``%s``.", "ResultsSink", filename_.c_str());
+}
+
+CsvResultsSink::~CsvResultsSink()
+{
+    close_();
+}
+
+void CsvResultsSink::writeRows_(const std::vector<ResultRow> &rows)
+{
+    for (const ResultRow &row: rows) {
+        if (header_) {
+            for (std::size_t i = 0; i < row.fields_.size(); i++) {
+                out_ << (i > 0 ? "," : "") << row.fields_[i].name_;
+                columns_.push_back(row.fields_[i].name_);
+            }
+            out_ << "\n";
+            header_ = false;
+        }
+        if (!warned_ && row.fields_.size() != columns_.size()) {
+            OMPL_WARN("%s: Rows of %zu columns are written under a header of %zu in ``%s``.", "ResultsSink",
+                row.fields_.size(), columns_.size(), filename_.c_str());
+            warned_ = true;
+        }
+        for (std::size_t i = 0; i < row.fields_.size(); i++)
+            out_ << (i > 0 ? "," : "") << csv_value(row.fields_[i]);
+        out_ << "\n";
+    }
+    out_.flush();
+}
+
+JsonLinesResultsSink::JsonLinesResultsSink(std::string filename): ResultsSink(std::move(filename))
+{
+    out_.open(filename_, std::ios::app);
+    if (!out_.is_open())
+        OMPL_ERROR("%s: Unable to open ``%s``.", "ResultsSink", filename_.c_str());
+}
+
+JsonLinesResultsSink::~JsonLinesResultsSink()
+{
+    close_();
+}
+
+void JsonLinesResultsSink::writeRows_(const std::vector<ResultRow> &rows)
+{
+    for (const ResultRow &row: rows) {
+        out_ << "{";
+        for (std::size_t i = 0; i < row.fields_.size(); i++) {
+            const ResultRow::Field &f = row.fields_[i];
+            if (i > 0)
+                out_ << ", ";
+            json_string(out_, f.name_);
+            out_ << ": ";
+            if (!f.numeric_)
+                json_string(out_, f.value_);
+            else if (is_finite(f.value_))
+                out_ << f.value_;
+            else
+                out_ << "null";
+        }
+        out_ << "}\n";
+    }
+    out_.flush();
+}
+
+ResultsSinkPtr make_results_sink(const std::string &filename)
+{
+    const std::string extension = std::filesystem::path(filename).extension().string();
+    if (extension == ".jsonl" || extension == ".json")
+        return std::make_shared<JsonLinesResultsSink>(filename);
+    return std::make_shared<CsvResultsSink>(filename);
+}
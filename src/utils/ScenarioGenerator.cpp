@@ -0,0 +1,242 @@
+#include "utils/ScenarioGenerator.h"
+#include "utils/TaskRuntime.h"
+#include <ompl/util/Console.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+#include <tuple>
+#include <vector>
+
+
+namespace
+{
+    /* the blocked cells of a map, by row (y) then column (x) */
+    class Grid
+    {
+    public:
+        Grid(const int width, const int height): width_(width), height_(height), blocked_(width * height, false) {}
+
+        bool inside(const int x, const int y) const {return x >= 0 && y >= 0 && x < width_ && y < height_;};
+
+        bool free(const int x, const int y) const {return inside(x, y) && !blocked_[index(x, y)];};
+
+        int index(const int x, const int y) const {return y * width_ + x;};
+
+        /* free and surrounded by free cells */
+        bool clear(const int x, const int y) const
+        {
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    if (!free(x + dx, y + dy))
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        const int width_;
+        const int height_;
+        std::vector<bool> blocked_;
+    };
+
+    /* the cells of the largest 4-connected free region */
+    std::vector<int> largest_region(const Grid &grid)
+    {
+        std::vector<int> region_of(grid.blocked_.size(), -1);
+        std::vector<int> largest, cells;
+        int regions = 0;
+        for (int start = 0; start < static_cast<int>(grid.blocked_.size()); start++) {
+            if (grid.blocked_[start] || region_of[start] >= 0)
+                continue;
+            cells.assign(1, start);
+            region_of[start] = regions;
+            for (std::size_t i = 0; i < cells.size(); i++) {
+                const int x = cells[i] % grid.width_, y = cells[i] / grid.width_;
+                const int neighbors[4][2] = {{x + 1, y}, {x - 1, y}, {x, y + 1}, {x, y - 1}};
+                for (const auto &n: neighbors) {
+                    if (grid.free(n[0], n[1]) && region_of[grid.index(n[0], n[1])] < 0) {
+                        region_of[grid.index(n[0], n[1])] = regions;
+                        cells.push_back(grid.index(n[0], n[1]));
+                    }
+                }
+            }
+            if (cells.size() > largest.size())
+                largest.swap(cells);
+            regions++;
+        }
+        return largest;
+    }
+
+    double octile(const int a, const int b, const int width)
+    {
+        const int dx = std::abs(a % width - b % width), dy = std::abs(a / width - b / width);
+        return std::max(dx, dy) + (std::sqrt(2.0) - 1) * std::min(dx, dy);
+    }
+
+    /* length of the shortest 8-connected path from start to goal (A*), diagonals only between two free cells.
+       Infinite if there is none */
+    double shortest_path(const Grid &grid, const int start, const int goal)
+    {
+        // f, then the deepest cell first (so the ties of the open grid are not all expanded), and the cell
+        typedef std::tuple<double, double, int> Entry;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+        std::vector<double> g(grid.blocked_.size(), std::numeric_limits<double>::infinity());
+        g[start] = 0;
+        open.push({octile(start, goal, grid.width_), 0.0, start});
+        while (!open.empty()) {
+            const int cell = std::get<2>(open.top());
+            const double depth = -std::get<1>(open.top());
+            open.pop();
+            if (cell == goal)
+                return g[goal];
+            // a stale entry of a cell reached by a shorter path since
+            if (depth > g[cell])
+                continue;
+            const int x = cell % grid.width_, y = cell / grid.width_;
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    if ((dx == 0 && dy == 0) || !grid.free(x + dx, y + dy))
+                        continue;
+                    if (dx != 0 && dy != 0 && (!grid.free(x + dx, y) || !grid.free(x, y + dy)))
+                        continue;
+                    const int next = grid.index(x + dx, y + dy);
+                    const double cost = g[cell] + ((dx != 0 && dy != 0) ? std::sqrt(2.0) : 1.0);
+                    if (cost < g[next]) {
+                        g[next] = cost;
+                        open.push({cost + octile(next, goal, grid.width_), -cost, next});
+                    }
+                }
+            }
+        }
+        return std::numeric_limits<double>::infinity();
+    }
+
+    /* cells of candidates (shuffled) spaced by at least spacing, up to n of them. The i-th is not avoid[i] */
+    std::vector<int> spaced_cells(const std::vector<int> &candidates, const unsigned int n, const double spacing,
+        const int width, const std::vector<int> &avoid = {})
+    {
+        std::vector<int> chosen;
+        for (const int c: candidates) {
+            if (chosen.size() == n)
+                break;
+            if (chosen.size() < avoid.size() && c == avoid[chosen.size()])
+                continue;
+            const bool spaced = std::none_of(chosen.begin(), chosen.end(), [&](const int o) {
+                return std::hypot(c % width - o % width, c / width - o / width) < spacing;
+            });
+            if (spaced)
+                chosen.push_back(c);
+        }
+        return chosen;
+    }
+
+    /* the name of dynamics in the scens, empty if none */
+    std::string dynamics_tag(const std::string &dynamics)
+    {
+        if (dynamics == "2D-Uncertain-Linear-Model")
+            return "2DUncertainLinear";
+        if (dynamics == "Uncertain-Unicycle-Model")
+            return "Uncertain-Unicycle";
+        if (dynamics == "FirstOrderCar")
+            return "FirstOrderCars";
+        return "";
+    }
+}
+
+std::string scenario_map_name(const ScenarioSpec &spec)
+{
+    return "random-" + std::to_string(spec.width_) + "-" + std::to_string(spec.height_) + "-" +
+        std::to_string(static_cast<int>(std::lround(100 * spec.density_)));
+}
+
+std::string scenario_scen_name(const ScenarioSpec &spec)
+{
+    return scenario_map_name(spec) + "-" + spec.shape_ + "s-" + dynamics_tag(spec.dynamics_);
+}
+
+bool generate_scenario(const ScenarioSpec &spec, const fs::path &directory, fs::path &map_file, fs::path &scen_file)
+{
+    if (spec.width_ < 3 || spec.height_ < 3 || spec.density_ < 0 || spec.density_ >= 1 || spec.agents_ == 0) {
+        OMPL_ERROR("%s: Invalid scenario (%dx%d, density %0.2f, %u agents).", "ScenarioGenerator", spec.width_,
+            spec.height_, spec.density_, spec.agents_);
+        return false;
+    }
+    if (dynamics_tag(spec.dynamics_).empty() || (spec.shape_ != "Point" && spec.shape_ != "Rectangle")) {
+        OMPL_ERROR("%s: Unknown robots ``%s`` with ``%s`` dynamics.", "ScenarioGenerator", spec.shape_.c_str(),
+            spec.dynamics_.c_str());
+        return false;
+    }
+    const std::uint32_t seed = (spec.seed_ != 0) ? spec.seed_ : std::random_device()();
+    std::mt19937 rng(seed);
+
+    // block a random subset of the cells
+    Grid grid(spec.width_, spec.height_);
+    std::vector<int> cells(grid.blocked_.size());
+    for (std::size_t i = 0; i < cells.size(); i++)
+        cells[i] = i;
+    std::shuffle(cells.begin(), cells.end(), rng);
+    const std::size_t num_blocked = std::lround(spec.density_ * cells.size());
+    for (std::size_t i = 0; i < num_blocked; i++)
+        grid.blocked_[cells[i]] = true;
+
+    // the starts and goals are drawn from the clear cells of one region
+    std::vector<int> candidates = largest_region(grid);
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&grid](const int c) {
+        return !grid.clear(c % grid.width_, c / grid.width_);
+    }), candidates.end());
+    std::shuffle(candidates.begin(), candidates.end(), rng);
+    const std::vector<int> starts = spaced_cells(candidates, spec.agents_, spec.spacing_, grid.width_);
+    std::shuffle(candidates.begin(), candidates.end(), rng);
+    // no agent starts at its goal
+    const std::vector<int> goals = spaced_cells(candidates, spec.agents_, spec.spacing_, grid.width_, starts);
+    if (starts.size() < spec.agents_ || goals.size() < spec.agents_) {
+        OMPL_ERROR("%s: A %dx%d map of density %0.2f only has room for %zu agents spaced by %0.1f.", "ScenarioGenerator",
+            spec.width_, spec.height_, spec.density_, std::min(starts.size(), goals.size()), spec.spacing_);
+        return false;
+    }
+
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    map_file = directory / (scenario_map_name(spec) + ".map");
+    scen_file = directory / (scenario_scen_name(spec) + ".scen");
+    std::ofstream map(map_file);
+    std::ofstream scen(scen_file);
+    if (!map.is_open() || !scen.is_open()) {
+        OMPL_ERROR("%s: Unable to write the scenario into ``%s``.", "ScenarioGenerator", directory.string().c_str());
+        return false;
+    }
+    map << "type octile\nheight " << spec.height_ << "\nwidth " << spec.width_ << "\nmap\n";
+    std::string row(spec.width_, '.');
+    for (int y = 0; y < spec.height_; y++) {
+        for (int x = 0; x < spec.width_; x++)
+            row[x] = grid.free(x, y) ? '.' : '@';
+        map << row << "\n";
+    }
+    // the searches of the agents are independent, and the bulk of the time on large maps
+    std::vector<double> lengths(starts.size());
+    std::atomic<std::size_t> next{0};
+    TaskGroup searches;
+    searches.runAndWait(TaskRuntime::instance().workers() + 1, [&](const std::size_t) {
+        for (std::size_t a = next++; a < starts.size(); a = next++)
+            lengths[a] = shortest_path(grid, starts[a], goals[a]);
+    });
+    scen << "version 1\n";
+    char line[512];
+    for (std::size_t a = 0; a < starts.size(); a++) {
+        const double length = lengths[a];
+        std::snprintf(line, sizeof(line), "%d\t%s\t%d\t%d\t%d\t%d\t%d\t%d\t%s\t%s\t%0.8f\n", static_cast<int>(length / 4),
+            map_file.filename().string().c_str(), spec.width_, spec.height_, starts[a] % grid.width_,
+            starts[a] / grid.width_, goals[a] % grid.width_, goals[a] / grid.width_, spec.shape_.c_str(),
+            spec.dynamics_.c_str(), length);
+        scen << line;
+    }
+    OMPL_INFORM("%s: Wrote %u agents on a %dx%d map (%zu blocked cells, seed %u) to ``%s``.", "ScenarioGenerator",
+        spec.agents_, spec.width_, spec.height_, num_blocked, seed, scen_file.string().c_str());
+    return true;
+}
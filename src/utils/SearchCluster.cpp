@@ -0,0 +1,399 @@
+#include "utils/SearchCluster.h"
+#include <ompl/util/Console.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+
+namespace
+{
+    const std::size_t header_size = 1 + 4 + 4 + 4;
+
+    void set_options(const int fd)
+    {
+        const int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    }
+
+    /* send all of n bytes on a blocking socket */
+    bool send_all(const int fd, const char *data, std::size_t n)
+    {
+        while (n > 0) {
+            const ssize_t sent = ::send(fd, data, n, MSG_NOSIGNAL);
+            if (sent <= 0)
+                return false;
+            data += sent;
+            n -= sent;
+        }
+        return true;
+    }
+
+    /* receive all of n bytes on a blocking socket within seconds, false if they did not all arrive in time */
+    bool recv_within(const int fd, char *data, std::size_t n, const double seconds)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        while (n > 0) {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            pollfd p{fd, POLLIN, 0};
+            if (left.count() <= 0 || ::poll(&p, 1, static_cast<int>(left.count())) <= 0)
+                return false;
+            const ssize_t received = ::recv(fd, data, n, 0);
+            if (received <= 0)
+                return false;
+            data += received;
+            n -= received;
+        }
+        return true;
+    }
+
+    double seconds_since(const std::chrono::steady_clock::time_point &t0)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+}
+
+SearchCluster::SearchCluster(const int rank, const int size, const std::string &host, const int port):
+    rank_(rank), size_(std::max(size, 1)), host_(host), port_(port), incumbent_(std::numeric_limits<double>::infinity())
+{
+    peers_.resize(isHub() ? size_ : 1);
+    load_.assign(size_, 0);
+    waiting_.assign(size_, false);
+}
+
+SearchCluster::~SearchCluster()
+{
+    close();
+}
+
+bool SearchCluster::connect(const double timeout)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    if (isHub()) {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        const int one = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(port_);
+        if (listen_fd_ < 0 || ::bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+            ::listen(listen_fd_, size_) != 0) {
+            OMPL_ERROR("%s: Unable to listen on port %d: %s", "SearchCluster", port_, std::strerror(errno));
+            return false;
+        }
+        // every rank introduces itself with its rank
+        for (int connected = 1; connected < size_;) {
+            const double left = timeout - seconds_since(t0);
+            pollfd p{listen_fd_, POLLIN, 0};
+            if (left <= 0 || ::poll(&p, 1, static_cast<int>(left * 1000)) <= 0) {
+                OMPL_ERROR("%s: Only %d of %d ranks connected.", "SearchCluster", connected, size_);
+                return false;
+            }
+            const int fd = ::accept(listen_fd_, nullptr, nullptr);
+            // a rank sends its rank as soon as it connects, so a silent connection is not held onto for long
+            std::int32_t rank = -1;
+            if (fd < 0 || !recv_within(fd, reinterpret_cast<char *>(&rank), sizeof(rank), std::min(left, 2.0)) ||
+                rank <= 0 || rank >= size_ || peers_[rank].fd_ >= 0) {
+                OMPL_WARN("%s: Rejected a connection that is not a new rank of the cluster (rank %d).", "SearchCluster", rank);
+                if (fd >= 0)
+                    ::close(fd);
+                continue;
+            }
+            set_options(fd);
+            peers_[rank].fd_ = fd;
+            connected++;
+        }
+        OMPL_INFORM("%s: Connected to %d ranks on port %d.", "SearchCluster", size_ - 1, port_);
+        return true;
+    }
+
+    // the hub may not be listening yet
+    addrinfo hints{}, *addrs = nullptr;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host_.c_str(), std::to_string(port_).c_str(), &hints, &addrs) != 0 || !addrs) {
+        OMPL_ERROR("%s: Unable to resolve ``%s``.", "SearchCluster", host_.c_str());
+        return false;
+    }
+    int fd = -1;
+    while (fd < 0 && seconds_since(t0) < timeout) {
+        fd = ::socket(addrs->ai_family, addrs->ai_socktype, addrs->ai_protocol);
+        if (fd >= 0 && ::connect(fd, addrs->ai_addr, addrs->ai_addrlen) != 0) {
+            ::close(fd);
+            fd = -1;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+    freeaddrinfo(addrs);
+    const std::int32_t rank = rank_;
+    if (fd < 0 || !send_all(fd, reinterpret_cast<const char *>(&rank), sizeof(rank))) {
+        OMPL_ERROR("%s: Unable to connect to %s:%d.", "SearchCluster", host_.c_str(), port_);
+        if (fd >= 0)
+            ::close(fd);
+        return false;
+    }
+    set_options(fd);
+    peers_[0].fd_ = fd;
+    OMPL_INFORM("%s: Rank %d connected to %s:%d.", "SearchCluster", rank_, host_.c_str(), port_);
+    return true;
+}
+
+void SearchCluster::close()
+{
+    // what is left to send goes out first
+    const auto t0 = std::chrono::steady_clock::now();
+    for (Peer &peer: peers_) {
+        while (peer.fd_ >= 0 && !peer.out_.empty() && seconds_since(t0) < 1.0) {
+            pollfd p{peer.fd_, POLLOUT, 0};
+            if (::poll(&p, 1, 100) > 0 && !flush_(peer))
+                break;
+        }
+        if (peer.fd_ >= 0)
+            ::close(peer.fd_);
+        peer.fd_ = -1;
+        peer.out_.clear();
+    }
+    if (listen_fd_ >= 0)
+        ::close(listen_fd_);
+    listen_fd_ = -1;
+}
+
+bool SearchCluster::send(const MessageType type, const int to, const std::string &payload)
+{
+    Message m{type, rank_, to, payload};
+    if (isHub()) {
+        route_(std::move(m));
+        return true;
+    }
+    return write_(peers_[0], m);
+}
+
+std::vector<SearchCluster::Message> SearchCluster::poll(const int wait_ms)
+{
+    std::vector<pollfd> fds;
+    std::vector<Peer *> polled;
+    for (Peer &peer: peers_) {
+        if (peer.fd_ < 0)
+            continue;
+        fds.push_back({peer.fd_, static_cast<short>(POLLIN | (peer.out_.empty() ? 0 : POLLOUT)), 0});
+        polled.push_back(&peer);
+    }
+    if (!fds.empty() && ::poll(fds.data(), fds.size(), inbox_.empty() ? wait_ms : 0) > 0) {
+        for (std::size_t i = 0; i < fds.size(); i++) {
+            Peer &peer = *polled[i];
+            bool open = true;
+            if (fds[i].revents & POLLOUT)
+                open = flush_(peer);
+            if (open && (fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                open = receive_(peer);
+            if (!open)
+                lost_(peer);
+        }
+    }
+    std::vector<Message> messages(std::make_move_iterator(inbox_.begin()), std::make_move_iterator(inbox_.end()));
+    inbox_.clear();
+    return messages;
+}
+
+void SearchCluster::finish()
+{
+    if (!isHub() || done_)
+        return;
+    done_ = true;
+    for (int r = 1; r < size_; r++)
+        write_(peers_[r], Message{DONE, rank_, r, std::string()});
+}
+
+bool SearchCluster::receive_(Peer &peer)
+{
+    char buffer[1 << 16];
+    bool open = true;
+    while (open) {
+        const ssize_t n = ::recv(peer.fd_, buffer, sizeof(buffer), 0);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            break;
+        // the frames that arrived before the connection closed are still delivered
+        open = (n > 0);
+        if (open)
+            peer.in_.append(buffer, n);
+    }
+    std::size_t pos = 0;
+    while (peer.in_.size() - pos >= header_size) {
+        std::uint8_t type;
+        std::int32_t from, to;
+        std::uint32_t length;
+        std::memcpy(&type, peer.in_.data() + pos, 1);
+        std::memcpy(&from, peer.in_.data() + pos + 1, 4);
+        std::memcpy(&to, peer.in_.data() + pos + 5, 4);
+        std::memcpy(&length, peer.in_.data() + pos + 9, 4);
+        if (peer.in_.size() - pos - header_size < length)
+            break;
+        route_(Message{static_cast<MessageType>(type), from, to, peer.in_.substr(pos + header_size, length)});
+        pos += header_size + length;
+    }
+    peer.in_.erase(0, pos);
+    return open;
+}
+
+bool SearchCluster::write_(Peer &peer, const Message &m)
+{
+    if (peer.fd_ < 0)
+        return false;
+    const std::uint8_t type = m.type_;
+    const std::int32_t from = m.from_, to = m.to_;
+    const std::uint32_t length = m.payload_.size();
+    peer.out_.append(reinterpret_cast<const char *>(&type), 1);
+    peer.out_.append(reinterpret_cast<const char *>(&from), 4);
+    peer.out_.append(reinterpret_cast<const char *>(&to), 4);
+    peer.out_.append(reinterpret_cast<const char *>(&length), 4);
+    peer.out_.append(m.payload_);
+    // the rest is sent by poll(), so two ranks sending large frames to each other never block on one another
+    if (!flush_(peer)) {
+        lost_(peer);
+        return false;
+    }
+    return true;
+}
+
+bool SearchCluster::flush_(Peer &peer)
+{
+    std::size_t pos = 0;
+    while (pos < peer.out_.size()) {
+        const ssize_t sent = ::send(peer.fd_, peer.out_.data() + pos, peer.out_.size() - pos, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                return false;
+            break;
+        }
+        pos += sent;
+    }
+    peer.out_.erase(0, pos);
+    return true;
+}
+
+void SearchCluster::lost_(Peer &peer)
+{
+    if (peer.fd_ < 0)
+        return;
+    ::close(peer.fd_);
+    peer.fd_ = -1;
+    peer.out_.clear();
+    if (!isHub()) {
+        if (!done_)
+            OMPL_WARN("%s: Lost the connection to the hub.", "SearchCluster");
+        done_ = true;
+        return;
+    }
+    // the nodes of a lost rank are lost with it, and it no longer holds up the end of the search
+    const int rank = &peer - peers_.data();
+    OMPL_WARN("%s: Lost the connection to rank %d.", "SearchCluster", rank);
+    load_[rank] = 0;
+    waiting_[rank] = true;
+    thieves_.erase(std::remove(thieves_.begin(), thieves_.end(), rank), thieves_.end());
+    checkIdle_();
+}
+
+void SearchCluster::route_(Message m)
+{
+    if (!isHub()) {
+        if (m.type_ == DONE)
+            done_ = true;
+        else if (m.type_ == INCUMBENT && m.payload_.size() >= sizeof(double)) {
+            double cost;
+            std::memcpy(&cost, m.payload_.data(), sizeof(cost));
+            incumbent_ = std::min(incumbent_, cost);
+        }
+        else
+            inbox_.push_back(std::move(m));
+        return;
+    }
+    if (m.from_ < 0 || m.from_ >= size_ || m.to_ < 0 || m.to_ >= size_)
+        return;
+    // every transfer of nodes passes through the hub, which then knows the thief has work again
+    if (m.type_ == NODES) {
+        outstanding_ -= (outstanding_ > 0) ? 1 : 0;
+        waiting_[m.to_] = false;
+    }
+    if (m.to_ != rank_) {
+        write_(peers_[m.to_], m);
+        return;
+    }
+    switch (m.type_) {
+        case STEAL:
+            waiting_[m.from_] = true;
+            load_[m.from_] = 0;
+            if (std::find(thieves_.begin(), thieves_.end(), m.from_) == thieves_.end())
+                thieves_.push_back(m.from_);
+            dispatchSteals_();
+            checkIdle_();
+            break;
+        case LOAD:
+            if (m.payload_.size() >= sizeof(std::uint64_t) && !waiting_[m.from_]) {
+                std::memcpy(&load_[m.from_], m.payload_.data(), sizeof(std::uint64_t));
+                dispatchSteals_();
+            }
+            break;
+        case SOLUTION:
+            if (m.payload_.size() >= sizeof(double)) {
+                double cost;
+                std::memcpy(&cost, m.payload_.data(), sizeof(cost));
+                if (cost < incumbent_) {
+                    incumbent_ = cost;
+                    for (int r = 1; r < size_; r++)
+                        write_(peers_[r], Message{INCUMBENT, rank_, r, m.payload_.substr(0, sizeof(double))});
+                }
+            }
+            // the hub's own solutions are already known to its search
+            if (m.from_ != rank_)
+                inbox_.push_back(std::move(m));
+            break;
+        default:
+            inbox_.push_back(std::move(m));
+            break;
+    }
+}
+
+void SearchCluster::dispatchSteals_()
+{
+    while (!thieves_.empty()) {
+        const int thief = thieves_.front();
+        int victim = -1;
+        for (int r = 0; r < size_; r++) {
+            if (r != thief && !waiting_[r] && load_[r] >= 2 && (victim < 0 || load_[r] > load_[victim]))
+                victim = r;
+        }
+        if (victim < 0)
+            return;
+        thieves_.pop_front();
+        // the victim gives away about half its queue, until it reports its load again
+        load_[victim] -= load_[victim] / 2;
+        outstanding_++;
+        Message steal{STEAL, thief, victim, std::string()};
+        if (victim == rank_)
+            inbox_.push_back(std::move(steal));
+        else if (!write_(peers_[victim], steal)) {
+            outstanding_--;
+            thieves_.push_front(thief);
+        }
+    }
+}
+
+void SearchCluster::checkIdle_()
+{
+    if (done_ || outstanding_ > 0 || std::find(waiting_.begin(), waiting_.end(), false) != waiting_.end())
+        return;
+    OMPL_INFORM("%s: Every rank ran out of nodes.", "SearchCluster");
+    finish();
+}
@@ -0,0 +1,162 @@
+#include "utils/SearchCodec.h"
+#include "Constraints/BeliefConstraint.h"
+#include "Constraints/DeterministicConstraint.h"
+#include "Spaces/RealVectorBeliefSpace.h"
+#include <type_traits>
+
+namespace ob = ompl::base;
+
+
+namespace
+{
+    enum ConstraintKind: std::uint8_t {Belief = 1, Deterministic = 2};
+    /* flag of the kind of a positive constraint */
+    const std::uint8_t positive_flag = 0x80;
+
+    static_assert(std::is_trivially_copyable<BeliefConstraint::Record>::value, "records are written as they are");
+    static_assert(std::is_trivially_copyable<RobotFootprint>::value, "footprints are written as they are");
+
+    template <typename T>
+    void write_array(ByteWriter &out, const std::vector<T> &values)
+    {
+        out.write(std::uint32_t(values.size()));
+        out.data().append(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+    }
+
+    template <typename T>
+    bool read_array(ByteReader &in, std::vector<T> &values)
+    {
+        std::uint32_t n;
+        if (!in.read(n) || n > in.remaining() / sizeof(T))
+            return false;
+        values.resize(n);
+        for (T &v: values)
+            in.read(v);
+        return true;
+    }
+}
+
+bool encodeConstraint(ByteWriter &out, const Constraint &constraint)
+{
+    const auto *belief = dynamic_cast<const BeliefConstraint *>(&constraint);
+    const auto *deterministic = dynamic_cast<const DeterministicConstraint *>(&constraint);
+    if (!belief && !deterministic)
+        return false;
+    out.write(std::uint8_t((belief ? Belief : Deterministic) | (constraint.isPositive() ? positive_flag : 0)));
+    out.write(std::int32_t(constraint.getConstrainedAgent()));
+    out.write(std::int32_t(constraint.getConstrainingAgent()));
+    write_array(out, constraint.getTimes());
+    if (belief)
+        write_array(out, belief->getRecords());
+    else
+        write_array(out, deterministic->getShapes());
+    return true;
+}
+
+ConstraintPtr decodeConstraint(ByteReader &in)
+{
+    std::uint8_t kind;
+    std::int32_t constrained, constraining;
+    std::vector<double> times;
+    if (!in.read(kind) || !in.read(constrained) || !in.read(constraining) || !read_array(in, times))
+        return nullptr;
+    const bool positive = (kind & positive_flag) != 0;
+    kind &= ~positive_flag;
+    if (kind == Belief) {
+        std::vector<BeliefConstraint::Record> records;
+        if (!read_array(in, records) || records.size() != times.size())
+            return nullptr;
+        return std::make_shared<BeliefConstraint>(constrained, constraining, std::move(times), std::move(records), positive);
+    }
+    if (kind == Deterministic) {
+        std::vector<RobotFootprint> shapes;
+        if (!read_array(in, shapes) || shapes.size() != times.size())
+            return nullptr;
+        return std::make_shared<DeterministicConstraint>(constrained, constraining, std::move(times), std::move(shapes), positive);
+    }
+    return nullptr;
+}
+
+void encodeTrajectory(ByteWriter &out, const oc::PathControl &path)
+{
+    const auto *si = static_cast<const oc::SpaceInformation *>(path.getSpaceInformation().get());
+    const bool belief = dynamic_cast<const RealVectorBeliefSpace *>(si->getStateSpace().get()) != nullptr;
+    const unsigned int control_dim = si->getControlSpace()->getDimension();
+    out.write(std::uint32_t(path.getStateCount()));
+    out.write(std::uint32_t(control_dim));
+    out.write(std::uint8_t(belief));
+    std::vector<double> reals;
+    for (const ob::State *st: path.getStates()) {
+        si->getStateSpace()->copyToReals(reals, st);
+        write_array(out, reals);
+        // sigma and lambda apart, so the belief is restored as it was planned
+        if (belief) {
+            const auto *b = st->as<RealVectorBeliefSpace::StateType>();
+            out.write(std::uint32_t(b->sigma_.rows()));
+            out.write(std::uint32_t(b->sigma_.cols()));
+            out.writeDoubles(b->sigma_.data(), b->sigma_.size());
+            out.writeDoubles(b->lambda_.data(), b->lambda_.size());
+        }
+    }
+    for (oc::Control *control: path.getControls()) {
+        for (unsigned int j = 0; j < control_dim; j++)
+            out.write(*si->getControlSpace()->getValueAddressAtIndex(control, j));
+    }
+    write_array(out, path.getControlDurations());
+}
+
+bool decodeTrajectory(ByteReader &in, const oc::SpaceInformationPtr &si, oc::PathControl &path)
+{
+    std::uint32_t num_states, control_dim;
+    std::uint8_t belief;
+    if (!in.read(num_states) || !in.read(control_dim) || !in.read(belief) || num_states == 0 ||
+        num_states > in.remaining() || control_dim != si->getControlSpace()->getDimension() ||
+        bool(belief) != (dynamic_cast<const RealVectorBeliefSpace *>(si->getStateSpace().get()) != nullptr))
+        return false;
+
+    std::vector<ob::State *> states;
+    auto free_states = [&]() {
+        for (ob::State *st: states)
+            si->freeState(st);
+    };
+    std::vector<double> reals;
+    for (std::uint32_t s = 0; s < num_states; s++) {
+        ob::State *st = si->allocState();
+        states.push_back(st);
+        if (!read_array(in, reals) || reals.size() != si->getStateSpace()->getValueLocations().size()) {
+            free_states();
+            return false;
+        }
+        si->getStateSpace()->copyFromReals(st, reals);
+        if (belief) {
+            auto *b = st->as<RealVectorBeliefSpace::StateType>();
+            std::uint32_t rows, cols;
+            if (!in.read(rows) || !in.read(cols) || rows != b->sigma_.rows() || cols != b->sigma_.cols() ||
+                !in.readDoubles(b->sigma_.data(), b->sigma_.size()) || !in.readDoubles(b->lambda_.data(), b->lambda_.size())) {
+                free_states();
+                return false;
+            }
+        }
+    }
+    std::vector<oc::Control *> controls;
+    bool valid = true;
+    for (std::uint32_t s = 0; s + 1 < num_states && valid; s++) {
+        controls.push_back(si->allocControl());
+        for (unsigned int j = 0; j < control_dim && valid; j++)
+            valid = in.read(*si->getControlSpace()->getValueAddressAtIndex(controls.back(), j));
+    }
+    std::vector<double> durations;
+    valid = valid && read_array(in, durations) && durations.size() == controls.size();
+
+    // the path keeps copies of the states and controls
+    if (valid) {
+        path = oc::PathControl(si);
+        path.append(states.front());
+        for (std::size_t c = 0; c < controls.size(); c++)
+            path.append(states[c + 1], controls[c], durations[c]);
+    }
+    free_states();
+    for (oc::Control *control: controls)
+        si->freeControl(control);
+    return valid;
+}
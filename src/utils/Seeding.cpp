@@ -0,0 +1,57 @@
+#include "utils/Seeding.h"
+#include <ompl/control/SimpleDirectedControlSampler.h>
+
+
+namespace seeding
+{
+    namespace
+    {
+        /* the generators are protected members, reached through pointers to them formed in derived classes */
+        struct StateSamplerAccess: ompl::base::StateSampler
+        {
+            static ompl::RNG ompl::base::StateSampler::*rng() {return &StateSamplerAccess::rng_;}
+        };
+
+        struct ControlSamplerAccess: ompl::control::ControlSampler
+        {
+            static ompl::RNG ompl::control::ControlSampler::*rng() {return &ControlSamplerAccess::rng_;}
+        };
+
+        struct DirectedControlSamplerAccess: ompl::control::SimpleDirectedControlSampler
+        {
+            static ompl::control::ControlSamplerPtr ompl::control::SimpleDirectedControlSampler::*sampler()
+            {
+                return &DirectedControlSamplerAccess::cs_;
+            }
+        };
+    }
+
+    std::uint32_t derive(const std::uint32_t seed, const std::uint64_t stream)
+    {
+        std::uint64_t z = (std::uint64_t(seed) << 32) + stream + 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        z ^= z >> 31;
+        const std::uint32_t derived = static_cast<std::uint32_t>(z ^ (z >> 32));
+        return (derived != 0) ? derived : 1;
+    }
+
+    void seed(ompl::base::StateSampler &sampler, const std::uint32_t seed)
+    {
+        (sampler.*StateSamplerAccess::rng()).setLocalSeed(seed);
+    }
+
+    void seed(ompl::control::ControlSampler &sampler, const std::uint32_t seed)
+    {
+        (sampler.*ControlSamplerAccess::rng()).setLocalSeed(seed);
+    }
+
+    bool seed(ompl::control::DirectedControlSampler &sampler, const std::uint32_t seed)
+    {
+        auto *simple = dynamic_cast<ompl::control::SimpleDirectedControlSampler *>(&sampler);
+        if (!simple || !(simple->*DirectedControlSamplerAccess::sampler()))
+            return false;
+        seeding::seed(*(simple->*DirectedControlSamplerAccess::sampler()), seed);
+        return true;
+    }
+}
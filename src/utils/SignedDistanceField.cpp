@@ -0,0 +1,116 @@
+#include "utils/SignedDistanceField.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+SignedDistanceField::SignedDistanceField(const std::vector<Obstacle*> &obstacles, const double x_low, const double x_high,
+    const double y_low, const double y_high, const double resolution, const std::size_t max_nodes):
+    x_low_(x_low), y_low_(y_low)
+{
+    std::vector<Ring> rings;
+    for (const Obstacle *o: obstacles) {
+        Ring ring;
+        for (const auto &pt: bg::exterior_ring(o->getPolygon()))
+            ring.points_.push_back(pt);
+        if (ring.points_.size() < 2)
+            continue;
+        ring.x_min_ = ring.y_min_ = std::numeric_limits<double>::infinity();
+        ring.x_max_ = ring.y_max_ = -std::numeric_limits<double>::infinity();
+        for (const Point &pt: ring.points_) {
+            ring.x_min_ = std::min(ring.x_min_, pt.x());
+            ring.y_min_ = std::min(ring.y_min_, pt.y());
+            ring.x_max_ = std::max(ring.x_max_, pt.x());
+            ring.y_max_ = std::max(ring.y_max_, pt.y());
+        }
+        rings.push_back(ring);
+    }
+
+    resize_(x_high, y_high, resolution, max_nodes);
+    for (long i = 0; i < nx_; i++) {
+        for (long j = 0; j < ny_; j++)
+            values_[i * ny_ + j] = signedDistance_(rings, x_low_ + i * res_, y_low_ + j * res_);
+    }
+}
+
+SignedDistanceField::SignedDistanceField(const OccupancyQuadtree &occupancy, const double x_low, const double x_high,
+    const double y_low, const double y_high, const double resolution, const std::size_t max_nodes):
+    x_low_(x_low), y_low_(y_low)
+{
+    resize_(x_high, y_high, resolution, max_nodes);
+    for (long i = 0; i < nx_; i++) {
+        for (long j = 0; j < ny_; j++)
+            values_[i * ny_ + j] = occupancy.signedDistance(x_low_ + i * res_, y_low_ + j * res_);
+    }
+}
+
+void SignedDistanceField::resize_(const double x_high, const double y_high, const double resolution,
+    const std::size_t max_nodes)
+{
+    res_ = std::max(resolution, 1e-6);
+    /* coarsen the field rather than allocating an oversized one */
+    while (true) {
+        nx_ = std::max<long>(2, std::ceil((x_high - x_low_) / res_) + 1);
+        ny_ = std::max<long>(2, std::ceil((y_high - y_low_) / res_) + 1);
+        if (static_cast<std::size_t>(nx_ * ny_) <= max_nodes)
+            break;
+        res_ *= 2;
+    }
+    if (res_ != std::max(resolution, 1e-6))
+        OMPL_WARN("%s: Resolution coarsened to %0.3f to keep the field below %lu nodes.", "SignedDistanceField", res_, max_nodes);
+    values_.resize(nx_ * ny_);
+}
+
+double SignedDistanceField::distance(const double x, const double y) const
+{
+    const long i = index_(x, x_low_, nx_);
+    const long j = index_(y, y_low_, ny_);
+    double best = -std::numeric_limits<double>::infinity();
+    for (long di = 0; di < 2; di++) {
+        for (long dj = 0; dj < 2; dj++) {
+            const double dx = x - (x_low_ + (i + di) * res_);
+            const double dy = y - (y_low_ + (j + dj) * res_);
+            best = std::max(best, values_[(i + di) * ny_ + (j + dj)] - std::sqrt(dx * dx + dy * dy));
+        }
+    }
+    return best;
+}
+
+double SignedDistanceField::signedDistance_(const std::vector<Ring> &rings, const double x, const double y)
+{
+    double best = std::numeric_limits<double>::infinity();
+    for (const Ring &ring: rings) {
+        /* the distance to the bounding box is a lower bound on the distance to the ring */
+        const double bx = std::max({0.0, ring.x_min_ - x, x - ring.x_max_});
+        const double by = std::max({0.0, ring.y_min_ - y, y - ring.y_max_});
+        const double box_d2 = bx * bx + by * by;
+        if (box_d2 > 0 && (best <= 0 || box_d2 >= best * best))
+            continue;
+
+        double d2 = std::numeric_limits<double>::infinity();
+        bool inside = false;
+        for (std::size_t k = 0; k + 1 < ring.points_.size(); k++) {
+            const double ax = ring.points_[k].x(), ay = ring.points_[k].y();
+            const double ex = ring.points_[k + 1].x() - ax, ey = ring.points_[k + 1].y() - ay;
+            const double len2 = ex * ex + ey * ey;
+            const double t = (len2 > 0) ? std::clamp(((x - ax) * ex + (y - ay) * ey) / len2, 0.0, 1.0) : 0.0;
+            const double px = ax + t * ex - x, py = ay + t * ey - y;
+            d2 = std::min(d2, px * px + py * py);
+            // crossing number of a ray towards +x
+            if ((ay > y) != (ring.points_[k + 1].y() > y) && x < ax + (y - ay) * ex / ey)
+                inside = !inside;
+        }
+        const double d = std::sqrt(d2);
+        best = std::min(best, inside ? -d : d);
+    }
+    return best;
+}
+
+long SignedDistanceField::index_(const double v, const double low, const long n) const
+{
+    /* index of the lower corner of the cell of v, the border cells extend to infinity */
+    const double idx = std::floor((v - low) / res_);
+    if (!(idx > 0))
+        return 0;
+    return std::min<long>(idx, n - 2);
+}
@@ -0,0 +1,237 @@
+#include "utils/SolutionPublisher.h"
+#include <ompl/util/Console.h>
+#include <chrono>
+#include <cstring>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define KCBS_SOLUTION_SHM
+#endif
+
+
+namespace
+{
+    const char magic[8] = {'K', 'C', 'B', 'S', 'R', 'I', 'N', 'G'};
+    const std::uint32_t version = 1;
+
+    std::size_t slot_stride(const std::uint64_t slot_bytes)
+    {
+        return sizeof(SolutionSlotHeader) + slot_bytes;
+    }
+
+    SolutionSlotHeader *slot_at(const SolutionRingHeader *ring, const std::uint64_t number)
+    {
+        char *slots = reinterpret_cast<char *>(const_cast<SolutionRingHeader *>(ring) + 1);
+        return reinterpret_cast<SolutionSlotHeader *>(slots + ((number - 1) % ring->slots_) * slot_stride(ring->slot_bytes_));
+    }
+}
+
+SolutionPublisher::~SolutionPublisher()
+{
+    close();
+}
+
+bool SolutionPublisher::open(const std::string &name, const unsigned int slots, const std::uint64_t slot_bytes)
+{
+    close();
+#ifdef KCBS_SOLUTION_SHM
+    if (slots < 2) {
+        OMPL_ERROR("%s: A ring needs at least 2 slots.", "SolutionPublisher");
+        return false;
+    }
+    const std::uint64_t bytes = (slot_bytes + 7) / 8 * 8;
+    const std::size_t size = sizeof(SolutionRingHeader) + slots * slot_stride(bytes);
+
+    // the ring of an earlier run is published on where it has this layout, so its readers keep it (and the numbers
+    // of its plans go on)
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) == size) {
+        void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED) {
+            SolutionRingHeader *ring = static_cast<SolutionRingHeader *>(data);
+            if (std::memcmp(ring->magic_, magic, sizeof(magic)) == 0 && ring->version_ == version &&
+                ring->slots_ == slots && ring->slot_bytes_ == bytes) {
+                ::close(fd);
+                ring_ = ring;
+                size_ = size;
+                // a slot left odd by a publisher that died while writing it would be even (stable to the readers)
+                // while the next plan is written to it, so it is freed and made even before anything is published
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (std::uint64_t n = 1; n <= slots; n++) {
+                    SolutionSlotHeader *slot = slot_at(ring_, n);
+                    const std::uint64_t sequence = slot->sequence_.load(std::memory_order_relaxed);
+                    if (sequence % 2 == 0)
+                        continue;
+                    slot->number_ = 0;
+                    slot->sequence_.store(sequence + 1, std::memory_order_release);
+                    OMPL_WARN("%s: Freed slot %llu of ``%s``, which was left half written.", "SolutionPublisher",
+                        static_cast<unsigned long long>(n - 1), name.c_str());
+                }
+                return true;
+            }
+            munmap(data, size);
+        }
+    }
+    if (fd >= 0)
+        ::close(fd);
+
+    // otherwise it is replaced by a new one
+    shm_unlink(name.c_str());
+    fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        OMPL_ERROR("%s: Unable to create the shared memory ``%s``.", "SolutionPublisher", name.c_str());
+        return false;
+    }
+    void *data = (ftruncate(fd, size) == 0) ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        OMPL_ERROR("%s: Unable to map the shared memory ``%s``.", "SolutionPublisher", name.c_str());
+        shm_unlink(name.c_str());
+        return false;
+    }
+    // a new segment is zeroed, so every slot is free (number 0) and even. The magic goes last, once the rest is set
+    ring_ = static_cast<SolutionRingHeader *>(data);
+    size_ = size;
+    ring_->version_ = version;
+    ring_->slots_ = slots;
+    ring_->slot_bytes_ = bytes;
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(ring_->magic_, magic, sizeof(magic));
+    return true;
+#else
+    OMPL_ERROR("%s: Shared memory is unavailable on this platform.", "SolutionPublisher");
+    return false;
+#endif
+}
+
+void SolutionPublisher::close()
+{
+#ifdef KCBS_SOLUTION_SHM
+    if (ring_)
+        munmap(ring_, size_);
+#endif
+    ring_ = nullptr;
+    size_ = 0;
+}
+
+std::uint64_t SolutionPublisher::publish(const std::vector<oc::PathControl*> &plan)
+{
+    if (!ring_)
+        return 0;
+    const std::uint64_t bytes = trajectoryImageSize(plan);
+    if (bytes > ring_->slot_bytes_) {
+        OMPL_WARN("%s: A plan of %llu bytes does not fit in the slots of %llu bytes, not published.", "SolutionPublisher",
+            static_cast<unsigned long long>(bytes), static_cast<unsigned long long>(ring_->slot_bytes_));
+        return 0;
+    }
+    // the threads of a process take turns, as a seqlock has one writer
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::uint64_t number = ring_->published_.load(std::memory_order_relaxed) + 1;
+    SolutionSlotHeader *slot = slot_at(ring_, number);
+    const std::uint64_t sequence = slot->sequence_.load(std::memory_order_relaxed);
+    slot->sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->number_ = number;
+    slot->stamp_ = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    slot->bytes_ = bytes;
+    writeTrajectoryImage(plan, reinterpret_cast<char *>(slot + 1));
+    slot->sequence_.store(sequence + 2, std::memory_order_release);
+    ring_->published_.store(number, std::memory_order_release);
+    return number;
+}
+
+SolutionSubscriber::~SolutionSubscriber()
+{
+    close();
+}
+
+bool SolutionSubscriber::open(const std::string &name)
+{
+    close();
+#ifdef KCBS_SOLUTION_SHM
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(SolutionRingHeader)) {
+        if (fd >= 0)
+            ::close(fd);
+        OMPL_ERROR("%s: No solution ring ``%s``.", "SolutionSubscriber", name.c_str());
+        return false;
+    }
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        OMPL_ERROR("%s: Unable to map the shared memory ``%s``.", "SolutionSubscriber", name.c_str());
+        return false;
+    }
+    ring_ = static_cast<const SolutionRingHeader *>(data);
+    size_ = st.st_size;
+    const bool valid = std::memcmp(ring_->magic_, magic, sizeof(magic)) == 0 && ring_->version_ == version &&
+        ring_->slots_ > 0 && sizeof(SolutionRingHeader) + ring_->slots_ * slot_stride(ring_->slot_bytes_) <= size_;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!valid) {
+        OMPL_ERROR("%s: ``%s`` is not a solution ring of version %u.", "SolutionSubscriber", name.c_str(), version);
+        close();
+        return false;
+    }
+    return true;
+#else
+    OMPL_ERROR("%s: Shared memory is unavailable on this platform.", "SolutionSubscriber");
+    return false;
+#endif
+}
+
+void SolutionSubscriber::close()
+{
+#ifdef KCBS_SOLUTION_SHM
+    if (ring_)
+        munmap(const_cast<SolutionRingHeader *>(ring_), size_);
+#endif
+    ring_ = nullptr;
+    size_ = 0;
+}
+
+std::uint64_t SolutionSubscriber::latest() const
+{
+    return ring_ ? ring_->published_.load(std::memory_order_acquire) : 0;
+}
+
+bool SolutionSubscriber::copy(const std::uint64_t after, std::vector<char> &image, std::uint64_t &number) const
+{
+    double stamp = 0;
+    return copy_(after, image, number, stamp);
+}
+
+bool SolutionSubscriber::copy_(const std::uint64_t after, std::vector<char> &image, std::uint64_t &number,
+    double &stamp) const
+{
+    const SolutionSlotHeader *slot = nullptr;
+    std::uint64_t sequence = 0;
+    if (!begin_(after, slot, number, sequence))
+        return false;
+    stamp = slot->stamp_;
+    const std::uint64_t bytes = slot->bytes_;
+    image.resize((bytes <= ring_->slot_bytes_) ? bytes : 0);
+    std::memcpy(image.data(), image_(slot), image.size());
+    return end_(slot, sequence) && image.size() == bytes;
+}
+
+bool SolutionSubscriber::begin_(const std::uint64_t after, const SolutionSlotHeader *&slot, std::uint64_t &number,
+    std::uint64_t &sequence) const
+{
+    number = latest();
+    if (number <= after)
+        return false;
+    slot = slot_at(ring_, number);
+    sequence = slot->sequence_.load(std::memory_order_acquire);
+    // odd while written, and a later plan if the publisher went round the ring since
+    return sequence % 2 == 0 && slot->number_ == number;
+}
+
+bool SolutionSubscriber::end_(const SolutionSlotHeader *slot, const std::uint64_t sequence) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot->sequence_.load(std::memory_order_relaxed) == sequence;
+}
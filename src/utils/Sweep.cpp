@@ -0,0 +1,334 @@
+#include "utils/Sweep.h"
+#include "utils/ScenarioGenerator.h"
+#include "utils/Seeding.h"
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <sstream>
+
+
+namespace
+{
+    /* the files with extension of every entry (a file, or a directory of them), sorted */
+    std::vector<fs::path> list_files(const std::vector<std::string> &entries, const std::string &extension)
+    {
+        std::vector<fs::path> files;
+        for (const std::string &entry: entries) {
+            const fs::path path(entry);
+            if (fs::is_directory(path)) {
+                for (const fs::directory_entry &f: fs::directory_iterator(path)) {
+                    if (f.is_regular_file() && f.path().extension() == extension)
+                        files.push_back(f.path());
+                }
+            }
+            else if (fs::exists(path))
+                files.push_back(path);
+            else
+                OMPL_WARN("%s: ``%s`` does not exist.", "Sweep", entry.c_str());
+        }
+        std::sort(files.begin(), files.end());
+        files.erase(std::unique(files.begin(), files.end()), files.end());
+        return files;
+    }
+
+    /* the numbers of agents of "k" or "first:last[:step]". False if range is not one */
+    bool parse_agents(const std::string &range, std::vector<int> &ks)
+    {
+        std::vector<int> v;
+        std::stringstream ss(range);
+        std::string token;
+        while (std::getline(ss, token, ':')) {
+            const int k = atoi(token.c_str());
+            if (k <= 0)
+                return false;
+            v.push_back(k);
+        }
+        if (v.empty() || v.size() > 3)
+            return false;
+        const int last = (v.size() > 1) ? v[1] : v[0];
+        const int step = (v.size() > 2) ? v[2] : 1;
+        for (int k = v[0]; k <= last; k += step)
+            ks.push_back(k);
+        return true;
+    }
+
+    /* the entries of key in the manifest, or the value of the command line */
+    std::vector<std::string> entries(const po::variables_map &manifest, const po::variables_map &vm, const std::string &key)
+    {
+        if (manifest.count(key))
+            return manifest[key].as<std::vector<std::string>>();
+        if (vm.count(key))
+            return {vm[key].as<std::string>()};
+        return {};
+    }
+
+    void set_option(po::variables_map &vm, const std::string &key, const boost::any &value)
+    {
+        // variables_map only exposes its values to read, they are written through the map it is
+        static_cast<std::map<std::string, po::variable_value> &>(vm)[key] = po::variable_value(value, false);
+    }
+
+    /* the width and height of "<width>x<height>". False if size is not one */
+    bool parse_size(const std::string &size, int &width, int &height)
+    {
+        const std::size_t x = size.find('x');
+        if (x == std::string::npos)
+            return false;
+        width = atoi(size.substr(0, x).c_str());
+        height = atoi(size.substr(x + 1).c_str());
+        return width > 0 && height > 0;
+    }
+
+    /* The rows of a sweep go on to its sink, and the trials of every configuration are summarized into a row of the
+       scaling table: its success rate, the median and mean of its computation times, its mean expansions and its
+       peak memory (of the process, and of every subsystem with alloc columns) */
+    class ScalingSummary: public ResultsSink
+    {
+    public:
+        ScalingSummary(ResultsSinkPtr sink): ResultsSink(sink->getFilename()), sink_(sink) {}
+
+        ~ScalingSummary() override
+        {
+            close_();
+        }
+
+        /* write the summary of the rows so far to filename */
+        void write(const std::string &filename)
+        {
+            flush();
+            sink_->flush();
+            ResultsSinkPtr out = make_results_sink(filename);
+            for (const Configuration &c: configurations_) {
+                ResultRow row;
+                row.fields_ = c.key_;
+                std::vector<double> times(c.times_);
+                std::sort(times.begin(), times.end());
+                const double trials = times.size();
+                const double median = times.empty() ? 0.0 : (times.size() % 2 == 1) ? times[times.size() / 2] :
+                    (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2;
+                row.add("Trials", times.size());
+                row.add("Success Rate", trials > 0 ? c.successes_ / trials : 0.0);
+                row.add("Median Time (s)", median);
+                row.add("Mean Time (s)", trials > 0 ? std::accumulate(times.begin(), times.end(), 0.0) / trials : 0.0);
+                row.add("Mean Nodes Expanded", trials > 0 ? c.expansions_ / trials : 0.0);
+                for (const std::pair<std::string, double> &peak: c.peaks_)
+                    row.add("Max " + peak.first, peak.second);
+                out->write(std::move(row));
+            }
+            out->flush();
+            OMPL_INFORM("%s: Wrote the scaling of %zu configurations to ``%s``.", "Sweep", configurations_.size(),
+                filename.c_str());
+        }
+
+    protected:
+        void writeRows_(const std::vector<ResultRow> &rows) override
+        {
+            for (const ResultRow &row: rows) {
+                sink_->write(row);
+                add_(row);
+            }
+        }
+
+    private:
+        struct Configuration
+        {
+            std::vector<ResultRow::Field> key_;
+            std::vector<double> times_;
+            unsigned int successes_{0};
+            double expansions_{0};
+            std::vector<std::pair<std::string, double>> peaks_;  // largest value of every peak column
+        };
+
+        void add_(const ResultRow &row)
+        {
+            static const std::vector<std::string> keys{"Map", "Map Width", "Map Height", "Agents", "Solver",
+                "Low-Level", "PVC", "SVC"};
+            std::vector<ResultRow::Field> key;
+            std::string id;
+            for (const ResultRow::Field &f: row.fields_) {
+                if (std::find(keys.begin(), keys.end(), f.name_) != keys.end()) {
+                    key.push_back(f);
+                    id += f.value_ + '\t';
+                }
+            }
+            auto itr = index_.find(id);
+            if (itr == index_.end()) {
+                itr = index_.emplace(id, configurations_.size()).first;
+                configurations_.emplace_back();
+                configurations_.back().key_ = key;
+            }
+            Configuration &c = configurations_[itr->second];
+            for (const ResultRow::Field &f: row.fields_) {
+                if (f.name_ == "Computation Time (s)")
+                    c.times_.push_back(std::stod(f.value_));
+                else if (f.name_ == "Success (Boolean)")
+                    c.successes_ += (f.value_ == "1");
+                else if (f.name_ == "Nodes Expanded")
+                    c.expansions_ += std::stod(f.value_);
+                else if (f.name_ == "Peak RSS (bytes)" || ends_with_(f.name_, " Peak Bytes")) {
+                    auto peak = std::find_if(c.peaks_.begin(), c.peaks_.end(),
+                        [&f](const std::pair<std::string, double> &p) {return p.first == f.name_;});
+                    if (peak == c.peaks_.end())
+                        c.peaks_.push_back({f.name_, std::stod(f.value_)});
+                    else
+                        peak->second = std::max(peak->second, std::stod(f.value_));
+                }
+            }
+        }
+
+        static bool ends_with_(const std::string &s, const std::string &suffix)
+        {
+            return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+        }
+
+        ResultsSinkPtr sink_;
+        // only touched by the writer thread, until write() flushed it
+        std::vector<Configuration> configurations_;
+        std::map<std::string, std::size_t> index_;
+    };
+}
+
+void run_sweep(const po::variables_map &vm, const std::string &manifest, const BenchmarkOptions &options)
+{
+    po::options_description desc("Sweep manifest");
+    desc.add_options()
+        ("map", po::value<std::vector<std::string>>()->composing(), "*.map file or directory")
+        ("scen", po::value<std::vector<std::string>>()->composing(), "*.scen file or directory")
+        ("agents", po::value<std::vector<std::string>>()->composing(), "number of agents, or first:last[:step]")
+        ("solver", po::value<std::vector<std::string>>()->composing(), "high-level MRMP solver")
+        ("lowlevel", po::value<std::vector<std::string>>()->composing(), "low-level motion planner")
+        ("pvc", po::value<std::vector<std::string>>()->composing(), "plan validity checker")
+        ("svc", po::value<std::vector<std::string>>()->composing(), "state validity checker")
+        ("generate", po::value<std::vector<std::string>>()->composing(), "size of a generated map, <width>x<height>")
+        ("density", po::value<double>()->default_value(0.1), "fraction of blocked cells of the generated maps")
+        ("dynamics", po::value<std::string>()->default_value("2D-Uncertain-Linear-Model"), "dynamics model of the generated agents")
+        ("shape", po::value<std::string>()->default_value("Point"), "shape of the generated agents")
+        ("generated", po::value<std::string>()->default_value("generated"), "directory of the generated maps and scens")
+        ("summary", po::value<std::string>(), "scaling table, a row per configuration")
+        ("trials", po::value<unsigned int>(), "number of trials per configuration")
+        ("workers", po::value<unsigned int>(), "number of trials run at once")
+        ("output", po::value<std::string>(), "results file");
+    std::ifstream file(manifest);
+    if (!file.is_open()) {
+        OMPL_ERROR("%s: Unable to open the manifest ``%s``.", "Sweep", manifest.c_str());
+        return;
+    }
+    po::variables_map sweep;
+    try {
+        po::store(po::parse_config_file(file, desc), sweep);
+    }
+    catch (const po::error &e) {
+        OMPL_ERROR("%s: Invalid manifest ``%s``: %s", "Sweep", manifest.c_str(), e.what());
+        return;
+    }
+
+    std::vector<fs::path> maps = list_files(entries(sweep, vm, "map"), ".map");
+    std::vector<fs::path> scens = list_files(entries(sweep, vm, "scen"), ".scen");
+    std::vector<int> ks;
+    if (sweep.count("agents")) {
+        for (const std::string &range: sweep["agents"].as<std::vector<std::string>>()) {
+            if (!parse_agents(range, ks))
+                OMPL_WARN("%s: Skipping the number of agents ``%s``.", "Sweep", range.c_str());
+        }
+    }
+    else if (vm.count("numAgents"))
+        ks.push_back(vm["numAgents"].as<int>());
+    // a map of every generated size, with a scen of the largest k (whose first agents are the smaller k)
+    if (sweep.count("generate")) {
+        const std::vector<std::string> &sizes = sweep["generate"].as<std::vector<std::string>>();
+        for (std::size_t g = 0; g < sizes.size(); g++) {
+            ScenarioSpec spec;
+            if (!parse_size(sizes[g], spec.width_, spec.height_) || ks.empty()) {
+                OMPL_WARN("%s: Skipping the generated map ``%s``.", "Sweep", sizes[g].c_str());
+                continue;
+            }
+            spec.density_ = sweep["density"].as<double>();
+            spec.agents_ = *std::max_element(ks.begin(), ks.end());
+            spec.dynamics_ = sweep["dynamics"].as<std::string>();
+            spec.shape_ = sweep["shape"].as<std::string>();
+            spec.seed_ = (options.seed_ != 0) ? seeding::derive(options.seed_, g) : 0;
+            fs::path map, scen;
+            if (!generate_scenario(spec, sweep["generated"].as<std::string>(), map, scen))
+                continue;
+            maps.push_back(map);
+            scens.push_back(scen);
+        }
+    }
+    const std::vector<std::string> solvers = entries(sweep, vm, "solver");
+    const std::vector<std::string> low_levels = entries(sweep, vm, "lowlevel");
+    const std::vector<std::string> pvcs = entries(sweep, vm, "pvc");
+    const std::vector<std::string> svcs = entries(sweep, vm, "svc");
+    const std::string output = sweep.count("output") ? sweep["output"].as<std::string>() : vm["output"].as<std::string>();
+
+    BenchmarkOptions run_options(options);
+    if (sweep.count("trials"))
+        run_options.trials_ = sweep["trials"].as<unsigned int>();
+    if (sweep.count("workers"))
+        run_options.workers_ = sweep["workers"].as<unsigned int>();
+    // the rows of all planners share the columns of the table, and the file is opened once for all of them
+    run_options.kcbs_columns_ = true;
+    run_options.sink_ = make_results_sink(output);
+    std::shared_ptr<ScalingSummary> summary = nullptr;
+    if (sweep.count("summary")) {
+        summary = std::make_shared<ScalingSummary>(run_options.sink_);
+        run_options.sink_ = summary;
+    }
+
+    // the first instance of every map, whose obstacles and geometry the others share
+    std::map<fs::path, InstancePtr> map_instances;
+    unsigned int configurations = 0;
+    for (const fs::path &map: maps) {
+        const std::string prefix = map.stem().string() + "-";
+        for (const fs::path &scen: scens) {
+            if (scen.filename().string().compare(0, prefix.size(), prefix) != 0)
+                continue;
+            for (const int k: ks) {
+                for (const std::string &solver: solvers) {
+                    // the low-level planner and the validity checkers are only swept where they are used
+                    const bool kcbs = (solver == "K-CBS");
+                    for (std::size_t l = 0; l < (kcbs ? low_levels.size() : 1); l++) {
+                        const bool belief = (!kcbs || low_levels[l] == "BSST");
+                        for (std::size_t c = 0; c < ((kcbs && belief) ? pvcs.size() : 1); c++) {
+                            for (std::size_t v = 0; v < (belief ? svcs.size() : 1); v++) {
+                                po::variables_map config(vm);
+                                set_option(config, "map", map.string());
+                                set_option(config, "scen", scen.string());
+                                set_option(config, "numAgents", k);
+                                set_option(config, "solver", solver);
+                                set_option(config, "lowlevel", low_levels[l]);
+                                set_option(config, "pvc", pvcs[c]);
+                                set_option(config, "svc", svcs[v]);
+                                InstancePtr &map_instance = map_instances[map];
+                                if (!map_instance)
+                                    map_instance = std::make_shared<Instance>(config);
+                                // the size of the map, the variable of the scaling in k's stead
+                                const std::vector<double> dimensions = map_instance->getDimensions();
+                                run_options.labels_ = options.labels_;
+                                run_options.labels_.push_back({"Map Width", std::to_string(int(dimensions[0]))});
+                                run_options.labels_.push_back({"Map Height", std::to_string(int(dimensions[1]))});
+                                InstanceFactory make_instance = [&map_instance, config]() {
+                                    po::variables_map worker_config(config);
+                                    return std::make_shared<Instance>(*map_instance, worker_config);
+                                };
+                                OMPL_INFORM("%s: %s, %s, k = %d, %s w/ %s (%s, %s).", "Sweep", map.filename().c_str(),
+                                    scen.filename().c_str(), k, solver.c_str(), low_levels[l].c_str(), pvcs[c].c_str(), svcs[v].c_str());
+                                if (kcbs)
+                                    run_kcbs_benchmark(make_instance, vm["bound"].as<int>(), vm["time"].as<double>(), output, run_options);
+                                else if (solver == "CentralizedBSST")
+                                    run_centralized_bsst_benchmark(make_instance, vm["time"].as<double>(), output, run_options);
+                                else {
+                                    OMPL_WARN("%s: Benchmarking %s is unavailable.", "Sweep", solver.c_str());
+                                    continue;
+                                }
+                                configurations++;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    OMPL_INFORM("%s: Ran %u configurations into ``%s``.", "Sweep", configurations, output.c_str());
+    if (summary)
+        summary->write(sweep["summary"].as<std::string>());
+}
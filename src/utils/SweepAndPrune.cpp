@@ -0,0 +1,65 @@
+#include "utils/SweepAndPrune.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+
+void SweepAndPrune::resize(const std::size_t n)
+{
+    if (order_.size() == n)
+        return;
+    boxes_.resize(n);
+    order_.resize(n);
+    parked_.assign(n, false);
+    std::iota(order_.begin(), order_.end(), 0);
+}
+
+void SweepAndPrune::setBox(const std::size_t i, const double min_x, const double max_x, const double min_y, const double max_y)
+{
+    if (std::isnan(min_x) || std::isnan(max_x) || std::isnan(min_y) || std::isnan(max_y)) {
+        const double inf = std::numeric_limits<double>::infinity();
+        boxes_[i] = {-inf, inf, -inf, inf};
+        return;
+    }
+    boxes_[i] = {min_x, max_x, min_y, max_y};
+}
+
+const std::vector<std::pair<int, int>> &SweepAndPrune::sweep()
+{
+    pairs_.clear();
+    if (candidates_) {
+        for (const std::pair<int, int> &ij: *candidates_) {
+            if (parked_[ij.first] && parked_[ij.second])
+                continue;
+            const Box &a = boxes_[ij.first];
+            const Box &b = boxes_[ij.second];
+            if (!(b.min_x_ > a.max_x_ || a.min_x_ > b.max_x_ || b.min_y_ > a.max_y_ || a.min_y_ > b.max_y_))
+                pairs_.push_back(ij);
+        }
+        return pairs_;
+    }
+
+    // insertion sort by min x, starting from the order of the previous sweep
+    for (std::size_t k = 1; k < order_.size(); k++) {
+        const int i = order_[k];
+        std::size_t l = k;
+        for (; l > 0 && boxes_[order_[l - 1]].min_x_ > boxes_[i].min_x_; l--)
+            order_[l] = order_[l - 1];
+        order_[l] = i;
+    }
+
+    for (std::size_t k = 0; k < order_.size(); k++) {
+        const Box &a = boxes_[order_[k]];
+        const bool parked = parked_[order_[k]];
+        for (std::size_t l = k + 1; l < order_.size() && boxes_[order_[l]].min_x_ <= a.max_x_; l++) {
+            const Box &b = boxes_[order_[l]];
+            if (parked && parked_[order_[l]])
+                continue;
+            if (b.max_x_ >= a.min_x_ && b.min_y_ <= a.max_y_ && b.max_y_ >= a.min_y_)
+                pairs_.emplace_back(std::min(order_[k], order_[l]), std::max(order_[k], order_[l]));
+        }
+    }
+    std::sort(pairs_.begin(), pairs_.end());
+    return pairs_;
+}
@@ -0,0 +1,166 @@
+#include "utils/TaskRuntime.h"
+#include <algorithm>
+
+namespace
+{
+    /* the runtime the calling thread is a worker of, and its index there */
+    thread_local const TaskRuntime *current_runtime = nullptr;
+    thread_local unsigned int current_index = 0;
+}
+
+
+TaskRuntime &TaskRuntime::instance()
+{
+    static TaskRuntime runtime(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return runtime;
+}
+
+TaskRuntime::TaskRuntime(const unsigned int workers)
+{
+    for (unsigned int w = 0; w <= workers; w++)
+        queues_.push_back(std::make_unique<Queue>());
+    for (unsigned int w = 1; w <= workers; w++)
+        threads_.emplace_back(&TaskRuntime::work_, this, w);
+}
+
+TaskRuntime::~TaskRuntime()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread &t: threads_)
+        t.join();
+}
+
+unsigned int TaskRuntime::threadIndex()
+{
+    return current_index;
+}
+
+ompl::RNG &TaskRuntime::rng()
+{
+    static thread_local ompl::RNG rng;
+    return rng;
+}
+
+void TaskRuntime::push_(Task task)
+{
+    const unsigned int index = (current_runtime == this) ? current_index : 0;
+    {
+        // counted first (under the lock of the sleepers, so a worker about to sleep sees it), as a pop uncounts it
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        queued_++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex_);
+        queues_[index]->tasks_.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+bool TaskRuntime::pop_(const unsigned int index, Task &task)
+{
+    {
+        Queue &own = *queues_[index];
+        std::lock_guard<std::mutex> lock(own.mutex_);
+        if (!own.tasks_.empty()) {
+            task = std::move(own.tasks_.back());
+            own.tasks_.pop_back();
+            queued_--;
+            return true;
+        }
+    }
+    // steal the oldest task of another deque, starting after the own one so the thieves spread out
+    for (std::size_t k = 1; k < queues_.size(); k++) {
+        Queue &other = *queues_[(index + k) % queues_.size()];
+        std::lock_guard<std::mutex> lock(other.mutex_);
+        if (!other.tasks_.empty()) {
+            task = std::move(other.tasks_.front());
+            other.tasks_.pop_front();
+            queued_--;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TaskRuntime::popOf_(const TaskGroup *group, Task &task)
+{
+    if (group->queued_ == 0)
+        return false;
+    for (const std::unique_ptr<Queue> &queue: queues_) {
+        std::lock_guard<std::mutex> lock(queue->mutex_);
+        auto itr = std::find_if(queue->tasks_.begin(), queue->tasks_.end(), [group](const Task &t) {return t.group_ == group;});
+        if (itr != queue->tasks_.end()) {
+            task = std::move(*itr);
+            queue->tasks_.erase(itr);
+            queued_--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskRuntime::execute_(Task &task)
+{
+    TaskGroup *group = task.group_;
+    group->queued_--;
+    if (!group->cancelled())
+        task.fn_();
+    // the task (and what it holds) goes before its group may
+    task.fn_ = nullptr;
+    group->finish_();
+}
+
+void TaskRuntime::work_(const unsigned int index)
+{
+    current_runtime = this;
+    current_index = index;
+    while (true) {
+        Task task;
+        if (pop_(index, task)) {
+            execute_(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [this]() {return stop_ || queued_ > 0;});
+        if (stop_ && queued_ == 0)
+            return;
+    }
+}
+
+void TaskGroup::run(std::function<void()> task)
+{
+    pending_++;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_++;
+    }
+    runtime_.push_(TaskRuntime::Task{this, std::move(task)});
+    // a waiter runs the task if no worker does
+    done_.notify_all();
+}
+
+void TaskGroup::wait()
+{
+    while (pending_ > 0) {
+        TaskRuntime::Task task;
+        if (runtime_.popOf_(this, task)) {
+            runtime_.execute_(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this]() {return pending_ == 0 || queued_ > 0;});
+    }
+    // the last finish_ may still hold the lock, which must be released before the group goes
+    std::lock_guard<std::mutex> lock(mutex_);
+}
+
+void TaskGroup::finish_()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--pending_ == 0)
+        done_.notify_all();
+}
@@ -0,0 +1,87 @@
+#include "utils/Trace.h"
+
+#ifdef KCBS_TRACING
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <ompl/util/Console.h>
+
+namespace trace
+{
+	namespace
+	{
+		/* the registry keeps the buffers of finished threads alive until the dump */
+		struct Registry
+		{
+			std::mutex mutex_;
+			std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+			const std::chrono::steady_clock::time_point epoch_{std::chrono::steady_clock::now()};
+		};
+
+		Registry &registry()
+		{
+			static Registry r;
+			return r;
+		}
+
+		void writeEscaped(std::ofstream &out, const char *s)
+		{
+			for (; *s; s++) {
+				if (*s == '"' || *s == '\\')
+					out << '\\';
+				out << *s;
+			}
+		}
+	}
+
+	ThreadBuffer &threadBuffer()
+	{
+		thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+			Registry &r = registry();
+			std::lock_guard<std::mutex> lock(r.mutex_);
+			auto b = std::make_shared<ThreadBuffer>(r.buffers_.size());
+			r.buffers_.push_back(b);
+			return b;
+		}();
+		return *buffer;
+	}
+
+	std::int64_t now()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - registry().epoch_).count();
+	}
+
+	bool dump(const std::string &filename)
+	{
+		std::ofstream out(filename);
+		if (!out) {
+			OMPL_ERROR("Unable to open %s for writing the trace.", filename.c_str());
+			return false;
+		}
+		Registry &r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex_);
+		std::size_t n_events = 0;
+		out << "{\"traceEvents\":[";
+		for (const auto &b: r.buffers_) {
+			const std::size_t head = b->head();
+			const std::size_t first = (head > ThreadBuffer::capacity_) ? head - ThreadBuffer::capacity_ : 0;
+			if (first > 0)
+				OMPL_WARN("Trace buffer of thread %u overflowed, dropped %zu events.", b->getThreadId(), first);
+			for (std::size_t i = first; i < head; i++) {
+				const Event &e = b->at(i);
+				out << (n_events++ > 0 ? ",\n" : "\n") << "{\"name\":\"";
+				writeEscaped(out, e.name_);
+				out << "\",\"ph\":\"X\",\"ts\":" << e.begin_us_ << ",\"dur\":" << (e.end_us_ - e.begin_us_)
+					<< ",\"pid\":0,\"tid\":" << b->getThreadId() << "}";
+			}
+		}
+		out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+		OMPL_INFORM("Wrote %zu trace events of %zu threads to %s.", n_events, r.buffers_.size(), filename.c_str());
+		return true;
+	}
+}
+
+#endif
@@ -0,0 +1,61 @@
+#include "utils/TrajectoryBVH.h"
+#include "utils/BeliefTrajectories.h"
+#include "utils/DiskGeometry.h"
+#include <cmath>
+
+
+TrajectoryBVH::TrajectoryBVH(const oc::PathControl &traj)
+{
+    const int n = traj.getStateCount();
+    if (n == 0)
+        return;
+
+    std::vector<Node> leaves;
+    leaves.reserve(n / leaf_steps_ + 1);
+    Node last{};
+    for (int k = 0; k < n; k++) {
+        double x, y, s_xx, s_xy, s_yy;
+        BeliefTrajectories::extract(traj.getState(k), x, y, s_xx, s_xy, s_yy);
+        Eigen::Matrix2d Sigma;
+        Sigma << s_xx, s_xy, s_xy, s_yy;
+        const double lambda = maxEigenvalue2x2(Sigma);
+        last = {x, x, y, y, lambda, std::sqrt(std::max(lambda, 0.0)), k, k};
+        if (k % leaf_steps_ == 0) {
+            leaves.push_back(last);
+            continue;
+        }
+        Node &leaf = leaves.back();
+        leaf.min_x_ = std::min(leaf.min_x_, x);
+        leaf.max_x_ = std::max(leaf.max_x_, x);
+        leaf.min_y_ = std::min(leaf.min_y_, y);
+        leaf.max_y_ = std::max(leaf.max_y_, y);
+        leaf.max_lambda_ = std::max(leaf.max_lambda_, lambda);
+        leaf.max_sqrt_lambda_ = std::max(leaf.max_sqrt_lambda_, last.max_sqrt_lambda_);
+        leaf.last_step_ = k;
+    }
+
+    nodes_.reserve(2 * leaves.size());
+    root_ = build_(leaves, 0, leaves.size());
+    // the robot stays at its last belief once its trajectory ends
+    last.first_step_ = n;
+    last.last_step_ = std::numeric_limits<int>::max();
+    tail_ = nodes_.size();
+    nodes_.push_back(last);
+}
+
+int TrajectoryBVH::build_(const std::vector<Node> &leaves, const std::size_t first, const std::size_t last)
+{
+    if (last - first == 1) {
+        nodes_.push_back(leaves[first]);
+        return nodes_.size() - 1;
+    }
+    const std::size_t mid = first + (last - first) / 2;
+    const int left = build_(leaves, first, mid);
+    const int right = build_(leaves, mid, last);
+    const Node &l = nodes_[left];
+    const Node &r = nodes_[right];
+    Node node{std::min(l.min_x_, r.min_x_), std::max(l.max_x_, r.max_x_), std::min(l.min_y_, r.min_y_), std::max(l.max_y_, r.max_y_),
+        std::max(l.max_lambda_, r.max_lambda_), std::max(l.max_sqrt_lambda_, r.max_sqrt_lambda_), l.first_step_, r.last_step_, left, right};
+    nodes_.push_back(node);
+    return nodes_.size() - 1;
+}
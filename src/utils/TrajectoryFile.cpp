@@ -0,0 +1,282 @@
+#include "utils/TrajectoryFile.h"
+#include "Spaces/RealVectorBeliefSpace.h"
+#include <ompl/control/SpaceInformation.h>
+#include <ompl/util/Console.h>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define KCBS_TRAJECTORY_MMAP
+#endif
+
+namespace ob = ompl::base;
+
+
+namespace
+{
+    const char magic[8] = {'K', 'C', 'B', 'S', 'T', 'R', 'A', 'J'};
+    const std::uint32_t version = 1;
+    const std::uint32_t byte_order = 0x01020304;
+
+    /* the dimensions of the arrays of path */
+    TrajectoryFileAgent dimensions(oc::PathControl &path)
+    {
+        const auto *si = static_cast<const oc::SpaceInformation *>(path.getSpaceInformation().get());
+        TrajectoryFileAgent agent{};
+        agent.states_ = path.getStateCount();
+        agent.state_dim_ = si->getStateSpace()->getValueLocations().size();
+        if (agent.states_ > 0 && dynamic_cast<const RealVectorBeliefSpace *>(si->getStateSpace().get())) {
+            const Eigen::MatrixXd cov = path.getState(0)->as<RealVectorBeliefSpace::StateType>()->getCovariance();
+            agent.cov_rows_ = cov.rows();
+            agent.cov_cols_ = cov.cols();
+        }
+        agent.control_dim_ = si->getControlSpace()->getDimension();
+        return agent;
+    }
+
+    std::uint64_t array_bytes(const std::uint64_t count)
+    {
+        return count * sizeof(double);
+    }
+
+    /* the table of plan, and the size of its file. The table comes first, since the offsets of every array follow
+       from the dimensions of all of them */
+    std::uint64_t layout(const std::vector<oc::PathControl*> &plan, std::vector<TrajectoryFileAgent> &agents)
+    {
+        agents.clear();
+        std::uint64_t offset = sizeof(TrajectoryFileHeader) + plan.size() * sizeof(TrajectoryFileAgent);
+        for (oc::PathControl *path: plan) {
+            TrajectoryFileAgent agent = dimensions(*path);
+            const std::uint64_t steps = (agent.states_ > 0) ? agent.states_ - 1 : 0;
+            agent.means_ = offset;
+            offset += array_bytes(std::uint64_t(agent.states_) * agent.state_dim_);
+            agent.covariances_ = offset;
+            offset += array_bytes(std::uint64_t(agent.states_) * agent.cov_rows_ * agent.cov_cols_);
+            agent.controls_ = offset;
+            offset += array_bytes(steps * agent.control_dim_);
+            agent.durations_ = offset;
+            offset += array_bytes(steps);
+            agents.push_back(agent);
+        }
+        return offset;
+    }
+
+    /* the bytes of the file of plan, in order, through write(data, bytes) */
+    template <typename Write>
+    void emit(const std::vector<oc::PathControl*> &plan, const std::vector<TrajectoryFileAgent> &agents, Write write)
+    {
+        TrajectoryFileHeader header{};
+        std::memcpy(header.magic_, magic, sizeof(magic));
+        header.version_ = version;
+        header.byte_order_ = byte_order;
+        header.agents_ = plan.size();
+        write(reinterpret_cast<const char *>(&header), sizeof(header));
+        write(reinterpret_cast<const char *>(agents.data()), agents.size() * sizeof(TrajectoryFileAgent));
+
+        std::vector<double> values;
+        auto write_values = [&]() {
+            write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(double));
+            values.clear();
+        };
+        for (std::size_t a = 0; a < plan.size(); a++) {
+            oc::PathControl &path = *plan[a];
+            const TrajectoryFileAgent &agent = agents[a];
+            const auto *si = static_cast<const oc::SpaceInformation *>(path.getSpaceInformation().get());
+            std::vector<double> reals;
+            for (const ob::State *st: path.getStates()) {
+                si->getStateSpace()->copyToReals(reals, st);
+                values.insert(values.end(), reals.begin(), reals.end());
+            }
+            write_values();
+            if (agent.cov_rows_ > 0) {
+                for (const ob::State *st: path.getStates()) {
+                    const Eigen::MatrixXd cov = st->as<RealVectorBeliefSpace::StateType>()->getCovariance();
+                    values.insert(values.end(), cov.data(), cov.data() + cov.size());
+                }
+                write_values();
+            }
+            for (const oc::Control *control: path.getControls()) {
+                for (unsigned int j = 0; j < agent.control_dim_; j++)
+                    values.push_back(*si->getControlSpace()->getValueAddressAtIndex(control, j));
+            }
+            write_values();
+            const std::vector<double> &durations = path.getControlDurations();
+            values.insert(values.end(), durations.begin(), durations.end());
+            write_values();
+        }
+    }
+}
+
+bool writeTrajectoryFile(const fs::path &filename, const std::vector<oc::PathControl*> &plan)
+{
+    std::vector<TrajectoryFileAgent> agents;
+    layout(plan, agents);
+
+    // one buffered stream, every array written at once
+    std::vector<char> stream_buffer(1 << 20);
+    std::ofstream out;
+    out.rdbuf()->pubsetbuf(stream_buffer.data(), stream_buffer.size());
+    out.open(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        OMPL_ERROR("%s: Unable to open ``%s``.", "TrajectoryFile", filename.c_str());
+        return false;
+    }
+    emit(plan, agents, [&out](const char *data, const std::size_t bytes) {out.write(data, bytes);});
+    out.close();
+    if (!out) {
+        OMPL_ERROR("%s: Unable to write ``%s``.", "TrajectoryFile", filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::uint64_t trajectoryImageSize(const std::vector<oc::PathControl*> &plan)
+{
+    std::vector<TrajectoryFileAgent> agents;
+    return layout(plan, agents);
+}
+
+void writeTrajectoryImage(const std::vector<oc::PathControl*> &plan, char *image)
+{
+    std::vector<TrajectoryFileAgent> agents;
+    layout(plan, agents);
+    emit(plan, agents, [&image](const char *data, const std::size_t bytes) {
+        std::memcpy(image, data, bytes);
+        image += bytes;
+    });
+}
+
+TrajectoryFile::~TrajectoryFile()
+{
+    close();
+}
+
+bool TrajectoryFile::open(const fs::path &filename)
+{
+    close();
+#ifdef KCBS_TRAJECTORY_MMAP
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            data_ = static_cast<const char *>(data);
+            size_ = st.st_size;
+            mapped_ = true;
+        }
+    }
+    if (fd >= 0)
+        ::close(fd);
+#endif
+    if (!data_) {
+        std::ifstream in(filename, std::ios::binary);
+        buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+    }
+    return check_(filename.string());
+}
+
+bool TrajectoryFile::openImage(const char *data, const std::size_t size)
+{
+    close();
+    data_ = data;
+    size_ = size;
+    return check_("the image");
+}
+
+bool TrajectoryFile::check_(const std::string &filename)
+{
+    // the header, and every array within the file
+    TrajectoryFileHeader header;
+    if (size_ < sizeof(header)) {
+        OMPL_ERROR("%s: ``%s`` is not a trajectory file.", "TrajectoryFile", filename.c_str());
+        close();
+        return false;
+    }
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic_, magic, sizeof(magic)) != 0 || header.version_ != version ||
+        header.byte_order_ != byte_order) {
+        OMPL_ERROR("%s: ``%s`` is not a trajectory file of version %u in this byte order.", "TrajectoryFile",
+            filename.c_str(), version);
+        close();
+        return false;
+    }
+    const std::uint64_t table_end = sizeof(header) + std::uint64_t(header.agents_) * sizeof(TrajectoryFileAgent);
+    if (table_end > size_) {
+        OMPL_ERROR("%s: ``%s`` is truncated.", "TrajectoryFile", filename.c_str());
+        close();
+        return false;
+    }
+    agents_.resize(header.agents_);
+    std::memcpy(agents_.data(), data_ + sizeof(header), agents_.size() * sizeof(TrajectoryFileAgent));
+    for (const TrajectoryFileAgent &agent: agents_) {
+        const std::uint64_t steps = (agent.states_ > 0) ? agent.states_ - 1 : 0;
+        const bool valid = agent.means_ >= table_end &&
+            (agent.means_ | agent.covariances_ | agent.controls_ | agent.durations_) % sizeof(double) == 0 &&
+            agent.means_ + array_bytes(std::uint64_t(agent.states_) * agent.state_dim_) <= size_ &&
+            agent.covariances_ + array_bytes(std::uint64_t(agent.states_) * agent.cov_rows_ * agent.cov_cols_) <= size_ &&
+            agent.controls_ + array_bytes(steps * agent.control_dim_) <= size_ &&
+            agent.durations_ + array_bytes(steps) <= size_;
+        if (!valid) {
+            OMPL_ERROR("%s: ``%s`` is truncated.", "TrajectoryFile", filename.c_str());
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void TrajectoryFile::close()
+{
+#ifdef KCBS_TRAJECTORY_MMAP
+    if (mapped_)
+        munmap(const_cast<char *>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    buffer_.clear();
+    agents_.clear();
+}
+
+bool convertTrajectoryFileToText(const fs::path &filename, const fs::path &directory)
+{
+    TrajectoryFile file;
+    if (!file.open(filename))
+        return false;
+    fs::create_directories(directory);
+    for (std::size_t a = 0; a < file.numAgents(); a++) {
+        const TrajectoryFileAgent &agent = file.getAgent(a);
+        std::ostringstream num;
+        num << std::setw(2) << std::setfill('0') << a;
+        // as PathControl::printAsMatrix: the last state has no control, so zeros
+        std::ofstream states(directory / ("agent" + num.str() + ".txt"));
+        for (std::size_t i = 0; i < agent.states_; i++) {
+            for (std::size_t d = 0; d < agent.state_dim_; d++)
+                states << file.getMeans(a)[i * agent.state_dim_ + d] << " ";
+            const bool last = (i + 1 == agent.states_);
+            for (std::size_t j = 0; j < agent.control_dim_; j++)
+                states << (last ? 0.0 : file.getControls(a)[i * agent.control_dim_ + j]) << " ";
+            states << (last ? 0.0 : file.getDurations(a)[i]) << std::endl;
+        }
+        if (agent.cov_rows_ == 0)
+            continue;
+        std::ofstream covs(directory / ("agent" + num.str() + "_covs.txt"));
+        const std::size_t cov_size = agent.cov_rows_ * agent.cov_cols_;
+        for (std::size_t i = 0; i < agent.states_; i++) {
+            const double *cov = file.getCovariances(a) + i * cov_size;
+            for (std::size_t r = 0; r < agent.cov_rows_; r++) {
+                for (std::size_t c = 0; c < agent.cov_cols_; c++)
+                    covs << cov[c * agent.cov_rows_ + r] << " ";
+            }
+            covs << std::endl;
+        }
+    }
+    return true;
+}
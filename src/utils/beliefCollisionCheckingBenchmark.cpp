@@ -1,4 +1,9 @@
 #include "utils/beliefCollisionCheckingBenchmark.h"
+#include "utils/TaskRuntime.h"
+#include <Eigen/Cholesky>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 BeliefCollisionCheckerBenchmark::BeliefCollisionCheckerBenchmark(std::string file1, std::string file2):
     beliefList1_(file1), beliefList2_(file2)
@@ -102,271 +107,192 @@ BeliefCollisionCheckerBenchmark::BeliefCollisionCheckerBenchmark(std::string fil
 }
 
 
-void BeliefCollisionCheckerBenchmark::runBenchmarks()
+namespace
 {
-    /* Create results data structure */
-    std::vector<std::pair<double, bool>> chiSquared_results;
-    const int num_examples = agent1_belief_map_.size();
-    bool result;
-    int num_fail = 0;
-    double total_time = 0;
-
-    OMPL_INFORM("Testing collision checkers on %d belief pairs.", num_examples);
-
-    // /* Create state validity checker object */
-    // auto ChiSquaredPlanValidator = std::make_shared<ChiSquaredBoundaryPVC>(mrmp_pdef_, instance_->getPsafe());
-    
-    // /* Iterate through all the states, test for collisions, and save results */
-    // for (int idx = 0; idx != num_examples; idx++) {
-    //     auto start_time = std::chrono::system_clock::now();
-    //     result = ChiSquaredPlanValidator->independentCheck(agent1_belief_map_[idx], agent2_belief_map_[idx]);
-    //     if (!result)
-    //         num_fail++;
-    //     std::chrono::duration<double> elapsed_time = std::chrono::system_clock::now() - start_time;
-    //     double execution_time = elapsed_time.count();
-    //     total_time += execution_time;
-    //     std::pair<double, bool> p(execution_time, result);
-    //     chiSquared_results.push_back(p);
-    // }
-
-    // double stat = (double)num_fail / num_examples;
-    // OMPL_INFORM("%s: rejected %0.1f percent of belief pairs in %0.3f seconds", ChiSquaredPlanValidator->getName().c_str(), (stat * 100.0), total_time);
-
-    // exportResults_("chi_squared_results.csv", chiSquared_results);
-
-    // /* Create results data structure */
-    // std::vector<std::pair<double, bool>> sumBlackmore_results;
-    // num_fail = 0;
-    // total_time = 0;
-
-    // /* Create state validity checker object */
-    // auto MinkowskiSumBlackmorePlanValidator = std::make_shared<MinkowskiSumBlackmorePVC>(mrmp_pdef_, instance_->getPsafe());
-    
-    // /* Iterate through all the states, test for collisions, and save results */
-    // for (int idx = 0; idx != num_examples; idx++) {
-    //     auto start_time = std::chrono::system_clock::now();
-    //     result = MinkowskiSumBlackmorePlanValidator->independentCheck(agent1_belief_map_[idx], agent2_belief_map_[idx]);
-    //     if (!result)
-    //         num_fail++;
-    //     std::chrono::duration<double> elapsed_time = std::chrono::system_clock::now() - start_time;
-    //     double execution_time = elapsed_time.count();
-    //     total_time += execution_time;
-    //     std::pair<double, bool> p(execution_time, result);
-    //     sumBlackmore_results.push_back(p);
-    // }
-
-    // stat = (double)num_fail / num_examples;
-    // OMPL_INFORM("%s: rejected %0.1f percent of belief pairs in a total of %0.3f seconds", MinkowskiSumBlackmorePlanValidator->getName().c_str(), (stat * 100.0), total_time);
-
-    // exportResults_("minkowski_sum_results.csv", sumBlackmore_results);
-
-    // /* Create results data structure */
-    // std::vector<std::pair<double, bool>> Blackmore2_results;
-    // num_fail = 0;
-    // total_time = 0;
-
-    // /* Create state validity checker object */
-    // auto Blackmore2PlanValidator = std::make_shared<Blackmore2PVC>(mrmp_pdef_, instance_->getPsafe());
-    
-    // /* Iterate through all the states, test for collisions, and save results */
-    // for (int idx = 0; idx != num_examples; idx++) {
-    //     auto start_time = std::chrono::system_clock::now();
-    //     result = Blackmore2PlanValidator->independentCheck(agent1_belief_map_[idx], agent2_belief_map_[idx]);
-    //     if (!result)
-    //         num_fail++;
-    //     std::chrono::duration<double> elapsed_time = std::chrono::system_clock::now() - start_time;
-    //     double execution_time = elapsed_time.count();
-    //     total_time += execution_time;
-    //     std::pair<double, bool> p(execution_time, result);
-    //     Blackmore2_results.push_back(p);
-    // }
-
-    // stat = (double)num_fail / num_examples;
-    // OMPL_INFORM("%s: rejected %0.1f percent of belief pairs in a total of %0.3f seconds", Blackmore2PlanValidator->getName().c_str(), (stat * 100.0), total_time);
-
-    // exportResults_("blackmore_2_results.csv", Blackmore2_results);
-
-    /* Create results data structure */
-    std::vector<std::pair<double, bool>> boundingBox_results;
-    num_fail = 0;
-    total_time = 0;
-
-    /* Create state validity checker object */
-    auto BoundingBoxBlackmorePlanValidator = std::make_shared<BoundingBoxBlackmorePVC>(mrmp_pdef_, instance_->getPsafe());
-    
-    /* Iterate through all the states, test for collisions, and save results */
-    for (int idx = 0; idx != num_examples; idx++) {
-        auto start_time = std::chrono::system_clock::now();
-        result = BoundingBoxBlackmorePlanValidator->independentCheck(agent1_belief_map_[idx], agent2_belief_map_[idx]);
-        if (!result)
-            num_fail++;
-        std::chrono::duration<double> elapsed_time = std::chrono::system_clock::now() - start_time;
-        double execution_time = elapsed_time.count();
-        total_time += execution_time;
-        std::pair<double, bool> p(execution_time, result);
-        boundingBox_results.push_back(p);
+    /* the q-quantile of sorted values */
+    double quantile(const std::vector<double> &sorted, const double q)
+    {
+        if (sorted.empty())
+            return 0;
+        const std::size_t k = std::min<std::size_t>(sorted.size() - 1, static_cast<std::size_t>(q * sorted.size()));
+        return sorted[k];
     }
+}
 
-    double stat = (double)num_fail / num_examples;
-    OMPL_INFORM("%s: rejected %0.1f percent of belief pairs in a total of %0.3f seconds", BoundingBoxBlackmorePlanValidator->getName().c_str(), (stat * 100.0), total_time);
-
-    // exportResults_("bounding_box_blackmore_results.csv", boundingBox_results);
-
-    /* Create results data structure */
-    std::vector<std::pair<double, bool>> adaptiveBoundingBox_results;
-    num_fail = 0;
-    total_time = 0;
-
-    /* Create state validity checker object */
-    auto AdaptiveBoundingBoxBlackmorePlanValidator = std::make_shared<AdaptiveRiskBoundingBoxPVC>(mrmp_pdef_, instance_->getPsafe());
-    
-    /* Iterate through all the states, test for collisions, and save results */
-    for (int idx = 0; idx != num_examples; idx++) {
-        auto start_time = std::chrono::system_clock::now();
-        result = AdaptiveBoundingBoxBlackmorePlanValidator->independentCheck(agent1_belief_map_[idx], agent2_belief_map_[idx]);
-        if (!result)
-            num_fail++;
-        std::chrono::duration<double> elapsed_time = std::chrono::system_clock::now() - start_time;
-        double execution_time = elapsed_time.count();
-        total_time += execution_time;
-        std::pair<double, bool> p(execution_time, result);
-        adaptiveBoundingBox_results.push_back(p);
+std::vector<BeliefCollisionCheckerBenchmark::Checker> BeliefCollisionCheckerBenchmark::checkers_() const
+{
+    const double p_safe = instance_->getPsafe();
+    const MultiRobotProblemDefinitionPtr pdef = mrmp_pdef_;
+    // every call builds a new checker, so every thread has its own
+    auto make = [](auto factory) {
+        return [factory]() -> CheckFn {
+            auto pvc = factory();
+            return [pvc](ob::State *a, ob::State *b) {return pvc->independentCheck(a, b);};
+        };
+    };
+    std::vector<Checker> checkers{
+        {"ChiSquared", "chi_squared_results.csv", make([=]() {return std::make_shared<ChiSquaredBoundaryPVC>(pdef, p_safe);})},
+        {"Blackmore", "minkowski_sum_results.csv", make([=]() {return std::make_shared<MinkowskiSumBlackmorePVC>(pdef, p_safe);})},
+        {"AdaptiveBlackmore", "adaptive_blackmore_results.csv", make([=]() {return std::make_shared<AdaptiveRiskBlackmorePVC>(pdef, p_safe);})},
+        {"BoundingBox", "bounding_box_results.csv", make([=]() {return std::make_shared<BoundingBoxBlackmorePVC>(pdef, p_safe);})},
+        {"AdaptiveBoundingBox", "adaptive_bounding_box_results.csv", make([=]() {return std::make_shared<AdaptiveRiskBoundingBoxPVC>(pdef, p_safe);})}};
+    for (const int disks: {2, 5, 20, 50}) {
+        checkers.push_back({"CDFGrid-" + std::to_string(disks), "cdfGrid(" + std::to_string(disks) + ")_results.csv",
+            make([=]() {return std::make_shared<CDFGridPVC>(pdef, p_safe, disks);})});
     }
-
-    stat = (double)num_fail / num_examples;
-    OMPL_INFORM("%s: rejected %0.1f percent of belief pairs in a total of %0.3f seconds", AdaptiveBoundingBoxBlackmorePlanValidator->getName().c_str(), (stat * 100.0), total_time);
-
-
-    // /* Create results data structure */
-    // std::vector<std::pair<double, bool>> adaptiveBlackmore_results;
-    // num_fail = 0;
-    // total_time = 0;
-
-    // /* Create state validity checker object */
-    // auto AdaptiveBlackmorePlanValidator = std::make_shared<AdaptiveRiskBlackmorePVC>(mrmp_pdef_, instance_->getPsafe());
-    
-    // /* Iterate through all the states, test for collisions, and save results */
-    // for (int idx = 0; idx != num_examples; idx++) {
-    //     auto start_time = std::chrono::system_clock::now();
-    //     result = AdaptiveBlackmorePlanValidator->independentCheck(agent1_belief_map_[idx], agent2_belief_map_[idx]);
-    //     if (!result)
-    //         num_fail++;
-    //     std::chrono::duration<double> elapsed_time = std::chrono::system_clock::now() - start_time;
-    //     double execution_time = elapsed_time.count();
-    //     total_time += execution_time;
-    //     std::pair<double, bool> p(execution_time, result);
-    //     adaptiveBlackmore_results.push_back(p);
-    // }
-
-    // stat = (double)num_fail / num_examples;
-    // OMPL_INFORM("%s: rejected %0.1f percent of belief pairs in a total of %0.3f seconds", AdaptiveBlackmorePlanValidator->getName().c_str(), (stat * 100.0), total_time);
-
-    // exportResults_("adaptive_blackmore_results.csv", adaptiveBlackmore_results);
-
-    /* Create results data structure */
-    std::vector<std::pair<double, bool>> cdfGrid2_results;
-    num_fail = 0;
-    total_time = 0;
-
-    /* Create state validity checker object */
-    auto CDFGrid2PlanValidator = std::make_shared<CDFGridPVC>(mrmp_pdef_, instance_->getPsafe(), 2);
-
-    /* Iterate through all the states, test for collisions, and save results */
-    for (int idx = 0; idx != num_examples; idx++) {
-        auto start_time = std::chrono::system_clock::now();
-        result = CDFGrid2PlanValidator->independentCheck(agent1_belief_map_[idx], agent2_belief_map_[idx]);
-        if (!result)
-            num_fail++;
-        std::chrono::duration<double> elapsed_time = std::chrono::system_clock::now() - start_time;
-        double execution_time = elapsed_time.count();
-        total_time += execution_time;
-        std::pair<double, bool> p(execution_time, result);
-        cdfGrid2_results.push_back(p);
+    for (const int samples: {256, 1024, 4096}) {
+        checkers.push_back({"MonteCarlo-" + std::to_string(samples), "monteCarlo(" + std::to_string(samples) + ")_results.csv",
+            make([=]() {return std::make_shared<MonteCarloPVC>(pdef, p_safe, samples);})});
     }
+    return checkers;
+}
 
-    stat = (double)num_fail / num_examples;
-    OMPL_INFORM("%s: rejected %0.1f percent of belief pairs in a total of %0.3f seconds", CDFGrid2PlanValidator->getName().c_str(), (stat * 100.0), total_time);
-
-    exportResults_("cdfGrid(2)_results.csv", cdfGrid2_results);
-
-    /* Create results data structure */
-    std::vector<std::pair<double, bool>> cdfGrid5_results;
-    num_fail = 0;
-    total_time = 0;
-
-    /* Create state validity checker object */
-    auto CDFGrid5PlanValidator = std::make_shared<CDFGridPVC>(mrmp_pdef_, instance_->getPsafe(), 5);
-
-    /* Iterate through all the states, test for collisions, and save results */
-    for (int idx = 0; idx != num_examples; idx++) {
-        auto start_time = std::chrono::system_clock::now();
-        result = CDFGrid5PlanValidator->independentCheck(agent1_belief_map_[idx], agent2_belief_map_[idx]);
-        if (!result)
-            num_fail++;
-        std::chrono::duration<double> elapsed_time = std::chrono::system_clock::now() - start_time;
-        double execution_time = elapsed_time.count();
-        total_time += execution_time;
-        std::pair<double, bool> p(execution_time, result);
-        cdfGrid5_results.push_back(p);
+std::vector<bool> BeliefCollisionCheckerBenchmark::referenceSafety_() const
+{
+    // the robots collide when the difference of their centers is inside the sum of their boxes
+    auto half_extents = [](const Robot *r) {
+        Eigen::Vector2d lo(std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity());
+        Eigen::Vector2d hi = -lo;
+        for (const Point &p: bg::exterior_ring(r->getBoundingShape())) {
+            lo = lo.cwiseMin(Eigen::Vector2d(p.x(), p.y()));
+            hi = hi.cwiseMax(Eigen::Vector2d(p.x(), p.y()));
+        }
+        return Eigen::Vector2d(0.5 * (hi - lo));
+    };
+    const Eigen::Vector2d reach = half_extents(instance_->getRobots()[0]) + half_extents(instance_->getRobots()[1]);
+    const double p_coll = 1 - instance_->getPsafe();
+    ompl::RNG rng;
+    std::vector<bool> safe(agent1_belief_map_.size());
+    for (std::size_t idx = 0; idx < safe.size(); idx++) {
+        const auto *a = agent1_belief_map_[idx]->as<RealVectorBeliefSpace::StateType>();
+        const auto *b = agent2_belief_map_[idx]->as<RealVectorBeliefSpace::StateType>();
+        const Eigen::Vector2d mu(a->values[0] - b->values[0], a->values[1] - b->values[1]);
+        const Eigen::Matrix2d Sigma = a->getCovariance().topLeftCorner<2, 2>() + b->getCovariance().topLeftCorner<2, 2>();
+        const Eigen::Matrix2d L = Sigma.llt().matrixL();
+        unsigned int collisions = 0;
+        for (unsigned int n = 0; n < reference_samples_; n++) {
+            const Eigen::Vector2d d = mu + L * Eigen::Vector2d(rng.gaussian01(), rng.gaussian01());
+            if (std::abs(d[0]) < reach[0] && std::abs(d[1]) < reach[1])
+                collisions++;
+        }
+        safe[idx] = (collisions <= p_coll * reference_samples_);
     }
+    return safe;
+}
 
-    stat = (double)num_fail / num_examples;
-    OMPL_INFORM("%s: rejected %0.1f percent of belief pairs in a total of %0.3f seconds", CDFGrid5PlanValidator->getName().c_str(), (stat * 100.0), total_time);
-
-    exportResults_("cdfGrid(5)_results.csv", cdfGrid5_results);
-
-    /* Create results data structure */
-    std::vector<std::pair<double, bool>> cdfGrid20_results;
-    num_fail = 0;
-    total_time = 0;
-
-    /* Create state validity checker object */
-    auto CDFGrid20PlanValidator = std::make_shared<CDFGridPVC>(mrmp_pdef_, instance_->getPsafe(), 20);
-
-    /* Iterate through all the states, test for collisions, and save results */
-    for (int idx = 0; idx != num_examples; idx++) {
-        auto start_time = std::chrono::system_clock::now();
-        result = CDFGrid20PlanValidator->independentCheck(agent1_belief_map_[idx], agent2_belief_map_[idx]);
-        if (!result)
-            num_fail++;
-        std::chrono::duration<double> elapsed_time = std::chrono::system_clock::now() - start_time;
-        double execution_time = elapsed_time.count();
-        total_time += execution_time;
-        std::pair<double, bool> p(execution_time, result);
-        cdfGrid20_results.push_back(p);
-        // break;
-    }
+void BeliefCollisionCheckerBenchmark::runBenchmarks()
+{
+    typedef std::chrono::steady_clock Clock;
+    const std::size_t num_examples = agent1_belief_map_.size();
+    OMPL_INFORM("Testing collision checkers on %d belief pairs.", num_examples);
+    if (num_examples == 0)
+        return;
 
-    stat = (double)num_fail / num_examples;
-    OMPL_INFORM("%s: rejected %0.1f percent of belief pairs in a total of %0.3f seconds", CDFGrid20PlanValidator->getName().c_str(), (stat * 100.0), total_time);
-
-    exportResults_("cdfGrid(20)_results.csv", cdfGrid20_results);
-
-    /* Create results data structure */
-    std::vector<std::pair<double, bool>> cdfGrid50_results;
-    num_fail = 0;
-    total_time = 0;
-
-    /* Create state validity checker object */
-    auto CDFGrid50PlanValidator = std::make_shared<CDFGridPVC>(mrmp_pdef_, instance_->getPsafe(), 50);
-
-    /* Iterate through all the states, test for collisions, and save results */
-    for (int idx = 0; idx != num_examples; idx++) {
-        auto start_time = std::chrono::system_clock::now();
-        result = CDFGrid50PlanValidator->independentCheck(agent1_belief_map_[idx], agent2_belief_map_[idx]);
-        if (!result)
-            num_fail++;
-        std::chrono::duration<double> elapsed_time = std::chrono::system_clock::now() - start_time;
-        double execution_time = elapsed_time.count();
-        total_time += execution_time;
-        std::pair<double, bool> p(execution_time, result);
-        cdfGrid50_results.push_back(p);
+    const std::vector<Checker> checkers = checkers_();
+    unsigned int max_threads = 1;
+    for (const unsigned int t: threads_)
+        max_threads = std::max(max_threads, t);
+    // build the checkers of every thread concurrently, instead of one after the other
+    std::vector<std::vector<CheckFn>> checks(checkers.size(), std::vector<CheckFn>(max_threads));
+    {
+        TaskGroup builders;
+        for (std::size_t c = 0; c < checkers.size(); c++) {
+            for (unsigned int t = 0; t < max_threads; t++)
+                builders.run([&, c, t]() {checks[c][t] = checkers[c].make_();});
+        }
+        builders.wait();
+    }
+    const std::vector<bool> reference = (reference_samples_ > 0) ? referenceSafety_() : std::vector<bool>();
+    perf::setEnabled(perf_counters_);
+
+    std::ofstream summary(summary_file_);
+    summary << "Checker,Rejected (%),Unsafe Accepted (%),Safe Rejected (%),p50 (ns),p99 (ns),p99.9 (ns),Throughput (checks/s)";
+    for (const unsigned int t: threads_)
+        summary << ",Throughput " << t << " Threads (checks/s),Speedup " << t << " Threads";
+    if (perf_counters_)
+        summary << ",Cycles per Check,Instructions per Check,IPC,Cache Misses per Check,Branch Misses per Check";
+    summary << std::endl;
+
+    for (std::size_t c = 0; c < checkers.size(); c++) {
+        const CheckFn &check = checks[c][0];
+        // latency: every check on its own, the steady clock read once per check
+        std::vector<std::pair<double, bool>> results(num_examples);
+        std::vector<double> latencies;
+        latencies.reserve(num_examples * latency_repeats_);
+        for (unsigned int r = 0; r < latency_repeats_; r++) {
+            for (std::size_t idx = 0; idx < num_examples; idx++) {
+                const Clock::time_point start = Clock::now();
+                const bool result = check(agent1_belief_map_[idx], agent2_belief_map_[idx]);
+                const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+                latencies.push_back(elapsed);
+                if (r == 0)
+                    results[idx] = {elapsed, result};
+            }
+        }
+        std::sort(latencies.begin(), latencies.end());
+
+        // throughput: batches of every pair, timed as a whole
+        auto batch = [&](const CheckFn &fn, const std::size_t first, const std::size_t last) {
+            std::size_t accepted = 0;
+            for (unsigned int it = 0; it < iterations_; it++) {
+                for (std::size_t idx = first; idx < last; idx++)
+                    accepted += fn(agent1_belief_map_[idx], agent2_belief_map_[idx]);
+            }
+            return accepted;
+        };
+        // the counters of every thread are read by the thread itself, over its batch
+        std::vector<perf::Counters> counters;
+        auto throughput = [&](const unsigned int threads) {
+            std::vector<std::thread> workers;
+            std::atomic<std::size_t> sink{0};
+            counters.assign(threads, perf::Counters());
+            const Clock::time_point start = Clock::now();
+            for (unsigned int t = 0; t < threads; t++) {
+                workers.emplace_back([&, t]() {
+                    const perf::Counters c0 = perf::read();
+                    sink += batch(checks[c][t], (t * num_examples) / threads, ((t + 1) * num_examples) / threads);
+                    counters[t] = perf::read() - c0;
+                });
+            }
+            for (std::thread &w: workers)
+                w.join();
+            const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+            return (elapsed > 0) ? (static_cast<double>(iterations_) * num_examples) / elapsed : 0.0;
+        };
+        const double single = throughput(1);
+        const perf::Counters single_counters = counters.front();
+
+        std::size_t rejected = 0, unsafe_accepted = 0, safe_rejected = 0;
+        for (std::size_t idx = 0; idx < num_examples; idx++) {
+            rejected += !results[idx].second;
+            if (!reference.empty()) {
+                unsafe_accepted += (results[idx].second && !reference[idx]);
+                safe_rejected += (!results[idx].second && reference[idx]);
+            }
+        }
+        OMPL_INFORM("%s: rejected %0.1f percent of belief pairs, p50 %0.0f ns, p99 %0.0f ns, %0.0f checks/s", checkers[c].name_.c_str(),
+            100.0 * rejected / num_examples, 1e9 * quantile(latencies, 0.5), 1e9 * quantile(latencies, 0.99), single);
+        summary << checkers[c].name_ << "," << 100.0 * rejected / num_examples;
+        if (reference.empty())
+            summary << ",,";
+        else
+            summary << "," << 100.0 * unsafe_accepted / num_examples << "," << 100.0 * safe_rejected / num_examples;
+        summary << "," << 1e9 * quantile(latencies, 0.5) << "," << 1e9 * quantile(latencies, 0.99) << "," << 1e9 * quantile(latencies, 0.999);
+        summary << "," << single;
+        for (const unsigned int t: threads_) {
+            const double scaled = (t == 1) ? single : throughput(t);
+            summary << "," << scaled << "," << ((single > 0) ? scaled / single : 0.0);
+        }
+        if (perf_counters_) {
+            const double per_check = 1.0 / (static_cast<double>(iterations_) * num_examples);
+            summary << "," << per_check * single_counters.cycles_ << "," << per_check * single_counters.instructions_;
+            summary << "," << single_counters.ipc() << "," << per_check * single_counters.cache_misses_;
+            summary << "," << per_check * single_counters.branch_misses_;
+        }
+        summary << std::endl;
+
+        exportResults_(checkers[c].results_file_, results);
     }
-
-    stat = (double)num_fail / num_examples;
-    OMPL_INFORM("%s: rejected %0.1f percent of belief pairs in a total of %0.3f seconds", CDFGrid50PlanValidator->getName().c_str(), (stat * 100.0), total_time);
-
-    exportResults_("cdfGrid(50)_results.csv", cdfGrid50_results);
 }
 
 void BeliefCollisionCheckerBenchmark::exportResults_(std::string filename, std::vector<std::pair<double, bool>> results)
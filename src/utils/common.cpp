@@ -44,6 +44,8 @@ RectangularObstacle::RectangularObstacle(double x, double y, double len, double
 Robot::Robot(std::string name, std::string model, Location start, Location goal):
     name_(name), dyn_model_(model), start_(start), goal_(goal) {}
 std::string Robot::getName() const {return name_;}
+int Robot::getId() const {return id_;}
+void Robot::setId(const int id) {id_ = id;}
 std::string Robot::getDynamicsModel() const {return dyn_model_;}
 const Polygon& Robot::getShape() const {return shape_;}
 const double Robot::getBoundingRadius() const {return bounding_rad_;};
@@ -377,42 +377,14 @@
 //     return fileName.stem().string() + "_" + GetCurrentTimeForFileName() + fileName.extension().string();
 // }
 
-// write solultion to the system
-void exportBeliefPlan(const std::vector<oc::PathControl*> plan, const std::string problem_name)
+// write solultion to the system, as solutions/<problem_name>.traj (see utils/TrajectoryFile.h)
+void exportBeliefPlan(const std::vector<oc::PathControl*> plan, const std::string problem_name, const bool text)
 {
-    fs::path sol_dir = "solutions/" + problem_name;
-    std::filesystem::remove_all(sol_dir);
-    fs::create_directories(sol_dir);
-    for (int i = 0; i < plan.size(); i++)
-    {
-    	std::string num;
-    	if (i < 10)
-    		num = "0" + std::to_string(i);
-    	else
-    		num = std::to_string(i);
-        std::string fileName = "agent" + num + ".txt";
-        auto filePath = fs::current_path() / sol_dir / fs::path(fileName);
-        std::ofstream file(filePath);
-        plan[i]->printAsMatrix(file);
-        file.close();
-
-        // print covariances
-        std::string covName = "agent" + num + "_covs.txt";
-        auto covFilePath = fs::current_path() / sol_dir / fs::path(covName);
-        std::ofstream MyFile(covFilePath);
-        std::vector<ob::State*> states = plan[i]->getStates();
-        for (auto itr = states.begin(); itr != states.end(); itr++) {
-            Eigen::MatrixXd Sigma = (*itr)->as<RealVectorBeliefSpace::StateType>()->getCovariance();
-            int r = Sigma.rows();
-            int c = Sigma.cols();
-            for (int i = 0; i < r; ++i)
-            {
-                for (int j = 0; j < c; ++j)
-                {
-                    MyFile << Sigma(i,j) << " ";
-                }
-            }
-            MyFile << std::endl;
-        }
-    }
-}
\ No newline at end of file
+    fs::create_directories("solutions");
+    const fs::path sol_file = fs::path("solutions") / (problem_name + ".traj");
+    if (!writeTrajectoryFile(sol_file, plan))
+        return;
+    // the per-agent text files of the trajectories, for debugging
+    if (text)
+        convertTrajectoryFileToText(sol_file, fs::path("solutions") / problem_name);
+}